@@ -114,10 +114,11 @@
     }
     
     //Send our messages
+    NSData *datagram = [message messageAsDataWithHeader:NO];
     for (NSString* address in destinations) {
         for (int i = 0; i < [[destinations objectForKey:address] count]; i++) {
             int port = [[[destinations objectForKey:address] objectAtIndex:i] intValue];
-            [socket sendData:[message messageAsDataWithHeader:NO] toHost:address port:port withTimeout:3 tag:0];
+            [socket sendData:datagram toHost:address port:port withTimeout:3 tag:0];
         }
     }
 }
@@ -0,0 +1,412 @@
+//
+//  AssetStore.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "AssetStore.h"
+#include <CommonCrypto/CommonDigest.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//Files are hashed through a buffer of this size.
+#define ASSET_STORE_BUFFER_LENGTH (1024 * 1024)
+//A stored file is linked into a score under this name first, and then renamed over the original.
+#define ASSET_STORE_TEMPORARY_SUFFIX ".assetstore.tmp"
+
+typedef struct {
+    char *path;
+    uint64_t size;
+} AssetStoreFile;
+
+struct AssetStoreIngestion {
+    char *storeDirectory;
+    //Largest first.
+    AssetStoreFile *files;
+    size_t fileCount;
+    size_t fileCapacity;
+    uint64_t totalBytes;
+
+    atomic_size_t nextFile;
+    atomic_size_t ingestedFiles;
+    atomic_uint_least64_t ingestedBytes;
+    atomic_uint_least64_t sharedBytes;
+    atomic_bool failed;
+};
+
+static bool listDirectory(AssetStoreIngestion *ingestion, const char *path, const char **excludedNames);
+static bool isExcluded(const char *name, const char **excludedNames);
+static bool addFile(AssetStoreIngestion *ingestion, char *path, uint64_t size);
+static char *joinPath(const char *directory, const char *name);
+static bool makeDirectory(const char *path);
+static bool digestDescriptor(int fd, uint8_t *buffer, uint8_t digest[ASSET_STORE_DIGEST_LENGTH]);
+static bool ingestFile(AssetStoreIngestion *ingestion, const AssetStoreFile *file, uint8_t *buffer);
+static bool linkFile(const char *path, const struct stat *status, const char *storedPath, bool *shared);
+static int compareFilesBySize(const void *a, const void *b);
+
+#pragma mark - Public functions
+
+bool AssetStoreDigestFile(const char *path, uint8_t digest[ASSET_STORE_DIGEST_LENGTH])
+{
+    uint8_t *buffer = malloc(ASSET_STORE_BUFFER_LENGTH);
+    int fd = open(path, O_RDONLY);
+    bool success = buffer != NULL && fd >= 0 && digestDescriptor(fd, buffer, digest);
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(buffer);
+    return success;
+}
+
+void AssetStoreDigestBytes(const uint8_t *bytes, size_t length, uint8_t digest[ASSET_STORE_DIGEST_LENGTH])
+{
+    CC_SHA256_CTX context;
+    CC_SHA256_Init(&context);
+    while (length > 0) {
+        size_t count = length < ASSET_STORE_BUFFER_LENGTH ? length : ASSET_STORE_BUFFER_LENGTH;
+        CC_SHA256_Update(&context, bytes, (CC_LONG)count);
+        bytes += count;
+        length -= count;
+    }
+    CC_SHA256_Final(digest, &context);
+}
+
+AssetStoreIngestion *AssetStoreIngestionOpen(const char *storeDirectory, const char *directory, const char **excludedNames)
+{
+    AssetStoreIngestion *ingestion = calloc(1, sizeof(AssetStoreIngestion));
+    if (ingestion == NULL) {
+        return NULL;
+    }
+    atomic_init(&ingestion->nextFile, 0);
+    atomic_init(&ingestion->ingestedFiles, 0);
+    atomic_init(&ingestion->ingestedBytes, 0);
+    atomic_init(&ingestion->sharedBytes, 0);
+    atomic_init(&ingestion->failed, false);
+    ingestion->storeDirectory = strdup(storeDirectory);
+    if (ingestion->storeDirectory == NULL || !makeDirectory(storeDirectory) || !listDirectory(ingestion, directory, excludedNames)) {
+        AssetStoreIngestionClose(ingestion);
+        return NULL;
+    }
+    if (ingestion->fileCount > 0) {
+        qsort(ingestion->files, ingestion->fileCount, sizeof(AssetStoreFile), compareFilesBySize);
+    }
+    return ingestion;
+}
+
+void AssetStoreIngestionClose(AssetStoreIngestion *ingestion)
+{
+    if (ingestion == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < ingestion->fileCount; i++) {
+        free(ingestion->files[i].path);
+    }
+    free(ingestion->files);
+    free(ingestion->storeDirectory);
+    free(ingestion);
+}
+
+size_t AssetStoreIngestionWorkerCount(const AssetStoreIngestion *ingestion, size_t maximum)
+{
+    size_t count = ingestion->fileCount < maximum ? ingestion->fileCount : maximum;
+    return count > 0 ? count : 1;
+}
+
+bool AssetStoreIngestionRunWorker(AssetStoreIngestion *ingestion)
+{
+    uint8_t *buffer = malloc(ASSET_STORE_BUFFER_LENGTH);
+    if (buffer == NULL) {
+        atomic_store(&ingestion->failed, true);
+        return false;
+    }
+
+    while (!atomic_load(&ingestion->failed)) {
+        size_t next = atomic_fetch_add(&ingestion->nextFile, 1);
+        if (next >= ingestion->fileCount) {
+            break;
+        }
+        const AssetStoreFile *file = &ingestion->files[next];
+        if (!ingestFile(ingestion, file, buffer)) {
+            atomic_store(&ingestion->failed, true);
+            break;
+        }
+        atomic_fetch_add(&ingestion->ingestedBytes, file->size);
+        atomic_fetch_add(&ingestion->ingestedFiles, 1);
+    }
+
+    free(buffer);
+    return !atomic_load(&ingestion->failed);
+}
+
+void AssetStoreIngestionGetProgress(const AssetStoreIngestion *ingestion, AssetStoreProgress *progress)
+{
+    progress->totalBytes = ingestion->totalBytes;
+    progress->ingestedBytes = atomic_load(&((AssetStoreIngestion *)ingestion)->ingestedBytes);
+    progress->sharedBytes = atomic_load(&((AssetStoreIngestion *)ingestion)->sharedBytes);
+    progress->fileCount = ingestion->fileCount;
+    progress->ingestedFiles = atomic_load(&((AssetStoreIngestion *)ingestion)->ingestedFiles);
+}
+
+uint64_t AssetStoreCollectGarbage(const char *storeDirectory)
+{
+    uint64_t freedBytes = 0;
+    DIR *store = opendir(storeDirectory);
+    if (store == NULL) {
+        return 0;
+    }
+    struct dirent *group;
+    while ((group = readdir(store)) != NULL) {
+        if (strlen(group->d_name) != 2 || strcmp(group->d_name, "..") == 0) {
+            continue;
+        }
+        char *groupPath = joinPath(storeDirectory, group->d_name);
+        DIR *directory = groupPath != NULL ? opendir(groupPath) : NULL;
+        if (directory == NULL) {
+            free(groupPath);
+            continue;
+        }
+        struct dirent *item;
+        while ((item = readdir(directory)) != NULL) {
+            if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0) {
+                continue;
+            }
+            char *path = joinPath(groupPath, item->d_name);
+            struct stat status;
+            //The store's own link is the only one left.
+            if (path != NULL && lstat(path, &status) == 0 && S_ISREG(status.st_mode) && status.st_nlink == 1 && unlink(path) == 0) {
+                freedBytes += (uint64_t)status.st_size;
+            }
+            free(path);
+        }
+        closedir(directory);
+        //This only succeeds once the directory is empty.
+        rmdir(groupPath);
+        free(groupPath);
+    }
+    closedir(store);
+    return freedBytes;
+}
+
+#pragma mark - Private functions
+
+static bool listDirectory(AssetStoreIngestion *ingestion, const char *path, const char **excludedNames)
+{
+    //Links aren't followed, so that nothing outside the score is ever stored (or replaced).
+    DIR *directory = opendir(path);
+    if (directory == NULL) {
+        return false;
+    }
+    bool success = true;
+    struct dirent *item;
+    while (success && (item = readdir(directory)) != NULL) {
+        if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0 || isExcluded(item->d_name, excludedNames)) {
+            continue;
+        }
+        char *itemPath = joinPath(path, item->d_name);
+        struct stat status;
+        if (itemPath == NULL) {
+            success = false;
+        } else if (lstat(itemPath, &status) != 0) {
+            //Skip it.
+        } else if (S_ISDIR(status.st_mode)) {
+            success = listDirectory(ingestion, itemPath, excludedNames);
+        } else if (S_ISREG(status.st_mode)) {
+            success = addFile(ingestion, itemPath, (uint64_t)status.st_size);
+            if (success) {
+                itemPath = NULL;
+            }
+        }
+        free(itemPath);
+    }
+    closedir(directory);
+    return success;
+}
+
+static bool isExcluded(const char *name, const char **excludedNames)
+{
+    if (excludedNames == NULL) {
+        return false;
+    }
+    for (int i = 0; excludedNames[i] != NULL; i++) {
+        if (strcmp(name, excludedNames[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool addFile(AssetStoreIngestion *ingestion, char *path, uint64_t size)
+{
+    if (ingestion->fileCount == ingestion->fileCapacity) {
+        size_t capacity = ingestion->fileCapacity > 0 ? ingestion->fileCapacity * 2 : 64;
+        AssetStoreFile *files = realloc(ingestion->files, capacity * sizeof(AssetStoreFile));
+        if (files == NULL) {
+            return false;
+        }
+        ingestion->files = files;
+        ingestion->fileCapacity = capacity;
+    }
+    ingestion->files[ingestion->fileCount].path = path;
+    ingestion->files[ingestion->fileCount].size = size;
+    ingestion->fileCount++;
+    ingestion->totalBytes += size;
+    return true;
+}
+
+static char *joinPath(const char *directory, const char *name)
+{
+    size_t directoryLength = strlen(directory);
+    size_t nameLength = strlen(name);
+    char *path = malloc(directoryLength + nameLength + 2);
+    if (path == NULL) {
+        return NULL;
+    }
+    memcpy(path, directory, directoryLength);
+    path[directoryLength] = '/';
+    memcpy(path + directoryLength + 1, name, nameLength + 1);
+    return path;
+}
+
+static bool makeDirectory(const char *path)
+{
+    if (mkdir(path, 0755) == 0) {
+        return true;
+    }
+    //Anything already there has to be a real directory (and not a link to somewhere else).
+    struct stat status;
+    return errno == EEXIST && lstat(path, &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+static bool digestDescriptor(int fd, uint8_t *buffer, uint8_t digest[ASSET_STORE_DIGEST_LENGTH])
+{
+    CC_SHA256_CTX context;
+    CC_SHA256_Init(&context);
+    while (true) {
+        ssize_t count = read(fd, buffer, ASSET_STORE_BUFFER_LENGTH);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            return false;
+        }
+        if (count == 0) {
+            break;
+        }
+        CC_SHA256_Update(&context, buffer, (CC_LONG)count);
+    }
+    CC_SHA256_Final(digest, &context);
+    return true;
+}
+
+static bool ingestFile(AssetStoreIngestion *ingestion, const AssetStoreFile *file, uint8_t *buffer)
+{
+    int fd = open(file->path, O_RDONLY | O_NOFOLLOW);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    uint8_t digest[ASSET_STORE_DIGEST_LENGTH];
+    bool readable = fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && digestDescriptor(fd, buffer, digest);
+    close(fd);
+    if (!readable) {
+        return false;
+    }
+
+    //Stored as <first byte>/<the rest>, in hex, so that no one directory gets too big.
+    static const char hexDigits[] = "0123456789abcdef";
+    char group[3];
+    char name[ASSET_STORE_DIGEST_LENGTH * 2 - 1];
+    group[0] = hexDigits[digest[0] >> 4];
+    group[1] = hexDigits[digest[0] & 0xf];
+    group[2] = '\0';
+    for (int i = 1; i < ASSET_STORE_DIGEST_LENGTH; i++) {
+        name[i * 2 - 2] = hexDigits[digest[i] >> 4];
+        name[i * 2 - 1] = hexDigits[digest[i] & 0xf];
+    }
+    name[ASSET_STORE_DIGEST_LENGTH * 2 - 2] = '\0';
+
+    char *groupPath = joinPath(ingestion->storeDirectory, group);
+    char *storedPath = groupPath != NULL ? joinPath(groupPath, name) : NULL;
+    bool success = storedPath != NULL;
+    bool shared = false;
+    //Anything that goes wrong from here on just leaves the file unshared.
+    if (success && makeDirectory(groupPath) && linkFile(file->path, &status, storedPath, &shared) && shared) {
+        atomic_fetch_add(&ingestion->sharedBytes, file->size);
+    }
+    free(storedPath);
+    free(groupPath);
+    return success;
+}
+
+static bool linkFile(const char *path, const struct stat *status, const char *storedPath, bool *shared)
+{
+    //Makes the file at the path and the stored file one and the same, whichever way round that
+    //needs to happen. A stored file can be collected at any point, so if it disappears part way
+    //through, this starts again and stores the file instead.
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (link(path, storedPath) == 0) {
+            chmod(storedPath, S_IRUSR | S_IRGRP | S_IROTH);
+            return true;
+        }
+        if (errno != EEXIST) {
+            return false;
+        }
+
+        struct stat storedStatus;
+        if (lstat(storedPath, &storedStatus) != 0) {
+            if (errno == ENOENT) {
+                continue;
+            }
+            return false;
+        }
+        if (storedStatus.st_dev == status->st_dev && storedStatus.st_ino == status->st_ino) {
+            //Already stored.
+            *shared = storedStatus.st_nlink > 2;
+            return true;
+        }
+        if (!S_ISREG(storedStatus.st_mode) || storedStatus.st_size != status->st_size) {
+            //Something other than the store has changed it, so it's best left alone.
+            return false;
+        }
+
+        char *temporaryPath = malloc(strlen(path) + strlen(ASSET_STORE_TEMPORARY_SUFFIX) + 1);
+        if (temporaryPath == NULL) {
+            return false;
+        }
+        strcpy(temporaryPath, path);
+        strcat(temporaryPath, ASSET_STORE_TEMPORARY_SUFFIX);
+        unlink(temporaryPath);
+        if (link(storedPath, temporaryPath) != 0) {
+            bool collected = errno == ENOENT;
+            free(temporaryPath);
+            if (collected) {
+                continue;
+            }
+            return false;
+        }
+        bool success = rename(temporaryPath, path) == 0;
+        if (!success) {
+            unlink(temporaryPath);
+        }
+        free(temporaryPath);
+        *shared = success;
+        return success;
+    }
+    return false;
+}
+
+static int compareFilesBySize(const void *a, const void *b)
+{
+    uint64_t first = ((const AssetStoreFile *)a)->size;
+    uint64_t second = ((const AssetStoreFile *)b)->size;
+    return first < second ? 1 : (first > second ? -1 : 0);
+}
@@ -0,0 +1,67 @@
+//
+//  AssetStore.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Keeps a single copy of each distinct file in the score library. Stored files are named by the
+//SHA-256 of their contents (in subdirectories named after the first byte), and the files in score
+//directories are hard links to them. That makes the link count of a stored file its reference
+//count: once it's down to one, no score uses it any more and it can be collected.
+//This relies on files in score directories never being changed in place. Everything that writes
+//to them replaces the file instead (with an atomic write or unlink and create), which leaves the
+//stored copy alone. Stored files are made read only so that anything that doesn't gets an error
+//rather than changing every score that shares the file.
+//
+//Storing a directory works like ZipExtract: the files are listed once, and then any number of
+//workers hash them and link them into the store, largest first.
+
+#ifndef AssetStore_h
+#define AssetStore_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ASSET_STORE_DIGEST_LENGTH 32
+
+typedef struct AssetStoreIngestion AssetStoreIngestion;
+
+typedef struct {
+    uint64_t totalBytes;
+    uint64_t ingestedBytes;
+    //Bytes in files that were already in the store, and so no longer take up any space of their own.
+    uint64_t sharedBytes;
+    size_t fileCount;
+    size_t ingestedFiles;
+} AssetStoreProgress;
+
+//Hashes a whole file. Returns false if it can't be read.
+bool AssetStoreDigestFile(const char *path, uint8_t digest[ASSET_STORE_DIGEST_LENGTH]);
+void AssetStoreDigestBytes(const uint8_t *bytes, size_t length, uint8_t digest[ASSET_STORE_DIGEST_LENGTH]);
+
+//Lists the regular files under a directory, leaving out files and directories with the given
+//names wherever they are. (The list ends with NULL, and can be NULL itself.) The store directory
+//is created if it doesn't exist, and has to be on the same volume. Returns NULL if either the
+//store or the directory can't be opened.
+AssetStoreIngestion *AssetStoreIngestionOpen(const char *storeDirectory, const char *directory, const char **excludedNames);
+void AssetStoreIngestionClose(AssetStoreIngestion *ingestion);
+
+//The number of workers worth running, at most the given maximum.
+size_t AssetStoreIngestionWorkerCount(const AssetStoreIngestion *ingestion, size_t maximum);
+//Stores files until there are none left. Call this from as many threads as there are workers.
+//A file that can't be linked (because the volume doesn't allow it, say) is left as it is, and
+//only counts as a failure if it can't be read. Returns false if anything has failed.
+bool AssetStoreIngestionRunWorker(AssetStoreIngestion *ingestion);
+
+//Can be called from any thread while the workers are running.
+void AssetStoreIngestionGetProgress(const AssetStoreIngestion *ingestion, AssetStoreProgress *progress);
+
+//Deletes the stored files that no score links to any more, and returns the number of bytes freed.
+//It's safe to run while files are being stored. A score always keeps its copy, and at worst a file
+//that's linked to just as it's collected won't be shared with the next score that has it.
+uint64_t AssetStoreCollectGarbage(const char *storeDirectory);
+
+#endif /* AssetStore_h */
@@ -13,8 +13,10 @@
 #import "CageEvent.h"
 #import "CageSlide.h"
 #import "TalkingBoard.h"
+#import "FrameClock.h"
+#import "ScoreArchive.h"
 
-@interface Cage ()
+@interface Cage () <FrameClockSubscriber>
 
 //These methods are used for both Variation 1 and 2
 - (void)variation1Reset;
@@ -22,7 +24,7 @@
 - (void)variation1Seek:(CGFloat)location;
 - (void)variation1ChangeDuration:(CGFloat)duration;
 - (void)variation1Rotate;
-- (void)scrollerAnimate;
+- (void)enableScrolling:(BOOL)enabled;
 //Variation 1
 - (void)initSlides;
 - (void)randomizeSlideOrder;
@@ -82,7 +84,9 @@
     //Variation 1 and 2 specific
     CALayer *readLine;
     CALayer *scroller;
-    NSTimer *scrollTimer;
+    BOOL scrolling;
+    CFTimeInterval scrollStartTime;
+    CGFloat scrollStartX;
     NSMutableArray *lineSlides;
     CageSlide *dotSlide;
     NSMutableArray *events;
@@ -156,7 +160,7 @@
 
 - (void)variation1Reset
 {
-    [scrollTimer invalidate];
+    [self enableScrolling:NO];
     canvas.sublayers = nil;
     
     //Reading line
@@ -201,12 +205,16 @@
 
 - (void)variation1Play
 {
-    scrollTimer = [NSTimer scheduledTimerWithTimeInterval:(1 / (float)CAGE_FRAMERATE) target:self selector:@selector(scrollerAnimate) userInfo:nil repeats:YES];
+    [self enableScrolling:YES];
 }
 
 - (void)variation1Seek:(CGFloat)location
 {
     scroller.position = CGPointMake(readLineOffset - (scroller.bounds.size.width * location), 0);
+    if (scrolling) {
+        //Carry on scrolling from our new position.
+        [self enableScrolling:YES];
+    }
 }
 
 - (void)variation1ChangeDuration:(CGFloat)duration
@@ -251,14 +259,33 @@
     [CATransaction commit];
 }
 
-- (void)scrollerAnimate
+- (void)animateToTime:(CFTimeInterval)frameTime
 {
+    //We move one pixel per frame of our nominal frame rate, counted from when we started.
+    CGFloat scrollerX = scrollStartX - floor(MAX(frameTime - scrollStartTime, 0) * CAGE_FRAMERATE);
+    if (scrollerX == scroller.position.x) {
+        return;
+    }
+    
     [CATransaction begin];
     [CATransaction setAnimationTimingFunction:[CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear]];
-    scroller.position = CGPointMake(scroller.position.x - 1, 0);
+    scroller.position = CGPointMake(scrollerX, 0);
     [CATransaction commit];
     if (scroller.position.x <= 150 - scroller.bounds.size.width) {
-        [scrollTimer invalidate];
+        [self enableScrolling:NO];
+    }
+}
+
+- (void)enableScrolling:(BOOL)enabled
+{
+    if (enabled) {
+        scrollStartTime = [[FrameClock sharedClock] currentTime];
+        scrollStartX = scroller.position.x;
+        [[FrameClock sharedClock] addSubscriber:self];
+        scrolling = YES;
+    } else if (scrolling) {
+        [[FrameClock sharedClock] removeSubscriber:self];
+        scrolling = NO;
     }
 }
 
@@ -1371,7 +1398,7 @@
     prefsCondition = [NSCondition new];
     if (score.prefsFile != nil && (score.variationNumber == -1 || score.variationNumber == 1 || score.variationNumber == 2 || score.variationNumber == 6)) {
         
-        NSData *prefsData = [[NSData alloc] initWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
+        NSData *prefsData = [ScoreArchive dataWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
         if (prefsData != nil) {
             prefsLoaded = NO;
             parser = [[CageParser alloc] initWithVaritionNumber:score.variationNumber prefsData:prefsData];
@@ -1384,7 +1411,7 @@
 }
 
 - (void)close {
-    [scrollTimer invalidate];
+    [self enableScrolling:NO];
     [fadeTimer invalidate];
     
     if (currentVariation == 5) {
@@ -9,6 +9,7 @@
 #import "Canvas.h"
 #import "Score.h"
 #import "OSCMessage.h"
+#import "ScoreArchive.h"
 
 @interface Canvas ()
 
@@ -284,7 +285,7 @@
     //Check if we have a preferences file and load preferences if needed.
     if (score.prefsFile != nil) {
         NSString *prefsFile = [score.scorePath stringByAppendingPathComponent:score.prefsFile];
-        NSData *prefsData = [[NSData alloc] initWithContentsOfFile:prefsFile];
+        NSData *prefsData = [ScoreArchive dataWithContentsOfFile:prefsFile];
         xmlParser = [[NSXMLParser alloc] initWithData:prefsData];
         
         isData = NO;
@@ -6,10 +6,11 @@
 //  Copyright (c) 2018 Decibel. All rights reserved.
 
 #import "CanvasScroller.h"
+#import "FrameClock.h"
 
-@interface CanvasScroller ()
+@interface CanvasScroller () <FrameClockSubscriber>
 
-- (void)animate;
+- (void)enableAnimation:(BOOL)enabled;
 
 @end
 
@@ -17,31 +18,38 @@
     NSString *scorePath;
     CALayer *scroller;
     
-    NSTimer *highRes;
+    BOOL animating;
+    CFTimeInterval animationStartTime;
+    CGFloat animationStartX;
     CGFloat pixelsPerShift;
-    CGFloat timerInterval;
     
     int rgba[4];
 }
 
 @synthesize containerLayer, partNumber, parentLayer, isRunning;
 
-- (void)animate
+- (void)animateToTime:(CFTimeInterval)frameTime
 {
-    int scrollerX = scroller.position.x - pixelsPerShift;
-    //If the scroller has reached the boundaries of the container, stop our timer.
+    //Still move in whole shifts so that we're limited to our maximum frame rate, but count
+    //them from the time we started rather than from our last position.
+    int shifts = floor(scrollerSpeed * MAX(frameTime - animationStartTime, 0) / pixelsPerShift);
+    int scrollerX = animationStartX - (shifts * pixelsPerShift);
+    if (scrollerX == (int)scroller.position.x) {
+        return;
+    }
+    
+    //If the scroller has reached the boundaries of the container, stop our animation.
     //Keep the isRunning variable set though so that a change in speed in the opposite
     //direction will resume the scroller.
-    
     if (pixelsPerShift > 0) {
         if (scrollerX <= -scroller.bounds.size.width) {
             scrollerX = -scroller.bounds.size.width;
-            [highRes invalidate];
+            [self enableAnimation:NO];
         }
     } else if (pixelsPerShift < 0) {
         if (scrollerX >= containerLayer.bounds.size.width) {
             scrollerX = containerLayer.bounds.size.width;
-            [highRes invalidate];
+            [self enableAnimation:NO];
         }
     }
     [CATransaction begin];
@@ -50,6 +58,19 @@
     [CATransaction commit];
 }
 
+- (void)enableAnimation:(BOOL)enabled
+{
+    if (enabled) {
+        animationStartTime = [[FrameClock sharedClock] currentTime];
+        animationStartX = scroller.position.x;
+        [[FrameClock sharedClock] addSubscriber:self];
+        animating = YES;
+    } else if (animating) {
+        [[FrameClock sharedClock] removeSubscriber:self];
+        animating = NO;
+    }
+}
+
 #pragma mark CanvasObject delegate
 
 - (id)initWithScorePath:(NSString *)path
@@ -193,15 +214,13 @@
     } else if (speed < 0) {
         pixelsPerShift = floorf(speed / MAX_CANVASSCROLLER_FRAMERATE);
     } else {
-        //If our speed is set to zero, then invalidate the timer and leave.
+        //If our speed is set to zero, then stop animating and leave.
         pixelsPerShift = 0;
-        [highRes invalidate];
+        [self enableAnimation:NO];
         return;
     }
     
-    //Otherwise set the timer interval and restart the timer if necessary.
-    timerInterval = pixelsPerShift / speed;
-    
+    //Otherwise restart the animation at the new speed if necessary.
     if (isRunning) {
         [self stop];
         [self start];
@@ -241,7 +260,7 @@
 
 - (void)start
 {
-    //If our timer is already running or our scroller speed is zero he are done here.
+    //If we're already running or our scroller speed is zero he are done here.
     if (isRunning || scrollerSpeed == 0) {
         //Even if our speed is zero, set our scroller as running.
         //This way a change of speed will have the effect of starting it.
@@ -249,19 +268,13 @@
         return;
     }
     
-    //For safety, invalidate the highres timer if it already exists.
-    if (highRes != nil) {
-        [highRes invalidate];
-    }
-    
-    //Set up our timer.
-    highRes = [NSTimer scheduledTimerWithTimeInterval:timerInterval target:self selector:@selector(animate) userInfo:nil repeats:YES];
+    [self enableAnimation:YES];
     isRunning = YES;
 }
 
 - (void)stop
 {
-    [highRes invalidate];
+    [self enableAnimation:NO];
     isRunning = NO;
 }
 
@@ -9,6 +9,8 @@
 #import <QuartzCore/QuartzCore.h>
 #import "ChainLoader.h"
 #import "Score.h"
+#import "CompiledScore.h"
+#import "ScoreArchive.h"
 //#import "OSCMessage.h"
 
 @interface ChainLoader ()
@@ -104,11 +106,23 @@
     prefsLoaded = NO;
     
     awaitingOpus = NO;
-    NSData *xmlScore = [[NSData alloc] initWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.fileName]];
-    OpusParser *parser = [[OpusParser alloc] initWithData:xmlScore scorePath:score.scorePath timeOut:5 asScoreComponent:YES];
-    parser.delegate = self;
     
-    NSData *prefsData = [[NSData alloc] initWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
+    //If the score has been compiled, the collection of scores has already been parsed.
+    CompiledScore *compiledScore = [CompiledScore compiledScoreForScorePath:score.scorePath];
+    NSArray *compiledScores = [compiledScore scoresForOpusFile:score.fileName];
+    if (compiledScores != nil) {
+        scores = [compiledScores mutableCopy];
+        opusLoaded = YES;
+    } else {
+        NSData *xmlScore = [ScoreArchive dataWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.fileName]];
+        OpusParser *parser = [[OpusParser alloc] initWithData:xmlScore scorePath:score.scorePath timeOut:5 asScoreComponent:YES];
+        parser.delegate = self;
+    }
+    
+    NSData *prefsData = [compiledScore dataForFile:score.prefsFile];
+    if (prefsData == nil) {
+        prefsData = [ScoreArchive dataWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
+    }
     xmlParser = [[NSXMLParser alloc] initWithData:prefsData];
     isData = NO;
     awaitingPrefs = NO;
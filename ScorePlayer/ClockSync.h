@@ -0,0 +1,32 @@
+//
+//  ClockSync.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+//Estimates the offset and drift of a remote clock from Ping/Pong round trips. Only the samples
+//with the lowest round trip times are trusted (these have the least queueing delay), and a line
+//is fitted through their offsets once they cover enough time to give a meaningful drift.
+//All times are in seconds, and the offset is remote time minus local time.
+
+@interface ClockSync : NSObject
+
+@property (nonatomic, readonly) NSUInteger sampleCount;
+//The offset as of our most recent trusted sample. Use offsetAtTime: to account for drift.
+@property (nonatomic, readonly) double offset;
+@property (nonatomic, readonly) double drift;
+@property (nonatomic, readonly) double minimumRoundTrip;
+//An estimate of how far our offset could be out. This grows with the round trip time
+//and with how noisy our filtered samples are.
+@property (nonatomic, readonly) double uncertainty;
+@property (nonatomic, readonly) BOOL isSynchronised;
+
+- (void)addSampleWithStartTime:(double)startTime remoteTime:(double)remoteTime endTime:(double)endTime;
+- (double)offsetAtTime:(double)localTime;
+- (void)reset;
+
+@end
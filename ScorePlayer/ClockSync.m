@@ -0,0 +1,160 @@
+//
+//  ClockSync.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ClockSync.h"
+
+#define CLOCK_SYNC_WINDOW 64
+
+//Samples within this margin of the best round trip time are used for our estimate.
+static const double RTT_TOLERANCE_FACTOR = 1.5;
+static const double RTT_TOLERANCE_MINIMUM = 0.001;
+//We need this many filtered samples over this many seconds before estimating drift.
+static const NSUInteger DRIFT_MIN_SAMPLES = 6;
+static const double DRIFT_MIN_SPAN = 20;
+//Crystal oscillators should be well within this. Anything larger is noise.
+static const double DRIFT_LIMIT = 0.0005;
+//A good sample this far from our prediction means the remote clock has been stepped.
+static const double STEP_THRESHOLD = 0.1;
+
+typedef struct {
+    double time;
+    double offset;
+    double roundTrip;
+} ClockSample;
+
+@interface ClockSync ()
+
+- (void)updateEstimate;
+
+@end
+
+@implementation ClockSync {
+    ClockSample samples[CLOCK_SYNC_WINDOW];
+    NSUInteger nextSample;
+    double referenceTime;
+    NSUInteger stepCount;
+}
+
+@synthesize sampleCount, offset, drift, minimumRoundTrip, uncertainty, isSynchronised;
+
+- (id)init
+{
+    self = [super init];
+    [self reset];
+    return self;
+}
+
+- (void)reset
+{
+    sampleCount = 0;
+    nextSample = 0;
+    offset = 0;
+    drift = 0;
+    referenceTime = 0;
+    minimumRoundTrip = 0;
+    uncertainty = INFINITY;
+    isSynchronised = NO;
+    stepCount = 0;
+}
+
+- (void)addSampleWithStartTime:(double)startTime remoteTime:(double)remoteTime endTime:(double)endTime
+{
+    double roundTrip = endTime - startTime;
+    if (roundTrip < 0 || roundTrip > 10) {
+        //This can't be a valid response.
+        return;
+    }
+    
+    ClockSample sample;
+    sample.time = (startTime + endTime) / 2;
+    sample.offset = remoteTime - sample.time;
+    sample.roundTrip = roundTrip;
+    
+    //If a sample with a good round trip time disagrees badly with our current estimate a few
+    //times in a row, the remote clock has been changed underneath us. Start again.
+    if (isSynchronised && roundTrip <= minimumRoundTrip * RTT_TOLERANCE_FACTOR + RTT_TOLERANCE_MINIMUM) {
+        if (fabs(sample.offset - [self offsetAtTime:sample.time]) > STEP_THRESHOLD) {
+            stepCount++;
+            if (stepCount >= 3) {
+                [self reset];
+            }
+        } else {
+            stepCount = 0;
+        }
+    }
+    
+    samples[nextSample] = sample;
+    nextSample = (nextSample + 1) % CLOCK_SYNC_WINDOW;
+    if (sampleCount < CLOCK_SYNC_WINDOW) {
+        sampleCount++;
+    }
+    [self updateEstimate];
+}
+
+- (double)offsetAtTime:(double)localTime
+{
+    return offset + drift * (localTime - referenceTime);
+}
+
+- (void)updateEstimate
+{
+    minimumRoundTrip = INFINITY;
+    for (NSUInteger i = 0; i < sampleCount; i++) {
+        minimumRoundTrip = MIN(minimumRoundTrip, samples[i].roundTrip);
+    }
+    double threshold = minimumRoundTrip * RTT_TOLERANCE_FACTOR + RTT_TOLERANCE_MINIMUM;
+    
+    //Get the mean time and offset of our filtered samples.
+    NSUInteger count = 0;
+    double meanTime = 0, meanOffset = 0, firstTime = INFINITY, lastTime = -INFINITY;
+    for (NSUInteger i = 0; i < sampleCount; i++) {
+        if (samples[i].roundTrip <= threshold) {
+            count++;
+            meanTime += samples[i].time;
+            meanOffset += samples[i].offset;
+            firstTime = MIN(firstTime, samples[i].time);
+            lastTime = MAX(lastTime, samples[i].time);
+        }
+    }
+    meanTime /= count;
+    meanOffset /= count;
+    
+    //Least squares fit of offset against time, if we have enough spread to make it worthwhile.
+    double slope = 0;
+    if (count >= DRIFT_MIN_SAMPLES && lastTime - firstTime >= DRIFT_MIN_SPAN) {
+        double covariance = 0, variance = 0;
+        for (NSUInteger i = 0; i < sampleCount; i++) {
+            if (samples[i].roundTrip <= threshold) {
+                covariance += (samples[i].time - meanTime) * (samples[i].offset - meanOffset);
+                variance += (samples[i].time - meanTime) * (samples[i].time - meanTime);
+            }
+        }
+        if (variance > 0) {
+            slope = MAX(-DRIFT_LIMIT, MIN(DRIFT_LIMIT, covariance / variance));
+        }
+    }
+    
+    //Then see how well our samples fit.
+    double residuals = 0;
+    for (NSUInteger i = 0; i < sampleCount; i++) {
+        if (samples[i].roundTrip <= threshold) {
+            double error = samples[i].offset - (meanOffset + slope * (samples[i].time - meanTime));
+            residuals += error * error;
+        }
+    }
+    
+    //Store our estimate relative to our most recent good sample.
+    referenceTime = lastTime;
+    offset = meanOffset + slope * (lastTime - meanTime);
+    drift = slope;
+    //Our offset can't be more accurate than half the round trip, since we assume a symmetric path.
+    uncertainty = minimumRoundTrip / 2 + sqrt(residuals / count);
+    isSynchronised = count >= 3;
+}
+
+@end
@@ -0,0 +1,44 @@
+//
+//  CompiledScore.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+//The compiled form of a downloaded score directory (see ScoreBundle.h), kept in the caches
+//directory. It knows the dimensions of every image in the score, carries the contents of the
+//XML and other small files, and has the scores from each opus file already parsed, so that a
+//score can be checked and loaded without opening and parsing each of its files in turn.
+//A compiled score is only used while it matches the directory it was built from, and is built
+//again in the background once the directory changes. Scores built into the app aren't compiled.
+
+@interface CompiledScore : NSObject
+
+@property (nonatomic, readonly) NSString *scorePath;
+
+//Returns the compiled form of a score directory, or nil if there isn't an up to date one.
+//Compiled scores are kept open once they've been asked for.
++ (CompiledScore *)compiledScoreForScorePath:(NSString *)scorePath;
+
+//Builds the compiled form of a score directory if it's missing or out of date.
++ (BOOL)compileScorePath:(NSString *)scorePath;
++ (void)compileScorePathsInBackground:(NSArray *)scorePaths;
+
+//Closes and deletes the compiled form of a score. Call this when a score is updated or removed.
++ (void)removeCompiledScoreForScorePath:(NSString *)scorePath;
+
+//File names are relative to the score directory.
+- (BOOL)hasFile:(NSString *)fileName;
+//Returns a zero size if the file isn't an image in the score.
+- (CGSize)imageSizeOfFile:(NSString *)fileName;
+//Returns the contents of a file, straight from the mapping if they were compiled in and from
+//disk otherwise.
+- (NSData *)dataForFile:(NSString *)fileName;
+//Returns the scores that were parsed from an opus file, or nil if it isn't one.
+- (NSArray *)scoresForOpusFile:(NSString *)fileName;
+
+@end
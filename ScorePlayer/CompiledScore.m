@@ -0,0 +1,385 @@
+//
+//  CompiledScore.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "CompiledScore.h"
+#import "ScoreBundle.h"
+#import "XMLReader.h"
+#import "OpusParser.h"
+#import "Renderer.h"
+#import "Score.h"
+#import "ScoreArchive.h"
+
+static NSString *const COMPILED_SCORE_DIRECTORY = @"CompiledScores";
+static NSString *const COMPILED_SCORE_EXTENSION = @"score";
+//Files other than XML that are bigger than this (images and audio, mostly) are listed in the
+//compiled score but not copied into it, so that a score doesn't take up twice the space.
+static const unsigned long long COMPILED_SCORE_EMBED_LIMIT = 64 * 1024;
+//Parsing an opus file can add thumbnails to the directory, which changes its signature. If that
+//happens the score is compiled again straight away.
+static const NSInteger COMPILED_SCORE_ATTEMPTS = 2;
+
+static NSMutableDictionary *compiledScores;
+static NSLock *compiledScoresLock;
+
+//Collects the results of an opus parser, which calls back before it returns.
+@interface CompiledScoreOpusResults : NSObject <OpusParserDelegate>
+
+@property (nonatomic, strong) NSArray *scores;
+
+@end
+
+@implementation CompiledScoreOpusResults
+
+@synthesize scores;
+
+- (void)parserFinished:(id)parser withScores:(NSMutableArray *)newScores
+{
+    ((OpusParser *)parser).delegate = nil;
+    scores = newScores;
+}
+
+- (void)parserError:(id)parser
+{
+    ((OpusParser *)parser).delegate = nil;
+    scores = nil;
+}
+
+@end
+
+@interface CompiledScore ()
+
+- (id)initWithBundle:(ScoreBundle *)scoreBundle scorePath:(NSString *)path;
+- (const ScoreBundleEntry *)entryForFile:(NSString *)fileName;
+
++ (void)initCompiledScores;
++ (NSString *)compiledScoreDirectory;
++ (NSString *)compiledPathForScorePath:(NSString *)scorePath;
++ (NSString *)generator;
++ (BOOL)canCompileScorePath:(NSString *)scorePath;
++ (CompiledScore *)openScorePath:(NSString *)scorePath;
++ (NSData *)parsedScoresFromFile:(NSString *)fileName scorePath:(NSString *)scorePath asScoreComponent:(BOOL)subScore;
+
+@end
+
+@implementation CompiledScore {
+    ScoreBundle *bundle;
+}
+
+@synthesize scorePath;
+
+- (id)initWithBundle:(ScoreBundle *)scoreBundle scorePath:(NSString *)path
+{
+    self = [super init];
+    bundle = scoreBundle;
+    scorePath = path;
+    return self;
+}
+
+- (void)dealloc
+{
+    ScoreBundleClose(bundle);
+}
+
++ (void)initCompiledScores
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        compiledScores = [[NSMutableDictionary alloc] init];
+        compiledScoresLock = [[NSLock alloc] init];
+    });
+}
+
++ (NSString *)compiledScoreDirectory
+{
+    static NSString *compiledScoreDirectory = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        NSString *cachesDirectory = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+        compiledScoreDirectory = [cachesDirectory stringByAppendingPathComponent:COMPILED_SCORE_DIRECTORY];
+        [[NSFileManager defaultManager] createDirectoryAtPath:compiledScoreDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+    });
+    
+    return compiledScoreDirectory;
+}
+
++ (NSString *)compiledPathForScorePath:(NSString *)scorePath
+{
+    //Score directories all live in the same place, so their names are unique. (The full path
+    //can't be used since the app's container moves when it's updated.)
+    return [[[self compiledScoreDirectory] stringByAppendingPathComponent:[scorePath lastPathComponent]] stringByAppendingPathExtension:COMPILED_SCORE_EXTENSION];
+}
+
++ (NSString *)generator
+{
+    //The parsed scores depend on which renderers the app has, so they're only trusted if they
+    //were made by the same build.
+    static NSString *generator = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        generator = [NSString stringWithFormat:@"%@ (%@)", [[NSBundle mainBundle] objectForInfoDictionaryKey:@"CFBundleShortVersionString"], [[NSBundle mainBundle] objectForInfoDictionaryKey:@"CFBundleVersion"]];
+    });
+    
+    return generator;
+}
+
++ (BOOL)canCompileScorePath:(NSString *)scorePath
+{
+    return [scorePath length] > 0 && ![scorePath hasPrefix:[[NSBundle mainBundle] bundlePath]];
+}
+
++ (CompiledScore *)openScorePath:(NSString *)scorePath
+{
+    ScoreBundle *scoreBundle = ScoreBundleOpen([[self compiledPathForScorePath:scorePath] fileSystemRepresentation]);
+    if (scoreBundle == NULL) {
+        return nil;
+    }
+    
+    NSString *generator = [[NSString alloc] initWithBytes:scoreBundle->generator length:scoreBundle->generatorLength encoding:NSUTF8StringEncoding];
+    if (![generator isEqualToString:[self generator]] || scoreBundle->signature != ScoreBundleSignature([scorePath fileSystemRepresentation])) {
+        ScoreBundleClose(scoreBundle);
+        return nil;
+    }
+    return [[CompiledScore alloc] initWithBundle:scoreBundle scorePath:scorePath];
+}
+
++ (CompiledScore *)compiledScoreForScorePath:(NSString *)scorePath
+{
+    if (![self canCompileScorePath:scorePath]) {
+        return nil;
+    }
+    
+    //Remember directories without a compiled score too, so that they're only checked once.
+    [self initCompiledScores];
+    [compiledScoresLock lock];
+    id compiledScore = [compiledScores objectForKey:scorePath];
+    if (compiledScore == nil) {
+        compiledScore = [self openScorePath:scorePath];
+        if (compiledScore == nil) {
+            compiledScore = [NSNull null];
+        }
+        [compiledScores setObject:compiledScore forKey:scorePath];
+    }
+    [compiledScoresLock unlock];
+    
+    if (compiledScore == [NSNull null]) {
+        return nil;
+    }
+    return compiledScore;
+}
+
++ (BOOL)compileScorePath:(NSString *)scorePath
+{
+    //A mounted archive (see ScoreArchive.h) is already indexed, and its files aren't on disk to
+    //be listed.
+    if (![self canCompileScorePath:scorePath] || [ScoreArchive isMountedScorePath:scorePath]) {
+        return NO;
+    }
+    if ([self openScorePath:scorePath] != nil) {
+        return YES;
+    }
+    
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSArray *imageExtensions = [NSArray arrayWithObjects:@"png", @"jpg", @"jpeg", @"gif", @"tif", @"tiff", @"bmp", nil];
+    BOOL success = NO;
+    for (int attempt = 0; attempt < COMPILED_SCORE_ATTEMPTS && !success; attempt++) {
+        @autoreleasepool {
+            uint64_t signature = ScoreBundleSignature([scorePath fileSystemRepresentation]);
+            if (signature == 0) {
+                return NO;
+            }
+            
+            //List everything that the signature covers. (Hidden files and directories are skipped.)
+            NSMutableData *items = [[NSMutableData alloc] init];
+            //The items point into these, so they're kept until the bundle is written.
+            NSMutableArray *itemObjects = [[NSMutableArray alloc] init];
+            NSDirectoryEnumerator *enumerator = [fileManager enumeratorAtPath:scorePath];
+            NSString *fileName;
+            while ((fileName = [enumerator nextObject]) != nil) {
+                NSDictionary *attributes = [enumerator fileAttributes];
+                if ([[fileName lastPathComponent] hasPrefix:@"."]) {
+                    if ([[attributes fileType] isEqualToString:NSFileTypeDirectory]) {
+                        [enumerator skipDescendants];
+                    }
+                    continue;
+                }
+                if (![[attributes fileType] isEqualToString:NSFileTypeRegular]) {
+                    continue;
+                }
+                
+                NSString *path = [scorePath stringByAppendingPathComponent:fileName];
+                NSString *extension = [[fileName pathExtension] lowercaseString];
+                [itemObjects addObject:fileName];
+                ScoreBundleItem item;
+                memset(&item, 0, sizeof(ScoreBundleItem));
+                item.name = [fileName UTF8String];
+                item.size = [attributes fileSize];
+                if ([imageExtensions containsObject:extension]) {
+                    CGSize imageSize = [Renderer readImageSize:path];
+                    item.kind = kScoreBundleImage;
+                    item.width = imageSize.width;
+                    item.height = imageSize.height;
+                } else if ([extension isEqualToString:@"xml"]) {
+                    item.kind = kScoreBundleXML;
+                    item.contentsPath = [path fileSystemRepresentation];
+                    NSData *parsed = [self parsedScoresFromFile:path scorePath:scorePath asScoreComponent:![fileName isEqualToString:@"opus.xml"]];
+                    if (parsed != nil) {
+                        [itemObjects addObject:parsed];
+                        item.parsed = [parsed bytes];
+                        item.parsedLength = [parsed length];
+                    }
+                } else if (item.size <= COMPILED_SCORE_EMBED_LIMIT) {
+                    item.kind = kScoreBundleFile;
+                    item.contentsPath = [path fileSystemRepresentation];
+                }
+                [items appendBytes:&item length:sizeof(ScoreBundleItem)];
+            }
+            
+            if (ScoreBundleSignature([scorePath fileSystemRepresentation]) != signature) {
+                continue;
+            }
+            success = ScoreBundleWrite([[self compiledPathForScorePath:scorePath] fileSystemRepresentation], signature, [[self generator] UTF8String], [items bytes], [items length] / sizeof(ScoreBundleItem));
+        }
+    }
+    
+    //Make sure that the next request opens the new version.
+    if (success) {
+        [self initCompiledScores];
+        [compiledScoresLock lock];
+        [compiledScores removeObjectForKey:scorePath];
+        [compiledScoresLock unlock];
+    }
+    return success;
+}
+
++ (void)compileScorePathsInBackground:(NSArray *)scorePaths
+{
+    static dispatch_queue_t compileQueue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        compileQueue = dispatch_queue_create("com.decibel.compiledscore", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_BACKGROUND, 0));
+    });
+    
+    NSArray *paths = [scorePaths copy];
+    dispatch_async(compileQueue, ^{
+        for (int i = 0; i < [paths count]; i++) {
+            @autoreleasepool {
+                [self compileScorePath:[paths objectAtIndex:i]];
+            }
+        }
+    });
+}
+
++ (void)removeCompiledScoreForScorePath:(NSString *)scorePath
+{
+    if (![self canCompileScorePath:scorePath]) {
+        return;
+    }
+    
+    [self initCompiledScores];
+    [compiledScoresLock lock];
+    [compiledScores removeObjectForKey:scorePath];
+    [compiledScoresLock unlock];
+    [[NSFileManager defaultManager] removeItemAtPath:[self compiledPathForScorePath:scorePath] error:nil];
+}
+
++ (NSData *)parsedScoresFromFile:(NSString *)fileName scorePath:(NSString *)scorePath asScoreComponent:(BOOL)subScore
+{
+    NSData *xmlData __attribute__((objc_precise_lifetime)) = [NSData dataWithContentsOfFile:fileName options:NSDataReadingMappedIfSafe error:nil];
+    if (xmlData == nil) {
+        return nil;
+    }
+    
+    //Only opus files are parsed ahead of time. Anything else is left to its renderer.
+    XMLReader reader;
+    XMLReaderInit(&reader, [xmlData bytes], [xmlData length]);
+    if (XMLReaderNext(&reader) != kXMLStartElement || !XMLSpanEquals(reader.name, "opus")) {
+        return nil;
+    }
+    
+    CompiledScoreOpusResults *results = [[CompiledScoreOpusResults alloc] init];
+    OpusParser *parser = [[OpusParser alloc] initWithData:xmlData scorePath:scorePath timeOut:5 asScoreComponent:subScore];
+    parser.delegate = results;
+    [parser startParse];
+    if (results.scores == nil) {
+        return nil;
+    }
+    
+    NSMutableArray *propertyLists = [[NSMutableArray alloc] initWithCapacity:[results.scores count]];
+    for (int i = 0; i < [results.scores count]; i++) {
+        [propertyLists addObject:[[results.scores objectAtIndex:i] propertyListRepresentation]];
+    }
+    return [NSPropertyListSerialization dataWithPropertyList:propertyLists format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+}
+
+- (const ScoreBundleEntry *)entryForFile:(NSString *)fileName
+{
+    const char *name = [fileName UTF8String];
+    if (name == NULL) {
+        return NULL;
+    }
+    return ScoreBundleFind(bundle, name, strlen(name));
+}
+
+- (BOOL)hasFile:(NSString *)fileName
+{
+    return [self entryForFile:fileName] != NULL;
+}
+
+- (CGSize)imageSizeOfFile:(NSString *)fileName
+{
+    const ScoreBundleEntry *entry = [self entryForFile:fileName];
+    if (entry == NULL || entry->kind != kScoreBundleImage) {
+        return CGSizeZero;
+    }
+    return CGSizeMake(entry->width, entry->height);
+}
+
+- (NSData *)dataForFile:(NSString *)fileName
+{
+    const ScoreBundleEntry *entry = [self entryForFile:fileName];
+    const void *bytes = entry == NULL ? NULL : ScoreBundleData(bundle, entry);
+    if (bytes == NULL) {
+        return [NSData dataWithContentsOfFile:[scorePath stringByAppendingPathComponent:fileName] options:NSDataReadingMappedIfSafe error:nil];
+    }
+    
+    //The data keeps us, and so the mapping, alive for as long as it's needed.
+    CompiledScore *owner = self;
+    return [[NSData alloc] initWithBytesNoCopy:(void *)bytes length:(NSUInteger)entry->dataLength deallocator:^(void *dataBytes, NSUInteger length) {
+        (void)owner;
+    }];
+}
+
+- (NSArray *)scoresForOpusFile:(NSString *)fileName
+{
+    const ScoreBundleEntry *entry = [self entryForFile:fileName];
+    const void *parsed = entry == NULL ? NULL : ScoreBundleParsed(bundle, entry);
+    if (parsed == NULL) {
+        return nil;
+    }
+    
+    NSData *parsedData = [NSData dataWithBytesNoCopy:(void *)parsed length:(NSUInteger)entry->parsedLength freeWhenDone:NO];
+    NSArray *propertyLists = [NSPropertyListSerialization propertyListWithData:parsedData options:NSPropertyListImmutable format:NULL error:nil];
+    if (![propertyLists isKindOfClass:[NSArray class]]) {
+        return nil;
+    }
+    
+    NSMutableArray *scores = [[NSMutableArray alloc] initWithCapacity:[propertyLists count]];
+    for (int i = 0; i < [propertyLists count]; i++) {
+        Score *score = [[Score alloc] initWithPropertyList:[propertyLists objectAtIndex:i]];
+        if (score == nil) {
+            return nil;
+        }
+        score.scorePath = scorePath;
+        [scores addObject:score];
+    }
+    return scores;
+}
+
+@end
@@ -11,6 +11,7 @@
 
 @class Connection;
 @class OSCMessage;
+@class ClockSync;
 
 @protocol ConnectionDelegate <NSObject>
 
@@ -36,6 +37,8 @@
 @property (nonatomic, strong) NSString *deviceName;
 @property (nonatomic, strong) NSString *playerVersion;
 @property (nonatomic, strong) NSArray *scoreList;
+//The estimated offset of the peer's clock. (Only maintained by the primary server.)
+@property (nonatomic, readonly) ClockSync *clockSync;
 
 //The server initialises with a socket, and the client with an address and port
 - (id)initWithSocket:(GCDAsyncSocket *)connectionSocket;
@@ -46,5 +49,8 @@
 - (void)close;
 
 - (void)sendNetworkMessage:(OSCMessage *)message;
+//Sends an already encoded frame (including its length header). The frame may be shared
+//between connections, so it is never modified or recycled.
+- (void)sendFrame:(NSData *)frame;
 
 @end
@@ -8,6 +8,14 @@
 
 #import "Connection.h"
 #import "OSCMessage.h"
+#import "OSCBufferPool.h"
+#import "ClockSync.h"
+
+//Write tags, so that we know which completed writes used pooled buffers.
+enum {
+    kSharedFrameWrite = 0,
+    kPooledFrameWrite = 1
+};
 
 @interface Connection ()
 
@@ -21,9 +29,13 @@
     NSUInteger port;
     
     SInt32 messageLength;
+    
+    //Pooled buffers that have been handed to the socket. Writes complete in order, so these
+    //can be recycled from the front as each write finishes.
+    NSMutableArray *pendingWrites;
 }
 
-@synthesize peerAddress, localAddress, delegate, deviceName, playerVersion, scoreList;
+@synthesize peerAddress, localAddress, delegate, deviceName, playerVersion, scoreList, clockSync;
 
 - (id)initWithSocket:(GCDAsyncSocket *)connectionSocket
 {
@@ -60,6 +72,8 @@
     playerVersion = nil;
     scoreList = nil;
     messageLength = -1;
+    pendingWrites = [[NSMutableArray alloc] init];
+    clockSync = [[ClockSync alloc] init];
 }
 
 - (BOOL)connectWithDelegate:(id)connectionDelegate withTimeout:(NSInteger)timeout
@@ -119,9 +133,21 @@
 - (void)sendNetworkMessage:(OSCMessage *)message
 {
     //The returned data already includes the length of the message content as a header
-    NSData *data = [message messageAsDataWithHeader:YES];
+    NSMutableData *data = [message pooledDataWithHeader:YES];
+    if (data == nil) {
+        return;
+    }
     
-    [socket writeData:data withTimeout:-1 tag:0];
+    [pendingWrites addObject:data];
+    [socket writeData:data withTimeout:-1 tag:kPooledFrameWrite];
+}
+
+- (void)sendFrame:(NSData *)frame
+{
+    if ([frame length] == 0) {
+        return;
+    }
+    [socket writeData:frame withTimeout:-1 tag:kSharedFrameWrite];
 }
 
 #pragma mark - GCDAsyncSocket delegate
@@ -143,6 +169,15 @@
     [self reset];
 }
 
+- (void)socket:(GCDAsyncSocket *)sock didWriteDataWithTag:(long)tag
+{
+    //The socket no longer needs our oldest pooled buffer.
+    if (tag == kPooledFrameWrite && [pendingWrites count] > 0) {
+        [[OSCBufferPool sharedPool] recycleBuffer:[pendingWrites objectAtIndex:0]];
+        [pendingWrites removeObjectAtIndex:0];
+    }
+}
+
 - (void)socket:(GCDAsyncSocket *)sock didReadData:(NSData *)data withTag:(long)tag
 {
     if (messageLength == -1) {
@@ -157,7 +192,11 @@
             [self close];
             return;
         }
-        NSData *rawData = [NSData dataWithBytes:[data bytes] length:messageLength];
+        //The message is decoded in place, so avoid copying our data unless we were given extra.
+        NSData *rawData = data;
+        if ([data length] > messageLength) {
+            rawData = [data subdataWithRange:NSMakeRange(0, messageLength)];
+        }
         OSCMessage *message = [[OSCMessage alloc] initWithData:rawData];
         if (message == nil) {
             //If we get a malformed message then alert the receiver.
@@ -0,0 +1,28 @@
+//
+//  ControlScheduler.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+//Runs control changes at their scheduled times on the main queue. Pending controls are kept in
+//time order (controls scheduled for the same time run in the order they were added), so a new
+//control never displaces one that is still waiting.
+@interface ControlScheduler : NSObject
+
+@property (nonatomic, readonly) NSUInteger pendingCount;
+//The current time, in the same units as scheduled times.
+@property (nonatomic, readonly) NSTimeInterval now;
+
+//Replaces the system clock. Used to run the scheduler against simulated time, in which case
+//fireDueControls should be called whenever the simulated time is advanced.
+@property (nonatomic, copy) NSTimeInterval (^timeSource)(void);
+
+- (void)performAtTime:(NSTimeInterval)time block:(dispatch_block_t)block;
+- (void)cancelAll;
+- (void)fireDueControls;
+
+@end
@@ -0,0 +1,138 @@
+//
+//  ControlScheduler.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ControlScheduler.h"
+#import <QuartzCore/QuartzCore.h>
+
+@interface ScheduledControl : NSObject
+
+@property (nonatomic) NSTimeInterval time;
+@property (nonatomic, copy) dispatch_block_t block;
+
+@end
+
+@implementation ScheduledControl
+
+@synthesize time, block;
+
+@end
+
+@interface ControlScheduler ()
+
+- (void)scheduleTimer;
+
+@end
+
+@implementation ControlScheduler {
+    NSMutableArray *pendingControls;
+    dispatch_source_t timer;
+}
+
+@synthesize timeSource;
+
+- (id)init
+{
+    self = [super init];
+    pendingControls = [[NSMutableArray alloc] init];
+    return self;
+}
+
+- (void)dealloc
+{
+    if (timer != nil) {
+        dispatch_source_cancel(timer);
+    }
+}
+
+- (NSUInteger)pendingCount
+{
+    return [pendingControls count];
+}
+
+- (NSTimeInterval)now
+{
+    if (timeSource != nil) {
+        return timeSource();
+    }
+    return CACurrentMediaTime();
+}
+
+- (void)performAtTime:(NSTimeInterval)time block:(dispatch_block_t)block
+{
+    ScheduledControl *control = [[ScheduledControl alloc] init];
+    control.time = time;
+    control.block = block;
+    
+    //Insert after any controls due at or before the same time. There are rarely more than a
+    //couple waiting, so a linear search is fine.
+    NSUInteger index = [pendingControls count];
+    while (index > 0 && ((ScheduledControl *)[pendingControls objectAtIndex:index - 1]).time > time) {
+        index--;
+    }
+    [pendingControls insertObject:control atIndex:index];
+    [self scheduleTimer];
+}
+
+- (void)cancelAll
+{
+    [pendingControls removeAllObjects];
+    if (timer != nil) {
+        dispatch_source_cancel(timer);
+        timer = nil;
+    }
+}
+
+- (void)fireDueControls
+{
+    //Take one control at a time, since a block may schedule or cancel others.
+    while ([pendingControls count] > 0) {
+        ScheduledControl *control = [pendingControls objectAtIndex:0];
+        if (control.time > self.now) {
+            break;
+        }
+        [pendingControls removeObjectAtIndex:0];
+        control.block();
+    }
+    [self scheduleTimer];
+}
+
+#pragma mark - Private methods
+
+- (void)scheduleTimer
+{
+    //Simulated time is driven manually.
+    if (timeSource != nil) {
+        return;
+    }
+    
+    if ([pendingControls count] == 0) {
+        if (timer != nil) {
+            dispatch_source_cancel(timer);
+            timer = nil;
+        }
+        return;
+    }
+    
+    if (timer == nil) {
+        timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, DISPATCH_TIMER_STRICT, dispatch_get_main_queue());
+        __weak ControlScheduler *weakSelf = self;
+        dispatch_source_set_event_handler(timer, ^{
+            [weakSelf fireDueControls];
+        });
+        dispatch_resume(timer);
+    }
+    
+    //Arm a one shot timer for the earliest control.
+    NSTimeInterval delay = ((ScheduledControl *)[pendingControls objectAtIndex:0]).time - self.now;
+    if (delay < 0) {
+        delay = 0;
+    }
+    dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, 0);
+}
+
+@end
@@ -0,0 +1,354 @@
+//
+//  Crc32.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "Crc32.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#elif defined(__linux__) && defined(__aarch64__)
+#include <sys/auxv.h>
+#endif
+
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#define CRC32_HAVE_ARM 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC32_HAVE_CLMUL 1
+#endif
+
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#define CRC32_POLYNOMIAL 0xedb88320
+#define CRC32_BENCHMARK_ROUNDS 5
+//Below this the carry-less multiply setup costs more than it saves.
+#define CRC32_CLMUL_MINIMUM_LENGTH 64
+
+typedef uint32_t (*Crc32Function)(uint32_t crc, const uint8_t *bytes, size_t length);
+
+static pthread_once_t crc32Once = PTHREAD_ONCE_INIT;
+static uint32_t crc32Tables[16][256];
+static bool crc32Available[Crc32MethodCount];
+static Crc32Function crc32Functions[Crc32MethodCount];
+static Crc32Method crc32Best;
+
+static void initCrc32(void);
+static uint32_t crc32Slicing(uint32_t crc, const uint8_t *bytes, size_t length);
+#if defined(CRC32_HAVE_CLMUL)
+static uint32_t crc32Clmul(uint32_t crc, const uint8_t *bytes, size_t length);
+#endif
+#if defined(CRC32_HAVE_ARM)
+static bool armHasCrc32(void);
+static uint32_t crc32Arm(uint32_t crc, const uint8_t *bytes, size_t length);
+#endif
+#if defined(HAVE_ZLIB)
+static uint32_t crc32Zlib(uint32_t crc, const uint8_t *bytes, size_t length);
+#endif
+
+uint32_t Crc32Update(uint32_t crc, const void *bytes, size_t length)
+{
+    pthread_once(&crc32Once, initCrc32);
+    return crc32Functions[crc32Best](crc, bytes, length);
+}
+
+bool Crc32MethodAvailable(Crc32Method method)
+{
+    pthread_once(&crc32Once, initCrc32);
+    return method >= 0 && method < Crc32MethodCount && crc32Available[method];
+}
+
+Crc32Method Crc32BestMethod(void)
+{
+    pthread_once(&crc32Once, initCrc32);
+    return crc32Best;
+}
+
+const char *Crc32MethodName(Crc32Method method)
+{
+    switch (method) {
+        case Crc32MethodSlicingBy16:
+            return "Slicing-by-16";
+        case Crc32MethodCarrylessMultiply:
+            return "Carry-less multiply";
+        case Crc32MethodArmInstructions:
+            return "ARM CRC32 instructions";
+        case Crc32MethodZlib:
+            return "zlib";
+        default:
+            return "Unknown";
+    }
+}
+
+uint32_t Crc32UpdateWithMethod(Crc32Method method, uint32_t crc, const void *bytes, size_t length)
+{
+    if (!Crc32MethodAvailable(method)) {
+        return 0;
+    }
+    return crc32Functions[method](crc, bytes, length);
+}
+
+double Crc32Benchmark(Crc32Method method, size_t length)
+{
+    if (!Crc32MethodAvailable(method) || length == 0) {
+        return 0;
+    }
+    uint8_t *buffer = malloc(length);
+    if (buffer == NULL) {
+        return 0;
+    }
+    //A simple xorshift is enough to keep the data from being anything special.
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < length; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        buffer[i] = (uint8_t)state;
+    }
+
+    double best = 0;
+    volatile uint32_t result = 0;
+    for (int i = 0; i < CRC32_BENCHMARK_ROUNDS; i++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        result ^= crc32Functions[method](0, buffer, length);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+        if (elapsed > 0 && length / elapsed > best) {
+            best = length / elapsed;
+        }
+    }
+    (void)result;
+    free(buffer);
+    return best;
+}
+
+#pragma mark - Private functions
+
+static void initCrc32(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t value = i;
+        for (int bit = 0; bit < 8; bit++) {
+            value = (value & 1) ? (value >> 1) ^ CRC32_POLYNOMIAL : value >> 1;
+        }
+        crc32Tables[0][i] = value;
+    }
+    //Each table adds another byte of zeroes after the one the index came from.
+    for (int table = 1; table < 16; table++) {
+        for (int i = 0; i < 256; i++) {
+            uint32_t previous = crc32Tables[table - 1][i];
+            crc32Tables[table][i] = (previous >> 8) ^ crc32Tables[0][previous & 0xff];
+        }
+    }
+
+    crc32Available[Crc32MethodSlicingBy16] = true;
+    crc32Functions[Crc32MethodSlicingBy16] = crc32Slicing;
+    crc32Best = Crc32MethodSlicingBy16;
+#if defined(HAVE_ZLIB)
+    crc32Available[Crc32MethodZlib] = true;
+    crc32Functions[Crc32MethodZlib] = crc32Zlib;
+#endif
+#if defined(CRC32_HAVE_CLMUL)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")) {
+        crc32Available[Crc32MethodCarrylessMultiply] = true;
+        crc32Functions[Crc32MethodCarrylessMultiply] = crc32Clmul;
+        crc32Best = Crc32MethodCarrylessMultiply;
+    }
+#endif
+#if defined(CRC32_HAVE_ARM)
+    if (armHasCrc32()) {
+        crc32Available[Crc32MethodArmInstructions] = true;
+        crc32Functions[Crc32MethodArmInstructions] = crc32Arm;
+        crc32Best = Crc32MethodArmInstructions;
+    }
+#endif
+}
+
+static uint32_t crc32Slicing(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    crc = ~crc;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (length >= 16) {
+        uint32_t words[4];
+        memcpy(words, bytes, sizeof(words));
+        words[0] ^= crc;
+        crc = crc32Tables[15][words[0] & 0xff] ^ crc32Tables[14][(words[0] >> 8) & 0xff] ^ crc32Tables[13][(words[0] >> 16) & 0xff] ^ crc32Tables[12][words[0] >> 24] ^
+            crc32Tables[11][words[1] & 0xff] ^ crc32Tables[10][(words[1] >> 8) & 0xff] ^ crc32Tables[9][(words[1] >> 16) & 0xff] ^ crc32Tables[8][words[1] >> 24] ^
+            crc32Tables[7][words[2] & 0xff] ^ crc32Tables[6][(words[2] >> 8) & 0xff] ^ crc32Tables[5][(words[2] >> 16) & 0xff] ^ crc32Tables[4][words[2] >> 24] ^
+            crc32Tables[3][words[3] & 0xff] ^ crc32Tables[2][(words[3] >> 8) & 0xff] ^ crc32Tables[1][(words[3] >> 16) & 0xff] ^ crc32Tables[0][words[3] >> 24];
+        bytes += 16;
+        length -= 16;
+    }
+#endif
+    while (length > 0) {
+        crc = (crc >> 8) ^ crc32Tables[0][(crc ^ *bytes) & 0xff];
+        bytes++;
+        length--;
+    }
+    return ~crc;
+}
+
+#if defined(CRC32_HAVE_CLMUL)
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32Clmul(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    //Folds four 128 bit lanes at a time, then folds those into one and does a Barrett reduction,
+    //as in Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+    //The constants are for the bit reflected zip polynomial. Whatever doesn't fill a whole 16
+    //byte block is left to the tables.
+    if (length < CRC32_CLMUL_MINIMUM_LENGTH) {
+        return crc32Slicing(crc, bytes, length);
+    }
+    static const uint64_t k1k2[2] __attribute__((aligned(16))) = { 0x0154442bd4, 0x01c6e41596 };
+    static const uint64_t k3k4[2] __attribute__((aligned(16))) = { 0x01751997d0, 0x00ccaa009e };
+    static const uint64_t k5k0[2] __attribute__((aligned(16))) = { 0x0163cd6124, 0x0000000000 };
+    static const uint64_t poly[2] __attribute__((aligned(16))) = { 0x01db710641, 0x01f7011641 };
+    size_t remainder = length & 15;
+    length -= remainder;
+
+    __m128i x1 = _mm_loadu_si128((const __m128i *)(bytes + 0x00));
+    __m128i x2 = _mm_loadu_si128((const __m128i *)(bytes + 0x10));
+    __m128i x3 = _mm_loadu_si128((const __m128i *)(bytes + 0x20));
+    __m128i x4 = _mm_loadu_si128((const __m128i *)(bytes + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)~crc));
+    __m128i x0 = _mm_load_si128((const __m128i *)k1k2);
+    bytes += 64;
+    length -= 64;
+
+    while (length >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(bytes + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(bytes + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(bytes + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(bytes + 0x30)));
+        bytes += 64;
+        length -= 64;
+    }
+
+    //Fold the four lanes into one.
+    x0 = _mm_load_si128((const __m128i *)k3k4);
+    __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    while (length >= 16) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)bytes)), x5);
+        bytes += 16;
+        length -= 16;
+    }
+
+    //Down to 64 bits, then 32.
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x00), x2);
+
+    x0 = _mm_load_si128((const __m128i *)poly);
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    crc = ~(uint32_t)_mm_extract_epi32(x1, 1);
+
+    return crc32Slicing(crc, bytes, remainder);
+}
+#endif
+
+#if defined(CRC32_HAVE_ARM)
+static bool armHasCrc32(void)
+{
+#if defined(__ARM_FEATURE_CRC32)
+    return true;
+#elif defined(__APPLE__)
+    int value = 0;
+    size_t size = sizeof(value);
+    return sysctlbyname("hw.optional.armv8_crc32", &value, &size, NULL, 0) == 0 && value != 0;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return false;
+#endif
+}
+
+__attribute__((target("crc")))
+static uint32_t crc32Arm(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    //The instructions take up to 8 bytes each. Four independent streams would hide their
+    //latency a little better, but combining them costs more than it saves on score sized files.
+    crc = ~crc;
+    while (length > 0 && ((uintptr_t)bytes & 7) != 0) {
+        crc = __crc32b(crc, *bytes);
+        bytes++;
+        length--;
+    }
+    while (length >= 32) {
+        uint64_t words[4];
+        memcpy(words, bytes, sizeof(words));
+        crc = __crc32d(crc, words[0]);
+        crc = __crc32d(crc, words[1]);
+        crc = __crc32d(crc, words[2]);
+        crc = __crc32d(crc, words[3]);
+        bytes += 32;
+        length -= 32;
+    }
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        crc = __crc32d(crc, word);
+        bytes += 8;
+        length -= 8;
+    }
+    while (length > 0) {
+        crc = __crc32b(crc, *bytes);
+        bytes++;
+        length--;
+    }
+    return ~crc;
+}
+#endif
+
+#if defined(HAVE_ZLIB)
+static uint32_t crc32Zlib(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    //This is what minizip used before. zlib only takes a uInt at a time.
+    while (length > 0) {
+        uInt count = length > UINT_MAX ? UINT_MAX : (uInt)length;
+        crc = (uint32_t)crc32(crc, bytes, count);
+        bytes += count;
+        length -= count;
+    }
+    return crc;
+}
+#endif
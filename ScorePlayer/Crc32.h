@@ -0,0 +1,44 @@
+//
+//  Crc32.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//The CRC-32 used by zip archives (and zlib), with the fastest method the CPU has picked the first
+//time it's used. On ARM that's the CRC32 instructions, and on Intel it's folding with carry-less
+//multiplies (PCLMULQDQ), which is what the simulator gets. Anything else falls back to slicing-by-16
+//tables, which still take 16 bytes a step rather than zlib's one.
+//minizip's mz_crypt_crc32_update calls through to this, so every entry that's read or written
+//with minizip is checked this way too.
+
+#ifndef Crc32_h
+#define Crc32_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    Crc32MethodSlicingBy16,
+    Crc32MethodCarrylessMultiply,
+    Crc32MethodArmInstructions,
+    //zlib's own crc32, for comparison. Only available when zlib is linked in.
+    Crc32MethodZlib,
+    Crc32MethodCount
+} Crc32Method;
+
+//Takes the CRC so far (0 to start) and returns it with the bytes added. Safe to call from any thread.
+uint32_t Crc32Update(uint32_t crc, const void *bytes, size_t length);
+
+bool Crc32MethodAvailable(Crc32Method method);
+Crc32Method Crc32BestMethod(void);
+const char *Crc32MethodName(Crc32Method method);
+//Returns 0 (without touching the CRC) if the method isn't available.
+uint32_t Crc32UpdateWithMethod(Crc32Method method, uint32_t crc, const void *bytes, size_t length);
+//Times a method over a buffer of the given length, filled with noise, taking the best of several
+//rounds. Returns bytes per second, or 0 if the method isn't available or there's no memory.
+double Crc32Benchmark(Crc32Method method, size_t length);
+
+#endif /* Crc32_h */
@@ -0,0 +1,71 @@
+//
+//  DecodeService.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+//Decodes images away from the main thread on a small pool of workers. Requests are taken
+//from the most urgent lane first, and in the order they were made within a lane. Images are
+//always handed back fully decoded into a bitmap that Core Animation can use as is, so setting
+//them as layer contents never triggers a decode on the main thread.
+//
+//Large decoded images are also kept on disk in a raw tile cache (see RawTileCache.h) in the
+//caches directory, so that the next time they're needed they can be mapped straight back in.
+
+typedef enum {
+    kDecodeVisible = 0,
+    kDecodeNextUp = 1,
+    kDecodeSpeculative = 2
+} DecodePriority;
+
+static const NSInteger DECODE_PRIORITY_LANES = 3;
+//Images smaller than this are quick enough to decode that they aren't worth the disk space.
+static const size_t DECODE_RAW_CACHE_MINIMUM_BYTES = 1024 * 1024;
+static const unsigned long long DECODE_RAW_CACHE_DEFAULT_LIMIT = 512 * 1024 * 1024;
+
+@interface DecodeRequest : NSObject
+
+@property (nonatomic, readonly) NSString *fileName;
+@property (nonatomic, readonly) DecodePriority priority;
+@property (readonly, getter=isCancelled) BOOL cancelled;
+
+//Stops the completion handler from being called. If the decode hasn't started yet it is skipped.
+- (void)cancel;
+
+@end
+
+@interface DecodeService : NSObject
+
+@property (nonatomic) NSInteger maximumWorkers;
+//The most disk space that the raw tile cache is allowed to use.
+@property (nonatomic) unsigned long long rawCacheLimit;
+
++ (DecodeService *)sharedService;
+
+//Synchronously loads and fully decodes an image on the calling thread. (Or maps it from the
+//raw tile cache if an up to date copy is there.)
++ (UIImage *)decodedImageWithContentsOfFile:(NSString *)fileName;
+
+//Decodes an image in the background and calls the completion handler on the main queue.
+//(The image will be nil if the file couldn't be read.) If useCache is set, the image is
+//taken from or added to the Renderer image cache. On a cache hit the completion handler
+//is called straight away and nil is returned.
+- (DecodeRequest *)decodeImage:(NSString *)fileName priority:(DecodePriority)priority useCache:(BOOL)useCache completion:(void (^)(UIImage *image))completion;
+
+//Moves a request that hasn't started yet into a different lane.
+- (void)changePriority:(DecodePriority)priority ofRequest:(DecodeRequest *)request;
+
+//Per lane counts and timings (in seconds) of the decodes carried out so far, along with the
+//number of raw tile cache hits and misses.
+- (NSDictionary *)statistics;
+- (void)resetStatistics;
+
+//Removes everything from the raw tile cache.
+- (void)clearRawCache;
+
+@end
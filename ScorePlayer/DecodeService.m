@@ -0,0 +1,451 @@
+//
+//  DecodeService.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "DecodeService.h"
+#import <ImageIO/ImageIO.h>
+#import <QuartzCore/QuartzCore.h>
+#import "Renderer.h"
+#import "RawTileCache.h"
+#import "ScoreArchive.h"
+
+static NSString *const RAW_CACHE_DIRECTORY = @"RawTiles";
+
+@interface DecodeRequest ()
+
+@property (nonatomic, strong) NSString *fileName;
+@property (nonatomic) DecodePriority priority;
+@property (nonatomic) BOOL useCache;
+@property (nonatomic) CFTimeInterval requestTime;
+@property (nonatomic, copy) void (^completion)(UIImage *image);
+
+@end
+
+@implementation DecodeRequest {
+    volatile BOOL cancelled;
+}
+
+@synthesize fileName, priority, useCache, requestTime, completion;
+
+- (BOOL)isCancelled
+{
+    return cancelled;
+}
+
+- (void)cancel
+{
+    cancelled = YES;
+}
+
+@end
+
+@interface DecodeService ()
+
+- (void)startWorkers;
+- (DecodeRequest *)nextRequest;
+- (void)runWorker;
++ (NSString *)rawCacheDirectory;
++ (dispatch_queue_t)rawCacheQueue;
++ (UIImage *)imageFromRawTileAtPath:(NSString *)rawPath source:(const RawTileSource *)rawSource;
++ (void)storeImage:(CGImageRef)image atPath:(NSString *)rawPath source:(const RawTileSource *)rawSource;
+- (void)recordRawCacheHit:(BOOL)hit;
+
+@end
+
+static void releaseRawTile(void *info, const void *data, size_t size)
+{
+    RawTileClose(info);
+}
+
+@implementation DecodeService {
+    NSLock *lock;
+    NSMutableArray *lanes;
+    NSInteger pendingCount;
+    NSInteger activeWorkers;
+    
+    NSUInteger decodeCount[DECODE_PRIORITY_LANES];
+    NSUInteger cancelledCount[DECODE_PRIORITY_LANES];
+    NSTimeInterval decodeTime[DECODE_PRIORITY_LANES];
+    NSTimeInterval maxDecodeTime[DECODE_PRIORITY_LANES];
+    NSTimeInterval waitTime[DECODE_PRIORITY_LANES];
+    NSUInteger rawCacheHits;
+    NSUInteger rawCacheMisses;
+}
+
+@synthesize maximumWorkers, rawCacheLimit;
+
++ (DecodeService *)sharedService
+{
+    static DecodeService *sharedService = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        sharedService = [[self alloc] init];
+    });
+    
+    return sharedService;
+}
+
++ (UIImage *)decodedImageWithContentsOfFile:(NSString *)fileName
+{
+    if ([fileName length] == 0) {
+        return nil;
+    }
+    
+    //Check the raw tile cache first. Entries are keyed on the path of the source image, and
+    //are only used if the source hasn't changed since they were written.
+    RawTileSource rawSource;
+    BOOL canUseRawCache = RawTileSourceRead([fileName fileSystemRepresentation], &rawSource);
+    NSString *rawPath = nil;
+    if (canUseRawCache) {
+        char rawName[RAW_TILE_NAME_LENGTH];
+        RawTileNameForSource([fileName fileSystemRepresentation], rawName);
+        rawPath = [[self rawCacheDirectory] stringByAppendingPathComponent:[NSString stringWithUTF8String:rawName]];
+        UIImage *rawImage = [self imageFromRawTileAtPath:rawPath source:&rawSource];
+        [[self sharedService] recordRawCacheHit:rawImage != nil];
+        if (rawImage != nil) {
+            return rawImage;
+        }
+    }
+    
+    //Images in a mounted score archive are decoded straight from its mapping.
+    NSData *archivedData = canUseRawCache ? nil : [ScoreArchive archivedDataForFile:fileName];
+    CGImageSourceRef source;
+    if (archivedData != nil) {
+        source = CGImageSourceCreateWithData((__bridge CFDataRef)archivedData, NULL);
+    } else {
+        source = CGImageSourceCreateWithURL((__bridge CFURLRef)[NSURL fileURLWithPath:fileName], NULL);
+    }
+    if (source == NULL) {
+        return nil;
+    }
+    CGImageRef image = CGImageSourceCreateImageAtIndex(source, 0, NULL);
+    CFRelease(source);
+    if (image == NULL) {
+        return nil;
+    }
+    
+    //Draw the image into a bitmap in the format that Core Animation uses. An image that's only been
+    //read from disk is decoded lazily when it is first displayed, which happens on the main thread.
+    size_t width = CGImageGetWidth(image);
+    size_t height = CGImageGetHeight(image);
+    CGImageAlphaInfo alphaInfo = CGImageGetAlphaInfo(image);
+    BOOL opaque = (alphaInfo == kCGImageAlphaNone || alphaInfo == kCGImageAlphaNoneSkipFirst || alphaInfo == kCGImageAlphaNoneSkipLast);
+    CGColorSpaceRef colourSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, colourSpace, kCGBitmapByteOrder32Host | (opaque ? kCGImageAlphaNoneSkipFirst : kCGImageAlphaPremultipliedFirst));
+    CGColorSpaceRelease(colourSpace);
+    if (context == NULL) {
+        //Fall back to the undecoded image rather than showing nothing.
+        UIImage *result = [UIImage imageWithCGImage:image];
+        CGImageRelease(image);
+        return result;
+    }
+    
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    CGImageRef decodedImage = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+    CGImageRelease(image);
+    
+    if (canUseRawCache && decodedImage != NULL && CGImageGetBytesPerRow(decodedImage) * height >= DECODE_RAW_CACHE_MINIMUM_BYTES) {
+        [self storeImage:decodedImage atPath:rawPath source:&rawSource];
+    }
+    
+    UIImage *result = [UIImage imageWithCGImage:decodedImage];
+    CGImageRelease(decodedImage);
+    return result;
+}
+
++ (NSString *)rawCacheDirectory
+{
+    //The caches directory isn't backed up, and the system can clear it when space is short.
+    static NSString *rawCacheDirectory = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        NSString *cachesDirectory = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+        rawCacheDirectory = [cachesDirectory stringByAppendingPathComponent:RAW_CACHE_DIRECTORY];
+        [[NSFileManager defaultManager] createDirectoryAtPath:rawCacheDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+    });
+    
+    return rawCacheDirectory;
+}
+
++ (dispatch_queue_t)rawCacheQueue
+{
+    static dispatch_queue_t rawCacheQueue;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        rawCacheQueue = dispatch_queue_create("com.decibel.rawtilecache", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+    });
+    
+    return rawCacheQueue;
+}
+
++ (UIImage *)imageFromRawTileAtPath:(NSString *)rawPath source:(const RawTileSource *)rawSource
+{
+    RawTile *tile = RawTileOpen([rawPath fileSystemRepresentation], rawSource);
+    if (tile == NULL) {
+        return nil;
+    }
+    
+    //The image draws straight from the mapping, which stays open until the image is released.
+    //The pixels were written in the format we decode into, so Core Animation can use them as is.
+    CGDataProviderRef provider = CGDataProviderCreateWithData(tile, tile->pixels, tile->pixelLength, releaseRawTile);
+    if (provider == NULL) {
+        RawTileClose(tile);
+        return nil;
+    }
+    CGColorSpaceRef colourSpace = CGColorSpaceCreateDeviceRGB();
+    CGImageRef image = CGImageCreate(tile->format.width, tile->format.height, 8, 32, tile->format.rowBytes, colourSpace, (CGBitmapInfo)tile->format.bitmapInfo, provider, NULL, false, kCGRenderingIntentDefault);
+    CGColorSpaceRelease(colourSpace);
+    CGDataProviderRelease(provider);
+    if (image == NULL) {
+        return nil;
+    }
+    
+    UIImage *result = [UIImage imageWithCGImage:image];
+    CGImageRelease(image);
+    return result;
+}
+
++ (void)storeImage:(CGImageRef)image atPath:(NSString *)rawPath source:(const RawTileSource *)rawSource
+{
+    //Write the entry on a low priority queue so that the image can be handed back straight away.
+    RawTileSource source = *rawSource;
+    NSString *directory = [self rawCacheDirectory];
+    unsigned long long limit = [self sharedService].rawCacheLimit;
+    CGImageRetain(image);
+    dispatch_async([self rawCacheQueue], ^{
+        CFDataRef pixels = CGDataProviderCopyData(CGImageGetDataProvider(image));
+        if (pixels != NULL) {
+            RawTileFormat format;
+            format.width = (uint32_t)CGImageGetWidth(image);
+            format.height = (uint32_t)CGImageGetHeight(image);
+            format.rowBytes = (uint32_t)CGImageGetBytesPerRow(image);
+            format.bitmapInfo = (uint32_t)CGImageGetBitmapInfo(image);
+            if (CFDataGetLength(pixels) >= (CFIndex)format.rowBytes * format.height && RawTileWrite([rawPath fileSystemRepresentation], &source, &format, CFDataGetBytePtr(pixels))) {
+                RawTileTrimDirectory([directory fileSystemRepresentation], limit);
+            }
+            CFRelease(pixels);
+        }
+        CGImageRelease(image);
+    });
+}
+
+- (id)init
+{
+    self = [super init];
+    lock = [[NSLock alloc] init];
+    lanes = [[NSMutableArray alloc] initWithCapacity:DECODE_PRIORITY_LANES];
+    for (int i = 0; i < DECODE_PRIORITY_LANES; i++) {
+        [lanes addObject:[[NSMutableArray alloc] init]];
+    }
+    pendingCount = 0;
+    activeWorkers = 0;
+    [self resetStatistics];
+    
+    //Leave a core free for the main thread.
+    NSInteger cores = [NSProcessInfo processInfo].activeProcessorCount;
+    maximumWorkers = MAX(1, MIN(cores - 1, 4));
+    rawCacheLimit = DECODE_RAW_CACHE_DEFAULT_LIMIT;
+    return self;
+}
+
+- (void)setMaximumWorkers:(NSInteger)workers
+{
+    [lock lock];
+    maximumWorkers = MAX(1, workers);
+    [self startWorkers];
+    [lock unlock];
+}
+
+- (void)setRawCacheLimit:(unsigned long long)limit
+{
+    rawCacheLimit = limit;
+    NSString *directory = [DecodeService rawCacheDirectory];
+    dispatch_async([DecodeService rawCacheQueue], ^{
+        RawTileTrimDirectory([directory fileSystemRepresentation], limit);
+    });
+}
+
+- (void)clearRawCache
+{
+    NSString *directory = [DecodeService rawCacheDirectory];
+    dispatch_async([DecodeService rawCacheQueue], ^{
+        RawTileTrimDirectory([directory fileSystemRepresentation], 0);
+    });
+}
+
+- (DecodeRequest *)decodeImage:(NSString *)fileName priority:(DecodePriority)priority useCache:(BOOL)useCache completion:(void (^)(UIImage *))completion
+{
+    if (useCache) {
+        UIImage *image = [Renderer cachedImageIfPresent:fileName];
+        if (image != nil) {
+            completion(image);
+            return nil;
+        }
+    }
+    
+    DecodeRequest *request = [[DecodeRequest alloc] init];
+    request.fileName = fileName;
+    request.priority = priority;
+    request.useCache = useCache;
+    request.requestTime = CACurrentMediaTime();
+    request.completion = completion;
+    
+    [lock lock];
+    [[lanes objectAtIndex:priority] addObject:request];
+    pendingCount++;
+    [self startWorkers];
+    [lock unlock];
+    
+    return request;
+}
+
+- (void)changePriority:(DecodePriority)priority ofRequest:(DecodeRequest *)request
+{
+    if (request == nil) {
+        return;
+    }
+    
+    [lock lock];
+    NSMutableArray *lane = [lanes objectAtIndex:request.priority];
+    NSUInteger index = [lane indexOfObjectIdenticalTo:request];
+    if (index != NSNotFound && request.priority != priority) {
+        [lane removeObjectAtIndex:index];
+        request.priority = priority;
+        [[lanes objectAtIndex:priority] addObject:request];
+    }
+    [lock unlock];
+}
+
+- (NSDictionary *)statistics
+{
+    NSArray *laneNames = [NSArray arrayWithObjects:@"visible", @"nextUp", @"speculative", nil];
+    NSMutableDictionary *result = [[NSMutableDictionary alloc] init];
+    
+    [lock lock];
+    for (int i = 0; i < DECODE_PRIORITY_LANES; i++) {
+        NSMutableDictionary *lane = [[NSMutableDictionary alloc] init];
+        [lane setObject:[NSNumber numberWithUnsignedInteger:decodeCount[i]] forKey:@"decodes"];
+        [lane setObject:[NSNumber numberWithUnsignedInteger:cancelledCount[i]] forKey:@"cancelled"];
+        [lane setObject:[NSNumber numberWithDouble:decodeTime[i]] forKey:@"totalDecodeTime"];
+        [lane setObject:[NSNumber numberWithDouble:maxDecodeTime[i]] forKey:@"maxDecodeTime"];
+        [lane setObject:[NSNumber numberWithDouble:decodeCount[i] > 0 ? decodeTime[i] / decodeCount[i] : 0] forKey:@"averageDecodeTime"];
+        [lane setObject:[NSNumber numberWithDouble:decodeCount[i] > 0 ? waitTime[i] / decodeCount[i] : 0] forKey:@"averageWaitTime"];
+        [result setObject:lane forKey:[laneNames objectAtIndex:i]];
+    }
+    [result setObject:[NSNumber numberWithInteger:pendingCount] forKey:@"pending"];
+    [result setObject:[NSNumber numberWithUnsignedInteger:rawCacheHits] forKey:@"rawCacheHits"];
+    [result setObject:[NSNumber numberWithUnsignedInteger:rawCacheMisses] forKey:@"rawCacheMisses"];
+    [lock unlock];
+    
+    return result;
+}
+
+- (void)resetStatistics
+{
+    [lock lock];
+    for (int i = 0; i < DECODE_PRIORITY_LANES; i++) {
+        decodeCount[i] = 0;
+        cancelledCount[i] = 0;
+        decodeTime[i] = 0;
+        maxDecodeTime[i] = 0;
+        waitTime[i] = 0;
+    }
+    rawCacheHits = 0;
+    rawCacheMisses = 0;
+    [lock unlock];
+}
+
+- (void)recordRawCacheHit:(BOOL)hit
+{
+    [lock lock];
+    if (hit) {
+        rawCacheHits++;
+    } else {
+        rawCacheMisses++;
+    }
+    [lock unlock];
+}
+
+- (void)startWorkers
+{
+    //Must be called with the lock held.
+    while (activeWorkers < maximumWorkers && activeWorkers < pendingCount) {
+        activeWorkers++;
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+            [self runWorker];
+        });
+    }
+}
+
+- (DecodeRequest *)nextRequest
+{
+    //Must be called with the lock held. Cancelled requests are dropped here rather than
+    //being searched for when they're cancelled.
+    for (int i = 0; i < DECODE_PRIORITY_LANES; i++) {
+        NSMutableArray *lane = [lanes objectAtIndex:i];
+        while ([lane count] > 0) {
+            DecodeRequest *request = [lane objectAtIndex:0];
+            [lane removeObjectAtIndex:0];
+            pendingCount--;
+            if (!request.cancelled) {
+                return request;
+            }
+            cancelledCount[i]++;
+            request.completion = nil;
+        }
+    }
+    return nil;
+}
+
+- (void)runWorker
+{
+    while (YES) {
+        [lock lock];
+        DecodeRequest *request = [self nextRequest];
+        if (request == nil) {
+            activeWorkers--;
+            [lock unlock];
+            return;
+        }
+        [lock unlock];
+        
+        CFTimeInterval startTime = CACurrentMediaTime();
+        UIImage *image = nil;
+        if (request.useCache) {
+            //Another request may have loaded the same file while this one was waiting.
+            image = [Renderer cachedImageIfPresent:request.fileName];
+        }
+        if (image == nil) {
+            image = [DecodeService decodedImageWithContentsOfFile:request.fileName];
+            if (request.useCache && image != nil) {
+                [Renderer addImageToCache:image forFileName:request.fileName];
+            }
+        }
+        CFTimeInterval finishTime = CACurrentMediaTime();
+        
+        DecodePriority lane = request.priority;
+        [lock lock];
+        decodeCount[lane]++;
+        decodeTime[lane] += finishTime - startTime;
+        maxDecodeTime[lane] = MAX(maxDecodeTime[lane], finishTime - startTime);
+        waitTime[lane] += startTime - request.requestTime;
+        [lock unlock];
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (!request.cancelled && request.completion != nil) {
+                request.completion(image);
+            }
+            request.completion = nil;
+        });
+    }
+}
+
+@end
@@ -0,0 +1,31 @@
+//
+//  EventScheduler.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+//Runs blocks at given points in score time using a timing wheel, in place of a timer per
+//event. The scheduler has no clock of its own: the renderer advances it (usually from the
+//frame clock), so stopping the calls pauses every pending event at once.
+
+@interface EventScheduler : NSObject
+
+@property (nonatomic, readonly) NSTimeInterval currentTime;
+@property (nonatomic, readonly) NSUInteger pendingCount;
+
+- (id)initWithResolution:(NSTimeInterval)resolution;
+
+//Returns a token that can be used to cancel the event.
+- (id)scheduleAtTime:(NSTimeInterval)time block:(dispatch_block_t)block;
+- (void)cancelEvent:(id)event;
+- (void)cancelAllEvents;
+
+- (void)advanceToTime:(NSTimeInterval)time;
+//Rearms all pending events relative to a new position. Nothing fires until the next advance.
+- (void)seekToTime:(NSTimeInterval)time;
+
+@end
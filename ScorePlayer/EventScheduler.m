@@ -0,0 +1,111 @@
+//
+//  EventScheduler.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "EventScheduler.h"
+#import "TimingWheel.h"
+
+//The wheel entry lives inside the event, and the wheel holds a reference to the event (through
+//the entry's context) for as long as it's scheduled.
+@interface ScheduledEvent : NSObject {
+    @public
+    TimingWheelEntry entry;
+    dispatch_block_t block;
+}
+
+@end
+
+@implementation ScheduledEvent
+
+@end
+
+static void fireEvent(TimingWheelEntry *entry, void *userData)
+{
+    ScheduledEvent *event = (__bridge_transfer ScheduledEvent *)entry->context;
+    entry->context = NULL;
+    dispatch_block_t block = event->block;
+    event->block = nil;
+    if (block != nil) {
+        block();
+    }
+}
+
+static void releaseEvent(TimingWheelEntry *entry, void *userData)
+{
+    ScheduledEvent *event = (__bridge_transfer ScheduledEvent *)entry->context;
+    entry->context = NULL;
+    event->block = nil;
+}
+
+@implementation EventScheduler {
+    TimingWheel wheel;
+}
+
+- (id)init
+{
+    return [self initWithResolution:0.01];
+}
+
+- (id)initWithResolution:(NSTimeInterval)resolution
+{
+    self = [super init];
+    TimingWheelInit(&wheel, resolution, 0);
+    return self;
+}
+
+- (void)dealloc
+{
+    TimingWheelClear(&wheel, releaseEvent, NULL);
+}
+
+- (NSTimeInterval)currentTime
+{
+    return TimingWheelCurrentTime(&wheel);
+}
+
+- (NSUInteger)pendingCount
+{
+    return wheel.count;
+}
+
+- (id)scheduleAtTime:(NSTimeInterval)time block:(dispatch_block_t)block
+{
+    ScheduledEvent *event = [[ScheduledEvent alloc] init];
+    event->block = [block copy];
+    event->entry.context = (__bridge_retained void *)event;
+    TimingWheelSchedule(&wheel, &event->entry, time);
+    return event;
+}
+
+- (void)cancelEvent:(id)event
+{
+    if (![event isKindOfClass:[ScheduledEvent class]]) {
+        return;
+    }
+    ScheduledEvent *scheduledEvent = event;
+    if (TimingWheelIsScheduled(&scheduledEvent->entry)) {
+        TimingWheelCancel(&wheel, &scheduledEvent->entry);
+        releaseEvent(&scheduledEvent->entry, NULL);
+    }
+}
+
+- (void)cancelAllEvents
+{
+    TimingWheelClear(&wheel, releaseEvent, NULL);
+}
+
+- (void)advanceToTime:(NSTimeInterval)time
+{
+    TimingWheelAdvance(&wheel, time, fireEvent, NULL);
+}
+
+- (void)seekToTime:(NSTimeInterval)time
+{
+    TimingWheelSeek(&wheel, time);
+}
+
+@end
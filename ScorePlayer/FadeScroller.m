@@ -10,10 +10,12 @@
 #import <QuartzCore/QuartzCore.h>
 #import "Renderer.h"
 #import "OSCMessage.h"
+#import "DecodeService.h"
 
 @interface FadeScroller()
 
 - (void)setOpacities;
+- (void)loadTileImages:(NSString *)firstImageName;
 
 @end
 
@@ -29,6 +31,7 @@
     
     CGSize originalSize;
     NSString *currentImageName;
+    NSMutableArray *decodeRequests;
     
     BOOL dataInitialised;
 }
@@ -50,8 +53,39 @@
     }
 }
 
+- (void)loadTileImages:(NSString *)firstImageName
+{
+    //Drop anything still waiting from a previous part.
+    for (DecodeRequest *request in decodeRequests) {
+        [request cancel];
+    }
+    decodeRequests = [[NSMutableArray alloc] init];
+    
+    //Decode the images off the main thread. The tiles under the current position are needed
+    //straight away and the rest will be needed as we scroll. (Until they arrive, tiles keep
+    //whatever they were showing before.)
+    for (int i = 0; i < [positions count]; i++) {
+        CALayer *tile = [tileArray objectAtIndex:i];
+        CGFloat tileStart = background.position.x + tile.position.x;
+        DecodePriority priority = (tileStart <= 0 && tileStart + tile.bounds.size.width > 0) ? kDecodeVisible : kDecodeNextUp;
+        NSString *fileName = [firstImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", [[[positions objectAtIndex:i] objectAtIndex:1] intValue]]];
+        DecodeRequest *request = [[DecodeService sharedService] decodeImage:fileName priority:priority useCache:YES completion:^(UIImage *image) {
+            [CATransaction begin];
+            [CATransaction setDisableActions:YES];
+            tile.contents = (id)image.CGImage;
+            [CATransaction commit];
+        }];
+        if (request != nil) {
+            [decodeRequests addObject:request];
+        }
+    }
+}
+
 - (void)dealloc
 {
+    for (DecodeRequest *request in decodeRequests) {
+        [request cancel];
+    }
     free(widths);
 }
 
@@ -176,13 +210,18 @@
         
         //Get our image widths and take our height from our first image
         int minimumWidth = overlap * 2;
-        height = [Renderer getImageSize:firstImageName].height;
+        NSMutableArray *fileNames = [[NSMutableArray alloc] initWithCapacity:numberOfTiles];
+        for (int i = 1; i <= numberOfTiles; i++) {
+            [fileNames addObject:[firstImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i]]];
+        }
+        NSArray *sizes = [Renderer getImageSizes:fileNames];
+        height = [[sizes objectAtIndex:0] CGSizeValue].height;
         if (autoWidth) {
             width = 0;
         }
         
         for (int i = 1; i <= numberOfTiles; i++) {
-            widths[i - 1] = [Renderer getImageSize:[firstImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i]]].width;
+            widths[i - 1] = [[sizes objectAtIndex:i - 1] CGSizeValue].width;
             if (widths[i - 1] < minimumWidth) {
                 minimumWidth = widths[i - 1];
             }
@@ -231,25 +270,21 @@
             tile.bounds = CGRectMake(0, 0, widths[[[[positions objectAtIndex:i] objectAtIndex:1] intValue] - 1], height);
             tile.anchorPoint = CGPointZero;
             tile.position = CGPointMake([[[positions objectAtIndex:i] objectAtIndex:0] intValue], 0);
-            
-            //Currently load all of the necessary images. We'll have to change this if we
-            //run into memory issues.
-            tile.contents = (id)[Renderer cachedImage:[firstImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", [[[positions objectAtIndex:i] objectAtIndex:1] intValue]]]].CGImage;
             tile.opacity = 0;
             
             [background addSublayer:tile];
             [tileArray addObject:tile];
         }
         
+        //Currently load all of the necessary images. We'll have to change this if we
+        //run into memory issues.
+        [self loadTileImages:firstImageName];
         [self setOpacities];
         dataInitialised = YES;
     } else {
         //Every other time. Load the images for the new part.
         //(Don't make any changes to the dimensions of the tile set.)
-        for (int i = 0; i < [positions count]; i++) {
-            CALayer *currentTile = [tileArray objectAtIndex:i];
-            currentTile.contents = (id)[Renderer cachedImage:[firstImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", [[[positions objectAtIndex:i] objectAtIndex:1] intValue]]]].CGImage;
-        }
+        [self loadTileImages:firstImageName];
         
         //No need to call setOpacities here, as the tiles should already be correctly configured.
         //[self setOpacities];
@@ -316,12 +351,12 @@
         tile.bounds = CGRectMake(0, 0, widths[[[[positions objectAtIndex:i] objectAtIndex:1] intValue] - 1], originalSize.height);
         tile.anchorPoint = CGPointZero;
         tile.position = CGPointMake([[[positions objectAtIndex:i] objectAtIndex:0] intValue], 0);
-        tile.contents = (id)[Renderer cachedImage:[currentImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", [[[positions objectAtIndex:i] objectAtIndex:1] intValue]]]].CGImage;
         tile.opacity = 0;
         
         [background addSublayer:tile];
         [tileArray addObject:tile];
     }
+    [self loadTileImages:currentImageName];
     
     //Fix opacities and height.
     [self setOpacities];
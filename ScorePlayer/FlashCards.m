@@ -10,6 +10,7 @@
 #import "FlashCards.h"
 #import "Score.h"
 #import "OSCMessage.h"
+#import "ScoreArchive.h"
 
 @interface FlashCards ()
 
@@ -473,7 +474,7 @@
     detached = NO;
     
     //Load our preferences
-    NSData *prefsData = [[NSData alloc] initWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
+    NSData *prefsData = [ScoreArchive dataWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
     xmlParser = [[NSXMLParser alloc] initWithData:prefsData];
     
     isData = NO;
@@ -1007,10 +1008,9 @@
 - (void)parserDidEndDocument:(NSXMLParser *)parser
 {
     //Check that we have all of our necessary image files.
-    NSFileManager *fileManager = [NSFileManager defaultManager];
     for (int i = 2; i <= cards; i++) {
         NSString *fileName = [score.scorePath stringByAppendingPathComponent:[score.fileName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i]]];
-        if (![fileManager fileExistsAtPath:fileName]) {
+        if (![ScoreArchive fileExistsAtPath:fileName]) {
             badPrefs = YES;
             errorMessage = @"Missing images in score file.";
             i = (int)cards + 1;
@@ -1019,7 +1019,7 @@
         //Perform the same checks for parts.
         for (int j = 0; j < [score.parts count]; j++) {
             NSString *fileName = [score.scorePath stringByAppendingPathComponent:[[score.parts objectAtIndex:j] stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i]]];
-            if (![fileManager fileExistsAtPath:fileName]) {
+            if (![ScoreArchive fileExistsAtPath:fileName]) {
                 badPrefs = YES;
                 errorMessage = @"Missing images in score file.";
                 i = (int)cards + 1;
@@ -1032,7 +1032,7 @@
     if (!badPrefs && duoCards > 0) {
         for (int i = 1; i <= duoCards; i++) {
             NSString *fileName = [score.scorePath stringByAppendingPathComponent:[duoFileName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i]]];
-            if (![fileManager fileExistsAtPath:fileName]) {
+            if (![ScoreArchive fileExistsAtPath:fileName]) {
                 badPrefs = YES;
                 errorMessage = @"Missing images in score file.";
                 i = (int)duoCards + 1;
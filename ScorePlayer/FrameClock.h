@@ -0,0 +1,39 @@
+//
+//  FrameClock.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <QuartzCore/QuartzCore.h>
+
+//A single display synchronised clock shared by all of the animated renderers. Subscribers are
+//handed the time of the frame being drawn and should calculate their position from the time
+//elapsed since they started animating, rather than moving by a fixed amount each call. That
+//way a late or skipped frame never shifts the score permanently.
+
+@protocol FrameClockSubscriber <NSObject>
+
+- (void)animateToTime:(CFTimeInterval)frameTime;
+
+@end
+
+@interface FrameClock : NSObject
+
+//The amount of subscriber work allowed per frame. Once this is exceeded, any remaining
+//subscribers are updated first on the next frame instead.
+@property (nonatomic) CFTimeInterval frameBudget;
+@property (nonatomic, readonly) NSUInteger deferredFrames;
+@property (nonatomic, readonly) NSUInteger subscriberCount;
+
++ (FrameClock *)sharedClock;
+
+//The current time on the same time base as the frame times passed to subscribers.
+- (CFTimeInterval)currentTime;
+
+- (void)addSubscriber:(id<FrameClockSubscriber>)subscriber;
+- (void)removeSubscriber:(id<FrameClockSubscriber>)subscriber;
+
+@end
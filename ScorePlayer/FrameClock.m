@@ -0,0 +1,126 @@
+//
+//  FrameClock.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "FrameClock.h"
+
+@interface FrameClock ()
+
+- (void)displayLinkFired:(CADisplayLink *)link;
+
+@end
+
+@implementation FrameClock {
+    CADisplayLink *displayLink;
+    NSMutableArray *subscribers;
+    NSUInteger nextSubscriber;
+}
+
+@synthesize frameBudget, deferredFrames;
+
++ (FrameClock *)sharedClock
+{
+    static FrameClock *sharedClock = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        sharedClock = [[self alloc] init];
+    });
+    
+    return sharedClock;
+}
+
+- (id)init
+{
+    self = [super init];
+    subscribers = [[NSMutableArray alloc] init];
+    nextSubscriber = 0;
+    deferredFrames = 0;
+    //Leave the rest of a 60Hz frame for Core Animation and everything else on the main thread.
+    frameBudget = 0.008;
+    return self;
+}
+
+- (NSUInteger)subscriberCount
+{
+    return [subscribers count];
+}
+
+- (CFTimeInterval)currentTime
+{
+    return CACurrentMediaTime();
+}
+
+- (void)addSubscriber:(id<FrameClockSubscriber>)subscriber
+{
+    if ([subscribers indexOfObjectIdenticalTo:subscriber] != NSNotFound) {
+        return;
+    }
+    [subscribers addObject:subscriber];
+    
+    if (displayLink == nil) {
+        displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkFired:)];
+        [displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    }
+    displayLink.paused = NO;
+}
+
+- (void)removeSubscriber:(id<FrameClockSubscriber>)subscriber
+{
+    NSUInteger index = [subscribers indexOfObjectIdenticalTo:subscriber];
+    if (index == NSNotFound) {
+        return;
+    }
+    [subscribers removeObjectAtIndex:index];
+    if (index < nextSubscriber) {
+        nextSubscriber--;
+    }
+    
+    //Don't keep waking up for frames that nobody needs.
+    if ([subscribers count] == 0) {
+        displayLink.paused = YES;
+        nextSubscriber = 0;
+    }
+}
+
+#pragma mark - Private methods
+
+- (void)displayLinkFired:(CADisplayLink *)link
+{
+    //Subscribers are free to add or remove themselves (or each other) while being updated,
+    //so work from a snapshot and check that each one is still subscribed before calling it.
+    NSArray *current = [subscribers copy];
+    NSUInteger count = [current count];
+    if (count == 0) {
+        return;
+    }
+    
+    //Aim for the frame that's about to be displayed rather than the one that just was.
+    CFTimeInterval frameTime = link.targetTimestamp;
+    CFTimeInterval startTime = CACurrentMediaTime();
+    NSUInteger start = nextSubscriber < count ? nextSubscriber : 0;
+    nextSubscriber = 0;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        id<FrameClockSubscriber> subscriber = [current objectAtIndex:(start + i) % count];
+        if ([subscribers indexOfObjectIdenticalTo:subscriber] == NSNotFound) {
+            continue;
+        }
+        [subscriber animateToTime:frameTime];
+        
+        //If we've used up our budget, start with whoever missed out next time. Their positions
+        //are worked out from the frame time, so they'll simply catch up.
+        if (i + 1 < count && CACurrentMediaTime() - startTime > frameBudget) {
+            NSUInteger deferred = [subscribers indexOfObjectIdenticalTo:[current objectAtIndex:(start + i + 1) % count]];
+            nextSubscriber = deferred == NSNotFound ? 0 : deferred;
+            deferredFrames++;
+            break;
+        }
+    }
+}
+
+@end
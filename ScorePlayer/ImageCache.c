@@ -0,0 +1,566 @@
+//
+//  ImageCache.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ImageCache.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_BUCKETS 64
+
+typedef struct CacheDirectory CacheDirectory;
+
+typedef struct CacheEntry {
+    char *key;
+    size_t keyLength;
+    uint32_t hash;
+    void *value;
+    size_t cost;
+    unsigned int pinCount;
+
+    struct CacheEntry *hashNext;
+    //Unpinned entries are kept in order of use, most recent first.
+    struct CacheEntry *lruPrevious;
+    struct CacheEntry *lruNext;
+    //The other entries in the same directory.
+    CacheDirectory *directory;
+    struct CacheEntry *directoryPrevious;
+    struct CacheEntry *directoryNext;
+} CacheEntry;
+
+struct CacheDirectory {
+    char *path;
+    size_t pathLength;
+    uint32_t hash;
+
+    CacheDirectory *hashNext;
+    CacheDirectory *parent;
+    CacheDirectory *firstChild;
+    CacheDirectory *previousSibling;
+    CacheDirectory *nextSibling;
+    CacheEntry *firstEntry;
+};
+
+typedef struct {
+    void **buckets;
+    size_t bucketCount;
+    size_t count;
+} HashTable;
+
+struct ImageCache {
+    HashTable entries;
+    HashTable directories;
+    CacheEntry *lruHead;
+    CacheEntry *lruTail;
+
+    ImageCacheReleaseCallback release;
+    void *userData;
+    ImageCacheStatistics statistics;
+};
+
+#pragma mark - Hashing
+
+static uint32_t hashString(const char *string, size_t length)
+{
+    //FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)string[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool tableInit(HashTable *table)
+{
+    table->buckets = calloc(INITIAL_BUCKETS, sizeof(void *));
+    table->bucketCount = INITIAL_BUCKETS;
+    table->count = 0;
+    return table->buckets != NULL;
+}
+
+static CacheEntry **entryBucket(ImageCache *cache, uint32_t hash)
+{
+    return (CacheEntry **)&cache->entries.buckets[hash & (cache->entries.bucketCount - 1)];
+}
+
+static CacheDirectory **directoryBucket(ImageCache *cache, uint32_t hash)
+{
+    return (CacheDirectory **)&cache->directories.buckets[hash & (cache->directories.bucketCount - 1)];
+}
+
+static void growEntries(ImageCache *cache)
+{
+    size_t newCount = cache->entries.bucketCount * 2;
+    void **newBuckets = calloc(newCount, sizeof(void *));
+    if (newBuckets == NULL) {
+        //We'll just have longer chains.
+        return;
+    }
+    for (size_t i = 0; i < cache->entries.bucketCount; i++) {
+        CacheEntry *entry = cache->entries.buckets[i];
+        while (entry != NULL) {
+            CacheEntry *next = entry->hashNext;
+            entry->hashNext = newBuckets[entry->hash & (newCount - 1)];
+            newBuckets[entry->hash & (newCount - 1)] = entry;
+            entry = next;
+        }
+    }
+    free(cache->entries.buckets);
+    cache->entries.buckets = newBuckets;
+    cache->entries.bucketCount = newCount;
+}
+
+static void growDirectories(ImageCache *cache)
+{
+    size_t newCount = cache->directories.bucketCount * 2;
+    void **newBuckets = calloc(newCount, sizeof(void *));
+    if (newBuckets == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < cache->directories.bucketCount; i++) {
+        CacheDirectory *directory = cache->directories.buckets[i];
+        while (directory != NULL) {
+            CacheDirectory *next = directory->hashNext;
+            directory->hashNext = newBuckets[directory->hash & (newCount - 1)];
+            newBuckets[directory->hash & (newCount - 1)] = directory;
+            directory = next;
+        }
+    }
+    free(cache->directories.buckets);
+    cache->directories.buckets = newBuckets;
+    cache->directories.bucketCount = newCount;
+}
+
+#pragma mark - Directories
+
+//Trailing slashes are ignored, except for the root directory itself.
+static size_t directoryLength(const char *path, size_t length)
+{
+    while (length > 1 && path[length - 1] == '/') {
+        length--;
+    }
+    return length;
+}
+
+//Returns the length of the parent directory's path, or -1 if there isn't one.
+static long parentLength(const char *path, size_t length)
+{
+    if (length == 0 || (length == 1 && path[0] == '/')) {
+        return -1;
+    }
+    const char *slash = NULL;
+    for (size_t i = length; i > 0; i--) {
+        if (path[i - 1] == '/') {
+            slash = path + i - 1;
+            break;
+        }
+    }
+    if (slash == NULL) {
+        //A relative path with no directory component.
+        return 0;
+    }
+    if (slash == path) {
+        return 1;
+    }
+    return directoryLength(path, slash - path);
+}
+
+static CacheDirectory *findDirectory(ImageCache *cache, const char *path, size_t length)
+{
+    uint32_t hash = hashString(path, length);
+    CacheDirectory *directory = *directoryBucket(cache, hash);
+    while (directory != NULL) {
+        if (directory->hash == hash && directory->pathLength == length && memcmp(directory->path, path, length) == 0) {
+            return directory;
+        }
+        directory = directory->hashNext;
+    }
+    return NULL;
+}
+
+static CacheDirectory *getDirectory(ImageCache *cache, const char *path, size_t length)
+{
+    CacheDirectory *directory = findDirectory(cache, path, length);
+    if (directory != NULL) {
+        return directory;
+    }
+
+    CacheDirectory *parent = NULL;
+    long parentPathLength = parentLength(path, length);
+    if (parentPathLength >= 0) {
+        parent = getDirectory(cache, path, parentPathLength);
+        if (parent == NULL) {
+            return NULL;
+        }
+    }
+
+    directory = calloc(1, sizeof(CacheDirectory));
+    if (directory == NULL) {
+        return NULL;
+    }
+    directory->path = malloc(length + 1);
+    if (directory->path == NULL) {
+        free(directory);
+        return NULL;
+    }
+    memcpy(directory->path, path, length);
+    directory->path[length] = 0;
+    directory->pathLength = length;
+    directory->hash = hashString(path, length);
+
+    directory->parent = parent;
+    if (parent != NULL) {
+        directory->nextSibling = parent->firstChild;
+        if (directory->nextSibling != NULL) {
+            directory->nextSibling->previousSibling = directory;
+        }
+        parent->firstChild = directory;
+    }
+
+    CacheDirectory **bucket = directoryBucket(cache, directory->hash);
+    directory->hashNext = *bucket;
+    *bucket = directory;
+    cache->directories.count++;
+    if (cache->directories.count > cache->directories.bucketCount) {
+        growDirectories(cache);
+    }
+    return directory;
+}
+
+static void freeDirectory(ImageCache *cache, CacheDirectory *directory)
+{
+    CacheDirectory **link = directoryBucket(cache, directory->hash);
+    while (*link != directory) {
+        link = &(*link)->hashNext;
+    }
+    *link = directory->hashNext;
+    cache->directories.count--;
+
+    if (directory->previousSibling != NULL) {
+        directory->previousSibling->nextSibling = directory->nextSibling;
+    } else if (directory->parent != NULL) {
+        directory->parent->firstChild = directory->nextSibling;
+    }
+    if (directory->nextSibling != NULL) {
+        directory->nextSibling->previousSibling = directory->previousSibling;
+    }
+
+    free(directory->path);
+    free(directory);
+}
+
+//Frees empty directories, working up the tree.
+static void pruneDirectory(ImageCache *cache, CacheDirectory *directory)
+{
+    while (directory != NULL && directory->firstEntry == NULL && directory->firstChild == NULL) {
+        CacheDirectory *parent = directory->parent;
+        freeDirectory(cache, directory);
+        directory = parent;
+    }
+}
+
+#pragma mark - Entries
+
+static void lruUnlink(ImageCache *cache, CacheEntry *entry)
+{
+    if (entry->lruPrevious != NULL) {
+        entry->lruPrevious->lruNext = entry->lruNext;
+    } else {
+        cache->lruHead = entry->lruNext;
+    }
+    if (entry->lruNext != NULL) {
+        entry->lruNext->lruPrevious = entry->lruPrevious;
+    } else {
+        cache->lruTail = entry->lruPrevious;
+    }
+    entry->lruPrevious = NULL;
+    entry->lruNext = NULL;
+}
+
+static void lruPushFront(ImageCache *cache, CacheEntry *entry)
+{
+    entry->lruPrevious = NULL;
+    entry->lruNext = cache->lruHead;
+    if (cache->lruHead != NULL) {
+        cache->lruHead->lruPrevious = entry;
+    } else {
+        cache->lruTail = entry;
+    }
+    cache->lruHead = entry;
+}
+
+static CacheEntry *findEntry(ImageCache *cache, const char *key, size_t length, uint32_t hash)
+{
+    CacheEntry *entry = *entryBucket(cache, hash);
+    while (entry != NULL) {
+        if (entry->hash == hash && entry->keyLength == length && memcmp(entry->key, key, length) == 0) {
+            return entry;
+        }
+        entry = entry->hashNext;
+    }
+    return NULL;
+}
+
+static void removeEntry(ImageCache *cache, CacheEntry *entry, bool prune)
+{
+    CacheEntry **link = entryBucket(cache, entry->hash);
+    while (*link != entry) {
+        link = &(*link)->hashNext;
+    }
+    *link = entry->hashNext;
+    cache->entries.count--;
+
+    if (entry->pinCount == 0) {
+        lruUnlink(cache, entry);
+    } else {
+        cache->statistics.pinnedBytes -= entry->cost;
+    }
+
+    CacheDirectory *directory = entry->directory;
+    if (entry->directoryPrevious != NULL) {
+        entry->directoryPrevious->directoryNext = entry->directoryNext;
+    } else {
+        directory->firstEntry = entry->directoryNext;
+    }
+    if (entry->directoryNext != NULL) {
+        entry->directoryNext->directoryPrevious = entry->directoryPrevious;
+    }
+    if (prune) {
+        pruneDirectory(cache, directory);
+    }
+
+    cache->statistics.bytesUsed -= entry->cost;
+    cache->statistics.entryCount--;
+    if (cache->release != NULL) {
+        cache->release(entry->value, cache->userData);
+    }
+    free(entry->key);
+    free(entry);
+}
+
+static void evict(ImageCache *cache)
+{
+    while (cache->statistics.bytesUsed > cache->statistics.byteBudget && cache->lruTail != NULL) {
+        removeEntry(cache, cache->lruTail, true);
+        cache->statistics.evictions++;
+    }
+}
+
+//Removes a directory, everything in it, and all of its subdirectories.
+static size_t removeSubtree(ImageCache *cache, CacheDirectory *directory)
+{
+    size_t removed = 0;
+    while (directory->firstChild != NULL) {
+        removed += removeSubtree(cache, directory->firstChild);
+    }
+    while (directory->firstEntry != NULL) {
+        removeEntry(cache, directory->firstEntry, false);
+        removed++;
+    }
+    freeDirectory(cache, directory);
+    return removed;
+}
+
+#pragma mark - Public functions
+
+ImageCache *ImageCacheCreate(size_t byteBudget, ImageCacheReleaseCallback release, void *userData)
+{
+    ImageCache *cache = calloc(1, sizeof(ImageCache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    if (!tableInit(&cache->entries) || !tableInit(&cache->directories)) {
+        free(cache->entries.buckets);
+        free(cache->directories.buckets);
+        free(cache);
+        return NULL;
+    }
+    cache->release = release;
+    cache->userData = userData;
+    cache->statistics.byteBudget = byteBudget;
+    return cache;
+}
+
+void ImageCacheDestroy(ImageCache *cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+    ImageCacheRemoveAll(cache);
+    free(cache->entries.buckets);
+    free(cache->directories.buckets);
+    free(cache);
+}
+
+void *ImageCacheGet(ImageCache *cache, const char *key)
+{
+    size_t length = strlen(key);
+    CacheEntry *entry = findEntry(cache, key, length, hashString(key, length));
+    if (entry == NULL) {
+        cache->statistics.misses++;
+        return NULL;
+    }
+    cache->statistics.hits++;
+    if (entry->pinCount == 0 && entry != cache->lruHead) {
+        lruUnlink(cache, entry);
+        lruPushFront(cache, entry);
+    }
+    return entry->value;
+}
+
+bool ImageCacheInsert(ImageCache *cache, const char *key, void *value, size_t cost)
+{
+    size_t length = strlen(key);
+    uint32_t hash = hashString(key, length);
+    CacheEntry *existing = findEntry(cache, key, length, hash);
+    unsigned int pinCount = 0;
+    if (existing != NULL) {
+        //Carry any pins across to the new value.
+        pinCount = existing->pinCount;
+        removeEntry(cache, existing, true);
+    }
+
+    if (cost > cache->statistics.byteBudget && pinCount == 0) {
+        if (cache->release != NULL) {
+            cache->release(value, cache->userData);
+        }
+        return false;
+    }
+
+    CacheEntry *entry = calloc(1, sizeof(CacheEntry));
+    long directoryPathLength = parentLength(key, length);
+    CacheDirectory *directory = NULL;
+    if (entry != NULL) {
+        entry->key = malloc(length + 1);
+        directory = getDirectory(cache, key, directoryPathLength < 0 ? 0 : directoryPathLength);
+    }
+    if (entry == NULL || entry->key == NULL || directory == NULL) {
+        if (entry != NULL) {
+            free(entry->key);
+            free(entry);
+        }
+        if (directory != NULL) {
+            pruneDirectory(cache, directory);
+        }
+        if (cache->release != NULL) {
+            cache->release(value, cache->userData);
+        }
+        return false;
+    }
+
+    memcpy(entry->key, key, length);
+    entry->key[length] = 0;
+    entry->keyLength = length;
+    entry->hash = hash;
+    entry->value = value;
+    entry->cost = cost;
+    entry->pinCount = pinCount;
+
+    CacheEntry **bucket = entryBucket(cache, hash);
+    entry->hashNext = *bucket;
+    *bucket = entry;
+    cache->entries.count++;
+    if (cache->entries.count > cache->entries.bucketCount) {
+        growEntries(cache);
+    }
+
+    entry->directory = directory;
+    entry->directoryNext = directory->firstEntry;
+    if (entry->directoryNext != NULL) {
+        entry->directoryNext->directoryPrevious = entry;
+    }
+    directory->firstEntry = entry;
+
+    if (pinCount == 0) {
+        lruPushFront(cache, entry);
+    } else {
+        cache->statistics.pinnedBytes += cost;
+    }
+    cache->statistics.bytesUsed += cost;
+    cache->statistics.entryCount++;
+
+    evict(cache);
+    return true;
+}
+
+void ImageCacheRemove(ImageCache *cache, const char *key)
+{
+    size_t length = strlen(key);
+    CacheEntry *entry = findEntry(cache, key, length, hashString(key, length));
+    if (entry != NULL) {
+        removeEntry(cache, entry, true);
+    }
+}
+
+size_t ImageCacheRemoveDirectory(ImageCache *cache, const char *path)
+{
+    CacheDirectory *directory = findDirectory(cache, path, directoryLength(path, strlen(path)));
+    if (directory == NULL) {
+        return 0;
+    }
+    CacheDirectory *parent = directory->parent;
+    size_t removed = removeSubtree(cache, directory);
+    pruneDirectory(cache, parent);
+    return removed;
+}
+
+void ImageCacheRemoveAll(ImageCache *cache)
+{
+    for (size_t i = 0; i < cache->directories.bucketCount; i++) {
+        while (cache->directories.buckets[i] != NULL) {
+            //Start from the top of whichever tree this directory is in.
+            CacheDirectory *directory = cache->directories.buckets[i];
+            while (directory->parent != NULL) {
+                directory = directory->parent;
+            }
+            removeSubtree(cache, directory);
+        }
+    }
+}
+
+bool ImageCachePin(ImageCache *cache, const char *key)
+{
+    size_t length = strlen(key);
+    CacheEntry *entry = findEntry(cache, key, length, hashString(key, length));
+    if (entry == NULL) {
+        return false;
+    }
+    if (entry->pinCount == 0) {
+        lruUnlink(cache, entry);
+        cache->statistics.pinnedBytes += entry->cost;
+    }
+    entry->pinCount++;
+    return true;
+}
+
+void ImageCacheUnpin(ImageCache *cache, const char *key)
+{
+    size_t length = strlen(key);
+    CacheEntry *entry = findEntry(cache, key, length, hashString(key, length));
+    if (entry == NULL || entry->pinCount == 0) {
+        return;
+    }
+    entry->pinCount--;
+    if (entry->pinCount == 0) {
+        cache->statistics.pinnedBytes -= entry->cost;
+        lruPushFront(cache, entry);
+        evict(cache);
+    }
+}
+
+void ImageCacheSetByteBudget(ImageCache *cache, size_t byteBudget)
+{
+    cache->statistics.byteBudget = byteBudget;
+    evict(cache);
+}
+
+ImageCacheStatistics ImageCacheGetStatistics(const ImageCache *cache)
+{
+    return cache->statistics;
+}
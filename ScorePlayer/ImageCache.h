@@ -0,0 +1,61 @@
+//
+//  ImageCache.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//A least recently used cache with a byte budget, for images keyed by file path. Values are
+//opaque to the cache: it takes ownership of each value on insertion and hands it back to the
+//release callback once it has been evicted or removed. Entries are also indexed by directory,
+//so that removing a directory costs time proportional to what is removed.
+//The cache is not thread safe. Callers need to provide their own locking.
+
+#ifndef ImageCache_h
+#define ImageCache_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct ImageCache ImageCache;
+
+typedef void (*ImageCacheReleaseCallback)(void *value, void *userData);
+
+typedef struct {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t entryCount;
+    size_t bytesUsed;
+    size_t pinnedBytes;
+    size_t byteBudget;
+} ImageCacheStatistics;
+
+ImageCache *ImageCacheCreate(size_t byteBudget, ImageCacheReleaseCallback release, void *userData);
+void ImageCacheDestroy(ImageCache *cache);
+
+//Returns NULL (and counts a miss) if the key isn't cached. A hit makes the entry the most
+//recently used.
+void *ImageCacheGet(ImageCache *cache, const char *key);
+
+//Replaces any existing value for the key, then evicts least recently used entries until the
+//cache is back within its budget. A value that is larger than the whole budget isn't kept,
+//and is released straight away. Returns false in that case (or if we're out of memory).
+bool ImageCacheInsert(ImageCache *cache, const char *key, void *value, size_t cost);
+void ImageCacheRemove(ImageCache *cache, const char *key);
+
+//Removes every entry in the given directory and any of its subdirectories, and returns
+//the number of entries removed.
+size_t ImageCacheRemoveDirectory(ImageCache *cache, const char *path);
+void ImageCacheRemoveAll(ImageCache *cache);
+
+//Pinned entries are never evicted (although they still count towards the budget). Pins
+//are counted, so each pin needs a matching unpin. Returns false if the key isn't cached.
+bool ImageCachePin(ImageCache *cache, const char *key);
+void ImageCacheUnpin(ImageCache *cache, const char *key);
+
+void ImageCacheSetByteBudget(ImageCache *cache, size_t byteBudget);
+ImageCacheStatistics ImageCacheGetStatistics(const ImageCache *cache);
+
+#endif /* ImageCache_h */
@@ -0,0 +1,85 @@
+//
+//  ImageDownscale.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ImageDownscale.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGE_DOWNSCALE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGE_DOWNSCALE_SSE2 1
+#endif
+
+size_t ImageDownscaleHalfSize(size_t size)
+{
+    return (size + 1) / 2;
+}
+
+//Averages pairs of pixels across two rows. Every channel is rounded to nearest, so the
+//vector paths and the scalar path give identical results.
+static void halveRow(const uint8_t *row0, const uint8_t *row1, size_t width, uint8_t *destination)
+{
+    size_t evenWidth = width & ~(size_t)1;
+    size_t x = 0;
+
+#if IMAGE_DOWNSCALE_NEON
+    //Sixteen source pixels at a time, split out by channel so that neighbouring pixels
+    //can be added pairwise.
+    for (; x + 16 <= evenWidth; x += 16) {
+        uint8x16x4_t top = vld4q_u8(row0 + x * IMAGE_DOWNSCALE_BYTES_PER_PIXEL);
+        uint8x16x4_t bottom = vld4q_u8(row1 + x * IMAGE_DOWNSCALE_BYTES_PER_PIXEL);
+        uint8x8x4_t result;
+        for (int channel = 0; channel < IMAGE_DOWNSCALE_BYTES_PER_PIXEL; channel++) {
+            uint16x8_t sum = vpaddlq_u8(top.val[channel]);
+            sum = vpadalq_u8(sum, bottom.val[channel]);
+            result.val[channel] = vrshrn_n_u16(sum, 2);
+        }
+        vst4_u8(destination + (x / 2) * IMAGE_DOWNSCALE_BYTES_PER_PIXEL, result);
+    }
+#elif IMAGE_DOWNSCALE_SSE2
+    //Four source pixels at a time. Widen to 16 bits, add the rows, then add the two pixels
+    //in each half of the register.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    for (; x + 4 <= evenWidth; x += 4) {
+        __m128i top = _mm_loadu_si128((const __m128i *)(row0 + x * IMAGE_DOWNSCALE_BYTES_PER_PIXEL));
+        __m128i bottom = _mm_loadu_si128((const __m128i *)(row1 + x * IMAGE_DOWNSCALE_BYTES_PER_PIXEL));
+        __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+        __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+        low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+        high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+        __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(low, high), two), 2);
+        _mm_storel_epi64((__m128i *)(destination + (x / 2) * IMAGE_DOWNSCALE_BYTES_PER_PIXEL), _mm_packus_epi16(sum, sum));
+    }
+#endif
+
+    for (; x < width; x += 2) {
+        //The last column of an odd width image is averaged with itself.
+        size_t next = (x + 1 < width) ? x + 1 : x;
+        const uint8_t *a = row0 + x * IMAGE_DOWNSCALE_BYTES_PER_PIXEL;
+        const uint8_t *b = row0 + next * IMAGE_DOWNSCALE_BYTES_PER_PIXEL;
+        const uint8_t *c = row1 + x * IMAGE_DOWNSCALE_BYTES_PER_PIXEL;
+        const uint8_t *d = row1 + next * IMAGE_DOWNSCALE_BYTES_PER_PIXEL;
+        uint8_t *out = destination + (x / 2) * IMAGE_DOWNSCALE_BYTES_PER_PIXEL;
+        for (int channel = 0; channel < IMAGE_DOWNSCALE_BYTES_PER_PIXEL; channel++) {
+            out[channel] = (uint8_t)((a[channel] + b[channel] + c[channel] + d[channel] + 2) >> 2);
+        }
+    }
+}
+
+void ImageDownscaleHalve(const uint8_t *source, size_t width, size_t height, size_t sourceRowBytes, uint8_t *destination, size_t destinationRowBytes)
+{
+    size_t halfHeight = ImageDownscaleHalfSize(height);
+    for (size_t y = 0; y < halfHeight; y++) {
+        const uint8_t *row0 = source + (2 * y) * sourceRowBytes;
+        //The last row of an odd height image is averaged with itself.
+        const uint8_t *row1 = (2 * y + 1 < height) ? row0 + sourceRowBytes : row0;
+        halveRow(row0, row1, width, destination + y * destinationRowBytes);
+    }
+}
@@ -0,0 +1,29 @@
+//
+//  ImageDownscale.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Halves the size of an image by averaging each 2x2 block of pixels. Pixels are four 8 bit
+//channels in any order (the channels are treated independently), so both premultiplied RGBA
+//and BGRA bitmaps work. Uses NEON or SSE2 where they're available.
+
+#ifndef ImageDownscale_h
+#define ImageDownscale_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define IMAGE_DOWNSCALE_BYTES_PER_PIXEL 4
+
+//The size of one dimension after halving. (Odd sizes round up, with the last row or column
+//averaged with itself.)
+size_t ImageDownscaleHalfSize(size_t size);
+
+//The destination must have room for ImageDownscaleHalfSize(width) by ImageDownscaleHalfSize(height)
+//pixels, and must not overlap the source.
+void ImageDownscaleHalve(const uint8_t *source, size_t width, size_t height, size_t sourceRowBytes, uint8_t *destination, size_t destinationRowBytes);
+
+#endif /* ImageDownscale_h */
@@ -0,0 +1,234 @@
+//
+//  ImageHeader.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ImageHeader.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//How much of a file is read at a time. This covers the whole header of a PNG and of most JPEGs
+//in one read. (Big EXIF segments are jumped over with another read past them.)
+#define IMAGE_HEADER_WINDOW 4096
+
+static const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+typedef struct {
+    //Set when reading from memory.
+    const uint8_t *bytes;
+    size_t length;
+    //Otherwise the file is read through a window.
+    int fd;
+    uint8_t window[IMAGE_HEADER_WINDOW];
+    uint64_t windowOffset;
+    size_t windowLength;
+} HeaderSource;
+
+static const uint8_t *sourceBytes(HeaderSource *source, uint64_t offset, size_t count);
+static ImageHeaderResult readPNG(HeaderSource *source, ImageHeaderSize *size);
+static ImageHeaderResult readJPEG(HeaderSource *source, ImageHeaderSize *size);
+static ImageHeaderResult readHeader(HeaderSource *source, ImageHeaderSize *size);
+static void versionFromStat(const struct stat *fileStat, ImageHeaderVersion *version);
+
+static inline uint32_t readUInt16(const uint8_t *bytes)
+{
+    return ((uint32_t)bytes[0] << 8) | bytes[1];
+}
+
+static inline uint32_t readUInt32(const uint8_t *bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+#pragma mark - Public functions
+
+ImageHeaderResult ImageHeaderRead(const uint8_t *bytes, size_t length, ImageHeaderSize *size)
+{
+    HeaderSource source;
+    source.bytes = bytes;
+    source.length = length;
+    source.fd = -1;
+    source.windowOffset = 0;
+    source.windowLength = 0;
+    return readHeader(&source, size);
+}
+
+ImageHeaderResult ImageHeaderReadFile(const char *path, ImageHeaderSize *size, ImageHeaderVersion *version)
+{
+    HeaderSource source;
+    source.bytes = NULL;
+    source.length = 0;
+    source.fd = open(path, O_RDONLY);
+    source.windowOffset = 0;
+    source.windowLength = 0;
+    if (source.fd < 0) {
+        return ImageHeaderUnrecognised;
+    }
+
+    struct stat fileStat;
+    if (version != NULL) {
+        if (fstat(source.fd, &fileStat) != 0) {
+            close(source.fd);
+            return ImageHeaderUnrecognised;
+        }
+        versionFromStat(&fileStat, version);
+    }
+
+    ImageHeaderResult result = readHeader(&source, size);
+    close(source.fd);
+    //There's no more to come, so a file that ends early is a damaged one.
+    return result == ImageHeaderTruncated ? ImageHeaderUnrecognised : result;
+}
+
+bool ImageHeaderReadVersion(const char *path, ImageHeaderVersion *version)
+{
+    struct stat fileStat;
+    if (stat(path, &fileStat) != 0) {
+        return false;
+    }
+    versionFromStat(&fileStat, version);
+    return true;
+}
+
+#pragma mark - Private functions
+
+static const uint8_t *sourceBytes(HeaderSource *source, uint64_t offset, size_t count)
+{
+    //Returns NULL if the input ends before count bytes from the offset.
+    if (source->bytes != NULL) {
+        if (offset > source->length || count > source->length - offset) {
+            return NULL;
+        }
+        return source->bytes + offset;
+    }
+
+    if (offset < source->windowOffset || offset + count > source->windowOffset + source->windowLength) {
+        ssize_t bytesRead = pread(source->fd, source->window, IMAGE_HEADER_WINDOW, (off_t)offset);
+        source->windowOffset = offset;
+        source->windowLength = bytesRead > 0 ? (size_t)bytesRead : 0;
+        if (count > source->windowLength) {
+            return NULL;
+        }
+    }
+    return source->window + (offset - source->windowOffset);
+}
+
+static ImageHeaderResult readHeader(HeaderSource *source, ImageHeaderSize *size)
+{
+    const uint8_t *bytes = sourceBytes(source, 0, 2);
+    if (bytes == NULL) {
+        return ImageHeaderTruncated;
+    }
+    if (bytes[0] == PNG_SIGNATURE[0]) {
+        return readPNG(source, size);
+    } else if (bytes[0] == 0xff && bytes[1] == 0xd8) {
+        return readJPEG(source, size);
+    }
+    return ImageHeaderUnrecognised;
+}
+
+static ImageHeaderResult readPNG(HeaderSource *source, ImageHeaderSize *size)
+{
+    const uint8_t *bytes = sourceBytes(source, 0, 16);
+    if (bytes == NULL) {
+        return ImageHeaderTruncated;
+    }
+    if (memcmp(bytes, PNG_SIGNATURE, 8) != 0) {
+        return ImageHeaderUnrecognised;
+    }
+
+    //Xcode's PNG optimisation puts a CgBI chunk in front of the IHDR of images in the app bundle.
+    uint64_t offset = 8;
+    if (memcmp(bytes + 12, "CgBI", 4) == 0) {
+        offset += 12 + (uint64_t)readUInt32(bytes + 8);
+    }
+
+    bytes = sourceBytes(source, offset, 16);
+    if (bytes == NULL) {
+        return ImageHeaderTruncated;
+    }
+    if (memcmp(bytes + 4, "IHDR", 4) != 0) {
+        return ImageHeaderUnrecognised;
+    }
+    bytes = sourceBytes(source, offset + 8, 8);
+    if (bytes == NULL) {
+        return ImageHeaderTruncated;
+    }
+    size->width = readUInt32(bytes);
+    size->height = readUInt32(bytes + 4);
+    return size->width > 0 && size->height > 0 ? ImageHeaderFound : ImageHeaderUnrecognised;
+}
+
+static ImageHeaderResult readJPEG(HeaderSource *source, ImageHeaderSize *size)
+{
+    uint64_t offset = 2;
+    while (true) {
+        const uint8_t *bytes = sourceBytes(source, offset, 1);
+        if (bytes == NULL) {
+            return ImageHeaderTruncated;
+        }
+        if (bytes[0] != 0xff) {
+            return ImageHeaderUnrecognised;
+        }
+        //Any number of fill bytes can come before the marker itself.
+        while (bytes[0] == 0xff) {
+            offset++;
+            bytes = sourceBytes(source, offset, 1);
+            if (bytes == NULL) {
+                return ImageHeaderTruncated;
+            }
+        }
+        uint8_t marker = bytes[0];
+        offset++;
+
+        if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7)) {
+            //These stand alone, without a length.
+            continue;
+        } else if (marker == 0xd9 || marker == 0xda) {
+            //The image (or its scan data) started without a frame header.
+            return ImageHeaderUnrecognised;
+        }
+
+        bytes = sourceBytes(source, offset, 2);
+        if (bytes == NULL) {
+            return ImageHeaderTruncated;
+        }
+        uint32_t segmentLength = readUInt16(bytes);
+        if (segmentLength < 2) {
+            return ImageHeaderUnrecognised;
+        }
+
+        //Start of frame markers, leaving out DHT (c4), JPG (c8) and DAC (cc), which share the range.
+        if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+            if (segmentLength < 7) {
+                return ImageHeaderUnrecognised;
+            }
+            bytes = sourceBytes(source, offset + 2, 5);
+            if (bytes == NULL) {
+                return ImageHeaderTruncated;
+            }
+            size->height = readUInt16(bytes + 1);
+            size->width = readUInt16(bytes + 3);
+            //A height of zero means it's given after the first scan, which we don't go looking for.
+            return size->width > 0 && size->height > 0 ? ImageHeaderFound : ImageHeaderUnrecognised;
+        }
+        offset += segmentLength;
+    }
+}
+
+static void versionFromStat(const struct stat *fileStat, ImageHeaderVersion *version)
+{
+    version->size = (uint64_t)fileStat->st_size;
+#ifdef __APPLE__
+    version->modifiedSeconds = fileStat->st_mtimespec.tv_sec;
+    version->modifiedNanoseconds = fileStat->st_mtimespec.tv_nsec;
+#else
+    version->modifiedSeconds = fileStat->st_mtim.tv_sec;
+    version->modifiedNanoseconds = fileStat->st_mtim.tv_nsec;
+#endif
+}
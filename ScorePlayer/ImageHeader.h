@@ -0,0 +1,49 @@
+//
+//  ImageHeader.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Reads the pixel dimensions of a PNG or JPEG file from its header, without going through
+//Image I/O. A PNG only needs its first few dozen bytes. A JPEG is walked marker by marker until
+//its frame header turns up, skipping over the contents of everything before it (such as EXIF
+//data and embedded thumbnails) rather than reading them.
+
+#ifndef ImageHeader_h
+#define ImageHeader_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    ImageHeaderFound,
+    //The bytes given end before the dimensions do.
+    ImageHeaderTruncated,
+    //Not a PNG or JPEG, or a damaged one.
+    ImageHeaderUnrecognised
+} ImageHeaderResult;
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+} ImageHeaderSize;
+
+//Identifies the version of a file, so that anything worked out from it can be checked later.
+typedef struct {
+    uint64_t size;
+    int64_t modifiedSeconds;
+    int64_t modifiedNanoseconds;
+} ImageHeaderVersion;
+
+ImageHeaderResult ImageHeaderRead(const uint8_t *bytes, size_t length, ImageHeaderSize *size);
+//Also fills in the version of the file if version isn't NULL. It's read from the same open
+//file, so it can't belong to a later version than the dimensions. Returns
+//ImageHeaderUnrecognised if the file can't be opened.
+ImageHeaderResult ImageHeaderReadFile(const char *path, ImageHeaderSize *size, ImageHeaderVersion *version);
+//Returns false if the file doesn't exist.
+bool ImageHeaderReadVersion(const char *path, ImageHeaderVersion *version);
+
+#endif /* ImageHeader_h */
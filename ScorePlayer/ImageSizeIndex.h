@@ -0,0 +1,31 @@
+//
+//  ImageSizeIndex.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+//Remembers the dimensions of the image files that have been asked about, in an index in the
+//caches directory, along with the size and modification time of each file. A file is only read
+//again once it has changed. Dimensions are read from the PNG or JPEG header (see ImageHeader.h)
+//where possible, and through Image I/O otherwise.
+//Compiled scores (see CompiledScore.h) have the dimensions of their images built in, so this is
+//mostly for the scores that are bundled with the app and ones that haven't been compiled yet.
+
+@interface ImageSizeIndex : NSObject
+
+//Returns the dimensions of each of the given image files, as NSValues holding CGSizes, in the
+//same order. Files that can't be read have a zero size. Any files that aren't in the index (or
+//have changed) are read in parallel.
++ (NSArray *)sizesOfImageFiles:(NSArray *)fileNames;
+//Reads the dimensions from the file itself, without using or updating the index.
++ (CGSize)readSizeOfImageFile:(NSString *)fileName;
+
+//Forgets the images in a score directory. Call this when a score is updated or removed.
++ (void)removeScorePath:(NSString *)scorePath;
+
+@end
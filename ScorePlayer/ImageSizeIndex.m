@@ -0,0 +1,291 @@
+//
+//  ImageSizeIndex.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ImageSizeIndex.h"
+#import <ImageIO/ImageIO.h>
+#import "ImageHeader.h"
+#import "ScoreArchive.h"
+
+static const NSInteger IMAGE_SIZE_INDEX_VERSION = 1;
+static NSString *const IMAGE_SIZE_INDEX_FILE = @"ImageSizes.index";
+static NSString *const BUNDLED_FILES_KEY = @"/Bundled/";
+static NSString *const HOME_FILES_KEY = @"~/";
+//Lookups tend to come in bursts while a score opens, so wait a moment before saving.
+static const int64_t IMAGE_SIZE_INDEX_SAVE_DELAY = 2 * NSEC_PER_SEC;
+//Enough for the header of a PNG and most JPEGs.
+static const NSUInteger IMAGE_SIZE_HEADER_LENGTH = 4096;
+
+//Each record is an array of the width and height of the image, followed by the size and
+//modification time (in seconds and nanoseconds) of the file they were read from.
+static NSMutableDictionary *imageSizes;
+static NSLock *imageSizesLock;
+static NSString *indexPath;
+static NSString *bundlePrefix;
+static NSString *homePrefix;
+static dispatch_queue_t saveQueue;
+static BOOL savePending;
+
+@interface ImageSizeIndex ()
+
++ (void)initIndex;
++ (BOOL)saveIndex;
++ (void)scheduleSave;
++ (NSString *)keyForPath:(NSString *)path;
++ (NSArray *)recordWithSize:(CGSize)size version:(ImageHeaderVersion)version;
++ (BOOL)record:(NSArray *)record matchesVersion:(ImageHeaderVersion)version;
++ (CGSize)imageIOSizeOfFile:(NSString *)fileName;
++ (CGSize)archivedSizeOfFile:(NSString *)fileName;
+
+@end
+
+@implementation ImageSizeIndex
+
++ (NSArray *)sizesOfImageFiles:(NSArray *)fileNames
+{
+    [self initIndex];
+    NSInteger count = [fileNames count];
+    
+    //Look everything up at once, then check and read the files in parallel.
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:count];
+    NSMutableArray *records = [[NSMutableArray alloc] initWithCapacity:count];
+    [imageSizesLock lock];
+    for (int i = 0; i < count; i++) {
+        NSString *key = [self keyForPath:[fileNames objectAtIndex:i]];
+        NSArray *record = [imageSizes objectForKey:key];
+        [keys addObject:key];
+        [records addObject:record == nil ? (id)[NSNull null] : record];
+    }
+    [imageSizesLock unlock];
+    
+    CGSize *sizes = calloc(count, sizeof(CGSize));
+    if (sizes == NULL) {
+        return nil;
+    }
+    NSMutableDictionary *newRecords = [[NSMutableDictionary alloc] init];
+    NSLock *newRecordsLock = [[NSLock alloc] init];
+    dispatch_apply(count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        @autoreleasepool {
+            NSString *fileName = [fileNames objectAtIndex:i];
+            const char *path = [fileName fileSystemRepresentation];
+            NSArray *record = [records objectAtIndex:i];
+            ImageHeaderVersion version;
+            if (record != (id)[NSNull null] && ImageHeaderReadVersion(path, &version) && [self record:record matchesVersion:version]) {
+                sizes[i] = CGSizeMake([[record objectAtIndex:0] floatValue], [[record objectAtIndex:1] floatValue]);
+                return;
+            }
+            
+            ImageHeaderSize headerSize;
+            if (ImageHeaderReadFile(path, &headerSize, &version) == ImageHeaderFound) {
+                sizes[i] = CGSizeMake(headerSize.width, headerSize.height);
+            } else if (ImageHeaderReadVersion(path, &version)) {
+                sizes[i] = [self imageIOSizeOfFile:fileName];
+            } else {
+                //Files in a mounted score archive are cheap enough to read that they aren't indexed.
+                sizes[i] = [self archivedSizeOfFile:fileName];
+                return;
+            }
+            
+            if (sizes[i].width > 0 && sizes[i].height > 0) {
+                [newRecordsLock lock];
+                [newRecords setObject:[self recordWithSize:sizes[i] version:version] forKey:[keys objectAtIndex:i]];
+                [newRecordsLock unlock];
+            }
+        }
+    });
+    
+    NSMutableArray *results = [[NSMutableArray alloc] initWithCapacity:count];
+    for (int i = 0; i < count; i++) {
+        [results addObject:[NSValue valueWithCGSize:sizes[i]]];
+    }
+    free(sizes);
+    
+    if ([newRecords count] > 0) {
+        [imageSizesLock lock];
+        [imageSizes addEntriesFromDictionary:newRecords];
+        [imageSizesLock unlock];
+        [self scheduleSave];
+    }
+    return results;
+}
+
++ (CGSize)readSizeOfImageFile:(NSString *)fileName
+{
+    ImageHeaderSize headerSize;
+    if (ImageHeaderReadFile([fileName fileSystemRepresentation], &headerSize, NULL) == ImageHeaderFound) {
+        return CGSizeMake(headerSize.width, headerSize.height);
+    }
+    CGSize size = [self imageIOSizeOfFile:fileName];
+    if (size.width == 0 && size.height == 0) {
+        size = [self archivedSizeOfFile:fileName];
+    }
+    return size;
+}
+
++ (void)removeScorePath:(NSString *)scorePath
+{
+    [self initIndex];
+    NSString *prefix = [self keyForPath:[scorePath stringByAppendingString:@"/"]];
+    
+    [imageSizesLock lock];
+    NSArray *keys = [imageSizes allKeys];
+    NSInteger removed = 0;
+    for (int i = 0; i < [keys count]; i++) {
+        if ([[keys objectAtIndex:i] hasPrefix:prefix]) {
+            [imageSizes removeObjectForKey:[keys objectAtIndex:i]];
+            removed++;
+        }
+    }
+    [imageSizesLock unlock];
+    
+    if (removed > 0) {
+        [self scheduleSave];
+    }
+}
+
+#pragma mark - Private methods
+
++ (void)initIndex
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSString *cachesDirectory = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+        indexPath = [cachesDirectory stringByAppendingPathComponent:IMAGE_SIZE_INDEX_FILE];
+        bundlePrefix = [[[NSBundle mainBundle] bundlePath] stringByAppendingString:@"/"];
+        homePrefix = [NSHomeDirectory() stringByAppendingString:@"/"];
+        imageSizesLock = [[NSLock alloc] init];
+        saveQueue = dispatch_queue_create("com.decibel.imagesizeindex", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+        
+        NSData *indexData = [NSData dataWithContentsOfFile:indexPath];
+        if (indexData != nil) {
+            NSDictionary *savedIndex = [NSPropertyListSerialization propertyListWithData:indexData options:NSPropertyListMutableContainers format:NULL error:nil];
+            if ([savedIndex isKindOfClass:[NSDictionary class]] && [[savedIndex objectForKey:@"indexVersion"] integerValue] == IMAGE_SIZE_INDEX_VERSION) {
+                imageSizes = [savedIndex objectForKey:@"images"];
+            }
+        }
+        if (![imageSizes isKindOfClass:[NSMutableDictionary class]]) {
+            imageSizes = [[NSMutableDictionary alloc] init];
+        }
+    });
+}
+
++ (BOOL)saveIndex
+{
+    [imageSizesLock lock];
+    savePending = NO;
+    NSDictionary *images = [NSDictionary dictionaryWithDictionary:imageSizes];
+    [imageSizesLock unlock];
+    
+    NSMutableDictionary *savedIndex = [[NSMutableDictionary alloc] init];
+    [savedIndex setObject:[NSNumber numberWithInteger:IMAGE_SIZE_INDEX_VERSION] forKey:@"indexVersion"];
+    [savedIndex setObject:images forKey:@"images"];
+    
+    NSData *indexData = [NSPropertyListSerialization dataWithPropertyList:savedIndex format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+    if (indexData == nil) {
+        return NO;
+    }
+    [[NSFileManager defaultManager] createDirectoryAtPath:[indexPath stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+    return [indexData writeToFile:indexPath atomically:YES];
+}
+
++ (void)scheduleSave
+{
+    [imageSizesLock lock];
+    if (savePending) {
+        [imageSizesLock unlock];
+        return;
+    }
+    savePending = YES;
+    [imageSizesLock unlock];
+    
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, IMAGE_SIZE_INDEX_SAVE_DELAY), saveQueue, ^{
+        [self saveIndex];
+    });
+}
+
++ (NSString *)keyForPath:(NSString *)path
+{
+    //Files are stored relative to the app bundle or home directory, since the path of the
+    //app's container can change between launches.
+    if ([path hasPrefix:bundlePrefix]) {
+        return [BUNDLED_FILES_KEY stringByAppendingString:[path substringFromIndex:[bundlePrefix length]]];
+    } else if ([path hasPrefix:homePrefix]) {
+        return [HOME_FILES_KEY stringByAppendingString:[path substringFromIndex:[homePrefix length]]];
+    }
+    return path;
+}
+
++ (NSArray *)recordWithSize:(CGSize)size version:(ImageHeaderVersion)version
+{
+    return [NSArray arrayWithObjects:[NSNumber numberWithFloat:size.width], [NSNumber numberWithFloat:size.height], [NSNumber numberWithUnsignedLongLong:version.size], [NSNumber numberWithLongLong:version.modifiedSeconds], [NSNumber numberWithLongLong:version.modifiedNanoseconds], nil];
+}
+
++ (BOOL)record:(NSArray *)record matchesVersion:(ImageHeaderVersion)version
+{
+    if (![record isKindOfClass:[NSArray class]] || [record count] != 5) {
+        return NO;
+    }
+    return [[record objectAtIndex:2] unsignedLongLongValue] == version.size && [[record objectAtIndex:3] longLongValue] == version.modifiedSeconds && [[record objectAtIndex:4] longLongValue] == version.modifiedNanoseconds;
+}
+
++ (CGSize)imageIOSizeOfFile:(NSString *)fileName
+{
+    //Return the dimensions of an image without loading it into memory.
+    NSURL *imageFileURL = [NSURL fileURLWithPath:fileName];
+    CGImageSourceRef imageSource = CGImageSourceCreateWithURL((__bridge CFURLRef)imageFileURL, NULL);
+    
+    if (imageSource == NULL) {
+        //Something has gone wrong. Return a zero size.
+        return CGSizeMake(0, 0);
+    }
+    
+    NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithBool:NO], (NSString *)kCGImageSourceShouldCache, nil];
+    CFDictionaryRef imageProperties = CGImageSourceCopyPropertiesAtIndex(imageSource, 0, (__bridge CFDictionaryRef)options);
+    if (imageProperties) {
+        NSNumber *width = (NSNumber *)CFDictionaryGetValue(imageProperties, kCGImagePropertyPixelWidth);
+        NSNumber *height = (NSNumber *)CFDictionaryGetValue(imageProperties, kCGImagePropertyPixelHeight);
+        
+        CFRelease(imageProperties);
+        CFRelease(imageSource);
+        return CGSizeMake([width intValue], [height intValue]);
+    } else {
+        CFRelease(imageSource);
+        return CGSizeMake(0, 0);
+    }
+}
+
++ (CGSize)archivedSizeOfFile:(NSString *)fileName
+{
+    //Try the start of the file first, since that's all most headers need.
+    NSData *header = [ScoreArchive archivedDataForFile:fileName range:NSMakeRange(0, IMAGE_SIZE_HEADER_LENGTH)];
+    if (header == nil) {
+        return CGSizeMake(0, 0);
+    }
+    ImageHeaderSize headerSize;
+    ImageHeaderResult result = ImageHeaderRead([header bytes], [header length], &headerSize);
+    if (result == ImageHeaderFound) {
+        return CGSizeMake(headerSize.width, headerSize.height);
+    }
+    
+    NSData *data = [ScoreArchive archivedDataForFile:fileName];
+    if (data == nil) {
+        return CGSizeMake(0, 0);
+    }
+    if (result == ImageHeaderTruncated && ImageHeaderRead([data bytes], [data length], &headerSize) == ImageHeaderFound) {
+        return CGSizeMake(headerSize.width, headerSize.height);
+    }
+    CGImageSourceRef imageSource = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+    if (imageSource == NULL) {
+        return CGSizeMake(0, 0);
+    }
+    NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithBool:NO], (NSString *)kCGImageSourceShouldCache, nil];
+    NSDictionary *imageProperties = (__bridge_transfer NSDictionary *)CGImageSourceCopyPropertiesAtIndex(imageSource, 0, (__bridge CFDictionaryRef)options);
+    CFRelease(imageSource);
+    return CGSizeMake([[imageProperties objectForKey:(NSString *)kCGImagePropertyPixelWidth] intValue], [[imageProperties objectForKey:(NSString *)kCGImagePropertyPixelHeight] intValue]);
+}
+
+@end
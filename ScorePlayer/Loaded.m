@@ -10,6 +10,7 @@
 #import "Loaded.h"
 #import "Score.h"
 #import "OSCMessage.h"
+#import "ScoreArchive.h"
 
 @interface Loaded ()
 
@@ -244,7 +245,7 @@
     allowRepeats = NO;
     
     //Load our preferences
-    NSData *prefsData = [[NSData alloc] initWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
+    NSData *prefsData = [ScoreArchive dataWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
     xmlParser = [[NSXMLParser alloc] initWithData:prefsData];
     
     isData = NO;
@@ -547,9 +548,8 @@
     }
     
     //Check that we have all of our necessary image files.
-    NSFileManager *fileManager = [NSFileManager defaultManager];
     
-    if (![fileManager fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:panelFileName]]) {
+    if (![ScoreArchive fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:panelFileName]]) {
         badPrefs = YES;
         errorMessage = @"Unable to find panel image file.";
     }
@@ -557,14 +557,14 @@
     //Check that we have enough images in the parts.
     for (int i = 1; i <= rows; i++) {
         NSString *fileName = [score.scorePath stringByAppendingPathComponent:[score.fileName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i]]];
-        if (![fileManager fileExistsAtPath:fileName]) {
+        if (![ScoreArchive fileExistsAtPath:fileName]) {
             badPrefs = YES;
             errorMessage = @"Missing images in score file.";
             i = (int)rows + 1;
         }
         for (int j = 0; j < [score.parts count]; j++) {
             fileName =[score.scorePath stringByAppendingPathComponent:[[score.parts objectAtIndex:j] stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i]]];
-            if (![fileManager fileExistsAtPath:fileName]) {
+            if (![ScoreArchive fileExistsAtPath:fileName]) {
                 badPrefs = YES;
                 errorMessage = @"Missing images in score file.";
                 i = (int)rows + 1;
@@ -578,7 +578,7 @@
         UIDelegate.clockDuration = [headlines count] * headlineTime;
     }
     
-    if ((titleCard != nil) && ![fileManager fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:titleCard]]) {
+    if ((titleCard != nil) && ![ScoreArchive fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:titleCard]]) {
         titleCard = nil;
     }
     
@@ -589,7 +589,7 @@
         fileName = [fileName stringByReplacingOccurrencesOfString:@"/" withString:@"-"];
         fileName = [fileName stringByReplacingOccurrencesOfString:@":" withString:@"."];
         fileName = [score.scorePath stringByAppendingPathComponent:fileName];
-        if (![fileManager fileExistsAtPath:fileName]) {
+        if (![ScoreArchive fileExistsAtPath:fileName]) {
             UIImage *thumbnail = [Renderer defaultThumbnail:[score.scorePath stringByAppendingPathComponent:titleCard] ofSize:(CGSizeMake(88, 66))];
             [UIImagePNGRepresentation(thumbnail) writeToFile:fileName atomically:YES];
         }
@@ -39,5 +39,8 @@
 
 @optional
 - (void)finishedUpdating;
+//Scores that were updated in place rather than downloaded. This is called before the downloaded
+//updates are handed over.
+- (void)updatedScoresAtPaths:(NSArray *)scorePaths;
 
 @end
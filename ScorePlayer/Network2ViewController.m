@@ -8,6 +8,7 @@
 
 #import "Network2ViewController.h"
 #import "Version.h"
+#import "ScoreSearchIndex.h"
 
 @interface Network2ViewController ()
 
@@ -21,6 +22,7 @@
     NSString *service;
     NSMutableArray *servers;
     NSMutableArray *filteredScores;
+    ScoreSearchIndex *scoresSearchIndex;
     UIColor *defaultVersionColour;
     
     Mode viewMode;
@@ -203,14 +205,19 @@
 
 - (void)filterScores:(NSString *)searchText
 {
-    [filteredScores removeAllObjects];
-    for (int i = 0; i < [availableScores count]; i++) {
-        NSRange nameRange = [[[availableScores objectAtIndex:i] objectAtIndex:0] rangeOfString:searchText options:NSCaseInsensitiveSearch];
-        NSRange composerRange = [[[availableScores objectAtIndex:i] objectAtIndex:1] rangeOfString:searchText options:NSCaseInsensitiveSearch];
-        if (nameRange.location != NSNotFound || composerRange.location != NSNotFound) {
-            [filteredScores addObject:[availableScores objectAtIndex:i]];
+    //Index the names and composers the first time we search a new list.
+    if (scoresSearchIndex == nil) {
+        scoresSearchIndex = [[ScoreSearchIndex alloc] initWithFieldCount:2];
+        for (int i = 0; i < [availableScores count]; i++) {
+            [scoresSearchIndex addEntryWithFields:[availableScores objectAtIndex:i]];
         }
     }
+    
+    [filteredScores removeAllObjects];
+    NSArray *matches = [scoresSearchIndex search:searchText];
+    for (int i = 0; i < [matches count]; i++) {
+        [filteredScores addObject:[availableScores objectAtIndex:[[matches objectAtIndex:i] integerValue]]];
+    }
 }
 
 #pragma mark NetworkStatus delegate
@@ -262,6 +269,7 @@
 - (void)setAvailableScores:(NSArray *)scores
 {
     availableScores = scores;
+    scoresSearchIndex = nil;
     
     if (networkConnectionDelegate == nil) {
         return;
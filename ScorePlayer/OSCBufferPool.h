@@ -0,0 +1,25 @@
+//
+//  OSCBufferPool.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+//A pool of reusable send buffers. Buffers are handed out at the requested length and should
+//be recycled once the socket has finished with them. Only a limited number of buffers up to
+//a maximum size are kept, so large one off messages don't pin memory.
+
+@interface OSCBufferPool : NSObject
+
+@property (nonatomic, readonly) NSUInteger buffersAllocated;
+@property (nonatomic, readonly) NSUInteger buffersReused;
+
++ (OSCBufferPool *)sharedPool;
+
+- (NSMutableData *)bufferWithLength:(NSUInteger)length;
+- (void)recycleBuffer:(NSMutableData *)buffer;
+
+@end
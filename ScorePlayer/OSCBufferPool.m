@@ -0,0 +1,83 @@
+//
+//  OSCBufferPool.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "OSCBufferPool.h"
+
+//Most of our traffic is ticks and control messages, so these limits are generous.
+static const NSUInteger POOL_MAX_BUFFERS = 64;
+static const NSUInteger POOL_MAX_BUFFER_SIZE = 65536;
+
+@implementation OSCBufferPool {
+    NSMutableArray *freeBuffers;
+    NSLock *poolLock;
+}
+
+@synthesize buffersAllocated, buffersReused;
+
++ (OSCBufferPool *)sharedPool
+{
+    static OSCBufferPool *sharedPool = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        sharedPool = [[self alloc] init];
+    });
+    
+    return sharedPool;
+}
+
+- (id)init
+{
+    self = [super init];
+    freeBuffers = [[NSMutableArray alloc] initWithCapacity:POOL_MAX_BUFFERS];
+    poolLock = [[NSLock alloc] init];
+    buffersAllocated = 0;
+    buffersReused = 0;
+    return self;
+}
+
+- (NSMutableData *)bufferWithLength:(NSUInteger)length
+{
+    NSMutableData *buffer = nil;
+    
+    [poolLock lock];
+    if (length <= POOL_MAX_BUFFER_SIZE) {
+        buffer = [freeBuffers lastObject];
+    }
+    if (buffer != nil) {
+        [freeBuffers removeLastObject];
+        buffersReused++;
+    } else {
+        buffersAllocated++;
+    }
+    [poolLock unlock];
+    
+    if (buffer == nil) {
+        //Allocate with room to grow so that the buffer is useful for later, larger messages.
+        buffer = [[NSMutableData alloc] initWithCapacity:MAX(length, 256)];
+    }
+    //Shrinking the length keeps the existing allocation, so reused buffers generally only
+    //reallocate if this message is larger than any they've held before.
+    [buffer setLength:length];
+    return buffer;
+}
+
+- (void)recycleBuffer:(NSMutableData *)buffer
+{
+    if (buffer == nil || [buffer length] > POOL_MAX_BUFFER_SIZE) {
+        return;
+    }
+    
+    [poolLock lock];
+    if ([freeBuffers count] < POOL_MAX_BUFFERS) {
+        [freeBuffers addObject:buffer];
+    }
+    [poolLock unlock];
+}
+
+@end
@@ -19,12 +19,25 @@
 @property (nonatomic, readonly) NSString *typeTag;
 @property (nonatomic, readonly) NSArray *arguments;
 @property (nonatomic) double timestamp;
+@property (nonatomic, readonly) NSUInteger addressCount;
+@property (nonatomic, readonly) NSUInteger argumentCount;
 
 + (NSDate *)ntpReferenceDate;
++ (BOOL)isBundle:(NSData *)data;
 + (NSArray *)processBundle:(NSData *)bundleData;
 
+//Received messages are decoded in place over the given data, which is retained rather than copied.
+//Address and argument objects are only created if they're asked for.
 - (id)initWithData:(NSData *)oscData;
 
+//Typed accessors that read straight from the received data where possible. They return 0 or nil
+//if the argument is out of range or of a different type.
+- (BOOL)addressComponentAtIndex:(NSUInteger)index isEqualToString:(NSString *)string;
+- (SInt32)intArgumentAtIndex:(NSUInteger)index;
+- (Float32)floatArgumentAtIndex:(NSUInteger)index;
+- (NSString *)stringArgumentAtIndex:(NSUInteger)index;
+- (NSData *)blobArgumentAtIndex:(NSUInteger)index;
+
 - (BOOL)appendAddressComponent:(NSString *)string;
 - (BOOL)prependAddressComponent:(NSString *)string;
 - (BOOL)setAddressWithString:(NSString *)string;
@@ -46,6 +59,12 @@
 - (void)removeArgumentAtIndex:(NSUInteger)index;
 - (void)removeAllArguments;
 
+//Encoding computes the exact size first and then serialises in a single pass. The optional
+//header is the 4 byte big endian length prefix used over TCP.
+- (NSUInteger)encodedLengthWithHeader:(BOOL)includeHeader;
+- (NSUInteger)encodeIntoBuffer:(void *)buffer capacity:(NSUInteger)capacity withHeader:(BOOL)includeHeader;
 - (NSData *)messageAsDataWithHeader:(BOOL)includeHeader;
+//Returns a buffer from the shared OSCBufferPool, which should be recycled once it has been sent.
+- (NSMutableData *)pooledDataWithHeader:(BOOL)includeHeader;
 
 @end
@@ -7,11 +7,15 @@
 //
 
 #import "OSCMessage.h"
+#import "OSCView.h"
+#import "OSCBufferPool.h"
 
 @interface OSCMessage ()
 
-- (void)padData:(NSMutableData *)data forString:(BOOL)isString;
-- (NSString *)extractFirstStringFrom:(const char *)data index:(NSUInteger *)index length:(NSUInteger)length;
+- (void)decodeView;
+- (void)willModifyAddress;
+- (void)willModifyArguments;
+- (NSUInteger)writeToBuffer:(char *)output length:(NSUInteger)length withHeader:(BOOL)includeHeader;
 
 //These functions ensure that we have the right endian format for OSC data types.
 + (SInt32)OSCIntValue:(SInt32)intValue;
@@ -22,10 +26,40 @@
 
 @end
 
+//Strings are always null terminated with up to 3 extra bytes of padding. Blobs are only padded
+//to the next multiple of 4.
+static inline NSUInteger OSCPaddedLength(NSUInteger length, BOOL isString)
+{
+    if (isString) {
+        return length + 4 - (length % 4);
+    }
+    return length + (4 - (length % 4)) % 4;
+}
+
+static inline NSUInteger OSCPad(char *output, NSUInteger start, NSUInteger index, BOOL isString)
+{
+    NSUInteger end = start + OSCPaddedLength(index - start, isString);
+    memset(output + index, 0, end - index);
+    return end;
+}
+
+static inline NSUInteger OSCWriteString(NSString *string, char *output, NSUInteger capacity)
+{
+    NSUInteger used = 0;
+    [string getBytes:output maxLength:capacity usedLength:&used encoding:NSUTF8StringEncoding options:0 range:NSMakeRange(0, [string length]) remainingRange:NULL];
+    return used;
+}
+
 @implementation OSCMessage {
-    //Used to cache our resulting data so that we only regenerate it if necessary.
-    NSMutableData *addressData;
-    NSMutableData *argumentData;
+    //For received messages, the original data and a view over it. The view stays valid until
+    //the message is modified, at which point we fall back to our decoded objects.
+    NSData *sourceData;
+    OSCView view;
+    BOOL hasView;
+    
+    //Immutable copies handed out by our getters, invalidated whenever we change.
+    NSArray *addressCopy;
+    NSArray *argumentsCopy;
 }
 
 @synthesize timestamp;
@@ -43,6 +77,12 @@
     return [[NSCalendar currentCalendar] dateFromComponents:refComponents];
 }
 
++ (BOOL)isBundle:(NSData *)data
+{
+    //Bundles start with "#bundle" followed by a null and an 8 byte timestamp.
+    return [data length] >= 16 && memcmp([data bytes], "#bundle", 8) == 0;
+}
+
 + (NSArray *)processBundle:(NSData *)bundleData
 {
     NSMutableArray *messages = [[NSMutableArray alloc] init];
@@ -50,7 +90,7 @@
     
     //For the moment we're not implementing support for time tags. Bundles get processed immediately.
     //Check that we've actually been given a bundle.
-    if (![[NSString stringWithUTF8String:[bundleData bytes]] isEqualToString:@"#bundle"]) {
+    if (![OSCMessage isBundle:bundleData]) {
         return nil;
     }
     
@@ -70,7 +110,7 @@
         messageSize += (4 - (messageSize % 4)) % 4;
         if (messageSize + currentLocation <= [bundleData length]) {
             NSData *messageData = [bundleData subdataWithRange:NSMakeRange(currentLocation, messageSize)];
-            if ([[NSString stringWithUTF8String:[messageData bytes]] isEqualToString:@"#bundle"]) {
+            if ([OSCMessage isBundle:messageData]) {
                 //Our bundle contains a bundle.
                 NSArray *subMessages = [OSCMessage processBundle:messageData];
                 if (subMessages != nil) {
@@ -112,100 +152,176 @@
 - (id)initWithData:(NSData *)oscData
 {
     self = [super init];
-    NSUInteger index = 0;
-    NSUInteger length = [oscData length];
-    const char *rawData = (const char *)[oscData bytes];
     
-    //Get our address and check if it starts with "/"
-    //(May perform additional validation later.)
-    NSString *newAddress = [self extractFirstStringFrom:rawData index:&index length:length];
-    if ([newAddress characterAtIndex:0] != '/') {
+    //Keep a reference to our data rather than copying it out. (Copying an immutable NSData
+    //just retains it, but protects us from being handed a mutable one.)
+    sourceData = [oscData copy];
+    if (!OSCViewParse(&view, [sourceData bytes], [sourceData length])) {
+        //Our OSC message isn't properly formatted.
         return nil;
     }
-    [self setAddressWithString:newAddress];
+    hasView = YES;
+    timestamp = 0;
     
-    //Get our tag type and check that it is valid.
-    typeTag = [[NSMutableString alloc] initWithString:[self extractFirstStringFrom:rawData index:&index length: length]];
-    if ([typeTag characterAtIndex:0] != ',') {
-        return nil;
-    }
-    NSString *argTags = [typeTag substringFromIndex:1];
-    NSCharacterSet *invalidTags = [[NSCharacterSet characterSetWithCharactersInString:@"ifsb"] invertedSet];
-    if ([argTags rangeOfCharacterFromSet:invalidTags].location != NSNotFound) {
-        return nil;
+    //All successful.
+    return self;
+}
+
+- (void)dealloc
+{
+    OSCViewRelease(&view);
+}
+
+- (void)decodeView
+{
+    //Create our address and argument objects from the view if they haven't already been.
+    if (!hasView || address != nil) {
+        return;
     }
     
-    //Now use our tag type to populate our data array. We'll need to check that we have enough
-    //data for each tag.
+    address = [[NSMutableArray alloc] initWithCapacity:view.addressCount];
+    for (NSUInteger i = 0; i < view.addressCount; i++) {
+        const char *component;
+        size_t length;
+        OSCViewAddressComponentAt(&view, i, &component, &length);
+        //The view has already checked that this is valid UTF-8.
+        [address addObject:[[NSString alloc] initWithBytes:component length:length encoding:NSUTF8StringEncoding]];
+    }
     
-    arguments = [[NSMutableArray alloc] init];
-    int intSize = sizeof(SInt32);
-    for (int i = 1; i < [typeTag length]; i++) {
-        char type = [typeTag characterAtIndex:i];
+    typeTag = [[NSMutableString alloc] initWithString:@","];
+    arguments = [[NSMutableArray alloc] initWithCapacity:view.argumentCount];
+    for (NSUInteger i = 0; i < view.argumentCount; i++) {
+        char type = OSCViewTypeAt(&view, i);
+        id argument;
         if (type == 'i') {
-            if ([oscData length] >= index + intSize) {
-                SInt32 buffer;
-                memcpy(&buffer, rawData + index, intSize);
-                [arguments addObject:[NSNumber numberWithInt:[OSCMessage intFromOSC:(SInt32)buffer]]];
-                index += intSize;
-            } else {
-                //Our OSC message isn't properly formatted.
-                return nil;
-            }
+            argument = [NSNumber numberWithInt:OSCViewInt32At(&view, i)];
         } else if (type == 'f') {
-            if ([oscData length] >= index + intSize) {
-                SInt32 buffer;
-                memcpy(&buffer, rawData + index, intSize);
-                [arguments addObject:[NSNumber numberWithFloat:[OSCMessage floatFromOSC:(SInt32)buffer]]];
-                index += intSize;
-            } else {
-                return nil;
-            }
+            argument = [NSNumber numberWithFloat:OSCViewFloatAt(&view, i)];
         } else if (type == 's') {
-            NSString *arg = [self extractFirstStringFrom:rawData index:&index length:length];
-            if (arg == nil) {
-                return nil;
-            } else {
-                [arguments addObject:arg];
-            }
-        } else if (type == 'b') {
-            //Minimum size of a blob is the size of the header plus 4 bytes.
-            if ([oscData length] >= index + intSize + 4) {
-                SInt32 header;
-                memcpy(&header, rawData + index, intSize);
-                int blobLength = [OSCMessage intFromOSC:header];
-                //Skip past our header before getting our data.
-                index += 4;
-                int padLength = (4 - (blobLength % 4)) % 4;
-                if (length - index < blobLength + padLength) {
-                    //We don't have enough data.
-                    return nil;
-                }
-                [arguments addObject:[NSData dataWithBytes:(rawData + index) length:blobLength]];
-                index += blobLength + padLength;
-            } else {
-                return nil;
-            }
+            argument = [self stringArgumentAtIndex:i];
+        } else {
+            argument = [self blobArgumentAtIndex:i];
         }
+        [typeTag appendFormat:@"%c", type];
+        [arguments addObject:argument];
     }
-    
-    //All successful.
-    return self;
+}
+
+- (void)willModifyAddress
+{
+    [self decodeView];
+    //Once we're changed, our original data no longer represents this message.
+    sourceData = nil;
+    addressCopy = nil;
+}
+
+- (void)willModifyArguments
+{
+    [self decodeView];
+    sourceData = nil;
+    argumentsCopy = nil;
 }
 
 - (NSArray *)address
 {
-    return [NSArray arrayWithArray:address];
+    if (addressCopy == nil) {
+        [self decodeView];
+        addressCopy = [NSArray arrayWithArray:address];
+    }
+    return addressCopy;
 }
 
 - (NSString *)typeTag
 {
+    [self decodeView];
     return [NSString stringWithString:typeTag];
 }
 
 - (NSArray *)arguments
 {
-    return [NSArray arrayWithArray:arguments];
+    if (argumentsCopy == nil) {
+        [self decodeView];
+        argumentsCopy = [NSArray arrayWithArray:arguments];
+    }
+    return argumentsCopy;
+}
+
+- (NSUInteger)addressCount
+{
+    if (hasView && address == nil) {
+        return view.addressCount;
+    }
+    return [address count];
+}
+
+- (NSUInteger)argumentCount
+{
+    if (hasView && arguments == nil) {
+        return view.argumentCount;
+    }
+    return [arguments count];
+}
+
+- (BOOL)addressComponentAtIndex:(NSUInteger)index isEqualToString:(NSString *)string
+{
+    if (hasView && address == nil) {
+        return OSCViewAddressComponentEquals(&view, index, [string UTF8String]);
+    }
+    return index < [address count] && [[address objectAtIndex:index] isEqualToString:string];
+}
+
+- (SInt32)intArgumentAtIndex:(NSUInteger)index
+{
+    if (sourceData != nil) {
+        return OSCViewInt32At(&view, index);
+    }
+    if (index >= [arguments count] || [typeTag characterAtIndex:index + 1] != 'i') {
+        return 0;
+    }
+    return [[arguments objectAtIndex:index] intValue];
+}
+
+- (Float32)floatArgumentAtIndex:(NSUInteger)index
+{
+    if (sourceData != nil) {
+        return OSCViewFloatAt(&view, index);
+    }
+    if (index >= [arguments count] || [typeTag characterAtIndex:index + 1] != 'f') {
+        return 0;
+    }
+    return [[arguments objectAtIndex:index] floatValue];
+}
+
+- (NSString *)stringArgumentAtIndex:(NSUInteger)index
+{
+    if (sourceData != nil) {
+        size_t length;
+        const char *string = OSCViewStringAt(&view, index, &length);
+        if (string == NULL) {
+            return nil;
+        }
+        return [[NSString alloc] initWithBytes:string length:length encoding:NSUTF8StringEncoding];
+    }
+    if (index >= [arguments count] || [typeTag characterAtIndex:index + 1] != 's') {
+        return nil;
+    }
+    return [arguments objectAtIndex:index];
+}
+
+- (NSData *)blobArgumentAtIndex:(NSUInteger)index
+{
+    if (sourceData != nil) {
+        size_t length;
+        const char *blob = OSCViewBlobAt(&view, index, &length);
+        if (blob == NULL) {
+            return nil;
+        }
+        return [sourceData subdataWithRange:NSMakeRange(blob - (const char *)[sourceData bytes], length)];
+    }
+    if (index >= [arguments count] || [typeTag characterAtIndex:index + 1] != 'b') {
+        return nil;
+    }
+    return [arguments objectAtIndex:index];
 }
 
 - (BOOL)appendAddressComponent:(NSString *)string
@@ -214,8 +330,8 @@
     if ([string rangeOfString:@"/"].location != NSNotFound) {
         return NO;
     }
+    [self willModifyAddress];
     [address addObject:string];
-    addressData = nil;
     return YES;
 }
 
@@ -225,8 +341,8 @@
     if ([string rangeOfString:@"/"].location != NSNotFound) {
         return NO;
     }
+    [self willModifyAddress];
     [address insertObject:string atIndex:0];
-    addressData = nil;
     return YES;
 }
 
@@ -240,16 +356,16 @@
             return NO;
         }
     }
+    [self willModifyAddress];
     address = [newAddress mutableCopy];
-    addressData = nil;
     return YES;
 }
 
 - (BOOL)stripFirstAddressComponent {
     //Only remove the first address component if we have additional components.
-    if ([address count] > 1) {
+    if (self.addressCount > 1) {
+        [self willModifyAddress];
         [address removeObjectAtIndex:0];
-        addressData = nil;
         return YES;
     } else {
         return NO;
@@ -261,66 +377,66 @@
     if ([message.address count] < 1) {
         return NO;
     } else {
+        [self willModifyAddress];
         address = [[NSMutableArray alloc] initWithArray:message.address];
-        addressData = nil;
         return YES;
     }
 }
 
 - (void)addIntegerArgument:(NSInteger)intArg
 {
+    [self willModifyArguments];
     [typeTag appendString:@"i"];
     [arguments addObject:[NSNumber numberWithInt:(int)intArg]];
-    argumentData = nil;
 }
 
 - (void)addFloatArgument:(CGFloat)floatArg
 {
+    [self willModifyArguments];
     [typeTag appendString:@"f"];
     [arguments addObject:[NSNumber numberWithFloat:floatArg]];
-    argumentData = nil;
 }
 
 - (void)addStringArgument:(NSString *)stringArg
 {
+    [self willModifyArguments];
     [typeTag appendString:@"s"];
     [arguments addObject:stringArg];
-    argumentData = nil;
 }
 
 - (void)addBlobArgument:(NSData *)blobArg
 {
+    [self willModifyArguments];
     [typeTag appendString:@"b"];
     [arguments addObject:blobArg];
-    argumentData = nil;
 }
 
 - (void)replaceArgumentAtIndex:(NSUInteger)index withInteger:(NSInteger)intArg
 {
+    [self willModifyArguments];
     [typeTag replaceCharactersInRange:NSMakeRange(index + 1, 1) withString:@"i"];
     [arguments replaceObjectAtIndex:index withObject:[NSNumber numberWithInt:(int)intArg]];
-    argumentData = nil;
 }
 
 - (void)replaceArgumentAtIndex:(NSUInteger)index withFloat:(CGFloat)floatArg
 {
+    [self willModifyArguments];
     [typeTag replaceCharactersInRange:NSMakeRange(index + 1, 1) withString:@"f"];
     [arguments replaceObjectAtIndex:index withObject:[NSNumber numberWithFloat:floatArg]];
-    argumentData = nil;
 }
 
 - (void)replaceArgumentAtIndex:(NSUInteger)index withString:(NSString *)stringArg
 {
+    [self willModifyArguments];
     [typeTag replaceCharactersInRange:NSMakeRange(index + 1, 1) withString:@"s"];
     [arguments replaceObjectAtIndex:index withObject:stringArg];
-    argumentData = nil;
 }
 
 - (void)replaceArgumentAtIndex:(NSUInteger)index withBlob:(NSData *)blobArg
 {
+    [self willModifyArguments];
     [typeTag replaceCharactersInRange:NSMakeRange(index + 1, 1) withString:@"b"];
     [arguments replaceObjectAtIndex:index withObject:blobArg];
-    argumentData = nil;
 }
 
 - (void)appendArgumentsFromMessage:(OSCMessage *)message
@@ -329,123 +445,151 @@
         return;
     }
     
+    [self willModifyArguments];
     [typeTag appendString:[message.typeTag substringFromIndex:1]];
     [arguments addObjectsFromArray:message.arguments];
-    argumentData = nil;
 }
 
 - (void)removeArgumentAtIndex:(NSUInteger)index
 {
+    [self willModifyArguments];
     [arguments removeObjectAtIndex:index];
     [typeTag replaceCharactersInRange:NSMakeRange(index + 1, 1) withString:@""];
-    argumentData = nil;
 }
 
 - (void)removeAllArguments
 {
+    [self willModifyArguments];
     [arguments removeAllObjects];
     typeTag = [[NSMutableString alloc] initWithString:@","];
-    argumentData = nil;
 }
 
-- (NSData *)messageAsDataWithHeader:(BOOL)includeHeader
+- (NSUInteger)encodedLengthWithHeader:(BOOL)includeHeader
 {
-    NSMutableData *message;
-    if (includeHeader) {
-        message = [[NSMutableData alloc] initWithLength:4];
-    } else {
-        message = [[NSMutableData alloc] init];
+    NSUInteger length = includeHeader ? 4 : 0;
+    if (sourceData != nil) {
+        return view.addressCount == 0 ? 0 : length + [sourceData length];
     }
     
-    //Make sure we have some address information. Then add it.
+    //Make sure we have some address information.
     if ([address count] == 0) {
-        return nil;
+        return 0;
     }
     
-    if (addressData == nil) {
-        addressData = [[NSMutableData alloc] init];
-        for (int i = 0; i < [address count]; i++) {
-            [addressData appendData:[[NSString stringWithFormat:@"/%@", [address objectAtIndex:i]] dataUsingEncoding:NSUTF8StringEncoding]];
-        }
-        [self padData:addressData forString:YES];
+    //Each address component is preceded by a slash.
+    NSUInteger addressLength = 0;
+    for (NSString *component in address) {
+        addressLength += [component lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + 1;
     }
-    [message appendData:addressData];
+    length += OSCPaddedLength(addressLength, YES);
+    length += OSCPaddedLength([typeTag length], YES);
     
-    //Add the type tag.
-    [message appendData:[typeTag dataUsingEncoding:NSUTF8StringEncoding]];
-    [self padData:message forString:YES];
-    
-    //Then add our arguments.
-    if (argumentData == nil) {
-        argumentData = [[NSMutableData alloc] init];
-        for (int i = 0; i < [arguments count]; i++) {
-            char type = [typeTag characterAtIndex:i + 1];
-            if (type == 'i') {
-                SInt32 arg = [OSCMessage OSCIntValue:[[arguments objectAtIndex:i] intValue]];
-                [argumentData appendBytes:&arg length:sizeof(SInt32)];
-            } else if (type == 'f') {
-                SInt32 arg = [OSCMessage OSCFloatValue:[[arguments objectAtIndex:i] floatValue]];
-                [argumentData appendBytes:&arg length:sizeof(SInt32)];
-            } else if (type == 's') {
-                [argumentData appendData:[[arguments objectAtIndex:i] dataUsingEncoding:NSUTF8StringEncoding]];
-                [self padData:argumentData forString:YES];
-            } else if (type == 'b') {
-                SInt32 length = [OSCMessage OSCIntValue:(SInt32)[[arguments objectAtIndex:i] length]];
-                [argumentData appendBytes:&length length:sizeof(SInt32)];
-                [argumentData appendData:[arguments objectAtIndex:i]];
-                [self padData:argumentData forString:NO];
-            } else {
-                //This shouldn't be possible. (Unrecognized tag type.) Return nil.
-                argumentData = nil;
-                return nil;
-            }
+    for (NSUInteger i = 0; i < [arguments count]; i++) {
+        char type = [typeTag characterAtIndex:i + 1];
+        if (type == 'i' || type == 'f') {
+            length += sizeof(SInt32);
+        } else if (type == 's') {
+            length += OSCPaddedLength([[arguments objectAtIndex:i] lengthOfBytesUsingEncoding:NSUTF8StringEncoding], YES);
+        } else if (type == 'b') {
+            length += sizeof(SInt32) + OSCPaddedLength([[arguments objectAtIndex:i] length], NO);
+        } else {
+            //This shouldn't be possible. (Unrecognized tag type.)
+            return 0;
         }
     }
-    [message appendData:argumentData];
     
-    if (includeHeader) {
-        //Remove the length of our header when calculating the length to store in the header.
-        SInt32 length = [OSCMessage OSCIntValue:(SInt32)([message length] - 4)];
-        [message replaceBytesInRange:NSMakeRange(0, 4) withBytes:&length];
+    return length;
+}
+
+- (NSUInteger)encodeIntoBuffer:(void *)buffer capacity:(NSUInteger)capacity withHeader:(BOOL)includeHeader
+{
+    NSUInteger length = [self encodedLengthWithHeader:includeHeader];
+    if (length == 0 || length > capacity) {
+        return 0;
+    }
+    return [self writeToBuffer:buffer length:length withHeader:includeHeader];
+}
+
+- (NSData *)messageAsDataWithHeader:(BOOL)includeHeader
+{
+    if (sourceData != nil && !includeHeader) {
+        //We haven't been changed since we were received, so our original data is still valid.
+        return view.addressCount == 0 ? nil : sourceData;
     }
     
+    NSUInteger length = [self encodedLengthWithHeader:includeHeader];
+    if (length == 0) {
+        return nil;
+    }
+    NSMutableData *message = [[NSMutableData alloc] initWithLength:length];
+    [self writeToBuffer:[message mutableBytes] length:length withHeader:includeHeader];
     return message;
 }
 
-- (void)padData:(NSMutableData *)data forString:(BOOL)isString;
+- (NSMutableData *)pooledDataWithHeader:(BOOL)includeHeader
 {
-    int padLength = 4 - ([data length] % 4);
-    if (!isString) {
-        padLength = padLength % 4;
+    NSUInteger length = [self encodedLengthWithHeader:includeHeader];
+    if (length == 0) {
+        return nil;
     }
-    [data increaseLengthBy:padLength];
+    NSMutableData *message = [[OSCBufferPool sharedPool] bufferWithLength:length];
+    [self writeToBuffer:[message mutableBytes] length:length withHeader:includeHeader];
+    return message;
 }
 
-- (NSString *)extractFirstStringFrom:(const char *)data index:(NSUInteger *)index length:(NSUInteger)length;
+- (NSUInteger)writeToBuffer:(char *)output length:(NSUInteger)length withHeader:(BOOL)includeHeader
 {
-    //Get the first null terminated string.
-    NSUInteger i = 0;
-    BOOL foundNull = NO;
-    while (!foundNull && i < length - *index) {
-        if (data[*index + i] == 0) {
-            foundNull = YES;
-        } else {
-            i++;
-        }
+    //Our length has already been calculated, so we can fill in the header up front and then
+    //serialise everything in a single pass.
+    NSUInteger index = 0;
+    if (includeHeader) {
+        SInt32 header = [OSCMessage OSCIntValue:(SInt32)(length - 4)];
+        memcpy(output, &header, sizeof(SInt32));
+        index += sizeof(SInt32);
     }
     
-    //If we didn't find a null character then our data wasn't formatted correctly.
-    if (*index + i == length) {
-        *index = length;
-        return nil;
+    if (sourceData != nil) {
+        memcpy(output + index, [sourceData bytes], [sourceData length]);
+        return length;
+    }
+    
+    NSUInteger stringStart = index;
+    for (NSString *component in address) {
+        output[index++] = '/';
+        index += OSCWriteString(component, output + index, length - index);
     }
+    index = OSCPad(output, stringStart, index, YES);
     
-    NSString *firstString = [NSString stringWithUTF8String:(data + *index)];
+    stringStart = index;
+    index += OSCWriteString(typeTag, output + index, length - index);
+    index = OSCPad(output, stringStart, index, YES);
+    
+    for (NSUInteger i = 0; i < [arguments count]; i++) {
+        char type = [typeTag characterAtIndex:i + 1];
+        if (type == 'i') {
+            SInt32 arg = [OSCMessage OSCIntValue:[[arguments objectAtIndex:i] intValue]];
+            memcpy(output + index, &arg, sizeof(SInt32));
+            index += sizeof(SInt32);
+        } else if (type == 'f') {
+            SInt32 arg = [OSCMessage OSCFloatValue:[[arguments objectAtIndex:i] floatValue]];
+            memcpy(output + index, &arg, sizeof(SInt32));
+            index += sizeof(SInt32);
+        } else if (type == 's') {
+            stringStart = index;
+            index += OSCWriteString([arguments objectAtIndex:i], output + index, length - index);
+            index = OSCPad(output, stringStart, index, YES);
+        } else if (type == 'b') {
+            NSData *blob = [arguments objectAtIndex:i];
+            SInt32 blobLength = [OSCMessage OSCIntValue:(SInt32)[blob length]];
+            memcpy(output + index, &blobLength, sizeof(SInt32));
+            index += sizeof(SInt32);
+            stringStart = index;
+            memcpy(output + index, [blob bytes], [blob length]);
+            index = OSCPad(output, stringStart, index + [blob length], NO);
+        }
+    }
     
-    //Increase our index by the length of the string and the null padding.
-    int padLength = 4 - ([firstString lengthOfBytesUsingEncoding:NSUTF8StringEncoding] % 4);
-    *index += [firstString lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + padLength;
-    return firstString;
+    return index;
 }
 
 + (SInt32)OSCIntValue:(SInt32)intValue
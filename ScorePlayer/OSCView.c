@@ -0,0 +1,291 @@
+//
+//  OSCView.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "OSCView.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t readBigEndian32(const char *data)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
+
+//Finds the end of the null terminated string starting at index, and returns the index
+//of the next 4 byte aligned field. Returns false if there is no terminating null.
+static bool skipString(const char *bytes, size_t length, size_t index, size_t *stringLength, size_t *next)
+{
+    if (index >= length) {
+        return false;
+    }
+    const char *end = memchr(bytes + index, 0, length - index);
+    if (end == NULL) {
+        return false;
+    }
+    *stringLength = end - (bytes + index);
+    //Strings are always followed by between 1 and 4 null bytes. Be lenient about missing
+    //padding at the very end of a message, the same as the original parser.
+    *next = index + *stringLength + 4 - (*stringLength % 4);
+    if (*next > length) {
+        *next = length;
+    }
+    return true;
+}
+
+//Strings have to be valid UTF-8, or they couldn't be turned into NSStrings. This is strict:
+//overlong forms, surrogates and anything beyond U+10FFFF are all rejected.
+static bool isValidUTF8(const char *string, size_t length)
+{
+    const unsigned char *bytes = (const unsigned char *)string;
+    size_t i = 0;
+    while (i < length) {
+        unsigned char lead = bytes[i];
+        if (lead < 0x80) {
+            i++;
+            continue;
+        }
+        size_t count;
+        unsigned char low = 0x80, high = 0xbf;
+        if (lead >= 0xc2 && lead <= 0xdf) {
+            count = 1;
+        } else if (lead >= 0xe0 && lead <= 0xef) {
+            count = 2;
+            if (lead == 0xe0) {
+                low = 0xa0;
+            } else if (lead == 0xed) {
+                high = 0x9f;
+            }
+        } else if (lead >= 0xf0 && lead <= 0xf4) {
+            count = 3;
+            if (lead == 0xf0) {
+                low = 0x90;
+            } else if (lead == 0xf4) {
+                high = 0x8f;
+            }
+        } else {
+            return false;
+        }
+        if (length - i <= count || bytes[i + 1] < low || bytes[i + 1] > high) {
+            return false;
+        }
+        for (size_t j = 2; j <= count; j++) {
+            if (bytes[i + j] < 0x80 || bytes[i + j] > 0xbf) {
+                return false;
+            }
+        }
+        i += count + 1;
+    }
+    return true;
+}
+
+static void setOffset(OSCView *view, size_t index, uint32_t offset)
+{
+    if (index < OSC_VIEW_INLINE_ARGUMENTS) {
+        view->inlineOffsets[index] = offset;
+    } else {
+        view->offsets[index - OSC_VIEW_INLINE_ARGUMENTS] = offset;
+    }
+}
+
+static uint32_t getOffset(const OSCView *view, size_t index)
+{
+    if (index < OSC_VIEW_INLINE_ARGUMENTS) {
+        return view->inlineOffsets[index];
+    } else {
+        return view->offsets[index - OSC_VIEW_INLINE_ARGUMENTS];
+    }
+}
+
+bool OSCViewParse(OSCView *view, const void *bytes, size_t length)
+{
+    memset(view, 0, sizeof(OSCView));
+    const char *data = (const char *)bytes;
+    if (data == NULL || length == 0 || length > UINT32_MAX) {
+        return false;
+    }
+
+    //Get our address and check that it starts with "/".
+    size_t stringLength, index;
+    if (!skipString(data, length, 0, &stringLength, &index) || stringLength == 0 || data[0] != '/' || !isValidUTF8(data, stringLength)) {
+        return false;
+    }
+
+    //Trim leading and trailing slashes, then count our components. An empty component
+    //leaves the message with no address, which receivers treat as unroutable.
+    const char *address = data;
+    size_t addressLength = stringLength;
+    while (addressLength > 0 && *address == '/') {
+        address++;
+        addressLength--;
+    }
+    while (addressLength > 0 && address[addressLength - 1] == '/') {
+        addressLength--;
+    }
+    size_t addressCount = addressLength > 0 ? 1 : 0;
+    for (size_t i = 0; i < addressLength; i++) {
+        if (address[i] == '/') {
+            if (address[i - 1] == '/') {
+                addressCount = 0;
+                break;
+            }
+            addressCount++;
+        }
+    }
+
+    //Get our type tag and check that it is valid.
+    const char *types = data + index;
+    size_t typesLength;
+    if (!skipString(data, length, index, &typesLength, &index) || typesLength == 0 || *types != ',') {
+        return false;
+    }
+    types++;
+    typesLength--;
+
+    if (typesLength > OSC_VIEW_INLINE_ARGUMENTS) {
+        view->offsets = malloc((typesLength - OSC_VIEW_INLINE_ARGUMENTS) * sizeof(uint32_t));
+        if (view->offsets == NULL) {
+            return false;
+        }
+    }
+
+    //Now walk our arguments, checking that we have enough data for each tag.
+    for (size_t i = 0; i < typesLength; i++) {
+        setOffset(view, i, (uint32_t)index);
+        switch (types[i]) {
+            case 'i':
+            case 'f':
+                if (length < index + 4) {
+                    OSCViewRelease(view);
+                    return false;
+                }
+                index += 4;
+                break;
+            case 's':
+                if (!skipString(data, length, index, &stringLength, &index) || !isValidUTF8(data + getOffset(view, i), stringLength)) {
+                    OSCViewRelease(view);
+                    return false;
+                }
+                break;
+            case 'b': {
+                if (length < index + 4) {
+                    OSCViewRelease(view);
+                    return false;
+                }
+                int32_t blobLength = (int32_t)readBigEndian32(data + index);
+                index += 4;
+                if (blobLength < 0) {
+                    OSCViewRelease(view);
+                    return false;
+                }
+                size_t padLength = (4 - (blobLength % 4)) % 4;
+                if (length - index < (size_t)blobLength + padLength) {
+                    OSCViewRelease(view);
+                    return false;
+                }
+                index += blobLength + padLength;
+                break;
+            }
+            default:
+                //Unsupported type tag.
+                OSCViewRelease(view);
+                return false;
+        }
+    }
+
+    view->bytes = data;
+    view->length = length;
+    view->address = address;
+    view->addressLength = addressLength;
+    view->addressCount = addressCount;
+    view->types = types;
+    view->argumentCount = typesLength;
+    return true;
+}
+
+void OSCViewRelease(OSCView *view)
+{
+    free(view->offsets);
+    memset(view, 0, sizeof(OSCView));
+}
+
+bool OSCViewAddressComponentAt(const OSCView *view, size_t index, const char **component, size_t *length)
+{
+    if (index >= view->addressCount) {
+        return false;
+    }
+    const char *start = view->address;
+    const char *end = view->address + view->addressLength;
+    for (size_t i = 0; i < index; i++) {
+        start = memchr(start, '/', end - start) + 1;
+    }
+    const char *next = memchr(start, '/', end - start);
+    *component = start;
+    *length = (next == NULL ? end : next) - start;
+    return true;
+}
+
+bool OSCViewAddressComponentEquals(const OSCView *view, size_t index, const char *string)
+{
+    const char *component;
+    size_t length;
+    if (!OSCViewAddressComponentAt(view, index, &component, &length)) {
+        return false;
+    }
+    return strlen(string) == length && memcmp(component, string, length) == 0;
+}
+
+char OSCViewTypeAt(const OSCView *view, size_t index)
+{
+    if (index >= view->argumentCount) {
+        return 0;
+    }
+    return view->types[index];
+}
+
+int32_t OSCViewInt32At(const OSCView *view, size_t index)
+{
+    if (OSCViewTypeAt(view, index) != 'i') {
+        return 0;
+    }
+    return (int32_t)readBigEndian32(view->bytes + getOffset(view, index));
+}
+
+float OSCViewFloatAt(const OSCView *view, size_t index)
+{
+    if (OSCViewTypeAt(view, index) != 'f') {
+        return 0;
+    }
+    uint32_t bits = readBigEndian32(view->bytes + getOffset(view, index));
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+const char *OSCViewStringAt(const OSCView *view, size_t index, size_t *length)
+{
+    if (OSCViewTypeAt(view, index) != 's') {
+        return NULL;
+    }
+    const char *string = view->bytes + getOffset(view, index);
+    if (length != NULL) {
+        *length = strlen(string);
+    }
+    return string;
+}
+
+const void *OSCViewBlobAt(const OSCView *view, size_t index, size_t *length)
+{
+    if (OSCViewTypeAt(view, index) != 'b') {
+        return NULL;
+    }
+    const char *blob = view->bytes + getOffset(view, index);
+    if (length != NULL) {
+        *length = readBigEndian32(blob);
+    }
+    return blob + 4;
+}
@@ -0,0 +1,60 @@
+//
+//  OSCView.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//A read only view over an encoded OSC message. Parsing validates the message and records
+//where each argument lives, but nothing is copied out of the original buffer. The buffer
+//must stay alive (and unchanged) for as long as the view is in use.
+
+#ifndef OSCView_h
+#define OSCView_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define OSC_VIEW_INLINE_ARGUMENTS 16
+
+typedef struct {
+    const char *bytes;
+    size_t length;
+
+    //The address string (including the leading "/") and its number of components.
+    const char *address;
+    size_t addressLength;
+    size_t addressCount;
+
+    //The type tags, not including the leading ",".
+    const char *types;
+    size_t argumentCount;
+
+    //Byte offsets of each argument. Messages with more arguments than fit inline spill
+    //over into a heap allocated array, which is freed by OSCViewRelease.
+    uint32_t inlineOffsets[OSC_VIEW_INLINE_ARGUMENTS];
+    uint32_t *offsets;
+} OSCView;
+
+//Returns false if the data is not a well formed OSC message, which includes any string (or the
+//address) that isn't valid UTF-8. (The view is left empty.)
+bool OSCViewParse(OSCView *view, const void *bytes, size_t length);
+void OSCViewRelease(OSCView *view);
+
+//Address components are returned without their separating slashes.
+bool OSCViewAddressComponentAt(const OSCView *view, size_t index, const char **component, size_t *length);
+bool OSCViewAddressComponentEquals(const OSCView *view, size_t index, const char *string);
+
+//Returns 0 if the index is out of range.
+char OSCViewTypeAt(const OSCView *view, size_t index);
+
+//Typed argument accessors. These return 0, NULL or false if the index is out of range
+//or the argument is of a different type.
+int32_t OSCViewInt32At(const OSCView *view, size_t index);
+float OSCViewFloatAt(const OSCView *view, size_t index);
+const char *OSCViewStringAt(const OSCView *view, size_t index, size_t *length);
+const void *OSCViewBlobAt(const OSCView *view, size_t index, size_t *length);
+
+#endif /* OSCView_h */
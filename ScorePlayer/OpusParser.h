@@ -16,7 +16,7 @@
 
 @end
 
-@interface OpusParser : NSObject <NSXMLParserDelegate> {
+@interface OpusParser : NSObject {
     NSString *thumbnailPath;
     NSString *annotationsPath;
     NSString *scorePath;
@@ -34,7 +34,9 @@
 @property (nonatomic, strong) NSString *formatVersion;
 @property (nonatomic, strong) id<OpusParserDelegate> delegate;
 
-- (id)initWithData:(NSData *)xmlData scorePath:(NSString *)path timeOut:(int)time asScoreComponent:(BOOL)subScore;
+//The delegate is called before startParse returns. (The time out is no longer needed, since
+//parsing can't hang, but is kept so that existing callers don't change.)
+- (id)initWithData:(NSData *)data scorePath:(NSString *)path timeOut:(int)time asScoreComponent:(BOOL)subScore;
 - (void)startParse;
 
 + (BOOL)isValidURL:(NSString *)url;
@@ -9,10 +9,65 @@
 #import "OpusParser.h"
 #import "Score.h"
 #import "Renderer.h"
+#import "ScoreArchive.h"
+#import "XMLReader.h"
+
+typedef enum {
+    kOpusElement,
+    kScoreElement,
+    kUpdateURLElement,
+    kVersionElement,
+    kFormatVersionElement,
+    kNameElement,
+    kComposerElement,
+    kTypeElement,
+    kVariationElement,
+    kDurationElement,
+    kStartOffsetElement,
+    kReadOffsetElement,
+    kFileNameElement,
+    kPrefsFileElement,
+    kInstructionsElement,
+    kAudioFileElement,
+    kOptionsElement,
+    kPartElement,
+    kAudioPartElement,
+    kManualIdentifierElement,
+    kBackgroundRGBElement
+} OpusElement;
+
+//The elements of opus.dtd.
+static const XMLName opusElements[] = {
+    {"opus", kOpusElement},
+    {"score", kScoreElement},
+    {"updateurl", kUpdateURLElement},
+    {"version", kVersionElement},
+    {"formatversion", kFormatVersionElement},
+    {"name", kNameElement},
+    {"composer", kComposerElement},
+    {"type", kTypeElement},
+    {"variation", kVariationElement},
+    {"duration", kDurationElement},
+    {"startoffset", kStartOffsetElement},
+    {"readoffset", kReadOffsetElement},
+    {"filename", kFileNameElement},
+    {"prefsfile", kPrefsFileElement},
+    {"instructions", kInstructionsElement},
+    {"audiofile", kAudioFileElement},
+    {"options", kOptionsElement},
+    {"part", kPartElement},
+    {"audiopart", kAudioPartElement},
+    {"manualidentifier", kManualIdentifierElement},
+    {"backgroundrgb", kBackgroundRGBElement}
+};
+
+static XMLNameTable opusNames;
 
 @interface OpusParser ()
 
-- (void)hangCheck;
+- (void)startElement:(int)element;
+- (void)endElement:(int)element text:(XMLSpan)text;
+- (void)endDocument;
 
 @end
 
@@ -20,10 +75,8 @@
     NSMutableArray *scores;
     Score *currentScore;
     NSFileManager *fileManager;
-    NSXMLParser *xmlParser;
-    NSTimer *watchdog;
-    int timeOut;
-    NSMutableString *currentString;
+    NSData *xmlData;
+    NSString *currentString;
     Class rendererClass;
     BOOL isScoreProperty;
     BOOL scoreInvalid;
@@ -32,37 +85,69 @@
 
 @synthesize thumbnailPath, annotationsPath, scorePath, updateURL, opusVersion, formatVersion, delegate;
 
-- (id)initWithData:(NSData *)xmlData scorePath:(NSString *)path timeOut:(int)time asScoreComponent:(BOOL)subScore
+- (id)initWithData:(NSData *)data scorePath:(NSString *)path timeOut:(int)time asScoreComponent:(BOOL)subScore
 {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        XMLNameTableInit(&opusNames, opusElements, sizeof(opusElements) / sizeof(XMLName));
+    });
+    
     self = [super init];
     scorePath = path;
-    timeOut = time;
     isSubScore = subScore;
     scores = [[NSMutableArray alloc] init];
     fileManager = [NSFileManager defaultManager];
-    if (xmlData != nil) {
-        xmlParser = [[NSXMLParser alloc] initWithData:xmlData];
-    }
+    xmlData = data;
     isScoreProperty = NO;
-    xmlParser.delegate = self;
     return self;
 }
 
 - (void)startParse
 {
-    //Trying to resolve the DTD file currently just gives an error.
-    //xmlParser.shouldResolveExternalEntities = YES;
-    if (xmlParser != nil) {
-        watchdog = [NSTimer scheduledTimerWithTimeInterval:timeOut target:self selector:@selector(hangCheck) userInfo:nil repeats:NO];
-        [xmlParser parse];
-    } else {
+    if (xmlData == nil) {
         [delegate parserError:self];
+        return;
+    }
+    
+    //The reader works straight from the data, so there's nothing to copy and no chance of it
+    //hanging. (The DTD isn't resolved, just as before.)
+    XMLReader reader;
+    XMLReaderInit(&reader, [xmlData bytes], [xmlData length]);
+    XMLText text;
+    XMLTextInit(&text);
+    
+    BOOL finished = NO;
+    while (!finished) {
+        switch (XMLReaderNext(&reader)) {
+            case kXMLStartElement:
+                XMLTextReset(&text);
+                [self startElement:XMLNameTableLookup(&opusNames, reader.name)];
+                break;
+                
+            case kXMLText:
+                if (isScoreProperty) {
+                    XMLTextAppend(&text, &reader);
+                }
+                break;
+                
+            case kXMLEndElement:
+                [self endElement:XMLNameTableLookup(&opusNames, reader.name) text:text.span];
+                XMLTextReset(&text);
+                break;
+                
+            case kXMLEndDocument:
+                finished = YES;
+                XMLTextRelease(&text);
+                [self endDocument];
+                break;
+                
+            case kXMLError:
+                finished = YES;
+                XMLTextRelease(&text);
+                [delegate parserError:self];
+                break;
+        }
     }
-}
-
-- (void)hangCheck
-{
-    [xmlParser abortParsing];
 }
 
 + (BOOL)isValidURL:(NSString *)url
@@ -83,40 +168,32 @@
     return NO;
 }
 
-#pragma mark - NSXMLParser delegate
-- (void)parser:(NSXMLParser *)parser didStartElement:(NSString *)elementName namespaceURI:(NSString *)namespaceURI qualifiedName:(NSString *)qName attributes:(NSDictionary *)attributeDict {
-    
-    if ([elementName isEqualToString:@"opus"]) {
+#pragma mark - Elements
+
+- (void)startElement:(int)element
+{
+    if (element == kOpusElement) {
         //This is our collection object which maps to the scores array. Since this is already
         //initialised, our work here is done.
         return;
-    } else if ([elementName isEqualToString:@"score"]) {
+    } else if (element == kScoreElement) {
         //A new score object
         currentScore = [[Score alloc] init];
         scoreInvalid = NO;
     } else {
         //Anything else is a property of the score.
         isScoreProperty = YES;
-        currentString = nil;
     }
 }
 
-- (void)parser:(NSXMLParser *)parser foundCharacters:(NSString *)string
+- (void)endElement:(int)element text:(XMLSpan)text
 {
-    if (isScoreProperty) {
-        if (currentString == nil) {
-            currentString = [[NSMutableString alloc] initWithString:string];
-        } else {
-            [currentString appendString:string];
-        }
-    }
-}
-
-- (void)parser:(NSXMLParser *)parser didEndElement:(NSString *)elementName namespaceURI:(NSString *)namespaceURI qualifiedName:(NSString *)qName
-{
-    if ([elementName isEqualToString:@"opus"]) {
+    //Text is only turned into a string here, once we know the element is one we want.
+    currentString = text.length > 0 ? XMLSpanString(text) : nil;
+    
+    if (element == kOpusElement) {
         return;
-    } else if ([elementName isEqualToString:@"score"]) {
+    } else if (element == kScoreElement) {
         //We need to check that the current score is valid and then add it to our scores collection.
         //Check that it has at least a name, composer (if needed) and renderer type.
         if ((!isSubScore && (currentScore.scoreName == nil || [currentScore.composers count] == 0)) || currentScore.scoreType == nil) {
@@ -181,9 +258,7 @@
             }
             
             //Check if our score has a thumbnail and if not generate it.
-            NSString *fileName = [NSString stringWithFormat:@".%@.%@.thumbnail.png", currentScore.composerFullText, currentScore.scoreName];
-            fileName = [fileName stringByReplacingOccurrencesOfString:@"/" withString:@"-"];
-            fileName = [fileName stringByReplacingOccurrencesOfString:@":" withString:@"."];
+            NSString *fileName = currentScore.thumbnailFileName;
             if (thumbnailPath != nil) {
                 //We have to save thumbnails for the built in scores to an alternative location.
                 fileName = [thumbnailPath stringByAppendingPathComponent:fileName];
@@ -218,18 +293,18 @@
     //If there is no currentScore then there should be no legitimate reason to set any properties.
     //The only things we should check for are opus wide options.
     if (currentScore == nil) {
-        if ([elementName isEqualToString:@"updateurl"]) {
+        if (element == kUpdateURLElement) {
             //Do some preliminary checks on the supplied URL to make sure it isn't completely insane.
             //NSURLRequest *request = [NSURLRequest requestWithURL:[NSURL URLWithString:currentString]];
             //if ([NSURLConnection canHandleRequest:request]) {
             if ([OpusParser isValidURL:currentString]) {
                 updateURL = [NSString stringWithString:currentString];
             }
-        } else if ([elementName isEqualToString:@"version"]) {
+        } else if (element == kVersionElement) {
             if (currentString != nil) {
                 opusVersion = [NSString stringWithString:currentString];
             }
-        } else if ([elementName isEqualToString:@"formatversion"]) {
+        } else if (element == kFormatVersionElement) {
             if (currentString != nil) {
                 formatVersion = [NSString stringWithString:currentString];
             }
@@ -237,103 +312,141 @@
         isScoreProperty = NO;
         return;
     }
-    if ([elementName isEqualToString:@"name"]) {
-        currentScore.scoreName = [NSString stringWithString:currentString];
-    } else if ([elementName isEqualToString:@"composer"]) {
-        //Multiple composers for a work should be separated by a semicolon. The parser will assume that the
-        //final space separates given names from surnames. This can be overruled by entering the composer in
-        //the format "Surname, Firstname".
-        NSArray *composers = [currentString componentsSeparatedByString:@";"];
-        for (int i = 0; i < [composers count]; i++) {
-            NSString *composer = [[composers objectAtIndex:i] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
-            NSString *firstName, *lastName;
-            NSRange split = [composer rangeOfString:@","];
-            if (split.location != NSNotFound) {
-                firstName = [[composer substringFromIndex:split.location + 1] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
-                lastName = [[composer substringToIndex:split.location] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
-            } else {
-                split = [composer rangeOfString:@" " options:NSBackwardsSearch];
+    switch (element) {
+        case kNameElement:
+            currentScore.scoreName = currentString;
+            break;
+            
+        case kComposerElement:
+        {
+            //Multiple composers for a work should be separated by a semicolon. The parser will assume that the
+            //final space separates given names from surnames. This can be overruled by entering the composer in
+            //the format "Surname, Firstname".
+            NSArray *composers = [currentString componentsSeparatedByString:@";"];
+            for (int i = 0; i < [composers count]; i++) {
+                NSString *composer = [[composers objectAtIndex:i] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+                NSString *firstName, *lastName;
+                NSRange split = [composer rangeOfString:@","];
                 if (split.location != NSNotFound) {
-                    firstName = [composer substringToIndex:split.location];
-                    lastName = [composer substringFromIndex:split.location + 1];
+                    firstName = [[composer substringFromIndex:split.location + 1] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+                    lastName = [[composer substringToIndex:split.location] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
                 } else {
-                    firstName = @"";
-                    lastName = composer;
+                    split = [composer rangeOfString:@" " options:NSBackwardsSearch];
+                    if (split.location != NSNotFound) {
+                        firstName = [composer substringToIndex:split.location];
+                        lastName = [composer substringFromIndex:split.location + 1];
+                    } else {
+                        firstName = @"";
+                        lastName = composer;
+                    }
                 }
+                [currentScore.composers addObject:[NSArray arrayWithObjects:lastName, firstName, nil]];
             }
-            [currentScore.composers addObject:[NSArray arrayWithObjects:lastName, firstName, nil]];
-        }
-    } else if ([elementName isEqualToString:@"type"]) {
-        currentScore.scoreType = [NSString stringWithString:currentString];
-        //Check to see that the renderer type is valid. We do this by checking that it refers to a class
-        //that properly implements the RendererDelegate protocol.
-        rendererClass = NSClassFromString(currentScore.scoreType);
-        if (rendererClass == nil || ![rendererClass conformsToProtocol:@protocol(RendererDelegate)]) {
-            scoreInvalid = YES;
-        }
-    } else if ([elementName isEqualToString:@"variation"]) {
-        currentScore.variationNumber = [currentString integerValue];
-    } else if ([elementName isEqualToString:@"duration"]) {
-        currentScore.originalDuration = [currentString floatValue];
-    } else if ([elementName isEqualToString:@"startoffset"]) {
-        currentScore.startOffset = [currentString integerValue];
-    } else if ([elementName isEqualToString:@"readoffset"]) {
-        currentScore.readLineOffset = [currentString integerValue];
-    } else if ([elementName isEqualToString:@"filename"]) {
-        currentScore.fileName = [NSString stringWithString:currentString];
-        //Check that the file actually exists. (If not set scoreInvalid)
-        if (![fileManager fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentScore.fileName]]) {
-            scoreInvalid = YES;
-        }
-    } else if ([elementName isEqualToString:@"prefsfile"]) {
-        currentScore.prefsFile = [NSString stringWithString:currentString];
-        //Check that the file actually exists. (If not set scoreInvalid)
-        if (![fileManager fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentScore.prefsFile]]) {
-            scoreInvalid = YES;
-        }
-    } else if ([elementName isEqualToString:@"instructions"]) {
-        //Check that the file actually exists. (If not, then ignore and leave the property unset)
-        if ([fileManager fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentString]]) {
-            currentScore.instructions = [NSString stringWithString:currentString];
-        }
-    } else if ([elementName isEqualToString:@"audiofile"]) {
-        //Check that the file actually exists. (If not, then ignore and leave the property unset)
-        if ([fileManager fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentString]]) {
-            currentScore.audioFile = [NSString stringWithString:currentString];
+            break;
         }
-    } else if ([elementName isEqualToString:@"options"]) {
-        if (currentString != nil && [currentString caseInsensitiveCompare:@"yes"] == NSOrderedSame) {
-            currentScore.allowsOptions = YES;
-        }
-    } else if ([elementName isEqualToString:@"part"]) {
-        //Check that the part exists first
-        if ([fileManager fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentString]]) {
-            [currentScore.parts addObject:[NSString stringWithString:currentString]];
-        }
-    } else if ([elementName isEqualToString:@"audiopart"]) {
-        if ([fileManager fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentString]]) {
-            [currentScore.audioParts addObject:[NSString stringWithString:currentString]];
-        }
-    } else if ([elementName isEqualToString:@"manualidentifier"]) {
-        if (currentString != nil && [currentString caseInsensitiveCompare:@"yes"] == NSOrderedSame) {
-            currentScore.askForIdentifier = YES;
-        }
-    } else if ([elementName isEqualToString:@"backgroundrgb"]) {
-        NSArray *colour = [currentString componentsSeparatedByString:@","];
-        //Check that we have three colour components in our array
-        if ([colour count] == 3) {
-            CGFloat r = [[colour objectAtIndex:0] intValue] & 255;
-            CGFloat g = [[colour objectAtIndex:1] intValue] & 255;
-            CGFloat b = [[colour objectAtIndex:2] intValue] & 255;
-            currentScore.backgroundColour = [UIColor colorWithRed:(r / 255) green:(g / 255) blue:(b / 255) alpha:1];
+            
+        case kTypeElement:
+            currentScore.scoreType = currentString;
+            //Check to see that the renderer type is valid. We do this by checking that it refers to a class
+            //that properly implements the RendererDelegate protocol.
+            rendererClass = currentString == nil ? nil : NSClassFromString(currentScore.scoreType);
+            if (rendererClass == nil || ![rendererClass conformsToProtocol:@protocol(RendererDelegate)]) {
+                scoreInvalid = YES;
+            }
+            break;
+            
+        case kVariationElement:
+            currentScore.variationNumber = XMLSpanIntegerValue(text);
+            break;
+            
+        case kDurationElement:
+            currentScore.originalDuration = XMLSpanDoubleValue(text);
+            break;
+            
+        case kStartOffsetElement:
+            currentScore.startOffset = XMLSpanIntegerValue(text);
+            break;
+            
+        case kReadOffsetElement:
+            currentScore.readLineOffset = XMLSpanIntegerValue(text);
+            break;
+            
+        case kFileNameElement:
+            currentScore.fileName = currentString;
+            //Check that the file actually exists. (If not set scoreInvalid)
+            if (currentString == nil || ![ScoreArchive fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentScore.fileName]]) {
+                scoreInvalid = YES;
+            }
+            break;
+            
+        case kPrefsFileElement:
+            currentScore.prefsFile = currentString;
+            //Check that the file actually exists. (If not set scoreInvalid)
+            if (currentString == nil || ![ScoreArchive fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentScore.prefsFile]]) {
+                scoreInvalid = YES;
+            }
+            break;
+            
+        case kInstructionsElement:
+            //Check that the file actually exists. (If not, then ignore and leave the property unset)
+            if (currentString != nil && [ScoreArchive fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentString]]) {
+                currentScore.instructions = currentString;
+            }
+            break;
+            
+        case kAudioFileElement:
+            //Check that the file actually exists. (If not, then ignore and leave the property unset)
+            if (currentString != nil && [ScoreArchive fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentString]]) {
+                currentScore.audioFile = currentString;
+            }
+            break;
+            
+        case kOptionsElement:
+            if (XMLSpanEqualsIgnoringCase(text, "yes")) {
+                currentScore.allowsOptions = YES;
+            }
+            break;
+            
+        case kPartElement:
+            //Check that the part exists first
+            if (currentString != nil && [ScoreArchive fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentString]]) {
+                [currentScore.parts addObject:currentString];
+            }
+            break;
+            
+        case kAudioPartElement:
+            if (currentString != nil && [ScoreArchive fileExistsAtPath:[scorePath stringByAppendingPathComponent:currentString]]) {
+                [currentScore.audioParts addObject:currentString];
+            }
+            break;
+            
+        case kManualIdentifierElement:
+            if (XMLSpanEqualsIgnoringCase(text, "yes")) {
+                currentScore.askForIdentifier = YES;
+            }
+            break;
+            
+        case kBackgroundRGBElement:
+        {
+            XMLSpan colour[3];
+            //Check that we have three colour components
+            if (XMLSpanSplit(text, ',', colour, 3) == 3) {
+                CGFloat r = XMLSpanIntegerValue(colour[0]) & 255;
+                CGFloat g = XMLSpanIntegerValue(colour[1]) & 255;
+                CGFloat b = XMLSpanIntegerValue(colour[2]) & 255;
+                currentScore.backgroundColour = [UIColor colorWithRed:(r / 255) green:(g / 255) blue:(b / 255) alpha:1];
+            }
+            break;
         }
+            
+        default:
+            break;
     }
     isScoreProperty = NO;
 }
 
-- (void)parserDidEndDocument:(NSXMLParser *)parser
+- (void)endDocument
 {
-    [watchdog invalidate];
     //Don't allow the update URL to be set if a version hasn't been provided with the score file.
     if (opusVersion == nil) {
         updateURL = nil;
@@ -350,11 +463,4 @@
     [delegate parserFinished:self withScores:scores];
 }
 
-- (void)parser:(NSXMLParser *)parser parseErrorOccurred:(NSError *)parseError {
-    //NSString *error;
-    //error = [parseError localizedDescription];
-    [watchdog invalidate];
-    [delegate parserError:self];
-}
-
 @end
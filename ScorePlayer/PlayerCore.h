@@ -47,6 +47,9 @@ extern const NSInteger NETWORK_PROTOCOL_VERSION;
 @property (nonatomic, readonly) CGFloat clockLocation;
 @property (nonatomic) BOOL splitSecondMode;
 @property (nonatomic) BOOL allowSyncToTick;
+//How far ahead of time networked play, pause and seek commands are scheduled, so that every
+//device has received them before they take effect.
+@property (nonatomic) NSTimeInterval scheduledControlLeadTime;
 @property (nonatomic, strong, readonly) NSString *identifier;
 @property (nonatomic, weak) id<RendererDelegate> rendererDelegate;
 @property (nonatomic, strong) id<NetworkStatus> networkStatusDelegate;
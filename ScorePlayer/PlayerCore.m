@@ -11,17 +11,25 @@
 #import "Connection.h"
 #import "Score.h"
 #import "LastNetworkAddress.h"
+#import "ScoreClock.h"
+#import "ControlScheduler.h"
 
 
 //Network protocol version. This must be incremented if a change to the protocol breaks
 //backwards compatibility.
+//(v17: Play, Pause and Seek control messages carry the network time they should take effect.)
 
-const NSInteger NETWORK_PROTOCOL_VERSION = 16;
+const NSInteger NETWORK_PROTOCOL_VERSION = 17;
 
-@interface PlayerCore ()
+@interface PlayerCore () <ScoreClockDelegate>
 
 - (void)sendControlSignal:(NSString *)signalType;
 - (void)sendControlSignal:(NSString *)signalType withFloatParameter:(CGFloat)parameter;
+- (void)sendScheduledControlSignal:(NSString *)signalType withFloatParameter:(CGFloat)parameter hasParameter:(BOOL)hasParameter;
+
+- (double)networkTime;
+- (double)networkTimeFromMessage:(OSCMessage *)message atIndex:(NSUInteger)index;
+- (BOOL)performAtNetworkTime:(double)time block:(dispatch_block_t)block;
 
 - (void)playerPlayWithAudio:(BOOL)startAudio;
 - (void)playerReset;
@@ -37,14 +45,18 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
 - (void)disableReconnection;
 - (void)disconnect;
 
-- (void)tick;
 - (void)startClock;
 
 @end
 
 @implementation PlayerCore {
-    NSTimer *clock;
+    ScoreClock *clock;
     NSDate *ntpReferenceDate;
+    
+    //Our estimate of our clock relative to the master's, provided by the primary server,
+    //and any control change waiting to take effect.
+    double masterClockOffset;
+    ControlScheduler *controlScheduler;
     int splitSecond;
     BOOL syncNextTick;
     
@@ -67,7 +79,7 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
     __weak id<PlayerUIDelegate> delegateBackup;
 }
 
-@synthesize isPausable, isStatic, playerState, currentScore, isMaster, clockEnabled, allowClockChange, clockDuration, clockProgress, splitSecondMode, allowSyncToTick, identifier, rendererDelegate, networkStatusDelegate, connectedManually;
+@synthesize isPausable, isStatic, playerState, currentScore, isMaster, clockEnabled, allowClockChange, clockDuration, clockProgress, splitSecondMode, allowSyncToTick, scheduledControlLeadTime, identifier, rendererDelegate, networkStatusDelegate, connectedManually;
 
 - (id)initWithScore:(Score *)score delegate:(__weak id<PlayerUIDelegate>)delegate
 {
@@ -82,6 +94,10 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
     isMaster = YES;
     awaitingStatus = NO;
     syncNextTick = NO;
+    masterClockOffset = 0;
+    scheduledControlLeadTime = 0.15;
+    clock = [[ScoreClock alloc] initWithTickInterval:1 delegate:self];
+    controlScheduler = [[ControlScheduler alloc] init];
     
     //Initialize arrays to store list of connected clients and connections
     networkDevices = [[NSMutableArray alloc] init];
@@ -216,7 +232,7 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
     }
     if (isNetworked) {
         //Play via network message
-        [self sendControlSignal:@"Play"];
+        [self sendScheduledControlSignal:@"Play" withFloatParameter:0 hasParameter:NO];
     } else {
         //Play directly. (Follow the same pattern for all control functions.)
         [self playerPlayWithAudio:YES];
@@ -232,7 +248,7 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
     }
     CGFloat pauseLocation = (clockProgress + 1) / clockDuration;
     if (isNetworked) {
-        [self sendControlSignal:@"Pause" withFloatParameter:pauseLocation];
+        [self sendScheduledControlSignal:@"Pause" withFloatParameter:pauseLocation hasParameter:YES];
     } else {
         [self playerStopAt:pauseLocation];
     }
@@ -250,7 +266,12 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
 - (void)seekTo:(CGFloat)location
 {
     if (isNetworked) {
-        [self sendControlSignal:@"Seek" withFloatParameter:location];
+        //Seeks only need to be synchronised if they happen while we're playing.
+        if (playerState == kPlaying) {
+            [self sendScheduledControlSignal:@"Seek" withFloatParameter:location hasParameter:YES];
+        } else {
+            [self sendControlSignal:@"Seek" withFloatParameter:location];
+        }
     } else {
         [self playerSeekTo:location];
     }
@@ -276,7 +297,7 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
 
 - (void)stopClockWithStateUpdate:(BOOL)updateState
 {
-    [clock invalidate];
+    [clock stop];
     if (updateState) {
         playerState = kStopped;
     }
@@ -284,7 +305,7 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
 
 - (void)resetClock
 {
-    [clock invalidate];
+    [clock stop];
     clockProgress = 0;
     splitSecond = 0;
 }
@@ -345,6 +366,56 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
     [self sendNetworkMessage:message];
 }
 
+- (void)sendScheduledControlSignal:(NSString *)signalType withFloatParameter:(CGFloat)parameter hasParameter:(BOOL)hasParameter
+{
+    //Add the time (in the master's clock) that this should take effect, split into two integers.
+    OSCMessage *message = [[OSCMessage alloc] init];
+    [message appendAddressComponent:@"Control"];
+    [message appendAddressComponent:signalType];
+    if (hasParameter) {
+        [message addFloatArgument:parameter];
+    }
+    double targetTime = [self networkTime] + scheduledControlLeadTime;
+    if (!isMaster) {
+        //Convert to the master's clock, which all scheduled times are relative to.
+        targetTime -= masterClockOffset;
+    }
+    SInt32 *ptr = (SInt32 *)&targetTime;
+    [message addIntegerArgument:*ptr];
+    [message addIntegerArgument:*(ptr + 1)];
+    [self sendNetworkMessage:message];
+}
+
+- (double)networkTime
+{
+    return [[NSDate date] timeIntervalSinceDate:ntpReferenceDate];
+}
+
+- (double)networkTimeFromMessage:(OSCMessage *)message atIndex:(NSUInteger)index
+{
+    double time;
+    SInt32 *ptr = (SInt32 *)&time;
+    *ptr = [message intArgumentAtIndex:index];
+    *(ptr + 1) = [message intArgumentAtIndex:index + 1];
+    return time;
+}
+
+- (BOOL)performAtNetworkTime:(double)time block:(dispatch_block_t)block
+{
+    //Convert the master's time into our own. Returns NO if we're already late, in which case
+    //the block is run immediately. Otherwise it waits its turn behind any earlier controls.
+    double delay = time + (isMaster ? 0 : masterClockOffset) - [self networkTime];
+    if (delay <= 0) {
+        block();
+        return NO;
+    }
+    //Don't let a bad estimate hold up the performance.
+    delay = MIN(delay, scheduledControlLeadTime * 4);
+    
+    [controlScheduler performAtTime:controlScheduler.now + delay block:block];
+    return YES;
+}
+
 - (CGFloat)clockLocation
 {
     if (clockDuration > 0) {
@@ -406,9 +477,10 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
 
 - (void)playerReset
 {
-    //Stop and reset our clock
+    //Stop and reset our clock, and drop any control change that's still waiting.
     playerState = kStopped;
-    [clock invalidate];
+    [controlScheduler cancelAll];
+    [clock stop];
     clockProgress = 0;
     splitSecond = 0;
     
@@ -433,7 +505,7 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
 {
     //TODO: There are some interesting ordering assumptions here from the original code.
     //TODO: Check that these are still valid.
-    [clock invalidate];
+    [clock stop];
     
     //Since clock resolution is only gauranteed to the second, round our value.
     clockProgress = (int)roundf(location * clockDuration);
@@ -558,25 +630,55 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
             if ((playerState == kPlaying) || isStatic) {
                 return;
             }
-            [self playerPlayWithAudio:YES];
+            if ([message.typeTag isEqualToString:@",ii"]) {
+                //Start at the scheduled time so that all devices start together. If the message
+                //arrived too late, resynchronise on the next tick.
+                __weak PlayerCore *weakSelf = self;
+                if (![self performAtNetworkTime:[self networkTimeFromMessage:message atIndex:0] block:^{
+                    PlayerCore *strongSelf = weakSelf;
+                    if (strongSelf != nil && strongSelf.playerState != kPlaying) {
+                        [strongSelf playerPlayWithAudio:YES];
+                    }
+                }]) {
+                    syncNextTick = allowSyncToTick && !isMaster;
+                }
+            } else {
+                [self playerPlayWithAudio:YES];
+            }
         } else if ([[message.address objectAtIndex:1] isEqualToString:@"Reset"]) {
             [self playerReset];
         } else if ([[message.address objectAtIndex:1] isEqualToString:@"Seek"]) {
-            if (![message.typeTag isEqualToString:@",f"]) {
-                return;
+            if ([message.typeTag isEqualToString:@",fii"]) {
+                CGFloat location = [message floatArgumentAtIndex:0];
+                __weak PlayerCore *weakSelf = self;
+                [self performAtNetworkTime:[self networkTimeFromMessage:message atIndex:1] block:^{
+                    [weakSelf playerSeekTo:location];
+                }];
+            } else if ([message.typeTag isEqualToString:@",f"]) {
+                [self playerSeekTo:[message floatArgumentAtIndex:0]];
             }
-            [self playerSeekTo:[[message.arguments objectAtIndex:0] floatValue]];
         } else if ([[message.address objectAtIndex:1] isEqualToString:@"SeekFinished"]) {
             [self playerSeekFinishedAfterResync:NO];
         } else if ([[message.address objectAtIndex:1] isEqualToString:@"Pause"]) {
-            if (![message.typeTag isEqualToString:@",f"]) {
+            if (!([message.typeTag isEqualToString:@",f"] || [message.typeTag isEqualToString:@",fii"])) {
                 return;
             }
             //Check that pausing is possible.
             if (!isPausable || playerState != kPlaying) {
                 return;
             }
-            [self playerStopAt:[[message.arguments objectAtIndex:0] floatValue]];
+            CGFloat location = [message floatArgumentAtIndex:0];
+            if (message.argumentCount == 3) {
+                __weak PlayerCore *weakSelf = self;
+                [self performAtNetworkTime:[self networkTimeFromMessage:message atIndex:1] block:^{
+                    PlayerCore *strongSelf = weakSelf;
+                    if (strongSelf != nil && strongSelf.playerState == kPlaying) {
+                        [strongSelf playerStopAt:location];
+                    }
+                }];
+            } else {
+                [self playerStopAt:location];
+            }
         } else if ([[message.address objectAtIndex:1] isEqualToString:@"SetDuration"]) {
             if (![message.typeTag isEqualToString:@",f"] || playerState != kStopped) {
                 return;
@@ -758,6 +860,12 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
                 }
             }
             networkStatusDelegate.availableScores = commonScores;
+        } else if ([[message.address objectAtIndex:1] isEqualToString:@"ClockOffset"] && !isMaster) {
+            //The primary server's estimate of how far our clock is ahead of the master's.
+            if (![message.typeTag isEqualToString:@",iif"] || [connections indexOfObjectIdenticalTo:connection] != 0) {
+                return;
+            }
+            masterClockOffset = [self networkTimeFromMessage:message atIndex:0];
         } else if ([[message.address objectAtIndex:1] isEqualToString:@"RequestRejected"]) {
             //TODO: Write more code here.
             [UIDelegate errorWithTitle:@"Score Unavailable" message:@"The requested score has become unavailable. Most likely, an iPad without the score just joined the network."];
@@ -913,6 +1021,8 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
 {
     //Close any connections and restart our server if it's not running
     [reconnectionTimer invalidate];
+    [controlScheduler cancelAll];
+    masterClockOffset = 0;
     isMaster = YES;
     [connections makeObjectsPerformSelector:@selector(close)];
     [connections removeAllObjects];
@@ -927,30 +1037,32 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
 }
 
 
-- (void)tick
+#pragma mark - ScoreClock delegate
+
+- (void)scoreClock:(ScoreClock *)scoreClock tick:(NSInteger)tickCount
 {
     if (clockDuration == 0) {
         return;
     }
     
-    //Increment the clock
+    //Our position comes straight from the tick count, so a late tick can't put us behind.
     if (splitSecondMode) {
-        clockProgress += splitSecond;
-        splitSecond++;
-        splitSecond %= 2;
+        clockProgress = (int)(tickCount / 2);
+        splitSecond = tickCount % 2;
     } else {
-        clockProgress++;
+        clockProgress = (int)tickCount;
     }
     
     BOOL finished = NO;
     if (clockProgress >= clockDuration && clockDuration > 0) {
-        [clock invalidate];
+        [clock stop];
         clockProgress = clockDuration;
         playerState = kStopped;
         finished = YES;
     }
     
-    //Send a tick across the network
+    //Send a tick across the network every second. The clock itself doesn't drift, but clients
+    //that are resynchronising (after joining late, say) pick up the next one.
     if (isNetworked && isMaster && !splitSecond) {
         OSCMessage *message = [[OSCMessage alloc] init];
         [message appendAddressComponent:@"Tick"];
@@ -967,18 +1079,15 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
 
 - (void)startClock
 {
-    //Invalidate first so we don't end up with multiple timers.
-    [clock invalidate];
+    //Stop first so that we restart from our current position.
+    [clock stop];
     if (clockProgress < 0) {
         //Make sure we're not in a pre playback area of the score.
         clockProgress = 0;
     }
     if (clockDuration != 0) {
-        if (splitSecondMode) {
-            clock = [NSTimer scheduledTimerWithTimeInterval:0.5 target:self selector:@selector(tick) userInfo:nil repeats:YES];
-        } else {
-            clock = [NSTimer scheduledTimerWithTimeInterval:1 target:self selector:@selector(tick) userInfo:nil repeats:YES];
-        }
+        clock.tickInterval = splitSecondMode ? 0.5 : 1;
+        [clock startAtPosition:clockProgress + splitSecond * clock.tickInterval];
     }
 }
 
@@ -1055,6 +1164,7 @@ const NSInteger NETWORK_PROTOCOL_VERSION = 16;
     //our device. This is done after we receive the protocol version and complete the initial network handshake.
     //(We also hold off on notifying the renderer of the change until this is all completed.)
     isMaster = NO;
+    masterClockOffset = 0;
     [playerServer stop];
     [networkDevices removeAllObjects];
     
@@ -35,6 +35,8 @@
 @property (nonatomic, readonly) BOOL isSecondary;
 @property (nonatomic, strong) NSArray *localScoreList;
 @property (nonatomic, strong) id<PlayerServer2Delegate> delegate;
+//How often clients are pinged to keep their clock estimates up to date once synchronised.
+@property (nonatomic) NSTimeInterval pingInterval;
 
 - (id)initWithName:(NSString *)name deviceName:(NSString *)devName serviceName:(NSString *)serviceName preferredPort:(NSUInteger)preferredPort protocolVersion:(NSInteger)netProtocolVersion;
 
@@ -50,8 +52,6 @@
 - (void)changeName:(NSString *)name;
 
 - (void)sendNetworkMessage:(OSCMessage *)message;
-
-//Testing only
 - (void)sendPing;
 
 @end
@@ -12,6 +12,11 @@
 #import <ifaddrs.h>
 #import <arpa/inet.h>
 #import "OSCMessage.h"
+#import "ClockSync.h"
+
+//Clients are pinged at this rate until they have enough samples for a reliable estimate.
+static const NSTimeInterval CLOCK_SYNC_FAST_INTERVAL = 0.5;
+static const NSUInteger CLOCK_SYNC_FAST_SAMPLES = 8;
 
 @interface PlayerServer2 ()
 
@@ -31,6 +36,9 @@
 - (void)loadScore:(NSArray *)scoreInfo;
 - (void)checkIfLoadComplete;
 - (void)broadCastInfo;
+- (void)startClockSync;
+- (void)stopClockSync;
+- (void)clockSyncTimerFired;
 
 - (void)loadComplete;
 
@@ -40,6 +48,8 @@
 - (BOOL)isIPv4Address:(NSString *)address;
 - (NSString *)getIPv4ForInterfaceWithIPv6Address:(NSString *)address;
 - (void)sendExternalMessage:(OSCMessage *)message toHost:(NSString *)address port:(int)port;
+- (void)sendExternalData:(NSData *)data toHost:(NSString *)address port:(int)port;
+- (void)sendExternalMessageToAll:(OSCMessage *)message;
 
 @end
 
@@ -89,9 +99,13 @@
     NSLock *dictionaryLock;
     
     NSDate *ntpReferenceDate;
+    
+    //Periodic pings used to estimate the clock offset of each client.
+    NSTimer *clockSyncTimer;
+    NSDate *lastPing;
 }
 
-@synthesize serverName, portNumber, isSecondary, delegate;
+@synthesize serverName, portNumber, isSecondary, delegate, pingInterval;
 
 - (id)initWithName:(NSString *)name deviceName:(NSString *)devName serviceName:(NSString *)serviceName preferredPort:(NSUInteger)preferredPort protocolVersion:(NSInteger)netProtocolVersion
 {
@@ -137,6 +151,7 @@
     
     dictionaryLock = [[NSLock alloc] init];
     ntpReferenceDate = [OSCMessage ntpReferenceDate];
+    pingInterval = 2;
     
     return self;
 }
@@ -180,6 +195,7 @@
     
     //Set up our client info broadcast timer.
     [self resumeBroadcastingClientInfo];
+    [self startClockSync];
     return YES;
 }
 
@@ -228,6 +244,7 @@
     [timeOuts makeObjectsPerformSelector:@selector(invalidate)];
     [secondaryTimeOut invalidate];
     [self suspendBroadcastingClientInfo];
+    [self stopClockSync];
     
     if (portNumber == 0) {
         //The server is already stopped.
@@ -320,6 +337,7 @@
     //Establish a new secondary server (if there are any other peers)
     [self promoteNewSecondary:nil];
     [self resumeBroadcastingClientInfo];
+    [self startClockSync];
     
     //Alert our externals that there's a new server then clear the list.
     //Externals will need to respond to this message by re-registering.
@@ -344,13 +362,15 @@
             [ipv4message addIntegerArgument:udpPortNumber];
         }
         
+        NSData *datagram = [message messageAsDataWithHeader:NO];
+        NSData *ipv4Datagram = [ipv4message messageAsDataWithHeader:NO];
         for (NSString *address in oldExternals) {
             for (int i = 0; i < [[oldExternals objectForKey:address] count]; i++) {
                 int port = [[[oldExternals objectForKey:address] objectAtIndex:i] intValue];
                 if (ipv4Address != nil && [self isIPv4Address:address]) {
-                    [self sendExternalMessage:ipv4message toHost:address port:port];
+                    [self sendExternalData:ipv4Datagram toHost:address port:port];
                 } else {
-                    [self sendExternalMessage:message toHost:address port:port];
+                    [self sendExternalData:datagram toHost:address port:port];
                 }
             }
         }
@@ -378,42 +398,40 @@
         serverName = preferredServerName;
         [self startBonjour];
         [self resumeBroadcastingClientInfo];
+        [self startClockSync];
     }
 }
 
 - (void)sendNetworkMessage:(OSCMessage *)message
 {
-    if ([message.address count] < 1) {
+    if (message.addressCount < 1) {
         //No routing information. Discard message.
         return;
     }
-    if ([[message.address objectAtIndex:0] isEqualToString:@"Server"] || [[message.address objectAtIndex:0] isEqualToString:@"Pong"]) {
+    if ([message addressComponentAtIndex:0 isEqualToString:@"Server"] || [message addressComponentAtIndex:0 isEqualToString:@"Pong"]) {
         //Message is from the master to the server. Process here.
         [self processServerMessage:message from:nil isLocal:YES];
     } else if (!isSecondary) {
         //Otherwise, send broadcast message to the clients (currently that's all we're implementing)
         //But only if we're the primary server. Also, don't pass on messages meant only for external devices.
-        if (![[message.address objectAtIndex:0] isEqualToString:@"External"]) {
+        if (![message addressComponentAtIndex:0 isEqualToString:@"External"]) {
             //If a load is in progress, only pass on specific messages.
-            if (!loadInProgress || [[message.address objectAtIndex:0] isEqualToString:@"Score"] || [[message.address objectAtIndex:0] isEqualToString:@"Renderer"]) {
-                [clients makeObjectsPerformSelector:@selector(sendNetworkMessage:) withObject:message];
+            if (!loadInProgress || [message addressComponentAtIndex:0 isEqualToString:@"Score"] || [message addressComponentAtIndex:0 isEqualToString:@"Renderer"]) {
+                //Encode once and share the same frame between all of our clients.
+                if ([clients count] > 0) {
+                    NSData *frame = [message messageAsDataWithHeader:YES];
+                    [clients makeObjectsPerformSelector:@selector(sendFrame:) withObject:frame];
+                }
                 //And include our delegate, the master player if not a ping
-                if (![[message.address objectAtIndex:0] isEqualToString:@"Ping"]) {
+                if (![message addressComponentAtIndex:0 isEqualToString:@"Ping"]) {
                     [delegate receivedNetworkMessage:message];
                 }
             }
         }
         
         //Pass selected message types on to external devices.
-        if ([[message.address objectAtIndex:0] isEqualToString:@"External"] || [[message.address objectAtIndex:0] isEqualToString:@"Control"] || [[message.address objectAtIndex:0] isEqualToString:@"Status"] || [[message.address objectAtIndex:0] isEqualToString:@"Tick"] || [[message.address objectAtIndex:0] isEqualToString:@"Score"]) {
-            [dictionaryLock lock];
-            for (NSString* address in externals) {
-                for (int i = 0; i < [[externals objectForKey:address] count]; i++) {
-                    int port = [[[externals objectForKey:address] objectAtIndex:i] intValue];
-                    [self sendExternalMessage:message toHost:address port:port];
-                }
-            }
-            [dictionaryLock unlock];
+        if ([message addressComponentAtIndex:0 isEqualToString:@"External"] || [message addressComponentAtIndex:0 isEqualToString:@"Control"] || [message addressComponentAtIndex:0 isEqualToString:@"Status"] || [message addressComponentAtIndex:0 isEqualToString:@"Tick"] || [message addressComponentAtIndex:0 isEqualToString:@"Score"]) {
+            [self sendExternalMessageToAll:message];
         }
     }
 }
@@ -428,6 +446,39 @@
     [message addIntegerArgument:*ptr];
     [message addIntegerArgument:*(ptr + 1)];
     [self sendNetworkMessage:message];
+    lastPing = [NSDate date];
+}
+
+- (void)startClockSync
+{
+    [clockSyncTimer invalidate];
+    lastPing = nil;
+    clockSyncTimer = [NSTimer scheduledTimerWithTimeInterval:CLOCK_SYNC_FAST_INTERVAL target:self selector:@selector(clockSyncTimerFired) userInfo:nil repeats:YES];
+}
+
+- (void)stopClockSync
+{
+    [clockSyncTimer invalidate];
+    clockSyncTimer = nil;
+}
+
+- (void)clockSyncTimerFired
+{
+    if (isSecondary || loadInProgress || [clients count] == 0) {
+        return;
+    }
+    
+    //Ping quickly while any client is still being synchronised, then back off to our normal rate.
+    BOOL needsSamples = NO;
+    for (Connection *connection in clients) {
+        if (connection.deviceName != nil && connection.clockSync.sampleCount < CLOCK_SYNC_FAST_SAMPLES) {
+            needsSamples = YES;
+            break;
+        }
+    }
+    if (needsSamples || lastPing == nil || [[NSDate date] timeIntervalSinceDate:lastPing] >= pingInterval) {
+        [self sendPing];
+    }
 }
 
 - (BOOL)serverStart
@@ -473,28 +524,35 @@
 - (void)processServerMessage:(OSCMessage *)message from:(Connection *)sourceConnection isLocal:(BOOL)local
 {
     //Check if we have a ping response first
-    if ([message.address count] == 1 && [[message.address objectAtIndex:0] isEqualToString:@"Pong"]) {
-        if (![message.typeTag isEqualToString:@",iiii"]) {
+    if (message.addressCount == 1 && [message addressComponentAtIndex:0 isEqualToString:@"Pong"]) {
+        if (![message.typeTag isEqualToString:@",iiii"] || sourceConnection == nil) {
             return;
         }
         
-        CGFloat now = [[NSDate date] timeIntervalSinceDate:ntpReferenceDate];
+        double now = [[NSDate date] timeIntervalSinceDate:ntpReferenceDate];
         double startTime, returnTime;
         SInt32 *ptr = (SInt32 *)&startTime;
-        *ptr = [[message.arguments objectAtIndex:0] intValue];
-        *(ptr + 1) = [[message.arguments objectAtIndex:1] intValue];
+        *ptr = [message intArgumentAtIndex:0];
+        *(ptr + 1) = [message intArgumentAtIndex:1];
         ptr = (SInt32 *)&returnTime;
-        *ptr = [[message.arguments objectAtIndex:2] intValue];
-        *(ptr + 1) = [[message.arguments objectAtIndex:3] intValue];
-        //NSLog(@"Ints: %i, %i", *ptr, *(ptr + 1));
+        *ptr = [message intArgumentAtIndex:2];
+        *(ptr + 1) = [message intArgumentAtIndex:3];
         
-        CGFloat delta1 = returnTime - startTime;
-        CGFloat delta2 = now - returnTime;
-        CGFloat offset = (delta1 - delta2) / 2;
-        NSLog(@"%f, %f, %f", startTime, returnTime, now);
-        NSLog(@"Deltas: %f, %f", delta1, delta2);
-        NSLog(@"Total: %f", now - startTime);
-        NSLog(@"Offset: %f", offset);
+        [sourceConnection.clockSync addSampleWithStartTime:startTime remoteTime:returnTime endTime:now];
+        
+        //Let the client know how far its clock is from ours so that it can schedule control changes.
+        if (sourceConnection.clockSync.isSynchronised) {
+            OSCMessage *response = [[OSCMessage alloc] init];
+            [response appendAddressComponent:@"Server"];
+            [response appendAddressComponent:@"ClockOffset"];
+            double offset = [sourceConnection.clockSync offsetAtTime:now];
+            ptr = (SInt32 *)&offset;
+            [response addIntegerArgument:*ptr];
+            [response addIntegerArgument:*(ptr + 1)];
+            [response addFloatArgument:sourceConnection.clockSync.uncertainty];
+            [sourceConnection sendNetworkMessage:response];
+        }
+        return;
     }
     
     //There should always be a method specified in a server message.
@@ -986,10 +1044,11 @@
         [appDelegate manageUdpShutdown:udpSocket goodbyeMessage:message destinations:externals];
     } else {
         //Handle it ourselves
+        NSData *datagram = [message messageAsDataWithHeader:NO];
         for (NSString* address in externals) {
             for (int i = 0; i < [[externals objectForKey:address] count]; i++) {
                 int port = [[[externals objectForKey:address] objectAtIndex:i] intValue];
-                [self sendExternalMessage:message toHost:address port:port];
+                [self sendExternalData:datagram toHost:address port:port];
             }
         }
     }
@@ -1122,15 +1181,7 @@
     OSCMessage *message = [[OSCMessage alloc] init];
     [message appendAddressComponent:@"Server"];
     [message appendAddressComponent:@"LoadComplete"];
-
-    [dictionaryLock lock];
-    for (NSString *address in externals) {
-        for (int i = 0; i < [[externals objectForKey:address] count]; i++) {
-            int port = [[[externals objectForKey:address] objectAtIndex:i] intValue];
-            [self sendExternalMessage:message toHost:address port:port];
-        }
-    }
-    [dictionaryLock unlock];
+    [self sendExternalMessageToAll:message];
 }
 
 - (OSCMessage *)getClientListMessage
@@ -1209,12 +1260,36 @@
 
 - (void)sendExternalMessage:(OSCMessage *)message toHost:(NSString *)address port:(int)port
 {
+    [self sendExternalData:[message messageAsDataWithHeader:NO] toHost:address port:port];
+}
+
+- (void)sendExternalData:(NSData *)data toHost:(NSString *)address port:(int)port
+{
+    if (data == nil) {
+        return;
+    }
     if ([address hasPrefix:@"fe80::"]) {
         //If we have a link local address, send via our wifi interface.
         //(We should have a better way of finding this rather than assuming it will be en0.)
         address = [address stringByAppendingString:@"%en0"];
     }
-    [udpSocket sendData:[message messageAsDataWithHeader:NO] toHost:address port:port withTimeout:-1 tag:0];
+    [udpSocket sendData:data toHost:address port:port withTimeout:-1 tag:0];
+}
+
+- (void)sendExternalMessageToAll:(OSCMessage *)message
+{
+    //Encode the datagram once and share it between every registered external.
+    [dictionaryLock lock];
+    if ([externals count] > 0) {
+        NSData *datagram = [message messageAsDataWithHeader:NO];
+        for (NSString *address in externals) {
+            for (int i = 0; i < [[externals objectForKey:address] count]; i++) {
+                int port = [[[externals objectForKey:address] objectAtIndex:i] intValue];
+                [self sendExternalData:datagram toHost:address port:port];
+            }
+        }
+    }
+    [dictionaryLock unlock];
 }
 
 #pragma mark - GCDAsyncSocket delegate
@@ -1270,7 +1345,7 @@
         return;
     }
     
-    if ([[NSString stringWithUTF8String:[data bytes]] isEqualToString:@"#bundle"]) {
+    if ([OSCMessage isBundle:data]) {
         //We have a bundle and need to process it.
         NSArray *messages = [OSCMessage processBundle:data];
         if (messages == nil) {
@@ -1280,15 +1355,17 @@
             [message appendAddressComponent:@"Malformed"];
             [self receivedNetworkMessage:message overConnection:nil];
         } else {
-            for (int i = 0; i < [messages count]; i++) {
+            NSString *host = [GCDAsyncUdpSocket hostFromAddress:address];
+            for (OSCMessage *message in messages) {
                 //If this is a message for the server to respond to, add our address data.
-                if ([((OSCMessage *)[messages objectAtIndex:i]).address count] >= 1 && [[((OSCMessage *)[messages objectAtIndex:i]).address objectAtIndex:0] isEqualToString:@"Server"]) {
-                    [[messages objectAtIndex:i] addStringArgument:[GCDAsyncUdpSocket hostFromAddress:address]];
+                BOOL isServerMessage = [message addressComponentAtIndex:0 isEqualToString:@"Server"];
+                if (isServerMessage) {
+                    [message addStringArgument:host];
                 }
                 
                 //Unless this is a registration message, check that our message is coming from one of our registered externals.
-                if (([((OSCMessage *)[messages objectAtIndex:i]).address count] >= 2 && [[((OSCMessage *)[messages objectAtIndex:i]).address objectAtIndex:0] isEqualToString:@"Server"] && [[((OSCMessage *)[messages objectAtIndex:i]).address objectAtIndex:1] isEqualToString:@"RegisterExternal"]) || ([externals objectForKey:[GCDAsyncUdpSocket hostFromAddress:address]] != nil)) {
-                    [self receivedNetworkMessage:[messages objectAtIndex:i] overConnection:nil];
+                if ((isServerMessage && [message addressComponentAtIndex:1 isEqualToString:@"RegisterExternal"]) || ([externals objectForKey:host] != nil)) {
+                    [self receivedNetworkMessage:message overConnection:nil];
                 }
             }
         }
@@ -1299,10 +1376,12 @@
             message = [[OSCMessage alloc] init];
             [message appendAddressComponent:@"Malformed"];
         } else {
-            if ([message.address count] >= 1 && [[message.address objectAtIndex:0] isEqualToString:@"Server"]) {
-                [message addStringArgument:[GCDAsyncUdpSocket hostFromAddress:address]];
+            NSString *host = [GCDAsyncUdpSocket hostFromAddress:address];
+            BOOL isServerMessage = [message addressComponentAtIndex:0 isEqualToString:@"Server"];
+            if (isServerMessage) {
+                [message addStringArgument:host];
             }
-            if (([message.address count] >= 2 && [[message.address objectAtIndex:0] isEqualToString:@"Server"] && [[message.address objectAtIndex:1] isEqualToString:@"RegisterExternal"]) || ([externals objectForKey:[GCDAsyncUdpSocket hostFromAddress:address]] != nil)) {
+            if ((isServerMessage && [message addressComponentAtIndex:1 isEqualToString:@"RegisterExternal"]) || ([externals objectForKey:host] != nil)) {
                 [self receivedNetworkMessage:message overConnection:nil];
             }
         }
@@ -1315,13 +1394,13 @@
 {
     //Perform checks to see if the message conforms to the most basic standards
     //(At least one address component.)
-    if ([message.address count] < 1) {
+    if (message.addressCount < 1) {
         return;
     }
     
     //Check to see if the message is intended for the server object to process
     //If not, broadcast to all clients
-    if ([[message.address objectAtIndex:0] isEqualToString:@"Server"] || [[message.address objectAtIndex:0] isEqualToString:@"Pong"]) {
+    if ([message addressComponentAtIndex:0 isEqualToString:@"Server"] || [message addressComponentAtIndex:0 isEqualToString:@"Pong"]) {
         [self processServerMessage:message from:sourceConnection isLocal:NO];
     } else {
         if ((sourceConnection != nil && sourceConnection.deviceName == nil)) {
@@ -1330,7 +1409,7 @@
         }
         if (sourceConnection == nil) {
             //Also limit the sort of messages that external devices can send.
-            if (!([[message.address objectAtIndex:0] isEqualToString:@"Control"] || [[message.address objectAtIndex:0] isEqualToString:@"Renderer"] || [[message.address objectAtIndex:0] isEqualToString:@"Master"])) {
+            if (!([message addressComponentAtIndex:0 isEqualToString:@"Control"] || [message addressComponentAtIndex:0 isEqualToString:@"Renderer"] || [message addressComponentAtIndex:0 isEqualToString:@"Master"])) {
                 return;
             }
         }
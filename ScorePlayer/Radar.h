@@ -9,8 +9,6 @@
 #import <Foundation/Foundation.h>
 #import "Renderer.h"
 
-static const NSInteger RADAR_FRAMERATE = 25;
-
 @interface Radar : NSObject <NSXMLParserDelegate, RendererDelegate> {
     BOOL isMaster;
 }
@@ -8,10 +8,11 @@
 
 #import "Radar.h"
 #import "Score.h"
+#import "FrameClock.h"
+#import "ScoreArchive.h"
 
-@interface Radar ()
+@interface Radar () <FrameClockSubscriber>
 
-- (void)animate;
 - (void)enableHighResTimer:(BOOL)enabled;
 - (UIBezierPath *)getRadarSweepPathForAngle:(CGFloat)angle;
 - (void)initLayers;
@@ -24,12 +25,14 @@
     CALayer *background;
     CAShapeLayer *radarSweep;
     UIColor *sweepColour;
-    NSTimer *highRes;
+    BOOL animating;
+    CFTimeInterval animationStartTime;
+    CGFloat animationStartDistance;
     
     NSInteger lineLength;
     CGPoint origin;
     
-    CGFloat anglePerFrame;
+    CGFloat anglePerSecond;
     CGFloat currentAngle;
     
     CGFloat angleOffset;
@@ -50,17 +53,31 @@
 
 @synthesize isMaster;
 
-- (void)animate
+- (void)animateToTime:(CFTimeInterval)frameTime
 {
-    currentAngle += (anglePerFrame * currentDirection);
+    //Work out how far the sweep has travelled since we started. On the return leg of a
+    //bidirectional sweep, this is more than a full set of rotations.
+    CGFloat fullSweep = 360 * rotations;
+    CGFloat distance = animationStartDistance + anglePerSecond * MAX(frameTime - animationStartTime, 0);
+    BOOL finished = NO;
+    
+    if (fabs(distance) < fabs(fullSweep)) {
+        currentAngle = distance;
+        currentDirection = 1;
+    } else if (!bidirectional) {
+        currentAngle = fullSweep;
+        finished = YES;
+    } else if (fabs(distance) < fabs(2 * fullSweep)) {
+        currentAngle = 2 * fullSweep - distance;
+        currentDirection = -1;
+    } else {
+        currentAngle = 0;
+        currentDirection = -1;
+        finished = YES;
+    }
+    
     radarSweep.path = [self getRadarSweepPathForAngle:(currentAngle + angleOffset)].CGPath;
-    if (fabs(currentAngle) >= fabs(360 * rotations)) {
-        if (bidirectional) {
-            currentDirection = -1;
-        } else {
-            [self enableHighResTimer:NO];
-        }
-    } else if (bidirectional && ((anglePerFrame > 0 && currentAngle <= 0) || (anglePerFrame < 0 && currentAngle >= 0))) {
+    if (finished) {
         [self enableHighResTimer:NO];
     }
 }
@@ -68,14 +85,17 @@
 - (void)enableHighResTimer:(BOOL)enabled
 {
     if (enabled) {
-        if (highRes == nil || !highRes.isValid) {
-            //Don't start a new timer if there is already a valid high resolution timer running.
-            highRes = [NSTimer scheduledTimerWithTimeInterval:(1.0 / RADAR_FRAMERATE) target:self selector:@selector(animate) userInfo:nil repeats:YES];
+        if (!animating) {
+            //Don't restart our animation if it's already running.
+            animationStartTime = [[FrameClock sharedClock] currentTime];
+            animationStartDistance = currentDirection < 0 ? 2 * 360 * rotations - currentAngle : currentAngle;
+            [[FrameClock sharedClock] addSubscriber:self];
+            animating = YES;
         }
     } else {
-        if (highRes != nil) {
-            [highRes invalidate];
-            highRes = nil;
+        if (animating) {
+            [[FrameClock sharedClock] removeSubscriber:self];
+            animating = NO;
         }
     }
 }
@@ -142,12 +162,12 @@
     UIDelegate.allowClockChange = NO;
     
     lineLength = sqrt(pow(canvas.bounds.size.width, 2) + pow(canvas.bounds.size.height, 2)) + 10;
-    anglePerFrame = 360.0 * rotations / (UIDelegate.clockDuration * RADAR_FRAMERATE);
+    anglePerSecond = 360.0 * rotations / UIDelegate.clockDuration;
     
     prefsCondition = [NSCondition new];
     if (score.prefsFile != nil) {
         NSString *prefsFile = [score.scorePath stringByAppendingPathComponent:score.prefsFile];
-        NSData *prefsData = [[NSData alloc] initWithContentsOfFile:prefsFile];
+        NSData *prefsData = [ScoreArchive dataWithContentsOfFile:prefsFile];
         xmlParser = [[NSXMLParser alloc] initWithData:prefsData];
         
         isData = NO;
@@ -253,7 +273,7 @@
         //Make sure this is a non-zero value.
         if ([currentString floatValue] != 0) {
             rotations = [currentString floatValue];
-            anglePerFrame = 360.0 * rotations / (UIDelegate.clockDuration * RADAR_FRAMERATE);
+            anglePerSecond = 360.0 * rotations / UIDelegate.clockDuration;
         }
     } else if ([elementName isEqualToString:@"sweeprgb"]) {
         NSArray *colour = [currentString componentsSeparatedByString:@","];
@@ -275,7 +295,7 @@
 - (void)parserDidEndDocument:(NSXMLParser *)parser
 {
     if (bidirectional) {
-        anglePerFrame *= 2;
+        anglePerSecond *= 2;
     }
     
     [prefsCondition lock];
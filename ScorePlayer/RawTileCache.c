@@ -0,0 +1,322 @@
+//
+//  RawTileCache.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "RawTileCache.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RAW_TILE_MAGIC "DBRAWTIL"
+#define RAW_TILE_VERSION 1
+//Pixels start on a page boundary (16KB on 64 bit iOS devices) so that they can be handed
+//straight to Core Graphics from the mapping.
+#define RAW_TILE_HEADER_LENGTH 16384
+#define RAW_TILE_HASH_SPAN 4096
+//Temporary files older than this were left behind by a write that never finished.
+#define RAW_TILE_STALE_TEMPORARY_SECONDS 3600
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerLength;
+    RawTileFormat format;
+    RawTileSource source;
+    uint64_t pixelLength;
+} RawTileHeader;
+
+typedef struct {
+    char *path;
+    uint64_t size;
+    int64_t modified;
+} CacheFile;
+
+static uint64_t hashBytes(uint64_t hash, const uint8_t *bytes, size_t length)
+{
+    //FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool readFully(int fd, void *buffer, size_t length, off_t offset)
+{
+    uint8_t *position = buffer;
+    while (length > 0) {
+        ssize_t count = pread(fd, position, length, offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        position += count;
+        length -= count;
+        offset += count;
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const void *buffer, size_t length)
+{
+    const uint8_t *position = buffer;
+    while (length > 0) {
+        ssize_t count = write(fd, position, length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        position += count;
+        length -= count;
+    }
+    return true;
+}
+
+static void modificationTime(const struct stat *status, int64_t *seconds, int64_t *nanoseconds)
+{
+#ifdef __APPLE__
+    *seconds = status->st_mtimespec.tv_sec;
+    *nanoseconds = status->st_mtimespec.tv_nsec;
+#else
+    *seconds = status->st_mtim.tv_sec;
+    *nanoseconds = status->st_mtim.tv_nsec;
+#endif
+}
+
+bool RawTileSourceRead(const char *sourcePath, RawTileSource *source)
+{
+    int fd = open(sourcePath, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return false;
+    }
+
+    memset(source, 0, sizeof(RawTileSource));
+    source->size = (uint64_t)status.st_size;
+    modificationTime(&status, &source->modifiedSeconds, &source->modifiedNanoseconds);
+
+    //Hash the start and the end of the file. That's where the headers and the final
+    //compressed data of an image are, and it's cheap compared to hashing everything.
+    uint8_t buffer[RAW_TILE_HASH_SPAN];
+    uint64_t hash = 14695981039346656037ULL;
+    size_t headLength = source->size < RAW_TILE_HASH_SPAN ? (size_t)source->size : RAW_TILE_HASH_SPAN;
+    bool success = readFully(fd, buffer, headLength, 0);
+    hash = hashBytes(hash, buffer, headLength);
+    if (success && source->size > RAW_TILE_HASH_SPAN) {
+        uint64_t tailStart = source->size > 2 * RAW_TILE_HASH_SPAN ? source->size - RAW_TILE_HASH_SPAN : RAW_TILE_HASH_SPAN;
+        size_t tailLength = (size_t)(source->size - tailStart);
+        success = readFully(fd, buffer, tailLength, (off_t)tailStart);
+        hash = hashBytes(hash, buffer, tailLength);
+    }
+    close(fd);
+    source->hash = hash;
+    return success;
+}
+
+void RawTileNameForSource(const char *sourcePath, char *name)
+{
+    uint64_t hash = hashBytes(14695981039346656037ULL, (const uint8_t *)sourcePath, strlen(sourcePath));
+    snprintf(name, RAW_TILE_NAME_LENGTH, "%016llx.raw", (unsigned long long)hash);
+}
+
+bool RawTileWrite(const char *path, const RawTileSource *source, const RawTileFormat *format, const uint8_t *pixels)
+{
+    if (format->rowBytes < format->width * 4 || format->height == 0) {
+        return false;
+    }
+
+    size_t pathLength = strlen(path);
+    char *temporaryPath = malloc(pathLength + 8);
+    if (temporaryPath == NULL) {
+        return false;
+    }
+    snprintf(temporaryPath, pathLength + 8, "%s.XXXXXX", path);
+    int fd = mkstemp(temporaryPath);
+    if (fd < 0) {
+        free(temporaryPath);
+        return false;
+    }
+
+    uint8_t *header = calloc(1, RAW_TILE_HEADER_LENGTH);
+    bool success = header != NULL;
+    if (success) {
+        RawTileHeader details;
+        memset(&details, 0, sizeof(RawTileHeader));
+        memcpy(details.magic, RAW_TILE_MAGIC, sizeof(details.magic));
+        details.version = RAW_TILE_VERSION;
+        details.headerLength = RAW_TILE_HEADER_LENGTH;
+        details.format = *format;
+        details.source = *source;
+        details.pixelLength = (uint64_t)format->rowBytes * format->height;
+        memcpy(header, &details, sizeof(RawTileHeader));
+        success = writeFully(fd, header, RAW_TILE_HEADER_LENGTH) && writeFully(fd, pixels, (size_t)details.pixelLength);
+    }
+    free(header);
+
+    if (close(fd) != 0) {
+        success = false;
+    }
+    if (success) {
+        success = rename(temporaryPath, path) == 0;
+    }
+    if (!success) {
+        unlink(temporaryPath);
+    }
+    free(temporaryPath);
+    return success;
+}
+
+RawTile *RawTileOpen(const char *path, const RawTileSource *source)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat status;
+    RawTileHeader header;
+    if (fstat(fd, &status) != 0 || status.st_size < RAW_TILE_HEADER_LENGTH || !readFully(fd, &header, sizeof(RawTileHeader), 0)) {
+        close(fd);
+        return NULL;
+    }
+
+    //Check that this is one of ours, that it's complete and that it came from the same source.
+    if (memcmp(header.magic, RAW_TILE_MAGIC, sizeof(header.magic)) != 0 || header.version != RAW_TILE_VERSION || header.headerLength != RAW_TILE_HEADER_LENGTH || header.pixelLength != (uint64_t)header.format.rowBytes * header.format.height || (uint64_t)status.st_size != RAW_TILE_HEADER_LENGTH + header.pixelLength || header.source.size != source->size || header.source.modifiedSeconds != source->modifiedSeconds || header.source.modifiedNanoseconds != source->modifiedNanoseconds || header.source.hash != source->hash) {
+        close(fd);
+        return NULL;
+    }
+
+    void *mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    //Mark the entry as recently used for trimming.
+    futimens(fd, NULL);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    RawTile *tile = malloc(sizeof(RawTile));
+    if (tile == NULL) {
+        munmap(mapping, (size_t)status.st_size);
+        return NULL;
+    }
+    tile->format = header.format;
+    tile->pixels = (const uint8_t *)mapping + RAW_TILE_HEADER_LENGTH;
+    tile->pixelLength = (size_t)header.pixelLength;
+    tile->mapping = mapping;
+    tile->mappingLength = (size_t)status.st_size;
+    return tile;
+}
+
+void RawTileClose(RawTile *tile)
+{
+    if (tile == NULL) {
+        return;
+    }
+    munmap(tile->mapping, tile->mappingLength);
+    free(tile);
+}
+
+static int compareCacheFiles(const void *first, const void *second)
+{
+    int64_t a = ((const CacheFile *)first)->modified;
+    int64_t b = ((const CacheFile *)second)->modified;
+    return (a > b) - (a < b);
+}
+
+uint64_t RawTileTrimDirectory(const char *directory, uint64_t byteLimit)
+{
+    DIR *directoryStream = opendir(directory);
+    if (directoryStream == NULL) {
+        return 0;
+    }
+
+    size_t count = 0;
+    size_t capacity = 64;
+    CacheFile *files = malloc(capacity * sizeof(CacheFile));
+    uint64_t total = 0;
+    uint64_t removed = 0;
+    time_t now = time(NULL);
+    size_t directoryLength = strlen(directory);
+
+    struct dirent *item;
+    while (files != NULL && (item = readdir(directoryStream)) != NULL) {
+        size_t nameLength = strlen(item->d_name);
+        bool isEntry = nameLength == RAW_TILE_NAME_LENGTH - 1 && strcmp(item->d_name + nameLength - 4, ".raw") == 0;
+        bool isTemporary = !isEntry && nameLength > RAW_TILE_NAME_LENGTH && strncmp(item->d_name + RAW_TILE_NAME_LENGTH - 5, ".raw.", 5) == 0;
+        if (!isEntry && !isTemporary) {
+            continue;
+        }
+
+        char *path = malloc(directoryLength + nameLength + 2);
+        if (path == NULL) {
+            continue;
+        }
+        snprintf(path, directoryLength + nameLength + 2, "%s/%s", directory, item->d_name);
+        struct stat status;
+        if (stat(path, &status) != 0) {
+            free(path);
+            continue;
+        }
+        int64_t modified, nanoseconds;
+        modificationTime(&status, &modified, &nanoseconds);
+
+        if (isTemporary) {
+            //Clear out anything left behind by an interrupted write.
+            if (now - modified > RAW_TILE_STALE_TEMPORARY_SECONDS && unlink(path) == 0) {
+                removed += (uint64_t)status.st_size;
+            }
+            free(path);
+            continue;
+        }
+
+        if (count == capacity) {
+            CacheFile *larger = realloc(files, capacity * 2 * sizeof(CacheFile));
+            if (larger == NULL) {
+                free(path);
+                break;
+            }
+            files = larger;
+            capacity *= 2;
+        }
+        files[count].path = path;
+        files[count].size = (uint64_t)status.st_size;
+        files[count].modified = modified;
+        total += files[count].size;
+        count++;
+    }
+    closedir(directoryStream);
+
+    if (files == NULL) {
+        return removed;
+    }
+
+    qsort(files, count, sizeof(CacheFile), compareCacheFiles);
+    for (size_t i = 0; i < count; i++) {
+        if (total > byteLimit && unlink(files[i].path) == 0) {
+            total -= files[i].size;
+            removed += files[i].size;
+        }
+        free(files[i].path);
+    }
+    free(files);
+    return removed;
+}
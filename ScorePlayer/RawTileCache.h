@@ -0,0 +1,66 @@
+//
+//  RawTileCache.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//An on-disk cache of decoded images. Each image is stored as raw pixels behind a small header,
+//and is memory mapped when it's opened, so getting it back on screen is a matter of paging
+//it in rather than inflating and unfiltering a PNG. Entries remember the size, modification
+//time and a hash of the ends of the file they were decoded from, and are ignored once the
+//source changes. The cache is trimmed to a byte limit, least recently used first.
+
+#ifndef RawTileCache_h
+#define RawTileCache_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t rowBytes;
+    //The CGBitmapInfo the pixels were written with. Stored but not interpreted.
+    uint32_t bitmapInfo;
+} RawTileFormat;
+
+typedef struct {
+    uint64_t size;
+    int64_t modifiedSeconds;
+    int64_t modifiedNanoseconds;
+    uint64_t hash;
+} RawTileSource;
+
+typedef struct {
+    RawTileFormat format;
+    const uint8_t *pixels;
+    size_t pixelLength;
+    //The whole mapping, for unmapping.
+    void *mapping;
+    size_t mappingLength;
+} RawTile;
+
+//Reads the details of a source image file. Returns false if it can't be read.
+bool RawTileSourceRead(const char *sourcePath, RawTileSource *source);
+
+//The name of the cache file (not including the directory) used for a source path. The buffer
+//must hold at least RAW_TILE_NAME_LENGTH bytes.
+#define RAW_TILE_NAME_LENGTH 21
+void RawTileNameForSource(const char *sourcePath, char *name);
+
+//Writes a cache file via a temporary file, so a partly written entry is never read.
+bool RawTileWrite(const char *path, const RawTileSource *source, const RawTileFormat *format, const uint8_t *pixels);
+
+//Maps a cache file if it exists and matches the source. Returns NULL otherwise. Opening
+//an entry marks it as recently used.
+RawTile *RawTileOpen(const char *path, const RawTileSource *source);
+void RawTileClose(RawTile *tile);
+
+//Deletes the least recently used cache files in a directory until the total is no more than
+//the byte limit. Returns the number of bytes removed.
+uint64_t RawTileTrimDirectory(const char *directory, uint64_t byteLimit);
+
+#endif /* RawTileCache_h */
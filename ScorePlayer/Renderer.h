@@ -163,12 +163,26 @@ static const NSInteger LOWER_PADDING = 52;
 @interface Renderer : NSObject
 
 //Image caching functions. (Works around UIImage only caching files in the app bundle directory.)
+//The cache is limited to a byte budget based on the decoded size of each image, and the least
+//recently used images are dropped first. Images that are on screen can be pinned to keep them.
+//Images are fully decoded before they're added, so cachedImage: does all of its work up front.
 + (UIImage *)cachedImage:(NSString *)fileName;
++ (UIImage *)cachedImageIfPresent:(NSString *)fileName;
++ (void)addImageToCache:(UIImage *)image forFileName:(NSString *)fileName;
++ (BOOL)pinCachedImage:(NSString *)fileName;
++ (void)unpinCachedImage:(NSString *)fileName;
 + (void)removeDirectoryFromCache:(NSString *)path;
 + (void)clearCache;
++ (void)setImageCacheBudget:(NSUInteger)bytes;
++ (NSDictionary *)imageCacheStatistics;
 
 + (NSMutableArray *)getDecibelColours;
 + (CGSize)getImageSize:(NSString *)fileName;
+//Returns NSValues holding the size of each file, in order. Any that need reading from disk are
+//read in parallel, so use this when checking a whole set of images.
++ (NSArray *)getImageSizes:(NSArray *)fileNames;
+//Always reads the size from the image file itself.
++ (CGSize)readImageSize:(NSString *)fileName;
 + (UIImage *)defaultThumbnail:(NSString *)imageFile ofSize:(CGSize)size;
 + (NSString *)getAnnotationsDirectoryForScore:(Score *)score;
 + (UIImage *)rotateImage:(UIImage *)image byRadians:(CGFloat)radians;
@@ -7,53 +7,137 @@
 //
 
 #import "Renderer.h"
-#import <ImageIO/ImageIO.h>
 #import "Score.h"
 
-static NSMutableDictionary *imageCache;
+#import "ImageCache.h"
+#import "DecodeService.h"
+#import "CompiledScore.h"
+#import "ImageSizeIndex.h"
+#import "ScoreArchive.h"
+
+static ImageCache *imageCache;
+static NSLock *imageCacheLock;
+
+static void releaseCachedImage(void *value, void *userData)
+{
+    CFBridgingRelease(value);
+}
+
+@interface Renderer ()
+
++ (void)initImageCache;
+
+@end
 
 @implementation Renderer
 
++ (void)initImageCache
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        //By default, allow decoded images to take up to a quarter of the device's memory.
+        imageCache = ImageCacheCreate([NSProcessInfo processInfo].physicalMemory / 4, releaseCachedImage, NULL);
+        imageCacheLock = [[NSLock alloc] init];
+    });
+}
+
 + (UIImage *)cachedImage:(NSString *)fileName
 {
-    //Check to see if the cache already exists and if the requested image has already been loaded
-    UIImage *image;
-    if (imageCache == nil) {
-        imageCache = [[NSMutableDictionary alloc] init];
-    } else {
-        image = [imageCache objectForKey:fileName];
-        if (image != nil) {
-            return image;
-        }
+    //Check to see if the requested image has already been loaded
+    UIImage *image = [self cachedImageIfPresent:fileName];
+    if (image != nil) {
+        return image;
     }
     
-    //Otherwise load the image
-    image = [UIImage imageWithContentsOfFile:fileName];
-    if (image != nil) {
-        [imageCache setObject:image forKey:fileName];
+    //Otherwise load the image, decoding it now rather than when it's first drawn.
+    image = [DecodeService decodedImageWithContentsOfFile:fileName];
+    [self addImageToCache:image forFileName:fileName];
+    return image;
+}
+
++ (UIImage *)cachedImageIfPresent:(NSString *)fileName
+{
+    if (fileName == nil) {
+        return nil;
     }
+    [self initImageCache];
+    [imageCacheLock lock];
+    //Retain the image before unlocking in case it's evicted by another thread.
+    UIImage *image = (__bridge UIImage *)ImageCacheGet(imageCache, [fileName UTF8String]);
+    [imageCacheLock unlock];
     return image;
 }
 
-+ (void)removeDirectoryFromCache:(NSString *)path
++ (void)addImageToCache:(UIImage *)image forFileName:(NSString *)fileName
 {
-    //If our cache doesn't exist then we have nothing to do here
-    if (imageCache == nil) {
+    if (image == nil || fileName == nil) {
         return;
     }
-    
+    //The cost of an image is the memory it takes up once decoded.
+    [self initImageCache];
+    size_t cost = CGImageGetBytesPerRow(image.CGImage) * CGImageGetHeight(image.CGImage);
+    [imageCacheLock lock];
+    ImageCacheInsert(imageCache, [fileName UTF8String], (__bridge_retained void *)image, cost);
+    [imageCacheLock unlock];
+}
+
++ (BOOL)pinCachedImage:(NSString *)fileName
+{
+    [self initImageCache];
+    [imageCacheLock lock];
+    BOOL pinned = ImageCachePin(imageCache, [fileName UTF8String]);
+    [imageCacheLock unlock];
+    return pinned;
+}
+
++ (void)unpinCachedImage:(NSString *)fileName
+{
+    [self initImageCache];
+    [imageCacheLock lock];
+    ImageCacheUnpin(imageCache, [fileName UTF8String]);
+    [imageCacheLock unlock];
+}
+
++ (void)removeDirectoryFromCache:(NSString *)path
+{
     //Remove any images from the cache in the given directory
-    NSArray *imageFiles = [imageCache allKeys];
-    for (int i = 0; i < [imageFiles count]; i++) {
-        if ([[imageFiles objectAtIndex:i] hasPrefix:path]) {
-            [imageCache removeObjectForKey:[imageFiles objectAtIndex:i]];
-        }
-    }
+    [self initImageCache];
+    [imageCacheLock lock];
+    ImageCacheRemoveDirectory(imageCache, [path UTF8String]);
+    [imageCacheLock unlock];
 }
 
 + (void)clearCache
 {
-    [imageCache removeAllObjects];
+    [self initImageCache];
+    [imageCacheLock lock];
+    ImageCacheRemoveAll(imageCache);
+    [imageCacheLock unlock];
+}
+
++ (void)setImageCacheBudget:(NSUInteger)bytes
+{
+    [self initImageCache];
+    [imageCacheLock lock];
+    ImageCacheSetByteBudget(imageCache, bytes);
+    [imageCacheLock unlock];
+}
+
++ (NSDictionary *)imageCacheStatistics
+{
+    [self initImageCache];
+    [imageCacheLock lock];
+    ImageCacheStatistics statistics = ImageCacheGetStatistics(imageCache);
+    [imageCacheLock unlock];
+    NSMutableDictionary *result = [[NSMutableDictionary alloc] init];
+    [result setObject:[NSNumber numberWithUnsignedLong:statistics.hits] forKey:@"hits"];
+    [result setObject:[NSNumber numberWithUnsignedLong:statistics.misses] forKey:@"misses"];
+    [result setObject:[NSNumber numberWithUnsignedLong:statistics.evictions] forKey:@"evictions"];
+    [result setObject:[NSNumber numberWithUnsignedLong:statistics.entryCount] forKey:@"entryCount"];
+    [result setObject:[NSNumber numberWithUnsignedLong:statistics.bytesUsed] forKey:@"bytesUsed"];
+    [result setObject:[NSNumber numberWithUnsignedLong:statistics.pinnedBytes] forKey:@"pinnedBytes"];
+    [result setObject:[NSNumber numberWithUnsignedLong:statistics.byteBudget] forKey:@"byteBudget"];
+    return result;
 }
 
 + (NSMutableArray *)getDecibelColours
@@ -70,28 +154,38 @@ static NSMutableDictionary *imageCache;
 
 + (CGSize)getImageSize:(NSString *)fileName
 {
-    //Return the dimensions of an image without loading it into memory.
-    NSURL *imageFileURL = [NSURL fileURLWithPath:fileName];
-    CGImageSourceRef imageSource = CGImageSourceCreateWithURL((__bridge CFURLRef)imageFileURL, NULL);
-    
-    if (imageSource == NULL) {
-        //Something has gone wrong. Return a zero size.
-        return CGSizeMake(0, 0);
+    return [[[self getImageSizes:[NSArray arrayWithObject:fileName]] objectAtIndex:0] CGSizeValue];
+}
+
++ (NSArray *)getImageSizes:(NSArray *)fileNames
+{
+    //Use the dimensions recorded in the compiled score if there is one, and get the rest from
+    //the image size index in one batch.
+    NSMutableArray *sizes = [[NSMutableArray alloc] initWithCapacity:[fileNames count]];
+    NSMutableArray *remainingFiles = [[NSMutableArray alloc] init];
+    NSMutableArray *remainingPositions = [[NSMutableArray alloc] init];
+    for (int i = 0; i < [fileNames count]; i++) {
+        NSString *fileName = [fileNames objectAtIndex:i];
+        CGSize imageSize = [[CompiledScore compiledScoreForScorePath:[fileName stringByDeletingLastPathComponent]] imageSizeOfFile:[fileName lastPathComponent]];
+        if (imageSize.width <= 0 || imageSize.height <= 0) {
+            [remainingFiles addObject:fileName];
+            [remainingPositions addObject:[NSNumber numberWithInt:i]];
+        }
+        [sizes addObject:[NSValue valueWithCGSize:imageSize]];
     }
     
-    NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithBool:NO], (NSString *)kCGImageSourceShouldCache, nil];
-    CFDictionaryRef imageProperties = CGImageSourceCopyPropertiesAtIndex(imageSource, 0, (__bridge CFDictionaryRef)options);
-    if (imageProperties) {
-        NSNumber *width = (NSNumber *)CFDictionaryGetValue(imageProperties, kCGImagePropertyPixelWidth);
-        NSNumber *height = (NSNumber *)CFDictionaryGetValue(imageProperties, kCGImagePropertyPixelHeight);
-        
-        CFRelease(imageProperties);
-        CFRelease(imageSource);
-        return CGSizeMake([width intValue], [height intValue]);
-    } else {
-        CFRelease(imageSource);
-        return CGSizeMake(0, 0);
+    if ([remainingFiles count] > 0) {
+        NSArray *indexedSizes = [ImageSizeIndex sizesOfImageFiles:remainingFiles];
+        for (int i = 0; i < [indexedSizes count]; i++) {
+            [sizes replaceObjectAtIndex:[[remainingPositions objectAtIndex:i] integerValue] withObject:[indexedSizes objectAtIndex:i]];
+        }
     }
+    return sizes;
+}
+
++ (CGSize)readImageSize:(NSString *)fileName
+{
+    return [ImageSizeIndex readSizeOfImageFile:fileName];
 }
 
 + (UIImage *)defaultThumbnail:(NSString *)imageFile ofSize:(CGSize)size
@@ -101,7 +195,7 @@ static NSMutableDictionary *imageCache;
     size = CGSizeMake(size.width * screenScale, size.height * screenScale);
     
     //Scale to fit our image within the size of the thumbnail, maintainting the aspect ratio.
-    UIImage *image = [UIImage imageWithContentsOfFile:imageFile];
+    UIImage *image = [ScoreArchive imageWithContentsOfFile:imageFile];
     CGFloat widthRatio = size.width / image.size.width;
     CGFloat heightRatio = size.height / image.size.height;
     CGFloat scaleFactor;
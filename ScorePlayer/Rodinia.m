@@ -10,8 +10,10 @@
 #import "RodiniaEvent.h"
 #import "Score.h"
 #import "OSCMessage.h"
+#import "FrameClock.h"
+#import "EventScheduler.h"
 
-@interface Rodinia ()
+@interface Rodinia () <FrameClockSubscriber>
 
 - (NSMutableArray *)getColourArray;
 - (NSArray *)getUIColours;
@@ -25,8 +27,10 @@
 - (void)initPlayerLayers;
 - (void)changePart:(NSInteger)relativeChange;
 
-- (void)scrollerAnimate;
-- (void)showEvent:(NSTimer *)timer;
+- (void)enableScrolling:(BOOL)enabled;
+- (CFTimeInterval)scoreTimeAtFrameTime:(CFTimeInterval)frameTime;
+- (void)updateFrameSubscription;
+- (void)showEvent:(RodiniaEvent *)event;
 
 - (void)relayMessageToExternal:(OSCMessage *)message;
 
@@ -77,14 +81,18 @@
     StreamState streamStates[4];
     NSInteger xFromLastEvent[4];
     
-    NSTimer *scrollTimer;
+    BOOL scrolling;
+    CFTimeInterval scrollStartTime;
+    CGFloat scrollStartX;
     NSInteger currentPart;
     
     NSArray *uiColours;
     NSMutableArray *eventColours;
     
     NSMutableArray *events;
-    NSMutableArray *eventTimers;
+    EventScheduler *eventScheduler;
+    //Score time from earlier stretches of scrolling.
+    CFTimeInterval scrolledTime;
     
     __weak id<RendererUI> UIDelegate;
     __weak id<RendererMessaging> messagingDelegate;
@@ -382,21 +390,60 @@
     }
 }
 
-- (void)scrollerAnimate
+- (void)animateToTime:(CFTimeInterval)frameTime
 {
-    [CATransaction begin];
-    [CATransaction setAnimationTimingFunction:[CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear]];
-    scroller.position = CGPointMake(scroller.position.x - RODINIA_SCROLLRATE, 0);
-    [CATransaction commit];
-    if (scroller.position.x <= 150 - scroller.bounds.size.width) {
-        [scrollTimer invalidate];
+    //Events are timed in score time, so they only move while the score does.
+    [eventScheduler advanceToTime:[self scoreTimeAtFrameTime:frameTime]];
+    
+    //Keep to the original stepped movement, but count the steps from when we started.
+    NSInteger shifts = floor(MAX(frameTime - scrollStartTime, 0) * RODINIA_FRAMERATE);
+    CGFloat scrollerX = scrollStartX - (shifts * RODINIA_SCROLLRATE);
+    if (scrolling && scrollerX != scroller.position.x) {
+        [CATransaction begin];
+        [CATransaction setAnimationTimingFunction:[CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear]];
+        scroller.position = CGPointMake(scrollerX, 0);
+        [CATransaction commit];
+        if (scroller.position.x <= 150 - scroller.bounds.size.width) {
+            [self enableScrolling:NO];
+        }
     }
+    [self updateFrameSubscription];
 }
 
-- (void)showEvent:(NSTimer *)timer
+- (void)enableScrolling:(BOOL)enabled
 {
-    [scoreLayer addSublayer:((RodiniaEvent *)timer.userInfo).layer];
-    [eventTimers removeObjectIdenticalTo:timer];
+    if (enabled && !scrolling) {
+        scrollStartTime = [[FrameClock sharedClock] currentTime];
+        scrollStartX = scroller.position.x;
+    } else if (!enabled && scrolling) {
+        scrolledTime = [self scoreTimeAtFrameTime:[[FrameClock sharedClock] currentTime]];
+    }
+    scrolling = enabled;
+    [self updateFrameSubscription];
+}
+
+- (CFTimeInterval)scoreTimeAtFrameTime:(CFTimeInterval)frameTime
+{
+    if (!scrolling) {
+        return scrolledTime;
+    }
+    return scrolledTime + MAX(frameTime - scrollStartTime, 0);
+}
+
+- (void)updateFrameSubscription
+{
+    //We only need frames while we're scrolling. Waiting events are keyed to score time, so
+    //they can't fall due while we're stopped.
+    if (scrolling) {
+        [[FrameClock sharedClock] addSubscriber:self];
+    } else {
+        [[FrameClock sharedClock] removeSubscriber:self];
+    }
+}
+
+- (void)showEvent:(RodiniaEvent *)event
+{
+    [scoreLayer addSublayer:event.layer];
 }
 
 - (void)relayMessageToExternal:(OSCMessage *)message
@@ -456,18 +503,16 @@
     for (int i = 0; i < 4; i++) {
         [events addObject:[[NSMutableArray alloc] init]];
     }
-    eventTimers = [[NSMutableArray alloc] init];
+    eventScheduler = [[EventScheduler alloc] init];
+    scrolledTime = 0;
     
     return self;
 }
 
 - (void)close
 {
-    [scrollTimer invalidate];
-    
-    for (int i = 0; i < [eventTimers count]; i++) {
-        [[eventTimers objectAtIndex:i] invalidate];
-    }
+    [eventScheduler cancelAllEvents];
+    [self enableScrolling:NO];
 }
 
 - (void)reset
@@ -475,12 +520,10 @@
     canvas.sublayers = nil;
     scoreLayer.sublayers = nil;
     scroller.position = CGPointMake(150, 0);
-    [scrollTimer invalidate];
-    
-    for (int i = 0; i < [eventTimers count]; i++) {
-        [[eventTimers objectAtIndex:i] invalidate];
-    }
-    [eventTimers removeAllObjects];
+    [eventScheduler cancelAllEvents];
+    [self enableScrolling:NO];
+    scrolledTime = 0;
+    [eventScheduler seekToTime:0];
     
     for (int i = 0; i < [streamLayers count]; i++) {
         ((CALayer *)[streamLayers objectAtIndex:i]).sublayers = nil;
@@ -522,7 +565,7 @@
 
 - (void)play
 {
-    scrollTimer = [NSTimer scheduledTimerWithTimeInterval:(1 / (float)RODINIA_FRAMERATE) target:self selector:@selector(scrollerAnimate) userInfo:nil repeats:YES];
+    [self enableScrolling:YES];
 }
 
 - (void)receiveMessage:(OSCMessage *)message
@@ -602,8 +645,17 @@
         event.rotation = stream;
         event.layer.position = [self scoreCoordinatesFromStreamNumber:stream withCoordinates:event.streamPosition];
         [[events objectAtIndex:stream] addObject:event];
-        NSTimer *eventTimer = [NSTimer scheduledTimerWithTimeInterval:(CGFloat)streamXOffset / (RODINIA_SCROLLRATE * RODINIA_FRAMERATE) target:self selector:@selector(showEvent:) userInfo:event repeats:NO];
-        [eventTimers addObject:eventTimer];
+        //Show the event on the score once it has scrolled across to the reading line. Bring the
+        //scheduler up to date first, so that it doesn't have to step through any idle time
+        //before the event on its next advance.
+        __weak Rodinia *weakSelf = self;
+        CFTimeInterval now = [self scoreTimeAtFrameTime:[[FrameClock sharedClock] currentTime]];
+        [eventScheduler advanceToTime:now];
+        CFTimeInterval showTime = now + (CGFloat)streamXOffset / (RODINIA_SCROLLRATE * RODINIA_FRAMERATE);
+        [eventScheduler scheduleAtTime:showTime block:^{
+            [weakSelf showEvent:event];
+        }];
+        [self updateFrameSubscription];
         
         return;
     }
@@ -13,6 +13,10 @@
 #include "mz_os.h"
 #include "mz_crypt.h"
 
+#if !defined(MZ_ZIP_NO_FAST_CRC32)
+#  include "../../Crc32.h"
+#endif
+
 #if defined(HAVE_ZLIB)
 #  include "zlib.h"
 #  if defined(ZLIBNG_VERNUM) && !defined(ZLIB_COMPAT)
@@ -48,7 +52,10 @@ int32_t mz_crypt_rand(uint8_t *buf, int32_t size) {
 #endif
 
 uint32_t mz_crypt_crc32_update(uint32_t value, const uint8_t *buf, int32_t size) {
-#if defined(HAVE_ZLIB)
+#if !defined(MZ_ZIP_NO_FAST_CRC32)
+    /* ScorePlayer: uses the CRC instructions (or slicing-by-16) picked at runtime, see Crc32.h */
+    return Crc32Update(value, buf, size > 0 ? (size_t)size : 0);
+#elif defined(HAVE_ZLIB)
     return (uint32_t)ZLIB_PREFIX(crc32)((z_crc_t)value, buf, (uInt)size);
 #elif defined(HAVE_LZMA)
     return (uint32_t)lzma_crc32(buf, (size_t)size, (uint32_t)value);
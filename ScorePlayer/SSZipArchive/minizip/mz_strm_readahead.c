@@ -0,0 +1,536 @@
+/* mz_strm_readahead.c -- Stream for reading ahead and writing behind on a thread
+   part of the minizip-ng project (ScorePlayer addition)
+
+   Copyright (C) 2026 Decibel
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+#include "mz.h"
+#include "mz_strm.h"
+#include "mz_strm_readahead.h"
+
+#include <pthread.h>
+
+/***************************************************************************/
+
+static mz_stream_vtbl mz_stream_readahead_vtbl = {
+    mz_stream_readahead_open,
+    mz_stream_readahead_is_open,
+    mz_stream_readahead_read,
+    mz_stream_readahead_write,
+    mz_stream_readahead_tell,
+    mz_stream_readahead_seek,
+    mz_stream_readahead_close,
+    mz_stream_readahead_error,
+    mz_stream_readahead_create,
+    mz_stream_readahead_delete,
+    mz_stream_readahead_get_prop_int64,
+    mz_stream_readahead_set_prop_int64
+};
+
+/***************************************************************************/
+
+#define MZ_READAHEAD_IDLE       (0)
+#define MZ_READAHEAD_READING    (1)
+#define MZ_READAHEAD_WRITING    (2)
+
+typedef struct mz_stream_readahead_chunk_s {
+    uint8_t         *data;
+    int32_t         len;
+    int64_t         offset;
+} mz_stream_readahead_chunk;
+
+/* The chunks form a ring. When reading, the chunks from head on hold what the thread has read
+   ahead, in order. When writing, they're queued for the thread to write out, and the chunk
+   after them is the one being filled by the caller. The thread only ever does IO on the base
+   outside the mutex, with busy set, and never touches a chunk that belongs to the caller. */
+typedef struct mz_stream_readahead_s {
+    mz_stream       stream;
+    int32_t         chunk_size;
+    int32_t         chunk_count;
+    mz_stream_readahead_chunk chunks[MZ_STREAM_READAHEAD_MAX_CHUNK_COUNT];
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    pthread_t       thread;
+    int32_t         is_open;
+    int32_t         stopping;
+    int32_t         mode;
+    int32_t         busy;
+    int32_t         head;
+    int32_t         count;
+    int32_t         depth;
+    int32_t         end;
+    int32_t         error;
+    int64_t         next_offset;
+    int32_t         read_pos;
+    int32_t         write_len;
+    int64_t         position;
+} mz_stream_readahead;
+
+/***************************************************************************/
+
+static int32_t mz_stream_readahead_read_full(void *base, uint8_t *buf, int32_t size) {
+    int32_t total = 0;
+    while (total < size) {
+        int32_t read = mz_stream_read(base, buf + total, size - total);
+        if (read < 0)
+            return read;
+        if (read == 0)
+            break;
+        total += read;
+    }
+    return total;
+}
+
+static int32_t mz_stream_readahead_write_full(void *base, const uint8_t *buf, int32_t size) {
+    int32_t total = 0;
+    while (total < size) {
+        int32_t written = mz_stream_write(base, buf + total, size - total);
+        if (written <= 0)
+            return MZ_WRITE_ERROR;
+        total += written;
+    }
+    return MZ_OK;
+}
+
+static void *mz_stream_readahead_thread(void *arg) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)arg;
+    mz_stream_readahead_chunk *chunk = NULL;
+    int64_t offset = 0;
+    int32_t result = 0;
+
+    pthread_mutex_lock(&readahead->mutex);
+    while (!readahead->stopping) {
+        if (readahead->mode == MZ_READAHEAD_READING && !readahead->end &&
+            readahead->error == MZ_OK && readahead->count < readahead->depth) {
+            chunk = &readahead->chunks[(readahead->head + readahead->count) % readahead->chunk_count];
+            offset = readahead->next_offset;
+            readahead->busy = 1;
+            pthread_mutex_unlock(&readahead->mutex);
+
+            result = mz_stream_readahead_read_full(readahead->stream.base, chunk->data, readahead->chunk_size);
+
+            pthread_mutex_lock(&readahead->mutex);
+            readahead->busy = 0;
+            if (result < 0) {
+                readahead->error = result;
+            } else {
+                chunk->len = result;
+                chunk->offset = offset;
+                readahead->count += 1;
+                readahead->next_offset += result;
+                if (result < readahead->chunk_size)
+                    readahead->end = 1;
+            }
+            pthread_cond_broadcast(&readahead->cond);
+        } else if (readahead->mode == MZ_READAHEAD_WRITING && readahead->count > 0) {
+            chunk = &readahead->chunks[readahead->head];
+            readahead->busy = 1;
+            pthread_mutex_unlock(&readahead->mutex);
+
+            result = mz_stream_readahead_write_full(readahead->stream.base, chunk->data, chunk->len);
+
+            pthread_mutex_lock(&readahead->mutex);
+            readahead->busy = 0;
+            /* A failed chunk is still dropped so that nobody waits on it, but the error sticks. */
+            if (result != MZ_OK)
+                readahead->error = result;
+            readahead->head = (readahead->head + 1) % readahead->chunk_count;
+            readahead->count -= 1;
+            pthread_cond_broadcast(&readahead->cond);
+        } else {
+            pthread_cond_wait(&readahead->cond, &readahead->mutex);
+        }
+    }
+    pthread_mutex_unlock(&readahead->mutex);
+    return NULL;
+}
+
+static int32_t mz_stream_readahead_sync(mz_stream_readahead *readahead) {
+    /* Must be called with the mutex held. Stops the thread and leaves the base at the position
+       the caller sees, with nothing read ahead or waiting to be written. */
+    if (readahead->mode == MZ_READAHEAD_IDLE)
+        return MZ_OK;
+
+    if (readahead->mode == MZ_READAHEAD_WRITING) {
+        if (readahead->write_len > 0) {
+            while (readahead->count == readahead->chunk_count)
+                pthread_cond_wait(&readahead->cond, &readahead->mutex);
+            readahead->chunks[(readahead->head + readahead->count) % readahead->chunk_count].len = readahead->write_len;
+            readahead->count += 1;
+            readahead->write_len = 0;
+            pthread_cond_broadcast(&readahead->cond);
+        }
+        while (readahead->count > 0 || readahead->busy)
+            pthread_cond_wait(&readahead->cond, &readahead->mutex);
+        readahead->mode = MZ_READAHEAD_IDLE;
+        readahead->head = 0;
+        if (readahead->error != MZ_OK)
+            return readahead->error;
+    } else {
+        readahead->mode = MZ_READAHEAD_IDLE;
+        while (readahead->busy)
+            pthread_cond_wait(&readahead->cond, &readahead->mutex);
+        readahead->head = 0;
+        readahead->count = 0;
+        readahead->read_pos = 0;
+        readahead->end = 0;
+        /* Read errors aren't kept, so that the next read tries again. */
+        readahead->error = MZ_OK;
+    }
+
+    /* Seek even if the base is already in the right place, since stdio needs it between
+       reading and writing. */
+    return mz_stream_seek(readahead->stream.base, readahead->position, MZ_SEEK_SET);
+}
+
+static void mz_stream_readahead_start(mz_stream_readahead *readahead, int32_t mode) {
+    /* Must be called with the mutex held, after syncing. */
+    readahead->mode = mode;
+    readahead->head = 0;
+    readahead->count = 0;
+    readahead->read_pos = 0;
+    readahead->write_len = 0;
+    readahead->end = 0;
+    readahead->depth = 1;
+    readahead->next_offset = readahead->position;
+    pthread_cond_broadcast(&readahead->cond);
+}
+
+static void mz_stream_readahead_free_chunks(mz_stream_readahead *readahead) {
+    int32_t i = 0;
+    for (i = 0; i < MZ_STREAM_READAHEAD_MAX_CHUNK_COUNT; i += 1) {
+        MZ_FREE(readahead->chunks[i].data);
+        readahead->chunks[i].data = NULL;
+    }
+}
+
+/***************************************************************************/
+
+int32_t mz_stream_readahead_open(void *stream, const char *path, int32_t mode) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    int32_t err = MZ_OK;
+    int32_t i = 0;
+
+    if (readahead->is_open)
+        return MZ_OPEN_ERROR;
+
+    for (i = 0; i < readahead->chunk_count; i += 1) {
+        readahead->chunks[i].data = (uint8_t *)MZ_ALLOC(readahead->chunk_size);
+        if (readahead->chunks[i].data == NULL) {
+            mz_stream_readahead_free_chunks(readahead);
+            return MZ_MEM_ERROR;
+        }
+    }
+
+    err = mz_stream_open(readahead->stream.base, path, mode);
+    if (err != MZ_OK) {
+        mz_stream_readahead_free_chunks(readahead);
+        return err;
+    }
+
+    readahead->stopping = 0;
+    readahead->mode = MZ_READAHEAD_IDLE;
+    readahead->busy = 0;
+    readahead->error = MZ_OK;
+    readahead->position = mz_stream_tell(readahead->stream.base);
+    if (readahead->position < 0)
+        readahead->position = 0;
+    if (pthread_create(&readahead->thread, NULL, mz_stream_readahead_thread, readahead) != 0) {
+        mz_stream_close(readahead->stream.base);
+        mz_stream_readahead_free_chunks(readahead);
+        return MZ_OPEN_ERROR;
+    }
+    readahead->is_open = 1;
+    return MZ_OK;
+}
+
+int32_t mz_stream_readahead_is_open(void *stream) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    if (!readahead->is_open)
+        return MZ_OPEN_ERROR;
+    return mz_stream_is_open(readahead->stream.base);
+}
+
+int32_t mz_stream_readahead_read(void *stream, void *buf, int32_t size) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    mz_stream_readahead_chunk *chunk = NULL;
+    int32_t bytes_read = 0;
+    int32_t bytes_to_copy = 0;
+    int32_t err = MZ_OK;
+
+    if (!readahead->is_open)
+        return MZ_OPEN_ERROR;
+    if (size <= 0)
+        return 0;
+
+    pthread_mutex_lock(&readahead->mutex);
+    if (readahead->mode != MZ_READAHEAD_READING) {
+        err = mz_stream_readahead_sync(readahead);
+        if (err != MZ_OK) {
+            pthread_mutex_unlock(&readahead->mutex);
+            return err;
+        }
+        mz_stream_readahead_start(readahead, MZ_READAHEAD_READING);
+    }
+
+    while (bytes_read < size) {
+        if (readahead->count > 0) {
+            chunk = &readahead->chunks[readahead->head];
+            if (readahead->read_pos < chunk->len) {
+                bytes_to_copy = chunk->len - readahead->read_pos;
+                if (bytes_to_copy > size - bytes_read)
+                    bytes_to_copy = size - bytes_read;
+                /* The head chunk belongs to the caller until it's handed back. */
+                pthread_mutex_unlock(&readahead->mutex);
+                memcpy((uint8_t *)buf + bytes_read, chunk->data + readahead->read_pos, bytes_to_copy);
+                pthread_mutex_lock(&readahead->mutex);
+                readahead->read_pos += bytes_to_copy;
+                readahead->position += bytes_to_copy;
+                bytes_read += bytes_to_copy;
+                continue;
+            }
+            /* Used up, so hand it back and read further ahead from now on. */
+            readahead->head = (readahead->head + 1) % readahead->chunk_count;
+            readahead->count -= 1;
+            readahead->read_pos = 0;
+            if (readahead->depth < readahead->chunk_count)
+                readahead->depth += 1;
+            pthread_cond_broadcast(&readahead->cond);
+            continue;
+        }
+        if (readahead->error != MZ_OK || readahead->end)
+            break;
+        pthread_cond_wait(&readahead->cond, &readahead->mutex);
+    }
+
+    if (bytes_read == 0 && readahead->error != MZ_OK)
+        bytes_read = readahead->error;
+    pthread_mutex_unlock(&readahead->mutex);
+    return bytes_read;
+}
+
+int32_t mz_stream_readahead_write(void *stream, const void *buf, int32_t size) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    mz_stream_readahead_chunk *chunk = NULL;
+    int32_t bytes_written = 0;
+    int32_t bytes_to_copy = 0;
+    int32_t err = MZ_OK;
+
+    if (!readahead->is_open)
+        return MZ_OPEN_ERROR;
+    if (size <= 0)
+        return 0;
+
+    pthread_mutex_lock(&readahead->mutex);
+    if (readahead->mode != MZ_READAHEAD_WRITING) {
+        err = mz_stream_readahead_sync(readahead);
+        if (err != MZ_OK) {
+            pthread_mutex_unlock(&readahead->mutex);
+            return err;
+        }
+        mz_stream_readahead_start(readahead, MZ_READAHEAD_WRITING);
+    }
+
+    while (bytes_written < size && readahead->error == MZ_OK) {
+        if (readahead->count == readahead->chunk_count) {
+            pthread_cond_wait(&readahead->cond, &readahead->mutex);
+            continue;
+        }
+        /* The thread moves the head on, but never past the chunk being filled. */
+        chunk = &readahead->chunks[(readahead->head + readahead->count) % readahead->chunk_count];
+        bytes_to_copy = readahead->chunk_size - readahead->write_len;
+        if (bytes_to_copy > size - bytes_written)
+            bytes_to_copy = size - bytes_written;
+        pthread_mutex_unlock(&readahead->mutex);
+        memcpy(chunk->data + readahead->write_len, (const uint8_t *)buf + bytes_written, bytes_to_copy);
+        pthread_mutex_lock(&readahead->mutex);
+        readahead->write_len += bytes_to_copy;
+        readahead->position += bytes_to_copy;
+        bytes_written += bytes_to_copy;
+        if (readahead->write_len == readahead->chunk_size) {
+            chunk->len = readahead->write_len;
+            readahead->count += 1;
+            readahead->write_len = 0;
+            pthread_cond_broadcast(&readahead->cond);
+        }
+    }
+
+    if (readahead->error != MZ_OK)
+        bytes_written = readahead->error;
+    pthread_mutex_unlock(&readahead->mutex);
+    return bytes_written;
+}
+
+int64_t mz_stream_readahead_tell(void *stream) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    if (!readahead->is_open)
+        return MZ_OPEN_ERROR;
+    return readahead->position;
+}
+
+int32_t mz_stream_readahead_seek(void *stream, int64_t offset, int32_t origin) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    mz_stream_readahead_chunk *chunk = NULL;
+    int64_t target = offset;
+    int32_t err = MZ_OK;
+    int32_t i = 0;
+
+    if (!readahead->is_open)
+        return MZ_OPEN_ERROR;
+    if (origin == MZ_SEEK_CUR)
+        target = readahead->position + offset;
+
+    pthread_mutex_lock(&readahead->mutex);
+    if (origin != MZ_SEEK_END) {
+        if (target == readahead->position && readahead->mode == MZ_READAHEAD_WRITING) {
+            pthread_mutex_unlock(&readahead->mutex);
+            return MZ_OK;
+        }
+        if (readahead->mode == MZ_READAHEAD_READING) {
+            /* Stay within what's been read ahead if possible, dropping the chunks before it. */
+            for (i = 0; i < readahead->count; i += 1) {
+                chunk = &readahead->chunks[(readahead->head + i) % readahead->chunk_count];
+                if (target >= chunk->offset && target < chunk->offset + chunk->len)
+                    break;
+            }
+            if (i < readahead->count || target == readahead->next_offset) {
+                readahead->head = (readahead->head + i) % readahead->chunk_count;
+                readahead->count -= i;
+                readahead->read_pos = readahead->count > 0 ?
+                    (int32_t)(target - readahead->chunks[readahead->head].offset) : 0;
+                readahead->position = target;
+                pthread_cond_broadcast(&readahead->cond);
+                pthread_mutex_unlock(&readahead->mutex);
+                return MZ_OK;
+            }
+        }
+    }
+
+    err = mz_stream_readahead_sync(readahead);
+    if (err == MZ_OK) {
+        if (origin == MZ_SEEK_END) {
+            err = mz_stream_seek(readahead->stream.base, offset, origin);
+            if (err == MZ_OK)
+                readahead->position = mz_stream_tell(readahead->stream.base);
+        } else {
+            err = mz_stream_seek(readahead->stream.base, target, MZ_SEEK_SET);
+            if (err == MZ_OK)
+                readahead->position = target;
+        }
+    }
+    pthread_mutex_unlock(&readahead->mutex);
+    return err;
+}
+
+int32_t mz_stream_readahead_close(void *stream) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    int32_t err = MZ_OK;
+
+    if (!readahead->is_open)
+        return MZ_OK;
+
+    pthread_mutex_lock(&readahead->mutex);
+    err = mz_stream_readahead_sync(readahead);
+    readahead->stopping = 1;
+    pthread_cond_broadcast(&readahead->cond);
+    pthread_mutex_unlock(&readahead->mutex);
+    pthread_join(readahead->thread, NULL);
+
+    readahead->is_open = 0;
+    mz_stream_readahead_free_chunks(readahead);
+    if (mz_stream_close(readahead->stream.base) != MZ_OK && err == MZ_OK)
+        err = MZ_CLOSE_ERROR;
+    return err;
+}
+
+int32_t mz_stream_readahead_error(void *stream) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    if (readahead->error != MZ_OK)
+        return readahead->error;
+    return mz_stream_error(readahead->stream.base);
+}
+
+int32_t mz_stream_readahead_get_prop_int64(void *stream, int32_t prop, int64_t *value) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    switch (prop) {
+    case MZ_STREAM_PROP_READAHEAD_CHUNK_SIZE:
+        *value = readahead->chunk_size;
+        return MZ_OK;
+    case MZ_STREAM_PROP_READAHEAD_CHUNK_COUNT:
+        *value = readahead->chunk_count;
+        return MZ_OK;
+    }
+    if (readahead->stream.base == NULL)
+        return MZ_EXIST_ERROR;
+    return mz_stream_get_prop_int64(readahead->stream.base, prop, value);
+}
+
+int32_t mz_stream_readahead_set_prop_int64(void *stream, int32_t prop, int64_t value) {
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    int32_t err = MZ_OK;
+
+    switch (prop) {
+    case MZ_STREAM_PROP_READAHEAD_CHUNK_SIZE:
+        if (readahead->is_open || value <= 0 || value > INT32_MAX)
+            return MZ_PARAM_ERROR;
+        readahead->chunk_size = (int32_t)value;
+        return MZ_OK;
+    case MZ_STREAM_PROP_READAHEAD_CHUNK_COUNT:
+        if (readahead->is_open || value < 2 || value > MZ_STREAM_READAHEAD_MAX_CHUNK_COUNT)
+            return MZ_PARAM_ERROR;
+        readahead->chunk_count = (int32_t)value;
+        return MZ_OK;
+    }
+    if (readahead->stream.base == NULL)
+        return MZ_EXIST_ERROR;
+    if (!readahead->is_open)
+        return mz_stream_set_prop_int64(readahead->stream.base, prop, value);
+
+    /* The base may move to another file (a split disk, say), so nothing buffered can be kept. */
+    pthread_mutex_lock(&readahead->mutex);
+    err = mz_stream_readahead_sync(readahead);
+    if (err == MZ_OK)
+        err = mz_stream_set_prop_int64(readahead->stream.base, prop, value);
+    readahead->position = mz_stream_tell(readahead->stream.base);
+    pthread_mutex_unlock(&readahead->mutex);
+    return err;
+}
+
+void *mz_stream_readahead_create(void **stream) {
+    mz_stream_readahead *readahead = NULL;
+
+    readahead = (mz_stream_readahead *)MZ_ALLOC(sizeof(mz_stream_readahead));
+    if (readahead != NULL) {
+        memset(readahead, 0, sizeof(mz_stream_readahead));
+        readahead->stream.vtbl = &mz_stream_readahead_vtbl;
+        readahead->chunk_size = MZ_STREAM_READAHEAD_CHUNK_SIZE;
+        readahead->chunk_count = MZ_STREAM_READAHEAD_CHUNK_COUNT;
+        pthread_mutex_init(&readahead->mutex, NULL);
+        pthread_cond_init(&readahead->cond, NULL);
+    }
+    if (stream != NULL)
+        *stream = readahead;
+
+    return readahead;
+}
+
+void mz_stream_readahead_delete(void **stream) {
+    mz_stream_readahead *readahead = NULL;
+    if (stream == NULL)
+        return;
+    readahead = (mz_stream_readahead *)*stream;
+    if (readahead != NULL) {
+        mz_stream_readahead_close(readahead);
+        pthread_mutex_destroy(&readahead->mutex);
+        pthread_cond_destroy(&readahead->cond);
+        MZ_FREE(readahead);
+    }
+    *stream = NULL;
+}
+
+void *mz_stream_readahead_get_interface(void) {
+    return (void *)&mz_stream_readahead_vtbl;
+}
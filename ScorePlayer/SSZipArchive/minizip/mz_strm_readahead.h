@@ -0,0 +1,62 @@
+/* mz_strm_readahead.h -- Stream for reading ahead and writing behind on a thread
+   part of the minizip-ng project (ScorePlayer addition)
+
+   Reads from the base stream are made a chunk at a time on a background thread,
+   so that the next chunk is already coming off the disk while the current one is
+   inflated. After a seek only one chunk is read ahead, and the depth grows by a
+   chunk each time one is used up, so that jumping from entry to entry doesn't
+   read much more than is needed. Writes are gathered into chunks that the thread
+   writes out behind the caller.
+
+   It sits directly on top of a stream that does the IO (os or split) and under
+   everything else, in place of the buffered stream.
+
+   Copyright (C) 2026 Decibel
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+#ifndef MZ_STREAM_READAHEAD_H
+#define MZ_STREAM_READAHEAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************/
+
+/* Both can only be set before the stream is opened. Other properties are passed on to the base. */
+#define MZ_STREAM_PROP_READAHEAD_CHUNK_SIZE     (100)
+#define MZ_STREAM_PROP_READAHEAD_CHUNK_COUNT    (101)
+
+#define MZ_STREAM_READAHEAD_CHUNK_SIZE          (256 * 1024)
+#define MZ_STREAM_READAHEAD_CHUNK_COUNT         (3)
+#define MZ_STREAM_READAHEAD_MAX_CHUNK_COUNT     (8)
+
+/***************************************************************************/
+
+int32_t mz_stream_readahead_open(void *stream, const char *path, int32_t mode);
+int32_t mz_stream_readahead_is_open(void *stream);
+int32_t mz_stream_readahead_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_readahead_write(void *stream, const void *buf, int32_t size);
+int64_t mz_stream_readahead_tell(void *stream);
+int32_t mz_stream_readahead_seek(void *stream, int64_t offset, int32_t origin);
+int32_t mz_stream_readahead_close(void *stream);
+int32_t mz_stream_readahead_error(void *stream);
+
+int32_t mz_stream_readahead_get_prop_int64(void *stream, int32_t prop, int64_t *value);
+int32_t mz_stream_readahead_set_prop_int64(void *stream, int32_t prop, int64_t value);
+
+void*   mz_stream_readahead_create(void **stream);
+void    mz_stream_readahead_delete(void **stream);
+
+void*   mz_stream_readahead_get_interface(void);
+
+/***************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -52,5 +52,11 @@
 @property (nonatomic, copy) NSString *annotationsPathOverride;
 @property (nonatomic, copy) NSString *version;
 @property (nonatomic, copy) NSString *formatVersion;
+@property (nonatomic, readonly) NSString *thumbnailFileName;
+
+//Used by the library index. The score path and annotations override aren't included, since
+//they depend on where the app's container is at the time.
+- (id)initWithPropertyList:(NSDictionary *)propertyList;
+- (NSDictionary *)propertyListRepresentation;
 
 @end
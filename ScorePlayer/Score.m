@@ -37,6 +37,88 @@
     return self;
 }
 
+- (id)initWithPropertyList:(NSDictionary *)propertyList
+{
+    self = [self init];
+    if (self) {
+        scoreName = [propertyList objectForKey:@"name"];
+        scoreType = [propertyList objectForKey:@"type"];
+        variationNumber = [[propertyList objectForKey:@"variation"] integerValue];
+        originalDuration = [[propertyList objectForKey:@"duration"] floatValue];
+        startOffset = [[propertyList objectForKey:@"startOffset"] integerValue];
+        readLineOffset = [[propertyList objectForKey:@"readOffset"] integerValue];
+        fileName = [propertyList objectForKey:@"fileName"];
+        prefsFile = [propertyList objectForKey:@"prefsFile"];
+        instructions = [propertyList objectForKey:@"instructions"];
+        audioFile = [propertyList objectForKey:@"audioFile"];
+        allowsOptions = [[propertyList objectForKey:@"options"] boolValue];
+        askForIdentifier = [[propertyList objectForKey:@"manualIdentifier"] boolValue];
+        version = [propertyList objectForKey:@"version"];
+        formatVersion = [propertyList objectForKey:@"formatVersion"];
+        [composers addObjectsFromArray:[propertyList objectForKey:@"composers"]];
+        [parts addObjectsFromArray:[propertyList objectForKey:@"parts"]];
+        [audioParts addObjectsFromArray:[propertyList objectForKey:@"audioParts"]];
+        
+        NSArray *colour = [propertyList objectForKey:@"background"];
+        if ([colour count] == 4) {
+            backgroundColour = [UIColor colorWithRed:[[colour objectAtIndex:0] doubleValue] green:[[colour objectAtIndex:1] doubleValue] blue:[[colour objectAtIndex:2] doubleValue] alpha:[[colour objectAtIndex:3] doubleValue]];
+        }
+    }
+    return self;
+}
+
+- (NSDictionary *)propertyListRepresentation
+{
+    //Optional values are left out when they're not set.
+    NSMutableDictionary *propertyList = [[NSMutableDictionary alloc] init];
+    if (scoreName != nil) {
+        [propertyList setObject:scoreName forKey:@"name"];
+    }
+    if (scoreType != nil) {
+        [propertyList setObject:scoreType forKey:@"type"];
+    }
+    [propertyList setObject:[NSNumber numberWithInteger:variationNumber] forKey:@"variation"];
+    [propertyList setObject:[NSNumber numberWithDouble:originalDuration] forKey:@"duration"];
+    [propertyList setObject:[NSNumber numberWithInteger:startOffset] forKey:@"startOffset"];
+    [propertyList setObject:[NSNumber numberWithInteger:readLineOffset] forKey:@"readOffset"];
+    if (fileName != nil) {
+        [propertyList setObject:fileName forKey:@"fileName"];
+    }
+    if (prefsFile != nil) {
+        [propertyList setObject:prefsFile forKey:@"prefsFile"];
+    }
+    if (instructions != nil) {
+        [propertyList setObject:instructions forKey:@"instructions"];
+    }
+    if (audioFile != nil) {
+        [propertyList setObject:audioFile forKey:@"audioFile"];
+    }
+    [propertyList setObject:[NSNumber numberWithBool:allowsOptions] forKey:@"options"];
+    [propertyList setObject:[NSNumber numberWithBool:askForIdentifier] forKey:@"manualIdentifier"];
+    if (version != nil) {
+        [propertyList setObject:version forKey:@"version"];
+    }
+    if (formatVersion != nil) {
+        [propertyList setObject:formatVersion forKey:@"formatVersion"];
+    }
+    [propertyList setObject:composers forKey:@"composers"];
+    [propertyList setObject:parts forKey:@"parts"];
+    [propertyList setObject:audioParts forKey:@"audioParts"];
+    
+    CGFloat r, g, b, a;
+    if ([backgroundColour getRed:&r green:&g blue:&b alpha:&a]) {
+        [propertyList setObject:[NSArray arrayWithObjects:[NSNumber numberWithDouble:r], [NSNumber numberWithDouble:g], [NSNumber numberWithDouble:b], [NSNumber numberWithDouble:a], nil] forKey:@"background"];
+    }
+    return propertyList;
+}
+
+- (NSString *)thumbnailFileName
+{
+    NSString *thumbnailFileName = [NSString stringWithFormat:@".%@.%@.thumbnail.png", self.composerFullText, scoreName];
+    thumbnailFileName = [thumbnailFileName stringByReplacingOccurrencesOfString:@"/" withString:@"-"];
+    return [thumbnailFileName stringByReplacingOccurrencesOfString:@":" withString:@"."];
+}
+
 - (NSString *)composerFullText
 {
     return [self nameStringWithSurnameOnly:NO];
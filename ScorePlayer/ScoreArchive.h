@@ -0,0 +1,50 @@
+//
+//  ScoreArchive.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+//Lets a score be played straight from the archive it was imported from, rather than extracting
+//it first. A mounted score still has a directory of its own, with the archive kept inside it as a
+//hidden file. Anything that's written to the directory later (thumbnails, annotations and tile
+//pyramids) sits on disk as usual, and files on disk always take precedence over the archive.
+//The archive is read through ZipMount (see ZipMount.h), so stored images are used straight from
+//a mapping of the archive without being copied.
+//Only archives with every image stored are mounted, since those are the ones that gain from it.
+//Archives with audio or video are always extracted, since those files are played from a URL.
+//
+//The file methods here work with any path. They cost no more than the NSFileManager and NSData
+//equivalents for files that aren't in a mounted score.
+
+@interface ScoreArchive : NSObject
+
+//Whether an archive can be played without extracting it.
++ (BOOL)canMountArchive:(NSString *)archivePath;
+//Moves an archive into a new score directory at the given path.
++ (BOOL)mountArchive:(NSString *)archivePath atScorePath:(NSString *)scorePath;
++ (BOOL)isMountedScorePath:(NSString *)scorePath;
+//Where the archive of a mounted score is kept.
++ (NSString *)archivePathForScorePath:(NSString *)scorePath;
+//Forgets the mounted archives (and the directories known not to have one) under a path. Call
+//this whenever score directories are removed or replaced.
++ (void)unmountScoresInDirectory:(NSString *)path;
+
+//Reads a file from disk, or failing that, from the archive of the score it belongs to.
++ (NSData *)dataWithContentsOfFile:(NSString *)path;
++ (UIImage *)imageWithContentsOfFile:(NSString *)path;
++ (BOOL)fileExistsAtPath:(NSString *)path;
+//Only NSFileSize and NSFileModificationDate are given for files in an archive. (The date is
+//when the archive was last changed.)
++ (NSDictionary *)attributesOfItemAtPath:(NSString *)path;
+
+//Returns nil unless the file is only in an archive. Stored files aren't copied.
++ (NSData *)archivedDataForFile:(NSString *)path;
+//Part of an archived file. The range is cut short at the end of the file.
++ (NSData *)archivedDataForFile:(NSString *)path range:(NSRange)range;
+
+@end
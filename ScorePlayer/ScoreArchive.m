@@ -0,0 +1,291 @@
+//
+//  ScoreArchive.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ScoreArchive.h"
+#import "ZipMount.h"
+
+static NSString *const SCORE_ARCHIVE_FILE = @".score.dsz";
+
+//Every directory that has been asked about, mapped to its archive or to NSNull if it hasn't
+//got one. Directories are only checked once.
+static NSMutableDictionary *archives;
+static NSLock *archivesLock;
+
+@interface ScoreArchive ()
+
+- (id)initWithPath:(NSString *)path;
+- (NSData *)dataForEntry:(const ZipMountEntry *)entry;
+- (NSData *)dataForEntry:(const ZipMountEntry *)entry range:(NSRange)range;
++ (void)initArchives;
++ (ScoreArchive *)archiveForFile:(NSString *)path entry:(const ZipMountEntry **)entry;
++ (BOOL)isImageFile:(NSString *)fileName;
++ (BOOL)isMediaFile:(NSString *)fileName;
+
+@end
+
+@implementation ScoreArchive {
+    ZipMount *mount;
+    NSDate *modificationDate;
+}
+
++ (BOOL)canMountArchive:(NSString *)archivePath
+{
+    ZipMount *archiveMount = ZipMountOpen([archivePath fileSystemRepresentation]);
+    if (archiveMount == NULL) {
+        return NO;
+    }
+    
+    BOOL canMount = ZipMountFind(archiveMount, "opus.xml", 8) != NULL;
+    BOOL hasImages = NO;
+    for (size_t i = 0; i < ZipMountEntryCount(archiveMount) && canMount; i++) {
+        const ZipMountEntry *entry = ZipMountEntryAtIndex(archiveMount, i);
+        NSString *fileName = [[NSString alloc] initWithBytes:entry->name length:entry->nameLength encoding:NSUTF8StringEncoding];
+        if (fileName == nil || [self isMediaFile:fileName]) {
+            canMount = NO;
+        } else if ([self isImageFile:fileName]) {
+            //Deflated images would have to be inflated every time they're loaded.
+            hasImages = YES;
+            canMount = entry->stored;
+        }
+    }
+    ZipMountClose(archiveMount);
+    return canMount && hasImages;
+}
+
++ (BOOL)mountArchive:(NSString *)archivePath atScorePath:(NSString *)scorePath
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    if (![fileManager createDirectoryAtPath:scorePath withIntermediateDirectories:YES attributes:nil error:nil]) {
+        return NO;
+    }
+    [self unmountScoresInDirectory:scorePath];
+    return [fileManager moveItemAtPath:archivePath toPath:[self archivePathForScorePath:scorePath] error:nil];
+}
+
++ (BOOL)isMountedScorePath:(NSString *)scorePath
+{
+    return [[NSFileManager defaultManager] fileExistsAtPath:[self archivePathForScorePath:scorePath]];
+}
+
++ (NSString *)archivePathForScorePath:(NSString *)scorePath
+{
+    return [scorePath stringByAppendingPathComponent:SCORE_ARCHIVE_FILE];
+}
+
++ (void)unmountScoresInDirectory:(NSString *)path
+{
+    [self initArchives];
+    NSString *prefix = [path stringByAppendingString:@"/"];
+    
+    //Archives stay mapped until any data that was read from them has been released.
+    [archivesLock lock];
+    NSArray *directories = [archives allKeys];
+    for (int i = 0; i < [directories count]; i++) {
+        NSString *directory = [directories objectAtIndex:i];
+        if ([directory isEqualToString:path] || [directory hasPrefix:prefix]) {
+            [archives removeObjectForKey:directory];
+        }
+    }
+    [archivesLock unlock];
+}
+
++ (NSData *)dataWithContentsOfFile:(NSString *)path
+{
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+    if (data != nil) {
+        return data;
+    }
+    return [self archivedDataForFile:path];
+}
+
++ (UIImage *)imageWithContentsOfFile:(NSString *)path
+{
+    UIImage *image = [UIImage imageWithContentsOfFile:path];
+    if (image != nil) {
+        return image;
+    }
+    NSData *data = [self archivedDataForFile:path];
+    return data == nil ? nil : [UIImage imageWithData:data];
+}
+
++ (BOOL)fileExistsAtPath:(NSString *)path
+{
+    if ([[NSFileManager defaultManager] fileExistsAtPath:path]) {
+        return YES;
+    }
+    const ZipMountEntry *entry;
+    return [self archiveForFile:path entry:&entry] != nil && entry != NULL;
+}
+
++ (NSDictionary *)attributesOfItemAtPath:(NSString *)path
+{
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil];
+    if (attributes != nil) {
+        return attributes;
+    }
+    
+    const ZipMountEntry *entry;
+    ScoreArchive *archive = [self archiveForFile:path entry:&entry];
+    if (archive == nil || entry == NULL) {
+        return nil;
+    }
+    return [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithUnsignedLongLong:entry->size], NSFileSize, archive->modificationDate, NSFileModificationDate, nil];
+}
+
++ (NSData *)archivedDataForFile:(NSString *)path
+{
+    const ZipMountEntry *entry;
+    ScoreArchive *archive = [self archiveForFile:path entry:&entry];
+    if (archive == nil || entry == NULL || [[NSFileManager defaultManager] fileExistsAtPath:path]) {
+        return nil;
+    }
+    return [archive dataForEntry:entry];
+}
+
++ (NSData *)archivedDataForFile:(NSString *)path range:(NSRange)range
+{
+    const ZipMountEntry *entry;
+    ScoreArchive *archive = [self archiveForFile:path entry:&entry];
+    if (archive == nil || entry == NULL || [[NSFileManager defaultManager] fileExistsAtPath:path]) {
+        return nil;
+    }
+    return [archive dataForEntry:entry range:range];
+}
+
+#pragma mark - Private methods
+
+- (id)initWithPath:(NSString *)path
+{
+    self = [super init];
+    mount = ZipMountOpen([path fileSystemRepresentation]);
+    if (mount == NULL) {
+        return nil;
+    }
+    modificationDate = [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] objectForKey:NSFileModificationDate];
+    if (modificationDate == nil) {
+        modificationDate = [NSDate date];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    ZipMountClose(mount);
+}
+
+- (NSData *)dataForEntry:(const ZipMountEntry *)entry
+{
+    const void *bytes = ZipMountMapEntry(mount, entry);
+    if (bytes != NULL) {
+        //The data holds on to the archive so that the mapping outlives it.
+        ScoreArchive *archive = self;
+        return [[NSData alloc] initWithBytesNoCopy:(void *)bytes length:(NSUInteger)entry->size deallocator:^(void *dataBytes, NSUInteger length) {
+            (void)archive;
+        }];
+    }
+    
+    if (entry->stored) {
+        //The local header is damaged.
+        return nil;
+    }
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:(NSUInteger)entry->size];
+    if (data == nil || !ZipMountReadEntry(mount, entry, [data mutableBytes])) {
+        return nil;
+    }
+    return data;
+}
+
+- (NSData *)dataForEntry:(const ZipMountEntry *)entry range:(NSRange)range
+{
+    if (range.location >= entry->size) {
+        return [NSData data];
+    }
+    NSUInteger length = MIN(range.length, (NSUInteger)entry->size - range.location);
+    const uint8_t *bytes = ZipMountMapEntry(mount, entry);
+    if (bytes != NULL) {
+        ScoreArchive *archive = self;
+        return [[NSData alloc] initWithBytesNoCopy:(void *)(bytes + range.location) length:length deallocator:^(void *dataBytes, NSUInteger dataLength) {
+            (void)archive;
+        }];
+    }
+    
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:length];
+    ssize_t bytesRead = data == nil ? -1 : ZipMountReadRange(mount, entry, range.location, [data mutableBytes], length);
+    if (bytesRead < 0) {
+        return nil;
+    }
+    [data setLength:(NSUInteger)bytesRead];
+    return data;
+}
+
++ (void)initArchives
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        archives = [[NSMutableDictionary alloc] init];
+        archivesLock = [[NSLock alloc] init];
+    });
+}
+
++ (ScoreArchive *)archiveForFile:(NSString *)path entry:(const ZipMountEntry **)entry
+{
+    //Work up through the directories that the file is in until one of them has an archive.
+    [self initArchives];
+    *entry = NULL;
+    NSString *directory = [path stringByDeletingLastPathComponent];
+    NSString *entryName = [path lastPathComponent];
+    while ([directory length] > 1) {
+        [archivesLock lock];
+        id archive = [archives objectForKey:directory];
+        [archivesLock unlock];
+        
+        if (archive == nil) {
+            archive = [[ScoreArchive alloc] initWithPath:[directory stringByAppendingPathComponent:SCORE_ARCHIVE_FILE]];
+            [archivesLock lock];
+            //Another thread may have got there first.
+            id existing = [archives objectForKey:directory];
+            if (existing != nil) {
+                archive = existing;
+            } else {
+                [archives setObject:archive == nil ? (id)[NSNull null] : archive forKey:directory];
+            }
+            [archivesLock unlock];
+        }
+        
+        if (archive != nil && archive != [NSNull null]) {
+            const char *name = [entryName UTF8String];
+            *entry = ZipMountFind(((ScoreArchive *)archive)->mount, name, strlen(name));
+            return archive;
+        }
+        entryName = [[directory lastPathComponent] stringByAppendingPathComponent:entryName];
+        directory = [directory stringByDeletingLastPathComponent];
+    }
+    return nil;
+}
+
++ (BOOL)isImageFile:(NSString *)fileName
+{
+    static NSSet *imageExtensions;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        imageExtensions = [NSSet setWithObjects:@"png", @"jpg", @"jpeg", @"gif", @"tif", @"tiff", @"bmp", nil];
+    });
+    return [imageExtensions containsObject:[[fileName pathExtension] lowercaseString]];
+}
+
++ (BOOL)isMediaFile:(NSString *)fileName
+{
+    static NSSet *mediaExtensions;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mediaExtensions = [NSSet setWithObjects:@"m4a", @"mp3", @"aac", @"wav", @"aif", @"aiff", @"caf", @"mp4", @"m4v", @"mov", nil];
+    });
+    return [mediaExtensions containsObject:[[fileName pathExtension] lowercaseString]];
+}
+
+@end
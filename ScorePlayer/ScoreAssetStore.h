@@ -0,0 +1,54 @@
+//
+//  ScoreAssetStore.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+//Keeps one copy of each file that imported scores have in common, so that the tiles and audio
+//shared between versions and variations of a score only take up space once. (See AssetStore.h
+//for how.) The store is a hidden directory inside the scores directory, and it has to be left out
+//of anything that treats the subdirectories there as scores.
+//Each score also records the digest of the archive it was imported from, so that importing the
+//same version again can be skipped.
+//Storing scores and collecting garbage are done one at a time on the store's queue. Swapping a
+//score in the scores directory for a new one doesn't need the queue, since garbage collection only
+//takes files that no score (old or new) links to, but it mustn't happen while the same score is
+//being stored. The swap locks the score's path instead, so it only ever waits for that one score.
+
+@interface ScoreAssetStore : NSObject
+
++ (NSString *)storeDirectoryForScoresDirectory:(NSString *)scoresDirectory;
++ (BOOL)isStoreDirectory:(NSString *)path;
+//A serial queue. It can be busy for a while, so it's best not waited on from the main queue (or
+//from anything the main queue waits on).
++ (dispatch_queue_t)queue;
+//Held while a score is stored or swapped for a new version. Paths are compared once standardised.
++ (void)lockScorePath:(NSString *)scorePath;
++ (void)unlockScorePath:(NSString *)scorePath;
+
+//Replaces the files in an imported score with links to the stored copies, storing any that are
+//new. A score that couldn't be stored is still fine to use, it just doesn't share its files.
+//This locks the score's path while it runs.
++ (BOOL)storeScorePath:(NSString *)scorePath;
+//Stores a score on the store's queue, after anything already queued there. If the score has gone
+//by then it's skipped.
++ (void)storeScorePathInBackground:(NSString *)scorePath;
+//Deletes stored files that no score uses any more. This can take a while for a big library, so it
+//shouldn't be called from the main queue.
++ (void)collectGarbageInScoresDirectory:(NSString *)scoresDirectory;
+//Collects garbage on the store's queue, after anything already queued there.
++ (void)collectGarbageInBackgroundInScoresDirectory:(NSString *)scoresDirectory;
+
+//The SHA-256 of a file as hex, or nil if it can't be read.
++ (NSString *)digestOfFile:(NSString *)path;
++ (NSString *)digestOfData:(NSData *)data;
+//The stored copy of the file with the given digest, or nil if there isn't one.
++ (NSString *)storedFileWithDigest:(NSString *)digest scoresDirectory:(NSString *)scoresDirectory;
++ (BOOL)scorePath:(NSString *)scorePath wasImportedFromArchiveWithDigest:(NSString *)digest;
++ (BOOL)setArchiveDigest:(NSString *)digest forScorePath:(NSString *)scorePath;
+
+@end
@@ -0,0 +1,189 @@
+//
+//  ScoreAssetStore.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ScoreAssetStore.h"
+#import "AssetStore.h"
+
+static NSString *const ASSET_STORE_DIRECTORY = @".assets";
+static NSString *const SCORE_SOURCE_FILE = @".score.source";
+
+//The scores being stored or swapped, guarded by scorePathCondition.
+static NSMutableSet *lockedScorePaths;
+
+@interface ScoreAssetStore ()
+
++ (NSCondition *)scorePathCondition;
++ (BOOL)runIngestion:(AssetStoreIngestion *)ingestion;
++ (NSString *)hexStringForDigest:(const uint8_t *)digest;
+
+@end
+
+@implementation ScoreAssetStore
+
++ (NSString *)storeDirectoryForScoresDirectory:(NSString *)scoresDirectory
+{
+    return [scoresDirectory stringByAppendingPathComponent:ASSET_STORE_DIRECTORY];
+}
+
++ (BOOL)isStoreDirectory:(NSString *)path
+{
+    return [[path lastPathComponent] isEqualToString:ASSET_STORE_DIRECTORY];
+}
+
++ (dispatch_queue_t)queue
+{
+    static dispatch_queue_t storeQueue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        storeQueue = dispatch_queue_create("com.decibel.scoreassetstore", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+    });
+    return storeQueue;
+}
+
++ (void)lockScorePath:(NSString *)scorePath
+{
+    NSString *path = [scorePath stringByStandardizingPath];
+    NSCondition *condition = [self scorePathCondition];
+    [condition lock];
+    while ([lockedScorePaths containsObject:path]) {
+        [condition wait];
+    }
+    [lockedScorePaths addObject:path];
+    [condition unlock];
+}
+
++ (void)unlockScorePath:(NSString *)scorePath
+{
+    NSCondition *condition = [self scorePathCondition];
+    [condition lock];
+    [lockedScorePaths removeObject:[scorePath stringByStandardizingPath]];
+    [condition broadcast];
+    [condition unlock];
+}
+
++ (BOOL)storeScorePath:(NSString *)scorePath
+{
+    //Tile pyramids are rebuilt on demand, and the manifest and source of a score are its own.
+    //(A mounted archive is stored like any other file.)
+    const char *excludedNames[] = {".pyramid", ".score.manifest", ".score.source", NULL};
+    NSString *storeDirectory = [self storeDirectoryForScoresDirectory:[scorePath stringByDeletingLastPathComponent]];
+    [self lockScorePath:scorePath];
+    AssetStoreIngestion *ingestion = AssetStoreIngestionOpen([storeDirectory fileSystemRepresentation], [scorePath fileSystemRepresentation], excludedNames);
+    BOOL success = ingestion != NULL && [self runIngestion:ingestion];
+    AssetStoreIngestionClose(ingestion);
+    [self unlockScorePath:scorePath];
+    return success;
+}
+
++ (void)storeScorePathInBackground:(NSString *)scorePath
+{
+    NSString *path = [scorePath copy];
+    dispatch_async([self queue], ^{
+        if ([[NSFileManager defaultManager] fileExistsAtPath:path]) {
+            @autoreleasepool {
+                [self storeScorePath:path];
+            }
+        }
+    });
+}
+
++ (void)collectGarbageInScoresDirectory:(NSString *)scoresDirectory
+{
+    uint64_t freedBytes = AssetStoreCollectGarbage([[self storeDirectoryForScoresDirectory:scoresDirectory] fileSystemRepresentation]);
+    if (freedBytes > 0) {
+        NSLog(@"Freed %llu bytes of unused assets", freedBytes);
+    }
+}
+
++ (void)collectGarbageInBackgroundInScoresDirectory:(NSString *)scoresDirectory
+{
+    NSString *directory = [scoresDirectory copy];
+    dispatch_async([self queue], ^{
+        [self collectGarbageInScoresDirectory:directory];
+    });
+}
+
++ (NSString *)digestOfFile:(NSString *)path
+{
+    uint8_t digest[ASSET_STORE_DIGEST_LENGTH];
+    if (!AssetStoreDigestFile([path fileSystemRepresentation], digest)) {
+        return nil;
+    }
+    return [self hexStringForDigest:digest];
+}
+
++ (NSString *)digestOfData:(NSData *)data
+{
+    uint8_t digest[ASSET_STORE_DIGEST_LENGTH];
+    AssetStoreDigestBytes([data bytes], [data length], digest);
+    return [self hexStringForDigest:digest];
+}
+
++ (NSString *)storedFileWithDigest:(NSString *)digest scoresDirectory:(NSString *)scoresDirectory
+{
+    //Stored files are named by digest, split after the first byte. (See AssetStore.c.)
+    if ([digest length] != ASSET_STORE_DIGEST_LENGTH * 2) {
+        return nil;
+    }
+    NSString *path = [[[self storeDirectoryForScoresDirectory:scoresDirectory] stringByAppendingPathComponent:[digest substringToIndex:2]] stringByAppendingPathComponent:[digest substringFromIndex:2]];
+    return [[NSFileManager defaultManager] fileExistsAtPath:path] ? path : nil;
+}
+
++ (BOOL)scorePath:(NSString *)scorePath wasImportedFromArchiveWithDigest:(NSString *)digest
+{
+    NSString *source = [NSString stringWithContentsOfFile:[scorePath stringByAppendingPathComponent:SCORE_SOURCE_FILE] encoding:NSUTF8StringEncoding error:nil];
+    return source != nil && [source isEqualToString:digest];
+}
+
++ (BOOL)setArchiveDigest:(NSString *)digest forScorePath:(NSString *)scorePath
+{
+    return [digest writeToFile:[scorePath stringByAppendingPathComponent:SCORE_SOURCE_FILE] atomically:YES encoding:NSUTF8StringEncoding error:nil];
+}
+
+#pragma mark - Private methods
+
++ (NSCondition *)scorePathCondition
+{
+    static NSCondition *condition;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        condition = [[NSCondition alloc] init];
+        lockedScorePaths = [[NSMutableSet alloc] init];
+    });
+    return condition;
+}
+
++ (BOOL)runIngestion:(AssetStoreIngestion *)ingestion
+{
+    size_t workerCount = AssetStoreIngestionWorkerCount(ingestion, [[NSProcessInfo processInfo] activeProcessorCount]);
+    __block BOOL success = YES;
+    if (workerCount == 1) {
+        success = AssetStoreIngestionRunWorker(ingestion);
+    } else {
+        NSLock *successLock = [[NSLock alloc] init];
+        dispatch_apply(workerCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+            if (!AssetStoreIngestionRunWorker(ingestion)) {
+                [successLock lock];
+                success = NO;
+                [successLock unlock];
+            }
+        });
+    }
+    return success;
+}
+
++ (NSString *)hexStringForDigest:(const uint8_t *)digest
+{
+    NSMutableString *hex = [[NSMutableString alloc] initWithCapacity:ASSET_STORE_DIGEST_LENGTH * 2];
+    for (int i = 0; i < ASSET_STORE_DIGEST_LENGTH; i++) {
+        [hex appendFormat:@"%02x", digest[i]];
+    }
+    return hex;
+}
+
+@end
@@ -0,0 +1,417 @@
+//
+//  ScoreBundle.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ScoreBundle.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SCORE_BUNDLE_MAGIC "DBSCORE1"
+#define SCORE_BUNDLE_VERSION 1
+#define SCORE_BUNDLE_COPY_LENGTH 65536
+#define SCORE_BUNDLE_MAX_DEPTH 8
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t signature;
+    uint64_t fileLength;
+    uint64_t directoryOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsLength;
+    uint32_t generatorOffset;
+    uint32_t generatorLength;
+} ScoreBundleHeader;
+
+static const uint8_t zeroes[SCORE_BUNDLE_ALIGNMENT];
+
+static uint64_t hashBytes(uint64_t hash, const void *bytes, size_t length)
+{
+    //FNV-1a
+    const uint8_t *position = bytes;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= position[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t alignUp(uint64_t offset, uint64_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+static bool writeFully(int fd, const void *buffer, size_t length)
+{
+    const uint8_t *position = buffer;
+    while (length > 0) {
+        ssize_t count = write(fd, position, length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        position += count;
+        length -= count;
+    }
+    return true;
+}
+
+static bool writePadding(int fd, uint64_t length)
+{
+    while (length > 0) {
+        size_t chunk = length < sizeof(zeroes) ? (size_t)length : sizeof(zeroes);
+        if (!writeFully(fd, zeroes, chunk)) {
+            return false;
+        }
+        length -= chunk;
+    }
+    return true;
+}
+
+static bool copyFile(int fd, const char *path, uint64_t size, uint8_t *buffer)
+{
+    //The file has to be exactly the size it was when the directory was listed, otherwise the
+    //entry would disagree with the signature.
+    int source = open(path, O_RDONLY);
+    if (source < 0) {
+        return false;
+    }
+    uint64_t copied = 0;
+    bool success = true;
+    while (success) {
+        ssize_t count = read(source, buffer, SCORE_BUNDLE_COPY_LENGTH);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            success = count == 0;
+            break;
+        }
+        copied += (uint64_t)count;
+        success = copied <= size && writeFully(fd, buffer, (size_t)count);
+    }
+    close(source);
+    return success && copied == size;
+}
+
+#pragma mark - Signature
+
+static uint64_t signDirectory(const char *path, size_t rootLength, int depth, uint64_t *fileCount)
+{
+    if (depth > SCORE_BUNDLE_MAX_DEPTH) {
+        return 0;
+    }
+    DIR *directoryStream = opendir(path);
+    if (directoryStream == NULL) {
+        return 0;
+    }
+
+    //Files are combined by adding their hashes, so the order they're listed in doesn't matter.
+    uint64_t sum = 0;
+    size_t pathLength = strlen(path);
+    struct dirent *item;
+    while ((item = readdir(directoryStream)) != NULL) {
+        if (item->d_name[0] == '.') {
+            continue;
+        }
+        size_t nameLength = strlen(item->d_name);
+        char *itemPath = malloc(pathLength + nameLength + 2);
+        if (itemPath == NULL) {
+            continue;
+        }
+        snprintf(itemPath, pathLength + nameLength + 2, "%s/%s", path, item->d_name);
+        struct stat status;
+        if (stat(itemPath, &status) == 0) {
+            if (S_ISDIR(status.st_mode)) {
+                sum += signDirectory(itemPath, rootLength, depth + 1, fileCount);
+            } else if (S_ISREG(status.st_mode)) {
+                int64_t modified[2];
+#ifdef __APPLE__
+                modified[0] = status.st_mtimespec.tv_sec;
+                modified[1] = status.st_mtimespec.tv_nsec;
+#else
+                modified[0] = status.st_mtim.tv_sec;
+                modified[1] = status.st_mtim.tv_nsec;
+#endif
+                uint64_t size = (uint64_t)status.st_size;
+                uint64_t hash = hashBytes(14695981039346656037ULL, itemPath + rootLength, strlen(itemPath + rootLength));
+                hash = hashBytes(hash, &size, sizeof(size));
+                hash = hashBytes(hash, modified, sizeof(modified));
+                sum += hash;
+                (*fileCount)++;
+            }
+        }
+        free(itemPath);
+    }
+    closedir(directoryStream);
+    return sum;
+}
+
+uint64_t ScoreBundleSignature(const char *directory)
+{
+    struct stat status;
+    if (stat(directory, &status) != 0 || !S_ISDIR(status.st_mode)) {
+        return 0;
+    }
+    uint64_t fileCount = 0;
+    uint64_t sum = signDirectory(directory, strlen(directory) + 1, 0, &fileCount);
+    uint64_t signature = hashBytes(sum, &fileCount, sizeof(fileCount));
+    return signature == 0 ? 1 : signature;
+}
+
+#pragma mark - Writing
+
+static int compareItems(const void *first, const void *second)
+{
+    return strcmp((*(const ScoreBundleItem **)first)->name, (*(const ScoreBundleItem **)second)->name);
+}
+
+bool ScoreBundleWrite(const char *path, uint64_t signature, const char *generator, const ScoreBundleItem *items, size_t count)
+{
+    if (count > UINT32_MAX / sizeof(ScoreBundleEntry)) {
+        return false;
+    }
+
+    //Entries are sorted by name so that they can be found with a binary search.
+    const ScoreBundleItem **sorted = malloc((count > 0 ? count : 1) * sizeof(ScoreBundleItem *));
+    if (sorted == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        sorted[i] = &items[i];
+    }
+    qsort(sorted, count, sizeof(ScoreBundleItem *), compareItems);
+
+    ScoreBundleHeader header;
+    memset(&header, 0, sizeof(ScoreBundleHeader));
+    memcpy(header.magic, SCORE_BUNDLE_MAGIC, sizeof(header.magic));
+    header.version = SCORE_BUNDLE_VERSION;
+    header.entryCount = (uint32_t)count;
+    header.signature = signature;
+    header.directoryOffset = alignUp(sizeof(ScoreBundleHeader), 8);
+    header.stringsOffset = header.directoryOffset + count * sizeof(ScoreBundleEntry);
+
+    //Work out where everything goes before writing anything.
+    uint64_t stringsLength = strlen(generator);
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0 && strcmp(sorted[i - 1]->name, sorted[i]->name) == 0) {
+            free(sorted);
+            return false;
+        }
+        stringsLength += strlen(sorted[i]->name);
+    }
+    if (stringsLength > UINT32_MAX) {
+        free(sorted);
+        return false;
+    }
+    header.stringsLength = stringsLength;
+    header.generatorOffset = 0;
+    header.generatorLength = (uint32_t)strlen(generator);
+
+    size_t tableLength = (size_t)(header.stringsOffset + stringsLength);
+    uint8_t *table = calloc(1, tableLength);
+    uint8_t *buffer = malloc(SCORE_BUNDLE_COPY_LENGTH);
+    if (table == NULL || buffer == NULL) {
+        free(table);
+        free(buffer);
+        free(sorted);
+        return false;
+    }
+
+    ScoreBundleEntry *entries = (ScoreBundleEntry *)(table + header.directoryOffset);
+    char *strings = (char *)(table + header.stringsOffset);
+    memcpy(strings, generator, header.generatorLength);
+    uint32_t stringPosition = header.generatorLength;
+    uint64_t blobPosition = alignUp(tableLength, SCORE_BUNDLE_ALIGNMENT);
+    uint64_t fileLength = tableLength;
+    for (size_t i = 0; i < count; i++) {
+        const ScoreBundleItem *item = sorted[i];
+        ScoreBundleEntry *entry = &entries[i];
+        entry->nameOffset = stringPosition;
+        entry->nameLength = (uint32_t)strlen(item->name);
+        memcpy(strings + stringPosition, item->name, entry->nameLength);
+        stringPosition += entry->nameLength;
+        entry->kind = item->kind;
+        entry->width = item->width;
+        entry->height = item->height;
+        entry->size = item->size;
+
+        if (item->contentsPath != NULL && item->size > 0) {
+            entry->dataOffset = blobPosition;
+            entry->dataLength = item->size;
+            fileLength = blobPosition + item->size;
+            blobPosition = alignUp(fileLength, SCORE_BUNDLE_ALIGNMENT);
+        }
+        if (item->parsed != NULL && item->parsedLength > 0) {
+            entry->parsedOffset = blobPosition;
+            entry->parsedLength = item->parsedLength;
+            fileLength = blobPosition + item->parsedLength;
+            blobPosition = alignUp(fileLength, SCORE_BUNDLE_ALIGNMENT);
+        }
+    }
+    header.fileLength = fileLength;
+    memcpy(table, &header, sizeof(ScoreBundleHeader));
+
+    size_t pathLength = strlen(path);
+    char *temporaryPath = malloc(pathLength + 8);
+    int fd = -1;
+    if (temporaryPath != NULL) {
+        snprintf(temporaryPath, pathLength + 8, "%s.XXXXXX", path);
+        fd = mkstemp(temporaryPath);
+    }
+    bool success = fd >= 0 && writeFully(fd, table, tableLength);
+
+    //Then the blobs, in the same order that their offsets were handed out.
+    uint64_t position = tableLength;
+    for (size_t i = 0; i < count && success; i++) {
+        const ScoreBundleEntry *entry = &entries[i];
+        if (entry->dataLength > 0) {
+            success = writePadding(fd, entry->dataOffset - position) && copyFile(fd, sorted[i]->contentsPath, entry->dataLength, buffer);
+            position = entry->dataOffset + entry->dataLength;
+        }
+        if (success && entry->parsedLength > 0) {
+            success = writePadding(fd, entry->parsedOffset - position) && writeFully(fd, sorted[i]->parsed, (size_t)entry->parsedLength);
+            position = entry->parsedOffset + entry->parsedLength;
+        }
+    }
+    free(table);
+    free(buffer);
+    free(sorted);
+
+    if (fd >= 0 && close(fd) != 0) {
+        success = false;
+    }
+    if (success) {
+        success = rename(temporaryPath, path) == 0;
+    }
+    if (!success && fd >= 0) {
+        unlink(temporaryPath);
+    }
+    free(temporaryPath);
+    return success;
+}
+
+#pragma mark - Reading
+
+static bool inBounds(uint64_t offset, uint64_t length, uint64_t limit)
+{
+    return offset <= limit && length <= limit - offset;
+}
+
+static int compareNames(const char *first, size_t firstLength, const char *second, size_t secondLength)
+{
+    int result = memcmp(first, second, firstLength < secondLength ? firstLength : secondLength);
+    if (result != 0) {
+        return result;
+    }
+    return (firstLength > secondLength) - (firstLength < secondLength);
+}
+
+ScoreBundle *ScoreBundleOpen(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (uint64_t)status.st_size < sizeof(ScoreBundleHeader)) {
+        close(fd);
+        return NULL;
+    }
+    size_t length = (size_t)status.st_size;
+    void *mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    //Everything else is checked against the mapping itself, so that a damaged or truncated
+    //file can never lead us outside of it.
+    const ScoreBundleHeader *header = mapping;
+    bool valid = memcmp(header->magic, SCORE_BUNDLE_MAGIC, sizeof(header->magic)) == 0 && header->version == SCORE_BUNDLE_VERSION && header->fileLength == length && header->directoryOffset % 8 == 0 && header->directoryOffset >= sizeof(ScoreBundleHeader) && inBounds(header->directoryOffset, (uint64_t)header->entryCount * sizeof(ScoreBundleEntry), length) && inBounds(header->stringsOffset, header->stringsLength, length) && inBounds(header->generatorOffset, header->generatorLength, header->stringsLength);
+
+    const ScoreBundleEntry *entries = valid ? (const ScoreBundleEntry *)((const uint8_t *)mapping + header->directoryOffset) : NULL;
+    const char *strings = valid ? (const char *)mapping + header->stringsOffset : NULL;
+    for (uint32_t i = 0; valid && i < header->entryCount; i++) {
+        const ScoreBundleEntry *entry = &entries[i];
+        valid = inBounds(entry->nameOffset, entry->nameLength, header->stringsLength) && inBounds(entry->dataOffset, entry->dataLength, length) && inBounds(entry->parsedOffset, entry->parsedLength, length);
+        //The names need to be in order for lookups to work.
+        if (valid && i > 0) {
+            const ScoreBundleEntry *previous = &entries[i - 1];
+            valid = compareNames(strings + previous->nameOffset, previous->nameLength, strings + entry->nameOffset, entry->nameLength) < 0;
+        }
+    }
+
+    ScoreBundle *bundle = valid ? malloc(sizeof(ScoreBundle)) : NULL;
+    if (bundle == NULL) {
+        munmap(mapping, length);
+        return NULL;
+    }
+    bundle->mapping = mapping;
+    bundle->length = length;
+    bundle->signature = header->signature;
+    bundle->entries = entries;
+    bundle->entryCount = header->entryCount;
+    bundle->strings = strings;
+    bundle->generator = strings + header->generatorOffset;
+    bundle->generatorLength = header->generatorLength;
+    return bundle;
+}
+
+void ScoreBundleClose(ScoreBundle *bundle)
+{
+    if (bundle == NULL) {
+        return;
+    }
+    munmap(bundle->mapping, bundle->length);
+    free(bundle);
+}
+
+const ScoreBundleEntry *ScoreBundleFind(const ScoreBundle *bundle, const char *name, size_t nameLength)
+{
+    size_t low = 0;
+    size_t high = bundle->entryCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        const ScoreBundleEntry *entry = &bundle->entries[middle];
+        int result = compareNames(bundle->strings + entry->nameOffset, entry->nameLength, name, nameLength);
+        if (result == 0) {
+            return entry;
+        } else if (result < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return NULL;
+}
+
+const void *ScoreBundleData(const ScoreBundle *bundle, const ScoreBundleEntry *entry)
+{
+    if (entry->dataLength == 0) {
+        return NULL;
+    }
+    return (const uint8_t *)bundle->mapping + entry->dataOffset;
+}
+
+const void *ScoreBundleParsed(const ScoreBundle *bundle, const ScoreBundleEntry *entry)
+{
+    if (entry->parsedLength == 0) {
+        return NULL;
+    }
+    return (const uint8_t *)bundle->mapping + entry->parsedOffset;
+}
@@ -0,0 +1,94 @@
+//
+//  ScoreBundle.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//A compiled form of a score directory, kept in a single file that is opened with one mmap.
+//The file is laid out as a header, a directory of entries sorted by name, a string table and
+//then the blobs, each of which starts on a page boundary so that it can be used straight from
+//the mapping. Every file in the score directory gets an entry recording its size (and for
+//images, their dimensions), whether or not its contents are embedded. An entry can also carry
+//a pre-parsed form of the file, whose format is up to the caller.
+//A bundle records a signature of the directory it was built from (see ScoreBundleSignature),
+//so that a stale bundle can be recognised and rebuilt.
+
+#ifndef ScoreBundle_h
+#define ScoreBundle_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//16KB is the page size on 64 bit iOS devices.
+#define SCORE_BUNDLE_ALIGNMENT 16384
+
+typedef enum {
+    kScoreBundleFile = 0,
+    kScoreBundleImage = 1,
+    kScoreBundleXML = 2
+} ScoreBundleKind;
+
+typedef struct {
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t kind;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+    //The size of the original file.
+    uint64_t size;
+    //Both of these have a length of 0 if they aren't present.
+    uint64_t dataOffset;
+    uint64_t dataLength;
+    uint64_t parsedOffset;
+    uint64_t parsedLength;
+} ScoreBundleEntry;
+
+typedef struct {
+    void *mapping;
+    size_t length;
+    uint64_t signature;
+    const ScoreBundleEntry *entries;
+    size_t entryCount;
+    const char *strings;
+    //The generator string given when the bundle was written. (Not NUL terminated.)
+    const char *generator;
+    size_t generatorLength;
+} ScoreBundle;
+
+//Describes a file to be written into a bundle. Names are paths relative to the score directory.
+//If contentsPath is set, the file at that path is copied in, and must still be the given size.
+typedef struct {
+    const char *name;
+    ScoreBundleKind kind;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+    const char *contentsPath;
+    const void *parsed;
+    size_t parsedLength;
+} ScoreBundleItem;
+
+//A signature of the names, sizes and modification times of every file in a directory and its
+//subdirectories. Hidden files and directories are skipped. Returns 0 if the directory can't
+//be read.
+uint64_t ScoreBundleSignature(const char *directory);
+
+//Writes a bundle via a temporary file, so that a partly written bundle is never opened. The
+//generator string lets the caller tell which version of itself made the parsed data.
+bool ScoreBundleWrite(const char *path, uint64_t signature, const char *generator, const ScoreBundleItem *items, size_t count);
+
+//Maps a bundle and checks that everything in it is in bounds. Returns NULL if the file is
+//missing or damaged. Comparing the signature is left to the caller.
+ScoreBundle *ScoreBundleOpen(const char *path);
+void ScoreBundleClose(ScoreBundle *bundle);
+
+//Finds an entry by name with a binary search. Returns NULL if there's no such file.
+const ScoreBundleEntry *ScoreBundleFind(const ScoreBundle *bundle, const char *name, size_t nameLength);
+const void *ScoreBundleData(const ScoreBundle *bundle, const ScoreBundleEntry *entry);
+const void *ScoreBundleParsed(const ScoreBundle *bundle, const ScoreBundleEntry *entry);
+
+#endif /* ScoreBundle_h */
@@ -0,0 +1,40 @@
+//
+//  ScoreClock.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class ScoreClock;
+
+@protocol ScoreClockDelegate <NSObject>
+
+//The tick count is absolute: tick n falls at a position of n * tickInterval seconds.
+- (void)scoreClock:(ScoreClock *)scoreClock tick:(NSInteger)tickCount;
+
+@end
+
+//Score time derived from a monotonic time source rather than counted timer firings. The
+//position is always startPosition + (now - startTime), and each tick is scheduled for its
+//own boundary, so late timer callbacks never push back the ticks that follow them.
+@interface ScoreClock : NSObject
+
+@property (nonatomic, weak) id<ScoreClockDelegate> delegate;
+@property (nonatomic) NSTimeInterval tickInterval;
+@property (nonatomic, readonly) BOOL isRunning;
+@property (nonatomic, readonly) NSTimeInterval position;
+
+//Replaces the monotonic system clock. Used to run the clock against simulated time, in which
+//case fireDueTicks should be called whenever the simulated time is advanced.
+@property (nonatomic, copy) NSTimeInterval (^timeSource)(void);
+
+- (id)initWithTickInterval:(NSTimeInterval)interval delegate:(id<ScoreClockDelegate>)delegate;
+
+- (void)startAtPosition:(NSTimeInterval)startPosition;
+- (void)stop;
+- (void)fireDueTicks;
+
+@end
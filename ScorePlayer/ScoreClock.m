@@ -0,0 +1,137 @@
+//
+//  ScoreClock.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ScoreClock.h"
+#import <QuartzCore/QuartzCore.h>
+
+//Allow for floating point error when deciding whether a tick boundary has been reached.
+static const NSTimeInterval kBoundaryTolerance = 0.000001;
+
+@interface ScoreClock ()
+
+- (NSTimeInterval)now;
+- (void)scheduleNextTick;
+
+@end
+
+@implementation ScoreClock {
+    NSTimeInterval startTime;
+    NSTimeInterval startPosition;
+    NSTimeInterval stoppedPosition;
+    NSInteger nextTick;
+    dispatch_source_t timer;
+}
+
+@synthesize delegate, tickInterval, isRunning, timeSource;
+
+- (id)init
+{
+    return [self initWithTickInterval:1 delegate:nil];
+}
+
+- (id)initWithTickInterval:(NSTimeInterval)interval delegate:(id<ScoreClockDelegate>)clockDelegate
+{
+    self = [super init];
+    tickInterval = interval;
+    delegate = clockDelegate;
+    isRunning = NO;
+    stoppedPosition = 0;
+    return self;
+}
+
+- (void)dealloc
+{
+    if (timer != nil) {
+        dispatch_source_cancel(timer);
+    }
+}
+
+- (NSTimeInterval)position
+{
+    if (!isRunning) {
+        return stoppedPosition;
+    }
+    return startPosition + [self now] - startTime;
+}
+
+- (void)startAtPosition:(NSTimeInterval)position
+{
+    [self stop];
+    if (tickInterval <= 0) {
+        return;
+    }
+    startPosition = position;
+    startTime = [self now];
+    isRunning = YES;
+    
+    //The first tick is the first boundary after our starting position.
+    nextTick = (NSInteger)floor(position / tickInterval + kBoundaryTolerance) + 1;
+    [self scheduleNextTick];
+}
+
+- (void)stop
+{
+    if (isRunning) {
+        stoppedPosition = self.position;
+        isRunning = NO;
+    }
+    if (timer != nil) {
+        dispatch_source_cancel(timer);
+        timer = nil;
+    }
+}
+
+- (void)fireDueTicks
+{
+    //Deliver every tick that is due, in order. If we've fallen behind, this catches up
+    //without changing where any of the later ticks fall.
+    while (isRunning && nextTick * tickInterval <= self.position + kBoundaryTolerance) {
+        NSInteger tickCount = nextTick;
+        nextTick++;
+        [delegate scoreClock:self tick:tickCount];
+    }
+    if (isRunning && timeSource == nil) {
+        [self scheduleNextTick];
+    }
+}
+
+#pragma mark - Private methods
+
+- (NSTimeInterval)now
+{
+    if (timeSource != nil) {
+        return timeSource();
+    }
+    return CACurrentMediaTime();
+}
+
+- (void)scheduleNextTick
+{
+    //Simulated time is driven manually.
+    if (timeSource != nil) {
+        return;
+    }
+    
+    if (timer == nil) {
+        timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, DISPATCH_TIMER_STRICT, dispatch_get_main_queue());
+        __weak ScoreClock *weakSelf = self;
+        dispatch_source_set_event_handler(timer, ^{
+            [weakSelf fireDueTicks];
+        });
+        dispatch_resume(timer);
+    }
+    
+    //Arm a one shot timer against the absolute boundary of the next tick.
+    NSTimeInterval delay = nextTick * tickInterval - self.position;
+    if (delay < 0) {
+        delay = 0;
+    }
+    dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, NSEC_PER_MSEC);
+}
+
+@end
@@ -0,0 +1,44 @@
+//
+//  ScoreLibrary.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OpusParser.h"
+
+//Keeps an index of the parsed contents of each score directory in a binary property list, so
+//that the library can be loaded without parsing every opus file. A directory is only parsed
+//again if it, or its opus file, has changed since the index was written, or if one of its
+//thumbnails has gone missing. The whole index is discarded when the app is updated, since the
+//set of valid renderers may have changed.
+
+@interface ScoreLibraryEntry : NSObject
+
+@property (nonatomic, strong) NSString *scorePath;
+@property (nonatomic, strong) NSArray *scores;
+@property (nonatomic, strong) NSString *updateURL;
+@property (nonatomic, strong) NSString *opusVersion;
+@property (nonatomic) BOOL corrupt;
+
+@end
+
+@interface ScoreLibrary : NSObject <OpusParserDelegate>
+
+@property (nonatomic, readonly) NSString *indexPath;
+//Where the thumbnails and annotations of the scores built into the app are kept.
+@property (nonatomic, strong) NSString *bundledThumbnailPath;
+@property (nonatomic, strong) NSString *bundledAnnotationsPath;
+//The number of directories that were parsed rather than read from the index on the last load.
+@property (nonatomic, readonly) NSInteger parsedCount;
+
+- (id)initWithIndexPath:(NSString *)path;
+
+//Returns an entry for each of the given score directories (preceded by the bundled scores if
+//requested) in order. Changed directories are parsed in parallel, and the index is saved
+//afterwards if anything was parsed.
+- (NSArray *)loadScoreDirectories:(NSArray *)scoreDirectories includeBundledScores:(BOOL)includeBundled;
+
+@end
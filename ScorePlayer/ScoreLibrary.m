@@ -0,0 +1,349 @@
+//
+//  ScoreLibrary.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ScoreLibrary.h"
+#import "Score.h"
+#import "ScoreArchive.h"
+
+static const NSInteger SCORE_LIBRARY_INDEX_VERSION = 1;
+//Can't clash with a score directory name, since those never contain a slash.
+static NSString *const BUNDLED_SCORES_KEY = @"/Bundled";
+
+@implementation ScoreLibraryEntry
+
+@synthesize scorePath, scores, updateURL, opusVersion, corrupt;
+
+@end
+
+@interface ScoreLibrary ()
+
+- (void)loadIndex;
+- (BOOL)saveIndex;
+- (NSString *)keyForScorePath:(NSString *)scorePath;
+- (NSString *)opusFileForScorePath:(NSString *)scorePath;
+- (NSString *)thumbnailPathForScorePath:(NSString *)scorePath;
+- (NSDictionary *)signatureForScorePath:(NSString *)scorePath;
+- (BOOL)indexEntry:(NSDictionary *)indexEntry isCurrentForScorePath:(NSString *)scorePath withSignature:(NSDictionary *)signature;
+- (ScoreLibraryEntry *)entryFromIndexEntry:(NSDictionary *)indexEntry scorePath:(NSString *)scorePath;
+- (NSDictionary *)indexEntryFromEntry:(ScoreLibraryEntry *)entry withSignature:(NSDictionary *)signature;
+- (ScoreLibraryEntry *)parseScorePath:(NSString *)scorePath;
+
+@end
+
+@implementation ScoreLibrary {
+    NSMutableDictionary *index;
+    NSString *libraryDirectory;
+    NSString *bundlePath;
+    NSString *appVersion;
+    NSFileManager *fileManager;
+    
+    NSLock *resultsLock;
+    NSMutableDictionary *parseResults;
+}
+
+@synthesize indexPath, bundledThumbnailPath, bundledAnnotationsPath, parsedCount;
+
+- (id)initWithIndexPath:(NSString *)path
+{
+    self = [super init];
+    indexPath = path;
+    bundlePath = [[NSBundle mainBundle] bundlePath];
+    appVersion = [NSString stringWithFormat:@"%@ (%@)", [[NSBundle mainBundle] objectForInfoDictionaryKey:@"CFBundleShortVersionString"], [[NSBundle mainBundle] objectForInfoDictionaryKey:@"CFBundleVersion"]];
+    fileManager = [NSFileManager defaultManager];
+    resultsLock = [[NSLock alloc] init];
+    parseResults = [[NSMutableDictionary alloc] init];
+    parsedCount = 0;
+    return self;
+}
+
+- (NSArray *)loadScoreDirectories:(NSArray *)scoreDirectories includeBundledScores:(BOOL)includeBundled
+{
+    if (index == nil) {
+        [self loadIndex];
+    }
+    
+    NSMutableArray *scorePaths = [[NSMutableArray alloc] init];
+    if (includeBundled) {
+        [scorePaths addObject:bundlePath];
+    }
+    [scorePaths addObjectsFromArray:scoreDirectories];
+    if ([scoreDirectories count] > 0) {
+        libraryDirectory = [[scoreDirectories objectAtIndex:0] stringByDeletingLastPathComponent];
+    }
+    
+    //Use the index wherever it's still current, and make a list of what needs parsing.
+    NSMutableArray *entries = [[NSMutableArray alloc] initWithCapacity:[scorePaths count]];
+    NSMutableArray *signatures = [[NSMutableArray alloc] initWithCapacity:[scorePaths count]];
+    NSMutableArray *changed = [[NSMutableArray alloc] init];
+    for (int i = 0; i < [scorePaths count]; i++) {
+        NSString *scorePath = [scorePaths objectAtIndex:i];
+        NSDictionary *signature = [self signatureForScorePath:scorePath];
+        NSDictionary *indexEntry = [index objectForKey:[self keyForScorePath:scorePath]];
+        ScoreLibraryEntry *entry = nil;
+        if ([self indexEntry:indexEntry isCurrentForScorePath:scorePath withSignature:signature]) {
+            entry = [self entryFromIndexEntry:indexEntry scorePath:scorePath];
+        }
+        
+        if (entry != nil) {
+            [entries addObject:entry];
+        } else {
+            [entries addObject:[NSNull null]];
+            [changed addObject:[NSNumber numberWithInt:i]];
+        }
+        [signatures addObject:signature == nil ? (id)[NSNull null] : signature];
+    }
+    
+    //Parse the rest in parallel. dispatch_apply limits the number running at once to the
+    //number of cores, and returns once they've all finished.
+    NSMutableArray *parsedEntries = [[NSMutableArray alloc] initWithCapacity:[changed count]];
+    for (int i = 0; i < [changed count]; i++) {
+        [parsedEntries addObject:[NSNull null]];
+    }
+    NSLock *parsedLock = [[NSLock alloc] init];
+    dispatch_apply([changed count], dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        @autoreleasepool {
+            NSInteger position = [[changed objectAtIndex:i] integerValue];
+            ScoreLibraryEntry *entry = [self parseScorePath:[scorePaths objectAtIndex:position]];
+            [parsedLock lock];
+            [parsedEntries replaceObjectAtIndex:i withObject:entry];
+            [parsedLock unlock];
+        }
+    });
+    
+    for (int i = 0; i < [changed count]; i++) {
+        NSInteger position = [[changed objectAtIndex:i] integerValue];
+        ScoreLibraryEntry *entry = [parsedEntries objectAtIndex:i];
+        [entries replaceObjectAtIndex:position withObject:entry];
+        id signature = [signatures objectAtIndex:position];
+        //Corrupt scores aren't kept, so that they're checked again next time.
+        if (signature != [NSNull null] && !entry.corrupt) {
+            [index setObject:[self indexEntryFromEntry:entry withSignature:signature] forKey:[self keyForScorePath:entry.scorePath]];
+        } else {
+            [index removeObjectForKey:[self keyForScorePath:entry.scorePath]];
+        }
+    }
+    parsedCount = [changed count];
+    
+    if (parsedCount > 0) {
+        [self saveIndex];
+    }
+    return entries;
+}
+
+- (void)loadIndex
+{
+    NSData *indexData = [NSData dataWithContentsOfFile:indexPath];
+    if (indexData != nil) {
+        NSDictionary *savedIndex = [NSPropertyListSerialization propertyListWithData:indexData options:NSPropertyListMutableContainers format:NULL error:nil];
+        //Start again if the index is from a different version of the app.
+        if ([savedIndex isKindOfClass:[NSDictionary class]] && [[savedIndex objectForKey:@"indexVersion"] integerValue] == SCORE_LIBRARY_INDEX_VERSION && [[savedIndex objectForKey:@"appVersion"] isEqualToString:appVersion]) {
+            index = [savedIndex objectForKey:@"directories"];
+        }
+    }
+    if (![index isKindOfClass:[NSMutableDictionary class]]) {
+        index = [[NSMutableDictionary alloc] init];
+    }
+}
+
+- (BOOL)saveIndex
+{
+    //Drop any directories that have since been removed.
+    if (libraryDirectory != nil) {
+        NSArray *keys = [index allKeys];
+        for (int i = 0; i < [keys count]; i++) {
+            NSString *key = [keys objectAtIndex:i];
+            if (![key isEqualToString:BUNDLED_SCORES_KEY] && ![fileManager fileExistsAtPath:[libraryDirectory stringByAppendingPathComponent:key]]) {
+                [index removeObjectForKey:key];
+            }
+        }
+    }
+    
+    NSMutableDictionary *savedIndex = [[NSMutableDictionary alloc] init];
+    [savedIndex setObject:[NSNumber numberWithInteger:SCORE_LIBRARY_INDEX_VERSION] forKey:@"indexVersion"];
+    [savedIndex setObject:appVersion forKey:@"appVersion"];
+    [savedIndex setObject:index forKey:@"directories"];
+    
+    NSData *indexData = [NSPropertyListSerialization dataWithPropertyList:savedIndex format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+    if (indexData == nil) {
+        return NO;
+    }
+    [fileManager createDirectoryAtPath:[indexPath stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+    return [indexData writeToFile:indexPath atomically:YES];
+}
+
+- (NSString *)keyForScorePath:(NSString *)scorePath
+{
+    //Index entries are stored by directory name, since the path of the app's container
+    //can change between launches.
+    if ([scorePath isEqualToString:bundlePath]) {
+        return BUNDLED_SCORES_KEY;
+    }
+    return [scorePath lastPathComponent];
+}
+
+- (NSString *)opusFileForScorePath:(NSString *)scorePath
+{
+    if ([scorePath isEqualToString:bundlePath]) {
+        return [[NSBundle mainBundle] pathForResource:@"Bundled" ofType:@"xml"];
+    }
+    return [scorePath stringByAppendingPathComponent:@"opus.xml"];
+}
+
+- (NSString *)thumbnailPathForScorePath:(NSString *)scorePath
+{
+    if ([scorePath isEqualToString:bundlePath] && bundledThumbnailPath != nil) {
+        return bundledThumbnailPath;
+    }
+    return scorePath;
+}
+
+- (NSDictionary *)signatureForScorePath:(NSString *)scorePath
+{
+    //The directory's modification date changes when files are added, removed or replaced in
+    //it. The opus file is checked separately in case it's been edited in place.
+    NSDictionary *directoryAttributes = [fileManager attributesOfItemAtPath:scorePath error:nil];
+    NSDictionary *opusAttributes = [ScoreArchive attributesOfItemAtPath:[self opusFileForScorePath:scorePath]];
+    if (directoryAttributes == nil || opusAttributes == nil) {
+        return nil;
+    }
+    
+    NSMutableDictionary *signature = [[NSMutableDictionary alloc] init];
+    [signature setObject:[directoryAttributes objectForKey:NSFileModificationDate] forKey:@"directoryModified"];
+    [signature setObject:[opusAttributes objectForKey:NSFileModificationDate] forKey:@"opusModified"];
+    [signature setObject:[opusAttributes objectForKey:NSFileSize] forKey:@"opusSize"];
+    return signature;
+}
+
+- (BOOL)indexEntry:(NSDictionary *)indexEntry isCurrentForScorePath:(NSString *)scorePath withSignature:(NSDictionary *)signature
+{
+    if (indexEntry == nil || signature == nil || ![[indexEntry objectForKey:@"signature"] isEqualToDictionary:signature]) {
+        return NO;
+    }
+    
+    //Regenerate any thumbnails that have been deleted.
+    NSString *thumbnailPath = [self thumbnailPathForScorePath:scorePath];
+    NSArray *thumbnails = [indexEntry objectForKey:@"thumbnails"];
+    for (int i = 0; i < [thumbnails count]; i++) {
+        if (![fileManager fileExistsAtPath:[thumbnailPath stringByAppendingPathComponent:[thumbnails objectAtIndex:i]]]) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (ScoreLibraryEntry *)entryFromIndexEntry:(NSDictionary *)indexEntry scorePath:(NSString *)scorePath
+{
+    BOOL isBundle = [scorePath isEqualToString:bundlePath];
+    NSArray *savedScores = [indexEntry objectForKey:@"scores"];
+    NSMutableArray *entryScores = [[NSMutableArray alloc] initWithCapacity:[savedScores count]];
+    for (int i = 0; i < [savedScores count]; i++) {
+        Score *score = [[Score alloc] initWithPropertyList:[savedScores objectAtIndex:i]];
+        if (score == nil) {
+            return nil;
+        }
+        score.scorePath = scorePath;
+        if (isBundle && bundledAnnotationsPath != nil) {
+            score.annotationsPathOverride = [bundledAnnotationsPath stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.%@", score.composerFullText, score.scoreName]];
+        }
+        [entryScores addObject:score];
+    }
+    
+    ScoreLibraryEntry *entry = [[ScoreLibraryEntry alloc] init];
+    entry.scorePath = scorePath;
+    entry.scores = entryScores;
+    entry.updateURL = [indexEntry objectForKey:@"updateURL"];
+    entry.opusVersion = [indexEntry objectForKey:@"opusVersion"];
+    entry.corrupt = [[indexEntry objectForKey:@"corrupt"] boolValue];
+    return entry;
+}
+
+- (NSDictionary *)indexEntryFromEntry:(ScoreLibraryEntry *)entry withSignature:(NSDictionary *)signature
+{
+    NSMutableDictionary *indexEntry = [[NSMutableDictionary alloc] init];
+    NSMutableArray *savedScores = [[NSMutableArray alloc] initWithCapacity:[entry.scores count]];
+    NSMutableArray *thumbnails = [[NSMutableArray alloc] init];
+    NSString *thumbnailPath = [self thumbnailPathForScorePath:entry.scorePath];
+    for (int i = 0; i < [entry.scores count]; i++) {
+        Score *score = [entry.scores objectAtIndex:i];
+        [savedScores addObject:[score propertyListRepresentation]];
+        //Only keep track of thumbnails that the renderer was able to make.
+        if ([fileManager fileExistsAtPath:[thumbnailPath stringByAppendingPathComponent:score.thumbnailFileName]]) {
+            [thumbnails addObject:score.thumbnailFileName];
+        }
+    }
+    
+    [indexEntry setObject:signature forKey:@"signature"];
+    [indexEntry setObject:savedScores forKey:@"scores"];
+    [indexEntry setObject:thumbnails forKey:@"thumbnails"];
+    if (entry.updateURL != nil) {
+        [indexEntry setObject:entry.updateURL forKey:@"updateURL"];
+    }
+    if (entry.opusVersion != nil) {
+        [indexEntry setObject:entry.opusVersion forKey:@"opusVersion"];
+    }
+    [indexEntry setObject:[NSNumber numberWithBool:entry.corrupt] forKey:@"corrupt"];
+    return indexEntry;
+}
+
+- (ScoreLibraryEntry *)parseScorePath:(NSString *)scorePath
+{
+    NSData *xmlScore = [ScoreArchive dataWithContentsOfFile:[self opusFileForScorePath:scorePath]];
+    OpusParser *parser = [[OpusParser alloc] initWithData:xmlScore scorePath:scorePath timeOut:5 asScoreComponent:NO];
+    if ([scorePath isEqualToString:bundlePath]) {
+        parser.thumbnailPath = bundledThumbnailPath;
+        parser.annotationsPath = bundledAnnotationsPath;
+    }
+    parser.delegate = self;
+    //The parser calls back before this returns.
+    [parser startParse];
+    
+    [resultsLock lock];
+    ScoreLibraryEntry *entry = [parseResults objectForKey:scorePath];
+    [parseResults removeObjectForKey:scorePath];
+    [resultsLock unlock];
+    
+    if (entry == nil) {
+        entry = [[ScoreLibraryEntry alloc] init];
+        entry.scorePath = scorePath;
+        entry.scores = [NSArray array];
+        entry.corrupt = YES;
+    }
+    return entry;
+}
+
+#pragma mark - OpusParser delegate
+
+- (void)parserFinished:(id)parser withScores:(NSMutableArray *)newScores
+{
+    ((OpusParser *)parser).delegate = nil;
+    ScoreLibraryEntry *entry = [[ScoreLibraryEntry alloc] init];
+    entry.scorePath = ((OpusParser *)parser).scorePath;
+    entry.scores = newScores;
+    entry.updateURL = ((OpusParser *)parser).updateURL;
+    entry.opusVersion = ((OpusParser *)parser).opusVersion;
+    entry.corrupt = NO;
+    
+    [resultsLock lock];
+    [parseResults setObject:entry forKey:entry.scorePath];
+    [resultsLock unlock];
+}
+
+- (void)parserError:(id)parser
+{
+    ((OpusParser *)parser).delegate = nil;
+    ScoreLibraryEntry *entry = [[ScoreLibraryEntry alloc] init];
+    entry.scorePath = ((OpusParser *)parser).scorePath;
+    entry.scores = [NSArray array];
+    entry.corrupt = YES;
+    
+    [resultsLock lock];
+    [parseResults setObject:entry forKey:entry.scorePath];
+    [resultsLock unlock];
+}
+
+@end
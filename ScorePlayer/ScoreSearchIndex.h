@@ -0,0 +1,28 @@
+//
+//  ScoreSearchIndex.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+//A search index over a list of entries with a fixed number of text fields, for filtering the
+//score lists as someone types into a search bar. Matching ignores case and diacritics, and
+//results are ranked (see TrigramIndex.h). Searches that extend the previous one only look
+//through its results. An index describes the entries as they were when it was built, so make
+//a new one whenever the list changes.
+
+@interface ScoreSearchIndex : NSObject
+
+@property (nonatomic, readonly) NSInteger count;
+
+- (id)initWithFieldCount:(NSInteger)fieldCount;
+//Entries are numbered from 0 in the order they're added. Any fields missing from the end of
+//the array are left empty.
+- (void)addEntryWithFields:(NSArray *)fields;
+//Returns the numbers of the matching entries, best match first.
+- (NSArray *)search:(NSString *)text;
+
+@end
@@ -0,0 +1,100 @@
+//
+//  ScoreSearchIndex.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ScoreSearchIndex.h"
+#import "TrigramIndex.h"
+
+@interface ScoreSearchIndex ()
+
++ (NSData *)foldedText:(NSString *)text;
+
+@end
+
+@implementation ScoreSearchIndex {
+    TrigramIndex *index;
+    TrigramSearch search;
+    NSInteger fieldCount;
+}
+
+@synthesize count;
+
+- (id)initWithFieldCount:(NSInteger)fields
+{
+    self = [super init];
+    fieldCount = fields;
+    index = TrigramIndexCreate(fieldCount);
+    if (index == NULL) {
+        return nil;
+    }
+    TrigramSearchInit(&search);
+    count = 0;
+    return self;
+}
+
+- (void)dealloc
+{
+    TrigramSearchRelease(&search);
+    TrigramIndexDestroy(index);
+}
+
++ (NSData *)foldedText:(NSString *)text
+{
+    //Fold the text the same way for entries and searches, so that a plain byte comparison
+    //behaves like a case and diacritic insensitive search.
+    NSString *folded = [text stringByFoldingWithOptions:(NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch) locale:nil];
+    return [folded dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (void)addEntryWithFields:(NSArray *)fields
+{
+    if (index == NULL) {
+        return;
+    }
+    
+    NSMutableArray *foldedFields = [[NSMutableArray alloc] initWithCapacity:fieldCount];
+    const char *fieldBytes[fieldCount];
+    size_t fieldLengths[fieldCount];
+    for (int i = 0; i < fieldCount; i++) {
+        NSData *folded = nil;
+        if (i < [fields count] && [[fields objectAtIndex:i] isKindOfClass:[NSString class]]) {
+            folded = [ScoreSearchIndex foldedText:[fields objectAtIndex:i]];
+        }
+        if (folded == nil) {
+            folded = [NSData data];
+        }
+        [foldedFields addObject:folded];
+        fieldBytes[i] = [folded bytes];
+        fieldLengths[i] = [folded length];
+    }
+    
+    //If we run out of memory the entry numbers would no longer line up, so give up on the
+    //index altogether. (Searches then find nothing.)
+    if (TrigramIndexAdd(index, fieldBytes, fieldLengths)) {
+        count++;
+    } else {
+        TrigramIndexDestroy(index);
+        index = NULL;
+    }
+}
+
+- (NSArray *)search:(NSString *)text
+{
+    if (index == NULL) {
+        return [NSArray array];
+    }
+    
+    NSData *query = [ScoreSearchIndex foldedText:text];
+    size_t matchCount = TrigramSearchRun(&search, index, [query bytes], [query length]);
+    NSMutableArray *results = [[NSMutableArray alloc] initWithCapacity:matchCount];
+    for (size_t i = 0; i < matchCount; i++) {
+        [results addObject:[NSNumber numberWithUnsignedInt:search.matches[i].document]];
+    }
+    return results;
+}
+
+@end
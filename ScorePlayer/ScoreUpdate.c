@@ -0,0 +1,314 @@
+//
+//  ScoreUpdate.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ScoreUpdate.h"
+#include <CommonCrypto/CommonDigest.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SCORE_UPDATE_MANIFEST_HEADER "ScorePlayer update 1\n"
+#define SCORE_UPDATE_DELTA_MAGIC "SPDELTA1"
+#define SCORE_UPDATE_DELTA_COPY 0x01
+#define SCORE_UPDATE_DELTA_ADD 0x02
+//Added bytes are passed through a buffer of this size.
+#define SCORE_UPDATE_BUFFER_LENGTH (64 * 1024)
+
+struct ScoreUpdateManifest {
+    //The manifest, with each name NUL terminated in place.
+    char *text;
+    ScoreUpdateFile *files;
+    size_t fileCount;
+    ScoreUpdateDelta *deltas;
+    size_t deltaCount;
+};
+
+static bool parseDigest(const char *field, char digest[SCORE_UPDATE_DIGEST_LENGTH], const char **end);
+static bool parseSize(const char *field, uint64_t *size, const char **end);
+static bool isSafeName(const char *name);
+static bool readAll(FILE *file, uint8_t *bytes, size_t length);
+static bool writeAll(int fd, const uint8_t *bytes, size_t length);
+static uint64_t readLittleEndian(const uint8_t *bytes, int length);
+static void formatDigest(const uint8_t *digest, char hex[SCORE_UPDATE_DIGEST_LENGTH]);
+
+#pragma mark - Public functions
+
+ScoreUpdateManifest *ScoreUpdateManifestParse(const char *text, size_t length)
+{
+    size_t headerLength = strlen(SCORE_UPDATE_MANIFEST_HEADER);
+    if (length < headerLength || memcmp(text, SCORE_UPDATE_MANIFEST_HEADER, headerLength) != 0 || memchr(text, '\0', length) != NULL) {
+        return NULL;
+    }
+    //There can't be more files or deltas than lines.
+    size_t lineCount = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '\n') {
+            lineCount++;
+        }
+    }
+    ScoreUpdateManifest *manifest = calloc(1, sizeof(ScoreUpdateManifest));
+    if (manifest == NULL) {
+        return NULL;
+    }
+    manifest->text = malloc(length + 1);
+    manifest->files = calloc(lineCount, sizeof(ScoreUpdateFile));
+    manifest->deltas = calloc(lineCount, sizeof(ScoreUpdateDelta));
+    if (manifest->text == NULL || manifest->files == NULL || manifest->deltas == NULL) {
+        ScoreUpdateManifestFree(manifest);
+        return NULL;
+    }
+    memcpy(manifest->text, text, length);
+    manifest->text[length] = '\0';
+
+    char *line = manifest->text + headerLength;
+    char *end = manifest->text + length;
+    bool success = true;
+    while (success && line < end) {
+        char *newline = memchr(line, '\n', (size_t)(end - line));
+        if (newline == NULL) {
+            //The last line has to be finished, so that a manifest that's been cut short is noticed.
+            success = false;
+            break;
+        }
+        *newline = '\0';
+        if (newline > line && newline[-1] == '\r') {
+            newline[-1] = '\0';
+        }
+
+        //Lines of any other kind are left for later versions of the format.
+        const char *field = NULL;
+        if (strncmp(line, "file ", 5) == 0) {
+            ScoreUpdateFile *file = &manifest->files[manifest->fileCount];
+            success = parseDigest(line + 5, file->digest, &field) && parseSize(field, &file->size, &field) && isSafeName(field);
+            file->name = field;
+            manifest->fileCount++;
+        } else if (strncmp(line, "delta ", 6) == 0) {
+            ScoreUpdateDelta *delta = &manifest->deltas[manifest->deltaCount];
+            success = parseDigest(line + 6, delta->baseDigest, &field) && parseDigest(field, delta->digest, &field) && parseSize(field, &delta->size, &field) && *field == '\0';
+            manifest->deltaCount++;
+        }
+        line = newline + 1;
+    }
+
+    //The same name can't be given twice.
+    for (size_t i = 0; success && i < manifest->fileCount; i++) {
+        for (size_t j = i + 1; j < manifest->fileCount; j++) {
+            if (strcmp(manifest->files[i].name, manifest->files[j].name) == 0) {
+                success = false;
+                break;
+            }
+        }
+    }
+    if (!success) {
+        ScoreUpdateManifestFree(manifest);
+        return NULL;
+    }
+    return manifest;
+}
+
+void ScoreUpdateManifestFree(ScoreUpdateManifest *manifest)
+{
+    if (manifest == NULL) {
+        return;
+    }
+    free(manifest->text);
+    free(manifest->files);
+    free(manifest->deltas);
+    free(manifest);
+}
+
+size_t ScoreUpdateManifestFileCount(const ScoreUpdateManifest *manifest)
+{
+    return manifest->fileCount;
+}
+
+const ScoreUpdateFile *ScoreUpdateManifestFileAtIndex(const ScoreUpdateManifest *manifest, size_t index)
+{
+    return index < manifest->fileCount ? &manifest->files[index] : NULL;
+}
+
+const ScoreUpdateDelta *ScoreUpdateManifestFindDelta(const ScoreUpdateManifest *manifest, const char *baseDigest, const char *digest)
+{
+    const ScoreUpdateDelta *smallest = NULL;
+    for (size_t i = 0; i < manifest->deltaCount; i++) {
+        const ScoreUpdateDelta *delta = &manifest->deltas[i];
+        if (strcmp(delta->baseDigest, baseDigest) == 0 && strcmp(delta->digest, digest) == 0 && (smallest == NULL || delta->size < smallest->size)) {
+            smallest = delta;
+        }
+    }
+    return smallest;
+}
+
+bool ScoreUpdateApplyDelta(const uint8_t *base, size_t baseLength, const char *deltaPath, const char *outputPath, char digest[SCORE_UPDATE_DIGEST_LENGTH])
+{
+    FILE *delta = fopen(deltaPath, "rb");
+    if (delta == NULL) {
+        return false;
+    }
+    uint8_t *buffer = malloc(SCORE_UPDATE_BUFFER_LENGTH);
+    unlink(outputPath);
+    int fd = open(outputPath, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0666);
+    bool success = buffer != NULL && fd >= 0;
+
+    uint8_t header[16];
+    uint64_t targetLength = 0;
+    success = success && readAll(delta, header, sizeof(header)) && memcmp(header, SCORE_UPDATE_DELTA_MAGIC, 8) == 0;
+    if (success) {
+        targetLength = readLittleEndian(header + 8, 8);
+    }
+
+    CC_SHA256_CTX context;
+    CC_SHA256_Init(&context);
+    uint64_t written = 0;
+    while (success) {
+        int instruction = fgetc(delta);
+        if (instruction == EOF) {
+            success = !ferror(delta);
+            break;
+        }
+        uint8_t arguments[12];
+        if (instruction == SCORE_UPDATE_DELTA_COPY && readAll(delta, arguments, 12)) {
+            uint64_t offset = readLittleEndian(arguments, 8);
+            uint32_t length = (uint32_t)readLittleEndian(arguments + 8, 4);
+            success = offset <= baseLength && length <= baseLength - offset && length <= targetLength - written;
+            success = success && writeAll(fd, base + offset, length);
+            if (success) {
+                CC_SHA256_Update(&context, base + offset, length);
+                written += length;
+            }
+        } else if (instruction == SCORE_UPDATE_DELTA_ADD && readAll(delta, arguments, 4)) {
+            uint32_t length = (uint32_t)readLittleEndian(arguments, 4);
+            success = length <= targetLength - written;
+            while (success && length > 0) {
+                size_t count = length < SCORE_UPDATE_BUFFER_LENGTH ? length : SCORE_UPDATE_BUFFER_LENGTH;
+                success = readAll(delta, buffer, count) && writeAll(fd, buffer, count);
+                if (success) {
+                    CC_SHA256_Update(&context, buffer, (CC_LONG)count);
+                    written += count;
+                    length -= (uint32_t)count;
+                }
+            }
+        } else {
+            success = false;
+        }
+    }
+    success = success && written == targetLength;
+
+    if (fd >= 0 && close(fd) != 0) {
+        success = false;
+    }
+    if (success) {
+        uint8_t rawDigest[CC_SHA256_DIGEST_LENGTH];
+        CC_SHA256_Final(rawDigest, &context);
+        formatDigest(rawDigest, digest);
+    } else {
+        unlink(outputPath);
+    }
+    fclose(delta);
+    free(buffer);
+    return success;
+}
+
+#pragma mark - Private functions
+
+static bool parseDigest(const char *field, char digest[SCORE_UPDATE_DIGEST_LENGTH], const char **end)
+{
+    //Exactly 64 lowercase hex digits, followed by a space or the end of the line.
+    for (int i = 0; i < SCORE_UPDATE_DIGEST_LENGTH - 1; i++) {
+        if (!((field[i] >= '0' && field[i] <= '9') || (field[i] >= 'a' && field[i] <= 'f'))) {
+            return false;
+        }
+        digest[i] = field[i];
+    }
+    digest[SCORE_UPDATE_DIGEST_LENGTH - 1] = '\0';
+    field += SCORE_UPDATE_DIGEST_LENGTH - 1;
+    if (*field != ' ') {
+        return false;
+    }
+    *end = field + 1;
+    return true;
+}
+
+static bool parseSize(const char *field, uint64_t *size, const char **end)
+{
+    if (*field < '0' || *field > '9') {
+        return false;
+    }
+    char *sizeEnd;
+    errno = 0;
+    unsigned long long value = strtoull(field, &sizeEnd, 10);
+    if (errno != 0 || (*sizeEnd != ' ' && *sizeEnd != '\0')) {
+        return false;
+    }
+    *size = value;
+    *end = *sizeEnd == ' ' ? sizeEnd + 1 : sizeEnd;
+    return true;
+}
+
+static bool isSafeName(const char *name)
+{
+    //Relative, with no empty, "." or ".." parts, so that it can't lead anywhere but into the score.
+    if (*name == '\0' || *name == '/') {
+        return false;
+    }
+    const char *part = name;
+    while (true) {
+        const char *slash = strchr(part, '/');
+        size_t length = slash != NULL ? (size_t)(slash - part) : strlen(part);
+        if (length == 0 || (length == 1 && part[0] == '.') || (length == 2 && part[0] == '.' && part[1] == '.')) {
+            return false;
+        }
+        if (slash == NULL) {
+            return true;
+        }
+        part = slash + 1;
+    }
+}
+
+static bool readAll(FILE *file, uint8_t *bytes, size_t length)
+{
+    return fread(bytes, 1, length, file) == length;
+}
+
+static bool writeAll(int fd, const uint8_t *bytes, size_t length)
+{
+    while (length > 0) {
+        ssize_t count = write(fd, bytes, length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        bytes += count;
+        length -= (size_t)count;
+    }
+    return true;
+}
+
+static uint64_t readLittleEndian(const uint8_t *bytes, int length)
+{
+    uint64_t value = 0;
+    for (int i = length - 1; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+static void formatDigest(const uint8_t *digest, char hex[SCORE_UPDATE_DIGEST_LENGTH])
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    for (int i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+        hex[i * 2] = hexDigits[digest[i] >> 4];
+        hex[i * 2 + 1] = hexDigits[digest[i] & 0xf];
+    }
+    hex[CC_SHA256_DIGEST_LENGTH * 2] = '\0';
+}
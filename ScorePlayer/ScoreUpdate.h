@@ -0,0 +1,67 @@
+//
+//  ScoreUpdate.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Lets a score be updated a file at a time instead of downloading the whole archive again. Along
+//with the archive, the server publishes a manifest of every file in the new version:
+//
+//    ScorePlayer update 1
+//    file <digest> <size> <name>
+//    delta <base digest> <digest> <size>
+//
+//Digests are the SHA-256 of the file in lowercase hex, and names are relative to the score and run
+//to the end of the line. Each file can be downloaded from objects/<digest>, relative to the manifest.
+//A delta line says that deltas/<base digest>-<digest> (which is the given size) turns the file
+//with the base digest into the file with the other, and there can be any number of them.
+//
+//A delta is the eight bytes "SPDELTA1" and the length of the file it makes, followed by
+//instructions until the end of the delta:
+//    0x01, offset, length: copy length bytes from the base, starting at offset
+//    0x02, length, bytes: add the bytes that follow
+//Offsets are 64 bits and lengths 32, except for the length of the file. All are little endian.
+
+#ifndef ScoreUpdate_h
+#define ScoreUpdate_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//Long enough for a digest in hex, with the NUL.
+#define SCORE_UPDATE_DIGEST_LENGTH 65
+
+typedef struct ScoreUpdateManifest ScoreUpdateManifest;
+
+typedef struct {
+    //Points into the manifest.
+    const char *name;
+    uint64_t size;
+    char digest[SCORE_UPDATE_DIGEST_LENGTH];
+} ScoreUpdateFile;
+
+typedef struct {
+    char baseDigest[SCORE_UPDATE_DIGEST_LENGTH];
+    char digest[SCORE_UPDATE_DIGEST_LENGTH];
+    uint64_t size;
+} ScoreUpdateDelta;
+
+//Returns NULL if the manifest is malformed, or if any name would lead outside the score.
+ScoreUpdateManifest *ScoreUpdateManifestParse(const char *text, size_t length);
+void ScoreUpdateManifestFree(ScoreUpdateManifest *manifest);
+
+size_t ScoreUpdateManifestFileCount(const ScoreUpdateManifest *manifest);
+const ScoreUpdateFile *ScoreUpdateManifestFileAtIndex(const ScoreUpdateManifest *manifest, size_t index);
+//The smallest delta from one file to the other, or NULL if there isn't one.
+const ScoreUpdateDelta *ScoreUpdateManifestFindDelta(const ScoreUpdateManifest *manifest, const char *baseDigest, const char *digest);
+
+//Applies a delta to the contents of the base file, writing the result to a new file at the output
+//path, and gives back the digest of the result so that it can be checked. If the delta is
+//malformed or the output can't be written, nothing is left at the output path and false is
+//returned.
+bool ScoreUpdateApplyDelta(const uint8_t *base, size_t baseLength, const char *deltaPath, const char *outputPath, char digest[SCORE_UPDATE_DIGEST_LENGTH]);
+
+#endif /* ScoreUpdate_h */
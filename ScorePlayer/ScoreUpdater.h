@@ -0,0 +1,40 @@
+//
+//  ScoreUpdater.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+//Updates an imported score from an update manifest (see ScoreUpdate.h) rather than downloading
+//its whole archive again. Files that haven't changed, or that the asset store already has, are
+//kept. A changed file is patched if the manifest has a delta from the version on the device, and
+//only what's left is downloaded. Everything is checked against its digest.
+//The new version is put together in a working directory and then swapped in for the old one, so
+//a score is never left half updated. Tile pyramids and other caches aren't carried over. A mounted
+//score comes out of an update extracted, since its archive can't be changed.
+
+@interface ScoreUpdater : NSObject
+
+@property (nonatomic, readonly) NSString *scorePath;
+@property (nonatomic, readonly) NSURL *manifestURL;
+
+//These are known once the manifest has been read, and can be read from any thread.
+@property (nonatomic, readonly) unsigned long long totalBytes;
+@property (nonatomic, readonly) unsigned long long downloadBytes;
+@property (nonatomic, readonly) unsigned long long receivedBytes;
+@property (nonatomic, readonly) NSInteger fileCount;
+@property (nonatomic, readonly) NSInteger reusedFiles;
+
+//Called on the main queue after each download.
+@property (nonatomic, copy) void (^progressHandler)(ScoreUpdater *updater);
+
+//The working directory has to be on the same volume as the score.
+- (id)initWithScorePath:(NSString *)path manifestURL:(NSURL *)url workingDirectory:(NSString *)directory;
+//The handler is called on the main queue once the score has been updated, or left as it was.
+- (void)updateWithCompletionHandler:(void (^)(BOOL success))completionHandler;
+- (void)cancel;
+
+@end
@@ -0,0 +1,272 @@
+//
+//  ScoreUpdater.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ScoreUpdater.h"
+#import "ScoreUpdate.h"
+#import "ScoreArchive.h"
+#import "ScoreAssetStore.h"
+#include <stdatomic.h>
+
+@interface ScoreUpdater ()
+
+- (BOOL)prepareFiles;
+- (void)downloadNextFile;
+- (NSData *)currentDataForPath:(NSString *)path;
+- (BOOL)replaceScore;
+- (void)finish:(BOOL)success;
+
+@end
+
+@implementation ScoreUpdater {
+    NSURLSession *session;
+    ScoreUpdateManifest *manifest;
+    NSString *scoresDirectory;
+    NSString *workingPath;
+    //Each is the index of a file in the manifest and the delta to download for it (or NULL).
+    NSMutableArray *pendingFiles;
+    void (^completionHandler)(BOOL success);
+    BOOL cancelled;
+    //Added to as downloads finish, while the progress is read from other threads.
+    _Atomic(unsigned long long) downloadByteCount;
+    _Atomic(unsigned long long) receivedByteCount;
+    
+    NSFileManager *fileManager;
+}
+
+@synthesize scorePath, manifestURL, totalBytes, fileCount, reusedFiles, progressHandler;
+
+- (id)initWithScorePath:(NSString *)path manifestURL:(NSURL *)url workingDirectory:(NSString *)directory
+{
+    self = [super init];
+    scorePath = path;
+    manifestURL = url;
+    scoresDirectory = [path stringByDeletingLastPathComponent];
+    workingPath = [directory stringByAppendingPathComponent:[path lastPathComponent]];
+    pendingFiles = [[NSMutableArray alloc] init];
+    fileManager = [NSFileManager defaultManager];
+    
+    NSURLSessionConfiguration *sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
+    sessionConfig.requestCachePolicy = NSURLRequestReloadIgnoringCacheData;
+    session = [NSURLSession sessionWithConfiguration:sessionConfig];
+    return self;
+}
+
+- (void)dealloc
+{
+    ScoreUpdateManifestFree(manifest);
+}
+
+- (unsigned long long)downloadBytes
+{
+    return atomic_load(&downloadByteCount);
+}
+
+- (unsigned long long)receivedBytes
+{
+    return atomic_load(&receivedByteCount);
+}
+
+- (void)updateWithCompletionHandler:(void (^)(BOOL success))handler
+{
+    completionHandler = handler;
+    
+    NSURLSessionDataTask *manifestTask = [session dataTaskWithURL:manifestURL completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        if (error != nil || data == nil || ![response isKindOfClass:[NSHTTPURLResponse class]] || [(NSHTTPURLResponse *)response statusCode] != 200) {
+            [self finish:NO];
+            return;
+        }
+        self->manifest = ScoreUpdateManifestParse([data bytes], [data length]);
+        if (self->manifest == NULL || ![self prepareFiles]) {
+            [self finish:NO];
+            return;
+        }
+        [self downloadNextFile];
+    }];
+    [manifestTask resume];
+}
+
+- (void)cancel
+{
+    //Any download in progress fails, which finishes the update.
+    cancelled = YES;
+    [session invalidateAndCancel];
+}
+
+#pragma mark - Private methods
+
+- (BOOL)prepareFiles
+{
+    //Work out where each file in the new version is going to come from, and gather the ones that
+    //are already on the device.
+    [fileManager removeItemAtPath:workingPath error:nil];
+    if (![fileManager createDirectoryAtPath:workingPath withIntermediateDirectories:YES attributes:nil error:nil]) {
+        return NO;
+    }
+    
+    fileCount = ScoreUpdateManifestFileCount(manifest);
+    for (int i = 0; i < fileCount; i++) {
+        const ScoreUpdateFile *file = ScoreUpdateManifestFileAtIndex(manifest, i);
+        totalBytes += file->size;
+        NSString *name = [NSString stringWithUTF8String:file->name];
+        NSString *digest = [NSString stringWithUTF8String:file->digest];
+        NSString *target = [workingPath stringByAppendingPathComponent:name];
+        if (name == nil || ![fileManager createDirectoryAtPath:[target stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil]) {
+            return NO;
+        }
+        
+        //The asset store might have it from another score, even if this one doesn't.
+        NSString *storedPath = [ScoreAssetStore storedFileWithDigest:digest scoresDirectory:scoresDirectory];
+        if (storedPath != nil && [fileManager linkItemAtPath:storedPath toPath:target error:nil]) {
+            reusedFiles++;
+            continue;
+        }
+        
+        //Otherwise check the version the score has now, which could be on disk or in its archive.
+        NSString *currentPath = [scorePath stringByAppendingPathComponent:name];
+        NSData *archivedData = [ScoreArchive archivedDataForFile:currentPath];
+        NSString *currentDigest = archivedData != nil ? [ScoreAssetStore digestOfData:archivedData] : [ScoreAssetStore digestOfFile:currentPath];
+        if ([currentDigest isEqualToString:digest]) {
+            BOOL copied;
+            if (archivedData != nil) {
+                copied = [archivedData writeToFile:target atomically:NO];
+            } else {
+                copied = [fileManager linkItemAtPath:currentPath toPath:target error:nil] || [fileManager copyItemAtPath:currentPath toPath:target error:nil];
+            }
+            if (copied) {
+                reusedFiles++;
+                continue;
+            }
+        }
+        
+        //It has to be downloaded, as a delta if there's one from the current version that's
+        //smaller than the file itself.
+        const ScoreUpdateDelta *delta = currentDigest != nil ? ScoreUpdateManifestFindDelta(manifest, [currentDigest UTF8String], file->digest) : NULL;
+        if (delta != NULL && delta->size >= file->size) {
+            delta = NULL;
+        }
+        [pendingFiles addObject:[NSArray arrayWithObjects:[NSNumber numberWithInt:i], [NSValue valueWithPointer:delta], nil]];
+        atomic_fetch_add(&downloadByteCount, delta != NULL ? delta->size : file->size);
+    }
+    return YES;
+}
+
+- (void)downloadNextFile
+{
+    if (cancelled) {
+        [self finish:NO];
+        return;
+    }
+    if ([pendingFiles count] == 0) {
+        [self finish:[self replaceScore]];
+        return;
+    }
+    
+    NSArray *pending = [pendingFiles objectAtIndex:0];
+    [pendingFiles removeObjectAtIndex:0];
+    NSNumber *index = [pending objectAtIndex:0];
+    const ScoreUpdateFile *file = ScoreUpdateManifestFileAtIndex(manifest, [index intValue]);
+    const ScoreUpdateDelta *delta = [[pending objectAtIndex:1] pointerValue];
+    NSString *name = [NSString stringWithUTF8String:file->name];
+    NSString *target = [workingPath stringByAppendingPathComponent:name];
+    
+    NSString *relativePath;
+    if (delta != NULL) {
+        relativePath = [NSString stringWithFormat:@"deltas/%s-%s", delta->baseDigest, delta->digest];
+    } else {
+        relativePath = [NSString stringWithFormat:@"objects/%s", file->digest];
+    }
+    NSURL *url = [NSURL URLWithString:relativePath relativeToURL:manifestURL];
+    
+    NSURLSessionDownloadTask *downloadTask = [session downloadTaskWithURL:url completionHandler:^(NSURL *location, NSURLResponse *response, NSError *error) {
+        BOOL downloaded = error == nil && [location isFileURL] && [response isKindOfClass:[NSHTTPURLResponse class]] && [(NSHTTPURLResponse *)response statusCode] == 200;
+        if (downloaded) {
+            atomic_fetch_add(&self->receivedByteCount, [[self->fileManager attributesOfItemAtPath:location.path error:nil] fileSize]);
+        }
+        
+        BOOL applied = NO;
+        if (downloaded && delta != NULL) {
+            NSData *base = [self currentDataForPath:[self->scorePath stringByAppendingPathComponent:name]];
+            char digest[SCORE_UPDATE_DIGEST_LENGTH];
+            applied = base != nil && ScoreUpdateApplyDelta([base bytes], [base length], [location.path fileSystemRepresentation], [target fileSystemRepresentation], digest) && strcmp(digest, file->digest) == 0;
+            if (!applied) {
+                [self->fileManager removeItemAtPath:target error:nil];
+            }
+        } else if (downloaded) {
+            applied = [[ScoreAssetStore digestOfFile:location.path] isEqualToString:[NSString stringWithUTF8String:file->digest]] && [self->fileManager moveItemAtPath:location.path toPath:target error:nil];
+        }
+        
+        if (!applied && delta != NULL && !self->cancelled) {
+            //If the delta didn't work out then the whole file will have to do.
+            [self->pendingFiles insertObject:[NSArray arrayWithObjects:index, [NSValue valueWithPointer:NULL], nil] atIndex:0];
+            atomic_fetch_add(&self->downloadByteCount, file->size);
+        } else if (!applied) {
+            [self finish:NO];
+            return;
+        }
+        
+        if (self->progressHandler != nil) {
+            void (^handler)(ScoreUpdater *) = self->progressHandler;
+            dispatch_async(dispatch_get_main_queue(), ^{
+                handler(self);
+            });
+        }
+        [self downloadNextFile];
+    }];
+    [downloadTask resume];
+}
+
+- (NSData *)currentDataForPath:(NSString *)path
+{
+    NSData *data = [ScoreArchive archivedDataForFile:path];
+    if (data == nil) {
+        data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+    }
+    return data;
+}
+
+- (BOOL)replaceScore
+{
+    //The old version is moved aside rather than deleted until the new one is in place. The score
+    //is locked meanwhile so that it isn't stored half way through.
+    NSString *backupPath = [scorePath stringByAppendingString:@".bak"];
+    [ScoreAssetStore lockScorePath:scorePath];
+    [fileManager removeItemAtPath:backupPath error:nil];
+    BOOL success = [fileManager moveItemAtPath:scorePath toPath:backupPath error:nil];
+    if (success && ![fileManager moveItemAtPath:workingPath toPath:scorePath error:nil]) {
+        [fileManager moveItemAtPath:backupPath toPath:scorePath error:nil];
+        success = NO;
+    }
+    if (success) {
+        [fileManager removeItemAtPath:backupPath error:nil];
+    }
+    [ScoreAssetStore unlockScorePath:scorePath];
+    
+    //Anything new is shared with the rest of the library.
+    if (success) {
+        [ScoreAssetStore storeScorePathInBackground:scorePath];
+    }
+    return success;
+}
+
+- (void)finish:(BOOL)success
+{
+    if (!success) {
+        [fileManager removeItemAtPath:workingPath error:nil];
+    }
+    [session finishTasksAndInvalidate];
+    
+    void (^handler)(BOOL) = completionHandler;
+    completionHandler = nil;
+    if (handler != nil) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            handler(success);
+        });
+    }
+}
+
+@end
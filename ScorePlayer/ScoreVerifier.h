@@ -0,0 +1,30 @@
+//
+//  ScoreVerifier.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+//Checks scores against their CRCs using every core, so that damaged files are found before
+//they're played rather than when a renderer trips over them. (See ScoreVerify.h for how the
+//work is split up.) A mounted score is checked against its archive, and an extracted score
+//against the manifest written when it was imported. Scores with neither can't be checked.
+
+@interface ScoreVerifier : NSObject
+
++ (BOOL)verifyArchive:(NSString *)archivePath;
+//Records the CRCs of an archive in the score it's being extracted to.
++ (BOOL)writeManifestForArchive:(NSString *)archivePath toScorePath:(NSString *)scorePath;
+//Returns YES for a score that can't be checked.
++ (BOOL)verifyScorePath:(NSString *)scorePath;
+//Checks a whole library, several scores at a time. Returns the paths of the scores that failed.
++ (NSArray *)corruptScoresInPaths:(NSArray *)scorePaths;
+
+//Bytes per second for each CRC method this device has, keyed by name, including zlib's (which
+//is what minizip used before).
++ (NSDictionary *)benchmarkChecksums;
+
+@end
@@ -0,0 +1,125 @@
+//
+//  ScoreVerifier.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ScoreVerifier.h"
+#import "ScoreVerify.h"
+#import "ScoreArchive.h"
+#import "Crc32.h"
+
+static NSString *const SCORE_MANIFEST_FILE = @".score.manifest";
+static const size_t SCORE_VERIFIER_BENCHMARK_LENGTH = 64 * 1024 * 1024;
+
+@interface ScoreVerifier ()
+
++ (ScoreVerification *)openVerificationForScorePath:(NSString *)scorePath;
++ (BOOL)runVerification:(ScoreVerification *)verification workers:(size_t)maximum;
+
+@end
+
+@implementation ScoreVerifier
+
++ (BOOL)verifyArchive:(NSString *)archivePath
+{
+    ScoreVerification *verification = ScoreVerificationOpenArchive([archivePath fileSystemRepresentation]);
+    if (verification == NULL) {
+        return NO;
+    }
+    BOOL success = [self runVerification:verification workers:[[NSProcessInfo processInfo] activeProcessorCount]];
+    ScoreVerificationClose(verification);
+    return success;
+}
+
++ (BOOL)writeManifestForArchive:(NSString *)archivePath toScorePath:(NSString *)scorePath
+{
+    return ScoreVerifyWriteManifest([archivePath fileSystemRepresentation], [[scorePath stringByAppendingPathComponent:SCORE_MANIFEST_FILE] fileSystemRepresentation]);
+}
+
++ (BOOL)verifyScorePath:(NSString *)scorePath
+{
+    ScoreVerification *verification = [self openVerificationForScorePath:scorePath];
+    if (verification == NULL) {
+        return YES;
+    }
+    BOOL success = [self runVerification:verification workers:[[NSProcessInfo processInfo] activeProcessorCount]];
+    ScoreVerificationClose(verification);
+    return success;
+}
+
++ (NSArray *)corruptScoresInPaths:(NSArray *)scorePaths
+{
+    //Most scores are small, so it's better to check several of them at once with a worker each
+    //than to split every score between all the cores.
+    NSUInteger count = [scorePaths count];
+    BOOL *corrupt = calloc(count > 0 ? count : 1, sizeof(BOOL));
+    if (corrupt == NULL) {
+        return [NSArray array];
+    }
+    dispatch_apply(count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        ScoreVerification *verification = [self openVerificationForScorePath:[scorePaths objectAtIndex:i]];
+        if (verification != NULL) {
+            corrupt[i] = ![self runVerification:verification workers:1];
+            ScoreVerificationClose(verification);
+        }
+    });
+    
+    NSMutableArray *corruptScores = [[NSMutableArray alloc] init];
+    for (int i = 0; i < count; i++) {
+        if (corrupt[i]) {
+            [corruptScores addObject:[scorePaths objectAtIndex:i]];
+        }
+    }
+    free(corrupt);
+    return corruptScores;
+}
+
++ (NSDictionary *)benchmarkChecksums
+{
+    NSMutableDictionary *results = [[NSMutableDictionary alloc] init];
+    for (int i = 0; i < Crc32MethodCount; i++) {
+        if (Crc32MethodAvailable(i)) {
+            [results setObject:[NSNumber numberWithDouble:Crc32Benchmark(i, SCORE_VERIFIER_BENCHMARK_LENGTH)] forKey:[NSString stringWithUTF8String:Crc32MethodName(i)]];
+        }
+    }
+    return results;
+}
+
+#pragma mark - Private methods
+
++ (ScoreVerification *)openVerificationForScorePath:(NSString *)scorePath
+{
+    if ([ScoreArchive isMountedScorePath:scorePath]) {
+        return ScoreVerificationOpenArchive([[ScoreArchive archivePathForScorePath:scorePath] fileSystemRepresentation]);
+    }
+    return ScoreVerificationOpenManifest([[scorePath stringByAppendingPathComponent:SCORE_MANIFEST_FILE] fileSystemRepresentation], [scorePath fileSystemRepresentation]);
+}
+
++ (BOOL)runVerification:(ScoreVerification *)verification workers:(size_t)maximum
+{
+    size_t workerCount = ScoreVerificationWorkerCount(verification, maximum);
+    __block BOOL success = YES;
+    if (workerCount == 1) {
+        success = ScoreVerificationRunWorker(verification);
+    } else {
+        NSLock *successLock = [[NSLock alloc] init];
+        dispatch_apply(workerCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+            if (!ScoreVerificationRunWorker(verification)) {
+                [successLock lock];
+                success = NO;
+                [successLock unlock];
+            }
+        });
+    }
+    
+    const char *failedFile = ScoreVerificationFailedFile(verification);
+    if (failedFile != NULL) {
+        NSLog(@"Failed CRC check: %s", failedFile);
+    }
+    return success;
+}
+
+@end
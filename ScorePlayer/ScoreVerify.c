@@ -0,0 +1,376 @@
+//
+//  ScoreVerify.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ScoreVerify.h"
+#include "Crc32.h"
+#include "ZipMount.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//Files on disk are read through a buffer of this size.
+#define SCORE_VERIFY_BUFFER_LENGTH (1024 * 1024)
+#define SCORE_VERIFY_MANIFEST_HEADER "ScorePlayer manifest 1\n"
+
+typedef struct {
+    //Relative to the score. Points into the manifest or the mounted archive.
+    const char *name;
+    uint64_t size;
+    uint32_t crc;
+    //NULL for a file on disk.
+    const ZipMountEntry *entry;
+} ScoreVerifyFile;
+
+struct ScoreVerification {
+    ZipMount *mount;
+    char *directory;
+    //The manifest, with each name NUL terminated in place.
+    char *manifest;
+    //Largest first.
+    ScoreVerifyFile *files;
+    size_t fileCount;
+    uint64_t totalBytes;
+
+    atomic_size_t nextFile;
+    atomic_size_t verifiedFiles;
+    atomic_uint_least64_t verifiedBytes;
+    atomic_bool failed;
+    //The index of the first file that failed, or SIZE_MAX.
+    atomic_size_t failedFile;
+};
+
+static ScoreVerification *newVerification(size_t fileCount);
+static char *readFile(const char *path, size_t *length);
+static bool parseManifest(ScoreVerification *verification, size_t length);
+static bool verifyFile(ScoreVerification *verification, const ScoreVerifyFile *file, uint8_t *buffer);
+static int compareFilesBySize(const void *a, const void *b);
+
+#pragma mark - Public functions
+
+bool ScoreVerifyWriteManifest(const char *archivePath, const char *manifestPath)
+{
+    ZipMount *mount = ZipMountOpen(archivePath);
+    if (mount == NULL) {
+        return false;
+    }
+    size_t pathLength = strlen(manifestPath);
+    char *temporaryPath = malloc(pathLength + 5);
+    if (temporaryPath == NULL) {
+        ZipMountClose(mount);
+        return false;
+    }
+    memcpy(temporaryPath, manifestPath, pathLength);
+    memcpy(temporaryPath + pathLength, ".tmp", 5);
+
+    //Written to the side and moved into place, so that a half written manifest is never read.
+    FILE *file = fopen(temporaryPath, "w");
+    bool success = file != NULL && fputs(SCORE_VERIFY_MANIFEST_HEADER, file) >= 0;
+    for (size_t i = 0; success && i < ZipMountEntryCount(mount); i++) {
+        const ZipMountEntry *entry = ZipMountEntryAtIndex(mount, i);
+        if (memchr(entry->name, '\n', entry->nameLength) != NULL) {
+            //Can't be written on a line of its own, so it just won't be checked.
+            continue;
+        }
+        success = fprintf(file, "%08" PRIx32 " %" PRIu64 " %s\n", entry->crc, entry->size, entry->name) > 0;
+    }
+    if (file != NULL && fclose(file) != 0) {
+        success = false;
+    }
+    if (success) {
+        success = rename(temporaryPath, manifestPath) == 0;
+    }
+    if (!success) {
+        unlink(temporaryPath);
+    }
+    free(temporaryPath);
+    ZipMountClose(mount);
+    return success;
+}
+
+ScoreVerification *ScoreVerificationOpenArchive(const char *archivePath)
+{
+    ZipMount *mount = ZipMountOpen(archivePath);
+    if (mount == NULL) {
+        return NULL;
+    }
+    ScoreVerification *verification = newVerification(ZipMountEntryCount(mount));
+    if (verification == NULL) {
+        ZipMountClose(mount);
+        return NULL;
+    }
+    verification->mount = mount;
+    for (size_t i = 0; i < verification->fileCount; i++) {
+        const ZipMountEntry *entry = ZipMountEntryAtIndex(mount, i);
+        verification->files[i].name = entry->name;
+        verification->files[i].size = entry->size;
+        verification->files[i].crc = entry->crc;
+        verification->files[i].entry = entry;
+        verification->totalBytes += entry->size;
+    }
+    if (verification->fileCount > 0) {
+        qsort(verification->files, verification->fileCount, sizeof(ScoreVerifyFile), compareFilesBySize);
+    }
+    return verification;
+}
+
+ScoreVerification *ScoreVerificationOpenManifest(const char *manifestPath, const char *directory)
+{
+    size_t length;
+    char *manifest = readFile(manifestPath, &length);
+    if (manifest == NULL) {
+        return NULL;
+    }
+    //There can't be more files than lines.
+    size_t lineCount = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (manifest[i] == '\n') {
+            lineCount++;
+        }
+    }
+    ScoreVerification *verification = newVerification(lineCount);
+    if (verification == NULL) {
+        free(manifest);
+        return NULL;
+    }
+    verification->manifest = manifest;
+    verification->directory = strdup(directory);
+    if (verification->directory == NULL || !parseManifest(verification, length)) {
+        ScoreVerificationClose(verification);
+        return NULL;
+    }
+    if (verification->fileCount > 0) {
+        qsort(verification->files, verification->fileCount, sizeof(ScoreVerifyFile), compareFilesBySize);
+    }
+    return verification;
+}
+
+void ScoreVerificationClose(ScoreVerification *verification)
+{
+    if (verification == NULL) {
+        return;
+    }
+    ZipMountClose(verification->mount);
+    free(verification->directory);
+    free(verification->manifest);
+    free(verification->files);
+    free(verification);
+}
+
+size_t ScoreVerificationWorkerCount(const ScoreVerification *verification, size_t maximum)
+{
+    size_t count = verification->fileCount < maximum ? verification->fileCount : maximum;
+    return count > 0 ? count : 1;
+}
+
+bool ScoreVerificationRunWorker(ScoreVerification *verification)
+{
+    uint8_t *buffer = NULL;
+    if (verification->mount == NULL) {
+        buffer = malloc(SCORE_VERIFY_BUFFER_LENGTH);
+        if (buffer == NULL) {
+            atomic_store(&verification->failed, true);
+            return false;
+        }
+    }
+
+    while (!atomic_load(&verification->failed)) {
+        size_t next = atomic_fetch_add(&verification->nextFile, 1);
+        if (next >= verification->fileCount) {
+            break;
+        }
+        const ScoreVerifyFile *file = &verification->files[next];
+        if (!verifyFile(verification, file, buffer)) {
+            size_t none = SIZE_MAX;
+            atomic_compare_exchange_strong(&verification->failedFile, &none, next);
+            atomic_store(&verification->failed, true);
+            break;
+        }
+        atomic_fetch_add(&verification->verifiedBytes, file->size);
+        atomic_fetch_add(&verification->verifiedFiles, 1);
+    }
+
+    free(buffer);
+    return !atomic_load(&verification->failed);
+}
+
+void ScoreVerificationGetProgress(const ScoreVerification *verification, ScoreVerificationProgress *progress)
+{
+    progress->totalBytes = verification->totalBytes;
+    progress->verifiedBytes = atomic_load(&((ScoreVerification *)verification)->verifiedBytes);
+    progress->fileCount = verification->fileCount;
+    progress->verifiedFiles = atomic_load(&((ScoreVerification *)verification)->verifiedFiles);
+}
+
+const char *ScoreVerificationFailedFile(const ScoreVerification *verification)
+{
+    size_t index = atomic_load(&((ScoreVerification *)verification)->failedFile);
+    return index < verification->fileCount ? verification->files[index].name : NULL;
+}
+
+#pragma mark - Private functions
+
+static ScoreVerification *newVerification(size_t fileCount)
+{
+    ScoreVerification *verification = calloc(1, sizeof(ScoreVerification));
+    if (verification == NULL) {
+        return NULL;
+    }
+    atomic_init(&verification->nextFile, 0);
+    atomic_init(&verification->verifiedFiles, 0);
+    atomic_init(&verification->verifiedBytes, 0);
+    atomic_init(&verification->failed, false);
+    atomic_init(&verification->failedFile, SIZE_MAX);
+    verification->files = calloc(fileCount > 0 ? fileCount : 1, sizeof(ScoreVerifyFile));
+    if (verification->files == NULL) {
+        free(verification);
+        return NULL;
+    }
+    verification->fileCount = fileCount;
+    return verification;
+}
+
+static char *readFile(const char *path, size_t *length)
+{
+    //Returns the whole file with a NUL after it.
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size < 0 || (uint64_t)status.st_size >= SIZE_MAX) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)status.st_size;
+    char *contents = malloc(size + 1);
+    size_t total = 0;
+    while (contents != NULL && total < size) {
+        ssize_t count = read(fd, contents + total, size - total);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            free(contents);
+            contents = NULL;
+            break;
+        }
+        total += (size_t)count;
+    }
+    close(fd);
+    if (contents != NULL) {
+        contents[total] = '\0';
+        *length = total;
+    }
+    return contents;
+}
+
+static bool parseManifest(ScoreVerification *verification, size_t length)
+{
+    //Each line after the header is the CRC in hex, the size, and the name, separated by single
+    //spaces. The name runs to the end of the line.
+    char *manifest = verification->manifest;
+    size_t headerLength = strlen(SCORE_VERIFY_MANIFEST_HEADER);
+    if (length < headerLength || memcmp(manifest, SCORE_VERIFY_MANIFEST_HEADER, headerLength) != 0) {
+        return false;
+    }
+    size_t count = 0;
+    char *line = manifest + headerLength;
+    char *end = manifest + length;
+    while (line < end) {
+        char *newline = memchr(line, '\n', (size_t)(end - line));
+        if (newline == NULL) {
+            return false;
+        }
+        *newline = '\0';
+
+        char *field;
+        errno = 0;
+        unsigned long crc = strtoul(line, &field, 16);
+        if (field == line || *field != ' ' || crc > UINT32_MAX) {
+            return false;
+        }
+        char *sizeField = field + 1;
+        unsigned long long size = strtoull(sizeField, &field, 10);
+        if (field == sizeField || *field != ' ' || errno != 0) {
+            return false;
+        }
+        char *name = field + 1;
+        if (*name == '\0' || *name == '/') {
+            return false;
+        }
+
+        verification->files[count].name = name;
+        verification->files[count].size = size;
+        verification->files[count].crc = (uint32_t)crc;
+        verification->totalBytes += size;
+        count++;
+        line = newline + 1;
+    }
+    verification->fileCount = count;
+    return true;
+}
+
+static bool verifyFile(ScoreVerification *verification, const ScoreVerifyFile *file, uint8_t *buffer)
+{
+    if (file->entry != NULL) {
+        return ZipMountVerifyEntry(verification->mount, file->entry);
+    }
+
+    size_t directoryLength = strlen(verification->directory);
+    size_t nameLength = strlen(file->name);
+    char *path = malloc(directoryLength + nameLength + 2);
+    if (path == NULL) {
+        return false;
+    }
+    memcpy(path, verification->directory, directoryLength);
+    path[directoryLength] = '/';
+    memcpy(path + directoryLength + 1, file->name, nameLength + 1);
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0) {
+        return false;
+    }
+
+    //Reading it through once is all that's needed, so there's no point in it being cached.
+#if defined(F_NOCACHE)
+    fcntl(fd, F_NOCACHE, 1);
+#endif
+    uint32_t crc = 0;
+    uint64_t total = 0;
+    bool success = true;
+    while (success) {
+        ssize_t count = read(fd, buffer, SCORE_VERIFY_BUFFER_LENGTH);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            success = count == 0;
+            break;
+        }
+        crc = Crc32Update(crc, buffer, (size_t)count);
+        total += (uint64_t)count;
+        if (total > file->size) {
+            success = false;
+        }
+    }
+    close(fd);
+    return success && total == file->size && crc == file->crc;
+}
+
+static int compareFilesBySize(const void *a, const void *b)
+{
+    uint64_t first = ((const ScoreVerifyFile *)a)->size;
+    uint64_t second = ((const ScoreVerifyFile *)b)->size;
+    return first < second ? 1 : (first > second ? -1 : 0);
+}
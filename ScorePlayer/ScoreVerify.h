@@ -0,0 +1,57 @@
+//
+//  ScoreVerify.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Checks a score's files against their CRCs with several threads at once. A score archive is
+//checked entry by entry through ZipMount (see ZipMount.h), so stored entries are read straight
+//from the mapping. An extracted score is checked against a manifest: a small text file listing
+//the CRC and size of every file that was extracted, taken from the archive's central directory
+//when the score was imported. Files written to the score directory after that aren't in the
+//manifest and aren't checked.
+//As with ZipExtract, every file is given a slot in a shared list (largest first, so that one big
+//file isn't left to a single worker at the end) and the workers take files from it until there
+//are none left. The CRCs are worked out with Crc32 (see Crc32.h).
+
+#ifndef ScoreVerify_h
+#define ScoreVerify_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ScoreVerification ScoreVerification;
+
+typedef struct {
+    uint64_t totalBytes;
+    uint64_t verifiedBytes;
+    size_t fileCount;
+    size_t verifiedFiles;
+} ScoreVerificationProgress;
+
+//Writes a manifest for every file that extracting the archive would give. Returns false if the
+//archive can't be read by ZipMount or the manifest can't be written.
+bool ScoreVerifyWriteManifest(const char *archivePath, const char *manifestPath);
+
+//Return NULL if the archive or manifest can't be read.
+ScoreVerification *ScoreVerificationOpenArchive(const char *archivePath);
+ScoreVerification *ScoreVerificationOpenManifest(const char *manifestPath, const char *directory);
+void ScoreVerificationClose(ScoreVerification *verification);
+
+//The number of workers worth running, at most the given maximum.
+size_t ScoreVerificationWorkerCount(const ScoreVerification *verification, size_t maximum);
+//Checks files until there are none left. Call this from as many threads as there are workers.
+//Once any file fails (including being missing or the wrong size) the other workers stop after
+//the file they're on, and every worker returns false.
+bool ScoreVerificationRunWorker(ScoreVerification *verification);
+
+//Can be called from any thread while the workers are running.
+void ScoreVerificationGetProgress(const ScoreVerification *verification, ScoreVerificationProgress *progress);
+//The name (relative to the score) of the first file found to be bad, or NULL if there isn't one.
+//Only valid once the workers have finished.
+const char *ScoreVerificationFailedFile(const ScoreVerification *verification);
+
+#endif /* ScoreVerify_h */
@@ -7,7 +7,6 @@
 //
 
 #import <UIKit/UIKit.h>
-#import "OpusParser.h"
 #import "Network.h"
 
 typedef enum {
@@ -15,7 +14,7 @@ typedef enum {
     kManageImports = 1
 } Mode;
 
-@interface ScoresViewController : UIViewController <UITableViewDataSource, UITableViewDelegate, OpusParserDelegate, UpdateDelegate, UITextFieldDelegate, UISearchBarDelegate>
+@interface ScoresViewController : UIViewController <UITableViewDataSource, UITableViewDelegate, UpdateDelegate, UITextFieldDelegate, UISearchBarDelegate>
 
 @property (nonatomic, strong) IBOutlet UITableView *scoresTableView;
 @property (nonatomic, strong) IBOutlet UIBarButtonItem *changeModeButton;
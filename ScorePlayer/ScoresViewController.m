@@ -9,15 +9,25 @@
 #import "ScoresViewController.h"
 #import "Score.h"
 #import "Renderer.h"
-#import "SSZipArchive.h"
+#import "ZipCompressor.h"
+#import "ZipExtractor.h"
+#import "ScoreVerifier.h"
 #import "PlayerViewController.h"
 #import "UpdateViewController.h"
 #import "DownloadViewController.h"
+#import "ScoreLibrary.h"
+#import "CompiledScore.h"
+#import "ScoreSearchIndex.h"
+#import "ImageSizeIndex.h"
+#import "ScoreArchive.h"
+#import "ScoreAssetStore.h"
 
 @interface ScoresViewController ()
 
 - (BOOL)importScores;
 - (BOOL)importScoresFromDirectory:(NSString *)directory;
+- (void)replacedScoreAtPath:(NSString *)scorePath;
+- (void)storeScorePaths:(NSArray *)scorePaths fromIndex:(NSUInteger)index;
 - (void)loadScores;
 - (NSMutableArray *)getDirectoryList;
 - (NSArray *)sortScores;
@@ -38,15 +48,16 @@
     NSMutableArray *scoresFiltered;
     BOOL isFiltered;
     
-    NSMutableArray *parsers;
-    int finishedParsers;
-    NSCondition *parserCondition;
+    ScoreLibrary *library;
     NSFileManager *fileManager;
     NSString *scoresDirectory;
     NSString *bundleAnnotationsDirectory;
     NSMutableArray *directories;
     NSArray *directoriesSorted;
     NSMutableArray *directoriesFiltered;
+    //Built the first time a list is searched, and thrown away whenever the list changes.
+    ScoreSearchIndex *scoresSearchIndex;
+    ScoreSearchIndex *directoriesSearchIndex;
     NSMutableArray *newDirectories;
     BOOL scoresLoaded;
     __block BOOL refreshInProgress;
@@ -88,7 +99,6 @@
     [super viewDidLoad];
 	// Do any additional setup after loading the view, typically from a nib.
     refreshCondition = [NSCondition new];
-    parserCondition = [NSCondition new];
     
     //Start in the score chooser mode
     viewMode = kChooseScore;
@@ -104,6 +114,12 @@
     scoresDirectory = [self getScoresDirectory];
     bundleAnnotationsDirectory = [[scoresDirectory stringByDeletingLastPathComponent] stringByAppendingPathComponent:@"Annotations"];
     
+    //The library index can be rebuilt at any time, so it goes in the caches directory.
+    NSString *cachesDirectory = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+    library = [[ScoreLibrary alloc] initWithIndexPath:[cachesDirectory stringByAppendingPathComponent:@"ScoreLibrary.index"]];
+    library.bundledThumbnailPath = scoresDirectory;
+    library.bundledAnnotationsPath = bundleAnnotationsDirectory;
+    
     directories = [[NSMutableArray alloc] init];
     directoriesFiltered = [[NSMutableArray alloc] init];
     newDirectories = [self getDirectoryList];
@@ -120,6 +136,12 @@
     [self loadScores];
     firstLoad = NO;
     
+    //Scores imported before the asset store existed have their files shared once, in the
+    //background, one score at a time.
+    if (![[NSUserDefaults standardUserDefaults] boolForKey:@"ScoreAssetsStored"]) {
+        [self storeScorePaths:[directories copy] fromIndex:0];
+    }
+    
     showDocumentsLocation = YES;
     knocks = 0;
     projectionMode = NO;
@@ -420,6 +442,7 @@
             self->dumpButton.title = @"";
             self->knocks = 0;
             [self disableControls:YES];
+            NSArray *scorePaths = [self->directories copy];
             
             //Don't block the main queue while we create our zip file.
             dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
@@ -431,6 +454,9 @@
                     return;
                 }
                 
+                //Check the scores first, so that a damaged one isn't carried into the archive unnoticed.
+                NSArray *damagedScores = [ScoreVerifier corruptScoresInPaths:scorePaths];
+                
                 NSString *zipFileName = [[paths objectAtIndex:0] stringByAppendingPathComponent:@"ScoreDump.zip"];
             
                 //Check if the zip file already exists and remove if necessary.
@@ -438,7 +464,7 @@
                     [self->fileManager removeItemAtPath:zipFileName error:nil];
                 }
                 
-                [SSZipArchive createZipFileAtPath:zipFileName withContentsOfDirectory:self->scoresDirectory];
+                [ZipCompressor compressDirectory:self->scoresDirectory toArchive:zipFileName];
             
                 //Store the creation date.
                 NSDictionary *zipAttrs = [self->fileManager attributesOfItemAtPath:zipFileName error:nil];
@@ -454,6 +480,11 @@
                     [self->dimmer removeFromSuperlayer];
                     [self->dumpIndicator stopAnimating];
                     [self disableControls:NO];
+                    
+                    if ([damagedScores count] > 0) {
+                        [self->corruptScores addObjectsFromArray:damagedScores];
+                        [self handleCorruptScores];
+                    }
                 });
             });
         }];
@@ -513,6 +544,10 @@
                     
                     //Don't block the main queue with the zip operation.
                     dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                        //Every score in the dump is stored below, so there's no need to carry on
+                        //sharing the files of the old collection.
+                        [defaults setBool:YES forKey:@"ScoreAssetsStored"];
+                        
                         for (int i = 0; i < [self->directories count]; i++) {
                             [self->fileManager removeItemAtPath:[self->directories objectAtIndex:i] error:nil];
                         }
@@ -527,10 +562,23 @@
                         [self->directories removeAllObjects];
                         [self->updateAddresses removeAllObjects];
                         [Renderer clearCache];
+                        [ScoreArchive unmountScoresInDirectory:self->scoresDirectory];
                         
-                        //Now unzip our file.
-                        [SSZipArchive unzipFileAtPath:zipFileName toDestination:self->scoresDirectory];
+                        //Now unzip our file. (The entries are inflated in parallel.) The dump has a full
+                        //copy of every score, so their files are shared again, a score at a time so that
+                        //nothing else waiting on the store is held up for long, and then what the old
+                        //collection left behind is cleared out.
+                        [ZipExtractor extractArchive:zipFileName toDestination:self->scoresDirectory];
                         self->newDirectories = [self getDirectoryList];
+                        for (int i = 0; i < [self->newDirectories count]; i++) {
+                            NSString *scorePath = [self->newDirectories objectAtIndex:i];
+                            dispatch_sync([ScoreAssetStore queue], ^{
+                                @autoreleasepool {
+                                    [ScoreAssetStore storeScorePath:scorePath];
+                                }
+                            });
+                        }
+                        [ScoreAssetStore collectGarbageInBackgroundInScoresDirectory:self->scoresDirectory];
                         
                         //Remove the dump file.
                         [self->fileManager removeItemAtPath:zipFileName error:nil];
@@ -604,10 +652,24 @@
     }
     
     //Unzip scores to our scores directory
+    BOOL replacedScores = NO;
     for (int i = 0; i < [zippedScores count]; i++) {
         NSString *fileName = [directory stringByAppendingPathComponent:[zippedScores objectAtIndex:i]];
         NSString *destination = [scoresDirectory stringByAppendingPathComponent:[[zippedScores objectAtIndex:i] stringByDeletingPathExtension]];
         
+        //If this is exactly the version that's already in the library (and it's still intact)
+        //then there's nothing to do but tidy up.
+        NSString *archiveDigest = [ScoreAssetStore digestOfFile:fileName];
+        if (archiveDigest != nil && [ScoreAssetStore scorePath:destination wasImportedFromArchiveWithDigest:archiveDigest] && [ScoreArchive fileExistsAtPath:[destination stringByAppendingPathComponent:@"opus.xml"]] && [ScoreVerifier verifyScorePath:destination]) {
+            [fileManager removeItemAtPath:fileName error:nil];
+            continue;
+        }
+        
+        //The score is locked while it's swapped for the new one so that it can't be stored half
+        //way through. Storing the new version happens afterwards, on the asset store's queue,
+        //which is never waited on here since a refresh can hold up the main queue.
+        BOOL imported = NO;
+        [ScoreAssetStore lockScorePath:destination];
         //If the directory already exists then we'll replace it with the new score.
         //Move the directory to a temporary location until our replacement score successfully unzips.
         BOOL backupMade = NO;
@@ -622,36 +684,30 @@
             }
         }
         
-        //Try to unzip our archive.
-        if ([SSZipArchive unzipFileAtPath:fileName toDestination:destination]) {
-            //If we successfully unzipped the score then we can remove the original file.
-            [fileManager removeItemAtPath:fileName error:nil];
-            
-            //Remove our backup directory.
-            if (backupMade) {
-                [fileManager removeItemAtPath:[destination stringByAppendingString:@".bak"] error:nil];
+        //Scores with their images stored in the archive can be played from it directly, and
+        //are kept as they are. Anything else is unzipped. Nothing checks a mounted archive's CRCs
+        //as it's played, so it's checked once here first. (Unzipping checks them as it goes.)
+        BOOL mounted = [ScoreArchive canMountArchive:fileName] && [ScoreVerifier verifyArchive:fileName] && [ScoreArchive mountArchive:fileName atScorePath:destination];
+        if (mounted || [ZipExtractor extractArchive:fileName toDestination:destination]) {
+            //If we successfully unzipped the score then we can remove the original file, once
+            //its CRCs have been kept so that the score can be checked again later. (A mounted
+            //archive has already been moved into place.)
+            if (!mounted) {
+                [ScoreVerifier writeManifestForArchive:fileName toScorePath:destination];
+                [fileManager removeItemAtPath:fileName error:nil];
             }
             
-            //Remove the directory from our list so that we don't end up with a duplicate when
-            //processing the new scores.
-            [directories removeObject:destination];
-            [updateAddresses removeObjectForKey:destination];
-            
-            //And remove any associated scores from the list.
-            for (int i = 0; i < [scores count]; i++) {
-                if ([((Score *)[scores objectAtIndex:i]).scorePath isEqualToString:destination]) {
-                    [scores removeObjectAtIndex:i];
-                    i--;
-                }
+            //Remember which archive the score came from.
+            if (archiveDigest != nil) {
+                [ScoreAssetStore setArchiveDigest:archiveDigest forScorePath:destination];
             }
             
-            //We also need to clear the image cache so that we don't have any references to old images
-            [Renderer removeDirectoryFromCache:destination];
-            
-            //Add the destination directory to the list of new directories for processing.
-            if ([newDirectories indexOfObject:destination] == NSNotFound) {
-                [newDirectories addObject:destination];
+            //Remove our backup directory.
+            if (backupMade) {
+                [fileManager removeItemAtPath:[destination stringByAppendingString:@".bak"] error:nil];
+                replacedScores = YES;
             }
+            imported = YES;
         } else {
             //Something went wrong while unzipping. If we're refreshing the list then the most likely
             //problem is that we tried to update while files were still being copied to the device.
@@ -671,17 +727,85 @@
                 }
             }
         }
+        [ScoreAssetStore unlockScorePath:destination];
+        
+        if (imported) {
+            //Share the files the score has in common with the rest of the library.
+            [ScoreAssetStore storeScorePathInBackground:destination];
+            [self replacedScoreAtPath:destination];
+        }
+    }
+    
+    //Files that only the old versions used can go now.
+    if (replacedScores) {
+        [ScoreAssetStore collectGarbageInBackgroundInScoresDirectory:scoresDirectory];
     }
     return YES;
 }
 
+- (void)replacedScoreAtPath:(NSString *)scorePath
+{
+    //Remove the directory from our list so that we don't end up with a duplicate when
+    //processing the new scores.
+    [directories removeObject:scorePath];
+    [updateAddresses removeObjectForKey:scorePath];
+    
+    //And remove any associated scores from the list.
+    for (int i = 0; i < [scores count]; i++) {
+        if ([((Score *)[scores objectAtIndex:i]).scorePath isEqualToString:scorePath]) {
+            [scores removeObjectAtIndex:i];
+            i--;
+        }
+    }
+    
+    //We also need to clear the image cache so that we don't have any references to old images,
+    //and throw away the compiled form of the old version.
+    [Renderer removeDirectoryFromCache:scorePath];
+    [CompiledScore removeCompiledScoreForScorePath:scorePath];
+    [ImageSizeIndex removeScorePath:scorePath];
+    [ScoreArchive unmountScoresInDirectory:scorePath];
+    
+    //Add the directory to the list of new directories for processing.
+    if ([newDirectories indexOfObject:scorePath] == NSNotFound) {
+        [newDirectories addObject:scorePath];
+    }
+}
+
+- (void)storeScorePaths:(NSArray *)scorePaths fromIndex:(NSUInteger)index
+{
+    //Each score is stored in a block of its own, and the next is queued from there, so it goes
+    //in behind anything that's been queued on the store in the meantime. That way nothing else
+    //that needs the store ever waits for more than one score of the backlog.
+    dispatch_async([ScoreAssetStore queue], ^{
+        //Restoring a dump stores every score itself, and sets the flag to say so.
+        NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+        if ([defaults boolForKey:@"ScoreAssetsStored"]) {
+            return;
+        }
+        if (index == [scorePaths count]) {
+            [ScoreAssetStore collectGarbageInScoresDirectory:self->scoresDirectory];
+            [defaults setBool:YES forKey:@"ScoreAssetsStored"];
+            return;
+        }
+        
+        //Scores that have been deleted since don't need storing.
+        NSString *scorePath = [scorePaths objectAtIndex:index];
+        if ([[NSFileManager defaultManager] fileExistsAtPath:scorePath]) {
+            @autoreleasepool {
+                [ScoreAssetStore storeScorePath:scorePath];
+            }
+        }
+        [self storeScorePaths:scorePaths fromIndex:index + 1];
+    });
+}
+
 - (void)loadScores
 {
     //Change flags as needed. The loaded flag is set false to show that a load operation is in progress.
     scoresLoaded = NO;
     
     for (int i = 0; i < [newDirectories count]; i++) {
-        if (![fileManager fileExistsAtPath:[[newDirectories objectAtIndex:i] stringByAppendingPathComponent:@"opus.xml"]]) {
+        if (![ScoreArchive fileExistsAtPath:[[newDirectories objectAtIndex:i] stringByAppendingPathComponent:@"opus.xml"]]) {
             //If no score definition exists in the subdirectory then this isn't a valid score and
             //shouldn't be in the scores directory. Remove it from our processing list and delete it.
             [fileManager removeItemAtPath:[newDirectories objectAtIndex:i] error:nil];
@@ -689,48 +813,36 @@
         }
     }
     
-    //If this is our first load, start with the bundled scores.
-    parsers = [[NSMutableArray alloc] init];
-    if (firstLoad) {
-        NSData *xmlScore = [[NSData alloc] initWithContentsOfFile:[[NSBundle mainBundle] pathForResource:@"Bundled" ofType:@"xml"]];
-        OpusParser *parser = [[OpusParser alloc] initWithData:xmlScore scorePath:[[NSBundle mainBundle] bundlePath] timeOut:5 asScoreComponent:NO];
-        parser.thumbnailPath = scoresDirectory;
-        parser.annotationsPath = bundleAnnotationsDirectory;
-        parser.delegate = self;
-        [parsers addObject:parser];
-    }
-    
-    //Set up the remaining parsers.
-    for (int i = 0; i < [newDirectories count]; i++) {
-        NSData *xmlScore = [[NSData alloc] initWithContentsOfFile:[[newDirectories objectAtIndex:i] stringByAppendingPathComponent:@"opus.xml"]];
-        OpusParser *parser = [[OpusParser alloc] initWithData:xmlScore scorePath:[newDirectories objectAtIndex:i] timeOut:5 asScoreComponent:NO];
-        parser.delegate = self;
-        [parsers addObject:parser];
-    }
-    
-    //Then start.
-    [parserCondition lock];
-    finishedParsers = 0;
-    [parserCondition unlock];
-    for (int i = 0; i < [parsers count]; i++) {
-        [[parsers objectAtIndex:i] startParse];
-    }
-    
-    //Wait for all of our parsers to finish or time out, then clean up.
-    [parserCondition lock];
-    while (finishedParsers < [parsers count]) {
-        [parserCondition wait];
+    //Get the new directories from the library, starting with the bundled scores if this is our first
+    //load. Only directories that have changed since they were last indexed are parsed again.
+    NSArray *entries = [library loadScoreDirectories:newDirectories includeBundledScores:firstLoad];
+    for (int i = 0; i < [entries count]; i++) {
+        ScoreLibraryEntry *entry = [entries objectAtIndex:i];
+        if (entry.corrupt) {
+            if (![entry.scorePath isEqualToString:[[NSBundle mainBundle] bundlePath]]) {
+                [corruptScores addObject:entry.scorePath];
+            }
+            continue;
+        }
+        
+        if (entry.updateURL != nil) {
+            [updateAddresses setObject:[NSArray arrayWithObjects:entry.updateURL, entry.opusVersion, nil] forKey:entry.scorePath];
+        }
+        [scores addObjectsFromArray:entry.scores];
     }
-    [parsers removeAllObjects];
-    [parserCondition unlock];
     
     //We're done loading the scores. Now sort them alphabetically by composer and name.
     scoresSorted = [self sortScores];
+    scoresSearchIndex = nil;
+    
+    //Compile any new or changed scores in the background so that they load quickly when they're opened.
+    [CompiledScore compileScorePathsInBackground:newDirectories];
     
     //Update the master directory list by appending the new directories we just processed
     [directories addObjectsFromArray:newDirectories];
     [newDirectories removeAllObjects];
     directoriesSorted = [self sortDirectories];
+    directoriesSearchIndex = nil;
     
     //The remaining code contains all sorts of user interface updates, so make sure we're on the main queue.
     
@@ -780,7 +892,7 @@
             BOOL isDirectory = NO;
             NSString *currentFile = [scoresDirectory stringByAppendingPathComponent:[directoryContents objectAtIndex:i]];
             [fileManager fileExistsAtPath:currentFile isDirectory:&isDirectory];
-            if (isDirectory) {
+            if (isDirectory && ![ScoreAssetStore isStoreDirectory:currentFile]) {
                 [directoryList addObject:currentFile];
             }
         }
@@ -841,6 +953,7 @@
         [corruptScores removeAllObjects];
         handlingCorruptScores = NO;
         directoriesSorted = [self sortDirectories];
+        directoriesSearchIndex = nil;
         return;
     }
     
@@ -848,6 +961,7 @@
     UIAlertAction *yesAction = [UIAlertAction actionWithTitle:@"Yes" style:UIAlertActionStyleDestructive handler:^(UIAlertAction *action) {
         [self->fileManager removeItemAtPath:[self->corruptScores objectAtIndex:self->currentCorruptScore] error:nil];
         [self->directories removeObject:[self->corruptScores objectAtIndex:self->currentCorruptScore]];
+        [ScoreAssetStore collectGarbageInBackgroundInScoresDirectory:self->scoresDirectory];
         [self processNextCorruptScore];
     }];
     UIAlertAction *noAction = [UIAlertAction actionWithTitle:@"No" style:UIAlertActionStyleDefault handler:^(UIAlertAction *action) {
@@ -933,9 +1047,7 @@
         }
         cell.textLabel.text = ((Score *)[dataSource objectAtIndex:indexPath.row]).scoreName;
         cell.detailTextLabel.text = ((Score *)[dataSource objectAtIndex:indexPath.row]).composerFullText;
-        NSString *fileName = [NSString stringWithFormat:@".%@.%@.thumbnail.png", ((Score *)[dataSource objectAtIndex:indexPath.row]).composerFullText, ((Score *)[dataSource objectAtIndex:indexPath.row]).scoreName];
-        fileName = [fileName stringByReplacingOccurrencesOfString:@"/" withString:@"-"];
-        fileName = [fileName stringByReplacingOccurrencesOfString:@":" withString:@"."];
+        NSString *fileName = ((Score *)[dataSource objectAtIndex:indexPath.row]).thumbnailFileName;
         if ([((Score *)[dataSource objectAtIndex:indexPath.row]).scorePath isEqualToString:[[NSBundle mainBundle] bundlePath]]) {
             fileName = [scoresDirectory stringByAppendingPathComponent:fileName];
         } else {
@@ -990,8 +1102,10 @@
             directoryIndex = [directories indexOfObjectIdenticalTo:[directoriesSorted objectAtIndex:indexPath.row]];
         }
         
-        //First we need to delete the directory associated with the row
+        //First we need to delete the directory associated with the row, along with any files
+        //that only it was using.
         [fileManager removeItemAtPath:[directories objectAtIndex:directoryIndex] error:nil];
+        [ScoreAssetStore collectGarbageInBackgroundInScoresDirectory:scoresDirectory];
         
         //Then remove any scores associated with that directory
         for (int i = 0; i < [scores count]; i++) {
@@ -1001,6 +1115,7 @@
             }
         }
         scoresSorted = [self sortScores];
+        scoresSearchIndex = nil;
         
         //Do the same for our filtered scores if necessary.
         if (isFiltered) {
@@ -1012,8 +1127,11 @@
             }
         }
         
-        //Clear any images from the cache that were located in that directory
+        //Clear any images from the cache that were located in that directory, along with its compiled form
         [Renderer removeDirectoryFromCache:[directories objectAtIndex:directoryIndex]];
+        [CompiledScore removeCompiledScoreForScorePath:[directories objectAtIndex:directoryIndex]];
+        [ImageSizeIndex removeScorePath:[directories objectAtIndex:directoryIndex]];
+        [ScoreArchive unmountScoresInDirectory:[directories objectAtIndex:directoryIndex]];
         [updateAddresses removeObjectForKey:[directories objectAtIndex:directoryIndex]];
         
         if ([updateAddresses count] == 0 && projectionButton.enabled) {
@@ -1024,6 +1142,7 @@
         //Then remove the reference from the directories array and the table
         [directories removeObjectAtIndex:directoryIndex];
         directoriesSorted = [self sortDirectories];
+        directoriesSearchIndex = nil;
         [tableView deleteRowsAtIndexPaths:[NSArray arrayWithObject:indexPath] withRowAnimation:UITableViewRowAnimationFade];
         
     } //else if (editingStyle == UITableViewCellEditingStyleInsert) {
@@ -1118,45 +1237,25 @@
     }
 }
 
-#pragma mark - OpusParser delegate
-
-- (void)parserFinished:(id)parser withScores:(NSMutableArray *)newScores;
-{
-    if (((OpusParser *)parser).updateURL != nil) {
-        NSString *updateURL = ((OpusParser *)parser).updateURL;
-        NSString *version = ((OpusParser *)parser).opusVersion;
-        [updateAddresses setObject:[NSArray arrayWithObjects:updateURL, version, nil] forKey:((OpusParser *)parser).scorePath];
-    }
-    
-    ((OpusParser *)parser).delegate = nil;
-    [scores addObjectsFromArray:newScores];
-    [parserCondition lock];
-    finishedParsers++;
-    [parserCondition signal];
-    [parserCondition unlock];
-}
+#pragma mark - UpdateDelegate
 
-- (void)parserError:(id)parser
+- (void)downloadedUpdatesToDirectory:(NSString *)downloadDirectory
 {
-    ((OpusParser *)parser).delegate = nil;
-    if (![((OpusParser *)parser).scorePath isEqualToString:[[NSBundle mainBundle] bundlePath]]) {
-        [corruptScores addObject:((OpusParser *)parser).scorePath];
+    //Scores that were updated in place are already waiting to be loaded.
+    BOOL imported = downloadDirectory != nil && [self importScoresFromDirectory:downloadDirectory];
+    if (imported || [newDirectories count] > 0) {
+        [self loadScores];
     }
-    [parserCondition lock];
-    finishedParsers++;
-    [parserCondition signal];
-    [parserCondition unlock];
 }
 
-#pragma mark - UpdateDelegate
-
-- (void)downloadedUpdatesToDirectory:(NSString *)downloadDirectory
+- (void)updatedScoresAtPaths:(NSArray *)scorePaths
 {
-    if (downloadDirectory != nil) {
-        if ([self importScoresFromDirectory:downloadDirectory]) {
-            [self loadScores];
-        }
+    for (int i = 0; i < [scorePaths count]; i++) {
+        [self replacedScoreAtPath:[scorePaths objectAtIndex:i]];
     }
+    
+    //Files that only the old versions used can go now.
+    [ScoreAssetStore collectGarbageInBackgroundInScoresDirectory:scoresDirectory];
 }
 
 - (void)finishedUpdating
@@ -1187,23 +1286,33 @@
         isFiltered = NO;
     } else {
         isFiltered = YES;
+        if (scoresSearchIndex == nil) {
+            scoresSearchIndex = [[ScoreSearchIndex alloc] initWithFieldCount:2];
+            for (int i = 0; i < [scoresSorted count]; i++) {
+                Score *score = [scoresSorted objectAtIndex:i];
+                [scoresSearchIndex addEntryWithFields:[NSArray arrayWithObjects:(score.scoreName == nil ? @"" : score.scoreName), score.composerFullText, nil]];
+            }
+        }
+        if (directoriesSearchIndex == nil) {
+            directoriesSearchIndex = [[ScoreSearchIndex alloc] initWithFieldCount:1];
+            for (int i = 0; i < [directories count]; i++) {
+                [directoriesSearchIndex addEntryWithFields:[NSArray arrayWithObject:[[directories objectAtIndex:i] lastPathComponent]]];
+            }
+        }
+        
         //Filter both our scores and directories so that we can change between view modes easily.
+        //The best matches come first. (Each search only looks through the results of the last one
+        //if it extends it.)
         [scoresFiltered removeAllObjects];
-        
-        for (int i = 0; i < [scoresSorted count]; i++) {
-            NSRange nameRange = [((Score *)[scoresSorted objectAtIndex:i]).scoreName rangeOfString:searchText options:NSCaseInsensitiveSearch];
-            NSRange composerRange = [((Score *)[scoresSorted objectAtIndex:i]).composerFullText rangeOfString:searchText options:NSCaseInsensitiveSearch];
-            if (nameRange.location != NSNotFound || composerRange.location != NSNotFound) {
-                [scoresFiltered addObject:[scoresSorted objectAtIndex:i]];
-            }
+        NSArray *matches = [scoresSearchIndex search:searchText];
+        for (int i = 0; i < [matches count]; i++) {
+            [scoresFiltered addObject:[scoresSorted objectAtIndex:[[matches objectAtIndex:i] integerValue]]];
         }
-        [directoriesFiltered removeAllObjects];
         
-        for (int i = 0; i < [directories count]; i++) {
-            NSRange pathRange = [[[directories objectAtIndex:i] lastPathComponent] rangeOfString:searchText options:NSCaseInsensitiveSearch];
-            if (pathRange.location != NSNotFound) {
-                [directoriesFiltered addObject:[directories objectAtIndex:i]];
-            }
+        [directoriesFiltered removeAllObjects];
+        matches = [directoriesSearchIndex search:searchText];
+        for (int i = 0; i < [matches count]; i++) {
+            [directoriesFiltered addObject:[directories objectAtIndex:[[matches objectAtIndex:i] integerValue]]];
         }
     }
     
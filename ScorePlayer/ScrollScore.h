@@ -10,6 +10,8 @@
 #import "Renderer.h"
 
 static const CGFloat MAX_SCROLLER_FRAMERATE = 25;
+//How many seconds before a fragment jump to start loading the destination.
+static const int FRAGMENT_PREFETCH_TIME = 2;
 
 typedef enum {
     kTopLevel = 0,
@@ -61,6 +63,8 @@ typedef enum {
 @property (nonatomic, strong) NSString *annotationsDirectory;
 @property (nonatomic) CGSize canvasSize;
 @property (nonatomic) ScrollOrientation orientation;
+//Signed scrolling speed in points per second. (Negative when the score is moving left.)
+@property (nonatomic) CGFloat scrollVelocity;
 
 + (NSArray *)arrayTags;
 + (NSArray *)dictionaryTags;
@@ -72,6 +76,7 @@ typedef enum {
 - (CALayer *)currentAnnotationMask;
 - (void)saveCurrentAnnotation:(UIImage *)image;
 - (void)hideSavedAnnotations:(BOOL)hide;
+- (void)prefetchForX:(CGFloat)x;
 
 @end
 
@@ -10,15 +10,19 @@
 #import "ScrollScore.h"
 #import "Score.h"
 #import "OSCMessage.h"
+#import "FrameClock.h"
+#import "TilePyramid.h"
+#import "CompiledScore.h"
+#import "ScoreArchive.h"
 
-@interface ScrollScore ()
+@interface ScrollScore () <FrameClockSubscriber>
 
-- (void)animate;
 - (void)enableHighResTimer:(BOOL)enabled;
 - (void)enableHighResTimer:(BOOL)enabled withSpeedMultiplier:(CGFloat)speed;
 - (void)changePart:(NSInteger)relativeChange;
 - (void)randomizeMiddleForDuration:(CGFloat)duration;
 - (OSCMessage *)createFragmentsMessageAsNew:(BOOL)new;
+- (CGFloat)scrollerPositionForFragment:(NSInteger)index;
 - (void)jumpToNextFragment;
 - (void)countIn;
 - (void)sendScrollerData;
@@ -45,7 +49,10 @@
     BOOL isTiled;
     NSInteger numberOfTiles;
 
-    NSTimer *highRes;
+    BOOL animating;
+    CFTimeInterval animationStartTime;
+    CGFloat animationStartX;
+    CGFloat pixelsPerSecond;
     NSInteger pixelsPerShift;
     BOOL firstLoad;
     NSTimer *countIn;
@@ -118,12 +125,16 @@
     __weak id<RendererMessaging> messagingDelegate;
 }
 
-- (void)animate
+- (void)animateToTime:(CFTimeInterval)frameTime
 {
-    //Calculate the new x coordinate of the scoller. Do this before actually moving the layer
-    //so that we can check that we're not going to overshoot the final position if moving multiple
-    //pixels as a time.
-    int scrollerX = scroller.x - (direction * pixelsPerShift);
+    //Calculate the new x coordinate of the scoller from the time since we started moving, in
+    //whole shifts. Do this before actually moving the layer so that we can check that we're not
+    //going to overshoot the final position if moving multiple pixels as a time.
+    NSInteger shifts = floor(pixelsPerSecond * MAX(frameTime - animationStartTime, 0) / pixelsPerShift);
+    int scrollerX = animationStartX - (direction * shifts * pixelsPerShift);
+    if (scrollerX == scroller.x) {
+        return;
+    }
     //scroller.position = CGPointMake(scroller.position.x - (direction * pixelsPerShift), yOffset);
     switch (currentSection) {
         case 0:
@@ -165,15 +176,22 @@
     }
     
     if (enabled) {
-        //If our high resolution timer already exists, invalidate it.
-        if (highRes != nil) {
-            [highRes invalidate];
+        //Restart our animation from the current position, even if it's already running.
+        animationStartTime = [[FrameClock sharedClock] currentTime];
+        animationStartX = scroller.x;
+        pixelsPerSecond = (scroller.width - startOffset) * speed / graphicDuration;
+        [[FrameClock sharedClock] addSubscriber:self];
+        animating = YES;
+        if ([scroller respondsToSelector:@selector(setScrollVelocity:)]) {
+            scroller.scrollVelocity = -direction * pixelsPerSecond;
         }
-        highRes = [NSTimer scheduledTimerWithTimeInterval:(pixelsPerShift * graphicDuration / ((scroller.width - startOffset) * speed)) target:self selector:@selector(animate) userInfo:nil repeats:YES];
     } else {
-        if (highRes != nil) {
-            [highRes invalidate];
-            highRes = nil;
+        if (animating) {
+            [[FrameClock sharedClock] removeSubscriber:self];
+            animating = NO;
+        }
+        if ([scroller respondsToSelector:@selector(setScrollVelocity:)]) {
+            scroller.scrollVelocity = 0;
         }
     }
 }
@@ -361,6 +379,18 @@
     return message;
 }
 
+- (CGFloat)scrollerPositionForFragment:(NSInteger)index
+{
+    if (index < [workingFragments count]) {
+        int x = -[[[workingFragments objectAtIndex:index] objectAtIndex:2] intValue];
+        x *= scroller.width / ([scroller originalSizeOfImages:[score.scorePath stringByAppendingPathComponent:score.fileName]]).width;
+        return x + readLineOffset;
+    } else {
+        //Beyond the last fragment we go to the start of the final section.
+        return readLineOffset - scroller.width;
+    }
+}
+
 - (void)jumpToNextFragment
 {
     [self enableHighResTimer:NO];
@@ -375,18 +405,14 @@
     [CATransaction setDisableActions:YES];
     
     CGFloat speed = 1;
+    scroller.x = [self scrollerPositionForFragment:fragmentIndex];
     if (fragmentIndex < [workingFragments count]) {
         nextFragmentChange += [[[workingFragments objectAtIndex:fragmentIndex] objectAtIndex:0] intValue];
         direction = [[[workingFragments objectAtIndex:fragmentIndex] objectAtIndex:1] intValue];
-        int x = -[[[workingFragments objectAtIndex:fragmentIndex] objectAtIndex:2] intValue];
-        x *= scroller.width / ([scroller originalSizeOfImages:[score.scorePath stringByAppendingPathComponent:score.fileName]]).width;
-        x += readLineOffset;
-        scroller.x = x;
         speed = [[[workingFragments objectAtIndex:fragmentIndex] objectAtIndex:4] floatValue];
         currentSection = 1;
     } else {
         //If we're beyond the number of available fragments then jump to the start of the final section
-        scroller.x = readLineOffset - scroller.width;
         currentSection = 2;
         direction = -1;
     }
@@ -582,26 +608,29 @@
     CGFloat screenScale = [[UIScreen mainScreen] scale];
     size = CGSizeMake(size.width * screenScale, size.height * screenScale);
     
-    UIImage *image = [UIImage imageWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.fileName]];
+    //Use pre-scaled images if we have them, but keep working in the original image dimensions.
+    NSString *firstFileName = [score.scorePath stringByAppendingPathComponent:score.fileName];
+    CGSize imageSize = [Renderer getImageSize:firstFileName];
     UIGraphicsBeginImageContext(size);
-    CGFloat scaleFactor = size.height / image.size.height;
+    CGFloat scaleFactor = size.height / imageSize.height;
+    UIImage *image = [ScoreArchive imageWithContentsOfFile:[TilePyramid pathForImage:firstFileName atScale:scaleFactor]];
     //Position our image from the start offset so that we see the actual score and not just instructions.
-    [image drawInRect:CGRectMake(-(CGFloat)score.startOffset * scaleFactor, 0, image.size.width * scaleFactor, size.height)];
-    CGFloat position = (image.size.width - (CGFloat)score.startOffset) * scaleFactor;
+    [image drawInRect:CGRectMake(-(CGFloat)score.startOffset * scaleFactor, 0, imageSize.width * scaleFactor, size.height)];
+    CGFloat position = (imageSize.width - (CGFloat)score.startOffset) * scaleFactor;
     
     if (position < size.width) {
         //Someone may have created a score with ridiculously small tiles... Sigh...
-        NSFileManager *fileManager = [NSFileManager defaultManager];
         int i = 2;
         while (position < size.width) {
             NSString *fileName = [score.scorePath stringByAppendingPathComponent:[score.fileName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i." , i]]];
-            if (![fileManager fileExistsAtPath:fileName]) {
+            if (![ScoreArchive fileExistsAtPath:fileName]) {
                 //We tried.
                 break;
             }
-            UIImage *image = [UIImage imageWithContentsOfFile:fileName];
-            [image drawInRect:CGRectMake(position, 0, image.size.width * scaleFactor, size.height)];
-            position += image.size.width * scaleFactor;
+            CGSize tileSize = [Renderer getImageSize:fileName];
+            UIImage *image = [ScoreArchive imageWithContentsOfFile:[TilePyramid pathForImage:fileName atScale:scaleFactor]];
+            [image drawInRect:CGRectMake(position, 0, tileSize.width * scaleFactor, size.height)];
+            position += tileSize.width * scaleFactor;
             i++;
         }
     }
@@ -672,8 +701,10 @@
     //Load any advanced preferances if the necessary file exists.
     
     if (score.prefsFile != nil) {
-        NSString *prefsFile = [score.scorePath stringByAppendingPathComponent:score.prefsFile];
-        NSData *prefsData = [[NSData alloc] initWithContentsOfFile:prefsFile];
+        NSData *prefsData = [[CompiledScore compiledScoreForScorePath:score.scorePath] dataForFile:score.prefsFile];
+        if (prefsData == nil) {
+            prefsData = [ScoreArchive dataWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
+        }
         xmlParser = [[NSXMLParser alloc] initWithData:prefsData];
             
         isData = NO;
@@ -740,9 +771,14 @@
         
         //If there are parts, check that they are the same width as the score.
         if ([score.parts count]  && [[scroller class] allowsParts]) {
-            int width = [Renderer getImageSize:[score.scorePath stringByAppendingString:score.fileName]].width;
+            NSMutableArray *fileNames = [[NSMutableArray alloc] initWithObjects:[score.scorePath stringByAppendingString:score.fileName], nil];
             for (int i = 0; i < [score.parts count]; i++) {
-                if ([Renderer getImageSize:[score.scorePath stringByAppendingString:[score.parts objectAtIndex:i]]].width != width) {
+                [fileNames addObject:[score.scorePath stringByAppendingString:[score.parts objectAtIndex:i]]];
+            }
+            NSArray *sizes = [Renderer getImageSizes:fileNames];
+            int width = [[sizes objectAtIndex:0] CGSizeValue].width;
+            for (int i = 1; i < [sizes count]; i++) {
+                if ([[sizes objectAtIndex:i] CGSizeValue].width != width) {
                     [UIDelegate badPreferencesFile:@"Mismatching image sizes. Widths of score and parts must be the same."];
                     return;
                 }
@@ -1079,7 +1115,7 @@
     //That's what I want to do to you if you're causing this particular snippet of code to execute.)
     if (UIDelegate.playerState == kPlaying) {
         [self enableHighResTimer:NO];
-        highRes = [NSTimer scheduledTimerWithTimeInterval:(pixelsPerShift * graphicDuration / (scroller.width - startOffset)) target:self selector:@selector(animate) userInfo:nil repeats:YES];
+        [self enableHighResTimer:YES];
         //If we're the master, synch to the player clock. (If we're not we'll be synched to the network
         //clock by the player.)
         if (isMaster) {
@@ -1179,6 +1215,9 @@
     if (liminumMode || juanitaMode) {
         if (progress == nextFragmentChange) {
             [self jumpToNextFragment];
+        } else if (progress == nextFragmentChange - FRAGMENT_PREFETCH_TIME && [scroller respondsToSelector:@selector(prefetchForX:)]) {
+            //Give the scroller a head start on loading wherever we're about to jump to.
+            [scroller prefetchForX:[self scrollerPositionForFragment:fragmentIndex + 1]];
         }
     }
     
@@ -1379,8 +1418,7 @@
             } else if ([elementName isEqualToString:@"image"]) {
                 readLineImageName = currentString;
                 //Check that the image file exists
-                NSFileManager *fileManager = [NSFileManager defaultManager];
-                if ([fileManager fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:readLineImageName]]) {
+                if ([ScoreArchive fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:readLineImageName]]) {
                     readLineStyle = kCustomImage;
                 }
             } else if ([elementName isEqualToString:@"align"]) {
@@ -1499,41 +1537,42 @@
     }
     
     //If we're a tiled score, we need to check that all of our images actually exist.
-    //(Also check to make sure that they're all the same width.)
+    //(Also check to make sure that they're all the same width.) A compiled score already lists
+    //every file along with its dimensions, so use that instead of going to each file if we can.
+    //Otherwise the sizes of all of the tiles are read together, in parallel.
+    CompiledScore *compiledScore = [CompiledScore compiledScoreForScorePath:score.scorePath];
     if (isTiled) {
-        NSFileManager *fileManager = [NSFileManager defaultManager];
-        int width = [Renderer getImageSize:[score.scorePath stringByAppendingPathComponent:score.fileName]].width;
-        
+        NSMutableArray *tileNames = [[NSMutableArray alloc] init];
+        NSMutableArray *fileNames = [[NSMutableArray alloc] init];
         for (int i = 1; i <= numberOfTiles; i++) {
-            NSString *fileName = [score.scorePath stringByAppendingPathComponent:[score.fileName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i." , i]]];
-            if (![fileManager fileExistsAtPath:fileName]) {
+            [tileNames addObject:[score.fileName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i." , i]]];
+            for (int j = 0; j < [score.parts count]; j++) {
+                [tileNames addObject:[[score.parts objectAtIndex:j] stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i." , i]]];
+            }
+        }
+        for (int i = 0; i < [tileNames count]; i++) {
+            [fileNames addObject:[score.scorePath stringByAppendingPathComponent:[tileNames objectAtIndex:i]]];
+        }
+        
+        NSArray *sizes = [Renderer getImageSizes:[[NSArray arrayWithObject:[score.scorePath stringByAppendingPathComponent:score.fileName]] arrayByAddingObjectsFromArray:fileNames]];
+        int width = [[sizes objectAtIndex:0] CGSizeValue].width;
+        for (int i = 0; i < [fileNames count]; i++) {
+            //Only files that couldn't be read need checking for.
+            CGSize tileSize = [[sizes objectAtIndex:i + 1] CGSizeValue];
+            if (tileSize.width == 0 && ![compiledScore hasFile:[tileNames objectAtIndex:i]] && ![ScoreArchive fileExistsAtPath:[fileNames objectAtIndex:i]]) {
                 badPrefs = YES;
                 errorMessage = @"Missing images in score file.";
-            } else if ([Renderer getImageSize:fileName].width != width) {
+            } else if (tileSize.width != width) {
                 badPrefs = YES;
                 errorMessage = @"Mismatching tile dimensions. All image widths must be the same for tiled scores.";
             }
-            
-            if ([score.parts count] > 0) {
-                for (int j = 0; j < [score.parts count]; j++) {
-                    NSString *partFile = [score.scorePath stringByAppendingPathComponent:[[score.parts objectAtIndex:j] stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i." , i]]];
-                    if (![fileManager fileExistsAtPath:partFile]) {
-                        badPrefs = YES;
-                        errorMessage = @"Missing images in score file.";
-                    } else if ([Renderer getImageSize:partFile].width != width) {
-                        badPrefs = YES;
-                        errorMessage = @"Mismatching tile dimensions. All image widths must be the same for tiled scores.";
-                    }
-                }
-            }
         }
     } else if (numberOfTiles > 1) {
         //Not a tiled score, but one that uses a set of images need to check that these exist.
-        NSFileManager *fileManager = [NSFileManager defaultManager];
         
         for (int i = 2; i <= numberOfTiles; i++) {
-            NSString *fileName = [score.scorePath stringByAppendingPathComponent:[score.fileName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i]]];
-            if (![fileManager fileExistsAtPath:fileName]) {
+            NSString *tileName = [score.fileName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i]];
+            if (![compiledScore hasFile:tileName] && ![ScoreArchive fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:tileName]]) {
                 badPrefs = YES;
                 errorMessage = @"Missing images in score file.";
             }
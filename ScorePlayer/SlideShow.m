@@ -10,10 +10,15 @@
 #import "SlideShow.h"
 #import "Score.h"
 #import "OSCMessage.h"
+#import "DecodeService.h"
+#import "ScoreArchive.h"
 
 @interface SlideShow ()
 
 - (void)displaySlide:(int)slideNumber;
+- (NSString *)fileNameForSlide:(int)slideNumber withBaseName:(NSString *)baseFileName;
+- (void)loadImage:(NSString *)fileName intoLayer:(CALayer *)layer useCache:(BOOL)useCache;
+- (void)prefetchSlide:(int)slideNumber withBaseName:(NSString *)baseFileName priority:(DecodePriority)priority;
 - (void)changePart:(NSInteger)relativeChange;
 - (NSMutableArray *)getChangesForPart:(NSInteger)partNumber;
 - (int)getCurrentSlideForPart:(NSInteger)partNumber atPosition:(int)progress;
@@ -48,6 +53,9 @@
     NSString *annotationsFileName;
     NSString *annotationsFileNameB;
     
+    NSMutableArray *slideRequests;
+    NSMutableArray *prefetchRequests;
+    
     NSXMLParser *xmlParser;
     NSMutableString *currentString;
     BOOL isData;
@@ -76,21 +84,9 @@
         baseFileName = [score.scorePath stringByAppendingPathComponent:[[score.parts objectAtIndex:currentPart - 1] stringByDeletingPathExtension]];
     }
     NSString *newFileName, *newFileNameB;
-    NSFileManager *fileManager = [NSFileManager defaultManager];
-    
-    //Try for a png file first, otherwise we've got a jpg.
-    if ([fileManager fileExistsAtPath:[baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.png" , slideNumber]]]) {
-        newFileName = [baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.png" , slideNumber]];
-    } else {
-        newFileName = [baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.jpg" , slideNumber]];
-    }
-    
+    newFileName = [self fileNameForSlide:slideNumber withBaseName:baseFileName];
     if (splitMode) {
-        if ([fileManager fileExistsAtPath:[baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.png" , slideNumber + 1]]]) {
-            newFileNameB = [baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.png" , slideNumber + 1]];
-        } else {
-            newFileNameB = [baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.jpg" , slideNumber + 1]];
-        }
+        newFileNameB = [self fileNameForSlide:slideNumber + 1 withBaseName:baseFileName];
     }
     
     if (annotationsDirectory != nil) {
@@ -101,40 +97,49 @@
         annotationsFileName = [annotationsFileName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i." , slideNumber]];
     }
     
-    //Now load the image into our layer
+    if (splitMode && slideNumber % 2 == 0) {
+        //Swap our names so that B always refers to our bottom panel.
+        NSString *nameSwap = newFileName;
+        newFileName = newFileNameB;
+        newFileNameB = nameSwap;
+        nameSwap = annotationsFileName;
+        annotationsFileName = annotationsFileNameB;
+        annotationsFileNameB = nameSwap;
+    }
+    
+    //Now load the images into our layers. These are decoded in the background, and the layers
+    //keep showing the previous slide until they arrive. (Cached slides are shown straight away.)
     canvas.sublayers = nil;
-    UIImage *slideImage = [Renderer cachedImage:newFileName];
-    UIImage *slideImageB;
-    if (splitMode) {
-        slideImageB = [Renderer cachedImage:newFileNameB];
+    for (DecodeRequest *request in slideRequests) {
+        [request cancel];
     }
+    slideRequests = [[NSMutableArray alloc] init];
     
-    [CATransaction begin];
-    [CATransaction setDisableActions:YES];
+    [self loadImage:newFileName intoLayer:slideLayerA useCache:YES];
     if (splitMode) {
-        if (slideNumber % 2 == 1) {
-            slideLayerA.contents = (id)slideImage.CGImage;
-            slideLayerB.contents = (id)slideImageB.CGImage;
-            annotationLayerA.contents = (id)[UIImage imageWithContentsOfFile:annotationsFileName].CGImage;
-            annotationLayerB.contents = (id)[UIImage imageWithContentsOfFile:annotationsFileNameB].CGImage;
-        } else {
-            slideLayerA.contents = (id)slideImageB.CGImage;
-            slideLayerB.contents = (id)slideImage.CGImage;
-            annotationLayerA.contents = (id)[UIImage imageWithContentsOfFile:annotationsFileNameB].CGImage;
-            annotationLayerB.contents = (id)[UIImage imageWithContentsOfFile:annotationsFileName].CGImage;
-            
-            //Swap our names so that B always refers to our bottom panel.
-            NSString *nameSwap = annotationsFileName;
-            annotationsFileName = annotationsFileNameB;
-            annotationsFileNameB = nameSwap;
+        [self loadImage:newFileNameB intoLayer:slideLayerB useCache:YES];
+        [self loadImage:annotationsFileName intoLayer:annotationLayerA useCache:NO];
+        [self loadImage:annotationsFileNameB intoLayer:annotationLayerB useCache:NO];
+    } else if (annotationsDirectory != nil) {
+        [self loadImage:annotationsFileName intoLayer:annotationLayer useCache:NO];
+    }
+    
+    //Get the slides on either side of this one ready in the cache. Going forwards is more likely.
+    for (DecodeRequest *request in prefetchRequests) {
+        [request cancel];
+    }
+    prefetchRequests = [[NSMutableArray alloc] init];
+    int step = splitMode ? 2 : 1;
+    for (int i = 0; i < step; i++) {
+        if (slideNumber + step + i <= slideCount[currentPart]) {
+            [self prefetchSlide:slideNumber + step + i withBaseName:baseFileName priority:kDecodeNextUp];
         }
-    } else {
-        slideLayerA.contents = (id)slideImage.CGImage;
-        if (annotationsDirectory != nil) {
-            annotationLayer.contents = (id)[UIImage imageWithContentsOfFile:annotationsFileName].CGImage;
+    }
+    for (int i = 0; i < step; i++) {
+        if (slideNumber - step + i >= 1) {
+            [self prefetchSlide:slideNumber - step + i withBaseName:baseFileName priority:kDecodeSpeculative];
         }
     }
-    [CATransaction commit];
     
     [canvas addSublayer:slideLayerA];
     if (splitMode) {
@@ -150,6 +155,37 @@
     }
 }
 
+- (NSString *)fileNameForSlide:(int)slideNumber withBaseName:(NSString *)baseFileName
+{
+    //Try for a png file first, otherwise we've got a jpg.
+    NSString *fileName = [baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.png" , slideNumber]];
+    if (![ScoreArchive fileExistsAtPath:fileName]) {
+        fileName = [baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.jpg" , slideNumber]];
+    }
+    return fileName;
+}
+
+- (void)loadImage:(NSString *)fileName intoLayer:(CALayer *)layer useCache:(BOOL)useCache
+{
+    DecodeRequest *request = [[DecodeService sharedService] decodeImage:fileName priority:kDecodeVisible useCache:useCache completion:^(UIImage *image) {
+        [CATransaction begin];
+        [CATransaction setDisableActions:YES];
+        layer.contents = (id)image.CGImage;
+        [CATransaction commit];
+    }];
+    if (request != nil) {
+        [slideRequests addObject:request];
+    }
+}
+
+- (void)prefetchSlide:(int)slideNumber withBaseName:(NSString *)baseFileName priority:(DecodePriority)priority
+{
+    DecodeRequest *request = [[DecodeService sharedService] decodeImage:[self fileNameForSlide:slideNumber withBaseName:baseFileName] priority:priority useCache:YES completion:^(UIImage *image) {}];
+    if (request != nil) {
+        [prefetchRequests addObject:request];
+    }
+}
+
 - (void)changePart:(NSInteger)relativeChange
 {
     NSInteger newPart = currentPart + relativeChange;
@@ -310,16 +346,15 @@
     }
     slideCount[0] = 1;
     NSString *baseFileName = [score.scorePath stringByAppendingPathComponent:[score.fileName stringByDeletingPathExtension]];
-    NSFileManager *fileManager = [NSFileManager defaultManager];
     
-    while ([fileManager fileExistsAtPath:[baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.png" , (int)slideCount[0] + 1]]] || [fileManager fileExistsAtPath:[baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.jpg" , (int)slideCount[0] + 1]]]) {
+    while ([ScoreArchive fileExistsAtPath:[baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.png" , (int)slideCount[0] + 1]]] || [ScoreArchive fileExistsAtPath:[baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.jpg" , (int)slideCount[0] + 1]]]) {
         slideCount[0]++;
     }
     //Do the same thing for any parts we might have.
     for (int i = 0; i < [score.parts count]; i++) {
         slideCount[i + 1] = 0;
         baseFileName = [score.scorePath stringByAppendingPathComponent:[[score.parts objectAtIndex:i] stringByDeletingPathExtension]];
-        while ([fileManager fileExistsAtPath:[baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.png" , (int)slideCount[i + 1] + 1]]] || [fileManager fileExistsAtPath:[baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.jpg" , (int)slideCount[i + 1] + 1]]]) {
+        while ([ScoreArchive fileExistsAtPath:[baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.png" , (int)slideCount[i + 1] + 1]]] || [ScoreArchive fileExistsAtPath:[baseFileName stringByReplacingOccurrencesOfString:@"_1" withString:[NSString stringWithFormat:@"_%i.jpg" , (int)slideCount[i + 1] + 1]]]) {
             slideCount[i + 1]++;
         }
     }
@@ -337,7 +372,7 @@
         changes = [[NSMutableArray alloc] init];
         currentChanges = changes;
         NSString *prefsFile = [score.scorePath stringByAppendingPathComponent:score.prefsFile];
-        NSData *prefsData = [[NSData alloc] initWithContentsOfFile:prefsFile];
+        NSData *prefsData = [ScoreArchive dataWithContentsOfFile:prefsFile];
         xmlParser = [[NSXMLParser alloc] initWithData:prefsData];
         
         isData = NO;
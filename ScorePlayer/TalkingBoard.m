@@ -10,6 +10,7 @@
 #import "TalkingBoard.h"
 #import "Score.h"
 #import "OSCMessage.h"
+#import "ScoreArchive.h"
 
 const NSInteger BACKGROUNDS_PER_MESSAGE = 50;
 const NSInteger PLANCHETTES_PER_MESSAGE = 100;
@@ -671,7 +672,7 @@ const NSInteger HEADER_LENGTH = 7;
 
 + (UIImage *)generateThumbnailForScore:(Score *)score ofSize:(CGSize)size
 {
-    UIImage *image = [UIImage imageWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.fileName]];
+    UIImage *image = [ScoreArchive imageWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.fileName]];
     if (image.size.width < 2048 && image.size.height < 1536) {
         return [Renderer defaultThumbnail:[score.scorePath stringByAppendingPathComponent:score.fileName] ofSize:size];
     } else {
@@ -722,7 +723,7 @@ const NSInteger HEADER_LENGTH = 7;
     generationLock = [[NSLock alloc] init];
     
     if (score.prefsFile != nil) {
-        NSData *prefsData = [[NSData alloc] initWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
+        NSData *prefsData = [ScoreArchive dataWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
         xmlParser = [[NSXMLParser alloc] initWithData:prefsData];
         isData = NO;
         xmlParser.delegate = self;
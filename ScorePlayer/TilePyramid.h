@@ -0,0 +1,32 @@
+//
+//  TilePyramid.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+//Pre-scaled copies of score images at a half and a quarter of their original size, so that a
+//score drawn on a small canvas can load an image close to the size it is displayed at instead
+//of decoding the full resolution image and having it scaled down. The levels are kept in a
+//hidden directory alongside the images, with an index recording which images have them.
+
+static const NSInteger TILE_PYRAMID_LEVELS = 2;
+
+@interface TilePyramid : NSObject
+
+//Returns the smallest stored version of the image that is still at least the given scale
+//(in pixels drawn per original pixel), or the original file if there isn't one.
++ (NSString *)pathForImage:(NSString *)fileName atScale:(CGFloat)scale;
++ (BOOL)hasLevelsForImage:(NSString *)fileName;
+
+//Builds any missing or out of date levels for the image. Returns NO if it couldn't be read or
+//the levels couldn't be written.
++ (BOOL)buildLevelsForImage:(NSString *)fileName;
+//Builds levels one image at a time on a low priority background queue.
++ (void)buildLevelsInBackgroundForImages:(NSArray *)fileNames;
+
+@end
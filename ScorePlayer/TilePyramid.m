@@ -0,0 +1,245 @@
+//
+//  TilePyramid.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "TilePyramid.h"
+#import <ImageIO/ImageIO.h>
+#import "ImageDownscale.h"
+#import "ScoreArchive.h"
+
+static NSString *const PYRAMID_DIRECTORY = @".pyramid";
+static NSString *const PYRAMID_INDEX = @"index.plist";
+
+static NSMutableDictionary *indexes;
+static NSLock *indexLock;
+
+@interface TilePyramid ()
+
++ (void)initIndexes;
++ (NSMutableDictionary *)indexForDirectory:(NSString *)directory;
++ (NSString *)pathForLevel:(NSInteger)level ofImage:(NSString *)fileName;
++ (BOOL)writeImage:(CGImageRef)image toPath:(NSString *)path type:(CFStringRef)type;
+
+@end
+
+@implementation TilePyramid
+
++ (void)initIndexes
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        indexes = [[NSMutableDictionary alloc] init];
+        indexLock = [[NSLock alloc] init];
+    });
+}
+
++ (NSMutableDictionary *)indexForDirectory:(NSString *)directory
+{
+    //Must be called with the index lock held. Indexes are read from disk once and kept.
+    NSMutableDictionary *index = [indexes objectForKey:directory];
+    if (index == nil) {
+        index = [NSMutableDictionary dictionaryWithContentsOfFile:[[directory stringByAppendingPathComponent:PYRAMID_DIRECTORY] stringByAppendingPathComponent:PYRAMID_INDEX]];
+        if (index == nil) {
+            index = [[NSMutableDictionary alloc] init];
+        }
+        [indexes setObject:index forKey:directory];
+    }
+    return index;
+}
+
++ (NSString *)pathForLevel:(NSInteger)level ofImage:(NSString *)fileName
+{
+    //Each level is stored under the factor it has been reduced by. (.pyramid/2, .pyramid/4)
+    NSString *levelDirectory = [[[fileName stringByDeletingLastPathComponent] stringByAppendingPathComponent:PYRAMID_DIRECTORY] stringByAppendingPathComponent:[NSString stringWithFormat:@"%i", 1 << (int)level]];
+    return [levelDirectory stringByAppendingPathComponent:[fileName lastPathComponent]];
+}
+
++ (NSString *)pathForImage:(NSString *)fileName atScale:(CGFloat)scale
+{
+    if (fileName == nil) {
+        return nil;
+    }
+    
+    [self initIndexes];
+    [indexLock lock];
+    NSDictionary *entry = [[self indexForDirectory:[fileName stringByDeletingLastPathComponent]] objectForKey:[fileName lastPathComponent]];
+    NSInteger levels = [[entry objectForKey:@"levels"] integerValue];
+    [indexLock unlock];
+    
+    //Work up from the smallest level to the first one that's big enough. (Check that it's still
+    //there in case the score has been replaced since we read the index.)
+    for (NSInteger level = levels; level > 0; level--) {
+        if (scale <= 1.0 / (1 << level)) {
+            NSString *levelPath = [self pathForLevel:level ofImage:fileName];
+            if ([[NSFileManager defaultManager] fileExistsAtPath:levelPath]) {
+                return levelPath;
+            }
+            break;
+        }
+    }
+    return fileName;
+}
+
++ (BOOL)hasLevelsForImage:(NSString *)fileName
+{
+    NSDictionary *attributes = [ScoreArchive attributesOfItemAtPath:fileName];
+    if (attributes == nil) {
+        return NO;
+    }
+    
+    [self initIndexes];
+    [indexLock lock];
+    NSDictionary *entry = [[self indexForDirectory:[fileName stringByDeletingLastPathComponent]] objectForKey:[fileName lastPathComponent]];
+    [indexLock unlock];
+    
+    //Levels built from an older version of the image don't count.
+    return [[entry objectForKey:@"levels"] integerValue] == TILE_PYRAMID_LEVELS && [[entry objectForKey:@"size"] isEqual:[attributes objectForKey:NSFileSize]] && [[entry objectForKey:@"modified"] isEqual:[attributes objectForKey:NSFileModificationDate]];
+}
+
++ (BOOL)buildLevelsForImage:(NSString *)fileName
+{
+    if ([self hasLevelsForImage:fileName]) {
+        return YES;
+    }
+    NSDictionary *attributes = [ScoreArchive attributesOfItemAtPath:fileName];
+    if (attributes == nil) {
+        return NO;
+    }
+    
+    //The levels of an image in a mounted score archive go in the score directory on disk.
+    NSData *archivedData = [ScoreArchive archivedDataForFile:fileName];
+    CGImageSourceRef source;
+    if (archivedData != nil) {
+        source = CGImageSourceCreateWithData((__bridge CFDataRef)archivedData, NULL);
+    } else {
+        source = CGImageSourceCreateWithURL((__bridge CFURLRef)[NSURL fileURLWithPath:fileName], NULL);
+    }
+    if (source == NULL) {
+        return NO;
+    }
+    CGImageRef image = CGImageSourceCreateImageAtIndex(source, 0, NULL);
+    if (image == NULL) {
+        CFRelease(source);
+        return NO;
+    }
+    
+    //Draw the original into a bitmap that we can halve repeatedly.
+    size_t width = CGImageGetWidth(image);
+    size_t height = CGImageGetHeight(image);
+    size_t rowBytes = width * IMAGE_DOWNSCALE_BYTES_PER_PIXEL;
+    uint8_t *pixels = malloc(rowBytes * height);
+    CGColorSpaceRef colourSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = NULL;
+    if (pixels != NULL) {
+        context = CGBitmapContextCreate(pixels, width, height, 8, rowBytes, colourSpace, kCGImageAlphaPremultipliedLast);
+    }
+    if (context == NULL) {
+        free(pixels);
+        CGColorSpaceRelease(colourSpace);
+        CGImageRelease(image);
+        CFRelease(source);
+        return NO;
+    }
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    CGContextRelease(context);
+    CGImageRelease(image);
+    
+    BOOL success = YES;
+    for (NSInteger level = 1; level <= TILE_PYRAMID_LEVELS && success; level++) {
+        size_t levelWidth = ImageDownscaleHalfSize(width);
+        size_t levelHeight = ImageDownscaleHalfSize(height);
+        size_t levelRowBytes = levelWidth * IMAGE_DOWNSCALE_BYTES_PER_PIXEL;
+        uint8_t *levelPixels = malloc(levelRowBytes * levelHeight);
+        if (levelPixels == NULL) {
+            success = NO;
+            break;
+        }
+        ImageDownscaleHalve(pixels, width, height, rowBytes, levelPixels, levelRowBytes);
+        free(pixels);
+        pixels = levelPixels;
+        width = levelWidth;
+        height = levelHeight;
+        rowBytes = levelRowBytes;
+        
+        //Save each level in the same format as the original.
+        context = CGBitmapContextCreate(pixels, width, height, 8, rowBytes, colourSpace, kCGImageAlphaPremultipliedLast);
+        CGImageRef levelImage = CGBitmapContextCreateImage(context);
+        CGContextRelease(context);
+        success = levelImage != NULL && [self writeImage:levelImage toPath:[self pathForLevel:level ofImage:fileName] type:CGImageSourceGetType(source)];
+        CGImageRelease(levelImage);
+    }
+    free(pixels);
+    CGColorSpaceRelease(colourSpace);
+    CFRelease(source);
+    
+    if (!success) {
+        return NO;
+    }
+    
+    //Record the new levels along with the details of the file that they were made from.
+    NSString *directory = [fileName stringByDeletingLastPathComponent];
+    NSMutableDictionary *entry = [[NSMutableDictionary alloc] init];
+    [entry setObject:[NSNumber numberWithInteger:TILE_PYRAMID_LEVELS] forKey:@"levels"];
+    [entry setObject:[attributes objectForKey:NSFileSize] forKey:@"size"];
+    [entry setObject:[attributes objectForKey:NSFileModificationDate] forKey:@"modified"];
+    
+    [self initIndexes];
+    [indexLock lock];
+    NSMutableDictionary *index = [self indexForDirectory:directory];
+    [index setObject:entry forKey:[fileName lastPathComponent]];
+    success = [index writeToFile:[[directory stringByAppendingPathComponent:PYRAMID_DIRECTORY] stringByAppendingPathComponent:PYRAMID_INDEX] atomically:YES];
+    [indexLock unlock];
+    
+    return success;
+}
+
++ (void)buildLevelsInBackgroundForImages:(NSArray *)fileNames
+{
+    static dispatch_queue_t buildQueue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        buildQueue = dispatch_queue_create("com.decibel.tilepyramid", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_BACKGROUND, 0));
+    });
+    
+    NSArray *images = [fileNames copy];
+    dispatch_async(buildQueue, ^{
+        for (int i = 0; i < [images count]; i++) {
+            @autoreleasepool {
+                [self buildLevelsForImage:[images objectAtIndex:i]];
+            }
+        }
+    });
+}
+
++ (BOOL)writeImage:(CGImageRef)image toPath:(NSString *)path type:(CFStringRef)type
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    if (![fileManager createDirectoryAtPath:[path stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil]) {
+        return NO;
+    }
+    
+    //Write to a temporary file first so that a half written level is never picked up.
+    NSString *temporaryPath = [path stringByAppendingPathExtension:@"tmp"];
+    CGImageDestinationRef destination = CGImageDestinationCreateWithURL((__bridge CFURLRef)[NSURL fileURLWithPath:temporaryPath], type, 1, NULL);
+    if (destination == NULL) {
+        return NO;
+    }
+    CGImageDestinationAddImage(destination, image, NULL);
+    BOOL success = CGImageDestinationFinalize(destination);
+    CFRelease(destination);
+    
+    if (success) {
+        [fileManager removeItemAtPath:path error:nil];
+        success = [fileManager moveItemAtPath:temporaryPath toPath:path error:nil];
+    }
+    if (!success) {
+        [fileManager removeItemAtPath:temporaryPath error:nil];
+    }
+    return success;
+}
+
+@end
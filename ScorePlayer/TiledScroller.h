@@ -9,6 +9,9 @@
 #import <Foundation/Foundation.h>
 #import "ScrollScore.h"
 
+//How far ahead (in seconds of scrolling) to prefetch tiles in the direction of travel.
+static const NSTimeInterval TILE_PREFETCH_LOOKAHEAD = 3;
+
 @interface TiledScroller : NSObject <ScrollerDelegate> {
     CGFloat height;
     CGFloat width;
@@ -19,7 +22,8 @@
     NSString *annotationsDirectory;
     CGSize canvasSize;
     ScrollOrientation orientation;
-    
+    CGFloat scrollVelocity;
+    NSInteger missedDeadlines;
 }
 
 @property (nonatomic) CGFloat height;
@@ -32,5 +36,8 @@
 @property (nonatomic) NSString *annotationsDirectory;
 @property (nonatomic) CGSize canvasSize;
 @property (nonatomic) ScrollOrientation orientation;
+@property (nonatomic) CGFloat scrollVelocity;
+//The number of tiles that were still queued when they came on screen and had to be loaded on the main thread.
+@property (nonatomic, readonly) NSInteger missedDeadlines;
 
 @end
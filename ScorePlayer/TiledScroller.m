@@ -9,11 +9,23 @@
 #import "TiledScroller.h"
 #import <QuartzCore/QuartzCore.h>
 #import "Renderer.h"
+#import "DecodeService.h"
+#import "TilePyramid.h"
+
+typedef enum {
+    kTileEmpty = 0,
+    kTileRequested = 1,
+    kTileLoaded = 2
+} TileState;
 
 @interface TiledScroller()
 
 - (void)loadNeededTilesWithLargeChange:(BOOL)largeChange;
-- (void)loadImage:(NSString *)imageName intoLayer:(CALayer *)layer inBackground:(BOOL)backgrounded;
+- (void)requestTile:(int)tile priority:(DecodePriority)priority;
+- (void)cancelRequestForTile:(int)tile;
+- (void)cancelTileRequests;
+- (CGFloat)viewportWidth;
+- (void)selectImagesForScale:(CGFloat)scale;
 - (NSRange)neededTilesForAnnotationOfWidth:(CGFloat)width;
 
 @end
@@ -22,7 +34,13 @@
     NSMutableArray *tileArray;
     NSMutableArray *annotationTileArray;
     CALayer *annotationLayer;
-    BOOL *tileLoaded;
+    TileState *tileState;
+    NSInteger *tileRequest;
+    NSInteger *tilePending;
+    DecodePriority *tilePriority;
+    NSMutableArray *decodeRequests;
+    NSInteger requestCounter;
+    NSRange prefetchRange;
     
     NSMutableDictionary *originalSize;
     
@@ -30,6 +48,9 @@
     int currentTile;
     NSString *currentImageName;
     NSString *annotationImageName;
+    NSArray *sourceTilePaths;
+    NSArray *tilePaths;
+    NSArray *annotationTilePaths;
     NSInteger buffer;
     
     CGFloat scoreWidth;
@@ -38,7 +59,7 @@
     BOOL debug;
 }
 
-@synthesize width, numberOfTiles, background, loadOccurred, annotationsDirectory, canvasSize, orientation;
+@synthesize width, numberOfTiles, background, loadOccurred, annotationsDirectory, canvasSize, orientation, scrollVelocity, missedDeadlines;
 
 - (void)loadNeededTilesWithLargeChange:(BOOL)largeChange
 {
@@ -47,79 +68,185 @@
         return;
     }
     
-    //Load the current tile if it hasn't loaded for some reason.
-    //(For example, the user has scrolled too quickly through the score).
-    if (!tileLoaded[currentTile]) {
-        tileLoaded[currentTile] = YES;
-        [self loadImage:[currentImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", currentTile + 1]] intoLayer:[tileArray objectAtIndex:currentTile] inBackground:NO];
-        [self loadImage:[annotationImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", currentTile + 1]] intoLayer:[annotationTileArray objectAtIndex:currentTile] inBackground:NO];
-    }
+    //Work out which part of the score is on screen. (Our x coordinate is the negative of the
+    //visible offset into the score.)
+    CGFloat visibleStart = -background.position.x;
+    CGFloat visibleEnd = visibleStart + [self viewportWidth];
     
-    //Load (or clear) the tiles in the back buffer.
-    int bufferLength = abs((int)background.position.x) % (int)tileWidth;
-    for (int i = currentTile - 1; i >= 0; i--) {
-        if (bufferLength > buffer) {
-            ((CALayer *)[tileArray objectAtIndex:i]).contents = nil;
-            ((CALayer *)[annotationTileArray objectAtIndex:i]).contents = nil;
-            tileLoaded[i] = NO;
-        } else if (!tileLoaded[i]) {
-            tileLoaded[i] = YES;
-            //If we've had a seek, load in the foreground, otherwise load in the background to try
-            //to minize any discruption to the speed of playback.
-            [self loadImage:[currentImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i + 1]] intoLayer:[tileArray objectAtIndex:i] inBackground:!largeChange];
-            [self loadImage:[annotationImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i + 1]] intoLayer:[annotationTileArray objectAtIndex:i] inBackground:!largeChange];
+    //Extend the buffer in the direction of travel by however far we'll scroll in the lookahead time.
+    //A negative velocity means the score is moving left, so upcoming tiles are to the right.
+    CGFloat lookahead = fabs(scrollVelocity) * TILE_PREFETCH_LOOKAHEAD;
+    CGFloat keepStart = visibleStart - buffer - (scrollVelocity > 0 ? lookahead : 0);
+    CGFloat keepEnd = visibleEnd + buffer + (scrollVelocity < 0 ? lookahead : 0);
+    
+    NSMutableArray *requests = [[NSMutableArray alloc] init];
+    for (int i = 0; i < numberOfTiles; i++) {
+        CGFloat tileStart = i * tileWidth;
+        CGFloat tileEnd = tileStart + tileWidth;
+        
+        if ((tileEnd <= keepStart || tileStart >= keepEnd) && !NSLocationInRange(i, prefetchRange)) {
+            //Clear the tile, cancelling it if it's still queued.
+            if (tileState[i] != kTileEmpty) {
+                [self cancelRequestForTile:i];
+                ((CALayer *)[tileArray objectAtIndex:i]).contents = nil;
+                ((CALayer *)[annotationTileArray objectAtIndex:i]).contents = nil;
+                tileState[i] = kTileEmpty;
+            }
+            continue;
+        }
+        
+        if (tileState[i] == kTileLoaded) {
+            continue;
+        }
+        
+        if (tileEnd > visibleStart && tileStart < visibleEnd) {
+            //The tile is on screen and hasn't arrived yet. (For example, the user has scrolled too
+            //quickly through the score, or we've had a seek.) Move it to the front of the queue.
+            if (tileState[i] == kTileEmpty) {
+                [self requestTile:i priority:kDecodeVisible];
+            } else if (tilePriority[i] != kDecodeVisible) {
+                missedDeadlines++;
+                tilePriority[i] = kDecodeVisible;
+                for (DecodeRequest *request in [decodeRequests objectAtIndex:i]) {
+                    [[DecodeService sharedService] changePriority:kDecodeVisible ofRequest:request];
+                }
+            }
+        } else if (tileState[i] == kTileEmpty) {
+            //Order the background loads by how soon each tile will come on screen. Tiles that
+            //we're moving away from (or all of them if we're stationary) go after that, nearest first.
+            CGFloat distance = tileStart >= visibleEnd ? tileStart - visibleEnd : visibleStart - tileEnd;
+            BOOL approaching = (tileStart >= visibleEnd && scrollVelocity < 0) || (tileEnd <= visibleStart && scrollVelocity > 0);
+            NSTimeInterval deadline = approaching ? distance / fabs(scrollVelocity) : DBL_MAX;
+            NSMutableArray *request = [[NSMutableArray alloc] init];
+            [request addObject:[NSNumber numberWithDouble:deadline]];
+            [request addObject:[NSNumber numberWithDouble:distance]];
+            [request addObject:[NSNumber numberWithInt:i]];
+            [requests addObject:request];
         }
-        bufferLength += tileWidth;
     }
     
-    //Load the tiles in the forward buffer.
-    bufferLength = background.position.x + ((currentTile + 1) * tileWidth) - 1024;
-    for (int i = currentTile + 1; i < numberOfTiles; i ++) {
-        if (bufferLength > buffer) {
-            ((CALayer *)[tileArray objectAtIndex:i]).contents = nil;
-            ((CALayer *)[annotationTileArray objectAtIndex:i]).contents = nil;
-            tileLoaded[i] = NO;
-        } else if (!tileLoaded[i]) {
-            tileLoaded[i] = YES;
-            [self loadImage:[currentImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i + 1]] intoLayer:[tileArray objectAtIndex:i] inBackground:!largeChange];
-            [self loadImage:[annotationImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i + 1]] intoLayer:[annotationTileArray objectAtIndex:i] inBackground:!largeChange];
+    if (largeChange) {
+        //Anything we prefetched for a fragment jump is now either on screen or in the buffer.
+        prefetchRange = NSMakeRange(0, 0);
+    }
+    
+    [requests sortUsingComparator:^NSComparisonResult(NSArray *first, NSArray *second) {
+        NSComparisonResult result = [[first objectAtIndex:0] compare:[second objectAtIndex:0]];
+        if (result == NSOrderedSame) {
+            result = [[first objectAtIndex:1] compare:[second objectAtIndex:1]];
         }
-        bufferLength += tileWidth;
+        return result;
+    }];
+    for (int i = 0; i < [requests count]; i++) {
+        //Anything due within our lookahead time is next up, the rest is speculative.
+        DecodePriority priority = [[[requests objectAtIndex:i] objectAtIndex:0] doubleValue] <= TILE_PREFETCH_LOOKAHEAD ? kDecodeNextUp : kDecodeSpeculative;
+        [self requestTile:[[[requests objectAtIndex:i] objectAtIndex:2] intValue] priority:priority];
     }
 }
 
-- (void)loadImage:(NSString *)imageName intoLayer:(CALayer *)layer inBackground:(BOOL)backgrounded
+- (void)requestTile:(int)tile priority:(DecodePriority)priority
 {
-    if (backgrounded) {
-        //Load the image from disk in the background.
-        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
-            UIImage *image = [UIImage imageWithContentsOfFile:imageName];
-            
-            //Draw the image into a trivial (1x1) graphics context to make the load actually happen
-            //(TODO: This may not be needed any more need to carry out additional tests.)
-            UIGraphicsBeginImageContext(CGSizeMake(1,1));
-            CGContextRef context = UIGraphicsGetCurrentContext();
-            CGContextDrawImage(context, CGRectMake(0, 0, 1, 1), [image CGImage]);
-            UIGraphicsEndImageContext();
-            
-            dispatch_async(dispatch_get_main_queue(), ^{
-                //[self->background removeAllAnimations];
-                //[CATransaction begin];
-                //[CATransaction setDisableActions:YES];
-                layer.contents = (id)image.CGImage;
-                self->loadOccurred = YES;
-                //NSLog(@"bam!");
-                //[CATransaction commit];
-            });
-        });
-    } else {
-        [background removeAllAnimations];
-        [CATransaction begin];
-        [CATransaction setDisableActions:YES];
-        UIImage *image = [UIImage imageWithContentsOfFile:imageName];
-        layer.contents = (id)image.CGImage;
-        loadOccurred = YES;
-        [CATransaction commit];
+    //Within a lane, the decode service works through requests in the order they're made, so the
+    //caller should make them in order of urgency. Each request carries a token so that any result
+    //that arrives after the tile has been cleared or re-requested is ignored.
+    tileState[tile] = kTileRequested;
+    tilePriority[tile] = priority;
+    NSInteger token = ++requestCounter;
+    tileRequest[tile] = token;
+    
+    NSMutableArray *paths = [NSMutableArray arrayWithObject:[tilePaths objectAtIndex:tile]];
+    NSMutableArray *layers = [NSMutableArray arrayWithObject:[tileArray objectAtIndex:tile]];
+    if ([[annotationTilePaths objectAtIndex:tile] length] > 0) {
+        [paths addObject:[annotationTilePaths objectAtIndex:tile]];
+        [layers addObject:[annotationTileArray objectAtIndex:tile]];
+    }
+    tilePending[tile] = [paths count];
+    
+    NSMutableArray *requests = [[NSMutableArray alloc] init];
+    for (int i = 0; i < [paths count]; i++) {
+        CALayer *layer = [layers objectAtIndex:i];
+        DecodeRequest *request = [[DecodeService sharedService] decodeImage:[paths objectAtIndex:i] priority:priority useCache:NO completion:^(UIImage *image) {
+            if (self->tileRequest[tile] != token) {
+                return;
+            }
+            layer.contents = (id)image.CGImage;
+            self->loadOccurred = YES;
+            self->tilePending[tile]--;
+            if (self->tilePending[tile] == 0) {
+                self->tileState[tile] = kTileLoaded;
+                self->tileRequest[tile] = 0;
+                [self->decodeRequests replaceObjectAtIndex:tile withObject:[NSNull null]];
+            }
+        }];
+        [requests addObject:request];
+    }
+    [decodeRequests replaceObjectAtIndex:tile withObject:requests];
+}
+
+- (void)cancelRequestForTile:(int)tile
+{
+    id requests = [decodeRequests objectAtIndex:tile];
+    if (requests != [NSNull null]) {
+        for (DecodeRequest *request in requests) {
+            [request cancel];
+        }
+        [decodeRequests replaceObjectAtIndex:tile withObject:[NSNull null]];
+    }
+    tileRequest[tile] = 0;
+}
+
+- (void)cancelTileRequests
+{
+    //Leave anything we're prefetching for an upcoming jump alone.
+    for (int i = 0; i < numberOfTiles; i++) {
+        if (tileState[i] == kTileRequested && !NSLocationInRange(i, prefetchRange)) {
+            [self cancelRequestForTile:i];
+            tileState[i] = kTileEmpty;
+        }
+    }
+}
+
+- (CGFloat)viewportWidth
+{
+    //Fall back to the old hard coded screen width if we haven't been told the size of our canvas.
+    return canvasSize.width > 0 ? canvasSize.width : 1024;
+}
+
+- (void)selectImagesForScale:(CGFloat)scale
+{
+    //If the score is being drawn at half its original size or less, load pre-scaled tiles
+    //where we have them. If we don't, build them in the background for next time.
+    NSMutableArray *paths = [[NSMutableArray alloc] init];
+    BOOL missingLevels = NO;
+    for (int i = 0; i < numberOfTiles; i++) {
+        NSString *sourcePath = [sourceTilePaths objectAtIndex:i];
+        NSString *path = [TilePyramid pathForImage:sourcePath atScale:scale];
+        if (scale <= 0.5 && path == sourcePath) {
+            missingLevels = YES;
+        }
+        [paths addObject:path];
+    }
+    if (missingLevels) {
+        [TilePyramid buildLevelsInBackgroundForImages:sourceTilePaths];
+    }
+    
+    if ([paths isEqualToArray:tilePaths]) {
+        return;
+    }
+    tilePaths = paths;
+    
+    //Reload everything from the new images. Tiles that are on screen keep showing the old
+    //ones until they're replaced.
+    CGFloat visibleStart = -background.position.x;
+    CGFloat visibleEnd = visibleStart + [self viewportWidth];
+    prefetchRange = NSMakeRange(0, 0);
+    for (int i = 0; i < numberOfTiles; i++) {
+        [self cancelRequestForTile:i];
+        if (i * tileWidth >= visibleEnd || (i + 1) * tileWidth <= visibleStart) {
+            ((CALayer *)[tileArray objectAtIndex:i]).contents = nil;
+            ((CALayer *)[annotationTileArray objectAtIndex:i]).contents = nil;
+        }
+        tileState[i] = kTileEmpty;
     }
 }
 
@@ -142,7 +269,13 @@
 
 - (void)dealloc
 {
-    free(tileLoaded);
+    for (int i = 0; i < numberOfTiles; i++) {
+        [self cancelRequestForTile:i];
+    }
+    free(tileState);
+    free(tileRequest);
+    free(tilePending);
+    free(tilePriority);
 }
 
 #pragma mark - Scroller delegate
@@ -170,8 +303,19 @@
     }
     
     numberOfTiles = tiles;
-    tileLoaded = malloc(sizeof(BOOL) * numberOfTiles);
+    tileState = calloc(numberOfTiles, sizeof(TileState));
+    tileRequest = calloc(numberOfTiles, sizeof(NSInteger));
+    tilePending = calloc(numberOfTiles, sizeof(NSInteger));
+    tilePriority = calloc(numberOfTiles, sizeof(DecodePriority));
+    decodeRequests = [[NSMutableArray alloc] initWithCapacity:numberOfTiles];
+    for (int i = 0; i < numberOfTiles; i++) {
+        [decodeRequests addObject:[NSNull null]];
+    }
+    requestCounter = 0;
+    prefetchRange = NSMakeRange(0, 0);
     loadOccurred = NO;
+    scrollVelocity = 0;
+    missedDeadlines = 0;
     
     //Set up the necessary layers. At this stage we don't load the image (this is done with changePart).
     //Because of this we'll use placeholder dimensions.
@@ -253,6 +397,8 @@
     }
     
     if (numberOfTiles > 1) {
+        CGFloat scale = newHeight * [UIScreen mainScreen].scale / ([[originalSize objectForKey:currentImageName] CGSizeValue]).height;
+        [self selectImagesForScale:scale];
         [self loadNeededTilesWithLargeChange:YES];
     }
 }
@@ -290,6 +436,42 @@
     return background.position.x;
 }
 
+- (void)setScrollVelocity:(CGFloat)velocity
+{
+    if (velocity == scrollVelocity) {
+        return;
+    }
+    scrollVelocity = velocity;
+    if (numberOfTiles > 1 && tileWidth > 0) {
+        //Reprioritise the outstanding loads for our new direction and speed.
+        [self cancelTileRequests];
+        [self loadNeededTilesWithLargeChange:NO];
+    }
+}
+
+- (void)prefetchForX:(CGFloat)x
+{
+    //Start loading the tiles that will be on screen after an upcoming jump, ahead of
+    //anything that's only needed for the current position's buffer. These are kept
+    //until the jump happens.
+    if (numberOfTiles == 1 || tileWidth <= 0) {
+        return;
+    }
+    
+    NSInteger startTile = MAX(-x / tileWidth, 0);
+    NSInteger endTile = MIN(([self viewportWidth] - x) / tileWidth, numberOfTiles - 1);
+    if (endTile < startTile) {
+        return;
+    }
+    prefetchRange = NSMakeRange(startTile, 1 + endTile - startTile);
+    
+    for (NSInteger i = startTile; i <= endTile; i++) {
+        if (tileState[i] == kTileEmpty) {
+            [self requestTile:(int)i priority:kDecodeNextUp];
+        }
+    }
+}
+
 - (void)setY:(CGFloat)y
 {
     background.position = CGPointMake(background.position.x, y);
@@ -327,19 +509,42 @@
     annotationImageName = [[currentImageName lastPathComponent] stringByDeletingPathExtension];
     annotationImageName = [[annotationsDirectory stringByAppendingPathComponent:annotationImageName] stringByAppendingPathExtension:@"png"];
     
+    //Work out the file names of all of our tiles once, rather than every time one is loaded.
+    //(If we don't have an annotations directory, use empty names for the annotation tiles.)
+    NSMutableArray *paths = [[NSMutableArray alloc] init];
+    NSMutableArray *annotationPaths = [[NSMutableArray alloc] init];
+    for (int i = 0; i < numberOfTiles; i++) {
+        if (numberOfTiles == 1) {
+            [paths addObject:currentImageName];
+            [annotationPaths addObject:annotationImageName != nil ? annotationImageName : @""];
+        } else {
+            [paths addObject:[currentImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i + 1]]];
+            if (annotationImageName != nil) {
+                [annotationPaths addObject:[annotationImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", i + 1]]];
+            } else {
+                [annotationPaths addObject:@""];
+            }
+        }
+    }
+    sourceTilePaths = paths;
+    tilePaths = paths;
+    annotationTilePaths = annotationPaths;
+    
+    //Anything still in the queue belongs to the old part.
+    prefetchRange = NSMakeRange(0, 0);
+    [self cancelTileRequests];
     for (int i = 0; i < numberOfTiles; i++) {
         ((CALayer *)[tileArray objectAtIndex:i]).contents = nil;
-        tileLoaded[i] = NO;
+        tileState[i] = kTileEmpty;
     }
     
     UIImage *image, *annotationImage;
     if (numberOfTiles == 1) {
         image = [Renderer cachedImage:currentImageName];
-        annotationImage = [UIImage imageWithContentsOfFile:annotationImageName];
     } else {
-        image = [UIImage imageWithContentsOfFile:[currentImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", currentTile + 1]]];
-        annotationImage = [UIImage imageWithContentsOfFile:[annotationImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", currentTile + 1]]];
+        image = [DecodeService decodedImageWithContentsOfFile:[tilePaths objectAtIndex:currentTile]];
     }
+    annotationImage = [DecodeService decodedImageWithContentsOfFile:[annotationTilePaths objectAtIndex:currentTile]];
     
     //Update the necessary properties and store the original size for later use.
     width = image.size.width * numberOfTiles;
@@ -367,7 +572,7 @@
     //(The player will assume that it needs to resynch if it is calling this method in the first place.)
     ((CALayer *)[tileArray objectAtIndex:currentTile]).contents = (id)image.CGImage;
     ((CALayer *)[annotationTileArray objectAtIndex:currentTile]).contents = (id)annotationImage.CGImage;
-    tileLoaded[currentTile] = YES;
+    tileState[currentTile] = kTileLoaded;
     
     //Resize the layers to match the image size.
     background.bounds = CGRectMake(0, 0, width, height);
@@ -417,12 +622,7 @@
     CGContextSetShouldAntialias(currentContext, NO);
     for (NSInteger i = tileRange.location; i < tileRange.location + tileRange.length; i++) {
         CGFloat startOffset = background.position.x + (tileWidth * i);
-        UIImage *currentImage;
-        if (numberOfTiles > 1) {
-            currentImage = [UIImage imageWithContentsOfFile:[annotationImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", (int)i + 1]]];
-        } else {
-            currentImage = [UIImage imageWithContentsOfFile:annotationImageName];
-        }
+        UIImage *currentImage = [UIImage imageWithContentsOfFile:[annotationTilePaths objectAtIndex:i]];
 
         if (currentImage != nil) {
             [currentImage drawInRect:CGRectMake(startOffset, yOffset, roundf(currentImage.size.width * imageScale), roundf(currentImage.size.height * imageScale))];
@@ -506,12 +706,7 @@
         CGContextRef currentContext = UIGraphicsGetCurrentContext();
         CGContextSetInterpolationQuality(currentContext, kCGInterpolationHigh);
         CGContextSetShouldAntialias(currentContext, NO);
-        NSString *imageName;
-        if (numberOfTiles > 1) {
-            imageName = [annotationImageName stringByReplacingOccurrencesOfString:@"_1." withString:[NSString stringWithFormat:@"_%i.", (int)i + 1]];
-        } else {
-            imageName = annotationImageName;
-        }
+        NSString *imageName = [annotationTilePaths objectAtIndex:i];
         //If our image already exists, load it and copy it into the graphics context.
         UIImage *currentImage = [UIImage imageWithContentsOfFile:imageName];
         if (currentImage != nil) {
@@ -0,0 +1,220 @@
+//
+//  TimingWheel.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "TimingWheel.h"
+#include <math.h>
+#include <string.h>
+
+#define SLOT_MASK (TIMING_WHEEL_SLOTS - 1)
+
+static uint64_t tickForTime(const TimingWheel *wheel, double time)
+{
+    if (!(time > 0)) {
+        return 0;
+    }
+    double tick = floor(time / wheel->resolution);
+    if (tick >= (double)UINT64_MAX) {
+        return UINT64_MAX;
+    }
+    return (uint64_t)tick;
+}
+
+static void pushEntry(TimingWheelEntry **head, TimingWheelEntry *entry)
+{
+    entry->next = *head;
+    if (entry->next != NULL) {
+        entry->next->pprev = &entry->next;
+    }
+    entry->pprev = head;
+    *head = entry;
+}
+
+static void unlinkEntry(TimingWheelEntry *entry)
+{
+    *entry->pprev = entry->next;
+    if (entry->next != NULL) {
+        entry->next->pprev = entry->pprev;
+    }
+    entry->next = NULL;
+    entry->pprev = NULL;
+}
+
+//Moves a whole list onto another head, so that it can be worked through safely while
+//entries are added to or removed from the wheel.
+static void takeList(TimingWheelEntry **source, TimingWheelEntry **destination)
+{
+    *destination = *source;
+    *source = NULL;
+    if (*destination != NULL) {
+        (*destination)->pprev = destination;
+    }
+}
+
+//Places an entry on the level whose span covers its distance from the next tick.
+static void placeEntry(TimingWheel *wheel, TimingWheelEntry *entry)
+{
+    if (entry->due < wheel->nextTick) {
+        pushEntry(&wheel->expired, entry);
+        return;
+    }
+    uint64_t delta = entry->due - wheel->nextTick;
+    for (int level = 0; level < TIMING_WHEEL_LEVELS; level++) {
+        if (delta < ((uint64_t)1 << (TIMING_WHEEL_SLOT_BITS * (level + 1)))) {
+            pushEntry(&wheel->slots[level][(entry->due >> (TIMING_WHEEL_SLOT_BITS * level)) & SLOT_MASK], entry);
+            return;
+        }
+    }
+    pushEntry(&wheel->overflow, entry);
+}
+
+static void replaceList(TimingWheel *wheel, TimingWheelEntry **list)
+{
+    //No callbacks run while entries are placed, so the list can simply be detached and walked.
+    TimingWheelEntry *pending = *list;
+    *list = NULL;
+    while (pending != NULL) {
+        TimingWheelEntry *entry = pending;
+        pending = entry->next;
+        entry->next = NULL;
+        entry->pprev = NULL;
+        placeEntry(wheel, entry);
+    }
+}
+
+//When the lower level wraps around, the matching slot on the level above is spread out
+//over the levels below it. Higher levels only need to cascade when their own index wraps.
+static void cascade(TimingWheel *wheel)
+{
+    for (int level = 1; level < TIMING_WHEEL_LEVELS; level++) {
+        if (((wheel->nextTick >> (TIMING_WHEEL_SLOT_BITS * (level - 1))) & SLOT_MASK) != 0) {
+            return;
+        }
+        replaceList(wheel, &wheel->slots[level][(wheel->nextTick >> (TIMING_WHEEL_SLOT_BITS * level)) & SLOT_MASK]);
+    }
+    if (((wheel->nextTick >> (TIMING_WHEEL_SLOT_BITS * (TIMING_WHEEL_LEVELS - 1))) & SLOT_MASK) == 0) {
+        replaceList(wheel, &wheel->overflow);
+    }
+}
+
+static void fireList(TimingWheel *wheel, TimingWheelEntry **list, TimingWheelCallback callback, void *userData)
+{
+    //Keep the list on the wheel while we work through it, so that a callback that cancels
+    //or clears entries still finds them.
+    takeList(list, &wheel->firing);
+    while (wheel->firing != NULL) {
+        TimingWheelEntry *entry = wheel->firing;
+        unlinkEntry(entry);
+        wheel->count--;
+        callback(entry, userData);
+    }
+}
+
+static void gatherList(TimingWheelEntry **list, TimingWheelEntry **pending)
+{
+    while (*list != NULL) {
+        TimingWheelEntry *entry = *list;
+        unlinkEntry(entry);
+        pushEntry(pending, entry);
+    }
+}
+
+static void gatherEntries(TimingWheel *wheel, TimingWheelEntry **pending)
+{
+    *pending = NULL;
+    for (int level = 0; level < TIMING_WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < TIMING_WHEEL_SLOTS; slot++) {
+            gatherList(&wheel->slots[level][slot], pending);
+        }
+    }
+    gatherList(&wheel->expired, pending);
+    gatherList(&wheel->overflow, pending);
+    gatherList(&wheel->firing, pending);
+}
+
+void TimingWheelInit(TimingWheel *wheel, double resolution, double startTime)
+{
+    memset(wheel, 0, sizeof(TimingWheel));
+    wheel->resolution = resolution > 0 ? resolution : 0.01;
+    wheel->nextTick = tickForTime(wheel, startTime);
+}
+
+double TimingWheelCurrentTime(const TimingWheel *wheel)
+{
+    return wheel->nextTick * wheel->resolution;
+}
+
+void TimingWheelSchedule(TimingWheel *wheel, TimingWheelEntry *entry, double time)
+{
+    if (entry->pprev != NULL) {
+        unlinkEntry(entry);
+    } else {
+        wheel->count++;
+    }
+    entry->due = tickForTime(wheel, time);
+    placeEntry(wheel, entry);
+}
+
+void TimingWheelCancel(TimingWheel *wheel, TimingWheelEntry *entry)
+{
+    if (entry->pprev == NULL) {
+        return;
+    }
+    unlinkEntry(entry);
+    wheel->count--;
+}
+
+bool TimingWheelIsScheduled(const TimingWheelEntry *entry)
+{
+    return entry->pprev != NULL;
+}
+
+void TimingWheelAdvance(TimingWheel *wheel, double time, TimingWheelCallback callback, void *userData)
+{
+    uint64_t target = tickForTime(wheel, time);
+    fireList(wheel, &wheel->expired, callback, userData);
+    
+    while (wheel->nextTick <= target) {
+        if (wheel->count == 0) {
+            //Nothing to wait for, so skip straight to the end.
+            wheel->nextTick = target + 1;
+            break;
+        }
+        cascade(wheel);
+        fireList(wheel, &wheel->slots[0][wheel->nextTick & SLOT_MASK], callback, userData);
+        //Anything scheduled in the past by a callback goes out with this tick.
+        fireList(wheel, &wheel->expired, callback, userData);
+        wheel->nextTick++;
+    }
+}
+
+void TimingWheelSeek(TimingWheel *wheel, double time)
+{
+    //Gather everything onto a single list, then place it again relative to our new time.
+    TimingWheelEntry *pending;
+    gatherEntries(wheel, &pending);
+    wheel->nextTick = tickForTime(wheel, time);
+    while (pending != NULL) {
+        TimingWheelEntry *entry = pending;
+        unlinkEntry(entry);
+        placeEntry(wheel, entry);
+    }
+}
+
+void TimingWheelClear(TimingWheel *wheel, TimingWheelCallback callback, void *userData)
+{
+    TimingWheelEntry *pending;
+    gatherEntries(wheel, &pending);
+    while (pending != NULL) {
+        TimingWheelEntry *entry = pending;
+        unlinkEntry(entry);
+        wheel->count--;
+        if (callback != NULL) {
+            callback(entry, userData);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+//
+//  TimingWheel.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//A hierarchical timing wheel for events keyed to score time. Scheduling and cancelling are
+//constant time, and advancing costs one step per elapsed tick plus the events that fall due.
+//Entries are owned by the caller and must stay put while they are scheduled. Nothing fires
+//unless the wheel is advanced, so pausing is simply a matter of not advancing it.
+
+#ifndef TimingWheel_h
+#define TimingWheel_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIMING_WHEEL_LEVELS 4
+#define TIMING_WHEEL_SLOT_BITS 6
+#define TIMING_WHEEL_SLOTS (1 << TIMING_WHEEL_SLOT_BITS)
+
+typedef struct TimingWheelEntry {
+    struct TimingWheelEntry *next;
+    //Points at whichever pointer points at us, so that we can unlink without a search.
+    //This is NULL when the entry isn't scheduled.
+    struct TimingWheelEntry **pprev;
+    uint64_t due;
+    void *context;
+} TimingWheelEntry;
+
+typedef struct {
+    double resolution;
+    //The next tick that will be processed.
+    uint64_t nextTick;
+    size_t count;
+    TimingWheelEntry *slots[TIMING_WHEEL_LEVELS][TIMING_WHEEL_SLOTS];
+    //Entries that are already due, entries beyond the range of the wheel, and entries
+    //that are in the middle of being fired.
+    TimingWheelEntry *expired;
+    TimingWheelEntry *overflow;
+    TimingWheelEntry *firing;
+} TimingWheel;
+
+typedef void (*TimingWheelCallback)(TimingWheelEntry *entry, void *userData);
+
+//Times are in seconds, and are rounded down to the resolution of the wheel.
+void TimingWheelInit(TimingWheel *wheel, double resolution, double startTime);
+double TimingWheelCurrentTime(const TimingWheel *wheel);
+
+//Scheduling an entry that is already scheduled moves it. An entry scheduled for a time
+//that has already passed fires on the next advance.
+void TimingWheelSchedule(TimingWheel *wheel, TimingWheelEntry *entry, double time);
+void TimingWheelCancel(TimingWheel *wheel, TimingWheelEntry *entry);
+bool TimingWheelIsScheduled(const TimingWheelEntry *entry);
+
+//Fires every entry due up to and including the given time, in order of their due tick. (The
+//order within a single tick is unspecified.) Entries are unscheduled before their callback is
+//run, and the callback is free to schedule or cancel other entries. (But not to advance the
+//wheel again.)
+void TimingWheelAdvance(TimingWheel *wheel, double time, TimingWheelCallback callback, void *userData);
+
+//Moves the wheel to a new time in either direction, rearming every pending entry without
+//firing any. Entries that are now in the past fire on the next advance.
+void TimingWheelSeek(TimingWheel *wheel, double time);
+
+//Unschedules every entry, passing each to the callback (if given) so it can be cleaned up.
+void TimingWheelClear(TimingWheel *wheel, TimingWheelCallback callback, void *userData);
+
+#endif /* TimingWheel_h */
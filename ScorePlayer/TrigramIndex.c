@@ -0,0 +1,478 @@
+//
+//  TrigramIndex.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "TrigramIndex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIGRAM_INITIAL_SLOTS 1024
+#define TRIGRAM_QUERY_LIMIT 64
+
+typedef struct {
+    //The three bytes of the trigram, with bit 24 set so that an empty slot can be 0.
+    uint32_t key;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *documents;
+} TrigramPosting;
+
+struct TrigramIndex {
+    size_t fieldCount;
+    size_t documentCount;
+    uint64_t version;
+
+    //The text of every field of every document, one after the other. Field f of document d
+    //runs from fieldOffsets[d * fieldCount + f] to the offset after it.
+    char *text;
+    size_t textLength;
+    size_t textCapacity;
+    uint32_t *fieldOffsets;
+    size_t offsetCapacity;
+
+    TrigramPosting *postings;
+    size_t slotCount;
+    size_t postingCount;
+};
+
+static bool reserve(void **buffer, size_t *capacity, size_t needed, size_t size)
+{
+    if (needed <= *capacity) {
+        return true;
+    }
+    size_t newCapacity = *capacity > 0 ? *capacity : 16;
+    while (newCapacity < needed) {
+        newCapacity *= 2;
+    }
+    void *larger = realloc(*buffer, newCapacity * size);
+    if (larger == NULL) {
+        return false;
+    }
+    *buffer = larger;
+    *capacity = newCapacity;
+    return true;
+}
+
+static uint32_t trigramKey(const char *bytes)
+{
+    const uint8_t *position = (const uint8_t *)bytes;
+    return 0x1000000 | ((uint32_t)position[0] << 16) | ((uint32_t)position[1] << 8) | position[2];
+}
+
+static size_t slotForKey(uint32_t key, size_t slotCount)
+{
+    return (size_t)((key * 2654435761U) & (uint32_t)(slotCount - 1));
+}
+
+static TrigramPosting *findPosting(const TrigramIndex *index, uint32_t key)
+{
+    size_t slot = slotForKey(key, index->slotCount);
+    while (index->postings[slot].key != 0) {
+        if (index->postings[slot].key == key) {
+            return &index->postings[slot];
+        }
+        slot = (slot + 1) & (index->slotCount - 1);
+    }
+    return NULL;
+}
+
+static bool growPostings(TrigramIndex *index)
+{
+    size_t slotCount = index->slotCount * 2;
+    TrigramPosting *postings = calloc(slotCount, sizeof(TrigramPosting));
+    if (postings == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < index->slotCount; i++) {
+        if (index->postings[i].key == 0) {
+            continue;
+        }
+        size_t slot = slotForKey(index->postings[i].key, slotCount);
+        while (postings[slot].key != 0) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        postings[slot] = index->postings[i];
+    }
+    free(index->postings);
+    index->postings = postings;
+    index->slotCount = slotCount;
+    return true;
+}
+
+static bool addPosting(TrigramIndex *index, uint32_t key, uint32_t document)
+{
+    TrigramPosting *posting = findPosting(index, key);
+    if (posting == NULL) {
+        //Keep the table no more than half full.
+        if ((index->postingCount + 1) * 2 > index->slotCount && !growPostings(index)) {
+            return false;
+        }
+        size_t slot = slotForKey(key, index->slotCount);
+        while (index->postings[slot].key != 0) {
+            slot = (slot + 1) & (index->slotCount - 1);
+        }
+        posting = &index->postings[slot];
+        posting->key = key;
+        index->postingCount++;
+    }
+
+    //Documents are added in order, so a document only ever needs checking against the end of
+    //the list, and the list stays sorted.
+    if (posting->count > 0 && posting->documents[posting->count - 1] == document) {
+        return true;
+    }
+    size_t capacity = posting->capacity;
+    if (!reserve((void **)&posting->documents, &capacity, posting->count + 1, sizeof(uint32_t))) {
+        return false;
+    }
+    posting->capacity = (uint32_t)capacity;
+    posting->documents[posting->count++] = document;
+    return true;
+}
+
+TrigramIndex *TrigramIndexCreate(size_t fieldCount)
+{
+    if (fieldCount == 0) {
+        return NULL;
+    }
+    TrigramIndex *index = calloc(1, sizeof(TrigramIndex));
+    if (index == NULL) {
+        return NULL;
+    }
+    index->fieldCount = fieldCount;
+    index->slotCount = TRIGRAM_INITIAL_SLOTS;
+    index->postings = calloc(index->slotCount, sizeof(TrigramPosting));
+    index->fieldOffsets = malloc(sizeof(uint32_t));
+    index->offsetCapacity = 1;
+    if (index->postings == NULL || index->fieldOffsets == NULL) {
+        TrigramIndexDestroy(index);
+        return NULL;
+    }
+    index->fieldOffsets[0] = 0;
+    return index;
+}
+
+void TrigramIndexDestroy(TrigramIndex *index)
+{
+    if (index == NULL) {
+        return;
+    }
+    if (index->postings != NULL) {
+        for (size_t i = 0; i < index->slotCount; i++) {
+            free(index->postings[i].documents);
+        }
+    }
+    free(index->postings);
+    free(index->text);
+    free(index->fieldOffsets);
+    free(index);
+}
+
+bool TrigramIndexAdd(TrigramIndex *index, const char **fields, const size_t *lengths)
+{
+    size_t totalLength = 0;
+    for (size_t i = 0; i < index->fieldCount; i++) {
+        totalLength += fields[i] != NULL ? lengths[i] : 0;
+    }
+    size_t offsetCount = (index->documentCount + 1) * index->fieldCount + 1;
+    if (index->textLength + totalLength > UINT32_MAX || index->documentCount >= UINT32_MAX || !reserve((void **)&index->text, &index->textCapacity, index->textLength + totalLength, 1) || !reserve((void **)&index->fieldOffsets, &index->offsetCapacity, offsetCount, sizeof(uint32_t))) {
+        return false;
+    }
+
+    uint32_t document = (uint32_t)index->documentCount;
+    uint32_t *offsets = &index->fieldOffsets[document * index->fieldCount];
+    for (size_t i = 0; i < index->fieldCount; i++) {
+        size_t length = fields[i] != NULL ? lengths[i] : 0;
+        if (length > 0) {
+            memcpy(index->text + index->textLength, fields[i], length);
+        }
+        //Trigrams never cross from one field into the next.
+        for (size_t j = 0; j + 3 <= length; j++) {
+            if (!addPosting(index, trigramKey(fields[i] + j), document)) {
+                //Drop the text added so far. (Any postings made for this document are harmless,
+                //since they only lead to a candidate that fails the exact check.)
+                index->textLength = offsets[0];
+                return false;
+            }
+        }
+        index->textLength += length;
+        offsets[i + 1] = (uint32_t)index->textLength;
+    }
+    index->documentCount++;
+    index->version++;
+    return true;
+}
+
+size_t TrigramIndexDocumentCount(const TrigramIndex *index)
+{
+    return index->documentCount;
+}
+
+#pragma mark - Searching
+
+static bool isWordCharacter(uint8_t character)
+{
+    //Anything outside of ASCII is treated as part of a word, since it's most likely a letter.
+    return character >= 0x80 || (character >= '0' && character <= '9') || (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z');
+}
+
+static uint32_t rankDocument(const TrigramIndex *index, uint32_t document, const char *query, size_t length)
+{
+    //Returns UINT32_MAX if the query isn't in the document.
+    uint32_t best = UINT32_MAX;
+    const uint32_t *offsets = &index->fieldOffsets[document * index->fieldCount];
+    for (size_t i = 0; i < index->fieldCount; i++) {
+        const char *field = index->text + offsets[i];
+        size_t fieldLength = offsets[i + 1] - offsets[i];
+        if (length == 0) {
+            return 0;
+        }
+        for (size_t position = 0; position + length <= fieldLength; position++) {
+            const char *found = memchr(field + position, query[0], fieldLength - length - position + 1);
+            if (found == NULL) {
+                break;
+            }
+            position = found - field;
+            if (memcmp(found, query, length) != 0) {
+                continue;
+            }
+            uint32_t kind = position == 0 ? 0 : (isWordCharacter(field[position - 1]) ? 2 : 1);
+            uint32_t rank = kind * (uint32_t)index->fieldCount + (uint32_t)i;
+            if (rank < best) {
+                best = rank;
+            }
+            //A later match in this field can only do better by starting a word.
+            if (kind < 2) {
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+static int compareCounts(const void *first, const void *second)
+{
+    uint32_t a = (*(const TrigramPosting **)first)->count;
+    uint32_t b = (*(const TrigramPosting **)second)->count;
+    return (a > b) - (a < b);
+}
+
+static bool containsBytes(const char *text, size_t textLength, const char *bytes, size_t length)
+{
+    for (size_t i = 0; i + length <= textLength; i++) {
+        if (memcmp(text + i, bytes, length) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static size_t intersect(uint32_t *candidates, size_t count, const TrigramPosting *posting)
+{
+    //Both lists are sorted, and the candidates are never the longer list, so step through the
+    //posting list with a galloping search.
+    size_t kept = 0;
+    size_t low = 0;
+    for (size_t i = 0; i < count && low < posting->count; i++) {
+        uint32_t document = candidates[i];
+        size_t step = 1;
+        size_t high = low;
+        while (high < posting->count && posting->documents[high] < document) {
+            low = high + 1;
+            high += step;
+            step *= 2;
+        }
+        if (high > posting->count) {
+            high = posting->count;
+        }
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (posting->documents[middle] < document) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (low < posting->count && posting->documents[low] == document) {
+            candidates[kept++] = document;
+            low++;
+        }
+    }
+    return kept;
+}
+
+static size_t scanDocuments(const TrigramIndex *index, const char *query, size_t length, TrigramMatch *ordered, size_t *rankStarts)
+{
+    //Looks for the query across all of the text at once, which is much quicker than going
+    //through the documents one at a time when most of them don't match. Each document that
+    //does is ranked in full and then skipped over.
+    size_t matchCount = 0;
+    size_t field = 0;
+    size_t position = 0;
+    const uint32_t *offsets = index->fieldOffsets;
+    while (position + length <= index->textLength) {
+        const char *found = memchr(index->text + position, query[0], index->textLength - length - position + 1);
+        if (found == NULL) {
+            break;
+        }
+        position = found - index->text;
+        while (offsets[field + 1] <= position) {
+            field++;
+        }
+        if (position + length > offsets[field + 1] || memcmp(found, query, length) != 0) {
+            position++;
+            continue;
+        }
+
+        uint32_t document = (uint32_t)(field / index->fieldCount);
+        uint32_t rank = rankDocument(index, document, query, length);
+        ordered[matchCount].document = document;
+        ordered[matchCount].rank = rank;
+        rankStarts[rank + 1]++;
+        matchCount++;
+        field = (document + 1) * index->fieldCount;
+        position = offsets[field];
+    }
+    return matchCount;
+}
+
+void TrigramSearchInit(TrigramSearch *search)
+{
+    memset(search, 0, sizeof(TrigramSearch));
+}
+
+void TrigramSearchRelease(TrigramSearch *search)
+{
+    free(search->matches);
+    free(search->ordered);
+    free(search->query);
+    free(search->candidates);
+    memset(search, 0, sizeof(TrigramSearch));
+}
+
+static size_t failSearch(TrigramSearch *search)
+{
+    search->valid = false;
+    search->matchCount = 0;
+    return 0;
+}
+
+size_t TrigramSearchRun(TrigramSearch *search, const TrigramIndex *index, const char *query, size_t length)
+{
+    size_t rankCount = 3 * index->fieldCount;
+    size_t *rankStarts = calloc(rankCount + 1, sizeof(size_t));
+    if (rankStarts == NULL || !reserve((void **)&search->query, &search->queryCapacity, length + 1, 1)) {
+        free(rankStarts);
+        return failSearch(search);
+    }
+
+    //Look up the posting lists of the query's trigrams, shortest first. (Long queries only use
+    //their first few trigrams, since the check that follows is exact anyway.)
+    const TrigramPosting *postings[TRIGRAM_QUERY_LIMIT];
+    size_t postingCount = 0;
+    bool missing = false;
+    for (size_t i = 0; i + 3 <= length && postingCount < TRIGRAM_QUERY_LIMIT; i++) {
+        const TrigramPosting *posting = findPosting(index, trigramKey(query + i));
+        if (posting == NULL) {
+            missing = true;
+            break;
+        }
+        postings[postingCount++] = posting;
+    }
+    if (postingCount > 0 && !missing) {
+        qsort(postings, postingCount, sizeof(TrigramPosting *), compareCounts);
+    }
+
+    //If this query contains the last one, the answer is among the last matches. Those are kept
+    //in document order, so they can be filtered in place. It's only worth it if there are fewer
+    //of them than there are documents to go through otherwise.
+    size_t matchCount = 0;
+    bool refine = search->valid && search->index == index && search->indexVersion == index->version && containsBytes(query, length, search->query, search->queryLength);
+    if (postingCount > 0) {
+        refine = refine && (missing || search->matchCount < postings[0]->count);
+    } else {
+        refine = refine && search->matchCount < index->documentCount / 2;
+    }
+
+    if (refine) {
+        for (size_t i = 0; i < search->matchCount; i++) {
+            uint32_t document = search->ordered[i].document;
+            uint32_t rank = rankDocument(index, document, query, length);
+            if (rank != UINT32_MAX) {
+                search->ordered[matchCount].document = document;
+                search->ordered[matchCount].rank = rank;
+                rankStarts[rank + 1]++;
+                matchCount++;
+            }
+        }
+    } else if (missing) {
+        //One of the trigrams isn't anywhere in the index.
+        matchCount = 0;
+    } else if (length < 3) {
+        //Too short for a trigram, so everything has to be looked through.
+        if (!reserve((void **)&search->ordered, &search->orderedCapacity, index->documentCount, sizeof(TrigramMatch))) {
+            free(rankStarts);
+            return failSearch(search);
+        }
+        if (length == 0) {
+            for (size_t i = 0; i < index->documentCount; i++) {
+                search->ordered[i].document = (uint32_t)i;
+                search->ordered[i].rank = 0;
+            }
+            matchCount = index->documentCount;
+            rankStarts[1] = matchCount;
+        } else {
+            matchCount = scanDocuments(index, query, length, search->ordered, rankStarts);
+        }
+    } else {
+        //Intersect the posting lists, then check each document that's left.
+        size_t candidateCount = postings[0]->count;
+        if (!reserve((void **)&search->candidates, &search->candidateCapacity, candidateCount, sizeof(uint32_t)) || !reserve((void **)&search->ordered, &search->orderedCapacity, candidateCount, sizeof(TrigramMatch))) {
+            free(rankStarts);
+            return failSearch(search);
+        }
+        memcpy(search->candidates, postings[0]->documents, candidateCount * sizeof(uint32_t));
+        for (size_t i = 1; i < postingCount && candidateCount > 0; i++) {
+            if (postings[i] != postings[i - 1]) {
+                candidateCount = intersect(search->candidates, candidateCount, postings[i]);
+            }
+        }
+        for (size_t i = 0; i < candidateCount; i++) {
+            uint32_t rank = rankDocument(index, search->candidates[i], query, length);
+            if (rank != UINT32_MAX) {
+                search->ordered[matchCount].document = search->candidates[i];
+                search->ordered[matchCount].rank = rank;
+                rankStarts[rank + 1]++;
+                matchCount++;
+            }
+        }
+    }
+
+    //There are only a few possible ranks, so sort the matches by counting them. Taking them in
+    //document order keeps documents with the same rank in the order they were added.
+    if (!reserve((void **)&search->matches, &search->matchCapacity, matchCount, sizeof(TrigramMatch))) {
+        free(rankStarts);
+        return failSearch(search);
+    }
+    for (size_t i = 1; i <= rankCount; i++) {
+        rankStarts[i] += rankStarts[i - 1];
+    }
+    for (size_t i = 0; i < matchCount; i++) {
+        search->matches[rankStarts[search->ordered[i].rank]++] = search->ordered[i];
+    }
+    free(rankStarts);
+
+    if (length > 0) {
+        memcpy(search->query, query, length);
+    }
+    search->queryLength = length;
+    search->matchCount = matchCount;
+    search->index = index;
+    search->indexVersion = index->version;
+    search->valid = true;
+    return matchCount;
+}
@@ -0,0 +1,65 @@
+//
+//  TrigramIndex.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//A substring search index over a list of documents, each made up of a fixed number of text
+//fields. Every run of three bytes in a field has a posting list of the documents that contain
+//it, so a query only has to check the documents that have all of its trigrams. Text is
+//compared byte for byte, so the caller should fold the case and diacritics of both the
+//documents and the queries (as UTF-8) before they get here.
+//A search remembers its last query and matches. If the next query contains the last one (as
+//it does when someone keeps typing) only the previous matches are checked again.
+
+#ifndef TrigramIndex_h
+#define TrigramIndex_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct TrigramIndex TrigramIndex;
+
+typedef struct {
+    uint32_t document;
+    //Lower is better. Matches at the start of a field come first, then matches at the start
+    //of a word, then anything else, with earlier fields winning ties.
+    uint32_t rank;
+} TrigramMatch;
+
+typedef struct {
+    //The results of the last run, best first. (Documents with the same rank stay in the order
+    //they were added.)
+    TrigramMatch *matches;
+    size_t matchCount;
+
+    const TrigramIndex *index;
+    uint64_t indexVersion;
+    char *query;
+    size_t queryLength;
+    size_t queryCapacity;
+    uint32_t *candidates;
+    size_t candidateCapacity;
+    //The same matches in document order.
+    TrigramMatch *ordered;
+    size_t orderedCapacity;
+    size_t matchCapacity;
+    bool valid;
+} TrigramSearch;
+
+TrigramIndex *TrigramIndexCreate(size_t fieldCount);
+void TrigramIndexDestroy(TrigramIndex *index);
+//Documents are numbered from 0 in the order they're added. Returns false if memory runs out.
+bool TrigramIndexAdd(TrigramIndex *index, const char **fields, const size_t *lengths);
+size_t TrigramIndexDocumentCount(const TrigramIndex *index);
+
+void TrigramSearchInit(TrigramSearch *search);
+void TrigramSearchRelease(TrigramSearch *search);
+//Finds the documents with the query in any of their fields, and returns how many there are.
+//An empty query matches everything. Returns 0 (and forgets the last query) if memory runs out.
+size_t TrigramSearchRun(TrigramSearch *search, const TrigramIndex *index, const char *query, size_t length);
+
+#endif /* TrigramIndex_h */
@@ -22,7 +22,7 @@ typedef enum {
     kTrainView = 1
 } MapMode;
 
-@interface UBahn : NSObject <RendererDelegate, NSXMLParserDelegate> {
+@interface UBahn : NSObject <RendererDelegate> {
     BOOL isMaster;
 }
 
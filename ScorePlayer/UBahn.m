@@ -13,10 +13,89 @@
 #import "Train.h"
 #import "Junction.h"
 #import "Mosaic.h"
+#import "FrameClock.h"
+#import "XMLReader.h"
+#import "ScoreArchive.h"
 
-@interface UBahn ()
+//Trains move in fixed simulation steps. If we fall behind, at most this many steps are
+//caught up in a single frame.
+static const CFTimeInterval UBAHN_STEP_INTERVAL = 0.04;
+static const NSInteger UBAHN_MAX_STEPS_PER_FRAME = 10;
+
+typedef enum {
+    kPathsElement,
+    kWidthElement,
+    kHeightElement,
+    kBidirectionalElement,
+    kPathElement,
+    kXElement,
+    kYElement,
+    kStopElement,
+    kInvertElement,
+    kEndZoneElement,
+    kTrainsElement,
+    kTrainElement,
+    kPathNumberElement,
+    kPartNumberElement,
+    kStopTimeElement,
+    kJunctionTimeElement,
+    kSpeedElement,
+    kRGBElement,
+    kMosaicElement,
+    kStartImageElement,
+    kEndImageElement,
+    kFinalImageElement,
+    kDurationElement,
+    kOverlayElement,
+    kBackgroundElement,
+    kFadeLayerElement,
+    kImageElement,
+    kXOffsetElement,
+    kYOffsetElement
+} PathsElement;
+
+//The elements of paths.dtd.
+static const XMLName pathsElements[] = {
+    {"paths", kPathsElement},
+    {"width", kWidthElement},
+    {"height", kHeightElement},
+    {"bidirectional", kBidirectionalElement},
+    {"path", kPathElement},
+    {"x", kXElement},
+    {"y", kYElement},
+    {"stop", kStopElement},
+    {"invert", kInvertElement},
+    {"endzone", kEndZoneElement},
+    {"trains", kTrainsElement},
+    {"train", kTrainElement},
+    {"pathnumber", kPathNumberElement},
+    {"partnumber", kPartNumberElement},
+    {"stoptime", kStopTimeElement},
+    {"junctiontime", kJunctionTimeElement},
+    {"speed", kSpeedElement},
+    {"rgb", kRGBElement},
+    {"mosaic", kMosaicElement},
+    {"startimage", kStartImageElement},
+    {"endimage", kEndImageElement},
+    {"finalimage", kFinalImageElement},
+    {"duration", kDurationElement},
+    {"overlay", kOverlayElement},
+    {"background", kBackgroundElement},
+    {"fadelayer", kFadeLayerElement},
+    {"image", kImageElement},
+    {"xoffset", kXOffsetElement},
+    {"yoffset", kYOffsetElement}
+};
+
+static XMLNameTable pathsNames;
+
+@interface UBahn () <FrameClockSubscriber>
 
 - (void)loadPaths;
+- (void)startElement:(int)element;
+- (void)endElement:(int)element text:(XMLSpan)text;
+- (void)finishLoadingPaths;
+- (void)failLoadingPaths;
 - (void)animateTrains;
 - (void)animateBackgroundAtNode:(BOOL)atNode junctionNumber:(NSInteger)atJunction;
 - (void)enableHighResTimer:(BOOL)enabled;
@@ -67,7 +146,9 @@
     NSInteger selectedTrain;
     OSCMessage *initialTrainData;
     
-    NSTimer *highRes;
+    BOOL animating;
+    CFTimeInterval animationStartTime;
+    NSInteger stepsTaken;
     NSInteger timeLimit;
     int mosaicCounter;
     NSInteger mosaicDuration;
@@ -86,16 +167,15 @@
     CGFloat coordinateScaleFactor;
     BOOL scaleFactorLocked;
     
-    NSFileManager *fileManager;
-    NSXMLParser *xmlParser;
-    NSMutableString *currentString;
     xmlLocation currentPrefs;
     BOOL isData;
     
-    NSArray *xArray;
-    NSArray *yArray;
-    NSArray *stopArray;
-    NSArray *orientationArray;
+    //The coordinates, stops and orientations of the path being read, as C arrays of double, int
+    //and BOOL respectively.
+    NSData *xValues;
+    NSData *yValues;
+    NSData *stopValues;
+    NSData *orientationValues;
     BOOL addToEndZone;
     
     NSInteger assignedPath;
@@ -120,20 +200,61 @@
 
 - (void)loadPaths
 {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        XMLNameTableInit(&pathsNames, pathsElements, sizeof(pathsElements) / sizeof(XMLName));
+    });
+    
     //Load the paths file. This now loads more than just the paths, so some of the initialization of layers needs to be
-    //done after this has taken place.
-    NSData *pathData = [[NSData alloc] initWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
-    if (pathData != nil) {
-        xmlParser = [[NSXMLParser alloc] initWithData:pathData];
-    }
+    //done after this has taken place. (Paths files can be large, so map the file rather than reading it in. The
+    //reader points into the data, so it needs to be kept alive until we're done.)
+    NSData *pathData __attribute__((objc_precise_lifetime)) = [ScoreArchive dataWithContentsOfFile:[score.scorePath stringByAppendingPathComponent:score.prefsFile]];
     
     isData = NO;
     scaleFactorLocked = NO;
     coordinateScaleFactor = 1;
-    xmlParser.delegate = self;
     currentPrefs = kTopLevel;
-    fileManager = [NSFileManager defaultManager];
-    [xmlParser parse];
+    if (pathData == nil) {
+        [self failLoadingPaths];
+        return;
+    }
+    
+    XMLReader reader;
+    XMLReaderInit(&reader, [pathData bytes], [pathData length]);
+    XMLText text;
+    XMLTextInit(&text);
+    
+    BOOL finished = NO;
+    while (!finished) {
+        switch (XMLReaderNext(&reader)) {
+            case kXMLStartElement:
+                XMLTextReset(&text);
+                [self startElement:XMLNameTableLookup(&pathsNames, reader.name)];
+                break;
+                
+            case kXMLText:
+                if (isData) {
+                    XMLTextAppend(&text, &reader);
+                }
+                break;
+                
+            case kXMLEndElement:
+                [self endElement:XMLNameTableLookup(&pathsNames, reader.name) text:text.span];
+                XMLTextReset(&text);
+                break;
+                
+            case kXMLEndDocument:
+                finished = YES;
+                [self finishLoadingPaths];
+                break;
+                
+            case kXMLError:
+                finished = YES;
+                [self failLoadingPaths];
+                break;
+        }
+    }
+    XMLTextRelease(&text);
 }
 
 - (void)animateTrains
@@ -316,18 +437,35 @@
 - (void)enableHighResTimer:(BOOL)enabled
 {
     if (enabled) {
-        if (highRes == nil || !highRes.isValid) {
-            //Don't start a new timer if there is already a valid high resolution timer running.
-            highRes = [NSTimer scheduledTimerWithTimeInterval:0.04 target:self selector:@selector(animateTrains) userInfo:nil repeats:YES];
+        if (!animating) {
+            //Don't restart our animation if it's already running.
+            animationStartTime = [[FrameClock sharedClock] currentTime];
+            stepsTaken = 0;
+            [[FrameClock sharedClock] addSubscriber:self];
+            animating = YES;
         }
     } else {
-        if (highRes != nil) {
-            [highRes invalidate];
-            highRes = nil;
+        if (animating) {
+            [[FrameClock sharedClock] removeSubscriber:self];
+            animating = NO;
         }
     }
 }
 
+- (void)animateToTime:(CFTimeInterval)frameTime
+{
+    //Run however many simulation steps are due since we started, so that a late frame
+    //catches up rather than slowing the trains down. (A step may stop or restart the animation.)
+    CFTimeInterval startTime = animationStartTime;
+    NSInteger dueSteps = floor(MAX(frameTime - startTime, 0) / UBAHN_STEP_INTERVAL);
+    NSInteger steps = 0;
+    while (animating && animationStartTime == startTime && stepsTaken < dueSteps && steps < UBAHN_MAX_STEPS_PER_FRAME) {
+        stepsTaken++;
+        steps++;
+        [self animateTrains];
+    }
+}
+
 - (OSCMessage *)createTrainMessage:(BOOL)newData
 {
     //Generate the train data to send to the clients.
@@ -1213,32 +1351,62 @@
     [UIDelegate partChangedToPart:selectedTrain + 1];
 }
 
-#pragma mark - NSXMLParser delegate
+#pragma mark - Paths file
+
+static NSData *valuesFromList(XMLSpan list, PathsElement element)
+{
+    //Converts a comma separated list into a C array of the type used for the element.
+    size_t count = XMLSpanSplit(list, ',', NULL, 0);
+    NSMutableData *fields = [NSMutableData dataWithLength:count * sizeof(XMLSpan)];
+    XMLSpan *field = [fields mutableBytes];
+    XMLSpanSplit(list, ',', field, count);
+    
+    NSMutableData *values;
+    if (element == kStopElement) {
+        values = [NSMutableData dataWithLength:count * sizeof(int)];
+        int *stop = [values mutableBytes];
+        for (size_t i = 0; i < count; i++) {
+            stop[i] = (int)XMLSpanIntegerValue(field[i]);
+        }
+    } else if (element == kInvertElement) {
+        values = [NSMutableData dataWithLength:count * sizeof(BOOL)];
+        BOOL *orientation = [values mutableBytes];
+        for (size_t i = 0; i < count; i++) {
+            orientation[i] = XMLSpanBoolValue(field[i]);
+        }
+    } else {
+        values = [NSMutableData dataWithLength:count * sizeof(double)];
+        double *coordinate = [values mutableBytes];
+        for (size_t i = 0; i < count; i++) {
+            coordinate[i] = XMLSpanDoubleValue(field[i]);
+        }
+    }
+    return values;
+}
 
-- (void)parser:(NSXMLParser *)parser didStartElement:(NSString *)elementName namespaceURI:(NSString *)namespaceURI qualifiedName:(NSString *)qName attributes:(NSDictionary *)attributeDict
+- (void)startElement:(int)element
 {
     if (currentPrefs == kTopLevel) {
-        if ([elementName isEqualToString:@"path"]) {
-            xArray = nil;
-            yArray = nil;
-            stopArray = nil;
-            orientationArray = nil;
+        if (element == kPathElement) {
+            xValues = nil;
+            yValues = nil;
+            stopValues = nil;
+            orientationValues = nil;
             addToEndZone = NO;
             currentPrefs = kPath;
-        } else if ([elementName isEqualToString:@"trains"]) {
+        } else if (element == kTrainsElement) {
             currentPrefs = kTrains;
-        } else if ([elementName isEqualToString:@"mosaic"]) {
+        } else if (element == kMosaicElement) {
             currentPrefs = kMosaic;
-        } else if ([elementName isEqualToString:@"background"] || [elementName isEqualToString:@"fadelayer"] || [elementName isEqualToString:@"overlay"]) {
+        } else if (element == kBackgroundElement || element == kFadeLayerElement || element == kOverlayElement) {
             imageName = nil;
             imageOffset = CGPointZero;
             currentPrefs = kImage;
-        } else if ([elementName isEqualToString:@"width"] || [elementName isEqualToString:@"height"] || [elementName isEqualToString:@"bidirectional"]) {
+        } else if (element == kWidthElement || element == kHeightElement || element == kBidirectionalElement) {
             isData = YES;
-            currentString = nil;
         }
     } else {
-        if ((currentPrefs == kTrains) && [elementName isEqualToString:@"train"]) {
+        if ((currentPrefs == kTrains) && element == kTrainElement) {
             //Reset default values.
             assignedPath = 0;
             assignedPart = 0;
@@ -1248,34 +1416,22 @@
             trainColour = [UIColor blackColor];
         } else {
             isData = YES;
-            currentString = nil;
         }
     }
 }
 
-- (void)parser:(NSXMLParser *)parser foundCharacters:(NSString *)string
-{
-    if (isData) {
-        if (currentString == nil) {
-            currentString = [[NSMutableString alloc] initWithString:string];
-        } else {
-            [currentString appendString:string];
-        }
-    }
-}
-
-- (void)parser:(NSXMLParser *)parser didEndElement:(NSString *)elementName namespaceURI:(NSString *)namespaceURI qualifiedName:(NSString *)qName
+- (void)endElement:(int)element text:(XMLSpan)text
 {
     switch (currentPrefs) {
         case kTopLevel:
             //Once we've started processing paths none of these tags can have any effect.
             if (!scaleFactorLocked) {
-                if ([elementName isEqualToString:@"width"]) {
-                    coordinateScaleFactor = screenWidth / [currentString floatValue];
-                } else if ([elementName isEqualToString:@"height"]) {
-                    coordinateScaleFactor = screenHeight / [currentString floatValue];
-                } else if ([elementName isEqualToString:@"bidirectional"]) {
-                    if (currentString != nil && [currentString caseInsensitiveCompare:@"no"] == NSOrderedSame) {
+                if (element == kWidthElement) {
+                    coordinateScaleFactor = screenWidth / XMLSpanDoubleValue(text);
+                } else if (element == kHeightElement) {
+                    coordinateScaleFactor = screenHeight / XMLSpanDoubleValue(text);
+                } else if (element == kBidirectionalElement) {
+                    if (XMLSpanEqualsIgnoringCase(text, "no")) {
                         bidirectional = NO;
                     }
                 }
@@ -1283,22 +1439,26 @@
             break;
             
         case kPath:
-            if ([elementName isEqualToString:@"path"]) {
-                if ([xArray count] != [yArray count] || [xArray count] != [stopArray count]) {
+            if (element == kPathElement) {
+                NSUInteger pointCount = [xValues length] / sizeof(double);
+                if (pointCount != [yValues length] / sizeof(double) || pointCount != [stopValues length] / sizeof(int)) {
                     //Our arrays aren't the same size. This isn't a valid coordinate list. Ignore it.
                     currentPrefs = kTopLevel;
                     isData = NO;
                     return;
                 }
                 scaleFactorLocked = YES;
-                NSMutableArray *currentPath = [[NSMutableArray alloc] init];
-                NSMutableArray *currentStops = [[NSMutableArray alloc] init];
-                for (int i = 0; i < [xArray count]; i++) {
-                    CGPoint pathPoint = CGPointMake(coordinateScaleFactor * [[xArray objectAtIndex:i] floatValue] + xOffset, coordinateScaleFactor * [[yArray objectAtIndex:i] floatValue] + yOffset);
+                NSMutableArray *currentPath = [[NSMutableArray alloc] initWithCapacity:pointCount];
+                NSMutableArray *currentStops = [[NSMutableArray alloc] initWithCapacity:pointCount];
+                const double *x = [xValues bytes];
+                const double *y = [yValues bytes];
+                const int *stopNumbers = [stopValues bytes];
+                for (int i = 0; i < pointCount; i++) {
+                    CGPoint pathPoint = CGPointMake(coordinateScaleFactor * x[i] + xOffset, coordinateScaleFactor * y[i] + yOffset);
                     [currentPath addObject:[NSValue valueWithCGPoint:pathPoint]];
-                    NSNumber *stop = [NSNumber numberWithInt:[[stopArray objectAtIndex:i] intValue]];
+                    NSNumber *stop = [NSNumber numberWithInt:stopNumbers[i]];
                     [currentStops addObject:stop];
-                    if ([stop intValue] > 0 && (bidirectional || i < ([xArray count] - 1))) {
+                    if ([stop intValue] > 0 && (bidirectional || i < (pointCount - 1))) {
                         //The stop is also a junction. Store a path to it in our junctions dictionary.
                         //(For each junction, we hold an array of path indexes. The first index is the path, while the
                         //second index is the position of the junction stop within the associated path array.)
@@ -1317,11 +1477,13 @@
                         }
                     }
                 }
-                if ([orientationArray count] == [xArray count] - 1) {
+                NSUInteger orientationCount = [orientationValues length] / sizeof(BOOL);
+                if (orientationCount == pointCount - 1) {
                     //Some of our track segments need the part graphic to be inverted. Make a note of them.
-                    NSMutableArray *currentOrientations = [[NSMutableArray alloc] init];
-                    for (int i = 0; i < [orientationArray count]; i++) {
-                        [currentOrientations addObject:[NSNumber numberWithBool:[[orientationArray objectAtIndex:i] boolValue]]];
+                    NSMutableArray *currentOrientations = [[NSMutableArray alloc] initWithCapacity:orientationCount];
+                    const BOOL *orientations = [orientationValues bytes];
+                    for (int i = 0; i < orientationCount; i++) {
+                        [currentOrientations addObject:[NSNumber numberWithBool:orientations[i]]];
                     }
                     [invertOrientation setObject:currentOrientations forKey:[NSNumber numberWithInteger:[paths count]]];
                 }
@@ -1332,27 +1494,27 @@
                     [endZone addObject:[NSNumber numberWithInteger:[paths count] - 1]];
                 }
                 currentPrefs = kTopLevel;
-            } else if ([elementName isEqualToString:@"x"]) {
+            } else if (element == kXElement) {
                 //Convert our values into an array for easier handling
-                xArray = [currentString componentsSeparatedByString:@","];
-            } else if ([elementName isEqualToString:@"y"]) {
-                yArray = [currentString componentsSeparatedByString:@","];
-            } else if ([elementName isEqualToString:@"stop"]) {
-                stopArray = [currentString componentsSeparatedByString:@","];
-            } else if ([elementName isEqualToString:@"invert"]) {
-                orientationArray = [currentString componentsSeparatedByString:@","];
-            } else if ([elementName isEqualToString:@"endzone"]) {
+                xValues = valuesFromList(text, kXElement);
+            } else if (element == kYElement) {
+                yValues = valuesFromList(text, kYElement);
+            } else if (element == kStopElement) {
+                stopValues = valuesFromList(text, kStopElement);
+            } else if (element == kInvertElement) {
+                orientationValues = valuesFromList(text, kInvertElement);
+            } else if (element == kEndZoneElement) {
                 //Only worry about having an endzone if our score duration is a soft timelimit rather than a hard value.
-                if (currentString != nil && [currentString caseInsensitiveCompare:@"yes"] == NSOrderedSame && UIDelegate.clockDuration < 0) {
+                if (XMLSpanEqualsIgnoringCase(text, "yes") && UIDelegate.clockDuration < 0) {
                     addToEndZone = YES;
                 }
             }
             break;
             
         case kTrains:
-            if ([elementName isEqualToString:@"trains"]) {
+            if (element == kTrainsElement) {
                 currentPrefs = kTopLevel;
-            } else if ([elementName isEqualToString:@"train"]) {
+            } else if (element == kTrainElement) {
                 Train *train = [[Train alloc] initWithPart:assignedPart];
                 train.initialPathIndex = assignedPath;
                 train.stopLength = stopLength;
@@ -1360,29 +1522,29 @@
                 train.speed = trainSpeed;
                 train.sprite.backgroundColor = trainColour.CGColor;
                 [trains addObject:train];
-            } else if ([elementName isEqualToString:@"pathnumber"]) {
-                assignedPath = [currentString integerValue];
-            } else if ([elementName isEqualToString:@"partnumber"]) {
-                assignedPart = [currentString integerValue];
-            } else if ([elementName isEqualToString:@"stoptime"]) {
-                stopLength = [currentString integerValue];
-            } else if ([elementName isEqualToString:@"junctiontime"]) {
-                junctionLength = [currentString integerValue];
-            } else if ([elementName isEqualToString:@"speed"]) {
-                trainSpeed = [currentString floatValue];
-            } else if ([elementName isEqualToString:@"rgb"]) {
-                NSArray *colour = [currentString componentsSeparatedByString:@","];
-                if ([colour count] == 3) {
-                    CGFloat r = [[colour objectAtIndex:0] intValue] & 255;
-                    CGFloat g = [[colour objectAtIndex:1] intValue] & 255;
-                    CGFloat b = [[colour objectAtIndex:2] intValue] & 255;
+            } else if (element == kPathNumberElement) {
+                assignedPath = XMLSpanIntegerValue(text);
+            } else if (element == kPartNumberElement) {
+                assignedPart = XMLSpanIntegerValue(text);
+            } else if (element == kStopTimeElement) {
+                stopLength = XMLSpanIntegerValue(text);
+            } else if (element == kJunctionTimeElement) {
+                junctionLength = XMLSpanIntegerValue(text);
+            } else if (element == kSpeedElement) {
+                trainSpeed = XMLSpanDoubleValue(text);
+            } else if (element == kRGBElement) {
+                XMLSpan colour[3];
+                if (XMLSpanSplit(text, ',', colour, 3) == 3) {
+                    CGFloat r = XMLSpanIntegerValue(colour[0]) & 255;
+                    CGFloat g = XMLSpanIntegerValue(colour[1]) & 255;
+                    CGFloat b = XMLSpanIntegerValue(colour[2]) & 255;
                     trainColour = [UIColor colorWithRed:(r / 255) green:(g / 255) blue:(b / 255) alpha:1];
                 }
             }
             break;
             
         case kMosaic:
-            if ([elementName isEqualToString:@"mosaic"]) {
+            if (element == kMosaicElement) {
                 if (mosaicStartImage == nil || mosaicEndImage == nil) {
                     mosaicDuration = 0;
                 } else {
@@ -1393,57 +1555,57 @@
                     mosaic.background.position = CGPointMake(screenWidth / 2, screenHeight / 2);
                 }
                 currentPrefs = kTopLevel;
-            } else if ([elementName isEqualToString:@"startimage"]) {
-                if ([fileManager fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:currentString]]) {
-                    mosaicStartImage = currentString;
-                }
-            } else if ([elementName isEqualToString:@"endimage"]) {
-                if ([fileManager fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:currentString]]) {
-                    mosaicEndImage = currentString;
+            } else if (element == kStartImageElement || element == kEndImageElement || element == kFinalImageElement) {
+                NSString *mosaicImage = XMLSpanString(text);
+                if (text.length == 0 || ![ScoreArchive fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:mosaicImage]]) {
+                    break;
                 }
-            } else if ([elementName isEqualToString:@"finalimage"]) {
-                if ([fileManager fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:currentString]]) {
-                    mosaicFinalImage = currentString;
+                if (element == kStartImageElement) {
+                    mosaicStartImage = mosaicImage;
+                } else if (element == kEndImageElement) {
+                    mosaicEndImage = mosaicImage;
+                } else {
+                    mosaicFinalImage = mosaicImage;
                 }
-            } else if ([elementName isEqualToString:@"duration"]) {
+            } else if (element == kDurationElement) {
                 //Only enable the mosaic if we're running to a timelimit rather than duration.
                 if (UIDelegate.clockDuration < 0) {
-                    mosaicDuration = [currentString integerValue];
+                    mosaicDuration = XMLSpanIntegerValue(text);
                 }
             }
             break;
             
         case kImage:
-            if ([elementName isEqualToString:@"background"]) {
-                if ([fileManager fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:imageName]]) {
+            if (element == kBackgroundElement) {
+                if ([ScoreArchive fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:imageName]]) {
                     UIImage *backgroundImage = [Renderer cachedImage:[score.scorePath stringByAppendingPathComponent:imageName]];
                     background = [CALayer layer];
                     background.contents = (id)backgroundImage.CGImage;
                     background.anchorPoint = CGPointZero;
                     background.frame = CGRectMake(imageOffset.x, imageOffset.y, backgroundImage.size.width, backgroundImage.size.height);
                 }
-            } else if ([elementName isEqualToString:@"fadelayer"]) {
-                if ([fileManager fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:imageName]]) {
+            } else if (element == kFadeLayerElement) {
+                if ([ScoreArchive fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:imageName]]) {
                     UIImage *fadeImage = [Renderer cachedImage:[score.scorePath stringByAppendingPathComponent:imageName]];
                     fadeLayer = [CALayer layer];
                     fadeLayer.contents = (id)fadeImage.CGImage;
                     fadeLayer.anchorPoint = CGPointZero;
                     fadeLayer.frame = CGRectMake(imageOffset.x, imageOffset.y, fadeImage.size.width, fadeImage.size.height);
                 }
-            } else if ([elementName isEqualToString:@"overlay"]) {
-                if ([fileManager fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:imageName]]) {
+            } else if (element == kOverlayElement) {
+                if ([ScoreArchive fileExistsAtPath:[score.scorePath stringByAppendingPathComponent:imageName]]) {
                     UIImage *overlayImage = [Renderer cachedImage:[score.scorePath stringByAppendingPathComponent:imageName]];
                     overlay = [CALayer layer];
                     overlay.contents = (id)overlayImage.CGImage;
                     overlay.anchorPoint = CGPointZero;
                     overlay.frame = CGRectMake(imageOffset.x, imageOffset.y, overlayImage.size.width, overlayImage.size.height);
                 }
-            } else if ([elementName isEqualToString:@"image"]) {
-                imageName = currentString;
-            } else if ([elementName isEqualToString:@"xoffset"]) {
-                imageOffset.x = [currentString floatValue];
-            } else if ([elementName isEqualToString:@"yoffset"]) {
-                imageOffset.y = [currentString floatValue];
+            } else if (element == kImageElement) {
+                imageName = text.length > 0 ? XMLSpanString(text) : nil;
+            } else if (element == kXOffsetElement) {
+                imageOffset.x = XMLSpanDoubleValue(text);
+            } else if (element == kYOffsetElement) {
+                imageOffset.y = XMLSpanDoubleValue(text);
             }
             break;
             
@@ -1454,7 +1616,7 @@
     isData = NO;
 }
 
-- (void)parserDidEndDocument:(NSXMLParser *)parser
+- (void)finishLoadingPaths
 {
     pathsLoaded = YES;
     BOOL traversable = YES;
@@ -1485,20 +1647,15 @@
     //Since we deal with the mosaic every half second, time the duration by 2.
     mosaicDuration *= 2;
     
-    parser.delegate = nil;
-    xmlParser = nil;
-    
     [pathsCondition lock];
     pathsLoaded = YES;
     [pathsCondition signal];
     [pathsCondition unlock];
 }
 
-- (void)parser:(NSXMLParser *)parser parseErrorOccurred:(NSError *)parseError
+- (void)failLoadingPaths
 {
     badPaths = YES;
-    parser.delegate = nil;
-    xmlParser = nil;
     [pathsCondition lock];
     pathsLoaded = YES;
     [pathsCondition signal];
@@ -7,9 +7,14 @@
 //
 
 #import "UpdateViewController.h"
+#import "ScoreUpdater.h"
 
 @interface UpdateViewController ()
 
+- (void)downloadNextUpdate;
+- (void)downloadArchiveForCurrentUpdate;
+- (void)finishedCurrentUpdate;
+
 @end
 
 @implementation UpdateViewController {
@@ -21,6 +26,11 @@
     __block NSInteger headersDownloaded;
     NSInteger currentDownload;
     NSInteger failCount;
+    BOOL cancelled;
+    
+    //Scores that have a manifest are updated a file at a time.
+    ScoreUpdater *currentUpdater;
+    NSMutableArray *updatedScores;
     
     NSFileManager *fileManager;
     
@@ -97,12 +107,20 @@
                     //If we have multiple lines in our response we should only pay attention to the first one.
                     rawString = [[rawString componentsSeparatedByString:@"\n"] objectAtIndex:0];
                     NSArray *components = [rawString componentsSeparatedByString:@","];
-                    if ([components count] == 2) {
+                    //An optional third component is the address of an update manifest (see ScoreUpdate.h).
+                    if ([components count] == 2 || [components count] == 3) {
                         //Check the reported version number against the current version number and check that our URL is vaugely sane.
                         NSURLRequest *request = [NSURLRequest requestWithURL:[NSURL URLWithString:[components objectAtIndex:0]]];
                         if ([NSURLConnection canHandleRequest:request]) {
                             if ([[components objectAtIndex:1] caseInsensitiveCompare:[[self->updateAddresses objectForKey:[scoreDirectories objectAtIndex:self->headersDownloaded]] objectAtIndex:1]] == NSOrderedDescending) {
-                                [self->availableUpdates addObject:[NSArray arrayWithObjects:[[scoreDirectories objectAtIndex:self->headersDownloaded] lastPathComponent], [components objectAtIndex:0], [components objectAtIndex:1], [[self->updateAddresses objectForKey:[scoreDirectories objectAtIndex:self->headersDownloaded]] objectAtIndex:1], nil]];
+                                NSMutableArray *update = [NSMutableArray arrayWithObjects:[[scoreDirectories objectAtIndex:self->headersDownloaded] lastPathComponent], [components objectAtIndex:0], [components objectAtIndex:1], [[self->updateAddresses objectForKey:[scoreDirectories objectAtIndex:self->headersDownloaded]] objectAtIndex:1], [scoreDirectories objectAtIndex:self->headersDownloaded], nil];
+                                if ([components count] == 3) {
+                                    NSURL *manifestURL = [NSURL URLWithString:[components objectAtIndex:2]];
+                                    if (manifestURL != nil && [NSURLConnection canHandleRequest:[NSURLRequest requestWithURL:manifestURL]]) {
+                                        [update addObject:manifestURL];
+                                    }
+                                }
+                                [self->availableUpdates addObject:update];
                             }
                         }
                     }
@@ -167,19 +185,105 @@
     }
     currentDownload = 0;
     failCount = 0;
-    statusLabel.text = [NSString stringWithFormat:@"Downloading %@", [[selectedUpdates objectAtIndex:0] objectAtIndex:0]];
-    
-    //Create our initial download task
-    NSURLSessionDownloadTask *currentTask = [downloadSession downloadTaskWithURL:[NSURL URLWithString:[[selectedUpdates objectAtIndex:0] objectAtIndex:1]]];
-    [currentTask resume];
+    updatedScores = [[NSMutableArray alloc] init];
+    [self downloadNextUpdate];
 }
 
 - (IBAction)cancel
 {
+    cancelled = YES;
+    [currentUpdater cancel];
     [downloadSession invalidateAndCancel];
     [self dismissViewControllerAnimated:YES completion:nil];
 }
 
+#pragma mark - Private methods
+
+- (void)downloadNextUpdate
+{
+    //Update the user interface before starting on the next score.
+    dispatch_async(dispatch_get_main_queue(), ^{
+        self->updateProgress.progress = (CGFloat)self->currentDownload / [self->selectedUpdates count];
+        self->statusLabel.text = [NSString stringWithFormat:@"Downloading %@", [[self->selectedUpdates objectAtIndex:self->currentDownload] objectAtIndex:0]];
+    });
+    
+    NSArray *update = [selectedUpdates objectAtIndex:currentDownload];
+    if ([update count] < 6 || updateDirectory == nil) {
+        [self downloadArchiveForCurrentUpdate];
+        return;
+    }
+    
+    //Only fetch what's changed. If that doesn't work out for any reason, the whole archive is downloaded instead.
+    NSString *scorePath = [update objectAtIndex:4];
+    currentUpdater = [[ScoreUpdater alloc] initWithScorePath:scorePath manifestURL:[update objectAtIndex:5] workingDirectory:updateDirectory];
+    NSInteger updateIndex = currentDownload;
+    currentUpdater.progressHandler = ^(ScoreUpdater *updater) {
+        if (updater.downloadBytes > 0) {
+            CGFloat progress = (CGFloat)updater.receivedBytes / (updater.downloadBytes * [self->selectedUpdates count]);
+            self->updateProgress.progress = progress + (CGFloat)updateIndex / [self->selectedUpdates count];
+        }
+    };
+    [currentUpdater updateWithCompletionHandler:^(BOOL success) {
+        if (self->cancelled) {
+            return;
+        }
+        if (success) {
+            [self->updatedScores addObject:scorePath];
+            [self finishedCurrentUpdate];
+        } else {
+            [self downloadArchiveForCurrentUpdate];
+        }
+    }];
+}
+
+- (void)downloadArchiveForCurrentUpdate
+{
+    NSURLSessionDownloadTask *currentTask = [downloadSession downloadTaskWithURL:[NSURL URLWithString:[[selectedUpdates objectAtIndex:currentDownload] objectAtIndex:1]]];
+    [currentTask resume];
+}
+
+- (void)finishedCurrentUpdate
+{
+    currentDownload++;
+    if (currentDownload < [selectedUpdates count]) {
+        [self downloadNextUpdate];
+        return;
+    }
+    
+    //We are done here.
+    for (int i = 0; i < [selectedUpdates count]; i++) {
+        [availableUpdates removeObjectIdenticalTo:[selectedUpdates objectAtIndex:i]];
+    }
+    
+    if (failCount > 0) {
+        UIAlertController *updateErrorAlert = [UIAlertController alertControllerWithTitle:@"Update Error" message:@"Some files did not download successfully." preferredStyle:UIAlertControllerStyleAlert];
+        UIAlertAction *okAction = [UIAlertAction actionWithTitle:@"OK" style:UIAlertActionStyleDefault handler:^(UIAlertAction *action) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                self->statusLabel.text = @"";
+                self->cancelButton.title = @"Close";
+                [self->availableUpdatesTable reloadData];
+            });
+        }];
+        [updateErrorAlert addAction:okAction];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            self->updateProgress.progress = 1;
+            [self presentViewController:updateErrorAlert animated:YES completion:nil];
+        });
+    } else {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            self->updateProgress.progress = 1;
+            self->statusLabel.text = @"Finished Downloading";
+            self->cancelButton.title = @"Close";
+            [self->availableUpdatesTable reloadData];
+        });
+    }
+    
+    if ([updatedScores count] > 0 && [updateDelegate respondsToSelector:@selector(updatedScoresAtPaths:)]) {
+        [updateDelegate updatedScoresAtPaths:updatedScores];
+    }
+    [updateDelegate downloadedUpdatesToDirectory:updateDirectory];
+}
+
 #pragma mark - Table view data source
 
 - (NSInteger)numberOfSectionsInTableView:(UITableView *)tableView
@@ -250,48 +354,7 @@
         [fileManager moveItemAtPath:location.path toPath:[[updateDirectory stringByAppendingPathComponent:[[selectedUpdates objectAtIndex:currentDownload] objectAtIndex:0]] stringByAppendingPathExtension:@"dsz"] error:nil];
     }
     
-    currentDownload++;
-    if (currentDownload < [selectedUpdates count]) {
-        //Cue up the next download after updating the user interface.
-        dispatch_async(dispatch_get_main_queue(), ^{
-            self->updateProgress.progress = (CGFloat)self->currentDownload / [self->selectedUpdates count];;
-            self->statusLabel.text = [NSString stringWithFormat:@"Downloading %@", [[self->selectedUpdates objectAtIndex:self->currentDownload] objectAtIndex:0]];
-        });
-        
-        NSURLSessionDownloadTask *currentTask = [downloadSession downloadTaskWithURL:[NSURL URLWithString:[[selectedUpdates objectAtIndex:currentDownload] objectAtIndex:1]]];
-        [currentTask resume];
-    } else {
-        //We are done here.
-        for (int i = 0; i < [selectedUpdates count]; i++) {
-            [availableUpdates removeObjectIdenticalTo:[selectedUpdates objectAtIndex:i]];
-        }
-        
-        if (failCount > 0) {
-            UIAlertController *updateErrorAlert = [UIAlertController alertControllerWithTitle:@"Update Error" message:@"Some files did not download successfully." preferredStyle:UIAlertControllerStyleAlert];
-            UIAlertAction *okAction = [UIAlertAction actionWithTitle:@"OK" style:UIAlertActionStyleDefault handler:^(UIAlertAction *action) {
-                dispatch_async(dispatch_get_main_queue(), ^{
-                    self->statusLabel.text = @"";
-                    self->cancelButton.title = @"Close";
-                    [self->availableUpdatesTable reloadData];
-                });
-            }];
-            [updateErrorAlert addAction:okAction];
-            dispatch_async(dispatch_get_main_queue(), ^{
-                self->updateProgress.progress = 1;
-                [self presentViewController:updateErrorAlert animated:YES completion:nil];
-            });
-        } else {
-            dispatch_async(dispatch_get_main_queue(), ^{
-                self->updateProgress.progress = 1;
-                self->statusLabel.text = @"Finished Downloading";
-                self->cancelButton.title = @"Close";
-                [self->availableUpdatesTable reloadData];
-            });
-        }
-        
-        [updateDelegate downloadedUpdatesToDirectory:updateDirectory];
-    }
-    
+    [self finishedCurrentUpdate];
 }
 
 - (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)downloadTask didWriteData:(int64_t)bytesWritten totalBytesWritten:(int64_t)totalBytesWritten totalBytesExpectedToWrite:(int64_t)totalBytesExpectedToWrite
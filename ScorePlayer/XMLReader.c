@@ -0,0 +1,567 @@
+//
+//  XMLReader.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "XMLReader.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define XML_NUMBER_LENGTH 64
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool isNameCharacter(char c)
+{
+    return !isSpace(c) && c != '>' && c != '/' && c != '=' && c != '<' && c != '\0';
+}
+
+static char lowerCase(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static const char *findString(const char *start, const char *end, const char *string, size_t length)
+{
+    //Returns the position of the string, or NULL if it isn't there.
+    while (start + length <= end) {
+        const char *candidate = memchr(start, string[0], end - start);
+        if (candidate == NULL || candidate + length > end) {
+            return NULL;
+        }
+        if (memcmp(candidate, string, length) == 0) {
+            return candidate;
+        }
+        start = candidate + 1;
+    }
+    return NULL;
+}
+
+static XMLEvent fail(XMLReader *reader, size_t position)
+{
+    reader->errorPosition = position;
+    reader->position = reader->length;
+    reader->finished = true;
+    reader->depth = SIZE_MAX;
+    return kXMLError;
+}
+
+void XMLReaderInit(XMLReader *reader, const void *bytes, size_t length)
+{
+    memset(reader, 0, sizeof(XMLReader));
+    reader->bytes = bytes;
+    reader->length = length;
+    //Skip a UTF-8 byte order mark.
+    if (length >= 3 && memcmp(bytes, "\xEF\xBB\xBF", 3) == 0) {
+        reader->position = 3;
+    }
+}
+
+static bool skipMarkup(XMLReader *reader, const char *start, const char *end)
+{
+    //Skips a comment, processing instruction or DOCTYPE starting at start. Returns false if
+    //it isn't terminated.
+    const char *close;
+    if (end - start >= 4 && memcmp(start, "<!--", 4) == 0) {
+        close = findString(start + 4, end, "-->", 3);
+        if (close == NULL) {
+            return false;
+        }
+        reader->position = close + 3 - reader->bytes;
+    } else if (start[1] == '?') {
+        close = findString(start + 2, end, "?>", 2);
+        if (close == NULL) {
+            return false;
+        }
+        reader->position = close + 2 - reader->bytes;
+    } else {
+        //A DOCTYPE, which may have an internal subset in square brackets.
+        int brackets = 0;
+        for (close = start + 2; close < end; close++) {
+            if (*close == '[') {
+                brackets++;
+            } else if (*close == ']') {
+                brackets--;
+            } else if (*close == '>' && brackets <= 0) {
+                break;
+            }
+        }
+        if (close == end) {
+            return false;
+        }
+        reader->position = close + 1 - reader->bytes;
+    }
+    return true;
+}
+
+XMLEvent XMLReaderNext(XMLReader *reader)
+{
+    if (reader->finished) {
+        return reader->depth == SIZE_MAX ? kXMLError : kXMLEndDocument;
+    }
+    if (reader->closePending) {
+        reader->closePending = false;
+        reader->depth--;
+        reader->attributes.bytes = NULL;
+        reader->attributes.length = 0;
+        return kXMLEndElement;
+    }
+
+    const char *end = reader->bytes + reader->length;
+    while (reader->position < reader->length) {
+        const char *start = reader->bytes + reader->position;
+
+        if (*start != '<') {
+            //Character data runs up to the next tag. Whitespace outside the root element is ignored.
+            const char *tag = memchr(start, '<', end - start);
+            if (tag == NULL) {
+                tag = end;
+            }
+            reader->position = tag - reader->bytes;
+            if (reader->depth == 0) {
+                for (const char *c = start; c < tag; c++) {
+                    if (!isSpace(*c)) {
+                        return fail(reader, c - reader->bytes);
+                    }
+                }
+                continue;
+            }
+            reader->text.bytes = start;
+            reader->text.length = tag - start;
+            reader->textHasReferences = memchr(start, '&', tag - start) != NULL;
+            return kXMLText;
+        }
+
+        if (end - start >= 9 && memcmp(start, "<![CDATA[", 9) == 0) {
+            const char *close = findString(start + 9, end, "]]>", 3);
+            if (close == NULL || reader->depth == 0) {
+                return fail(reader, reader->position);
+            }
+            reader->position = close + 3 - reader->bytes;
+            reader->text.bytes = start + 9;
+            reader->text.length = close - (start + 9);
+            reader->textHasReferences = false;
+            return kXMLText;
+        }
+
+        if (end - start >= 2 && (start[1] == '!' || start[1] == '?')) {
+            if (!skipMarkup(reader, start, end)) {
+                return fail(reader, reader->position);
+            }
+            continue;
+        }
+
+        //An element tag. Find the end of it, allowing for '>' inside quoted attribute values.
+        bool isEndTag = end - start >= 2 && start[1] == '/';
+        const char *nameStart = start + (isEndTag ? 2 : 1);
+        const char *nameEnd = nameStart;
+        while (nameEnd < end && isNameCharacter(*nameEnd)) {
+            nameEnd++;
+        }
+        const char *close = nameEnd;
+        char quote = 0;
+        while (close < end && (quote != 0 || *close != '>')) {
+            if (quote != 0) {
+                if (*close == quote) {
+                    quote = 0;
+                }
+            } else if (*close == '"' || *close == '\'') {
+                quote = *close;
+            }
+            close++;
+        }
+        if (close == end || nameEnd == nameStart) {
+            return fail(reader, reader->position);
+        }
+        reader->position = close + 1 - reader->bytes;
+        reader->name.bytes = nameStart;
+        reader->name.length = nameEnd - nameStart;
+
+        if (isEndTag) {
+            //Check that it matches the element that's open.
+            for (const char *c = nameEnd; c < close; c++) {
+                if (!isSpace(*c)) {
+                    return fail(reader, c - reader->bytes);
+                }
+            }
+            size_t level = reader->depth - 1;
+            if (reader->depth == 0 || reader->openLengths[level] != reader->name.length || memcmp(reader->bytes + reader->openNames[level], nameStart, reader->name.length) != 0) {
+                return fail(reader, nameStart - reader->bytes);
+            }
+            reader->depth--;
+            reader->attributes.bytes = NULL;
+            reader->attributes.length = 0;
+            return kXMLEndElement;
+        }
+
+        if (reader->depth == XML_READER_MAX_DEPTH || (reader->depth == 0 && reader->openLengths[0] != 0)) {
+            //Too deep, or a second root element.
+            return fail(reader, nameStart - reader->bytes);
+        }
+        bool isEmpty = close > nameEnd && close[-1] == '/';
+        reader->attributes.bytes = nameEnd;
+        reader->attributes.length = (close - (isEmpty ? 1 : 0)) - nameEnd;
+        reader->openNames[reader->depth] = (uint32_t)(nameStart - reader->bytes);
+        reader->openLengths[reader->depth] = (uint32_t)reader->name.length;
+        reader->depth++;
+        reader->closePending = isEmpty;
+        return kXMLStartElement;
+    }
+
+    //Only a complete document ends cleanly.
+    if (reader->depth != 0 || reader->openLengths[0] == 0) {
+        return fail(reader, reader->length);
+    }
+    reader->finished = true;
+    return kXMLEndDocument;
+}
+
+#pragma mark - Text
+
+static size_t encodeCharacter(uint32_t code, char *output)
+{
+    if (code < 0x80) {
+        output[0] = (char)code;
+        return 1;
+    } else if (code < 0x800) {
+        output[0] = (char)(0xC0 | (code >> 6));
+        output[1] = (char)(0x80 | (code & 0x3F));
+        return 2;
+    } else if (code < 0x10000) {
+        output[0] = (char)(0xE0 | (code >> 12));
+        output[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        output[2] = (char)(0x80 | (code & 0x3F));
+        return 3;
+    } else if (code < 0x110000) {
+        output[0] = (char)(0xF0 | (code >> 18));
+        output[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+        output[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+        output[3] = (char)(0x80 | (code & 0x3F));
+        return 4;
+    }
+    return 0;
+}
+
+static size_t decodeText(const char *input, size_t length, char *output)
+{
+    //Expands references. The output is never longer than the input, since no character takes
+    //more bytes in UTF-8 than its reference does. Anything that isn't a reference we recognise
+    //is copied through as is.
+    size_t count = 0;
+    size_t i = 0;
+    while (i < length) {
+        if (input[i] != '&') {
+            output[count++] = input[i++];
+            continue;
+        }
+        const char *semicolon = memchr(input + i, ';', length - i);
+        if (semicolon == NULL) {
+            output[count++] = input[i++];
+            continue;
+        }
+        const char *reference = input + i + 1;
+        size_t referenceLength = semicolon - reference;
+        size_t written = 0;
+        if (referenceLength == 2 && memcmp(reference, "lt", 2) == 0) {
+            output[count] = '<';
+            written = 1;
+        } else if (referenceLength == 2 && memcmp(reference, "gt", 2) == 0) {
+            output[count] = '>';
+            written = 1;
+        } else if (referenceLength == 3 && memcmp(reference, "amp", 3) == 0) {
+            output[count] = '&';
+            written = 1;
+        } else if (referenceLength == 4 && memcmp(reference, "quot", 4) == 0) {
+            output[count] = '"';
+            written = 1;
+        } else if (referenceLength == 4 && memcmp(reference, "apos", 4) == 0) {
+            output[count] = '\'';
+            written = 1;
+        } else if (referenceLength >= 2 && referenceLength <= 9 && reference[0] == '#') {
+            bool hex = reference[1] == 'x' || reference[1] == 'X';
+            uint32_t code = 0;
+            bool valid = referenceLength > (hex ? 2 : 1);
+            for (size_t j = hex ? 2 : 1; j < referenceLength && valid; j++) {
+                char c = lowerCase(reference[j]);
+                if (c >= '0' && c <= '9') {
+                    code = code * (hex ? 16 : 10) + (c - '0');
+                } else if (hex && c >= 'a' && c <= 'f') {
+                    code = code * 16 + (c - 'a' + 10);
+                } else {
+                    valid = false;
+                }
+            }
+            if (valid && code != 0) {
+                written = encodeCharacter(code, output + count);
+            }
+        }
+
+        if (written == 0) {
+            output[count++] = input[i++];
+        } else {
+            count += written;
+            i = semicolon + 1 - input;
+        }
+    }
+    return count;
+}
+
+void XMLTextInit(XMLText *text)
+{
+    memset(text, 0, sizeof(XMLText));
+}
+
+void XMLTextReset(XMLText *text)
+{
+    text->span.bytes = NULL;
+    text->span.length = 0;
+}
+
+bool XMLTextAppend(XMLText *text, const XMLReader *reader)
+{
+    if (text->span.length == 0 && !reader->textHasReferences) {
+        text->span = reader->text;
+        return true;
+    }
+
+    //Move into the buffer.
+    size_t needed = text->span.length + reader->text.length;
+    if (needed > text->capacity) {
+        size_t capacity = text->capacity > 0 ? text->capacity : 256;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        char *buffer = malloc(capacity);
+        if (buffer == NULL) {
+            return false;
+        }
+        if (text->span.length > 0) {
+            memcpy(buffer, text->span.bytes, text->span.length);
+        }
+        free(text->buffer);
+        text->buffer = buffer;
+        text->capacity = capacity;
+    } else if (text->span.length > 0 && text->span.bytes != text->buffer) {
+        memmove(text->buffer, text->span.bytes, text->span.length);
+    }
+    size_t added;
+    if (reader->textHasReferences) {
+        added = decodeText(reader->text.bytes, reader->text.length, text->buffer + text->span.length);
+    } else {
+        memcpy(text->buffer + text->span.length, reader->text.bytes, reader->text.length);
+        added = reader->text.length;
+    }
+    text->span.bytes = text->buffer;
+    text->span.length += added;
+    return true;
+}
+
+void XMLTextRelease(XMLText *text)
+{
+    free(text->buffer);
+    memset(text, 0, sizeof(XMLText));
+}
+
+#pragma mark - Name tables
+
+static uint32_t hashName(const char *name, size_t length)
+{
+    //FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool XMLNameTableInit(XMLNameTable *table, const XMLName *names, size_t count)
+{
+    memset(table, 0, sizeof(XMLNameTable));
+    if (count > XML_NAME_TABLE_SLOTS / 2) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        size_t length = strlen(names[i].name);
+        uint32_t hash = hashName(names[i].name, length);
+        size_t slot = hash & (XML_NAME_TABLE_SLOTS - 1);
+        while (table->names[slot] != NULL) {
+            slot = (slot + 1) & (XML_NAME_TABLE_SLOTS - 1);
+        }
+        table->names[slot] = names[i].name;
+        table->lengths[slot] = (uint32_t)length;
+        table->hashes[slot] = hash;
+        table->identifiers[slot] = names[i].identifier;
+    }
+    return true;
+}
+
+int XMLNameTableLookup(const XMLNameTable *table, XMLSpan name)
+{
+    uint32_t hash = hashName(name.bytes, name.length);
+    size_t slot = hash & (XML_NAME_TABLE_SLOTS - 1);
+    while (table->names[slot] != NULL) {
+        if (table->hashes[slot] == hash && table->lengths[slot] == name.length && memcmp(table->names[slot], name.bytes, name.length) == 0) {
+            return table->identifiers[slot];
+        }
+        slot = (slot + 1) & (XML_NAME_TABLE_SLOTS - 1);
+    }
+    return -1;
+}
+
+#pragma mark - Conversions
+
+bool XMLSpanEquals(XMLSpan span, const char *string)
+{
+    size_t length = strlen(string);
+    return span.length == length && memcmp(span.bytes, string, length) == 0;
+}
+
+bool XMLSpanEqualsIgnoringCase(XMLSpan span, const char *string)
+{
+    size_t length = strlen(string);
+    if (span.length != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (lowerCase(span.bytes[i]) != lowerCase(string[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t copyNumber(XMLSpan span, char *number)
+{
+    //Copies the start of the span (without leading whitespace) so that it can be handed to
+    //the C library, which expects a terminated string.
+    size_t start = 0;
+    while (start < span.length && isSpace(span.bytes[start])) {
+        start++;
+    }
+    size_t length = span.length - start;
+    if (length > XML_NUMBER_LENGTH - 1) {
+        length = XML_NUMBER_LENGTH - 1;
+    }
+    memcpy(number, span.bytes + start, length);
+    number[length] = '\0';
+    return length;
+}
+
+long XMLSpanIntegerValue(XMLSpan span)
+{
+    size_t i = 0;
+    while (i < span.length && isSpace(span.bytes[i])) {
+        i++;
+    }
+    bool negative = i < span.length && span.bytes[i] == '-';
+    if (i < span.length && (span.bytes[i] == '-' || span.bytes[i] == '+')) {
+        i++;
+    }
+    long value = 0;
+    size_t digits = 0;
+    while (i < span.length && span.bytes[i] >= '0' && span.bytes[i] <= '9') {
+        if (++digits > 18) {
+            //Leave anything that might overflow to the C library.
+            char number[XML_NUMBER_LENGTH];
+            copyNumber(span, number);
+            return strtol(number, NULL, 10);
+        }
+        value = value * 10 + (span.bytes[i] - '0');
+        i++;
+    }
+    return negative ? -value : value;
+}
+
+double XMLSpanDoubleValue(XMLSpan span)
+{
+    //Coordinate lists are mostly short decimals, which can be converted exactly by dividing
+    //the digits (as an integer) by a power of ten, as long as both fit in a double without
+    //rounding. Anything else goes to strtod.
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    size_t i = 0;
+    while (i < span.length && isSpace(span.bytes[i])) {
+        i++;
+    }
+    bool negative = i < span.length && span.bytes[i] == '-';
+    if (i < span.length && (span.bytes[i] == '-' || span.bytes[i] == '+')) {
+        i++;
+    }
+    uint64_t mantissa = 0;
+    size_t digits = 0;
+    size_t fractionDigits = 0;
+    bool isFraction = false;
+    for (; i < span.length; i++) {
+        char c = span.bytes[i];
+        if (c >= '0' && c <= '9') {
+            mantissa = mantissa * 10 + (c - '0');
+            digits++;
+            if (isFraction) {
+                fractionDigits++;
+            }
+        } else if (c == '.' && !isFraction) {
+            isFraction = true;
+        } else {
+            break;
+        }
+        if (digits > 15) {
+            break;
+        }
+    }
+    bool hasMore = i < span.length && ((span.bytes[i] >= '0' && span.bytes[i] <= '9') || span.bytes[i] == 'e' || span.bytes[i] == 'E');
+    if (hasMore || digits > 15 || fractionDigits > 22) {
+        char number[XML_NUMBER_LENGTH];
+        copyNumber(span, number);
+        return strtod(number, NULL);
+    }
+    double value = (double)mantissa / powers[fractionDigits];
+    return negative ? -value : value;
+}
+
+bool XMLSpanBoolValue(XMLSpan span)
+{
+    size_t i = 0;
+    while (i < span.length && isSpace(span.bytes[i])) {
+        i++;
+    }
+    if (i < span.length && (span.bytes[i] == '+' || span.bytes[i] == '-')) {
+        i++;
+    }
+    while (i < span.length && span.bytes[i] == '0') {
+        i++;
+    }
+    if (i == span.length) {
+        return false;
+    }
+    char c = span.bytes[i];
+    return c == 'Y' || c == 'y' || c == 'T' || c == 't' || (c >= '1' && c <= '9');
+}
+
+size_t XMLSpanSplit(XMLSpan span, char separator, XMLSpan *fields, size_t capacity)
+{
+    if (span.length == 0) {
+        return 0;
+    }
+    size_t count = 0;
+    const char *start = span.bytes;
+    const char *end = span.bytes + span.length;
+    while (true) {
+        const char *next = memchr(start, separator, end - start);
+        const char *fieldEnd = next == NULL ? end : next;
+        if (count < capacity) {
+            fields[count].bytes = start;
+            fields[count].length = fieldEnd - start;
+        }
+        count++;
+        if (next == NULL) {
+            return count;
+        }
+        start = next + 1;
+    }
+}
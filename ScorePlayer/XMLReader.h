@@ -0,0 +1,122 @@
+//
+//  XMLReader.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//A pull reader for the XML used by opus and preference files. It walks a buffer (normally a
+//memory mapped file) and reports elements and text as spans into that buffer, without
+//allocating or copying. The XML declaration, comments, processing instructions and the
+//DOCTYPE are skipped. Attributes aren't parsed, since none of our formats use them, but their
+//raw text is available. Start and end tags are checked against each other, so a malformed
+//file is reported as an error just as it would be by NSXMLParser.
+//The buffer must stay alive (and unchanged) for as long as any spans from it are in use.
+
+#ifndef XMLReader_h
+#define XMLReader_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define XML_READER_MAX_DEPTH 32
+#define XML_NAME_TABLE_SLOTS 128
+
+typedef struct {
+    const char *bytes;
+    size_t length;
+} XMLSpan;
+
+typedef enum {
+    kXMLStartElement,
+    kXMLEndElement,
+    kXMLText,
+    kXMLEndDocument,
+    kXMLError
+} XMLEvent;
+
+typedef struct {
+    const char *bytes;
+    size_t length;
+    size_t position;
+
+    //Details of the current event. Empty element tags (<a/>) are reported as a start
+    //followed by an end.
+    XMLSpan name;
+    XMLSpan attributes;
+    XMLSpan text;
+    //Set if the text may contain entity or character references. (Never set for CDATA.)
+    bool textHasReferences;
+    size_t depth;
+    //Where in the buffer things went wrong, once an error has been returned.
+    size_t errorPosition;
+
+    bool closePending;
+    bool finished;
+    uint32_t openNames[XML_READER_MAX_DEPTH];
+    uint32_t openLengths[XML_READER_MAX_DEPTH];
+} XMLReader;
+
+void XMLReaderInit(XMLReader *reader, const void *bytes, size_t length);
+//Once the end of the document or an error has been reached, the same event keeps being returned.
+XMLEvent XMLReaderNext(XMLReader *reader);
+
+//Gathers the text content of an element. A single run of text without any references (which
+//is almost always what we have) is kept as a span into the document. Anything else is decoded
+//into a buffer that is allocated on demand and reused after each reset.
+typedef struct {
+    XMLSpan span;
+    char *buffer;
+    size_t capacity;
+} XMLText;
+
+void XMLTextInit(XMLText *text);
+void XMLTextReset(XMLText *text);
+//Adds the text of the reader's current text event. Returns false if memory runs out.
+bool XMLTextAppend(XMLText *text, const XMLReader *reader);
+void XMLTextRelease(XMLText *text);
+
+//Maps element names onto identifiers. Each format declares its names once in a static array
+//and builds a table from it, after which a lookup is a hash and (almost always) one compare.
+typedef struct {
+    const char *name;
+    int identifier;
+} XMLName;
+
+typedef struct {
+    const char *names[XML_NAME_TABLE_SLOTS];
+    uint32_t lengths[XML_NAME_TABLE_SLOTS];
+    uint32_t hashes[XML_NAME_TABLE_SLOTS];
+    int identifiers[XML_NAME_TABLE_SLOTS];
+} XMLNameTable;
+
+//Returns false if there are too many names. (The table is kept at most half full.)
+bool XMLNameTableInit(XMLNameTable *table, const XMLName *names, size_t count);
+//Returns -1 for names that aren't in the table.
+int XMLNameTableLookup(const XMLNameTable *table, XMLSpan name);
+
+//Conversions for element text. The numeric ones behave like their NSString counterparts:
+//leading whitespace is skipped, parsing stops at the first character that doesn't fit, and
+//0 is returned if there's no number at all.
+bool XMLSpanEquals(XMLSpan span, const char *string);
+bool XMLSpanEqualsIgnoringCase(XMLSpan span, const char *string);
+long XMLSpanIntegerValue(XMLSpan span);
+double XMLSpanDoubleValue(XMLSpan span);
+//As for NSString boolValue: true for a leading Y, y, T, t or non zero digit.
+bool XMLSpanBoolValue(XMLSpan span);
+//Splits a span on a separator. Returns the number of fields, even if that's more than the
+//capacity of the fields array. (An empty span has no fields.)
+size_t XMLSpanSplit(XMLSpan span, char separator, XMLSpan *fields, size_t capacity);
+
+#ifdef __OBJC__
+#import <Foundation/Foundation.h>
+
+static inline NSString *XMLSpanString(XMLSpan span)
+{
+    return [[NSString alloc] initWithBytes:span.bytes length:span.length encoding:NSUTF8StringEncoding];
+}
+#endif
+
+#endif /* XMLReader_h */
@@ -0,0 +1,727 @@
+//
+//  ZipCompress.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ZipCompress.h"
+#include "SSZipArchive/minizip/mz.h"
+#include "SSZipArchive/minizip/mz_crypt.h"
+#include "SSZipArchive/minizip/mz_os.h"
+#include "SSZipArchive/minizip/mz_strm.h"
+#include "SSZipArchive/minizip/mz_strm_os.h"
+#include "SSZipArchive/minizip/mz_strm_readahead.h"
+#include "SSZipArchive/minizip/mz_zip.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+//Files up to this size are read and compressed in memory. Bigger ones are streamed.
+#define ZIP_COMPRESS_MEMORY_LIMIT (8 * 1024 * 1024)
+#define ZIP_COMPRESS_BUFFER_LENGTH (256 * 1024)
+#define ZIP_COMPRESS_DEFAULT_BUDGET (64 * 1024 * 1024)
+
+//Extensions of files that are already compressed.
+static const char *const STORED_EXTENSIONS[] = {"png", "jpg", "jpeg", "gif", "heic", "m4a", "mp3", "aac", "mp4", "m4v", "mov", "zip", "dsz", "gz", NULL};
+
+typedef enum {
+    ZipEntryPending,
+    ZipEntryReady,
+    ZipEntryWritten
+} ZipEntryState;
+
+typedef struct {
+    //The name in the archive. Directories end in a slash.
+    char *name;
+    char *path;
+    bool isDirectory;
+    bool store;
+    uint32_t mode;
+    time_t modified;
+
+    //Filled in once the entry has been compressed.
+    ZipEntryState state;
+    uint16_t method;
+    uint32_t crc;
+    uint64_t uncompressedSize;
+    uint64_t compressedSize;
+    //The compressed data, if it's in memory.
+    uint8_t *data;
+    //Otherwise it's in this file (the source itself if the entry is stored).
+    int fd;
+} ZipCompressEntry;
+
+struct ZipCompression {
+    char *archivePath;
+    int level;
+    char *temporaryDirectory;
+    size_t memoryBudget;
+    void *stream;
+    //Writes the archive out on a thread of its own, so the writer never waits on the disk.
+    void *writeBehindStream;
+    void *zip;
+
+    ZipCompressEntry *entries;
+    size_t entryCount;
+    size_t entryCapacity;
+    uint64_t totalBytes;
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    size_t nextCompress;
+    size_t nextWrite;
+    size_t bufferedBytes;
+    bool writing;
+    bool failed;
+    bool finished;
+    bool succeeded;
+
+    atomic_uint_least64_t compressedBytes;
+    atomic_size_t writtenEntries;
+};
+
+static bool listDirectory(ZipCompression *compression, const char *path, const char *name, const ZipCompressionOptions *options, dev_t archiveDevice, ino_t archiveInode);
+static bool addEntry(ZipCompression *compression, const ZipCompressEntry *entry);
+static bool isExcluded(const char *name, const ZipCompressionOptions *options);
+static bool hasStoredExtension(const char *name);
+static char *joinPath(const char *directory, const char *name, const char *suffix);
+static bool readAll(int fd, uint8_t *bytes, size_t length, size_t *bytesRead);
+static bool writeAll(int fd, const uint8_t *bytes, size_t length);
+static bool compressEntry(ZipCompression *compression, ZipCompressEntry *entry);
+static bool compressInMemory(ZipCompression *compression, ZipCompressEntry *entry, int fd);
+static bool compressToFile(ZipCompression *compression, ZipCompressEntry *entry, int fd);
+static bool writeEntry(ZipCompression *compression, ZipCompressEntry *entry);
+static void releaseEntry(ZipCompressEntry *entry);
+static int compareNames(const void *a, const void *b);
+
+#pragma mark - Public functions
+
+void ZipCompressionOptionsInit(ZipCompressionOptions *options)
+{
+    options->level = Z_DEFAULT_COMPRESSION;
+    options->storeCompressedFiles = true;
+    options->excludedNames = NULL;
+    options->temporaryDirectory = NULL;
+    options->memoryBudget = 0;
+}
+
+ZipCompression *ZipCompressionOpen(const char *directory, const char *archivePath, const ZipCompressionOptions *options)
+{
+    ZipCompression *compression = calloc(1, sizeof(ZipCompression));
+    if (compression == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&compression->lock, NULL);
+    pthread_cond_init(&compression->changed, NULL);
+    atomic_init(&compression->compressedBytes, 0);
+    atomic_init(&compression->writtenEntries, 0);
+    compression->level = options->level;
+    compression->memoryBudget = options->memoryBudget > 0 ? options->memoryBudget : ZIP_COMPRESS_DEFAULT_BUDGET;
+    compression->archivePath = strdup(archivePath);
+    const char *temporaryDirectory = options->temporaryDirectory;
+    if (temporaryDirectory == NULL) {
+        temporaryDirectory = getenv("TMPDIR") != NULL ? getenv("TMPDIR") : "/tmp";
+    }
+    compression->temporaryDirectory = strdup(temporaryDirectory);
+    if (compression->archivePath == NULL || compression->temporaryDirectory == NULL) {
+        compression->failed = true;
+        ZipCompressionClose(compression);
+        return NULL;
+    }
+
+    mz_stream_os_create(&compression->stream);
+    mz_stream_readahead_create(&compression->writeBehindStream);
+    mz_zip_create(&compression->zip);
+    if (compression->stream == NULL || compression->writeBehindStream == NULL || compression->zip == NULL) {
+        compression->failed = true;
+        ZipCompressionClose(compression);
+        return NULL;
+    }
+    mz_stream_set_base(compression->writeBehindStream, compression->stream);
+    if (mz_stream_open(compression->writeBehindStream, archivePath, MZ_OPEN_MODE_WRITE | MZ_OPEN_MODE_CREATE) != MZ_OK || mz_zip_open(compression->zip, compression->writeBehindStream, MZ_OPEN_MODE_WRITE) != MZ_OK) {
+        compression->failed = true;
+        ZipCompressionClose(compression);
+        return NULL;
+    }
+    mz_zip_set_version_madeby(compression->zip, MZ_VERSION_MADEBY);
+
+    //Leave the archive out if it's inside the directory.
+    struct stat archiveStatus;
+    if (stat(archivePath, &archiveStatus) != 0 || !listDirectory(compression, directory, "", options, archiveStatus.st_dev, archiveStatus.st_ino)) {
+        compression->failed = true;
+        ZipCompressionClose(compression);
+        return NULL;
+    }
+    return compression;
+}
+
+bool ZipCompressionFinish(ZipCompression *compression)
+{
+    if (compression->finished) {
+        return compression->succeeded;
+    }
+    compression->finished = true;
+
+    bool success = !compression->failed && compression->nextWrite == compression->entryCount && compression->zip != NULL;
+    if (compression->zip != NULL) {
+        //This writes the central directory.
+        if (mz_zip_close(compression->zip) != MZ_OK) {
+            success = false;
+        }
+        mz_zip_delete(&compression->zip);
+    }
+    if (compression->writeBehindStream != NULL) {
+        if (mz_stream_close(compression->writeBehindStream) != MZ_OK) {
+            success = false;
+        }
+        mz_stream_readahead_delete(&compression->writeBehindStream);
+    }
+    if (compression->stream != NULL) {
+        mz_stream_os_delete(&compression->stream);
+    }
+    if (!success && compression->archivePath != NULL) {
+        unlink(compression->archivePath);
+    }
+    compression->succeeded = success;
+    return success;
+}
+
+void ZipCompressionClose(ZipCompression *compression)
+{
+    if (compression == NULL) {
+        return;
+    }
+    ZipCompressionFinish(compression);
+
+    for (size_t i = 0; i < compression->entryCount; i++) {
+        releaseEntry(&compression->entries[i]);
+        free(compression->entries[i].name);
+        free(compression->entries[i].path);
+    }
+    free(compression->entries);
+    free(compression->archivePath);
+    free(compression->temporaryDirectory);
+    pthread_mutex_destroy(&compression->lock);
+    pthread_cond_destroy(&compression->changed);
+    free(compression);
+}
+
+size_t ZipCompressionWorkerCount(const ZipCompression *compression, size_t maximum)
+{
+    size_t count = compression->entryCount < maximum ? compression->entryCount : maximum;
+    return count > 0 ? count : 1;
+}
+
+bool ZipCompressionRunWorker(ZipCompression *compression)
+{
+    pthread_mutex_lock(&compression->lock);
+    while (!compression->failed && compression->nextWrite < compression->entryCount) {
+        //Append whatever is ready, in order, unless someone else is already doing it.
+        if (!compression->writing && compression->entries[compression->nextWrite].state == ZipEntryReady) {
+            compression->writing = true;
+            while (!compression->failed && compression->nextWrite < compression->entryCount && compression->entries[compression->nextWrite].state == ZipEntryReady) {
+                ZipCompressEntry *entry = &compression->entries[compression->nextWrite];
+                size_t buffered = entry->data != NULL ? (size_t)entry->compressedSize : 0;
+                pthread_mutex_unlock(&compression->lock);
+                bool written = writeEntry(compression, entry);
+                releaseEntry(entry);
+                pthread_mutex_lock(&compression->lock);
+
+                entry->state = ZipEntryWritten;
+                compression->bufferedBytes -= buffered;
+                compression->nextWrite++;
+                if (written) {
+                    atomic_fetch_add(&compression->writtenEntries, 1);
+                } else {
+                    compression->failed = true;
+                }
+            }
+            compression->writing = false;
+            pthread_cond_broadcast(&compression->changed);
+            continue;
+        }
+
+        //Otherwise compress the next entry, as long as there's room to hold it. (If nothing is
+        //waiting then there's always room, so that a single worker can't get stuck.)
+        if (compression->nextCompress < compression->entryCount && (compression->bufferedBytes < compression->memoryBudget || compression->bufferedBytes == 0)) {
+            ZipCompressEntry *entry = &compression->entries[compression->nextCompress++];
+            pthread_mutex_unlock(&compression->lock);
+            bool compressed = compressEntry(compression, entry);
+            pthread_mutex_lock(&compression->lock);
+
+            if (compressed) {
+                entry->state = ZipEntryReady;
+                if (entry->data != NULL) {
+                    compression->bufferedBytes += (size_t)entry->compressedSize;
+                }
+            } else {
+                compression->failed = true;
+            }
+            pthread_cond_broadcast(&compression->changed);
+            continue;
+        }
+
+        //Everything has been handed out, and whoever finishes the next entry will write it.
+        if (compression->nextCompress >= compression->entryCount) {
+            break;
+        }
+        //Wait for the writer to free up some of the budget.
+        pthread_cond_wait(&compression->changed, &compression->lock);
+    }
+    bool success = !compression->failed;
+    pthread_mutex_unlock(&compression->lock);
+    return success;
+}
+
+void ZipCompressionGetProgress(const ZipCompression *compression, ZipCompressionProgress *progress)
+{
+    progress->totalBytes = compression->totalBytes;
+    progress->compressedBytes = atomic_load(&((ZipCompression *)compression)->compressedBytes);
+    progress->entryCount = compression->entryCount;
+    progress->writtenEntries = atomic_load(&((ZipCompression *)compression)->writtenEntries);
+}
+
+#pragma mark - Private functions
+
+static bool listDirectory(ZipCompression *compression, const char *path, const char *name, const ZipCompressionOptions *options, dev_t archiveDevice, ino_t archiveInode)
+{
+    //Lists the contents of a directory in name order, recursing into subdirectories. Empty
+    //directories get an entry of their own so that they're recreated when unzipped.
+    DIR *directory = opendir(path);
+    if (directory == NULL) {
+        return false;
+    }
+    char **names = NULL;
+    size_t nameCount = 0;
+    size_t nameCapacity = 0;
+    bool success = true;
+    struct dirent *item;
+    while (success && (item = readdir(directory)) != NULL) {
+        if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0 || isExcluded(item->d_name, options)) {
+            continue;
+        }
+        if (nameCount == nameCapacity) {
+            nameCapacity = nameCapacity > 0 ? nameCapacity * 2 : 32;
+            char **newNames = realloc(names, nameCapacity * sizeof(char *));
+            if (newNames == NULL) {
+                success = false;
+                break;
+            }
+            names = newNames;
+        }
+        names[nameCount] = strdup(item->d_name);
+        if (names[nameCount] == NULL) {
+            success = false;
+            break;
+        }
+        nameCount++;
+    }
+    closedir(directory);
+    if (success && nameCount > 0) {
+        qsort(names, nameCount, sizeof(char *), compareNames);
+    }
+
+    size_t entriesBefore = compression->entryCount;
+    for (size_t i = 0; success && i < nameCount; i++) {
+        char *itemPath = joinPath(path, names[i], "");
+        char *itemName = *name != '\0' ? joinPath(name, names[i], "") : strdup(names[i]);
+        struct stat status;
+        //Links are followed, but a linked directory isn't gone into.
+        bool isLinkedDirectory = false;
+        if (itemPath != NULL && lstat(itemPath, &status) == 0 && S_ISLNK(status.st_mode)) {
+            isLinkedDirectory = stat(itemPath, &status) == 0 && S_ISDIR(status.st_mode);
+        }
+
+        if (itemPath == NULL || itemName == NULL) {
+            success = false;
+        } else if (isLinkedDirectory || stat(itemPath, &status) != 0 || (status.st_dev == archiveDevice && status.st_ino == archiveInode)) {
+            //Skip it.
+        } else if (S_ISDIR(status.st_mode)) {
+            success = listDirectory(compression, itemPath, itemName, options, archiveDevice, archiveInode);
+        } else if (S_ISREG(status.st_mode)) {
+            ZipCompressEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.name = itemName;
+            entry.path = itemPath;
+            entry.mode = (uint32_t)status.st_mode;
+            entry.modified = status.st_mtime;
+            entry.store = options->storeCompressedFiles && hasStoredExtension(names[i]);
+            entry.uncompressedSize = (uint64_t)status.st_size;
+            entry.fd = -1;
+            success = addEntry(compression, &entry);
+            if (success) {
+                compression->totalBytes += entry.uncompressedSize;
+                itemName = NULL;
+                itemPath = NULL;
+            }
+        }
+        free(itemPath);
+        free(itemName);
+    }
+
+    if (success && *name != '\0' && compression->entryCount == entriesBefore) {
+        struct stat status;
+        ZipCompressEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.name = joinPath(name, "", "");
+        entry.isDirectory = true;
+        entry.mode = stat(path, &status) == 0 ? (uint32_t)status.st_mode : (S_IFDIR | 0755);
+        entry.modified = stat(path, &status) == 0 ? status.st_mtime : 0;
+        entry.fd = -1;
+        success = entry.name != NULL && addEntry(compression, &entry);
+        if (!success) {
+            free(entry.name);
+        }
+    }
+
+    for (size_t i = 0; i < nameCount; i++) {
+        free(names[i]);
+    }
+    free(names);
+    return success;
+}
+
+static bool addEntry(ZipCompression *compression, const ZipCompressEntry *entry)
+{
+    if (compression->entryCount == compression->entryCapacity) {
+        size_t capacity = compression->entryCapacity > 0 ? compression->entryCapacity * 2 : 64;
+        ZipCompressEntry *entries = realloc(compression->entries, capacity * sizeof(ZipCompressEntry));
+        if (entries == NULL) {
+            return false;
+        }
+        compression->entries = entries;
+        compression->entryCapacity = capacity;
+    }
+    compression->entries[compression->entryCount++] = *entry;
+    return true;
+}
+
+static bool isExcluded(const char *name, const ZipCompressionOptions *options)
+{
+    if (options->excludedNames == NULL) {
+        return false;
+    }
+    for (int i = 0; options->excludedNames[i] != NULL; i++) {
+        if (strcmp(name, options->excludedNames[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool hasStoredExtension(const char *name)
+{
+    const char *extension = strrchr(name, '.');
+    if (extension == NULL) {
+        return false;
+    }
+    for (int i = 0; STORED_EXTENSIONS[i] != NULL; i++) {
+        if (strcasecmp(extension + 1, STORED_EXTENSIONS[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static char *joinPath(const char *directory, const char *name, const char *suffix)
+{
+    //Joins with a slash. A name of "" gives the directory with a slash on the end.
+    size_t directoryLength = strlen(directory);
+    size_t nameLength = strlen(name);
+    size_t suffixLength = strlen(suffix);
+    char *path = malloc(directoryLength + nameLength + suffixLength + 2);
+    if (path == NULL) {
+        return NULL;
+    }
+    memcpy(path, directory, directoryLength);
+    path[directoryLength] = '/';
+    memcpy(path + directoryLength + 1, name, nameLength);
+    memcpy(path + directoryLength + 1 + nameLength, suffix, suffixLength + 1);
+    return path;
+}
+
+static bool readAll(int fd, uint8_t *bytes, size_t length, size_t *bytesRead)
+{
+    //Reads until the buffer is full or the file ends.
+    *bytesRead = 0;
+    while (*bytesRead < length) {
+        ssize_t result = read(fd, bytes + *bytesRead, length - *bytesRead);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        } else if (result == 0) {
+            break;
+        }
+        *bytesRead += (size_t)result;
+    }
+    return true;
+}
+
+static bool writeAll(int fd, const uint8_t *bytes, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+static bool compressEntry(ZipCompression *compression, ZipCompressEntry *entry)
+{
+    if (entry->isDirectory) {
+        entry->method = MZ_COMPRESS_METHOD_STORE;
+        return true;
+    }
+
+    int fd = open(entry->path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return false;
+    }
+    //Go by the size of the file as it is now, in case it's changed since it was listed.
+    entry->uncompressedSize = (uint64_t)status.st_size;
+
+    bool success;
+    if (entry->uncompressedSize <= ZIP_COMPRESS_MEMORY_LIMIT) {
+        success = compressInMemory(compression, entry, fd);
+        close(fd);
+    } else {
+        //Keeps the file open if it's going to be stored.
+        success = compressToFile(compression, entry, fd);
+    }
+    return success;
+}
+
+static bool compressInMemory(ZipCompression *compression, ZipCompressEntry *entry, int fd)
+{
+    size_t length = (size_t)entry->uncompressedSize;
+    uint8_t *input = malloc(length > 0 ? length : 1);
+    size_t bytesRead = 0;
+    if (input == NULL || !readAll(fd, input, length, &bytesRead)) {
+        free(input);
+        return false;
+    }
+    length = bytesRead;
+    entry->uncompressedSize = length;
+    entry->crc = mz_crypt_crc32_update(0, input, (int32_t)length);
+    atomic_fetch_add(&compression->compressedBytes, length);
+
+    if (!entry->store && length > 0) {
+        z_stream zStream;
+        memset(&zStream, 0, sizeof(zStream));
+        if (deflateInit2(&zStream, compression->level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            free(input);
+            return false;
+        }
+        uLong bound = deflateBound(&zStream, (uLong)length);
+        uint8_t *output = malloc(bound);
+        int result = Z_STREAM_ERROR;
+        if (output != NULL) {
+            zStream.next_in = input;
+            zStream.avail_in = (uInt)length;
+            zStream.next_out = output;
+            zStream.avail_out = (uInt)bound;
+            result = deflate(&zStream, Z_FINISH);
+        }
+        deflateEnd(&zStream);
+
+        //Only keep the deflated version if it's actually smaller.
+        if (result == Z_STREAM_END && zStream.total_out < length) {
+            free(input);
+            entry->data = output;
+            entry->compressedSize = zStream.total_out;
+            entry->method = MZ_COMPRESS_METHOD_DEFLATE;
+            return true;
+        }
+        free(output);
+    }
+
+    entry->data = input;
+    entry->compressedSize = length;
+    entry->method = MZ_COMPRESS_METHOD_STORE;
+    return true;
+}
+
+static bool compressToFile(ZipCompression *compression, ZipCompressEntry *entry, int fd)
+{
+    uint8_t *input = malloc(ZIP_COMPRESS_BUFFER_LENGTH);
+    uint8_t *output = malloc(ZIP_COMPRESS_BUFFER_LENGTH);
+    int outputFd = -1;
+    if (input == NULL || output == NULL) {
+        free(input);
+        free(output);
+        close(fd);
+        return false;
+    }
+
+    z_stream zStream;
+    memset(&zStream, 0, sizeof(zStream));
+    bool success = true;
+    if (!entry->store) {
+        char *temporaryPath = joinPath(compression->temporaryDirectory, "zipchunk.XXXXXX", "");
+        outputFd = temporaryPath != NULL ? mkstemp(temporaryPath) : -1;
+        if (outputFd >= 0) {
+            //Nothing else needs to see it, and this way it goes away however we finish.
+            unlink(temporaryPath);
+        }
+        free(temporaryPath);
+        success = outputFd >= 0 && deflateInit2(&zStream, compression->level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        if (!success && outputFd >= 0) {
+            close(outputFd);
+            outputFd = -1;
+        }
+    }
+
+    //Read the whole file through, working out the CRC and deflating it if need be.
+    uint32_t crc = 0;
+    uint64_t totalRead = 0;
+    int flush = Z_NO_FLUSH;
+    while (success && flush != Z_FINISH) {
+        size_t bytesRead = 0;
+        success = readAll(fd, input, ZIP_COMPRESS_BUFFER_LENGTH, &bytesRead);
+        if (!success) {
+            break;
+        }
+        if (bytesRead < ZIP_COMPRESS_BUFFER_LENGTH) {
+            flush = Z_FINISH;
+        }
+        crc = mz_crypt_crc32_update(crc, input, (int32_t)bytesRead);
+        totalRead += bytesRead;
+        atomic_fetch_add(&compression->compressedBytes, bytesRead);
+        if (entry->store) {
+            continue;
+        }
+
+        zStream.next_in = input;
+        zStream.avail_in = (uInt)bytesRead;
+        int result;
+        do {
+            zStream.next_out = output;
+            zStream.avail_out = ZIP_COMPRESS_BUFFER_LENGTH;
+            result = deflate(&zStream, flush);
+            size_t produced = ZIP_COMPRESS_BUFFER_LENGTH - zStream.avail_out;
+            if (result == Z_STREAM_ERROR || !writeAll(outputFd, output, produced)) {
+                success = false;
+                break;
+            }
+        } while (zStream.avail_out == 0);
+    }
+    free(input);
+    free(output);
+
+    entry->crc = crc;
+    entry->uncompressedSize = totalRead;
+    if (entry->store) {
+        //The writer copies straight from the source file.
+        entry->method = MZ_COMPRESS_METHOD_STORE;
+        entry->compressedSize = totalRead;
+        entry->fd = fd;
+    } else {
+        entry->method = MZ_COMPRESS_METHOD_DEFLATE;
+        entry->compressedSize = zStream.total_out;
+        entry->fd = outputFd;
+        deflateEnd(&zStream);
+        close(fd);
+    }
+    if (!success && entry->fd >= 0) {
+        close(entry->fd);
+        entry->fd = -1;
+    }
+    return success;
+}
+
+static bool writeEntry(ZipCompression *compression, ZipCompressEntry *entry)
+{
+    mz_zip_file info;
+    memset(&info, 0, sizeof(info));
+    info.version_madeby = MZ_VERSION_MADEBY;
+    info.flag = MZ_ZIP_FLAG_UTF8;
+    info.compression_method = entry->method;
+    info.modified_date = entry->modified;
+    info.filename = entry->name;
+    info.crc = entry->crc;
+    info.compressed_size = (int64_t)entry->compressedSize;
+    info.uncompressed_size = (int64_t)entry->uncompressedSize;
+    info.zip64 = MZ_ZIP64_AUTO;
+    //The low byte holds the DOS attributes, and the high bytes the POSIX mode.
+    uint32_t dosAttributes = 0;
+    mz_zip_attrib_convert(MZ_HOST_SYSTEM(MZ_VERSION_MADEBY), entry->mode, MZ_HOST_SYSTEM_MSDOS, &dosAttributes);
+    info.external_fa = dosAttributes | (entry->mode << 16);
+
+    //The data is already compressed, so it's written raw.
+    if (mz_zip_entry_write_open(compression->zip, &info, (int16_t)compression->level, 1, NULL) != MZ_OK) {
+        return false;
+    }
+
+    bool success = true;
+    if (entry->data != NULL) {
+        const uint8_t *bytes = entry->data;
+        uint64_t remaining = entry->compressedSize;
+        while (success && remaining > 0) {
+            int32_t length = remaining > ZIP_COMPRESS_BUFFER_LENGTH ? ZIP_COMPRESS_BUFFER_LENGTH : (int32_t)remaining;
+            success = mz_zip_entry_write(compression->zip, bytes, length) == length;
+            bytes += length;
+            remaining -= (uint64_t)length;
+        }
+    } else if (entry->fd >= 0) {
+        uint8_t *buffer = malloc(ZIP_COMPRESS_BUFFER_LENGTH);
+        uint64_t offset = 0;
+        success = buffer != NULL;
+        while (success && offset < entry->compressedSize) {
+            uint64_t remaining = entry->compressedSize - offset;
+            size_t length = remaining > ZIP_COMPRESS_BUFFER_LENGTH ? ZIP_COMPRESS_BUFFER_LENGTH : (size_t)remaining;
+            ssize_t bytesRead = pread(entry->fd, buffer, length, (off_t)offset);
+            if (bytesRead <= 0) {
+                //The file has shrunk since it was read (or can't be read), so the CRC won't match.
+                success = false;
+                break;
+            }
+            success = mz_zip_entry_write(compression->zip, buffer, (int32_t)bytesRead) == (int32_t)bytesRead;
+            offset += (uint64_t)bytesRead;
+        }
+        free(buffer);
+    }
+
+    if (mz_zip_entry_close_raw(compression->zip, (int64_t)entry->uncompressedSize, entry->crc) != MZ_OK) {
+        success = false;
+    }
+    return success;
+}
+
+static void releaseEntry(ZipCompressEntry *entry)
+{
+    free(entry->data);
+    entry->data = NULL;
+    if (entry->fd >= 0) {
+        close(entry->fd);
+        entry->fd = -1;
+    }
+}
+
+static int compareNames(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
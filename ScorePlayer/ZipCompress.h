@@ -0,0 +1,69 @@
+//
+//  ZipCompress.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Zips up the contents of a directory with several threads at once, in the style of pigz. The
+//files are deflated by the workers in parallel, each into memory (or, for big files, into an
+//unlinked temporary file), and whichever worker finds the next entry in the archive ready
+//appends it with minizip, so the archive is always written in order. Files that are already
+//compressed (images, audio and video, and other archives) can be stored as they are, and any
+//file that deflate can't make smaller is stored too.
+//How far the compressors can get ahead of the archive is limited by a memory budget.
+
+#ifndef ZipCompress_h
+#define ZipCompress_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ZipCompression ZipCompression;
+
+typedef struct {
+    //A zlib compression level, from 1 to 9, or -1 for the default.
+    int level;
+    //Store PNG, JPEG, audio and video files and archives rather than deflating them again.
+    bool storeCompressedFiles;
+    //Files and directories with these names are left out wherever they are. The list ends
+    //with NULL, and can be NULL itself.
+    const char **excludedNames;
+    //Where big files are compressed to before they're added. NULL for the system default.
+    const char *temporaryDirectory;
+    //The most compressed data to hold in memory waiting to be written. 0 for the default.
+    size_t memoryBudget;
+} ZipCompressionOptions;
+
+typedef struct {
+    //Sizes are of the files going in.
+    uint64_t totalBytes;
+    uint64_t compressedBytes;
+    size_t entryCount;
+    size_t writtenEntries;
+} ZipCompressionProgress;
+
+void ZipCompressionOptionsInit(ZipCompressionOptions *options);
+
+//Creates the archive (replacing anything already at the path) and lists the files in the
+//directory. Entry names are relative to the directory. Returns NULL if either fails.
+ZipCompression *ZipCompressionOpen(const char *directory, const char *archivePath, const ZipCompressionOptions *options);
+//Finishes the archive once every worker has returned. If anything failed (or there are entries
+//left) the archive is deleted and false is returned. Progress can still be read afterwards.
+bool ZipCompressionFinish(ZipCompression *compression);
+//Frees the compression, finishing the archive first if that hasn't been done.
+void ZipCompressionClose(ZipCompression *compression);
+
+//The number of workers worth running, at most the given maximum.
+size_t ZipCompressionWorkerCount(const ZipCompression *compression, size_t maximum);
+//Compresses and writes entries until there are none left. Call this from as many threads as
+//there are workers. Any one worker will get through the whole archive on its own if the others
+//never get to run. Returns false if anything has failed.
+bool ZipCompressionRunWorker(ZipCompression *compression);
+
+//Can be called from any thread while the workers are running.
+void ZipCompressionGetProgress(const ZipCompression *compression, ZipCompressionProgress *progress);
+
+#endif /* ZipCompress_h */
@@ -0,0 +1,42 @@
+//
+//  ZipCompressor.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+//Zips up a directory using a worker for each core. (See ZipCompress.h for how the work is split
+//up.) Images and audio are stored rather than deflated again, and the tile pyramids that are
+//cached inside score directories are left out, since they're rebuilt on demand. So is the asset
+//store, since every score's files are archived in full anyway.
+
+@interface ZipCompressor : NSObject
+
+@property (nonatomic, readonly) NSString *directory;
+@property (nonatomic, readonly) NSString *archivePath;
+
+//These can be read from any thread while the archive is being written.
+@property (nonatomic, readonly) unsigned long long totalBytes;
+@property (nonatomic, readonly) unsigned long long compressedBytes;
+@property (nonatomic, readonly) NSInteger entryCount;
+@property (nonatomic, readonly) NSInteger writtenEntries;
+//Bytes compressed per second since compression started.
+@property (nonatomic, readonly) double bytesPerSecond;
+
+//Called on the main queue a few times a second while the archive is written, and once more
+//when it's done.
+@property (nonatomic, copy) void (^progressHandler)(ZipCompressor *compressor);
+
+//Creates the archive, replacing anything already at the path. Returns nil if it can't be
+//created or the directory can't be read.
+- (id)initWithDirectory:(NSString *)directoryPath archivePath:(NSString *)path;
+//Blocks until the archive is finished. Returns NO if anything failed, in which case the
+//archive is deleted.
+- (BOOL)compress;
+
++ (BOOL)compressDirectory:(NSString *)directoryPath toArchive:(NSString *)path;
+
+@end
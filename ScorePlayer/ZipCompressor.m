@@ -0,0 +1,127 @@
+//
+//  ZipCompressor.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ZipCompressor.h"
+#import "ZipCompress.h"
+
+static const int64_t ZIP_COMPRESSOR_PROGRESS_INTERVAL = NSEC_PER_SEC / 10;
+
+@implementation ZipCompressor {
+    ZipCompression *compression;
+    NSTimeInterval startTime;
+    NSTimeInterval endTime;
+}
+
+@synthesize directory, archivePath, progressHandler;
+
+- (id)initWithDirectory:(NSString *)directoryPath archivePath:(NSString *)path
+{
+    self = [super init];
+    directory = directoryPath;
+    archivePath = path;
+    
+    ZipCompressionOptions options;
+    ZipCompressionOptionsInit(&options);
+    const char *excludedNames[] = {".pyramid", ".assets", NULL};
+    options.excludedNames = excludedNames;
+    options.storeCompressedFiles = true;
+    options.temporaryDirectory = [NSTemporaryDirectory() fileSystemRepresentation];
+    compression = ZipCompressionOpen([directoryPath fileSystemRepresentation], [path fileSystemRepresentation], &options);
+    if (compression == NULL) {
+        return nil;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    //If we never got as far as compressing, this deletes the unfinished archive.
+    ZipCompressionClose(compression);
+}
+
+- (BOOL)compress
+{
+    startTime = [NSDate timeIntervalSinceReferenceDate];
+    endTime = 0;
+    
+    dispatch_source_t progressTimer = nil;
+    if (progressHandler != nil) {
+        progressTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+        dispatch_source_set_timer(progressTimer, dispatch_time(DISPATCH_TIME_NOW, ZIP_COMPRESSOR_PROGRESS_INTERVAL), ZIP_COMPRESSOR_PROGRESS_INTERVAL, ZIP_COMPRESSOR_PROGRESS_INTERVAL / 10);
+        __weak ZipCompressor *weakSelf = self;
+        dispatch_source_set_event_handler(progressTimer, ^{
+            ZipCompressor *compressor = weakSelf;
+            if (compressor != nil && compressor.progressHandler != nil) {
+                compressor.progressHandler(compressor);
+            }
+        });
+        dispatch_resume(progressTimer);
+    }
+    
+    size_t workerCount = ZipCompressionWorkerCount(compression, [[NSProcessInfo processInfo] activeProcessorCount]);
+    dispatch_apply(workerCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        ZipCompressionRunWorker(self->compression);
+    });
+    
+    BOOL success = ZipCompressionFinish(compression);
+    endTime = [NSDate timeIntervalSinceReferenceDate];
+    
+    if (progressTimer != nil) {
+        dispatch_source_cancel(progressTimer);
+        void (^handler)(ZipCompressor *) = progressHandler;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            handler(self);
+        });
+    }
+    return success;
+}
+
++ (BOOL)compressDirectory:(NSString *)directoryPath toArchive:(NSString *)path
+{
+    ZipCompressor *compressor = [[ZipCompressor alloc] initWithDirectory:directoryPath archivePath:path];
+    return [compressor compress];
+}
+
+- (unsigned long long)totalBytes
+{
+    ZipCompressionProgress progress;
+    ZipCompressionGetProgress(compression, &progress);
+    return progress.totalBytes;
+}
+
+- (unsigned long long)compressedBytes
+{
+    ZipCompressionProgress progress;
+    ZipCompressionGetProgress(compression, &progress);
+    return progress.compressedBytes;
+}
+
+- (NSInteger)entryCount
+{
+    ZipCompressionProgress progress;
+    ZipCompressionGetProgress(compression, &progress);
+    return progress.entryCount;
+}
+
+- (NSInteger)writtenEntries
+{
+    ZipCompressionProgress progress;
+    ZipCompressionGetProgress(compression, &progress);
+    return progress.writtenEntries;
+}
+
+- (double)bytesPerSecond
+{
+    if (startTime == 0) {
+        return 0;
+    }
+    NSTimeInterval elapsed = (endTime > 0 ? endTime : [NSDate timeIntervalSinceReferenceDate]) - startTime;
+    return elapsed > 0 ? self.compressedBytes / elapsed : 0;
+}
+
+@end
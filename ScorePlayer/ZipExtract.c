@@ -0,0 +1,504 @@
+//
+//  ZipExtract.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ZipExtract.h"
+#include "ZipPath.h"
+#include "SSZipArchive/minizip/mz.h"
+#include "SSZipArchive/minizip/mz_strm.h"
+#include "SSZipArchive/minizip/mz_strm_os.h"
+#include "SSZipArchive/minizip/mz_strm_readahead.h"
+#include "SSZipArchive/minizip/mz_zip.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+//Each worker inflates into a buffer of this size and writes it out in one go.
+#define ZIP_EXTRACT_BUFFER_LENGTH (256 * 1024)
+
+typedef struct {
+    int64_t centralDirectoryPosition;
+    //Relative to the destination.
+    char *path;
+    uint64_t size;
+    time_t modified;
+    //The position of the entry in the archive.
+    size_t order;
+} ZipExtractEntry;
+
+struct ZipExtraction {
+    char *archivePath;
+    char *destination;
+    //Largest first, so that one big file doesn't hold everything up at the end.
+    ZipExtractEntry *entries;
+    size_t entryCount;
+    size_t entryCapacity;
+    //Relative to the destination, and sorted so that each comes after its parent.
+    char **directories;
+    size_t directoryCount;
+    size_t directoryCapacity;
+    uint64_t totalBytes;
+    bool prepared;
+
+    atomic_size_t nextEntry;
+    atomic_size_t extractedFiles;
+    atomic_uint_least64_t extractedBytes;
+    atomic_bool failed;
+};
+
+static char *joinPath(const char *directory, const char *name);
+static bool addEntry(ZipExtraction *extraction, const ZipExtractEntry *entry);
+static bool addDirectory(ZipExtraction *extraction, const char *path, size_t length);
+static bool addParentDirectories(ZipExtraction *extraction, const char *path);
+static void removeDuplicateEntries(ZipExtraction *extraction);
+static void removeDuplicateDirectories(ZipExtraction *extraction);
+static bool makeDirectory(const char *path);
+static void preallocate(int fd, uint64_t length);
+static bool writeAll(int fd, const uint8_t *bytes, size_t length);
+static bool extractEntry(ZipExtraction *extraction, void *zip, const ZipExtractEntry *entry, uint8_t *buffer);
+static int compareEntriesByPath(const void *a, const void *b);
+static int compareEntriesBySize(const void *a, const void *b);
+static int compareStrings(const void *a, const void *b);
+
+#pragma mark - Public functions
+
+ZipExtraction *ZipExtractionOpen(const char *archivePath, const char *destination)
+{
+    ZipExtraction *extraction = calloc(1, sizeof(ZipExtraction));
+    if (extraction == NULL) {
+        return NULL;
+    }
+    atomic_init(&extraction->nextEntry, 0);
+    atomic_init(&extraction->extractedFiles, 0);
+    atomic_init(&extraction->extractedBytes, 0);
+    atomic_init(&extraction->failed, false);
+    extraction->archivePath = strdup(archivePath);
+    extraction->destination = strdup(destination);
+    if (extraction->archivePath == NULL || extraction->destination == NULL) {
+        ZipExtractionClose(extraction);
+        return NULL;
+    }
+
+    void *stream = NULL;
+    void *zip = NULL;
+    mz_stream_os_create(&stream);
+    mz_zip_create(&zip);
+    bool success = stream != NULL && zip != NULL;
+    success = success && mz_stream_os_open(stream, archivePath, MZ_OPEN_MODE_READ) == MZ_OK;
+    success = success && mz_zip_open(zip, stream, MZ_OPEN_MODE_READ) == MZ_OK;
+
+    //Walk the central directory, remembering where each entry is so that the workers can go
+    //straight to it.
+    int32_t err = success ? mz_zip_goto_first_entry(zip) : MZ_PARAM_ERROR;
+    size_t order = 0;
+    while (success && err == MZ_OK) {
+        mz_zip_file *info = NULL;
+        if (mz_zip_entry_get_info(zip, &info) != MZ_OK || (info->flag & MZ_ZIP_FLAG_ENCRYPTED)) {
+            success = false;
+            break;
+        }
+
+        char *path = ZipPathClean(info->filename);
+        if (path == NULL && errno == ENOMEM) {
+            success = false;
+        } else if (path != NULL) {
+            if (mz_zip_entry_is_dir(zip) == MZ_OK) {
+                success = addDirectory(extraction, path, strlen(path)) && addParentDirectories(extraction, path);
+                free(path);
+            } else if (mz_zip_entry_is_symlink(zip) == MZ_OK) {
+                free(path);
+            } else {
+                ZipExtractEntry entry;
+                entry.centralDirectoryPosition = mz_zip_get_entry(zip);
+                entry.path = path;
+                entry.size = info->uncompressed_size > 0 ? (uint64_t)info->uncompressed_size : 0;
+                entry.modified = info->modified_date;
+                entry.order = order;
+                success = addParentDirectories(extraction, path) && addEntry(extraction, &entry);
+                if (!success) {
+                    free(path);
+                }
+            }
+        }
+        order++;
+        err = mz_zip_goto_next_entry(zip);
+    }
+    if (err != MZ_END_OF_LIST) {
+        success = false;
+    }
+
+    if (zip != NULL) {
+        mz_zip_close(zip);
+        mz_zip_delete(&zip);
+    }
+    if (stream != NULL) {
+        mz_stream_os_close(stream);
+        mz_stream_os_delete(&stream);
+    }
+    if (!success) {
+        ZipExtractionClose(extraction);
+        return NULL;
+    }
+
+    removeDuplicateEntries(extraction);
+    removeDuplicateDirectories(extraction);
+    if (extraction->entryCount > 0) {
+        qsort(extraction->entries, extraction->entryCount, sizeof(ZipExtractEntry), compareEntriesBySize);
+    }
+    for (size_t i = 0; i < extraction->entryCount; i++) {
+        extraction->totalBytes += extraction->entries[i].size;
+    }
+    return extraction;
+}
+
+void ZipExtractionClose(ZipExtraction *extraction)
+{
+    if (extraction == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < extraction->entryCount; i++) {
+        free(extraction->entries[i].path);
+    }
+    for (size_t i = 0; i < extraction->directoryCount; i++) {
+        free(extraction->directories[i]);
+    }
+    free(extraction->entries);
+    free(extraction->directories);
+    free(extraction->archivePath);
+    free(extraction->destination);
+    free(extraction);
+}
+
+bool ZipExtractionPrepare(ZipExtraction *extraction)
+{
+    //Create the destination itself, then the directories within it. Parents sort ahead of
+    //their children, so each directory only needs one mkdir.
+    char *path = strdup(extraction->destination);
+    if (path == NULL) {
+        return false;
+    }
+    for (char *separator = strchr(path + 1, '/'); separator != NULL; separator = strchr(separator + 1, '/')) {
+        *separator = '\0';
+        bool made = makeDirectory(path);
+        *separator = '/';
+        if (!made) {
+            free(path);
+            return false;
+        }
+    }
+    bool success = makeDirectory(path);
+    free(path);
+
+    for (size_t i = 0; success && i < extraction->directoryCount; i++) {
+        char *directory = joinPath(extraction->destination, extraction->directories[i]);
+        success = directory != NULL && makeDirectory(directory);
+        free(directory);
+    }
+    extraction->prepared = success;
+    return success;
+}
+
+size_t ZipExtractionWorkerCount(const ZipExtraction *extraction, size_t maximum)
+{
+    size_t count = extraction->entryCount < maximum ? extraction->entryCount : maximum;
+    return count > 0 ? count : 1;
+}
+
+bool ZipExtractionRunWorker(ZipExtraction *extraction)
+{
+    if (!extraction->prepared) {
+        atomic_store(&extraction->failed, true);
+        return false;
+    }
+
+    //Each worker reads the archive ahead of itself on another thread, so that inflating
+    //doesn't stop and wait every time it needs more from the disk.
+    void *stream = NULL;
+    void *readAheadStream = NULL;
+    void *zip = NULL;
+    uint8_t *buffer = malloc(ZIP_EXTRACT_BUFFER_LENGTH);
+    mz_stream_os_create(&stream);
+    mz_stream_readahead_create(&readAheadStream);
+    mz_zip_create(&zip);
+    bool success = buffer != NULL && stream != NULL && readAheadStream != NULL && zip != NULL;
+    success = success && mz_stream_set_base(readAheadStream, stream) == MZ_OK;
+    success = success && mz_stream_open(readAheadStream, extraction->archivePath, MZ_OPEN_MODE_READ) == MZ_OK;
+    success = success && mz_zip_open(zip, readAheadStream, MZ_OPEN_MODE_READ) == MZ_OK;
+
+    while (success && !atomic_load(&extraction->failed)) {
+        size_t next = atomic_fetch_add(&extraction->nextEntry, 1);
+        if (next >= extraction->entryCount) {
+            break;
+        }
+        success = extractEntry(extraction, zip, &extraction->entries[next], buffer);
+    }
+    if (!success) {
+        atomic_store(&extraction->failed, true);
+    }
+
+    if (zip != NULL) {
+        mz_zip_close(zip);
+        mz_zip_delete(&zip);
+    }
+    if (readAheadStream != NULL) {
+        //This closes the stream underneath it too.
+        mz_stream_readahead_delete(&readAheadStream);
+    }
+    if (stream != NULL) {
+        mz_stream_os_delete(&stream);
+    }
+    free(buffer);
+    return !atomic_load(&extraction->failed);
+}
+
+void ZipExtractionGetProgress(const ZipExtraction *extraction, ZipExtractionProgress *progress)
+{
+    progress->totalBytes = extraction->totalBytes;
+    progress->extractedBytes = atomic_load(&((ZipExtraction *)extraction)->extractedBytes);
+    progress->fileCount = extraction->entryCount;
+    progress->extractedFiles = atomic_load(&((ZipExtraction *)extraction)->extractedFiles);
+}
+
+#pragma mark - Private functions
+
+static char *joinPath(const char *directory, const char *name)
+{
+    size_t directoryLength = strlen(directory);
+    size_t nameLength = strlen(name);
+    char *path = malloc(directoryLength + nameLength + 2);
+    if (path == NULL) {
+        return NULL;
+    }
+    memcpy(path, directory, directoryLength);
+    path[directoryLength] = '/';
+    memcpy(path + directoryLength + 1, name, nameLength + 1);
+    return path;
+}
+
+static bool addEntry(ZipExtraction *extraction, const ZipExtractEntry *entry)
+{
+    if (extraction->entryCount == extraction->entryCapacity) {
+        size_t capacity = extraction->entryCapacity > 0 ? extraction->entryCapacity * 2 : 64;
+        ZipExtractEntry *entries = realloc(extraction->entries, capacity * sizeof(ZipExtractEntry));
+        if (entries == NULL) {
+            return false;
+        }
+        extraction->entries = entries;
+        extraction->entryCapacity = capacity;
+    }
+    extraction->entries[extraction->entryCount++] = *entry;
+    return true;
+}
+
+static bool addDirectory(ZipExtraction *extraction, const char *path, size_t length)
+{
+    //Skip the most common repeat straight away: files from the same directory in a row.
+    if (extraction->directoryCount > 0) {
+        const char *last = extraction->directories[extraction->directoryCount - 1];
+        if (strlen(last) == length && memcmp(last, path, length) == 0) {
+            return true;
+        }
+    }
+
+    if (extraction->directoryCount == extraction->directoryCapacity) {
+        size_t capacity = extraction->directoryCapacity > 0 ? extraction->directoryCapacity * 2 : 16;
+        char **directories = realloc(extraction->directories, capacity * sizeof(char *));
+        if (directories == NULL) {
+            return false;
+        }
+        extraction->directories = directories;
+        extraction->directoryCapacity = capacity;
+    }
+    char *directory = malloc(length + 1);
+    if (directory == NULL) {
+        return false;
+    }
+    memcpy(directory, path, length);
+    directory[length] = '\0';
+    extraction->directories[extraction->directoryCount++] = directory;
+    return true;
+}
+
+static bool addParentDirectories(ZipExtraction *extraction, const char *path)
+{
+    for (const char *separator = strchr(path, '/'); separator != NULL; separator = strchr(separator + 1, '/')) {
+        if (!addDirectory(extraction, path, separator - path)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void removeDuplicateEntries(ZipExtraction *extraction)
+{
+    //Sort by name and then by position in the archive, and keep the last of each name.
+    if (extraction->entryCount == 0) {
+        return;
+    }
+    qsort(extraction->entries, extraction->entryCount, sizeof(ZipExtractEntry), compareEntriesByPath);
+    size_t kept = 0;
+    for (size_t i = 0; i < extraction->entryCount; i++) {
+        if (i + 1 < extraction->entryCount && strcmp(extraction->entries[i].path, extraction->entries[i + 1].path) == 0) {
+            free(extraction->entries[i].path);
+        } else {
+            extraction->entries[kept++] = extraction->entries[i];
+        }
+    }
+    extraction->entryCount = kept;
+}
+
+static void removeDuplicateDirectories(ZipExtraction *extraction)
+{
+    if (extraction->directoryCount == 0) {
+        return;
+    }
+    qsort(extraction->directories, extraction->directoryCount, sizeof(char *), compareStrings);
+    size_t kept = 0;
+    for (size_t i = 0; i < extraction->directoryCount; i++) {
+        if (kept > 0 && strcmp(extraction->directories[kept - 1], extraction->directories[i]) == 0) {
+            free(extraction->directories[i]);
+        } else {
+            extraction->directories[kept++] = extraction->directories[i];
+        }
+    }
+    extraction->directoryCount = kept;
+}
+
+static bool makeDirectory(const char *path)
+{
+    if (mkdir(path, 0755) == 0) {
+        return true;
+    }
+    //Anything already there has to be a real directory (and not a link to somewhere else).
+    struct stat status;
+    return errno == EEXIST && lstat(path, &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+static void preallocate(int fd, uint64_t length)
+{
+    //This is only a hint, so failures are ignored.
+    if (length == 0) {
+        return;
+    }
+#ifdef __APPLE__
+    fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t)length, 0};
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        fcntl(fd, F_PREALLOCATE, &store);
+    }
+#else
+    posix_fallocate(fd, 0, (off_t)length);
+#endif
+}
+
+static bool writeAll(int fd, const uint8_t *bytes, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+static bool extractEntry(ZipExtraction *extraction, void *zip, const ZipExtractEntry *entry, uint8_t *buffer)
+{
+    if (mz_zip_goto_entry(zip, entry->centralDirectoryPosition) != MZ_OK || mz_zip_entry_read_open(zip, 0, NULL) != MZ_OK) {
+        return false;
+    }
+
+    char *path = joinPath(extraction->destination, entry->path);
+    int fd = -1;
+    if (path != NULL) {
+        //Replace whatever is there, without following it if it's a link.
+        unlink(path);
+        fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0666);
+    }
+    free(path);
+    if (fd < 0) {
+        mz_zip_entry_close(zip);
+        return false;
+    }
+    preallocate(fd, entry->size);
+
+    bool success = true;
+    uint64_t written = 0;
+    while (true) {
+        int32_t bytesRead = mz_zip_entry_read(zip, buffer, ZIP_EXTRACT_BUFFER_LENGTH);
+        if (bytesRead <= 0) {
+            success = bytesRead == 0;
+            break;
+        }
+        if (!writeAll(fd, buffer, (size_t)bytesRead)) {
+            success = false;
+            break;
+        }
+        written += (uint64_t)bytesRead;
+        atomic_fetch_add(&extraction->extractedBytes, (uint64_t)bytesRead);
+    }
+    //Closing the entry checks its CRC.
+    if (mz_zip_entry_close(zip) != MZ_OK) {
+        success = false;
+    }
+
+    //The preallocation may have set the length from the central directory, which could be wrong.
+    if (success && written != entry->size) {
+        success = ftruncate(fd, (off_t)written) == 0;
+    }
+    if (success) {
+        struct timespec times[2];
+        times[0].tv_sec = 0;
+        times[0].tv_nsec = UTIME_OMIT;
+        times[1].tv_sec = entry->modified;
+        times[1].tv_nsec = 0;
+        futimens(fd, times);
+    }
+    if (close(fd) != 0) {
+        success = false;
+    }
+    if (success) {
+        atomic_fetch_add(&extraction->extractedFiles, 1);
+    }
+    return success;
+}
+
+static int compareEntriesByPath(const void *a, const void *b)
+{
+    const ZipExtractEntry *first = a;
+    const ZipExtractEntry *second = b;
+    int result = strcmp(first->path, second->path);
+    if (result != 0) {
+        return result;
+    }
+    return first->order < second->order ? -1 : (first->order > second->order ? 1 : 0);
+}
+
+static int compareEntriesBySize(const void *a, const void *b)
+{
+    const ZipExtractEntry *first = a;
+    const ZipExtractEntry *second = b;
+    if (first->size != second->size) {
+        return first->size > second->size ? -1 : 1;
+    }
+    return first->order < second->order ? -1 : (first->order > second->order ? 1 : 0);
+}
+
+static int compareStrings(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
@@ -0,0 +1,55 @@
+//
+//  ZipExtract.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Extracts a zip archive with several threads at once, using minizip. The central directory is
+//read once, when the extraction is opened, and every file entry is given a slot in a shared
+//list. Each worker then opens its own handle on the archive (which only means reading the end
+//of central directory record) and takes entries from the list until there are none left, so
+//the entries are inflated in parallel. Output files are preallocated to their final size
+//before they're written.
+//Entry names are cleaned up before use: "." and ".." components are resolved without ever
+//leaving the destination, and absolute paths are made relative. Symbolic links are skipped.
+//Where an archive has the same name twice, the later entry wins, as it would if the archive
+//was extracted in order.
+
+#ifndef ZipExtract_h
+#define ZipExtract_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ZipExtraction ZipExtraction;
+
+typedef struct {
+    //Sizes are of the extracted files.
+    uint64_t totalBytes;
+    uint64_t extractedBytes;
+    size_t fileCount;
+    size_t extractedFiles;
+} ZipExtractionProgress;
+
+//Reads the central directory of an archive. Returns NULL if it can't be read, or if it
+//contains encrypted entries.
+ZipExtraction *ZipExtractionOpen(const char *archivePath, const char *destination);
+void ZipExtractionClose(ZipExtraction *extraction);
+
+//Creates the destination and every directory in the archive. This has to be done (once) before
+//any workers are run. Returns false if a directory can't be created.
+bool ZipExtractionPrepare(ZipExtraction *extraction);
+//The number of workers worth running, at most the given maximum.
+size_t ZipExtractionWorkerCount(const ZipExtraction *extraction, size_t maximum);
+//Extracts entries until there are none left. Call this from as many threads as there are
+//workers. If any entry fails (including failing its CRC check) the other workers stop once
+//they finish the entry they're on, and every worker returns false.
+bool ZipExtractionRunWorker(ZipExtraction *extraction);
+
+//Can be called from any thread while the workers are running.
+void ZipExtractionGetProgress(const ZipExtraction *extraction, ZipExtractionProgress *progress);
+
+#endif /* ZipExtract_h */
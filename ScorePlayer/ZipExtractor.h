@@ -0,0 +1,39 @@
+//
+//  ZipExtractor.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+//Unzips an archive using a worker for each core, so that big score archives import quickly.
+//(See ZipExtract.h for how the work is split up.)
+
+@interface ZipExtractor : NSObject
+
+@property (nonatomic, readonly) NSString *archivePath;
+@property (nonatomic, readonly) NSString *destination;
+
+//These can be read from any thread while the archive is being extracted.
+@property (nonatomic, readonly) unsigned long long totalBytes;
+@property (nonatomic, readonly) unsigned long long extractedBytes;
+@property (nonatomic, readonly) NSInteger fileCount;
+@property (nonatomic, readonly) NSInteger extractedFiles;
+//Extracted bytes per second since extraction started.
+@property (nonatomic, readonly) double bytesPerSecond;
+
+//Called on the main queue a few times a second while the archive is extracted, and once more
+//when it's done.
+@property (nonatomic, copy) void (^progressHandler)(ZipExtractor *extractor);
+
+//Returns nil if the archive can't be read.
+- (id)initWithArchivePath:(NSString *)path destination:(NSString *)destinationPath;
+//Blocks until every file has been extracted. Returns NO if any of them couldn't be, in which
+//case some files may have been written and others not.
+- (BOOL)extract;
+
++ (BOOL)extractArchive:(NSString *)path toDestination:(NSString *)destinationPath;
+
+@end
@@ -0,0 +1,128 @@
+//
+//  ZipExtractor.m
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ZipExtractor.h"
+#import "ZipExtract.h"
+
+static const int64_t ZIP_EXTRACTOR_PROGRESS_INTERVAL = NSEC_PER_SEC / 10;
+
+@implementation ZipExtractor {
+    ZipExtraction *extraction;
+    NSTimeInterval startTime;
+    NSTimeInterval endTime;
+}
+
+@synthesize archivePath, destination, progressHandler;
+
+- (id)initWithArchivePath:(NSString *)path destination:(NSString *)destinationPath
+{
+    self = [super init];
+    archivePath = path;
+    destination = destinationPath;
+    extraction = ZipExtractionOpen([path fileSystemRepresentation], [destinationPath fileSystemRepresentation]);
+    if (extraction == NULL) {
+        return nil;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    ZipExtractionClose(extraction);
+}
+
+- (BOOL)extract
+{
+    startTime = [NSDate timeIntervalSinceReferenceDate];
+    endTime = 0;
+    if (!ZipExtractionPrepare(extraction)) {
+        return NO;
+    }
+    
+    dispatch_source_t progressTimer = nil;
+    if (progressHandler != nil) {
+        progressTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+        dispatch_source_set_timer(progressTimer, dispatch_time(DISPATCH_TIME_NOW, ZIP_EXTRACTOR_PROGRESS_INTERVAL), ZIP_EXTRACTOR_PROGRESS_INTERVAL, ZIP_EXTRACTOR_PROGRESS_INTERVAL / 10);
+        __weak ZipExtractor *weakSelf = self;
+        dispatch_source_set_event_handler(progressTimer, ^{
+            ZipExtractor *extractor = weakSelf;
+            if (extractor != nil && extractor.progressHandler != nil) {
+                extractor.progressHandler(extractor);
+            }
+        });
+        dispatch_resume(progressTimer);
+    }
+    
+    //The workers spend much of their time waiting on the disk, but more of them than there
+    //are cores just fight over the inflating.
+    size_t workerCount = ZipExtractionWorkerCount(extraction, [[NSProcessInfo processInfo] activeProcessorCount]);
+    __block BOOL success = YES;
+    NSLock *successLock = [[NSLock alloc] init];
+    dispatch_apply(workerCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        if (!ZipExtractionRunWorker(self->extraction)) {
+            [successLock lock];
+            success = NO;
+            [successLock unlock];
+        }
+    });
+    endTime = [NSDate timeIntervalSinceReferenceDate];
+    
+    if (progressTimer != nil) {
+        dispatch_source_cancel(progressTimer);
+        void (^handler)(ZipExtractor *) = progressHandler;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            handler(self);
+        });
+    }
+    return success;
+}
+
++ (BOOL)extractArchive:(NSString *)path toDestination:(NSString *)destinationPath
+{
+    ZipExtractor *extractor = [[ZipExtractor alloc] initWithArchivePath:path destination:destinationPath];
+    return [extractor extract];
+}
+
+- (unsigned long long)totalBytes
+{
+    ZipExtractionProgress progress;
+    ZipExtractionGetProgress(extraction, &progress);
+    return progress.totalBytes;
+}
+
+- (unsigned long long)extractedBytes
+{
+    ZipExtractionProgress progress;
+    ZipExtractionGetProgress(extraction, &progress);
+    return progress.extractedBytes;
+}
+
+- (NSInteger)fileCount
+{
+    ZipExtractionProgress progress;
+    ZipExtractionGetProgress(extraction, &progress);
+    return progress.fileCount;
+}
+
+- (NSInteger)extractedFiles
+{
+    ZipExtractionProgress progress;
+    ZipExtractionGetProgress(extraction, &progress);
+    return progress.extractedFiles;
+}
+
+- (double)bytesPerSecond
+{
+    if (startTime == 0) {
+        return 0;
+    }
+    NSTimeInterval elapsed = (endTime > 0 ? endTime : [NSDate timeIntervalSinceReferenceDate]) - startTime;
+    return elapsed > 0 ? self.extractedBytes / elapsed : 0;
+}
+
+@end
@@ -0,0 +1,574 @@
+//
+//  ZipMount.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ZipMount.h"
+#include "Crc32.h"
+#include "ZipPath.h"
+#include "SSZipArchive/minizip/mz.h"
+#include "SSZipArchive/minizip/mz_crypt.h"
+#include "SSZipArchive/minizip/mz_strm.h"
+#include "SSZipArchive/minizip/mz_strm_os.h"
+#include "SSZipArchive/minizip/mz_zip.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define ZIP_MOUNT_BLOCK_LENGTH (64 * 1024)
+#define ZIP_MOUNT_CACHED_BLOCKS 16
+//Each cursor is a partly inflated entry that a later read can carry on from.
+#define ZIP_MOUNT_CURSORS 2
+#define ZIP_MOUNT_LOCAL_HEADER_LENGTH 30
+#define ZIP_MOUNT_LOCAL_HEADER_MAGIC 0x04034b50
+
+typedef struct {
+    ZipMountEntry entry;
+    uint64_t localHeaderOffset;
+    //Worked out from the local header the first time the entry is read. 0 until then.
+    atomic_uint_least64_t dataOffset;
+} ZipMountRecord;
+
+typedef struct {
+    const ZipMountRecord *record;
+    uint64_t block;
+    size_t length;
+    uint8_t *data;
+    uint64_t lastUse;
+} ZipMountBlock;
+
+typedef struct {
+    const ZipMountRecord *record;
+    z_stream stream;
+    bool initialised;
+    //How much has been inflated so far.
+    uint64_t position;
+    uint64_t lastUse;
+} ZipMountCursor;
+
+struct ZipMount {
+    const uint8_t *mapping;
+    size_t length;
+
+    ZipMountRecord *records;
+    size_t recordCount;
+    size_t recordCapacity;
+    //Open addressing. Each slot holds a record index plus one, or 0 if it's empty.
+    size_t *slots;
+    size_t slotMask;
+
+    pthread_mutex_t cacheLock;
+    ZipMountBlock blocks[ZIP_MOUNT_CACHED_BLOCKS];
+    ZipMountCursor cursors[ZIP_MOUNT_CURSORS];
+    uint64_t useCounter;
+};
+
+static uint64_t hashName(const char *name, size_t length);
+static size_t *findSlot(const ZipMount *mount, const char *name, size_t length);
+static bool addRecord(ZipMount *mount, const ZipMountRecord *record);
+static bool buildTable(ZipMount *mount);
+static uint64_t dataOffset(ZipMount *mount, const ZipMountRecord *record);
+static bool inflateBytes(ZipMount *mount, ZipMountCursor *cursor, uint8_t *buffer, size_t length);
+static ZipMountCursor *cursorForBlock(ZipMount *mount, const ZipMountRecord *record, uint64_t block);
+static ZipMountBlock *cachedBlock(ZipMount *mount, const ZipMountRecord *record, uint64_t block);
+
+#pragma mark - Public functions
+
+ZipMount *ZipMountOpen(const char *archivePath)
+{
+    ZipMount *mount = calloc(1, sizeof(ZipMount));
+    if (mount == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&mount->cacheLock, NULL);
+
+    //Map the whole archive. Only the pages that are actually read get loaded.
+    int fd = open(archivePath, O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0 || status.st_size <= 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        ZipMountClose(mount);
+        return NULL;
+    }
+    mount->length = (size_t)status.st_size;
+    void *mapping = mmap(NULL, mount->length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        ZipMountClose(mount);
+        return NULL;
+    }
+    mount->mapping = mapping;
+
+    void *stream = NULL;
+    void *zip = NULL;
+    mz_stream_os_create(&stream);
+    mz_zip_create(&zip);
+    bool success = stream != NULL && zip != NULL;
+    success = success && mz_stream_os_open(stream, archivePath, MZ_OPEN_MODE_READ) == MZ_OK;
+    success = success && mz_zip_open(zip, stream, MZ_OPEN_MODE_READ) == MZ_OK;
+
+    int32_t err = success ? mz_zip_goto_first_entry(zip) : MZ_PARAM_ERROR;
+    while (success && err == MZ_OK) {
+        mz_zip_file *info = NULL;
+        if (mz_zip_entry_get_info(zip, &info) != MZ_OK || (info->flag & MZ_ZIP_FLAG_ENCRYPTED) || info->disk_number != 0) {
+            success = false;
+            break;
+        }
+        if (mz_zip_entry_is_dir(zip) == MZ_OK || mz_zip_entry_is_symlink(zip) == MZ_OK) {
+            err = mz_zip_goto_next_entry(zip);
+            continue;
+        }
+        if ((info->compression_method != MZ_COMPRESS_METHOD_STORE && info->compression_method != MZ_COMPRESS_METHOD_DEFLATE) || info->compressed_size < 0 || info->uncompressed_size < 0 || info->disk_offset < 0) {
+            success = false;
+            break;
+        }
+
+        char *name = ZipPathClean(info->filename);
+        if (name == NULL && errno == ENOMEM) {
+            success = false;
+        } else if (name != NULL) {
+            ZipMountRecord record;
+            memset(&record, 0, sizeof(record));
+            record.entry.name = name;
+            record.entry.nameLength = strlen(name);
+            record.entry.stored = info->compression_method == MZ_COMPRESS_METHOD_STORE;
+            record.entry.crc = info->crc;
+            record.entry.compressedSize = (uint64_t)info->compressed_size;
+            record.entry.size = (uint64_t)info->uncompressed_size;
+            record.entry.modified = info->modified_date;
+            record.localHeaderOffset = (uint64_t)info->disk_offset;
+            //A stored entry has to be the same size either way.
+            if (record.entry.stored && record.entry.compressedSize != record.entry.size) {
+                success = false;
+            }
+            success = success && addRecord(mount, &record);
+            if (!success) {
+                free(name);
+            }
+        }
+        err = mz_zip_goto_next_entry(zip);
+    }
+    if (err != MZ_END_OF_LIST) {
+        success = false;
+    }
+
+    if (zip != NULL) {
+        mz_zip_close(zip);
+        mz_zip_delete(&zip);
+    }
+    if (stream != NULL) {
+        mz_stream_os_close(stream);
+        mz_stream_os_delete(&stream);
+    }
+    if (!success || !buildTable(mount)) {
+        ZipMountClose(mount);
+        return NULL;
+    }
+    return mount;
+}
+
+void ZipMountClose(ZipMount *mount)
+{
+    if (mount == NULL) {
+        return;
+    }
+    for (int i = 0; i < ZIP_MOUNT_CURSORS; i++) {
+        if (mount->cursors[i].initialised) {
+            inflateEnd(&mount->cursors[i].stream);
+        }
+    }
+    for (int i = 0; i < ZIP_MOUNT_CACHED_BLOCKS; i++) {
+        free(mount->blocks[i].data);
+    }
+    for (size_t i = 0; i < mount->recordCount; i++) {
+        free((char *)mount->records[i].entry.name);
+    }
+    free(mount->records);
+    free(mount->slots);
+    if (mount->mapping != NULL) {
+        munmap((void *)mount->mapping, mount->length);
+    }
+    pthread_mutex_destroy(&mount->cacheLock);
+    free(mount);
+}
+
+size_t ZipMountEntryCount(const ZipMount *mount)
+{
+    return mount->recordCount;
+}
+
+const ZipMountEntry *ZipMountEntryAtIndex(const ZipMount *mount, size_t index)
+{
+    return index < mount->recordCount ? &mount->records[index].entry : NULL;
+}
+
+const ZipMountEntry *ZipMountFind(const ZipMount *mount, const char *name, size_t nameLength)
+{
+    size_t *slot = findSlot(mount, name, nameLength);
+    if (slot == NULL || *slot == 0) {
+        return NULL;
+    }
+    return &mount->records[*slot - 1].entry;
+}
+
+const void *ZipMountMapEntry(ZipMount *mount, const ZipMountEntry *entry)
+{
+    //The entry is the first member of its record.
+    const ZipMountRecord *record = (const ZipMountRecord *)entry;
+    if (!entry->stored) {
+        return NULL;
+    }
+    uint64_t offset = dataOffset(mount, record);
+    return offset > 0 ? mount->mapping + offset : NULL;
+}
+
+bool ZipMountReadEntry(ZipMount *mount, const ZipMountEntry *entry, void *buffer)
+{
+    const ZipMountRecord *record = (const ZipMountRecord *)entry;
+    uint64_t offset = dataOffset(mount, record);
+    if (offset == 0) {
+        return false;
+    }
+    if (entry->stored) {
+        memcpy(buffer, mount->mapping + offset, (size_t)entry->size);
+    } else {
+        //Inflate the lot in one go, without going through the block cache.
+        ZipMountCursor cursor;
+        memset(&cursor, 0, sizeof(cursor));
+        cursor.record = record;
+        if (inflateInit2(&cursor.stream, -MAX_WBITS) != Z_OK) {
+            return false;
+        }
+        cursor.initialised = true;
+        bool success = inflateBytes(mount, &cursor, buffer, (size_t)entry->size);
+        inflateEnd(&cursor.stream);
+        if (!success) {
+            return false;
+        }
+    }
+
+    uint32_t crc = 0;
+    const uint8_t *bytes = buffer;
+    for (uint64_t checked = 0; checked < entry->size; checked += INT32_MAX) {
+        uint64_t length = entry->size - checked < INT32_MAX ? entry->size - checked : INT32_MAX;
+        crc = mz_crypt_crc32_update(crc, bytes + checked, (int32_t)length);
+    }
+    return crc == entry->crc;
+}
+
+ssize_t ZipMountReadRange(ZipMount *mount, const ZipMountEntry *entry, uint64_t offset, void *buffer, size_t length)
+{
+    const ZipMountRecord *record = (const ZipMountRecord *)entry;
+    if (offset >= entry->size) {
+        return 0;
+    }
+    if (length > entry->size - offset) {
+        length = (size_t)(entry->size - offset);
+    }
+    if (length > SSIZE_MAX) {
+        length = SSIZE_MAX;
+    }
+    uint64_t start = dataOffset(mount, record);
+    if (start == 0) {
+        return -1;
+    }
+    if (entry->stored) {
+        memcpy(buffer, mount->mapping + start + offset, length);
+        return (ssize_t)length;
+    }
+
+    uint8_t *output = buffer;
+    size_t copied = 0;
+    pthread_mutex_lock(&mount->cacheLock);
+    while (copied < length) {
+        uint64_t position = offset + copied;
+        ZipMountBlock *block = cachedBlock(mount, record, position / ZIP_MOUNT_BLOCK_LENGTH);
+        if (block == NULL) {
+            pthread_mutex_unlock(&mount->cacheLock);
+            return -1;
+        }
+        size_t blockOffset = (size_t)(position % ZIP_MOUNT_BLOCK_LENGTH);
+        size_t count = block->length - blockOffset < length - copied ? block->length - blockOffset : length - copied;
+        memcpy(output + copied, block->data + blockOffset, count);
+        copied += count;
+    }
+    pthread_mutex_unlock(&mount->cacheLock);
+    return (ssize_t)copied;
+}
+
+bool ZipMountVerifyEntry(ZipMount *mount, const ZipMountEntry *entry)
+{
+    const ZipMountRecord *record = (const ZipMountRecord *)entry;
+    uint64_t offset = dataOffset(mount, record);
+    if (offset == 0) {
+        return false;
+    }
+    if (entry->stored) {
+        return Crc32Update(0, mount->mapping + offset, (size_t)entry->size) == entry->crc;
+    }
+
+    uint8_t *block = malloc(ZIP_MOUNT_BLOCK_LENGTH);
+    ZipMountCursor cursor;
+    memset(&cursor, 0, sizeof(cursor));
+    cursor.record = record;
+    if (block == NULL || inflateInit2(&cursor.stream, -MAX_WBITS) != Z_OK) {
+        free(block);
+        return false;
+    }
+    uint32_t crc = 0;
+    bool success = true;
+    while (success && cursor.position < entry->size) {
+        uint64_t remaining = entry->size - cursor.position;
+        size_t length = remaining > ZIP_MOUNT_BLOCK_LENGTH ? ZIP_MOUNT_BLOCK_LENGTH : (size_t)remaining;
+        success = inflateBytes(mount, &cursor, block, length);
+        if (success) {
+            crc = Crc32Update(crc, block, length);
+        }
+    }
+    inflateEnd(&cursor.stream);
+    free(block);
+    return success && crc == entry->crc;
+}
+
+#pragma mark - Private functions
+
+static uint64_t hashName(const char *name, size_t length)
+{
+    //FNV-1a.
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static size_t *findSlot(const ZipMount *mount, const char *name, size_t length)
+{
+    //Returns the slot holding the name, or the empty slot where it would go.
+    if (mount->slots == NULL) {
+        return NULL;
+    }
+    size_t index = (size_t)hashName(name, length) & mount->slotMask;
+    while (mount->slots[index] != 0) {
+        const ZipMountEntry *entry = &mount->records[mount->slots[index] - 1].entry;
+        if (entry->nameLength == length && memcmp(entry->name, name, length) == 0) {
+            break;
+        }
+        index = (index + 1) & mount->slotMask;
+    }
+    return &mount->slots[index];
+}
+
+static bool addRecord(ZipMount *mount, const ZipMountRecord *record)
+{
+    if (mount->recordCount == mount->recordCapacity) {
+        size_t capacity = mount->recordCapacity > 0 ? mount->recordCapacity * 2 : 64;
+        ZipMountRecord *records = realloc(mount->records, capacity * sizeof(ZipMountRecord));
+        if (records == NULL) {
+            return false;
+        }
+        mount->records = records;
+        mount->recordCapacity = capacity;
+    }
+    mount->records[mount->recordCount].entry = record->entry;
+    mount->records[mount->recordCount].localHeaderOffset = record->localHeaderOffset;
+    atomic_init(&mount->records[mount->recordCount].dataOffset, 0);
+    mount->recordCount++;
+    return true;
+}
+
+static bool buildTable(ZipMount *mount)
+{
+    //Keep the table at most half full.
+    size_t capacity = 16;
+    while (capacity < mount->recordCount * 2) {
+        capacity *= 2;
+    }
+    mount->slots = calloc(capacity, sizeof(size_t));
+    if (mount->slots == NULL) {
+        return false;
+    }
+    mount->slotMask = capacity - 1;
+
+    //Where the same name appears twice the later entry wins, as it would when extracting. The
+    //earlier one is dropped from the list altogether.
+    size_t kept = 0;
+    for (size_t i = 0; i < mount->recordCount; i++) {
+        ZipMountRecord *record = &mount->records[i];
+        size_t *slot = findSlot(mount, record->entry.name, record->entry.nameLength);
+        if (*slot != 0) {
+            ZipMountRecord *earlier = &mount->records[*slot - 1];
+            free((char *)earlier->entry.name);
+            earlier->entry = record->entry;
+            earlier->localHeaderOffset = record->localHeaderOffset;
+            continue;
+        }
+        if (kept != i) {
+            mount->records[kept].entry = record->entry;
+            mount->records[kept].localHeaderOffset = record->localHeaderOffset;
+        }
+        *slot = ++kept;
+    }
+    mount->recordCount = kept;
+    return true;
+}
+
+static uint64_t dataOffset(ZipMount *mount, const ZipMountRecord *record)
+{
+    //Returns 0 if the local header is damaged or the data runs past the end of the archive.
+    ZipMountRecord *mutableRecord = (ZipMountRecord *)record;
+    uint64_t offset = atomic_load_explicit(&mutableRecord->dataOffset, memory_order_relaxed);
+    if (offset > 0) {
+        return offset;
+    }
+
+    uint64_t header = record->localHeaderOffset;
+    if (header > mount->length || mount->length - header < ZIP_MOUNT_LOCAL_HEADER_LENGTH) {
+        return 0;
+    }
+    const uint8_t *bytes = mount->mapping + header;
+    uint32_t magic = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    if (magic != ZIP_MOUNT_LOCAL_HEADER_MAGIC) {
+        return 0;
+    }
+    uint64_t nameLength = (uint64_t)bytes[26] | ((uint64_t)bytes[27] << 8);
+    uint64_t extraLength = (uint64_t)bytes[28] | ((uint64_t)bytes[29] << 8);
+    offset = header + ZIP_MOUNT_LOCAL_HEADER_LENGTH + nameLength + extraLength;
+    if (offset > mount->length || mount->length - offset < record->entry.compressedSize) {
+        return 0;
+    }
+    //Every thread works out the same value, so it doesn't matter who stores it first.
+    atomic_store_explicit(&mutableRecord->dataOffset, offset, memory_order_relaxed);
+    return offset;
+}
+
+static bool inflateBytes(ZipMount *mount, ZipMountCursor *cursor, uint8_t *buffer, size_t length)
+{
+    //Carries on inflating the cursor's entry, straight from the mapping. The input is fed in no
+    //more than UINT_MAX bytes at a time since that's as much as zlib takes.
+    const ZipMountRecord *record = cursor->record;
+    uint64_t start = dataOffset(mount, record);
+    if (start == 0 || length > record->entry.size - cursor->position) {
+        return false;
+    }
+    size_t produced = 0;
+    while (produced < length) {
+        if (cursor->stream.avail_in == 0) {
+            uint64_t consumed = (uint64_t)(cursor->stream.next_in != NULL ? cursor->stream.next_in - (mount->mapping + start) : 0);
+            uint64_t remaining = record->entry.compressedSize - consumed;
+            cursor->stream.next_in = (Bytef *)(mount->mapping + start + consumed);
+            cursor->stream.avail_in = remaining > UINT_MAX ? UINT_MAX : (uInt)remaining;
+        }
+        size_t wanted = length - produced;
+        cursor->stream.next_out = buffer + produced;
+        cursor->stream.avail_out = wanted > UINT_MAX ? UINT_MAX : (uInt)wanted;
+        uInt available = cursor->stream.avail_out;
+        int result = inflate(&cursor->stream, Z_NO_FLUSH);
+        size_t count = available - cursor->stream.avail_out;
+        produced += count;
+        cursor->position += count;
+        if (result == Z_STREAM_END) {
+            break;
+        }
+        if (result != Z_OK && !(result == Z_BUF_ERROR && count > 0)) {
+            return false;
+        }
+    }
+    return produced == length;
+}
+
+static ZipMountCursor *cursorForBlock(ZipMount *mount, const ZipMountRecord *record, uint64_t block)
+{
+    //Must be called with the cache lock held. Finds the cursor that has got furthest through
+    //the entry without passing the block, or starts the entry again in the least recently used.
+    uint64_t target = block * ZIP_MOUNT_BLOCK_LENGTH;
+    ZipMountCursor *best = NULL;
+    ZipMountCursor *oldest = &mount->cursors[0];
+    for (int i = 0; i < ZIP_MOUNT_CURSORS; i++) {
+        ZipMountCursor *cursor = &mount->cursors[i];
+        if (cursor->initialised && cursor->record == record && cursor->position <= target && (best == NULL || cursor->position > best->position)) {
+            best = cursor;
+        }
+        if (cursor->lastUse < oldest->lastUse) {
+            oldest = cursor;
+        }
+    }
+    if (best != NULL) {
+        return best;
+    }
+
+    if (oldest->initialised) {
+        inflateEnd(&oldest->stream);
+    }
+    memset(oldest, 0, sizeof(ZipMountCursor));
+    if (inflateInit2(&oldest->stream, -MAX_WBITS) != Z_OK) {
+        return NULL;
+    }
+    oldest->initialised = true;
+    oldest->record = record;
+    return oldest;
+}
+
+static ZipMountBlock *cachedBlock(ZipMount *mount, const ZipMountRecord *record, uint64_t block)
+{
+    //Must be called with the cache lock held.
+    ZipMountBlock *oldest = &mount->blocks[0];
+    for (int i = 0; i < ZIP_MOUNT_CACHED_BLOCKS; i++) {
+        ZipMountBlock *cached = &mount->blocks[i];
+        if (cached->data != NULL && cached->record == record && cached->block == block) {
+            cached->lastUse = ++mount->useCounter;
+            return cached;
+        }
+        if (cached->lastUse < oldest->lastUse) {
+            oldest = cached;
+        }
+    }
+
+    if (oldest->data == NULL) {
+        oldest->data = malloc(ZIP_MOUNT_BLOCK_LENGTH);
+        if (oldest->data == NULL) {
+            return NULL;
+        }
+    }
+    oldest->record = NULL;
+    ZipMountCursor *cursor = cursorForBlock(mount, record, block);
+    if (cursor == NULL) {
+        return NULL;
+    }
+    cursor->lastUse = ++mount->useCounter;
+
+    //Inflate up to the start of the block, using the block's own buffer to hold what's skipped.
+    uint64_t target = block * ZIP_MOUNT_BLOCK_LENGTH;
+    while (cursor->position < target) {
+        uint64_t skip = target - cursor->position;
+        if (!inflateBytes(mount, cursor, oldest->data, skip > ZIP_MOUNT_BLOCK_LENGTH ? ZIP_MOUNT_BLOCK_LENGTH : (size_t)skip)) {
+            cursor->record = NULL;
+            return NULL;
+        }
+    }
+    uint64_t remaining = record->entry.size - target;
+    size_t length = remaining > ZIP_MOUNT_BLOCK_LENGTH ? ZIP_MOUNT_BLOCK_LENGTH : (size_t)remaining;
+    if (!inflateBytes(mount, cursor, oldest->data, length)) {
+        cursor->record = NULL;
+        return NULL;
+    }
+    oldest->record = record;
+    oldest->block = block;
+    oldest->length = length;
+    oldest->lastUse = ++mount->useCounter;
+    return oldest;
+}
@@ -0,0 +1,65 @@
+//
+//  ZipMount.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Read only access to the files in a zip archive without extracting it. The central directory is
+//read once with minizip when the archive is mounted, and the entries are put in a hash table by
+//name. The archive itself is mapped into memory, so a stored (uncompressed) entry can be used as
+//a slice of the mapping with no copying at all. Deflated entries are inflated straight from the
+//mapping when they're read. Reading a whole entry inflates it into the caller's buffer and checks
+//its CRC; reading part of one goes through a small cache of inflated blocks, so that a run of
+//small reads through the same entry doesn't inflate it from the start each time.
+//Entry names are cleaned up with ZipPathClean, as ZipExtract does, so a file is found under the path
+//that extracting the archive would have given it. Directories and symbolic links are left out,
+//and encrypted archives and compression methods other than store and deflate aren't supported.
+
+#ifndef ZipMount_h
+#define ZipMount_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+typedef struct ZipMount ZipMount;
+
+typedef struct {
+    //Cleaned up, relative to the root of the archive, and NUL terminated.
+    const char *name;
+    size_t nameLength;
+    bool stored;
+    uint32_t crc;
+    uint64_t compressedSize;
+    uint64_t size;
+    time_t modified;
+} ZipMountEntry;
+
+//Returns NULL if the archive can't be read or uses something that isn't supported.
+ZipMount *ZipMountOpen(const char *archivePath);
+//Any slices of the mapping must no longer be in use.
+void ZipMountClose(ZipMount *mount);
+
+size_t ZipMountEntryCount(const ZipMount *mount);
+const ZipMountEntry *ZipMountEntryAtIndex(const ZipMount *mount, size_t index);
+//Returns NULL if there's no file by that name.
+const ZipMountEntry *ZipMountFind(const ZipMount *mount, const char *name, size_t nameLength);
+
+//Returns the contents of a stored entry straight from the mapping, or NULL if the entry is
+//deflated or its local header is damaged.
+const void *ZipMountMapEntry(ZipMount *mount, const ZipMountEntry *entry);
+//Reads a whole entry into a buffer of entry->size bytes. Fails if the data doesn't match its CRC.
+bool ZipMountReadEntry(ZipMount *mount, const ZipMountEntry *entry, void *buffer);
+//Reads part of an entry. Returns the number of bytes read, which is only short at the end of
+//the entry, or -1 on failure. Safe to call from several threads at once.
+ssize_t ZipMountReadRange(ZipMount *mount, const ZipMountEntry *entry, uint64_t offset, void *buffer, size_t length);
+//Checks an entry against its CRC without keeping any of it. Deflated entries are inflated a block
+//at a time, so this takes no more memory for a large entry than a small one. Safe to call from
+//several threads at once, and doesn't go through the block cache.
+bool ZipMountVerifyEntry(ZipMount *mount, const ZipMountEntry *entry);
+
+#endif /* ZipMount_h */
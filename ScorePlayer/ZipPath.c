@@ -0,0 +1,55 @@
+//
+//  ZipPath.c
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ZipPath.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+char *ZipPathClean(const char *name)
+{
+    errno = 0;
+    size_t length = strlen(name);
+    char *path = malloc(length + 1);
+    if (path == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    size_t pathLength = 0;
+    const char *component = name;
+    while (*component != '\0') {
+        size_t componentLength = strcspn(component, "/\\");
+        if (componentLength == 2 && component[0] == '.' && component[1] == '.') {
+            //Go up a level, but never above the root.
+            while (pathLength > 0 && path[pathLength - 1] != '/') {
+                pathLength--;
+            }
+            if (pathLength > 0) {
+                pathLength--;
+            }
+        } else if (componentLength > 0 && !(componentLength == 1 && component[0] == '.')) {
+            if (pathLength > 0) {
+                path[pathLength++] = '/';
+            }
+            memcpy(path + pathLength, component, componentLength);
+            pathLength += componentLength;
+        }
+        component += componentLength;
+        if (*component != '\0') {
+            component++;
+        }
+    }
+
+    if (pathLength == 0) {
+        free(path);
+        return NULL;
+    }
+    path[pathLength] = '\0';
+    return path;
+}
@@ -0,0 +1,21 @@
+//
+//  ZipPath.h
+//  ScorePlayer
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Cleans up the names of zip entries, for ZipExtract and ZipMount, so that a file is found in a
+//mounted archive under the same path that extracting the archive would have given it.
+
+#ifndef ZipPath_h
+#define ZipPath_h
+
+//Returns a copy of the name, relative to the root of the archive, with "/" and "\" both treated
+//as separators, empty and "." components removed, and ".." resolved without ever leaving the
+//root. Returns NULL (with errno set to ENOMEM if that's the reason) if nothing is left of the
+//name. The caller frees the copy.
+char *ZipPathClean(const char *name);
+
+#endif /* ZipPath_h */
@@ -0,0 +1,295 @@
+//
+//  AssetStoreTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "AssetStore.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAXIMUM_WORKERS 4
+#define SHARED_FILE_COUNT 12
+
+static char directory[CORE_TEST_PATH_LENGTH];
+static char storePath[CORE_TEST_PATH_LENGTH];
+
+typedef struct {
+    const char *path;
+    bool success;
+} IngestionThread;
+
+static void *runWorker(void *ingestion)
+{
+    return AssetStoreIngestionRunWorker(ingestion) ? ingestion : NULL;
+}
+
+static bool ingest(const char *score, AssetStoreProgress *progress)
+{
+    static const char *excludedNames[] = {"cache", NULL};
+    AssetStoreIngestion *ingestion = AssetStoreIngestionOpen(storePath, score, excludedNames);
+    if (ingestion == NULL) {
+        return false;
+    }
+    size_t workerCount = AssetStoreIngestionWorkerCount(ingestion, MAXIMUM_WORKERS);
+    pthread_t workers[MAXIMUM_WORKERS];
+    for (size_t i = 0; i < workerCount; i++) {
+        pthread_create(&workers[i], NULL, runWorker, ingestion);
+    }
+    bool success = true;
+    for (size_t i = 0; i < workerCount; i++) {
+        void *result;
+        pthread_join(workers[i], &result);
+        success = success && result != NULL;
+    }
+    if (progress != NULL) {
+        AssetStoreIngestionGetProgress(ingestion, progress);
+    }
+    AssetStoreIngestionClose(ingestion);
+    return success;
+}
+
+static void *runIngestion(void *context)
+{
+    IngestionThread *thread = context;
+    thread->success = ingest(thread->path, NULL);
+    return NULL;
+}
+
+static void writeFile(const char *score, const char *name, const char *contents)
+{
+    char path[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(score, name, path);
+    CoreTestWriteFile(path, contents, strlen(contents));
+}
+
+static void makeScore(const char *score, const char *name)
+{
+    //Pages shared with other scores, a page of its own, and a cache that isn't stored.
+    char path[CORE_TEST_PATH_LENGTH], contents[64];
+    mkdir(score, 0755);
+    CoreTestPath(score, "pages", path);
+    mkdir(path, 0755);
+    CoreTestPath(score, "cache", path);
+    mkdir(path, 0755);
+    writeFile(score, "pages/shared.png", "a page that every score has");
+    writeFile(score, "pages/copy.png", "a page that every score has");
+    snprintf(contents, sizeof(contents), "<score name=\"%s\"/>", name);
+    writeFile(score, "score.xml", contents);
+    writeFile(score, "cache/tile", "a page that every score has");
+}
+
+static bool statFile(const char *score, const char *name, struct stat *status)
+{
+    char path[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(score, name, path);
+    return lstat(path, status) == 0;
+}
+
+static bool fileContains(const char *score, const char *name, const char *contents)
+{
+    char path[CORE_TEST_PATH_LENGTH], buffer[128];
+    CoreTestPath(score, name, path);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    size_t length = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+    return length == strlen(contents) && memcmp(buffer, contents, length) == 0;
+}
+
+static size_t storedFileCount(void)
+{
+    size_t count = 0;
+    DIR *store = opendir(storePath);
+    if (store == NULL) {
+        return 0;
+    }
+    struct dirent *group;
+    while ((group = readdir(store)) != NULL) {
+        char groupPath[CORE_TEST_PATH_LENGTH];
+        if (strlen(group->d_name) != 2 || strcmp(group->d_name, "..") == 0) {
+            continue;
+        }
+        CoreTestPath(storePath, group->d_name, groupPath);
+        DIR *files = opendir(groupPath);
+        struct dirent *file;
+        while (files != NULL && (file = readdir(files)) != NULL) {
+            count += file->d_name[0] != '.';
+        }
+        if (files != NULL) {
+            closedir(files);
+        }
+    }
+    closedir(store);
+    return count;
+}
+
+static void testDigests(void)
+{
+    static const uint8_t abc[ASSET_STORE_DIGEST_LENGTH] = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+    };
+    uint8_t digest[ASSET_STORE_DIGEST_LENGTH];
+    char path[CORE_TEST_PATH_LENGTH];
+    AssetStoreDigestBytes((const uint8_t *)"abc", 3, digest);
+    CORE_TEST_ASSERT(memcmp(digest, abc, sizeof(abc)) == 0);
+    CoreTestPath(directory, "abc", path);
+    CoreTestWriteFile(path, "abc", 3);
+    memset(digest, 0, sizeof(digest));
+    CORE_TEST_ASSERT(AssetStoreDigestFile(path, digest) && memcmp(digest, abc, sizeof(abc)) == 0);
+    CoreTestPath(directory, "missing", path);
+    CORE_TEST_ASSERT(!AssetStoreDigestFile(path, digest));
+}
+
+static void testDeduplication(void)
+{
+    //Identical files within a score and across scores end up as one stored file, with a link
+    //from each. Files of a score's own are stored too, and excluded ones are left alone.
+    char first[CORE_TEST_PATH_LENGTH], second[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "first", first);
+    CoreTestPath(directory, "second", second);
+    makeScore(first, "first");
+    makeScore(second, "second");
+
+    AssetStoreProgress progress;
+    CORE_TEST_ASSERT(ingest(first, &progress));
+    CORE_TEST_ASSERT(progress.fileCount == 3 && progress.ingestedFiles == 3);
+    //The second copy of the shared page is shared with the first.
+    CORE_TEST_ASSERT(progress.sharedBytes == 27);
+    CORE_TEST_ASSERT(ingest(second, &progress));
+    CORE_TEST_ASSERT(progress.sharedBytes == 2 * 27);
+    CORE_TEST_ASSERT(storedFileCount() == 3);
+
+    struct stat shared, copy, otherShared, own, cache;
+    CORE_TEST_ASSERT(statFile(first, "pages/shared.png", &shared) && statFile(first, "pages/copy.png", &copy) && statFile(second, "pages/shared.png", &otherShared));
+    CORE_TEST_ASSERT(shared.st_ino == copy.st_ino && shared.st_ino == otherShared.st_ino);
+    //Four copies in the scores, and the store's own.
+    CORE_TEST_ASSERT(shared.st_nlink == 5);
+    CORE_TEST_ASSERT((shared.st_mode & (S_IWUSR | S_IWGRP | S_IWOTH)) == 0);
+    CORE_TEST_ASSERT(statFile(first, "score.xml", &own) && own.st_nlink == 2);
+    CORE_TEST_ASSERT(statFile(first, "cache/tile", &cache) && cache.st_nlink == 1);
+    CORE_TEST_ASSERT(fileContains(second, "score.xml", "<score name=\"second\"/>"));
+
+    //Storing a score again changes nothing.
+    CORE_TEST_ASSERT(ingest(first, &progress));
+    CORE_TEST_ASSERT(storedFileCount() == 3);
+    CORE_TEST_ASSERT(statFile(first, "pages/shared.png", &shared) && shared.st_nlink == 5);
+}
+
+static void testGarbageCollection(void)
+{
+    //Stored files are kept for as long as any score links to them.
+    char first[CORE_TEST_PATH_LENGTH], second[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "first", first);
+    CoreTestPath(directory, "second", second);
+    CORE_TEST_ASSERT(AssetStoreCollectGarbage(storePath) == 0);
+    CORE_TEST_ASSERT(storedFileCount() == 3);
+
+    CoreTestRemoveDirectory(first);
+    CORE_TEST_ASSERT(AssetStoreCollectGarbage(storePath) == strlen("<score name=\"first\"/>"));
+    CORE_TEST_ASSERT(storedFileCount() == 2);
+    struct stat shared;
+    CORE_TEST_ASSERT(statFile(second, "pages/shared.png", &shared) && shared.st_nlink == 3);
+    CORE_TEST_ASSERT(fileContains(second, "pages/shared.png", "a page that every score has"));
+
+    //A score file that's been replaced (rather than changed in place) no longer holds on to
+    //the stored copy.
+    writeFile(second, "score.xml.new", "<score name=\"renamed\"/>");
+    char from[CORE_TEST_PATH_LENGTH], to[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(second, "score.xml.new", from);
+    CoreTestPath(second, "score.xml", to);
+    CORE_TEST_ASSERT(rename(from, to) == 0);
+    CORE_TEST_ASSERT(AssetStoreCollectGarbage(storePath) == strlen("<score name=\"second\"/>"));
+    CORE_TEST_ASSERT(fileContains(second, "score.xml", "<score name=\"renamed\"/>"));
+
+    CoreTestRemoveDirectory(second);
+    CORE_TEST_ASSERT(AssetStoreCollectGarbage(storePath) == 27);
+    CORE_TEST_ASSERT(storedFileCount() == 0);
+}
+
+static void *collectGarbage(void *running)
+{
+    while (atomic_load((atomic_bool *)running)) {
+        AssetStoreCollectGarbage(storePath);
+    }
+    return NULL;
+}
+
+static void testConcurrentIngestion(void)
+{
+    //Two scores with the same files are stored at once, so that both race to put each one in
+    //the store. In the second round the garbage collector runs the whole time as well, which can
+    //take a stored file away part way through. Either way, every score keeps its files intact.
+    char names[2][CORE_TEST_PATH_LENGTH], name[64], contents[64];
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 2; i++) {
+            snprintf(name, sizeof(name), "race%d-%d", round, i);
+            CoreTestPath(directory, name, names[i]);
+            mkdir(names[i], 0755);
+            for (int j = 0; j < SHARED_FILE_COUNT; j++) {
+                snprintf(name, sizeof(name), "%d.png", j);
+                snprintf(contents, sizeof(contents), "page %d of round %d", j, round);
+                writeFile(names[i], name, contents);
+            }
+        }
+
+        atomic_bool running;
+        atomic_init(&running, round == 1);
+        pthread_t collector;
+        if (round == 1) {
+            pthread_create(&collector, NULL, collectGarbage, &running);
+        }
+        IngestionThread threads[2] = {{names[0], false}, {names[1], false}};
+        pthread_t ingestionThreads[2];
+        for (int i = 0; i < 2; i++) {
+            pthread_create(&ingestionThreads[i], NULL, runIngestion, &threads[i]);
+        }
+        for (int i = 0; i < 2; i++) {
+            pthread_join(ingestionThreads[i], NULL);
+            CORE_TEST_ASSERT(threads[i].success);
+        }
+        if (round == 1) {
+            atomic_store(&running, false);
+            pthread_join(collector, NULL);
+        }
+
+        bool intact = true, shared = true;
+        for (int j = 0; j < SHARED_FILE_COUNT; j++) {
+            struct stat first, second;
+            snprintf(name, sizeof(name), "%d.png", j);
+            snprintf(contents, sizeof(contents), "page %d of round %d", j, round);
+            intact = intact && fileContains(names[0], name, contents) && fileContains(names[1], name, contents);
+            shared = shared && statFile(names[0], name, &first) && statFile(names[1], name, &second) && first.st_ino == second.st_ino && first.st_nlink == 3;
+        }
+        CORE_TEST_ASSERT(intact);
+        //With nothing collected, whichever score lost the race was linked to the winner's copy.
+        CORE_TEST_ASSERT(round == 1 || shared);
+        CoreTestRemoveDirectory(names[0]);
+        CoreTestRemoveDirectory(names[1]);
+    }
+    AssetStoreCollectGarbage(storePath);
+    CORE_TEST_ASSERT(storedFileCount() == 0);
+}
+
+void AssetStoreTests(void)
+{
+    CORE_TEST_ASSERT(CoreTestMakeDirectory("AssetStoreTests", directory));
+    CoreTestPath(directory, "store", storePath);
+    testDigests();
+    testDeduplication();
+    testGarbageCollection();
+    testConcurrentIngestion();
+    CoreTestRemoveDirectory(directory);
+}
@@ -0,0 +1,222 @@
+//
+//  ControlSchedulingTests.m
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ControlSchedulingTests.h"
+#import "ControlScheduler.h"
+#import "ClockSync.h"
+
+static const NSTimeInterval LEAD_TIME = 0.15;
+static const NSTimeInterval SIMULATION_STEP = 0.0001;
+static const int LOOPBACK_CLIENTS = 4;
+static const int LOOPBACK_PINGS = 30;
+
+//A client on the simulated network: how far its clock is from the master's, and the one way
+//latency of its link in each direction (plus up to the given jitter).
+typedef struct {
+    double clockOffset;
+    double downLatency;
+    double upLatency;
+    double jitter;
+} LoopbackLink;
+
+@interface ControlSchedulingTests ()
+
+- (double)latency:(double)latency jitter:(double)jitter;
+
+@end
+
+@implementation ControlSchedulingTests {
+    uint32_t randomState;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    randomState = 1;
+}
+
+- (void)testControlsKeepTheirOrder
+{
+    __block NSTimeInterval now = 0;
+    ControlScheduler *scheduler = [[ControlScheduler alloc] init];
+    scheduler.timeSource = ^{
+        return now;
+    };
+    
+    //A seek and a pause arriving while a play is still waiting shouldn't displace it.
+    NSMutableArray *fired = [[NSMutableArray alloc] init];
+    [scheduler performAtTime:0.15 block:^{
+        [fired addObject:@"Play"];
+    }];
+    [scheduler performAtTime:0.10 block:^{
+        [fired addObject:@"Seek"];
+    }];
+    [scheduler performAtTime:0.30 block:^{
+        [fired addObject:@"Pause"];
+    }];
+    [scheduler performAtTime:0.15 block:^{
+        [fired addObject:@"Play2"];
+    }];
+    XCTAssertEqual(scheduler.pendingCount, (NSUInteger)4);
+    
+    now = 0.05;
+    [scheduler fireDueControls];
+    XCTAssertEqual([fired count], (NSUInteger)0);
+    now = 0.2;
+    [scheduler fireDueControls];
+    NSArray *expected = [NSArray arrayWithObjects:@"Seek", @"Play", @"Play2", nil];
+    XCTAssertEqualObjects(fired, expected);
+    now = 0.3;
+    [scheduler fireDueControls];
+    XCTAssertEqualObjects([fired lastObject], @"Pause");
+    XCTAssertEqual(scheduler.pendingCount, (NSUInteger)0);
+    
+    //Controls scheduled from within a control run in their turn.
+    [fired removeAllObjects];
+    __weak ControlScheduler *weakScheduler = scheduler;
+    [scheduler performAtTime:0.4 block:^{
+        [fired addObject:@"First"];
+        [weakScheduler performAtTime:0.4 block:^{
+            [fired addObject:@"Nested"];
+        }];
+    }];
+    [scheduler performAtTime:0.4 block:^{
+        [fired addObject:@"Second"];
+    }];
+    now = 0.4;
+    [scheduler fireDueControls];
+    expected = [NSArray arrayWithObjects:@"First", @"Second", @"Nested", nil];
+    XCTAssertEqualObjects(fired, expected);
+    
+    //And a reset drops everything.
+    [scheduler performAtTime:1 block:^{
+        [fired addObject:@"Dropped"];
+    }];
+    [scheduler cancelAll];
+    now = 2;
+    [scheduler fireDueControls];
+    XCTAssertFalse([fired containsObject:@"Dropped"]);
+}
+
+- (void)testSystemClock
+{
+    //Without a time source the controls run from the main queue.
+    ControlScheduler *scheduler = [[ControlScheduler alloc] init];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Control"];
+    NSTimeInterval target = scheduler.now + 0.05;
+    __block NSTimeInterval firedAt = 0;
+    [scheduler performAtTime:target block:^{
+        firedAt = scheduler.now;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertGreaterThanOrEqual(firedAt, target);
+    XCTAssertLessThan(firedAt - target, 0.02);
+}
+
+- (void)testLoopbackStartSkew
+{
+    //A master and a set of clients on a simulated network. The clients' clocks are offset from
+    //the master's, and each link has its own latency, which isn't always symmetric.
+    LoopbackLink links[LOOPBACK_CLIENTS] = {
+        {2.5, 0.002, 0.002, 0.0005},
+        {-1.25, 0.010, 0.014, 0.002},
+        {0.004, 0.030, 0.026, 0.004},
+        {-37.0, 0.060, 0.065, 0.010},
+    };
+    
+    //Simulated true time, which is also the master's clock.
+    __block double now = 100;
+    
+    //Synchronise each client the way the primary server does, through Ping/Pong round trips.
+    //(The offset the server sends in /Server/ClockOffset is its ClockSync estimate.)
+    double estimatedOffsets[LOOPBACK_CLIENTS];
+    double uncertainties[LOOPBACK_CLIENTS];
+    for (int i = 0; i < LOOPBACK_CLIENTS; i++) {
+        ClockSync *clockSync = [[ClockSync alloc] init];
+        for (int j = 0; j < LOOPBACK_PINGS; j++) {
+            double start = now + j * 0.5;
+            double arrival = start + [self latency:links[i].downLatency jitter:links[i].jitter];
+            double remoteTime = arrival + links[i].clockOffset;
+            double end = arrival + [self latency:links[i].upLatency jitter:links[i].jitter];
+            [clockSync addSampleWithStartTime:start remoteTime:remoteTime endTime:end];
+        }
+        XCTAssertTrue(clockSync.isSynchronised);
+        estimatedOffsets[i] = [clockSync offsetAtTime:now + LOOPBACK_PINGS * 0.5];
+        uncertainties[i] = clockSync.uncertainty;
+    }
+    now += LOOPBACK_PINGS * 0.5 + 1;
+    
+    //Each client gets its own scheduler running on its own clock.
+    NSMutableArray *schedulers = [[NSMutableArray alloc] init];
+    for (int i = 0; i < LOOPBACK_CLIENTS; i++) {
+        ControlScheduler *scheduler = [[ControlScheduler alloc] init];
+        double clockOffset = links[i].clockOffset;
+        scheduler.timeSource = ^{
+            return now + clockOffset;
+        };
+        [schedulers addObject:scheduler];
+    }
+    
+    //The master schedules a play for LEAD_TIME from now, in its own clock. Each client receives it
+    //after its link's latency and converts the time into its own clock, as PlayerCore does.
+    double target = now + LEAD_TIME;
+    double arrivals[LOOPBACK_CLIENTS];
+    BOOL received[LOOPBACK_CLIENTS];
+    double startTimes[LOOPBACK_CLIENTS];
+    for (int i = 0; i < LOOPBACK_CLIENTS; i++) {
+        arrivals[i] = now + [self latency:links[i].downLatency jitter:links[i].jitter];
+        received[i] = NO;
+        startTimes[i] = -1;
+    }
+    double masterStart = target;
+    
+    double end = target + 1;
+    while (now < end) {
+        now += SIMULATION_STEP;
+        for (int i = 0; i < LOOPBACK_CLIENTS; i++) {
+            ControlScheduler *scheduler = [schedulers objectAtIndex:i];
+            if (!received[i] && now >= arrivals[i]) {
+                received[i] = YES;
+                double localTarget = target + estimatedOffsets[i];
+                XCTAssertGreaterThan(localTarget, scheduler.now);
+                double *startTime = &startTimes[i];
+                [scheduler performAtTime:localTarget block:^{
+                    *startTime = now;
+                }];
+            }
+            [scheduler fireDueControls];
+        }
+    }
+    
+    //Every client should start within its clock uncertainty (plus a simulation step) of the
+    //master, regardless of how long its link is.
+    double earliest = masterStart, latest = masterStart;
+    for (int i = 0; i < LOOPBACK_CLIENTS; i++) {
+        XCTAssertGreaterThan(startTimes[i], 0);
+        XCTAssertLessThanOrEqual(fabs(startTimes[i] - masterStart), uncertainties[i] + SIMULATION_STEP);
+        earliest = MIN(earliest, startTimes[i]);
+        latest = MAX(latest, startTimes[i]);
+    }
+    //An asymmetric link leaves a client out by about half the asymmetry, so the skew here should
+    //be a few milliseconds. Without scheduling it would be the spread of the link latencies
+    //(around 65 ms).
+    XCTAssertLessThan(latest - earliest, 0.01);
+    NSLog(@"Loopback start skew: %.3f ms", (latest - earliest) * 1000);
+}
+
+#pragma mark - Private methods
+
+- (double)latency:(double)latency jitter:(double)jitter
+{
+    //A small deterministic generator so that failures can be repeated.
+    randomState = randomState * 1664525 + 1013904223;
+    return latency + jitter * (randomState >> 8) / (double)(1 << 24);
+}
+
+@end
@@ -0,0 +1,95 @@
+//
+//  CoreTest.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+//Some suites check things from more than one thread.
+static size_t failureCount = 0;
+
+void CoreTestCheck(bool passed, const char *expression, const char *file, int line)
+{
+    if (!passed) {
+        __atomic_add_fetch(&failureCount, 1, __ATOMIC_RELAXED);
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    }
+}
+
+size_t CoreTestRun(const char *name, void (*function)(void))
+{
+    size_t failuresBefore = __atomic_load_n(&failureCount, __ATOMIC_RELAXED);
+    double start = CoreTestTime();
+    function();
+    size_t failures = __atomic_load_n(&failureCount, __ATOMIC_RELAXED) - failuresBefore;
+    fprintf(stderr, "%s: %s (%.2f s)\n", name, failures == 0 ? "passed" : "FAILED", CoreTestTime() - start);
+    return failures;
+}
+
+double CoreTestTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+uint32_t CoreTestRandom(uint64_t *state)
+{
+    //SplitMix64, which is good enough for picking test cases.
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+void CoreTestReport(const char *name, double value, const char *unit)
+{
+    fprintf(stderr, "benchmark: %-48s %12.3f %s\n", name, value, unit);
+}
+
+bool CoreTestMakeDirectory(const char *prefix, char *directory)
+{
+    const char *temporary = getenv("TMPDIR");
+    snprintf(directory, CORE_TEST_PATH_LENGTH, "%s/%s.XXXXXX", temporary == NULL ? "/tmp" : temporary, prefix);
+    if (mkdtemp(directory) == NULL) {
+        directory[0] = '\0';
+        return false;
+    }
+    return true;
+}
+
+static int removeItem(const char *path, const struct stat *status, int type, struct FTW *position)
+{
+    remove(path);
+    return 0;
+}
+
+void CoreTestRemoveDirectory(const char *directory)
+{
+    if (directory[0] != '\0') {
+        nftw(directory, removeItem, 16, FTW_DEPTH | FTW_PHYS);
+    }
+}
+
+void CoreTestPath(const char *directory, const char *name, char *path)
+{
+    snprintf(path, CORE_TEST_PATH_LENGTH, "%s/%s", directory, name);
+}
+
+bool CoreTestWriteFile(const char *path, const void *bytes, size_t length)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    bool success = fwrite(bytes, 1, length, file) == length;
+    return fclose(file) == 0 && success;
+}
@@ -0,0 +1,77 @@
+//
+//  CoreTest.h
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Support for the tests of the portable C cores. Each core has a suite of tests (and possibly a
+//benchmark) written in plain C, so that the same code runs from XCTest (see ScorePlayerTests.m)
+//and from the command line on Linux or macOS (see CoreTestMain.c and the Makefile).
+
+#ifndef CoreTest_h
+#define CoreTest_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//Records a failure (and where it happened) without stopping the suite.
+#define CORE_TEST_ASSERT(condition) CoreTestCheck((condition), #condition, __FILE__, __LINE__)
+
+void CoreTestCheck(bool passed, const char *expression, const char *file, int line);
+
+//Runs a suite or benchmark and returns the number of failures it recorded.
+size_t CoreTestRun(const char *name, void (*function)(void));
+
+//A monotonic time in seconds.
+double CoreTestTime(void);
+//A small generator with its state kept by the caller, so that a failing randomised test can be
+//repeated exactly.
+uint32_t CoreTestRandom(uint64_t *state);
+//Prints a benchmark figure in a form that's easy to pick out of the log.
+void CoreTestReport(const char *name, double value, const char *unit);
+
+//Scratch space for suites that work with files. A fresh directory is made under TMPDIR (the
+//buffer must hold CORE_TEST_PATH_LENGTH bytes), and removed along with everything in it.
+#define CORE_TEST_PATH_LENGTH 512
+bool CoreTestMakeDirectory(const char *prefix, char *directory);
+void CoreTestRemoveDirectory(const char *directory);
+//Joins a directory and a relative path into a CORE_TEST_PATH_LENGTH buffer.
+void CoreTestPath(const char *directory, const char *name, char *path);
+bool CoreTestWriteFile(const char *path, const void *bytes, size_t length);
+
+//The suites and benchmarks.
+void OSCViewTests(void);
+void TimingWheelTests(void);
+void TimingWheelBenchmark(void);
+void ImageCacheTests(void);
+void ImageDownscaleTests(void);
+void ImageDownscaleBenchmark(void);
+void RawTileCacheTests(void);
+void RawTileCacheBenchmark(void);
+void XMLReaderTests(void);
+void XMLReaderBenchmark(void);
+void ScoreBundleTests(void);
+void ScoreBundleBenchmark(void);
+void TrigramIndexTests(void);
+void TrigramIndexBenchmark(void);
+void ReadAheadStreamTests(void);
+void ReadAheadStreamBenchmark(void);
+void ScoreUpdateTests(void);
+void ScoreUpdateBenchmark(void);
+void ZipExtractTests(void);
+void ZipCompressTests(void);
+void ZipMountTests(void);
+void Crc32Tests(void);
+//Crc32Benchmark is taken by Crc32.h.
+void Crc32MethodsBenchmark(void);
+void ScoreVerifyTests(void);
+void AssetStoreTests(void);
+
+//Fuzz targets, which are also run by the suites. Each takes arbitrary input and returns false if
+//the core did something it shouldn't have. (The Makefile can build them for libFuzzer.)
+bool OSCViewFuzzCheck(const uint8_t *data, size_t size);
+
+#endif /* CoreTest_h */
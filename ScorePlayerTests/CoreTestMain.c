@@ -0,0 +1,76 @@
+//
+//  CoreTestMain.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Runs the core suites from the command line. (This isn't part of the Xcode test target, which
+//runs them through XCTest instead.)
+//    coretests [-b] [suite ...]
+//With -b the benchmarks are run rather than the tests. Either way, every suite is run unless
+//some are named.
+
+#include "CoreTest.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    void (*tests)(void);
+    void (*benchmark)(void);
+} CoreTestSuite;
+
+static const CoreTestSuite suites[] = {
+    {"OSCView", OSCViewTests, NULL},
+    {"TimingWheel", TimingWheelTests, TimingWheelBenchmark},
+    {"ImageCache", ImageCacheTests, NULL},
+    {"ImageDownscale", ImageDownscaleTests, ImageDownscaleBenchmark},
+    {"RawTileCache", RawTileCacheTests, RawTileCacheBenchmark},
+    {"XMLReader", XMLReaderTests, XMLReaderBenchmark},
+    {"ScoreBundle", ScoreBundleTests, ScoreBundleBenchmark},
+    {"TrigramIndex", TrigramIndexTests, TrigramIndexBenchmark},
+    {"ReadAheadStream", ReadAheadStreamTests, ReadAheadStreamBenchmark},
+    {"ScoreUpdate", ScoreUpdateTests, ScoreUpdateBenchmark},
+    {"ZipExtract", ZipExtractTests, NULL},
+    {"ZipCompress", ZipCompressTests, NULL},
+    {"ZipMount", ZipMountTests, NULL},
+    {"Crc32", Crc32Tests, Crc32MethodsBenchmark},
+    {"ScoreVerify", ScoreVerifyTests, NULL},
+    {"AssetStore", AssetStoreTests, NULL},
+};
+
+int main(int argc, char **argv)
+{
+    bool benchmarks = false;
+    int firstName = 1;
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        benchmarks = true;
+        firstName = 2;
+    }
+
+    size_t failures = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < sizeof(suites) / sizeof(CoreTestSuite); i++) {
+        bool selected = firstName >= argc;
+        for (int j = firstName; j < argc; j++) {
+            if (strcmp(argv[j], suites[i].name) == 0) {
+                selected = true;
+            }
+        }
+        void (*function)(void) = benchmarks ? suites[i].benchmark : suites[i].tests;
+        if (!selected || function == NULL) {
+            continue;
+        }
+        failures += CoreTestRun(suites[i].name, function);
+        count++;
+    }
+
+    if (count == 0) {
+        fprintf(stderr, "No matching suites\n");
+        return 2;
+    }
+    fprintf(stderr, "%zu failure%s\n", failures, failures == 1 ? "" : "s");
+    return failures == 0 ? 0 : 1;
+}
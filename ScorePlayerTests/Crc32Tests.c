@@ -0,0 +1,139 @@
+//
+//  Crc32Tests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "Crc32.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#define MAXIMUM_LENGTH 4096
+//Room to start anywhere within a few cache lines.
+#define MAXIMUM_MISALIGNMENT 63
+
+static uint8_t *createData(size_t length, uint64_t *state)
+{
+    uint8_t *data = malloc(length);
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (uint8_t)CoreTestRandom(state);
+    }
+    return data;
+}
+
+static uint32_t zlibCrc(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    return (uint32_t)crc32(crc, bytes, (uInt)length);
+}
+
+static void testAvailability(void)
+{
+    //Slicing-by-16 works everywhere, and zlib is always linked in here.
+    CORE_TEST_ASSERT(Crc32MethodAvailable(Crc32MethodSlicingBy16));
+    CORE_TEST_ASSERT(Crc32MethodAvailable(Crc32MethodZlib));
+    CORE_TEST_ASSERT(Crc32MethodAvailable(Crc32BestMethod()));
+    CORE_TEST_ASSERT(!Crc32MethodAvailable(Crc32MethodCount));
+    CORE_TEST_ASSERT(Crc32UpdateWithMethod(Crc32MethodCount, 1234, "123456789", 9) == 0);
+    for (int method = 0; method < Crc32MethodCount; method++) {
+        if (Crc32MethodAvailable(method)) {
+            CORE_TEST_ASSERT(Crc32UpdateWithMethod(method, 0, "123456789", 9) == 0xcbf43926);
+        }
+    }
+    CORE_TEST_ASSERT(Crc32Update(0, "123456789", 9) == 0xcbf43926);
+}
+
+static void testLengths(void)
+{
+    //Every length up to 4 KiB, both aligned and starting part way through a word, so that every
+    //method's head, body and tail handling is used on its own and together.
+    uint64_t state = 22;
+    uint8_t *data = createData(MAXIMUM_LENGTH + MAXIMUM_MISALIGNMENT + 1, &state);
+    for (int method = 0; method < Crc32MethodCount; method++) {
+        if (!Crc32MethodAvailable(method)) {
+            continue;
+        }
+        bool matches = true;
+        for (size_t length = 0; length <= MAXIMUM_LENGTH; length++) {
+            size_t starts[2] = {0, 1 + length % MAXIMUM_MISALIGNMENT};
+            for (int i = 0; i < 2; i++) {
+                const uint8_t *bytes = data + starts[i];
+                matches = matches && Crc32UpdateWithMethod(method, 0, bytes, length) == zlibCrc(0, bytes, length);
+            }
+        }
+        //A longer run at every misalignment.
+        for (size_t start = 0; start <= MAXIMUM_MISALIGNMENT; start++) {
+            matches = matches && Crc32UpdateWithMethod(method, 0, data + start, MAXIMUM_LENGTH) == zlibCrc(0, data + start, MAXIMUM_LENGTH);
+        }
+        CORE_TEST_ASSERT(matches);
+    }
+    free(data);
+}
+
+static void testChaining(void)
+{
+    //Splitting a buffer into pieces of random length (including empty ones) gives the same CRC
+    //as doing it in one go, whichever methods are used for the pieces.
+    uint64_t state = 23;
+    const size_t length = 100000;
+    uint8_t *data = createData(length, &state);
+    uint32_t expected = zlibCrc(0, data, length);
+    for (int method = 0; method < Crc32MethodCount; method++) {
+        if (!Crc32MethodAvailable(method)) {
+            continue;
+        }
+        bool matches = true;
+        for (int round = 0; round < 50; round++) {
+            uint32_t crc = 0;
+            size_t position = 0;
+            while (position < length) {
+                size_t pieceLength = CoreTestRandom(&state) % (round < 25 ? 40 : 5000);
+                if (pieceLength > length - position) {
+                    pieceLength = length - position;
+                }
+                //Every other piece goes through a method picked at random.
+                int pieceMethod = method;
+                if (CoreTestRandom(&state) % 2 == 0) {
+                    pieceMethod = CoreTestRandom(&state) % Crc32MethodCount;
+                    if (!Crc32MethodAvailable(pieceMethod)) {
+                        pieceMethod = Crc32MethodSlicingBy16;
+                    }
+                }
+                crc = Crc32UpdateWithMethod(pieceMethod, crc, data + position, pieceLength);
+                position += pieceLength;
+            }
+            matches = matches && crc == expected;
+        }
+        CORE_TEST_ASSERT(matches);
+    }
+    CORE_TEST_ASSERT(Crc32Update(Crc32Update(0, data, 12345), data + 12345, length - 12345) == expected);
+    free(data);
+}
+
+void Crc32Tests(void)
+{
+    testAvailability();
+    testLengths();
+    testChaining();
+}
+
+void Crc32MethodsBenchmark(void)
+{
+    //Throughput of each method on a small entry, a typical page image and a big recording.
+    const size_t lengths[] = {4096, 1024 * 1024, 64 * 1024 * 1024};
+    const char *lengthNames[] = {"4 KiB", "1 MiB", "64 MiB"};
+    char name[128];
+    for (int method = 0; method < Crc32MethodCount; method++) {
+        if (!Crc32MethodAvailable(method)) {
+            continue;
+        }
+        for (int i = 0; i < 3; i++) {
+            snprintf(name, sizeof(name), "Crc32 %s%s %s", Crc32MethodName(method), method == (int)Crc32BestMethod() ? " (best)" : "", lengthNames[i]);
+            CoreTestReport(name, Crc32Benchmark(method, lengths[i]) / 1e9, "GB/s");
+        }
+    }
+}
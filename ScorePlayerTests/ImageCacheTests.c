@@ -0,0 +1,186 @@
+//
+//  ImageCacheTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "ImageCache.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//Synthetic images, which only need to know whether they're still alive.
+typedef struct {
+    int identifier;
+    bool live;
+} Image;
+
+static size_t liveImages = 0;
+static bool releasedTwice = false;
+
+static void releaseImage(void *value, void *userData)
+{
+    Image *image = value;
+    releasedTwice = releasedTwice || !image->live;
+    image->live = false;
+    liveImages--;
+    free(image);
+}
+
+static Image *createImage(int identifier)
+{
+    Image *image = malloc(sizeof(Image));
+    image->identifier = identifier;
+    image->live = true;
+    liveImages++;
+    return image;
+}
+
+static int identifierForKey(ImageCache *cache, const char *key)
+{
+    Image *image = ImageCacheGet(cache, key);
+    return image == NULL ? -1 : image->identifier;
+}
+
+static void testEviction(void)
+{
+    ImageCache *cache = ImageCacheCreate(1000, releaseImage, NULL);
+    CORE_TEST_ASSERT(ImageCacheInsert(cache, "/Scores/a/1.png", createImage(1), 400));
+    CORE_TEST_ASSERT(ImageCacheInsert(cache, "/Scores/a/2.png", createImage(2), 400));
+
+    //Using the first image makes the second the least recently used.
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/a/1.png") == 1);
+    CORE_TEST_ASSERT(ImageCacheInsert(cache, "/Scores/b/3.png", createImage(3), 400));
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/a/2.png") == -1);
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/a/1.png") == 1);
+
+    ImageCacheStatistics statistics = ImageCacheGetStatistics(cache);
+    CORE_TEST_ASSERT(statistics.hits == 2 && statistics.misses == 1 && statistics.evictions == 1);
+    CORE_TEST_ASSERT(statistics.entryCount == 2 && statistics.bytesUsed == 800 && statistics.byteBudget == 1000);
+    CORE_TEST_ASSERT(liveImages == 2);
+
+    //Replacing a value releases the old one.
+    CORE_TEST_ASSERT(ImageCacheInsert(cache, "/Scores/a/1.png", createImage(4), 100));
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/a/1.png") == 4);
+    CORE_TEST_ASSERT(ImageCacheGetStatistics(cache).bytesUsed == 500);
+    CORE_TEST_ASSERT(liveImages == 2);
+
+    //Anything larger than the whole budget is turned away, and released.
+    CORE_TEST_ASSERT(!ImageCacheInsert(cache, "/Scores/c/huge.png", createImage(5), 2000));
+    CORE_TEST_ASSERT(liveImages == 2);
+
+    //Shrinking the budget evicts straight away. (The replacement counts as a use.)
+    ImageCacheSetByteBudget(cache, 450);
+    statistics = ImageCacheGetStatistics(cache);
+    CORE_TEST_ASSERT(statistics.entryCount == 1 && statistics.bytesUsed == 100);
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/a/1.png") == 4);
+
+    ImageCacheDestroy(cache);
+    CORE_TEST_ASSERT(liveImages == 0 && !releasedTwice);
+}
+
+static void testPinning(void)
+{
+    ImageCache *cache = ImageCacheCreate(1000, releaseImage, NULL);
+    ImageCacheInsert(cache, "/Scores/a/1.png", createImage(1), 400);
+    ImageCacheInsert(cache, "/Scores/a/2.png", createImage(2), 400);
+    CORE_TEST_ASSERT(!ImageCachePin(cache, "/Scores/a/missing.png"));
+
+    //A pinned image survives even as the least recently used, and pins are counted.
+    CORE_TEST_ASSERT(ImageCachePin(cache, "/Scores/a/1.png"));
+    CORE_TEST_ASSERT(ImageCachePin(cache, "/Scores/a/1.png"));
+    CORE_TEST_ASSERT(ImageCacheGetStatistics(cache).pinnedBytes == 400);
+    ImageCacheInsert(cache, "/Scores/a/3.png", createImage(3), 500);
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/a/1.png") == 1);
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/a/2.png") == -1);
+
+    ImageCacheUnpin(cache, "/Scores/a/1.png");
+    ImageCacheInsert(cache, "/Scores/a/4.png", createImage(4), 500);
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/a/1.png") == 1);
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/a/3.png") == -1);
+
+    //Once the last pin goes, it's fair game again.
+    ImageCacheUnpin(cache, "/Scores/a/1.png");
+    CORE_TEST_ASSERT(ImageCacheGetStatistics(cache).pinnedBytes == 0);
+    identifierForKey(cache, "/Scores/a/4.png");
+    ImageCacheInsert(cache, "/Scores/a/5.png", createImage(5), 500);
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/a/1.png") == -1);
+
+    ImageCacheDestroy(cache);
+    CORE_TEST_ASSERT(liveImages == 0 && !releasedTwice);
+}
+
+static void testDirectories(void)
+{
+    ImageCache *cache = ImageCacheCreate(1000, releaseImage, NULL);
+    ImageCacheInsert(cache, "/Scores/d/e/1.png", createImage(1), 10);
+    ImageCacheInsert(cache, "/Scores/d/2.png", createImage(2), 10);
+    ImageCacheInsert(cache, "/Scores/dd/3.png", createImage(3), 10);
+    ImageCacheInsert(cache, "/Scores/4.png", createImage(4), 10);
+
+    //Removing a directory takes its subdirectories, but not siblings that share a prefix.
+    CORE_TEST_ASSERT(ImageCacheRemoveDirectory(cache, "/Scores/d/") == 2);
+    CORE_TEST_ASSERT(identifierForKey(cache, "/Scores/dd/3.png") == 3);
+    CORE_TEST_ASSERT(ImageCacheRemoveDirectory(cache, "/Scores/d") == 0);
+    CORE_TEST_ASSERT(ImageCacheRemoveDirectory(cache, "/Scores") == 2);
+    CORE_TEST_ASSERT(ImageCacheGetStatistics(cache).entryCount == 0);
+    CORE_TEST_ASSERT(liveImages == 0);
+
+    ImageCacheInsert(cache, "/Scores/a/1.png", createImage(1), 10);
+    ImageCacheRemove(cache, "/Scores/a/1.png");
+    ImageCacheRemove(cache, "/Scores/a/1.png");
+    ImageCacheInsert(cache, "/Scores/a/2.png", createImage(2), 10);
+    ImageCacheRemoveAll(cache);
+    CORE_TEST_ASSERT(ImageCacheGetStatistics(cache).bytesUsed == 0 && liveImages == 0);
+    ImageCacheDestroy(cache);
+    CORE_TEST_ASSERT(!releasedTwice);
+}
+
+static void testRandomised(void)
+{
+    ImageCache *cache = ImageCacheCreate(3000, releaseImage, NULL);
+    uint64_t state = 1;
+    char key[64];
+    bool consistent = true;
+    for (int i = 0; i < 200000; i++) {
+        uint32_t operation = CoreTestRandom(&state) % 10;
+        snprintf(key, sizeof(key), "/r%u/s%u/%u.png", CoreTestRandom(&state) % 5, CoreTestRandom(&state) % 5, CoreTestRandom(&state) % 50);
+        if (operation < 4) {
+            size_t cost = CoreTestRandom(&state) % 300;
+            ImageCacheInsert(cache, key, createImage(i), cost);
+        } else if (operation < 7) {
+            ImageCacheGet(cache, key);
+        } else if (operation == 7) {
+            //Pins are kept short lived, as they would be for visible images.
+            if (ImageCachePin(cache, key)) {
+                ImageCacheGet(cache, key);
+                ImageCacheUnpin(cache, key);
+            }
+        } else if (operation == 8) {
+            snprintf(key, sizeof(key), "/r%u/s%u", CoreTestRandom(&state) % 5, CoreTestRandom(&state) % 5);
+            ImageCacheRemoveDirectory(cache, key);
+        } else if (CoreTestRandom(&state) % 100 == 0) {
+            ImageCacheSetByteBudget(cache, 500 + CoreTestRandom(&state) % 5000);
+        } else {
+            ImageCacheRemove(cache, key);
+        }
+
+        ImageCacheStatistics statistics = ImageCacheGetStatistics(cache);
+        consistent = consistent && statistics.entryCount == liveImages && statistics.bytesUsed <= statistics.byteBudget && statistics.pinnedBytes == 0;
+    }
+    ImageCacheStatistics statistics = ImageCacheGetStatistics(cache);
+    CORE_TEST_ASSERT(statistics.hits > 0 && statistics.misses > 0 && statistics.evictions > 0);
+    ImageCacheDestroy(cache);
+    CORE_TEST_ASSERT(consistent);
+    CORE_TEST_ASSERT(liveImages == 0 && !releasedTwice);
+}
+
+void ImageCacheTests(void)
+{
+    testEviction();
+    testPinning();
+    testDirectories();
+    testRandomised();
+}
@@ -0,0 +1,179 @@
+//
+//  ImageDownscaleTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "ImageDownscale.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PADDING_BYTE 0xa5
+
+//A straightforward version to check the vector paths against.
+static void referenceHalve(const uint8_t *source, size_t width, size_t height, size_t sourceRowBytes, uint8_t *destination, size_t destinationRowBytes)
+{
+    for (size_t y = 0; y < ImageDownscaleHalfSize(height); y++) {
+        size_t y0 = 2 * y;
+        size_t y1 = 2 * y + 1 < height ? 2 * y + 1 : 2 * y;
+        for (size_t x = 0; x < ImageDownscaleHalfSize(width); x++) {
+            size_t x0 = 2 * x;
+            size_t x1 = 2 * x + 1 < width ? 2 * x + 1 : 2 * x;
+            for (int channel = 0; channel < IMAGE_DOWNSCALE_BYTES_PER_PIXEL; channel++) {
+                int sum = source[y0 * sourceRowBytes + x0 * IMAGE_DOWNSCALE_BYTES_PER_PIXEL + channel];
+                sum += source[y0 * sourceRowBytes + x1 * IMAGE_DOWNSCALE_BYTES_PER_PIXEL + channel];
+                sum += source[y1 * sourceRowBytes + x0 * IMAGE_DOWNSCALE_BYTES_PER_PIXEL + channel];
+                sum += source[y1 * sourceRowBytes + x1 * IMAGE_DOWNSCALE_BYTES_PER_PIXEL + channel];
+                destination[y * destinationRowBytes + x * IMAGE_DOWNSCALE_BYTES_PER_PIXEL + channel] = (uint8_t)((sum + 2) >> 2);
+            }
+        }
+    }
+}
+
+static void testSizes(void)
+{
+    CORE_TEST_ASSERT(ImageDownscaleHalfSize(1) == 1);
+    CORE_TEST_ASSERT(ImageDownscaleHalfSize(2) == 1);
+    CORE_TEST_ASSERT(ImageDownscaleHalfSize(7) == 4);
+    CORE_TEST_ASSERT(ImageDownscaleHalfSize(8000) == 4000);
+}
+
+static void testKnownValues(void)
+{
+    //A 3x3 image, so the last row and column are averaged with themselves.
+    uint8_t source[3 * 3 * 4];
+    for (int i = 0; i < 9; i++) {
+        memset(source + i * 4, i * 10, 4);
+    }
+    source[3] = 255;
+    uint8_t destination[2 * 2 * 4];
+    ImageDownscaleHalve(source, 3, 3, 12, destination, 8);
+    //(0 + 10 + 30 + 40 + 2) / 4
+    CORE_TEST_ASSERT(destination[0] == 20 && destination[1] == 20 && destination[2] == 20);
+    //(255 + 10 + 30 + 40 + 2) / 4
+    CORE_TEST_ASSERT(destination[3] == 84);
+    CORE_TEST_ASSERT(destination[4] == 35);
+    CORE_TEST_ASSERT(destination[8] == 65);
+    CORE_TEST_ASSERT(destination[12] == 80);
+
+    //Rounding is to nearest, with halves going up.
+    uint8_t ones[2 * 2 * 4] = {1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0};
+    ImageDownscaleHalve(ones, 2, 2, 8, destination, 4);
+    CORE_TEST_ASSERT(destination[0] == 1);
+}
+
+static void testAgainstReference(void)
+{
+    //Random sizes, odd and even, with padded rows on both sides so that the vector paths and
+    //their scalar tails all get exercised.
+    uint64_t state = 1;
+    bool matches = true;
+    bool paddingIntact = true;
+    for (int i = 0; i < 2000; i++) {
+        size_t width = 1 + CoreTestRandom(&state) % 70;
+        size_t height = 1 + CoreTestRandom(&state) % 9;
+        size_t sourceRowBytes = width * 4 + CoreTestRandom(&state) % 8;
+        size_t halfWidth = ImageDownscaleHalfSize(width);
+        size_t halfHeight = ImageDownscaleHalfSize(height);
+        size_t destinationRowBytes = halfWidth * 4 + CoreTestRandom(&state) % 5;
+
+        uint8_t *source = malloc(sourceRowBytes * height);
+        uint8_t *destination = malloc(destinationRowBytes * halfHeight);
+        uint8_t *expected = malloc(destinationRowBytes * halfHeight);
+        for (size_t j = 0; j < sourceRowBytes * height; j++) {
+            source[j] = (uint8_t)CoreTestRandom(&state);
+        }
+        memset(destination, PADDING_BYTE, destinationRowBytes * halfHeight);
+        ImageDownscaleHalve(source, width, height, sourceRowBytes, destination, destinationRowBytes);
+        referenceHalve(source, width, height, sourceRowBytes, expected, destinationRowBytes);
+
+        for (size_t y = 0; y < halfHeight; y++) {
+            matches = matches && memcmp(destination + y * destinationRowBytes, expected + y * destinationRowBytes, halfWidth * 4) == 0;
+            for (size_t x = halfWidth * 4; x < destinationRowBytes; x++) {
+                paddingIntact = paddingIntact && destination[y * destinationRowBytes + x] == PADDING_BYTE;
+            }
+        }
+        free(source);
+        free(destination);
+        free(expected);
+    }
+    CORE_TEST_ASSERT(matches);
+    CORE_TEST_ASSERT(paddingIntact);
+}
+
+static void testPyramid(void)
+{
+    //Halving twice, as the tile pyramid does, gives the half and quarter size levels.
+    size_t width = 1001, height = 333;
+    uint8_t *pixels = malloc(width * height * 4);
+    for (size_t i = 0; i < width * height * 4; i++) {
+        pixels[i] = (uint8_t)(i * 7);
+    }
+    for (int level = 1; level <= 2; level++) {
+        size_t levelWidth = ImageDownscaleHalfSize(width);
+        size_t levelHeight = ImageDownscaleHalfSize(height);
+        uint8_t *levelPixels = malloc(levelWidth * levelHeight * 4);
+        ImageDownscaleHalve(pixels, width, height, width * 4, levelPixels, levelWidth * 4);
+        free(pixels);
+        pixels = levelPixels;
+        width = levelWidth;
+        height = levelHeight;
+    }
+    CORE_TEST_ASSERT(width == 251 && height == 84);
+    free(pixels);
+
+    //A flat colour stays the same colour at every level.
+    uint8_t flat[8 * 8 * 4];
+    for (int i = 0; i < 64; i++) {
+        flat[i * 4] = 200;
+        flat[i * 4 + 1] = 100;
+        flat[i * 4 + 2] = 50;
+        flat[i * 4 + 3] = 255;
+    }
+    uint8_t half[4 * 4 * 4], quarter[2 * 2 * 4];
+    ImageDownscaleHalve(flat, 8, 8, 32, half, 16);
+    ImageDownscaleHalve(half, 4, 4, 16, quarter, 8);
+    CORE_TEST_ASSERT(memcmp(quarter, flat, 8) == 0 && memcmp(quarter + 8, flat, 8) == 0);
+}
+
+void ImageDownscaleTests(void)
+{
+    testSizes();
+    testKnownValues();
+    testAgainstReference();
+    testPyramid();
+}
+
+void ImageDownscaleBenchmark(void)
+{
+    //A typical scroll score strip, taken down to both pyramid levels.
+    size_t width = 8000, height = 1400;
+    uint8_t *source = malloc(width * height * 4);
+    uint8_t *half = malloc(ImageDownscaleHalfSize(width) * ImageDownscaleHalfSize(height) * 4);
+    uint8_t *quarter = malloc(ImageDownscaleHalfSize(width / 2) * ImageDownscaleHalfSize(height / 2) * 4);
+    for (size_t i = 0; i < width * height * 4; i++) {
+        source[i] = (uint8_t)(i * 7);
+    }
+
+    int runs = 10;
+    double start = CoreTestTime();
+    for (int i = 0; i < runs; i++) {
+        ImageDownscaleHalve(source, width, height, width * 4, half, (width / 2) * 4);
+    }
+    double halfTime = (CoreTestTime() - start) / runs;
+    start = CoreTestTime();
+    for (int i = 0; i < runs; i++) {
+        ImageDownscaleHalve(half, width / 2, height / 2, (width / 2) * 4, quarter, (width / 4) * 4);
+    }
+    double quarterTime = (CoreTestTime() - start) / runs;
+    CoreTestReport("ImageDownscale halve 8000x1400", halfTime * 1e3, "ms");
+    CoreTestReport("ImageDownscale halve 4000x700", quarterTime * 1e3, "ms");
+    CoreTestReport("ImageDownscale throughput", width * height * 4 / halfTime / 1e9, "GB/s");
+
+    free(source);
+    free(half);
+    free(quarter);
+}
@@ -0,0 +1,29 @@
+//
+//  CommonDigest.h
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//The parts of CommonCrypto's digests that the cores use, mapped onto OpenSSL so that they can be
+//tested away from Apple's platforms. The Makefile only puts this directory on the include path
+//there. (The low level SHA-256 calls are deprecated in OpenSSL 3, but still do the job.)
+
+#ifndef CommonDigest_h
+#define CommonDigest_h
+
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <openssl/sha.h>
+
+#define CC_SHA256_DIGEST_LENGTH SHA256_DIGEST_LENGTH
+
+typedef unsigned int CC_LONG;
+typedef SHA256_CTX CC_SHA256_CTX;
+
+#define CC_SHA256_Init SHA256_Init
+#define CC_SHA256_Update SHA256_Update
+#define CC_SHA256_Final SHA256_Final
+#define CC_SHA256(data, length, digest) SHA256((data), (length), (digest))
+
+#endif /* CommonDigest_h */
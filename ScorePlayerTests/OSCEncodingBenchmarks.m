@@ -0,0 +1,148 @@
+//
+//  OSCEncodingBenchmarks.m
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "OSCEncodingBenchmarks.h"
+#import "OSCMessage.h"
+#import "OSCBufferPool.h"
+
+static const int ENCODE_ITERATIONS = 100000;
+
+//Compares encoding into a new NSData for every message with encoding into pooled buffers, for the
+//messages that make up most of our traffic. Throughput and buffer bytes allocated per message are
+//logged for each.
+@interface OSCEncodingBenchmarks ()
+
+- (OSCMessage *)tickMessage;
+- (OSCMessage *)controlMessage;
+- (OSCMessage *)layersDataMessage;
+- (void)benchmarkMessage:(OSCMessage *)message named:(NSString *)name;
+
+@end
+
+@implementation OSCEncodingBenchmarks
+
+- (void)testTickEncoding
+{
+    [self benchmarkMessage:[self tickMessage] named:@"Tick"];
+}
+
+- (void)testControlEncoding
+{
+    [self benchmarkMessage:[self controlMessage] named:@"Control"];
+}
+
+- (void)testLayersDataEncoding
+{
+    [self benchmarkMessage:[self layersDataMessage] named:@"LayersData"];
+}
+
+- (void)testEncodingMatches
+{
+    //Every path has to produce the same bytes.
+    NSArray *messages = [NSArray arrayWithObjects:[self tickMessage], [self controlMessage], [self layersDataMessage], nil];
+    for (int i = 0; i < [messages count]; i++) {
+        OSCMessage *message = [messages objectAtIndex:i];
+        NSData *data = [message messageAsDataWithHeader:YES];
+        NSMutableData *pooled = [message pooledDataWithHeader:YES];
+        XCTAssertEqualObjects(data, pooled);
+        [[OSCBufferPool sharedPool] recycleBuffer:pooled];
+        
+        uint8_t buffer[4096];
+        NSUInteger length = [message encodeIntoBuffer:buffer capacity:sizeof(buffer) withHeader:YES];
+        XCTAssertEqual(length, [data length]);
+        XCTAssertEqual(memcmp(buffer, [data bytes], length), 0);
+        XCTAssertEqual([message encodeIntoBuffer:buffer capacity:length - 1 withHeader:YES], (NSUInteger)0);
+        
+        //And the header is the big endian length of the rest.
+        uint32_t header = ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) | ((uint32_t)buffer[2] << 8) | buffer[3];
+        XCTAssertEqual((NSUInteger)header, length - 4);
+    }
+}
+
+#pragma mark - Private methods
+
+- (OSCMessage *)tickMessage
+{
+    OSCMessage *message = [[OSCMessage alloc] init];
+    [message appendAddressComponent:@"Tick"];
+    [message addFloatArgument:123.5];
+    return message;
+}
+
+- (OSCMessage *)controlMessage
+{
+    //A scheduled seek, with its target time split into two integers.
+    OSCMessage *message = [[OSCMessage alloc] init];
+    [message appendAddressComponent:@"Control"];
+    [message appendAddressComponent:@"Seek"];
+    [message addFloatArgument:0.25];
+    [message addIntegerArgument:1792442003];
+    [message addIntegerArgument:150000000];
+    return message;
+}
+
+- (OSCMessage *)layersDataMessage
+{
+    //Twenty layers with the common arguments and an image file each.
+    OSCMessage *message = [[OSCMessage alloc] init];
+    [message appendAddressComponent:@"LayersData"];
+    [message addIntegerArgument:20];
+    [message addStringArgument:@"255,255,255,255"];
+    for (int i = 0; i < 20; i++) {
+        [message addStringArgument:[NSString stringWithFormat:@"layer%i", i]];
+        [message addStringArgument:@"CanvasLayer"];
+        [message addStringArgument:@"canvas"];
+        [message addIntegerArgument:0];
+        [message addIntegerArgument:i * 10];
+        [message addIntegerArgument:i * 20];
+        [message addIntegerArgument:320];
+        [message addIntegerArgument:240];
+        [message addStringArgument:@"0,0,0,255"];
+        [message addFloatArgument:1];
+        [message addStringArgument:@"s"];
+        [message addStringArgument:@",imageFile"];
+        [message addStringArgument:[NSString stringWithFormat:@"image%i.png", i]];
+    }
+    return message;
+}
+
+- (void)benchmarkMessage:(OSCMessage *)message named:(NSString *)name
+{
+    NSUInteger encodedLength = [message encodedLengthWithHeader:YES];
+    
+    //A new NSData for every message.
+    NSDate *start = [NSDate date];
+    NSUInteger totalLength = 0;
+    for (int i = 0; i < ENCODE_ITERATIONS; i++) {
+        @autoreleasepool {
+            totalLength += [[message messageAsDataWithHeader:YES] length];
+        }
+    }
+    NSTimeInterval dataTime = -[start timeIntervalSinceNow];
+    XCTAssertEqual(totalLength, encodedLength * ENCODE_ITERATIONS);
+    
+    //Pooled buffers, recycled as the socket would once each write completes.
+    OSCBufferPool *pool = [OSCBufferPool sharedPool];
+    NSUInteger allocatedBefore = pool.buffersAllocated;
+    start = [NSDate date];
+    for (int i = 0; i < ENCODE_ITERATIONS; i++) {
+        @autoreleasepool {
+            NSMutableData *buffer = [message pooledDataWithHeader:YES];
+            [pool recycleBuffer:buffer];
+        }
+    }
+    NSTimeInterval pooledTime = -[start timeIntervalSinceNow];
+    NSUInteger allocated = pool.buffersAllocated - allocatedBefore;
+    //Pooled buffers are allocated with at least 256 bytes of capacity.
+    double pooledBytes = (double)(allocated * MAX(encodedLength, 256)) / ENCODE_ITERATIONS;
+    XCTAssertLessThanOrEqual(allocated, (NSUInteger)1);
+    
+    NSLog(@"%@ (%lu bytes): new data %.0f messages/s, %lu bytes allocated per message; pooled %.0f messages/s, %.3f bytes allocated per message", name, (unsigned long)encodedLength, ENCODE_ITERATIONS / dataTime, (unsigned long)encodedLength, ENCODE_ITERATIONS / pooledTime, pooledBytes);
+}
+
+@end
@@ -0,0 +1,13 @@
+//
+//  OSCMessageTests.h
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+@interface OSCMessageTests : XCTestCase
+
+@end
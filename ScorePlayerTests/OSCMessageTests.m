@@ -0,0 +1,60 @@
+//
+//  OSCMessageTests.m
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "OSCMessageTests.h"
+#import "OSCMessage.h"
+
+@implementation OSCMessageTests
+
+- (void)testRoundTrip
+{
+    OSCMessage *message = [[OSCMessage alloc] init];
+    [message appendAddressComponent:@"Control"];
+    [message appendAddressComponent:@"Seek"];
+    [message addIntegerArgument:-42];
+    [message addFloatArgument:1.5];
+    [message addStringArgument:@"Café"];
+    [message addBlobArgument:[@"abc" dataUsingEncoding:NSUTF8StringEncoding]];
+    
+    NSData *data = [message messageAsDataWithHeader:NO];
+    XCTAssertEqual(data.length, [message encodedLengthWithHeader:NO]);
+    XCTAssertEqual([message encodedLengthWithHeader:YES], data.length + 4);
+    
+    OSCMessage *decoded = [[OSCMessage alloc] initWithData:data];
+    XCTAssertNotNil(decoded);
+    XCTAssertEqual(decoded.addressCount, (NSUInteger)2);
+    XCTAssertTrue([decoded addressComponentAtIndex:1 isEqualToString:@"Seek"]);
+    XCTAssertEqualObjects(decoded.typeTag, @"ifsb");
+    XCTAssertEqual([decoded intArgumentAtIndex:0], -42);
+    XCTAssertEqual([decoded floatArgumentAtIndex:1], 1.5f);
+    XCTAssertEqualObjects([decoded stringArgumentAtIndex:2], @"Café");
+    XCTAssertEqualObjects([decoded blobArgumentAtIndex:3], [@"abc" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertNil([decoded stringArgumentAtIndex:0]);
+}
+
+- (void)testInvalidUTF8
+{
+    //"/Player/Name" with a lone continuation byte as its string argument.
+    const char bytes[] = "/Player/Name\0\0\0\0,s\0\0\x80\0\0\0";
+    NSData *data = [NSData dataWithBytes:bytes length:sizeof(bytes) - 1];
+    XCTAssertNil([[OSCMessage alloc] initWithData:data]);
+    
+    //The same in the address.
+    const char address[] = "/Play\xc3\0\0,\0\0\0";
+    data = [NSData dataWithBytes:address length:sizeof(address) - 1];
+    XCTAssertNil([[OSCMessage alloc] initWithData:data]);
+    
+    //While valid strings survive intact.
+    const char valid[] = "/Player/Name\0\0\0\0,s\0\0caf\xc3\xa9\0\0\0";
+    data = [NSData dataWithBytes:valid length:sizeof(valid) - 1];
+    OSCMessage *message = [[OSCMessage alloc] initWithData:data];
+    XCTAssertNotNil(message);
+    XCTAssertEqualObjects([message stringArgumentAtIndex:0], @"café");
+}
+
+@end
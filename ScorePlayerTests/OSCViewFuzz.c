@@ -0,0 +1,74 @@
+//
+//  OSCViewFuzz.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "OSCView.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool OSCViewFuzzCheck(const uint8_t *data, size_t size)
+{
+    //Parse from a copy of exactly the right size, so that ASan catches any read past the end.
+    char *bytes = malloc(size > 0 ? size : 1);
+    if (bytes == NULL) {
+        return true;
+    }
+    memcpy(bytes, data, size);
+    const char *end = bytes + size;
+
+    OSCView view;
+    bool consistent = true;
+    if (OSCViewParse(&view, bytes, size)) {
+        consistent = view.bytes == bytes && view.length == size && view.address >= bytes && view.address + view.addressLength <= end;
+        for (size_t i = 0; consistent && i < view.addressCount; i++) {
+            const char *component;
+            size_t length;
+            consistent = OSCViewAddressComponentAt(&view, i, &component, &length) && length > 0 && component >= view.address && component + length <= view.address + view.addressLength;
+        }
+        for (size_t i = 0; consistent && i < view.argumentCount; i++) {
+            size_t length;
+            switch (OSCViewTypeAt(&view, i)) {
+                case 'i':
+                    OSCViewInt32At(&view, i);
+                    break;
+                case 'f':
+                    OSCViewFloatAt(&view, i);
+                    break;
+                case 's': {
+                    const char *string = OSCViewStringAt(&view, i, &length);
+                    consistent = string != NULL && string >= bytes && string + length < end;
+                    break;
+                }
+                case 'b': {
+                    const char *blob = OSCViewBlobAt(&view, i, &length);
+                    consistent = blob != NULL && blob >= bytes && length <= (size_t)(end - blob);
+                    break;
+                }
+                default:
+                    consistent = false;
+                    break;
+            }
+        }
+    } else {
+        //A failed parse leaves the view empty.
+        consistent = view.bytes == NULL && view.offsets == NULL && view.argumentCount == 0;
+    }
+    OSCViewRelease(&view);
+    free(bytes);
+    return consistent;
+}
+
+#ifdef CORE_TEST_FUZZER
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (!OSCViewFuzzCheck(data, size)) {
+        abort();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,393 @@
+//
+//  OSCViewTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "OSCView.h"
+#include <stdlib.h>
+#include <string.h>
+
+//Builds encoded messages for the tests.
+typedef struct {
+    char bytes[1024];
+    size_t length;
+} Message;
+
+static void addString(Message *message, const char *string)
+{
+    size_t length = strlen(string);
+    memcpy(message->bytes + message->length, string, length);
+    message->length += length;
+    //Between one and four nulls.
+    size_t padding = 4 - (length % 4);
+    memset(message->bytes + message->length, 0, padding);
+    message->length += padding;
+}
+
+static void addInt(Message *message, int32_t value)
+{
+    uint32_t bits = (uint32_t)value;
+    for (int i = 0; i < 4; i++) {
+        message->bytes[message->length++] = (char)(bits >> (24 - i * 8));
+    }
+}
+
+static void addFloat(Message *message, float value)
+{
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    addInt(message, bits);
+}
+
+static void addBlob(Message *message, const void *blob, int32_t length)
+{
+    addInt(message, length);
+    memcpy(message->bytes + message->length, blob, length);
+    message->length += length;
+    while (message->length % 4 != 0) {
+        message->bytes[message->length++] = 0;
+    }
+}
+
+//Parses from a heap copy of exactly the right size, so that ASan catches any read past the end.
+static bool parse(OSCView *view, const Message *message, char **copy)
+{
+    *copy = malloc(message->length > 0 ? message->length : 1);
+    memcpy(*copy, message->bytes, message->length);
+    return OSCViewParse(view, *copy, message->length);
+}
+
+static void testArguments(void)
+{
+    Message message = {{0}, 0};
+    addString(&message, "/Control/Seek");
+    addString(&message, ",ifsb");
+    addInt(&message, -42);
+    addFloat(&message, 1.5f);
+    addString(&message, "caf\xc3\xa9");
+    addBlob(&message, "abc", 3);
+
+    OSCView view;
+    char *copy;
+    CORE_TEST_ASSERT(parse(&view, &message, &copy));
+    CORE_TEST_ASSERT(view.addressCount == 2);
+    CORE_TEST_ASSERT(view.argumentCount == 4);
+    CORE_TEST_ASSERT(OSCViewAddressComponentEquals(&view, 0, "Control"));
+    CORE_TEST_ASSERT(OSCViewAddressComponentEquals(&view, 1, "Seek"));
+    CORE_TEST_ASSERT(!OSCViewAddressComponentEquals(&view, 1, "See"));
+    CORE_TEST_ASSERT(!OSCViewAddressComponentEquals(&view, 2, "Seek"));
+
+    CORE_TEST_ASSERT(OSCViewTypeAt(&view, 0) == 'i');
+    CORE_TEST_ASSERT(OSCViewTypeAt(&view, 3) == 'b');
+    CORE_TEST_ASSERT(OSCViewTypeAt(&view, 4) == 0);
+    CORE_TEST_ASSERT(OSCViewInt32At(&view, 0) == -42);
+    CORE_TEST_ASSERT(OSCViewFloatAt(&view, 1) == 1.5f);
+    size_t length;
+    const char *string = OSCViewStringAt(&view, 2, &length);
+    CORE_TEST_ASSERT(string != NULL && length == 5 && memcmp(string, "caf\xc3\xa9", 5) == 0);
+    const char *blob = OSCViewBlobAt(&view, 3, &length);
+    CORE_TEST_ASSERT(blob != NULL && length == 3 && memcmp(blob, "abc", 3) == 0);
+
+    //Everything points into the original buffer.
+    CORE_TEST_ASSERT(string > copy && string < copy + message.length);
+    CORE_TEST_ASSERT(blob > copy && blob < copy + message.length);
+
+    //Asking for the wrong type, or past the end, gives nothing.
+    CORE_TEST_ASSERT(OSCViewInt32At(&view, 1) == 0);
+    CORE_TEST_ASSERT(OSCViewFloatAt(&view, 0) == 0);
+    CORE_TEST_ASSERT(OSCViewStringAt(&view, 3, NULL) == NULL);
+    CORE_TEST_ASSERT(OSCViewBlobAt(&view, 2, NULL) == NULL);
+    CORE_TEST_ASSERT(OSCViewInt32At(&view, 100) == 0);
+    OSCViewRelease(&view);
+    free(copy);
+}
+
+static void testAddresses(void)
+{
+    OSCView view;
+    char *copy;
+    const char *component;
+    size_t length;
+
+    //Leading and trailing slashes are trimmed.
+    Message message = {{0}, 0};
+    addString(&message, "//Server/Ping/");
+    addString(&message, ",");
+    CORE_TEST_ASSERT(parse(&view, &message, &copy));
+    CORE_TEST_ASSERT(view.addressCount == 2);
+    CORE_TEST_ASSERT(OSCViewAddressComponentAt(&view, 1, &component, &length) && length == 4 && memcmp(component, "Ping", 4) == 0);
+    CORE_TEST_ASSERT(!OSCViewAddressComponentAt(&view, 2, &component, &length));
+    CORE_TEST_ASSERT(view.argumentCount == 0);
+    OSCViewRelease(&view);
+    free(copy);
+
+    //An empty component in the middle leaves the message without an address.
+    message.length = 0;
+    addString(&message, "/Server//Ping");
+    addString(&message, ",");
+    CORE_TEST_ASSERT(parse(&view, &message, &copy));
+    CORE_TEST_ASSERT(view.addressCount == 0);
+    OSCViewRelease(&view);
+    free(copy);
+
+    //As does an address of just a slash.
+    message.length = 0;
+    addString(&message, "/");
+    addString(&message, ",");
+    CORE_TEST_ASSERT(parse(&view, &message, &copy));
+    CORE_TEST_ASSERT(view.addressCount == 0);
+    OSCViewRelease(&view);
+    free(copy);
+}
+
+static void testManyArguments(void)
+{
+    //More arguments than fit inline.
+    Message message = {{0}, 0};
+    addString(&message, "/Canvas/LayersData");
+    char types[42] = ",";
+    for (int i = 0; i < 40; i++) {
+        types[i + 1] = i % 2 == 0 ? 'i' : 's';
+    }
+    types[41] = '\0';
+    addString(&message, types);
+    for (int i = 0; i < 40; i++) {
+        if (i % 2 == 0) {
+            addInt(&message, i);
+        } else {
+            addString(&message, i % 4 == 1 ? "abc" : "abcd");
+        }
+    }
+
+    OSCView view;
+    char *copy;
+    CORE_TEST_ASSERT(parse(&view, &message, &copy));
+    CORE_TEST_ASSERT(view.argumentCount == 40);
+    CORE_TEST_ASSERT(view.offsets != NULL);
+    bool correct = true;
+    for (int i = 0; i < 40; i++) {
+        if (i % 2 == 0) {
+            correct = correct && OSCViewInt32At(&view, i) == i;
+        } else {
+            size_t length;
+            const char *string = OSCViewStringAt(&view, i, &length);
+            correct = correct && string != NULL && length == (i % 4 == 1 ? 3 : 4);
+        }
+    }
+    CORE_TEST_ASSERT(correct);
+    OSCViewRelease(&view);
+    CORE_TEST_ASSERT(view.offsets == NULL && view.argumentCount == 0);
+    free(copy);
+}
+
+static bool parses(const Message *message)
+{
+    OSCView view;
+    char *copy;
+    bool result = parse(&view, message, &copy);
+    OSCViewRelease(&view);
+    free(copy);
+    return result;
+}
+
+static void testMalformed(void)
+{
+    Message message = {{0}, 0};
+    CORE_TEST_ASSERT(!parses(&message));
+
+    //The address has to start with a slash, and the type tag with a comma.
+    addString(&message, "Control");
+    addString(&message, ",");
+    CORE_TEST_ASSERT(!parses(&message));
+    message.length = 0;
+    addString(&message, "/Control");
+    addString(&message, "i");
+    addInt(&message, 1);
+    CORE_TEST_ASSERT(!parses(&message));
+
+    //No type tag at all.
+    message.length = 0;
+    addString(&message, "/Control");
+    CORE_TEST_ASSERT(!parses(&message));
+
+    //Unterminated address.
+    message.length = 0;
+    memcpy(message.bytes, "/Control", 8);
+    message.length = 8;
+    CORE_TEST_ASSERT(!parses(&message));
+
+    //Unsupported type.
+    message.length = 0;
+    addString(&message, "/Control");
+    addString(&message, ",d");
+    addInt(&message, 0);
+    addInt(&message, 0);
+    CORE_TEST_ASSERT(!parses(&message));
+
+    //Arguments that run off the end.
+    message.length = 0;
+    addString(&message, "/Control");
+    addString(&message, ",ii");
+    addInt(&message, 1);
+    CORE_TEST_ASSERT(!parses(&message));
+    message.length -= 1;
+    message.bytes[message.length - 1] = 0;
+    CORE_TEST_ASSERT(!parses(&message));
+
+    message.length = 0;
+    addString(&message, "/Control");
+    addString(&message, ",b");
+    addBlob(&message, "abcdefgh", 8);
+    CORE_TEST_ASSERT(parses(&message));
+    message.length -= 4;
+    CORE_TEST_ASSERT(!parses(&message));
+
+    //A negative blob length.
+    message.length = 0;
+    addString(&message, "/Control");
+    addString(&message, ",b");
+    addInt(&message, -4);
+    addInt(&message, 0);
+    CORE_TEST_ASSERT(!parses(&message));
+
+    //An unterminated string argument.
+    message.length = 0;
+    addString(&message, "/Control");
+    addString(&message, ",s");
+    memcpy(message.bytes + message.length, "abcd", 4);
+    message.length += 4;
+    CORE_TEST_ASSERT(!parses(&message));
+}
+
+static void testPadding(void)
+{
+    //Missing padding after the last string is tolerated, as it always has been.
+    Message message = {{0}, 0};
+    addString(&message, "/Player/Name");
+    addString(&message, ",s");
+    memcpy(message.bytes + message.length, "ab", 3);
+    message.length += 3;
+    OSCView view;
+    char *copy;
+    CORE_TEST_ASSERT(parse(&view, &message, &copy));
+    size_t length;
+    const char *string = OSCViewStringAt(&view, 0, &length);
+    CORE_TEST_ASSERT(string != NULL && length == 2);
+    OSCViewRelease(&view);
+    free(copy);
+}
+
+static void testUTF8(void)
+{
+    static const char *valid[] = {"", "plain", "caf\xc3\xa9", "\xe2\x82\xac", "\xef\xbf\xbd", "\xf0\x9f\x8e\xb5", "\xf4\x8f\xbf\xbf"};
+    static const char *invalid[] = {
+        "\x80",
+        "\xc3",
+        "\xc3x",
+        //Overlong forms.
+        "\xc0\xaf",
+        "\xe0\x80\xaf",
+        "\xf0\x80\x80\xaf",
+        //A surrogate.
+        "\xed\xa0\x80",
+        //Beyond U+10FFFF.
+        "\xf4\x90\x80\x80",
+        "\xf5\x80\x80\x80",
+        "\xff",
+        //Truncated in the middle of a sequence.
+        "\xf0\x9f\x8e",
+    };
+
+    for (size_t i = 0; i < sizeof(valid) / sizeof(char *); i++) {
+        Message message = {{0}, 0};
+        addString(&message, "/Player/Name");
+        addString(&message, ",s");
+        addString(&message, valid[i]);
+        CORE_TEST_ASSERT(parses(&message));
+    }
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(char *); i++) {
+        Message message = {{0}, 0};
+        addString(&message, "/Player/Name");
+        addString(&message, ",s");
+        addString(&message, invalid[i]);
+        CORE_TEST_ASSERT(!parses(&message));
+
+        //The same goes for the address.
+        char address[16] = "/";
+        strcat(address, invalid[i]);
+        message.length = 0;
+        addString(&message, address);
+        addString(&message, ",");
+        CORE_TEST_ASSERT(!parses(&message));
+    }
+}
+
+static void testRandomised(void)
+{
+    //Mutations of valid messages. Whatever the parser makes of them, it mustn't read outside the
+    //buffer (which ASan checks), and anything it accepts has to be self consistent.
+    Message seeds[3] = {{{0}, 0}, {{0}, 0}, {{0}, 0}};
+    addString(&seeds[0], "/Control/Seek");
+    addString(&seeds[0], ",fsib");
+    addFloat(&seeds[0], 12.5f);
+    addString(&seeds[0], "Sc\xc3\xb6re");
+    addInt(&seeds[0], 7);
+    addBlob(&seeds[0], "\x01\x02\x03\x04\x05", 5);
+    addString(&seeds[1], "/Tick");
+    addString(&seeds[1], ",i");
+    addInt(&seeds[1], 300);
+    addString(&seeds[2], "/Canvas/LayersData");
+    addString(&seeds[2], ",siiiiiiiiiiiiiiiiiiii");
+    addString(&seeds[2], "layer");
+    for (int i = 0; i < 20; i++) {
+        addInt(&seeds[2], i);
+    }
+
+    uint64_t state = 1;
+    for (int iteration = 0; iteration < 200000; iteration++) {
+        Message message = seeds[CoreTestRandom(&state) % 3];
+        int mutations = 1 + CoreTestRandom(&state) % 4;
+        for (int i = 0; i < mutations; i++) {
+            uint32_t choice = CoreTestRandom(&state);
+            size_t position = message.length > 0 ? CoreTestRandom(&state) % message.length : 0;
+            switch (choice % 4) {
+                case 0:
+                    message.length = position;
+                    break;
+                case 1:
+                    if (message.length > 0) {
+                        message.bytes[position] ^= (char)(1 << (choice % 8));
+                    }
+                    break;
+                case 2:
+                    if (message.length > 0) {
+                        message.bytes[position] = (char)(choice >> 8);
+                    }
+                    break;
+                case 3:
+                    if (message.length < sizeof(message.bytes)) {
+                        memmove(message.bytes + position + 1, message.bytes + position, message.length - position);
+                        message.bytes[position] = (char)(choice >> 16);
+                        message.length++;
+                    }
+                    break;
+            }
+        }
+        CORE_TEST_ASSERT(OSCViewFuzzCheck((const uint8_t *)message.bytes, message.length));
+    }
+}
+
+void OSCViewTests(void)
+{
+    testArguments();
+    testAddresses();
+    testManyArguments();
+    testMalformed();
+    testPadding();
+    testUTF8();
+    testRandomised();
+}
@@ -0,0 +1,303 @@
+//
+//  RawTileCacheTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "RawTileCache.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define RAW_TILE_HEADER_LENGTH 16384
+#define PAGE_LENGTH 4096
+
+static char directory[CORE_TEST_PATH_LENGTH];
+
+static void pathInDirectory(const char *name, char *path)
+{
+    CoreTestPath(directory, name, path);
+}
+
+static void setModified(const char *path, time_t seconds)
+{
+    struct timespec times[2] = {{seconds, 0}, {seconds, 0}};
+    utimensat(AT_FDCWD, path, times, 0);
+}
+
+static uint8_t *createPixels(const RawTileFormat *format)
+{
+    uint8_t *pixels = malloc((size_t)format->rowBytes * format->height);
+    for (size_t i = 0; i < (size_t)format->rowBytes * format->height; i++) {
+        pixels[i] = (uint8_t)(i * 7);
+    }
+    return pixels;
+}
+
+static void testSource(void)
+{
+    char sourcePath[CORE_TEST_PATH_LENGTH];
+    pathInDirectory("source.png", sourcePath);
+    uint8_t bytes[20000];
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = (uint8_t)(i * 13);
+    }
+    CORE_TEST_ASSERT(CoreTestWriteFile(sourcePath, bytes, sizeof(bytes)));
+    RawTileSource source;
+    CORE_TEST_ASSERT(RawTileSourceRead(sourcePath, &source));
+    CORE_TEST_ASSERT(source.size == sizeof(bytes));
+
+    //A change in the middle of the file isn't part of the hash, but the ends are.
+    RawTileSource changed;
+    bytes[10000]++;
+    CoreTestWriteFile(sourcePath, bytes, sizeof(bytes));
+    RawTileSourceRead(sourcePath, &changed);
+    CORE_TEST_ASSERT(changed.hash == source.hash);
+    bytes[0]++;
+    CoreTestWriteFile(sourcePath, bytes, sizeof(bytes));
+    RawTileSourceRead(sourcePath, &changed);
+    CORE_TEST_ASSERT(changed.hash != source.hash);
+    bytes[0]--;
+    bytes[sizeof(bytes) - 1]++;
+    CoreTestWriteFile(sourcePath, bytes, sizeof(bytes));
+    RawTileSourceRead(sourcePath, &changed);
+    CORE_TEST_ASSERT(changed.hash != source.hash);
+
+    //Small files are hashed whole.
+    CoreTestWriteFile(sourcePath, bytes, 10);
+    CORE_TEST_ASSERT(RawTileSourceRead(sourcePath, &changed) && changed.size == 10);
+
+    pathInDirectory("missing.png", sourcePath);
+    CORE_TEST_ASSERT(!RawTileSourceRead(sourcePath, &source));
+}
+
+static void testNames(void)
+{
+    char name[RAW_TILE_NAME_LENGTH], other[RAW_TILE_NAME_LENGTH];
+    RawTileNameForSource("/Scores/a/1.png", name);
+    CORE_TEST_ASSERT(strlen(name) == RAW_TILE_NAME_LENGTH - 1);
+    CORE_TEST_ASSERT(strcmp(name + RAW_TILE_NAME_LENGTH - 5, ".raw") == 0);
+    RawTileNameForSource("/Scores/a/1.png", other);
+    CORE_TEST_ASSERT(strcmp(name, other) == 0);
+    RawTileNameForSource("/Scores/a/2.png", other);
+    CORE_TEST_ASSERT(strcmp(name, other) != 0);
+}
+
+static void testRoundTrip(void)
+{
+    char sourcePath[CORE_TEST_PATH_LENGTH], path[CORE_TEST_PATH_LENGTH];
+    pathInDirectory("round.png", sourcePath);
+    uint8_t bytes[100] = {1, 2, 3};
+    CoreTestWriteFile(sourcePath, bytes, sizeof(bytes));
+    RawTileSource source;
+    RawTileSourceRead(sourcePath, &source);
+
+    //Padded rows, and a bitmap info that's kept as is.
+    RawTileFormat format = {13, 7, 13 * 4 + 4, 8194};
+    uint8_t *pixels = createPixels(&format);
+    char name[RAW_TILE_NAME_LENGTH];
+    RawTileNameForSource(sourcePath, name);
+    pathInDirectory(name, path);
+    CORE_TEST_ASSERT(RawTileOpen(path, &source) == NULL);
+    CORE_TEST_ASSERT(RawTileWrite(path, &source, &format, pixels));
+
+    RawTile *tile = RawTileOpen(path, &source);
+    CORE_TEST_ASSERT(tile != NULL);
+    if (tile != NULL) {
+        CORE_TEST_ASSERT(memcmp(&tile->format, &format, sizeof(RawTileFormat)) == 0);
+        CORE_TEST_ASSERT(tile->pixelLength == (size_t)format.rowBytes * format.height);
+        CORE_TEST_ASSERT(memcmp(tile->pixels, pixels, tile->pixelLength) == 0);
+        //The pixels start on a page boundary so that they can be used straight from the mapping.
+        CORE_TEST_ASSERT((uintptr_t)tile->pixels % PAGE_LENGTH == 0);
+    }
+    RawTileClose(tile);
+    RawTileClose(NULL);
+
+    //Opening an entry marks it as used.
+    setModified(path, 1000);
+    tile = RawTileOpen(path, &source);
+    RawTileClose(tile);
+    struct stat status;
+    CORE_TEST_ASSERT(stat(path, &status) == 0 && status.st_mtime > 1000);
+
+    //A rewrite replaces the entry.
+    pixels[0]++;
+    CORE_TEST_ASSERT(RawTileWrite(path, &source, &format, pixels));
+    tile = RawTileOpen(path, &source);
+    CORE_TEST_ASSERT(tile != NULL && tile->pixels[0] == pixels[0]);
+    RawTileClose(tile);
+    free(pixels);
+}
+
+static void testStale(void)
+{
+    char sourcePath[CORE_TEST_PATH_LENGTH], path[CORE_TEST_PATH_LENGTH];
+    pathInDirectory("stale.png", sourcePath);
+    uint8_t bytes[100] = {4, 5, 6};
+    CoreTestWriteFile(sourcePath, bytes, sizeof(bytes));
+    RawTileSource source;
+    RawTileSourceRead(sourcePath, &source);
+    pathInDirectory("0000000000000001.raw", path);
+    RawTileFormat format = {100, 50, 400, 0};
+    uint8_t *pixels = createPixels(&format);
+    RawTileWrite(path, &source, &format, pixels);
+
+    //Any change to the source turns the entry away.
+    RawTileSource changed = source;
+    changed.size++;
+    CORE_TEST_ASSERT(RawTileOpen(path, &changed) == NULL);
+    changed = source;
+    changed.modifiedSeconds++;
+    CORE_TEST_ASSERT(RawTileOpen(path, &changed) == NULL);
+    changed = source;
+    changed.modifiedNanoseconds++;
+    CORE_TEST_ASSERT(RawTileOpen(path, &changed) == NULL);
+    changed = source;
+    changed.hash++;
+    CORE_TEST_ASSERT(RawTileOpen(path, &changed) == NULL);
+
+    //As does a truncated or overlong file.
+    CORE_TEST_ASSERT(truncate(path, RAW_TILE_HEADER_LENGTH + 10) == 0);
+    CORE_TEST_ASSERT(RawTileOpen(path, &source) == NULL);
+    CORE_TEST_ASSERT(truncate(path, 10) == 0);
+    CORE_TEST_ASSERT(RawTileOpen(path, &source) == NULL);
+    RawTileWrite(path, &source, &format, pixels);
+    CORE_TEST_ASSERT(truncate(path, RAW_TILE_HEADER_LENGTH + 400 * 50 + 1) == 0);
+    CORE_TEST_ASSERT(RawTileOpen(path, &source) == NULL);
+
+    //And so does anything that isn't a cache file.
+    uint8_t *zeroes = calloc(1, RAW_TILE_HEADER_LENGTH + 400 * 50);
+    CoreTestWriteFile(path, zeroes, RAW_TILE_HEADER_LENGTH + 400 * 50);
+    CORE_TEST_ASSERT(RawTileOpen(path, &source) == NULL);
+    free(zeroes);
+    free(pixels);
+}
+
+static void testTrim(void)
+{
+    char trimDirectory[CORE_TEST_PATH_LENGTH], name[64], path[CORE_TEST_PATH_LENGTH];
+    pathInDirectory("trim", trimDirectory);
+    mkdir(trimDirectory, 0755);
+    RawTileSource source = {100, 0, 0, 0};
+    RawTileFormat format = {10, 10, 40, 0};
+    uint8_t *pixels = createPixels(&format);
+    uint64_t entryLength = RAW_TILE_HEADER_LENGTH + 400;
+
+    //Five entries, oldest first.
+    for (int i = 0; i < 5; i++) {
+        snprintf(name, sizeof(name), "trim/%016x.raw", i);
+        pathInDirectory(name, path);
+        RawTileWrite(path, &source, &format, pixels);
+        setModified(path, 1000 + i);
+    }
+    //A temporary file from a write that never finished, another that's still being written,
+    //and something that isn't ours.
+    pathInDirectory("trim/0000000000000000.raw.ABCDEF", path);
+    CoreTestWriteFile(path, pixels, 100);
+    setModified(path, 1000);
+    pathInDirectory("trim/0000000000000001.raw.GHIJKL", path);
+    CoreTestWriteFile(path, pixels, 100);
+    pathInDirectory("trim/notes.txt", path);
+    CoreTestWriteFile(path, pixels, 100);
+
+    CORE_TEST_ASSERT(RawTileTrimDirectory(trimDirectory, entryLength * 10) == 100);
+    CORE_TEST_ASSERT(RawTileTrimDirectory(trimDirectory, entryLength * 2) == entryLength * 3);
+    for (int i = 0; i < 5; i++) {
+        snprintf(name, sizeof(name), "trim/%016x.raw", i);
+        pathInDirectory(name, path);
+        CORE_TEST_ASSERT((access(path, F_OK) == 0) == (i >= 3));
+    }
+    pathInDirectory("trim/0000000000000001.raw.GHIJKL", path);
+    CORE_TEST_ASSERT(access(path, F_OK) == 0);
+    pathInDirectory("trim/notes.txt", path);
+    CORE_TEST_ASSERT(access(path, F_OK) == 0);
+
+    CORE_TEST_ASSERT(RawTileTrimDirectory(trimDirectory, 0) == entryLength * 2);
+    pathInDirectory("missing", trimDirectory);
+    CORE_TEST_ASSERT(RawTileTrimDirectory(trimDirectory, 0) == 0);
+    free(pixels);
+}
+
+void RawTileCacheTests(void)
+{
+    CORE_TEST_ASSERT(CoreTestMakeDirectory("RawTileCacheTests", directory));
+    testSource();
+    testNames();
+    testRoundTrip();
+    testStale();
+    testTrim();
+    CoreTestRemoveDirectory(directory);
+}
+
+void RawTileCacheBenchmark(void)
+{
+    //Open to first frame for a typical page sized tile, with and without the cache. Without it,
+    //the PNG has to be inflated, which is the bulk of decoding one (zlib is used here so that
+    //the benchmark runs wherever the tests do). With it, the source is checked, the entry is
+    //mapped and every page is touched, as drawing the first frame would.
+    CoreTestMakeDirectory("RawTileCacheTests", directory);
+    RawTileFormat format = {4000, 1400, 4000 * 4, 0};
+    size_t pixelLength = (size_t)format.rowBytes * format.height;
+    uint8_t *pixels = malloc(pixelLength);
+    uint64_t state = 1;
+    for (size_t i = 0; i < pixelLength; i++) {
+        //Mostly white with some ink, which compresses about as well as a score does.
+        pixels[i] = CoreTestRandom(&state) % 16 == 0 ? (uint8_t)CoreTestRandom(&state) : 255;
+    }
+    uLongf compressedLength = compressBound(pixelLength);
+    uint8_t *compressed = malloc(compressedLength);
+    compress2(compressed, &compressedLength, pixels, pixelLength, Z_DEFAULT_COMPRESSION);
+
+    char sourcePath[CORE_TEST_PATH_LENGTH], path[CORE_TEST_PATH_LENGTH];
+    pathInDirectory("source.png", sourcePath);
+    pathInDirectory("0000000000000000.raw", path);
+    CoreTestWriteFile(sourcePath, compressed, compressedLength);
+    RawTileSource source;
+    RawTileSourceRead(sourcePath, &source);
+    CORE_TEST_ASSERT(RawTileWrite(path, &source, &format, pixels));
+
+    int runs = 10;
+    double decodeTime = 1e9, cacheTime = 1e9;
+    uint8_t *decoded = malloc(pixelLength);
+    for (int i = 0; i < runs; i++) {
+        double start = CoreTestTime();
+        int fd = open(sourcePath, O_RDONLY);
+        uint8_t *file = malloc(compressedLength);
+        CORE_TEST_ASSERT(read(fd, file, compressedLength) == (ssize_t)compressedLength);
+        close(fd);
+        uLongf decodedLength = pixelLength;
+        CORE_TEST_ASSERT(uncompress(decoded, &decodedLength, file, compressedLength) == Z_OK);
+        free(file);
+        double elapsed = CoreTestTime() - start;
+        decodeTime = elapsed < decodeTime ? elapsed : decodeTime;
+
+        start = CoreTestTime();
+        RawTileSource current;
+        RawTileSourceRead(sourcePath, &current);
+        RawTile *tile = RawTileOpen(path, &current);
+        CORE_TEST_ASSERT(tile != NULL);
+        unsigned checksum = 0;
+        for (size_t j = 0; tile != NULL && j < tile->pixelLength; j += PAGE_LENGTH) {
+            checksum += tile->pixels[j];
+        }
+        RawTileClose(tile);
+        elapsed = CoreTestTime() - start;
+        cacheTime = elapsed < cacheTime ? elapsed : cacheTime;
+        CORE_TEST_ASSERT(checksum > 0);
+    }
+    CORE_TEST_ASSERT(memcmp(decoded, pixels, pixelLength) == 0);
+    CoreTestReport("RawTileCache first frame 4000x1400 without cache", decodeTime * 1e3, "ms");
+    CoreTestReport("RawTileCache first frame 4000x1400 with cache", cacheTime * 1e3, "ms");
+
+    free(decoded);
+    free(compressed);
+    free(pixels);
+    CoreTestRemoveDirectory(directory);
+}
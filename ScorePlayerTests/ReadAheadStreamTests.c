@@ -0,0 +1,399 @@
+//
+//  ReadAheadStreamTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "ZipCompress.h"
+#include "ZipExtract.h"
+#include "SSZipArchive/minizip/mz.h"
+#include "SSZipArchive/minizip/mz_strm.h"
+#include "SSZipArchive/minizip/mz_strm_buf.h"
+#include "SSZipArchive/minizip/mz_strm_os.h"
+#include "SSZipArchive/minizip/mz_strm_readahead.h"
+#include "SSZipArchive/minizip/mz_zip.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DATA_LENGTH 3000000
+#define READ_LENGTH 200000
+
+static char directory[CORE_TEST_PATH_LENGTH];
+
+//Chunk sizes and counts to try, including ones small enough that most reads span several
+//chunks. (0 leaves the defaults.)
+static const int64_t chunkSettings[][2] = {{1000, 2}, {4096, 3}, {65536, 8}, {0, 0}, {61, 2}};
+
+static uint8_t *createData(uint64_t *state)
+{
+    uint8_t *data = malloc(DATA_LENGTH);
+    for (size_t i = 0; i < DATA_LENGTH; i++) {
+        data[i] = (uint8_t)CoreTestRandom(state);
+    }
+    return data;
+}
+
+static void *openStream(const char *path, int32_t mode, const int64_t *settings, void **baseStream)
+{
+    void *stream = NULL;
+    mz_stream_os_create(baseStream);
+    mz_stream_readahead_create(&stream);
+    mz_stream_set_base(stream, *baseStream);
+    if (settings[0] != 0) {
+        mz_stream_set_prop_int64(stream, MZ_STREAM_PROP_READAHEAD_CHUNK_SIZE, settings[0]);
+        mz_stream_set_prop_int64(stream, MZ_STREAM_PROP_READAHEAD_CHUNK_COUNT, settings[1]);
+    }
+    if (mz_stream_open(stream, path, mode) != MZ_OK) {
+        mz_stream_readahead_delete(&stream);
+        mz_stream_os_delete(baseStream);
+        return NULL;
+    }
+    return stream;
+}
+
+static void closeStream(void **stream, void **baseStream)
+{
+    //This closes the base stream too.
+    mz_stream_readahead_delete(stream);
+    mz_stream_os_delete(baseStream);
+}
+
+static void testReading(void)
+{
+    //Random reads, seeks from every origin and short hops back and forth, checked against the
+    //file's contents and the expected position.
+    uint64_t state = 4;
+    uint8_t *data = createData(&state);
+    char path[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "data", path);
+    CoreTestWriteFile(path, data, DATA_LENGTH);
+    uint8_t *buffer = malloc(READ_LENGTH);
+
+    for (size_t setting = 0; setting < sizeof(chunkSettings) / sizeof(chunkSettings[0]); setting++) {
+        void *baseStream = NULL;
+        void *stream = openStream(path, MZ_OPEN_MODE_READ, chunkSettings[setting], &baseStream);
+        CORE_TEST_ASSERT(stream != NULL);
+        if (stream == NULL) {
+            continue;
+        }
+        int64_t position = 0;
+        bool seeksWork = true, readsMatch = true, positionsMatch = true;
+        for (int i = 0; i < 3000; i++) {
+            uint32_t operation = CoreTestRandom(&state) % 10;
+            if (operation < 2) {
+                int64_t target = CoreTestRandom(&state) % (DATA_LENGTH + 10);
+                int32_t origin = CoreTestRandom(&state) % 3;
+                int64_t offset = origin == MZ_SEEK_SET ? target : (origin == MZ_SEEK_CUR ? target - position : target - DATA_LENGTH);
+                seeksWork = seeksWork && mz_stream_seek(stream, offset, origin) == MZ_OK;
+                position = target;
+            } else if (operation < 3) {
+                int64_t target = position + (int64_t)(CoreTestRandom(&state) % 3000) - 1000;
+                target = target < 0 ? 0 : target;
+                seeksWork = seeksWork && mz_stream_seek(stream, target, MZ_SEEK_SET) == MZ_OK;
+                position = target;
+            } else {
+                int32_t length = CoreTestRandom(&state) % (operation == 9 ? READ_LENGTH : 5000);
+                int32_t read = mz_stream_read(stream, buffer, length);
+                int64_t expected = position >= DATA_LENGTH ? 0 : (DATA_LENGTH - position < length ? DATA_LENGTH - position : length);
+                readsMatch = readsMatch && read == expected && (read <= 0 || memcmp(buffer, data + position, read) == 0);
+                position += read > 0 ? read : 0;
+            }
+            if (mz_stream_tell(stream) != position) {
+                positionsMatch = false;
+                position = mz_stream_tell(stream);
+            }
+        }
+        CORE_TEST_ASSERT(seeksWork);
+        CORE_TEST_ASSERT(readsMatch);
+        CORE_TEST_ASSERT(positionsMatch);
+        closeStream(&stream, &baseStream);
+    }
+    free(buffer);
+    free(data);
+}
+
+static void testWriting(void)
+{
+    //Random writes (some long), with seeks back into what has been written and reads of it,
+    //checked against a copy kept in memory and then against the file.
+    uint64_t state = 5;
+    uint8_t *data = createData(&state);
+    char path[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "written", path);
+    uint8_t buffer[3000];
+
+    for (size_t setting = 0; setting < sizeof(chunkSettings) / sizeof(chunkSettings[0]); setting++) {
+        CoreTestWriteFile(path, "", 0);
+        void *baseStream = NULL;
+        void *stream = openStream(path, MZ_OPEN_MODE_READWRITE | MZ_OPEN_MODE_APPEND, chunkSettings[setting], &baseStream);
+        CORE_TEST_ASSERT(stream != NULL);
+        if (stream == NULL) {
+            continue;
+        }
+        uint8_t *model = calloc(1, DATA_LENGTH);
+        int64_t position = 0, length = 0;
+        bool writesWork = true, readsMatch = true, positionsMatch = true;
+        for (int i = 0; i < 2000; i++) {
+            uint32_t operation = CoreTestRandom(&state) % 10;
+            if (operation < 1 && length > 0) {
+                position = CoreTestRandom(&state) % length;
+                mz_stream_seek(stream, position, MZ_SEEK_SET);
+            } else if (operation < 2) {
+                mz_stream_seek(stream, 0, MZ_SEEK_END);
+                position = length;
+            } else if (operation < 3 && length > 0) {
+                int32_t readLength = CoreTestRandom(&state) % sizeof(buffer);
+                int32_t read = mz_stream_read(stream, buffer, readLength);
+                int64_t expected = length - position < readLength ? length - position : readLength;
+                readsMatch = readsMatch && read == expected && (read <= 0 || memcmp(buffer, model + position, read) == 0);
+                position += read > 0 ? read : 0;
+            } else {
+                int32_t writeLength = CoreTestRandom(&state) % (operation == 9 ? 100000 : 3000);
+                if (position + writeLength > DATA_LENGTH) {
+                    writeLength = (int32_t)(DATA_LENGTH - position);
+                }
+                writesWork = writesWork && mz_stream_write(stream, data + i * 100, writeLength) == writeLength;
+                memcpy(model + position, data + i * 100, writeLength);
+                position += writeLength;
+                length = position > length ? position : length;
+            }
+            if (mz_stream_tell(stream) != position) {
+                positionsMatch = false;
+                position = mz_stream_tell(stream);
+            }
+        }
+        CORE_TEST_ASSERT(writesWork);
+        CORE_TEST_ASSERT(readsMatch);
+        CORE_TEST_ASSERT(positionsMatch);
+        closeStream(&stream, &baseStream);
+
+        //Everything is on disk once the stream is closed.
+        FILE *file = fopen(path, "rb");
+        uint8_t *written = malloc(DATA_LENGTH);
+        size_t writtenLength = file != NULL ? fread(written, 1, DATA_LENGTH, file) : 0;
+        if (file != NULL) {
+            fclose(file);
+        }
+        CORE_TEST_ASSERT((int64_t)writtenLength == length && memcmp(written, model, length) == 0);
+        free(written);
+        free(model);
+    }
+    free(data);
+}
+
+static void makeFiles(const char *root, size_t fileCount, size_t maximumLength, uint64_t *state)
+{
+    //A mix of random (incompressible) and repetitive files, some in a subdirectory.
+    char path[CORE_TEST_PATH_LENGTH], name[64];
+    mkdir(root, 0755);
+    CoreTestPath(root, "sub", path);
+    mkdir(path, 0755);
+    uint8_t *contents = malloc(maximumLength);
+    for (size_t i = 0; i < fileCount; i++) {
+        size_t length = CoreTestRandom(state) % maximumLength;
+        bool random = i % 2 == 0;
+        for (size_t j = 0; j < length; j++) {
+            contents[j] = random ? (uint8_t)CoreTestRandom(state) : (uint8_t)("0123456789\n"[j % 11]);
+        }
+        snprintf(name, sizeof(name), i % 3 == 0 ? "sub/%zu.bin" : "%zu.bin", i);
+        CoreTestPath(root, name, path);
+        CoreTestWriteFile(path, contents, length);
+    }
+    free(contents);
+}
+
+static bool filesMatch(const char *first, const char *second)
+{
+    FILE *a = fopen(first, "rb"), *b = fopen(second, "rb");
+    bool match = a != NULL && b != NULL;
+    while (match) {
+        int c = fgetc(a);
+        match = c == fgetc(b);
+        if (c == EOF) {
+            break;
+        }
+    }
+    if (a != NULL) {
+        fclose(a);
+    }
+    if (b != NULL) {
+        fclose(b);
+    }
+    return match;
+}
+
+static bool compressDirectory(const char *source, const char *archivePath, int level)
+{
+    ZipCompressionOptions options;
+    ZipCompressionOptionsInit(&options);
+    options.level = level;
+    ZipCompression *compression = ZipCompressionOpen(source, archivePath, &options);
+    if (compression == NULL) {
+        return false;
+    }
+    //One worker gets through the whole archive on its own.
+    bool success = ZipCompressionRunWorker(compression) && ZipCompressionFinish(compression);
+    ZipCompressionClose(compression);
+    return success;
+}
+
+static void *runExtractionWorker(void *extraction)
+{
+    return ZipExtractionRunWorker(extraction) ? extraction : NULL;
+}
+
+static void testArchiveRoundTrip(void)
+{
+    //The write behind stream under ZipCompress and the read ahead stream under ZipExtract,
+    //with several extraction workers reading the same archive at once.
+    uint64_t state = 6;
+    char source[CORE_TEST_PATH_LENGTH], archivePath[CORE_TEST_PATH_LENGTH], destination[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "source", source);
+    CoreTestPath(directory, "archive.zip", archivePath);
+    CoreTestPath(directory, "extracted", destination);
+    makeFiles(source, 30, 400000, &state);
+    CORE_TEST_ASSERT(compressDirectory(source, archivePath, 1));
+
+    ZipExtraction *extraction = ZipExtractionOpen(archivePath, destination);
+    CORE_TEST_ASSERT(extraction != NULL);
+    if (extraction == NULL) {
+        return;
+    }
+    CORE_TEST_ASSERT(ZipExtractionPrepare(extraction));
+    size_t workerCount = ZipExtractionWorkerCount(extraction, 4);
+    pthread_t workers[4];
+    for (size_t i = 0; i < workerCount; i++) {
+        pthread_create(&workers[i], NULL, runExtractionWorker, extraction);
+    }
+    bool success = true;
+    for (size_t i = 0; i < workerCount; i++) {
+        void *result;
+        pthread_join(workers[i], &result);
+        success = success && result != NULL;
+    }
+    CORE_TEST_ASSERT(success);
+    ZipExtractionProgress progress;
+    ZipExtractionGetProgress(extraction, &progress);
+    CORE_TEST_ASSERT(progress.fileCount == 30 && progress.extractedFiles == 30 && progress.extractedBytes == progress.totalBytes);
+    ZipExtractionClose(extraction);
+
+    bool identical = true;
+    char name[64], original[CORE_TEST_PATH_LENGTH], extracted[CORE_TEST_PATH_LENGTH];
+    for (size_t i = 0; i < 30; i++) {
+        snprintf(name, sizeof(name), i % 3 == 0 ? "sub/%zu.bin" : "%zu.bin", i);
+        CoreTestPath(source, name, original);
+        CoreTestPath(destination, name, extracted);
+        identical = identical && filesMatch(original, extracted);
+    }
+    CORE_TEST_ASSERT(identical);
+}
+
+void ReadAheadStreamTests(void)
+{
+    CORE_TEST_ASSERT(CoreTestMakeDirectory("ReadAheadStreamTests", directory));
+    testReading();
+    testWriting();
+    testArchiveRoundTrip();
+    CoreTestRemoveDirectory(directory);
+}
+
+static void evictFromCache(const char *path)
+{
+    //Dropping the archive from the page cache makes every run read it from the device. (This
+    //only works on Linux. Elsewhere the runs after the first are warm.)
+#ifdef POSIX_FADV_DONTNEED
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#endif
+}
+
+static bool inflateArchive(const char *archivePath, bool readAhead, uint64_t *totalBytes)
+{
+    //Reads every entry in order, as a single extraction worker does, on top of either the
+    //read ahead stream or the buffered stream it replaced.
+    void *baseStream = NULL, *stream = NULL, *zip = NULL;
+    mz_stream_os_create(&baseStream);
+    if (readAhead) {
+        mz_stream_readahead_create(&stream);
+    } else {
+        mz_stream_buffered_create(&stream);
+    }
+    mz_zip_create(&zip);
+    bool success = mz_stream_set_base(stream, baseStream) == MZ_OK && mz_stream_open(stream, archivePath, MZ_OPEN_MODE_READ) == MZ_OK;
+    success = success && mz_zip_open(zip, stream, MZ_OPEN_MODE_READ) == MZ_OK;
+
+    uint8_t *buffer = malloc(INT16_MAX);
+    *totalBytes = 0;
+    int32_t status = success ? mz_zip_goto_first_entry(zip) : MZ_END_OF_LIST;
+    while (success && status == MZ_OK) {
+        success = mz_zip_entry_read_open(zip, 0, NULL) == MZ_OK;
+        int32_t read;
+        while (success && (read = mz_zip_entry_read(zip, buffer, INT16_MAX)) > 0) {
+            *totalBytes += read;
+        }
+        success = success && read == 0 && mz_zip_entry_close(zip) == MZ_OK;
+        status = mz_zip_goto_next_entry(zip);
+    }
+    free(buffer);
+
+    mz_zip_close(zip);
+    mz_zip_delete(&zip);
+    if (readAhead) {
+        mz_stream_readahead_delete(&stream);
+    } else {
+        mz_stream_close(stream);
+        mz_stream_buffered_delete(&stream);
+    }
+    mz_stream_os_delete(&baseStream);
+    return success && status == MZ_END_OF_LIST;
+}
+
+void ReadAheadStreamBenchmark(void)
+{
+    //Inflating a 128MB archive straight after dropping it from the page cache, with and
+    //without reading ahead. The runs alternate so that both see the same conditions.
+    CoreTestMakeDirectory("ReadAheadStreamBenchmark", directory);
+    uint64_t state = 7;
+    char source[CORE_TEST_PATH_LENGTH], archivePath[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "source", source);
+    CoreTestPath(directory, "archive.zip", archivePath);
+    makeFiles(source, 64, 4 * 1024 * 1024, &state);
+    CORE_TEST_ASSERT(compressDirectory(source, archivePath, 1));
+
+    int runs = 5;
+    double bufferedTime = 1e9, readAheadTime = 1e9;
+    uint64_t bufferedBytes = 0, readAheadBytes = 0;
+    for (int i = 0; i < runs; i++) {
+        evictFromCache(archivePath);
+        double start = CoreTestTime();
+        CORE_TEST_ASSERT(inflateArchive(archivePath, false, &bufferedBytes));
+        double elapsed = CoreTestTime() - start;
+        bufferedTime = elapsed < bufferedTime ? elapsed : bufferedTime;
+
+        evictFromCache(archivePath);
+        start = CoreTestTime();
+        CORE_TEST_ASSERT(inflateArchive(archivePath, true, &readAheadBytes));
+        elapsed = CoreTestTime() - start;
+        readAheadTime = elapsed < readAheadTime ? elapsed : readAheadTime;
+    }
+    CORE_TEST_ASSERT(bufferedBytes == readAheadBytes && bufferedBytes > 0);
+
+    struct stat status;
+    stat(archivePath, &status);
+    CoreTestReport("ReadAheadStream archive size", status.st_size / 1e6, "MB");
+    CoreTestReport("ReadAheadStream cold inflate, buffered stream", bufferedTime * 1e3, "ms");
+    CoreTestReport("ReadAheadStream cold inflate, read ahead", readAheadTime * 1e3, "ms");
+    CoreTestRemoveDirectory(directory);
+}
@@ -0,0 +1,330 @@
+//
+//  ScoreBundleTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "ScoreBundle.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static char directory[CORE_TEST_PATH_LENGTH];
+static char scoreDirectory[CORE_TEST_PATH_LENGTH];
+
+static void pathInDirectory(const char *name, char *path)
+{
+    CoreTestPath(directory, name, path);
+}
+
+static void pathInScore(const char *name, char *path)
+{
+    CoreTestPath(scoreDirectory, name, path);
+}
+
+static void makeScore(void)
+{
+    //A small score directory: an opus file, an image, a file in a subdirectory, and a hidden
+    //directory of the sort the app keeps its own data in.
+    char path[CORE_TEST_PATH_LENGTH];
+    pathInDirectory("score", scoreDirectory);
+    mkdir(scoreDirectory, 0755);
+    pathInScore("sub", path);
+    mkdir(path, 0755);
+    pathInScore(".pyramid", path);
+    mkdir(path, 0755);
+
+    pathInScore("opus.xml", path);
+    CoreTestWriteFile(path, "<opus/>", 7);
+    pathInScore("sub/b.txt", path);
+    CoreTestWriteFile(path, "x", 1);
+    pathInScore(".pyramid/skip", path);
+    CoreTestWriteFile(path, "hidden", 6);
+    uint8_t *image = calloc(1, 100000);
+    pathInScore("a_1.png", path);
+    CoreTestWriteFile(path, image, 100000);
+    free(image);
+}
+
+static uint8_t *readFile(const char *path, size_t *length)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *length = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *bytes = malloc(*length);
+    if (fread(bytes, 1, *length, file) != *length) {
+        free(bytes);
+        bytes = NULL;
+    }
+    fclose(file);
+    return bytes;
+}
+
+static void testRoundTrip(void)
+{
+    uint64_t signature = ScoreBundleSignature(scoreDirectory);
+    CORE_TEST_ASSERT(signature != 0);
+    CORE_TEST_ASSERT(ScoreBundleSignature(scoreDirectory) == signature);
+
+    char opusPath[CORE_TEST_PATH_LENGTH], textPath[CORE_TEST_PATH_LENGTH], bundlePath[CORE_TEST_PATH_LENGTH];
+    pathInScore("opus.xml", opusPath);
+    pathInScore("sub/b.txt", textPath);
+    pathInDirectory("score.bundle", bundlePath);
+    const char parsed[] = "PARSED";
+    //Items are given out of order, and the image is listed without its contents.
+    ScoreBundleItem items[3] = {
+        {"sub/b.txt", kScoreBundleFile, 1, 0, 0, textPath, NULL, 0},
+        {"opus.xml", kScoreBundleXML, 7, 0, 0, opusPath, parsed, 6},
+        {"a_1.png", kScoreBundleImage, 100000, 640, 480, NULL, NULL, 0}
+    };
+    CORE_TEST_ASSERT(ScoreBundleWrite(bundlePath, signature, "1.0 (1)", items, 3));
+
+    ScoreBundle *bundle = ScoreBundleOpen(bundlePath);
+    CORE_TEST_ASSERT(bundle != NULL);
+    if (bundle == NULL) {
+        return;
+    }
+    CORE_TEST_ASSERT(bundle->signature == signature && bundle->entryCount == 3);
+    CORE_TEST_ASSERT(bundle->generatorLength == 7 && memcmp(bundle->generator, "1.0 (1)", 7) == 0);
+
+    //Entries are sorted by name.
+    bool sorted = true;
+    for (size_t i = 1; i < bundle->entryCount; i++) {
+        const ScoreBundleEntry *previous = &bundle->entries[i - 1], *entry = &bundle->entries[i];
+        size_t length = previous->nameLength < entry->nameLength ? previous->nameLength : entry->nameLength;
+        int order = memcmp(bundle->strings + previous->nameOffset, bundle->strings + entry->nameOffset, length);
+        sorted = sorted && (order < 0 || (order == 0 && previous->nameLength < entry->nameLength));
+    }
+    CORE_TEST_ASSERT(sorted);
+
+    const ScoreBundleEntry *entry = ScoreBundleFind(bundle, "opus.xml", 8);
+    CORE_TEST_ASSERT(entry != NULL && entry->kind == kScoreBundleXML && entry->size == 7 && entry->dataLength == 7);
+    if (entry != NULL) {
+        CORE_TEST_ASSERT(memcmp(ScoreBundleData(bundle, entry), "<opus/>", 7) == 0);
+        CORE_TEST_ASSERT(entry->parsedLength == 6 && memcmp(ScoreBundleParsed(bundle, entry), "PARSED", 6) == 0);
+        //Blobs start on a page boundary within the file.
+        CORE_TEST_ASSERT(((const uint8_t *)ScoreBundleData(bundle, entry) - (const uint8_t *)bundle->mapping) % SCORE_BUNDLE_ALIGNMENT == 0);
+        CORE_TEST_ASSERT(((const uint8_t *)ScoreBundleParsed(bundle, entry) - (const uint8_t *)bundle->mapping) % SCORE_BUNDLE_ALIGNMENT == 0);
+    }
+
+    entry = ScoreBundleFind(bundle, "a_1.png", 7);
+    CORE_TEST_ASSERT(entry != NULL && entry->kind == kScoreBundleImage && entry->width == 640 && entry->height == 480 && entry->size == 100000);
+    CORE_TEST_ASSERT(entry != NULL && ScoreBundleData(bundle, entry) == NULL && ScoreBundleParsed(bundle, entry) == NULL);
+    entry = ScoreBundleFind(bundle, "sub/b.txt", 9);
+    CORE_TEST_ASSERT(entry != NULL && *(const char *)ScoreBundleData(bundle, entry) == 'x');
+
+    //Lookups go by the whole name.
+    CORE_TEST_ASSERT(ScoreBundleFind(bundle, "a_1.pn", 6) == NULL);
+    CORE_TEST_ASSERT(ScoreBundleFind(bundle, "a_1.pngx", 8) == NULL);
+    CORE_TEST_ASSERT(ScoreBundleFind(bundle, "zzz", 3) == NULL);
+    CORE_TEST_ASSERT(ScoreBundleFind(bundle, "", 0) == NULL);
+    ScoreBundleClose(bundle);
+
+    //No temporary files are left behind.
+    DIR *directoryStream = opendir(directory);
+    struct dirent *item;
+    bool leftovers = false;
+    while (directoryStream != NULL && (item = readdir(directoryStream)) != NULL) {
+        leftovers = leftovers || strncmp(item->d_name, "score.bundle.", 13) == 0;
+    }
+    closedir(directoryStream);
+    CORE_TEST_ASSERT(!leftovers);
+
+    //An empty bundle is still a bundle.
+    pathInDirectory("empty.bundle", bundlePath);
+    CORE_TEST_ASSERT(ScoreBundleWrite(bundlePath, 5, "", NULL, 0));
+    bundle = ScoreBundleOpen(bundlePath);
+    CORE_TEST_ASSERT(bundle != NULL && bundle->entryCount == 0 && bundle->signature == 5);
+    CORE_TEST_ASSERT(bundle != NULL && ScoreBundleFind(bundle, "a", 1) == NULL);
+    ScoreBundleClose(bundle);
+    ScoreBundleClose(NULL);
+
+    pathInDirectory("missing.bundle", bundlePath);
+    CORE_TEST_ASSERT(ScoreBundleOpen(bundlePath) == NULL);
+}
+
+static void testSignature(void)
+{
+    char path[CORE_TEST_PATH_LENGTH];
+    uint64_t signature = ScoreBundleSignature(scoreDirectory);
+
+    //Hidden files don't count.
+    pathInScore(".pyramid/skip", path);
+    CoreTestWriteFile(path, "changed", 7);
+    pathInScore(".hidden", path);
+    CoreTestWriteFile(path, "new", 3);
+    CORE_TEST_ASSERT(ScoreBundleSignature(scoreDirectory) == signature);
+
+    //Anything else does, even in a subdirectory.
+    pathInScore("sub/b.txt", path);
+    CoreTestWriteFile(path, "yy", 2);
+    uint64_t changed = ScoreBundleSignature(scoreDirectory);
+    CORE_TEST_ASSERT(changed != signature);
+    pathInScore("sub/c.txt", path);
+    CoreTestWriteFile(path, "", 0);
+    CORE_TEST_ASSERT(ScoreBundleSignature(scoreDirectory) != changed);
+    unlink(path);
+    CORE_TEST_ASSERT(ScoreBundleSignature(scoreDirectory) == changed);
+
+    pathInDirectory("missing", path);
+    CORE_TEST_ASSERT(ScoreBundleSignature(path) == 0);
+}
+
+static void testRejectedItems(void)
+{
+    char textPath[CORE_TEST_PATH_LENGTH], bundlePath[CORE_TEST_PATH_LENGTH];
+    pathInScore("sub/b.txt", textPath);
+    pathInDirectory("rejected.bundle", bundlePath);
+
+    //A file that isn't the size it was listed as.
+    ScoreBundleItem item = {"sub/b.txt", kScoreBundleFile, 1000, 0, 0, textPath, NULL, 0};
+    CORE_TEST_ASSERT(!ScoreBundleWrite(bundlePath, 1, "g", &item, 1));
+    //Two items with the same name.
+    ScoreBundleItem duplicates[2] = {
+        {"a_1.png", kScoreBundleImage, 100000, 640, 480, NULL, NULL, 0},
+        {"a_1.png", kScoreBundleImage, 100000, 640, 480, NULL, NULL, 0}
+    };
+    CORE_TEST_ASSERT(!ScoreBundleWrite(bundlePath, 1, "g", duplicates, 2));
+    CORE_TEST_ASSERT(ScoreBundleOpen(bundlePath) == NULL);
+}
+
+static void testDamaged(void)
+{
+    //Truncated and corrupted bundles are either refused or open with everything in bounds.
+    //(Under ASan, any read outside the mapping fails the suite.)
+    char opusPath[CORE_TEST_PATH_LENGTH], bundlePath[CORE_TEST_PATH_LENGTH], damagedPath[CORE_TEST_PATH_LENGTH];
+    pathInScore("opus.xml", opusPath);
+    pathInDirectory("good.bundle", bundlePath);
+    pathInDirectory("damaged.bundle", damagedPath);
+    ScoreBundleItem items[3] = {
+        {"opus.xml", kScoreBundleXML, 7, 0, 0, opusPath, "PARSED", 6},
+        {"a_1.png", kScoreBundleImage, 100000, 640, 480, NULL, NULL, 0},
+        {"b_1.png", kScoreBundleImage, 100000, 640, 480, NULL, NULL, 0}
+    };
+    CORE_TEST_ASSERT(ScoreBundleWrite(bundlePath, 1, "generator", items, 3));
+    size_t length;
+    uint8_t *good = readFile(bundlePath, &length);
+    CORE_TEST_ASSERT(good != NULL);
+    if (good == NULL) {
+        return;
+    }
+
+    uint64_t state = 1;
+    int opened = 0;
+    bool inBounds = true;
+    uint8_t *damaged = malloc(length);
+    for (int i = 0; i < 3000; i++) {
+        memcpy(damaged, good, length);
+        size_t damagedLength = length;
+        if (i % 3 == 0) {
+            damagedLength = CoreTestRandom(&state) % length;
+        } else {
+            //Damage the header and directory, where the offsets are.
+            for (int j = 0; j < 4; j++) {
+                damaged[CoreTestRandom(&state) % (sizeof(ScoreBundleEntry) * 3 + 80)] = (uint8_t)CoreTestRandom(&state);
+            }
+        }
+        CoreTestWriteFile(damagedPath, damaged, damagedLength);
+
+        ScoreBundle *bundle = ScoreBundleOpen(damagedPath);
+        if (bundle == NULL) {
+            continue;
+        }
+        opened++;
+        const uint8_t *start = bundle->mapping, *end = start + bundle->length;
+        for (size_t j = 0; j < bundle->entryCount; j++) {
+            const ScoreBundleEntry *entry = &bundle->entries[j];
+            ScoreBundleFind(bundle, bundle->strings + entry->nameOffset, entry->nameLength);
+            const uint8_t *data = ScoreBundleData(bundle, entry);
+            const uint8_t *parsed = ScoreBundleParsed(bundle, entry);
+            inBounds = inBounds && (const uint8_t *)bundle->strings + entry->nameOffset + entry->nameLength <= end;
+            inBounds = inBounds && (data == NULL || (data >= start && entry->dataLength <= (uint64_t)(end - data)));
+            inBounds = inBounds && (parsed == NULL || (parsed >= start && entry->parsedLength <= (uint64_t)(end - parsed)));
+        }
+        ScoreBundleClose(bundle);
+    }
+    CORE_TEST_ASSERT(inBounds);
+    //Some of the damage is in places that don't matter, so not everything is refused.
+    CORE_TEST_ASSERT(opened > 0 && opened < 3000);
+    free(damaged);
+    free(good);
+}
+
+void ScoreBundleTests(void)
+{
+    CORE_TEST_ASSERT(CoreTestMakeDirectory("ScoreBundleTests", directory));
+    makeScore();
+    testRoundTrip();
+    testSignature();
+    testRejectedItems();
+    testDamaged();
+    CoreTestRemoveDirectory(directory);
+}
+
+void ScoreBundleBenchmark(void)
+{
+    //Switching to a 300 tile scroll score: checking every tile by opening it and reading its
+    //PNG header, against opening the bundle, checking its signature and looking up each tile.
+    CoreTestMakeDirectory("ScoreBundleBenchmark", directory);
+    pathInDirectory("score", scoreDirectory);
+    mkdir(scoreDirectory, 0755);
+    static char names[300][32];
+    static char paths[300][CORE_TEST_PATH_LENGTH];
+    ScoreBundleItem items[300];
+    uint8_t *image = calloc(1, 200000);
+    for (int i = 0; i < 300; i++) {
+        snprintf(names[i], sizeof(names[i]), "tile_%d.png", i + 1);
+        pathInScore(names[i], paths[i]);
+        CoreTestWriteFile(paths[i], image, 200000);
+        items[i] = (ScoreBundleItem){names[i], kScoreBundleImage, 200000, 4000, 1024, NULL, NULL, 0};
+    }
+    free(image);
+    char bundlePath[CORE_TEST_PATH_LENGTH];
+    pathInDirectory("score.bundle", bundlePath);
+    CORE_TEST_ASSERT(ScoreBundleWrite(bundlePath, ScoreBundleSignature(scoreDirectory), "1", items, 300));
+
+    int runs = 200;
+    long total = 0;
+    uint8_t header[33];
+    double start = CoreTestTime();
+    for (int run = 0; run < runs; run++) {
+        for (int i = 0; i < 300; i++) {
+            struct stat status;
+            if (stat(paths[i], &status) == 0) {
+                int fd = open(paths[i], O_RDONLY);
+                total += read(fd, header, sizeof(header));
+                close(fd);
+            }
+        }
+    }
+    double probeTime = (CoreTestTime() - start) / runs;
+
+    bool found = true;
+    start = CoreTestTime();
+    for (int run = 0; run < runs; run++) {
+        ScoreBundle *bundle = ScoreBundleOpen(bundlePath);
+        found = found && bundle != NULL && bundle->signature == ScoreBundleSignature(scoreDirectory);
+        for (int i = 0; found && i < 300; i++) {
+            const ScoreBundleEntry *entry = ScoreBundleFind(bundle, names[i], strlen(names[i]));
+            found = entry != NULL && entry->width == 4000;
+        }
+        ScoreBundleClose(bundle);
+    }
+    double bundleTime = (CoreTestTime() - start) / runs;
+    CORE_TEST_ASSERT(found && total == (long)runs * 300 * (long)sizeof(header));
+
+    CoreTestReport("ScoreBundle 300 tiles, probing each file", probeTime * 1e3, "ms");
+    CoreTestReport("ScoreBundle 300 tiles, open and look up", bundleTime * 1e3, "ms");
+    CoreTestRemoveDirectory(directory);
+}
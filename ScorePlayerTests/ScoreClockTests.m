@@ -0,0 +1,127 @@
+//
+//  ScoreClockTests.m
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ScoreClockTests.h"
+#import "ScoreClock.h"
+
+static const NSTimeInterval SIMULATED_DURATION = 3600;
+
+@interface ScoreClockTests () <ScoreClockDelegate>
+
+- (ScoreClock *)simulatedClockWithInterval:(NSTimeInterval)interval;
+
+@end
+
+@implementation ScoreClockTests {
+    NSTimeInterval simulatedTime;
+    NSMutableArray *ticks;
+    NSMutableArray *tickTimes;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    simulatedTime = 0;
+    ticks = [[NSMutableArray alloc] init];
+    tickTimes = [[NSMutableArray alloc] init];
+}
+
+- (void)testNoDriftOverAnHour
+{
+    //Wake up late by a varying amount, as a busy main thread would, for an hour of simulated
+    //time. Every tick should still land on its own boundary, with none lost or repeated.
+    ScoreClock *clock = [self simulatedClockWithInterval:1];
+    [clock startAtPosition:0];
+    
+    uint32_t randomState = 1;
+    while (simulatedTime < SIMULATED_DURATION) {
+        randomState = randomState * 1664525 + 1013904223;
+        //Anywhere from on time to 300 ms late, with the occasional stall of several seconds.
+        NSTimeInterval lateness = (randomState >> 8) % 300 / 1000.0;
+        if (randomState % 500 == 0) {
+            lateness += 3;
+        }
+        simulatedTime = floor(simulatedTime) + 1 + lateness;
+        [clock fireDueTicks];
+    }
+    
+    NSInteger expectedTicks = (NSInteger)floor(simulatedTime);
+    XCTAssertEqual((NSInteger)[ticks count], expectedTicks);
+    BOOL consecutive = YES;
+    BOOL onTime = YES;
+    for (NSInteger i = 0; i < [ticks count]; i++) {
+        consecutive = consecutive && [[ticks objectAtIndex:i] integerValue] == i + 1;
+        //A tick is never delivered before its boundary.
+        onTime = onTime && [[tickTimes objectAtIndex:i] doubleValue] >= i + 1 - 0.000001;
+    }
+    XCTAssertTrue(consecutive);
+    XCTAssertTrue(onTime);
+    
+    //The position is exactly the elapsed time.
+    XCTAssertEqualWithAccuracy(clock.position, simulatedTime, 0.000001);
+    [clock stop];
+}
+
+- (void)testFractionalIntervals
+{
+    //Tenths of a second don't accumulate floating point error over an hour.
+    ScoreClock *clock = [self simulatedClockWithInterval:0.1];
+    [clock startAtPosition:0];
+    for (int i = 1; i <= SIMULATED_DURATION * 10; i++) {
+        simulatedTime = i * 0.1;
+        [clock fireDueTicks];
+    }
+    XCTAssertEqual((NSInteger)[ticks count], (NSInteger)(SIMULATED_DURATION * 10));
+    XCTAssertEqual([[ticks lastObject] integerValue], (NSInteger)(SIMULATED_DURATION * 10));
+    [clock stop];
+}
+
+- (void)testSeekAndStop
+{
+    ScoreClock *clock = [self simulatedClockWithInterval:1];
+    simulatedTime = 50;
+    
+    //Starting part way through a second, the first tick is the next whole boundary.
+    [clock startAtPosition:10.4];
+    simulatedTime = 50.5;
+    [clock fireDueTicks];
+    XCTAssertEqual([ticks count], (NSUInteger)0);
+    simulatedTime = 50.6;
+    [clock fireDueTicks];
+    XCTAssertEqualObjects([ticks lastObject], [NSNumber numberWithInteger:11]);
+    
+    //Stopping freezes the position.
+    [clock stop];
+    simulatedTime = 60;
+    [clock fireDueTicks];
+    XCTAssertEqual([ticks count], (NSUInteger)1);
+    XCTAssertEqualWithAccuracy(clock.position, 11, 0.000001);
+}
+
+#pragma mark - Private methods
+
+- (ScoreClock *)simulatedClockWithInterval:(NSTimeInterval)interval
+{
+    ScoreClock *clock = [[ScoreClock alloc] initWithTickInterval:interval delegate:self];
+    __weak ScoreClockTests *weakSelf = self;
+    clock.timeSource = ^{
+        ScoreClockTests *strongSelf = weakSelf;
+        return strongSelf != nil ? strongSelf->simulatedTime : 0;
+    };
+    return clock;
+}
+
+#pragma mark - ScoreClock delegate
+
+- (void)scoreClock:(ScoreClock *)scoreClock tick:(NSInteger)tickCount
+{
+    [ticks addObject:[NSNumber numberWithInteger:tickCount]];
+    [tickTimes addObject:[NSNumber numberWithDouble:simulatedTime]];
+}
+
+@end
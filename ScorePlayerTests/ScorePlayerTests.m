@@ -7,26 +7,135 @@
 //
 
 #import "ScorePlayerTests.h"
+#import "CoreTest.h"
 
+//Runs the suites for the portable C cores. (These can also be run from the command line using the
+//Makefile in this directory.)
 @implementation ScorePlayerTests
 
-- (void)setUp
+- (void)testOSCView
 {
-    [super setUp];
-    
-    // Set-up code here.
+    XCTAssertEqual(CoreTestRun("OSCView", OSCViewTests), (size_t)0);
 }
 
-- (void)tearDown
+- (void)testTimingWheel
 {
-    // Tear-down code here.
-    
-    [super tearDown];
+    XCTAssertEqual(CoreTestRun("TimingWheel", TimingWheelTests), (size_t)0);
 }
 
-- (void)testExample
+- (void)testTimingWheelBenchmark
 {
-    XCTFail(@"Unit tests are not implemented yet in ScorePlayerTests");
+    XCTAssertEqual(CoreTestRun("TimingWheel benchmark", TimingWheelBenchmark), (size_t)0);
+}
+
+- (void)testImageCache
+{
+    XCTAssertEqual(CoreTestRun("ImageCache", ImageCacheTests), (size_t)0);
+}
+
+- (void)testImageDownscale
+{
+    XCTAssertEqual(CoreTestRun("ImageDownscale", ImageDownscaleTests), (size_t)0);
+}
+
+- (void)testImageDownscaleBenchmark
+{
+    XCTAssertEqual(CoreTestRun("ImageDownscale benchmark", ImageDownscaleBenchmark), (size_t)0);
+}
+
+- (void)testRawTileCache
+{
+    XCTAssertEqual(CoreTestRun("RawTileCache", RawTileCacheTests), (size_t)0);
+}
+
+- (void)testRawTileCacheBenchmark
+{
+    XCTAssertEqual(CoreTestRun("RawTileCache benchmark", RawTileCacheBenchmark), (size_t)0);
+}
+
+- (void)testXMLReader
+{
+    XCTAssertEqual(CoreTestRun("XMLReader", XMLReaderTests), (size_t)0);
+}
+
+- (void)testXMLReaderBenchmark
+{
+    XCTAssertEqual(CoreTestRun("XMLReader benchmark", XMLReaderBenchmark), (size_t)0);
+}
+
+- (void)testScoreBundle
+{
+    XCTAssertEqual(CoreTestRun("ScoreBundle", ScoreBundleTests), (size_t)0);
+}
+
+- (void)testScoreBundleBenchmark
+{
+    XCTAssertEqual(CoreTestRun("ScoreBundle benchmark", ScoreBundleBenchmark), (size_t)0);
+}
+
+- (void)testTrigramIndex
+{
+    XCTAssertEqual(CoreTestRun("TrigramIndex", TrigramIndexTests), (size_t)0);
+}
+
+- (void)testTrigramIndexBenchmark
+{
+    XCTAssertEqual(CoreTestRun("TrigramIndex benchmark", TrigramIndexBenchmark), (size_t)0);
+}
+
+- (void)testReadAheadStream
+{
+    XCTAssertEqual(CoreTestRun("ReadAheadStream", ReadAheadStreamTests), (size_t)0);
+}
+
+- (void)testReadAheadStreamBenchmark
+{
+    XCTAssertEqual(CoreTestRun("ReadAheadStream benchmark", ReadAheadStreamBenchmark), (size_t)0);
+}
+
+- (void)testScoreUpdate
+{
+    XCTAssertEqual(CoreTestRun("ScoreUpdate", ScoreUpdateTests), (size_t)0);
+}
+
+- (void)testScoreUpdateBenchmark
+{
+    XCTAssertEqual(CoreTestRun("ScoreUpdate benchmark", ScoreUpdateBenchmark), (size_t)0);
+}
+
+- (void)testZipExtract
+{
+    XCTAssertEqual(CoreTestRun("ZipExtract", ZipExtractTests), (size_t)0);
+}
+
+- (void)testZipCompress
+{
+    XCTAssertEqual(CoreTestRun("ZipCompress", ZipCompressTests), (size_t)0);
+}
+
+- (void)testZipMount
+{
+    XCTAssertEqual(CoreTestRun("ZipMount", ZipMountTests), (size_t)0);
+}
+
+- (void)testCrc32
+{
+    XCTAssertEqual(CoreTestRun("Crc32", Crc32Tests), (size_t)0);
+}
+
+- (void)testCrc32Benchmark
+{
+    XCTAssertEqual(CoreTestRun("Crc32 benchmark", Crc32MethodsBenchmark), (size_t)0);
+}
+
+- (void)testScoreVerify
+{
+    XCTAssertEqual(CoreTestRun("ScoreVerify", ScoreVerifyTests), (size_t)0);
+}
+
+- (void)testAssetStore
+{
+    XCTAssertEqual(CoreTestRun("AssetStore", AssetStoreTests), (size_t)0);
 }
 
 @end
@@ -0,0 +1,381 @@
+//
+//  ScoreUpdateTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "ScoreUpdate.h"
+#include <CommonCrypto/CommonDigest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DIGEST_A "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+#define DIGEST_B "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb"
+#define HEADER "ScorePlayer update 1\n"
+
+static char directory[CORE_TEST_PATH_LENGTH];
+
+//A delta being put together in memory, in the format described in ScoreUpdate.h.
+typedef struct {
+    uint8_t *bytes;
+    size_t length;
+    size_t capacity;
+} Delta;
+
+static void appendBytes(Delta *delta, const void *bytes, size_t length)
+{
+    if (delta->length + length > delta->capacity) {
+        delta->capacity = (delta->length + length) * 2;
+        delta->bytes = realloc(delta->bytes, delta->capacity);
+    }
+    memcpy(delta->bytes + delta->length, bytes, length);
+    delta->length += length;
+}
+
+static void appendLittleEndian(Delta *delta, uint64_t value, int length)
+{
+    uint8_t bytes[8];
+    for (int i = 0; i < length; i++) {
+        bytes[i] = (uint8_t)(value >> (i * 8));
+    }
+    appendBytes(delta, bytes, length);
+}
+
+static void startDelta(Delta *delta, uint64_t targetLength)
+{
+    delta->bytes = NULL;
+    delta->length = 0;
+    delta->capacity = 0;
+    appendBytes(delta, "SPDELTA1", 8);
+    appendLittleEndian(delta, targetLength, 8);
+}
+
+static void appendCopy(Delta *delta, uint64_t offset, uint32_t length)
+{
+    appendBytes(delta, "\x01", 1);
+    appendLittleEndian(delta, offset, 8);
+    appendLittleEndian(delta, length, 4);
+}
+
+static void appendAdd(Delta *delta, const uint8_t *bytes, uint32_t length)
+{
+    appendBytes(delta, "\x02", 1);
+    appendLittleEndian(delta, length, 4);
+    appendBytes(delta, bytes, length);
+}
+
+//The simplest delta that does any good: copy what the two have in common at either end, and add
+//whatever's left in between (in pieces of at most maxAdd bytes).
+static void makeDelta(Delta *delta, const uint8_t *base, size_t baseLength, const uint8_t *target, size_t targetLength, uint32_t maxAdd)
+{
+    size_t shorter = baseLength < targetLength ? baseLength : targetLength;
+    size_t prefix = 0, suffix = 0;
+    while (prefix < shorter && base[prefix] == target[prefix]) {
+        prefix++;
+    }
+    while (suffix < shorter - prefix && base[baseLength - 1 - suffix] == target[targetLength - 1 - suffix]) {
+        suffix++;
+    }
+    startDelta(delta, targetLength);
+    if (prefix > 0) {
+        appendCopy(delta, 0, (uint32_t)prefix);
+    }
+    for (size_t i = prefix; i < targetLength - suffix; i += maxAdd) {
+        size_t remaining = targetLength - suffix - i;
+        appendAdd(delta, target + i, (uint32_t)(remaining < maxAdd ? remaining : maxAdd));
+    }
+    if (suffix > 0) {
+        appendCopy(delta, baseLength - suffix, (uint32_t)suffix);
+    }
+}
+
+static void digestOfBytes(const uint8_t *bytes, size_t length, char hex[SCORE_UPDATE_DIGEST_LENGTH])
+{
+    uint8_t digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_CTX context;
+    CC_SHA256_Init(&context);
+    CC_SHA256_Update(&context, bytes, (CC_LONG)length);
+    CC_SHA256_Final(digest, &context);
+    for (int i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+        snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+}
+
+static uint8_t *readFile(const char *path, size_t *length)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *length = (size_t)ftell(file);
+    rewind(file);
+    uint8_t *bytes = malloc(*length + 1);
+    if (fread(bytes, 1, *length, file) != *length) {
+        free(bytes);
+        bytes = NULL;
+    }
+    fclose(file);
+    return bytes;
+}
+
+//Applies a delta (written out first) and checks that the output is exactly the target, or that
+//nothing was left behind if the delta is expected to fail.
+static bool applyDelta(const uint8_t *base, size_t baseLength, const Delta *delta, const uint8_t *target, size_t targetLength)
+{
+    char deltaPath[CORE_TEST_PATH_LENGTH], outputPath[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "delta", deltaPath);
+    CoreTestPath(directory, "output", outputPath);
+    CoreTestWriteFile(deltaPath, delta->length > 0 ? (const void *)delta->bytes : "", delta->length);
+    //Whatever was at the output path before is replaced either way.
+    CoreTestWriteFile(outputPath, "stale", 5);
+
+    char digest[SCORE_UPDATE_DIGEST_LENGTH];
+    bool applied = ScoreUpdateApplyDelta(base, baseLength, deltaPath, outputPath, digest);
+    if (target == NULL) {
+        return !applied && access(outputPath, F_OK) != 0;
+    }
+
+    size_t outputLength = 0;
+    uint8_t *output = readFile(outputPath, &outputLength);
+    char expectedDigest[SCORE_UPDATE_DIGEST_LENGTH];
+    digestOfBytes(target, targetLength, expectedDigest);
+    bool matches = applied && output != NULL && outputLength == targetLength && memcmp(output, target, targetLength) == 0 && strcmp(digest, expectedDigest) == 0;
+    free(output);
+    unlink(outputPath);
+    return matches;
+}
+
+static bool manifestIsRejected(const char *text)
+{
+    ScoreUpdateManifest *manifest = ScoreUpdateManifestParse(text, strlen(text));
+    ScoreUpdateManifestFree(manifest);
+    return manifest == NULL;
+}
+
+static void testManifest(void)
+{
+    //Names run to the end of the line (spaces and all), carriage returns are dropped, and lines
+    //the parser doesn't know are skipped.
+    const char *text = HEADER
+        "file " DIGEST_A " 12 opus.xml\n"
+        "file " DIGEST_B " 0 img/a b.png\r\n"
+        "delta " DIGEST_A " " DIGEST_B " 40\n"
+        "delta " DIGEST_A " " DIGEST_B " 30\n"
+        "delta " DIGEST_B " " DIGEST_A " 10\n"
+        "something from a later version\n"
+        "\n";
+    ScoreUpdateManifest *manifest = ScoreUpdateManifestParse(text, strlen(text));
+    CORE_TEST_ASSERT(manifest != NULL);
+    if (manifest != NULL) {
+        CORE_TEST_ASSERT(ScoreUpdateManifestFileCount(manifest) == 2);
+        const ScoreUpdateFile *first = ScoreUpdateManifestFileAtIndex(manifest, 0);
+        const ScoreUpdateFile *second = ScoreUpdateManifestFileAtIndex(manifest, 1);
+        CORE_TEST_ASSERT(strcmp(first->name, "opus.xml") == 0 && first->size == 12 && strcmp(first->digest, DIGEST_A) == 0);
+        CORE_TEST_ASSERT(strcmp(second->name, "img/a b.png") == 0 && second->size == 0 && strcmp(second->digest, DIGEST_B) == 0);
+        CORE_TEST_ASSERT(ScoreUpdateManifestFileAtIndex(manifest, 2) == NULL);
+
+        //The smallest delta wins, and deltas only go one way.
+        const ScoreUpdateDelta *delta = ScoreUpdateManifestFindDelta(manifest, DIGEST_A, DIGEST_B);
+        CORE_TEST_ASSERT(delta != NULL && delta->size == 30);
+        delta = ScoreUpdateManifestFindDelta(manifest, DIGEST_B, DIGEST_A);
+        CORE_TEST_ASSERT(delta != NULL && delta->size == 10);
+        CORE_TEST_ASSERT(ScoreUpdateManifestFindDelta(manifest, DIGEST_A, DIGEST_A) == NULL);
+    }
+    ScoreUpdateManifestFree(manifest);
+
+    manifest = ScoreUpdateManifestParse(HEADER, strlen(HEADER));
+    CORE_TEST_ASSERT(manifest != NULL && ScoreUpdateManifestFileCount(manifest) == 0);
+    ScoreUpdateManifestFree(manifest);
+
+    CORE_TEST_ASSERT(manifestIsRejected(""));
+    CORE_TEST_ASSERT(manifestIsRejected("ScorePlayer update 2\n"));
+    //A manifest that's been cut short.
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 12 opus.xml"));
+    //Names that would lead outside the score, or that aren't names at all.
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 12 ../opus.xml\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 12 img/../../opus.xml\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 12 /etc/passwd\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 12 img//a.png\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 12 img/./a.png\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 12 img/\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 12\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 12 a\nfile " DIGEST_B " 1 a\n"));
+    //Digests and sizes.
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA 12 a\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file aaaa 12 a\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A "a 12 a\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " -1 a\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 99999999999999999999 a\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "file " DIGEST_A " 12x a\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "delta " DIGEST_A " " DIGEST_B " 5 x\n"));
+    CORE_TEST_ASSERT(manifestIsRejected(HEADER "delta " DIGEST_A " 5\n"));
+
+    //A NUL anywhere would cut a name short.
+    const char withNul[] = HEADER "file " DIGEST_A " 12 a\0b\n";
+    manifest = ScoreUpdateManifestParse(withNul, sizeof(withNul) - 1);
+    CORE_TEST_ASSERT(manifest == NULL);
+    ScoreUpdateManifestFree(manifest);
+}
+
+static void testDelta(void)
+{
+    //A base with some edits made to it: bytes changed in the middle, something cut from the start
+    //and something added to the end.
+    uint64_t state = 11;
+    size_t baseLength = 300000;
+    uint8_t *base = malloc(baseLength);
+    for (size_t i = 0; i < baseLength; i++) {
+        base[i] = (uint8_t)CoreTestRandom(&state);
+    }
+    size_t targetLength = baseLength + 1000;
+    uint8_t *target = malloc(targetLength);
+    memcpy(target, base, baseLength);
+    for (size_t i = 150000; i < 150100; i++) {
+        target[i] = (uint8_t)CoreTestRandom(&state);
+    }
+    memset(target + baseLength, 'x', 1000);
+
+    //Adds bigger than the buffer they pass through, and ones much smaller.
+    Delta delta;
+    makeDelta(&delta, base, baseLength, target, targetLength, 200000);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, target, targetLength));
+    free(delta.bytes);
+    makeDelta(&delta, base, baseLength, target, targetLength, 7);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, target, targetLength));
+    free(delta.bytes);
+    makeDelta(&delta, base, baseLength, target + 5000, targetLength - 5000, 65536);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, target + 5000, targetLength - 5000));
+    free(delta.bytes);
+
+    //Copies can go anywhere in the base, and in any order.
+    startDelta(&delta, 300);
+    appendCopy(&delta, 200000, 100);
+    appendCopy(&delta, 0, 100);
+    appendCopy(&delta, 200000, 100);
+    uint8_t *reordered = malloc(300);
+    memcpy(reordered, base + 200000, 100);
+    memcpy(reordered + 100, base, 100);
+    memcpy(reordered + 200, base + 200000, 100);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, reordered, 300));
+    free(reordered);
+    free(delta.bytes);
+
+    //Empty files, on either side.
+    startDelta(&delta, 0);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, (const uint8_t *)"", 0));
+    free(delta.bytes);
+    startDelta(&delta, 3);
+    appendAdd(&delta, (const uint8_t *)"new", 3);
+    CORE_TEST_ASSERT(applyDelta(NULL, 0, &delta, (const uint8_t *)"new", 3));
+    free(delta.bytes);
+
+    //Malformed deltas fail without leaving anything behind.
+    makeDelta(&delta, base, baseLength, target, targetLength, 65536);
+    delta.length -= 3;
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, NULL, 0));
+    delta.length = 12;
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, NULL, 0));
+    delta.bytes[0] = 'X';
+    delta.length = 16;
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, NULL, 0));
+    free(delta.bytes);
+
+    startDelta(&delta, 10);
+    appendCopy(&delta, baseLength - 5, 10);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, NULL, 0));
+    free(delta.bytes);
+    startDelta(&delta, 10);
+    appendCopy(&delta, UINT64_MAX, 10);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, NULL, 0));
+    free(delta.bytes);
+    startDelta(&delta, 10);
+    appendCopy(&delta, 0, 11);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, NULL, 0));
+    free(delta.bytes);
+    startDelta(&delta, 2);
+    appendAdd(&delta, (const uint8_t *)"abc", 3);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, NULL, 0));
+    free(delta.bytes);
+    startDelta(&delta, 5);
+    appendAdd(&delta, (const uint8_t *)"abc", 3);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, NULL, 0));
+    free(delta.bytes);
+    startDelta(&delta, 0);
+    appendBytes(&delta, "\x07", 1);
+    CORE_TEST_ASSERT(applyDelta(base, baseLength, &delta, NULL, 0));
+    free(delta.bytes);
+
+    //Or if there's no delta at all.
+    char missingPath[CORE_TEST_PATH_LENGTH], outputPath[CORE_TEST_PATH_LENGTH];
+    char digest[SCORE_UPDATE_DIGEST_LENGTH];
+    CoreTestPath(directory, "missing", missingPath);
+    CoreTestPath(directory, "output", outputPath);
+    CORE_TEST_ASSERT(!ScoreUpdateApplyDelta(base, baseLength, missingPath, outputPath, digest));
+
+    free(target);
+    free(base);
+}
+
+void ScoreUpdateTests(void)
+{
+    CORE_TEST_ASSERT(CoreTestMakeDirectory("ScoreUpdateTests", directory));
+    testManifest();
+    testDelta();
+    CoreTestRemoveDirectory(directory);
+}
+
+void ScoreUpdateBenchmark(void)
+{
+    //A 20 MB file with a small edit in the middle, which is what a corrected page of a score looks
+    //like to the updater, against reading the whole of the new version.
+    CORE_TEST_ASSERT(CoreTestMakeDirectory("ScoreUpdateBenchmark", directory));
+    uint64_t state = 5;
+    size_t baseLength = 20 * 1024 * 1024;
+    uint8_t *base = malloc(baseLength);
+    for (size_t i = 0; i < baseLength; i++) {
+        base[i] = (uint8_t)CoreTestRandom(&state);
+    }
+    uint8_t *target = malloc(baseLength);
+    memcpy(target, base, baseLength);
+    memcpy(target + baseLength / 2, "a corrected bar", 15);
+
+    Delta delta;
+    makeDelta(&delta, base, baseLength, target, baseLength, 65536);
+    char deltaPath[CORE_TEST_PATH_LENGTH], outputPath[CORE_TEST_PATH_LENGTH], fullPath[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "delta", deltaPath);
+    CoreTestPath(directory, "output", outputPath);
+    CoreTestPath(directory, "full", fullPath);
+    CoreTestWriteFile(deltaPath, delta.bytes, delta.length);
+
+    int runs = 5;
+    double applyTime = 0, digestTime = 0;
+    char digest[SCORE_UPDATE_DIGEST_LENGTH], expectedDigest[SCORE_UPDATE_DIGEST_LENGTH];
+    bool applied = true;
+    for (int run = 0; run < runs; run++) {
+        double start = CoreTestTime();
+        applied = applied && ScoreUpdateApplyDelta(base, baseLength, deltaPath, outputPath, digest);
+        applyTime += CoreTestTime() - start;
+
+        //Checking a whole downloaded file is the least that the full download has to do.
+        start = CoreTestTime();
+        CoreTestWriteFile(fullPath, target, baseLength);
+        digestOfBytes(target, baseLength, expectedDigest);
+        digestTime += CoreTestTime() - start;
+    }
+    CORE_TEST_ASSERT(applied && strcmp(digest, expectedDigest) == 0);
+
+    CoreTestReport("ScoreUpdate delta size, 20 MB file", (double)delta.length, "bytes");
+    CoreTestReport("ScoreUpdate apply delta", applyTime / runs * 1e3, "ms");
+    CoreTestReport("ScoreUpdate write and check whole file", digestTime / runs * 1e3, "ms");
+
+    free(delta.bytes);
+    free(target);
+    free(base);
+    CoreTestRemoveDirectory(directory);
+}
@@ -0,0 +1,345 @@
+//
+//  ScoreUpdaterTests.m
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "ScoreUpdaterTests.h"
+#import "ScoreUpdater.h"
+#import "ScoreAssetStore.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static void appendLittleEndian(NSMutableData *data, uint64_t value, int length)
+{
+    uint8_t bytes[8];
+    for (int i = 0; i < length; i++) {
+        bytes[i] = (uint8_t)(value >> (i * 8));
+    }
+    [data appendBytes:bytes length:length];
+}
+
+@interface ScoreUpdaterTests ()
+
+- (void)startServer;
+- (void)serveConnection:(int)connection;
+- (void)writeScore;
+- (NSData *)deltaFrom:(NSData *)base to:(NSData *)target;
+- (NSString *)manifestLineForData:(NSData *)data name:(NSString *)name;
+- (void)publishManifest:(NSString *)manifest;
+- (BOOL)runUpdater:(ScoreUpdater *)updater;
+- (NSData *)dataInScore:(NSString *)name;
+
+@end
+
+@implementation ScoreUpdaterTests {
+    NSString *directory;
+    NSString *scorePath;
+    NSString *workingDirectory;
+    NSFileManager *fileManager;
+    
+    //The stand-in for the update server, which serves the responses by path relative to baseURL.
+    dispatch_queue_t serverQueue;
+    dispatch_source_t listenSource;
+    NSURL *baseURL;
+    NSMutableDictionary *responses;
+    NSMutableArray *requestedPaths;
+    
+    //The score as it is on the device, and the version that the update brings it up to.
+    NSData *opus;
+    NSData *oldPage;
+    NSData *newPage;
+    NSData *notes;
+    NSData *part;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    fileManager = [NSFileManager defaultManager];
+    directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    scorePath = [[directory stringByAppendingPathComponent:@"Scores"] stringByAppendingPathComponent:@"Test Score"];
+    workingDirectory = [directory stringByAppendingPathComponent:@"Updates"];
+    [fileManager createDirectoryAtPath:workingDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+    
+    responses = [[NSMutableDictionary alloc] init];
+    requestedPaths = [[NSMutableArray alloc] init];
+    [self startServer];
+    [self writeScore];
+}
+
+- (void)tearDown
+{
+    dispatch_source_cancel(listenSource);
+    //Let anything still being served finish before the files go.
+    dispatch_sync(serverQueue, ^{});
+    [fileManager removeItemAtPath:directory error:nil];
+    [super tearDown];
+}
+
+- (void)testUpdate
+{
+    //Only the delta for the changed page and the new part should be fetched. The opus file is kept,
+    //and the notes that the new version doesn't have are gone.
+    NSData *delta = [self deltaFrom:oldPage to:newPage];
+    NSString *oldPageDigest = [ScoreAssetStore digestOfData:oldPage];
+    NSString *newPageDigest = [ScoreAssetStore digestOfData:newPage];
+    NSString *partDigest = [ScoreAssetStore digestOfData:part];
+    NSString *deltaPath = [NSString stringWithFormat:@"deltas/%@-%@", oldPageDigest, newPageDigest];
+    NSString *manifest = [NSString stringWithFormat:@"ScorePlayer update 1\n%@%@%@delta %@ %@ %lu\n", [self manifestLineForData:opus name:@"opus.xml"], [self manifestLineForData:newPage name:@"page_1.png"], [self manifestLineForData:part name:@"parts/violin.txt"], oldPageDigest, newPageDigest, (unsigned long)[delta length]];
+    [self publishManifest:manifest];
+    [responses setObject:delta forKey:deltaPath];
+    [responses setObject:newPage forKey:[@"objects/" stringByAppendingString:newPageDigest]];
+    [responses setObject:part forKey:[@"objects/" stringByAppendingString:partDigest]];
+    
+    ScoreUpdater *updater = [[ScoreUpdater alloc] initWithScorePath:scorePath manifestURL:[NSURL URLWithString:@"manifest" relativeToURL:baseURL] workingDirectory:workingDirectory];
+    XCTAssertTrue([self runUpdater:updater]);
+    
+    XCTAssertEqualObjects([self dataInScore:@"opus.xml"], opus);
+    XCTAssertEqualObjects([self dataInScore:@"page_1.png"], newPage);
+    XCTAssertEqualObjects([self dataInScore:@"parts/violin.txt"], part);
+    XCTAssertNil([self dataInScore:@"notes.txt"]);
+    XCTAssertFalse([fileManager fileExistsAtPath:[workingDirectory stringByAppendingPathComponent:@"Test Score"]]);
+    XCTAssertFalse([fileManager fileExistsAtPath:[scorePath stringByAppendingString:@".bak"]]);
+    
+    NSArray *expectedPaths = [NSArray arrayWithObjects:@"manifest", deltaPath, [@"objects/" stringByAppendingString:partDigest], nil];
+    XCTAssertEqualObjects([NSSet setWithArray:requestedPaths], [NSSet setWithArray:expectedPaths]);
+    XCTAssertEqual([requestedPaths count], [expectedPaths count]);
+    XCTAssertEqual(updater.fileCount, (NSInteger)3);
+    XCTAssertEqual(updater.reusedFiles, (NSInteger)1);
+    XCTAssertEqual(updater.totalBytes, (unsigned long long)([opus length] + [newPage length] + [part length]));
+    XCTAssertEqual(updater.downloadBytes, (unsigned long long)([delta length] + [part length]));
+    XCTAssertEqual(updater.receivedBytes, updater.downloadBytes);
+    
+    //The new files have been shared with the rest of the library, once the store has got to them.
+    dispatch_sync([ScoreAssetStore queue], ^{});
+    XCTAssertNotNil([ScoreAssetStore storedFileWithDigest:newPageDigest scoresDirectory:[scorePath stringByDeletingLastPathComponent]]);
+}
+
+- (void)testBrokenDelta
+{
+    //A delta that doesn't produce the file it says it does is thrown away, and the whole file is
+    //downloaded instead.
+    NSMutableData *delta = [[self deltaFrom:oldPage to:newPage] mutableCopy];
+    ((uint8_t *)[delta mutableBytes])[[delta length] - 1] ^= 0xff;
+    NSString *oldPageDigest = [ScoreAssetStore digestOfData:oldPage];
+    NSString *newPageDigest = [ScoreAssetStore digestOfData:newPage];
+    NSString *deltaPath = [NSString stringWithFormat:@"deltas/%@-%@", oldPageDigest, newPageDigest];
+    NSString *manifest = [NSString stringWithFormat:@"ScorePlayer update 1\n%@%@delta %@ %@ %lu\n", [self manifestLineForData:opus name:@"opus.xml"], [self manifestLineForData:newPage name:@"page_1.png"], oldPageDigest, newPageDigest, (unsigned long)[delta length]];
+    [self publishManifest:manifest];
+    [responses setObject:delta forKey:deltaPath];
+    [responses setObject:newPage forKey:[@"objects/" stringByAppendingString:newPageDigest]];
+    
+    ScoreUpdater *updater = [[ScoreUpdater alloc] initWithScorePath:scorePath manifestURL:[NSURL URLWithString:@"manifest" relativeToURL:baseURL] workingDirectory:workingDirectory];
+    XCTAssertTrue([self runUpdater:updater]);
+    XCTAssertEqualObjects([self dataInScore:@"page_1.png"], newPage);
+    XCTAssertEqualObjects([self dataInScore:@"opus.xml"], opus);
+    
+    NSArray *expectedPaths = [NSArray arrayWithObjects:@"manifest", deltaPath, [@"objects/" stringByAppendingString:newPageDigest], nil];
+    XCTAssertEqualObjects(requestedPaths, expectedPaths);
+    XCTAssertEqual(updater.downloadBytes, (unsigned long long)([delta length] + [newPage length]));
+    XCTAssertEqual(updater.receivedBytes, updater.downloadBytes);
+}
+
+- (void)testMissingFile
+{
+    //If anything can't be had, the score is left exactly as it was.
+    NSString *manifest = [NSString stringWithFormat:@"ScorePlayer update 1\n%@%@", [self manifestLineForData:opus name:@"opus.xml"], [self manifestLineForData:part name:@"parts/violin.txt"]];
+    [self publishManifest:manifest];
+    
+    ScoreUpdater *updater = [[ScoreUpdater alloc] initWithScorePath:scorePath manifestURL:[NSURL URLWithString:@"manifest" relativeToURL:baseURL] workingDirectory:workingDirectory];
+    XCTAssertFalse([self runUpdater:updater]);
+    XCTAssertEqualObjects([self dataInScore:@"opus.xml"], opus);
+    XCTAssertEqualObjects([self dataInScore:@"page_1.png"], oldPage);
+    XCTAssertEqualObjects([self dataInScore:@"notes.txt"], notes);
+    XCTAssertNil([self dataInScore:@"parts/violin.txt"]);
+    XCTAssertFalse([fileManager fileExistsAtPath:[workingDirectory stringByAppendingPathComponent:@"Test Score"]]);
+}
+
+- (void)testUnsafeManifest
+{
+    //A manifest that would write outside the score is refused before anything is downloaded.
+    NSString *partDigest = [ScoreAssetStore digestOfData:part];
+    NSString *manifest = [NSString stringWithFormat:@"ScorePlayer update 1\n%@", [self manifestLineForData:part name:@"../escaped.txt"]];
+    [self publishManifest:manifest];
+    [responses setObject:part forKey:[@"objects/" stringByAppendingString:partDigest]];
+    
+    ScoreUpdater *updater = [[ScoreUpdater alloc] initWithScorePath:scorePath manifestURL:[NSURL URLWithString:@"manifest" relativeToURL:baseURL] workingDirectory:workingDirectory];
+    XCTAssertFalse([self runUpdater:updater]);
+    XCTAssertEqualObjects(requestedPaths, [NSArray arrayWithObject:@"manifest"]);
+    XCTAssertFalse([fileManager fileExistsAtPath:[workingDirectory stringByAppendingPathComponent:@"escaped.txt"]]);
+    XCTAssertFalse([fileManager fileExistsAtPath:[[scorePath stringByDeletingLastPathComponent] stringByAppendingPathComponent:@"escaped.txt"]]);
+    XCTAssertEqualObjects([self dataInScore:@"page_1.png"], oldPage);
+}
+
+#pragma mark - Private methods
+
+- (void)startServer
+{
+    //A bare HTTP server on the loopback interface. Each connection gets one response, and then
+    //it's closed.
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_len = sizeof(address);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressLength = sizeof(address);
+    XCTAssertEqual(bind(listener, (struct sockaddr *)&address, sizeof(address)), 0);
+    XCTAssertEqual(listen(listener, 16), 0);
+    getsockname(listener, (struct sockaddr *)&address, &addressLength);
+    baseURL = [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%d/update/", ntohs(address.sin_port)]];
+    
+    serverQueue = dispatch_queue_create("com.decibel.scoreupdatertests", DISPATCH_QUEUE_SERIAL);
+    listenSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, listener, 0, serverQueue);
+    __weak ScoreUpdaterTests *weakSelf = self;
+    dispatch_source_set_event_handler(listenSource, ^{
+        int connection = accept(listener, NULL, NULL);
+        if (connection >= 0) {
+            [weakSelf serveConnection:connection];
+            close(connection);
+        }
+    });
+    dispatch_source_set_cancel_handler(listenSource, ^{
+        close(listener);
+    });
+    dispatch_resume(listenSource);
+}
+
+- (void)serveConnection:(int)connection
+{
+    int noSigPipe = 1;
+    setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+    
+    //Read up to the end of the headers. Only GETs are expected, so there's no body.
+    NSMutableData *request = [[NSMutableData alloc] init];
+    NSData *headerEnd = [@"\r\n\r\n" dataUsingEncoding:NSASCIIStringEncoding];
+    char buffer[1024];
+    while ([request rangeOfData:headerEnd options:0 range:NSMakeRange(0, [request length])].location == NSNotFound) {
+        ssize_t count = read(connection, buffer, sizeof(buffer));
+        if (count <= 0) {
+            return;
+        }
+        [request appendBytes:buffer length:count];
+    }
+    NSString *requestText = [[NSString alloc] initWithData:request encoding:NSASCIIStringEncoding];
+    NSArray *requestLine = [[[requestText componentsSeparatedByString:@"\r\n"] objectAtIndex:0] componentsSeparatedByString:@" "];
+    if ([requestLine count] < 3) {
+        return;
+    }
+    NSString *path = [requestLine objectAtIndex:1];
+    if ([path hasPrefix:baseURL.path]) {
+        path = [[path substringFromIndex:[baseURL.path length]] stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"/"]];
+    }
+    
+    NSData *body;
+    @synchronized (self) {
+        [requestedPaths addObject:path];
+        body = [responses objectForKey:path];
+    }
+    NSString *status = body != nil ? @"200 OK" : @"404 Not Found";
+    NSMutableData *response = [[[NSString stringWithFormat:@"HTTP/1.1 %@\r\nContent-Length: %lu\r\nContent-Type: application/octet-stream\r\nConnection: close\r\n\r\n", status, (unsigned long)[body length]] dataUsingEncoding:NSASCIIStringEncoding] mutableCopy];
+    if (body != nil) {
+        [response appendData:body];
+    }
+    
+    const uint8_t *bytes = [response bytes];
+    size_t remaining = [response length];
+    while (remaining > 0) {
+        ssize_t count = write(connection, bytes, remaining);
+        if (count <= 0) {
+            return;
+        }
+        bytes += count;
+        remaining -= count;
+    }
+}
+
+- (void)writeScore
+{
+    opus = [@"<opus><score name=\"Test Score\"/></opus>" dataUsingEncoding:NSUTF8StringEncoding];
+    notes = [@"Performance notes" dataUsingEncoding:NSUTF8StringEncoding];
+    part = [@"A new violin part" dataUsingEncoding:NSUTF8StringEncoding];
+    
+    //The page is big enough that a delta is worth having, and is changed in one place.
+    NSMutableData *page = [NSMutableData dataWithLength:200000];
+    arc4random_buf([page mutableBytes], [page length]);
+    oldPage = [page copy];
+    [page replaceBytesInRange:NSMakeRange(120000, 16) withBytes:"a corrected bar!"];
+    newPage = [page copy];
+    
+    [fileManager createDirectoryAtPath:scorePath withIntermediateDirectories:YES attributes:nil error:nil];
+    [opus writeToFile:[scorePath stringByAppendingPathComponent:@"opus.xml"] atomically:NO];
+    [oldPage writeToFile:[scorePath stringByAppendingPathComponent:@"page_1.png"] atomically:NO];
+    [notes writeToFile:[scorePath stringByAppendingPathComponent:@"notes.txt"] atomically:NO];
+}
+
+- (NSData *)deltaFrom:(NSData *)base to:(NSData *)target
+{
+    //Copy what the two have in common at either end, and add what's left in the middle. (See
+    //ScoreUpdate.h for the format.)
+    const uint8_t *baseBytes = [base bytes];
+    const uint8_t *targetBytes = [target bytes];
+    NSUInteger shorter = MIN([base length], [target length]);
+    NSUInteger prefix = 0, suffix = 0;
+    while (prefix < shorter && baseBytes[prefix] == targetBytes[prefix]) {
+        prefix++;
+    }
+    while (suffix < shorter - prefix && baseBytes[[base length] - 1 - suffix] == targetBytes[[target length] - 1 - suffix]) {
+        suffix++;
+    }
+    
+    NSMutableData *delta = [NSMutableData dataWithBytes:"SPDELTA1" length:8];
+    appendLittleEndian(delta, [target length], 8);
+    if (prefix > 0) {
+        [delta appendBytes:"\x01" length:1];
+        appendLittleEndian(delta, 0, 8);
+        appendLittleEndian(delta, prefix, 4);
+    }
+    NSUInteger middle = [target length] - prefix - suffix;
+    if (middle > 0) {
+        [delta appendBytes:"\x02" length:1];
+        appendLittleEndian(delta, middle, 4);
+        [delta appendBytes:targetBytes + prefix length:middle];
+    }
+    if (suffix > 0) {
+        [delta appendBytes:"\x01" length:1];
+        appendLittleEndian(delta, [base length] - suffix, 8);
+        appendLittleEndian(delta, suffix, 4);
+    }
+    return delta;
+}
+
+- (NSString *)manifestLineForData:(NSData *)data name:(NSString *)name
+{
+    return [NSString stringWithFormat:@"file %@ %lu %@\n", [ScoreAssetStore digestOfData:data], (unsigned long)[data length], name];
+}
+
+- (void)publishManifest:(NSString *)manifest
+{
+    [responses setObject:[manifest dataUsingEncoding:NSUTF8StringEncoding] forKey:@"manifest"];
+}
+
+- (BOOL)runUpdater:(ScoreUpdater *)updater
+{
+    XCTestExpectation *finished = [self expectationWithDescription:@"Update finished"];
+    __block BOOL updated = NO;
+    [updater updateWithCompletionHandler:^(BOOL success) {
+        XCTAssertTrue([NSThread isMainThread]);
+        updated = success;
+        [finished fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:30 handler:nil];
+    return updated;
+}
+
+- (NSData *)dataInScore:(NSString *)name
+{
+    return [NSData dataWithContentsOfFile:[scorePath stringByAppendingPathComponent:name]];
+}
+
+@end
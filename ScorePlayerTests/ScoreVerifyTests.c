@@ -0,0 +1,196 @@
+//
+//  ScoreVerifyTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "ScoreVerify.h"
+#include "ZipTestArchive.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAXIMUM_WORKERS 4
+#define PAGE_LENGTH 200000
+
+static char directory[CORE_TEST_PATH_LENGTH];
+static char archivePath[CORE_TEST_PATH_LENGTH];
+static char manifestPath[CORE_TEST_PATH_LENGTH];
+static char scorePath[CORE_TEST_PATH_LENGTH];
+
+static const char *fileNames[] = {"score.xml", "pages/1.png", "pages/2.png", "parts/empty"};
+
+static void *runWorker(void *verification)
+{
+    return ScoreVerificationRunWorker(verification) ? verification : NULL;
+}
+
+static bool verify(ScoreVerification *verification, char *failedFile)
+{
+    //Runs the workers, and copies out the name of the bad file if there is one.
+    size_t workerCount = ScoreVerificationWorkerCount(verification, MAXIMUM_WORKERS);
+    pthread_t workers[MAXIMUM_WORKERS];
+    for (size_t i = 0; i < workerCount; i++) {
+        pthread_create(&workers[i], NULL, runWorker, verification);
+    }
+    bool success = true;
+    for (size_t i = 0; i < workerCount; i++) {
+        void *result;
+        pthread_join(workers[i], &result);
+        success = success && result != NULL;
+    }
+    const char *name = ScoreVerificationFailedFile(verification);
+    snprintf(failedFile, CORE_TEST_PATH_LENGTH, "%s", name != NULL ? name : "");
+    return success;
+}
+
+static bool verifyScore(char *failedFile)
+{
+    ScoreVerification *verification = ScoreVerificationOpenManifest(manifestPath, scorePath);
+    if (verification == NULL) {
+        return false;
+    }
+    bool success = verify(verification, failedFile);
+    ScoreVerificationClose(verification);
+    return success;
+}
+
+static void makeScore(void)
+{
+    //An archive with a stored and a deflated page, its manifest, and the same files extracted.
+    uint64_t state = 24;
+    uint8_t *pages[2];
+    for (int i = 0; i < 2; i++) {
+        pages[i] = malloc(PAGE_LENGTH);
+        for (size_t j = 0; j < PAGE_LENGTH; j++) {
+            pages[i][j] = i == 0 || j % 5 == 0 ? (uint8_t)CoreTestRandom(&state) : (uint8_t)j;
+        }
+    }
+    const char *score = "<score><page>1.png</page><page>2.png</page></score>";
+    const void *contents[] = {score, pages[0], pages[1], ""};
+    const size_t lengths[] = {strlen(score), PAGE_LENGTH, PAGE_LENGTH, 0};
+    const ZipTestEntryKind kinds[] = {kZipTestDeflated, kZipTestStored, kZipTestDeflated, kZipTestStored};
+
+    char path[CORE_TEST_PATH_LENGTH];
+    ZipTestArchive archive;
+    ZipTestArchiveInit(&archive);
+    mkdir(scorePath, 0755);
+    CoreTestPath(scorePath, "pages", path);
+    mkdir(path, 0755);
+    CoreTestPath(scorePath, "parts", path);
+    mkdir(path, 0755);
+    for (int i = 0; i < 4; i++) {
+        ZipTestArchiveAdd(&archive, fileNames[i], contents[i], lengths[i], kinds[i]);
+        CoreTestPath(scorePath, fileNames[i], path);
+        CoreTestWriteFile(path, contents[i], lengths[i]);
+    }
+    CORE_TEST_ASSERT(ZipTestArchiveWrite(&archive, archivePath));
+    ZipTestArchiveFree(&archive);
+    free(pages[0]);
+    free(pages[1]);
+    CORE_TEST_ASSERT(ScoreVerifyWriteManifest(archivePath, manifestPath));
+}
+
+static void changeByte(const char *path, long offset)
+{
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL) {
+        return;
+    }
+    fseek(file, offset, SEEK_SET);
+    int c = fgetc(file);
+    fseek(file, offset, SEEK_SET);
+    fputc(c ^ 0x01, file);
+    fclose(file);
+}
+
+static void testGoodScore(void)
+{
+    //Both the archive and the extracted files match, and files that aren't in the manifest
+    //don't matter.
+    char failedFile[CORE_TEST_PATH_LENGTH], path[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(scorePath, "annotations.xml", path);
+    CoreTestWriteFile(path, "<annotations/>", 14);
+
+    ScoreVerification *verification = ScoreVerificationOpenManifest(manifestPath, scorePath);
+    CORE_TEST_ASSERT(verification != NULL);
+    if (verification != NULL) {
+        CORE_TEST_ASSERT(verify(verification, failedFile));
+        CORE_TEST_ASSERT(failedFile[0] == '\0');
+        ScoreVerificationProgress progress;
+        ScoreVerificationGetProgress(verification, &progress);
+        CORE_TEST_ASSERT(progress.fileCount == 4 && progress.verifiedFiles == 4);
+        CORE_TEST_ASSERT(progress.totalBytes == progress.verifiedBytes && progress.totalBytes > 2 * PAGE_LENGTH);
+        ScoreVerificationClose(verification);
+    }
+
+    verification = ScoreVerificationOpenArchive(archivePath);
+    CORE_TEST_ASSERT(verification != NULL);
+    if (verification != NULL) {
+        CORE_TEST_ASSERT(verify(verification, failedFile));
+        ScoreVerificationClose(verification);
+    }
+}
+
+static void testCorruptedFiles(void)
+{
+    //A changed byte, a truncated file and a missing one are each caught, and named.
+    char failedFile[CORE_TEST_PATH_LENGTH], path[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(scorePath, "pages/2.png", path);
+    changeByte(path, PAGE_LENGTH - 1);
+    CORE_TEST_ASSERT(!verifyScore(failedFile));
+    CORE_TEST_ASSERT(strcmp(failedFile, "pages/2.png") == 0);
+    changeByte(path, PAGE_LENGTH - 1);
+    CORE_TEST_ASSERT(verifyScore(failedFile));
+
+    CoreTestPath(scorePath, "score.xml", path);
+    CORE_TEST_ASSERT(truncate(path, 10) == 0);
+    CORE_TEST_ASSERT(!verifyScore(failedFile));
+    CORE_TEST_ASSERT(strcmp(failedFile, "score.xml") == 0);
+
+    CORE_TEST_ASSERT(unlink(path) == 0);
+    CORE_TEST_ASSERT(!verifyScore(failedFile));
+    CORE_TEST_ASSERT(strcmp(failedFile, "score.xml") == 0);
+
+    //The stored page in the archive comes straight after the first entry, so a byte well into
+    //the archive is part of it.
+    changeByte(archivePath, PAGE_LENGTH / 2);
+    ScoreVerification *verification = ScoreVerificationOpenArchive(archivePath);
+    CORE_TEST_ASSERT(verification != NULL);
+    if (verification != NULL) {
+        CORE_TEST_ASSERT(!verify(verification, failedFile));
+        CORE_TEST_ASSERT(strcmp(failedFile, "pages/1.png") == 0);
+        ScoreVerificationClose(verification);
+    }
+}
+
+static void testBadManifests(void)
+{
+    //Manifests that are missing, or aren't manifests at all, can't be opened.
+    char path[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "missing", path);
+    CORE_TEST_ASSERT(ScoreVerificationOpenManifest(path, scorePath) == NULL);
+    CoreTestPath(directory, "bad", path);
+    CoreTestWriteFile(path, "not a manifest\n", 15);
+    CORE_TEST_ASSERT(ScoreVerificationOpenManifest(path, scorePath) == NULL);
+    CORE_TEST_ASSERT(ScoreVerificationOpenArchive(path) == NULL);
+}
+
+void ScoreVerifyTests(void)
+{
+    CORE_TEST_ASSERT(CoreTestMakeDirectory("ScoreVerifyTests", directory));
+    CoreTestPath(directory, "score.zip", archivePath);
+    CoreTestPath(directory, "manifest", manifestPath);
+    CoreTestPath(directory, "score", scorePath);
+    makeScore();
+    testGoodScore();
+    testCorruptedFiles();
+    testBadManifests();
+    CoreTestRemoveDirectory(directory);
+}
@@ -0,0 +1,116 @@
+//
+//  TilePyramidTests.m
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#import "TilePyramidTests.h"
+#import "TilePyramid.h"
+
+@interface TilePyramidTests ()
+
+- (NSString *)writeImageNamed:(NSString *)name size:(CGSize)size colour:(UIColor *)colour;
+
+@end
+
+@implementation TilePyramidTests {
+    NSString *directory;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    //Levels are indexed by directory, so each test gets a fresh one.
+    directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+    [super tearDown];
+}
+
+- (void)testBuildLevels
+{
+    NSString *fileName = [self writeImageNamed:@"score.png" size:CGSizeMake(1001, 333) colour:[UIColor redColor]];
+    XCTAssertFalse([TilePyramid hasLevelsForImage:fileName]);
+    XCTAssertEqualObjects([TilePyramid pathForImage:fileName atScale:0.1], fileName);
+    
+    XCTAssertTrue([TilePyramid buildLevelsForImage:fileName]);
+    XCTAssertTrue([TilePyramid hasLevelsForImage:fileName]);
+    
+    //Each level is half the size of the one before, rounding up.
+    NSString *half = [TilePyramid pathForImage:fileName atScale:0.5];
+    NSString *quarter = [TilePyramid pathForImage:fileName atScale:0.2];
+    XCTAssertNotEqualObjects(half, fileName);
+    XCTAssertNotEqualObjects(quarter, half);
+    UIImage *halfImage = [UIImage imageWithContentsOfFile:half];
+    UIImage *quarterImage = [UIImage imageWithContentsOfFile:quarter];
+    XCTAssertEqual(CGImageGetWidth(halfImage.CGImage), (size_t)501);
+    XCTAssertEqual(CGImageGetHeight(halfImage.CGImage), (size_t)167);
+    XCTAssertEqual(CGImageGetWidth(quarterImage.CGImage), (size_t)251);
+    XCTAssertEqual(CGImageGetHeight(quarterImage.CGImage), (size_t)84);
+    
+    //Anything drawn above half size needs the original.
+    XCTAssertEqualObjects([TilePyramid pathForImage:fileName atScale:0.75], fileName);
+    XCTAssertEqualObjects([TilePyramid pathForImage:fileName atScale:0.25], quarter);
+}
+
+- (void)testChangedImage
+{
+    NSString *fileName = [self writeImageNamed:@"score_1.png" size:CGSizeMake(200, 100) colour:[UIColor blueColor]];
+    XCTAssertTrue([TilePyramid buildLevelsForImage:fileName]);
+    
+    //Replacing the image makes its levels out of date until they're rebuilt.
+    [self writeImageNamed:@"score_1.png" size:CGSizeMake(300, 100) colour:[UIColor greenColor]];
+    NSDate *later = [NSDate dateWithTimeIntervalSinceNow:10];
+    [[NSFileManager defaultManager] setAttributes:[NSDictionary dictionaryWithObject:later forKey:NSFileModificationDate] ofItemAtPath:fileName error:nil];
+    XCTAssertFalse([TilePyramid hasLevelsForImage:fileName]);
+    
+    XCTAssertTrue([TilePyramid buildLevelsForImage:fileName]);
+    XCTAssertTrue([TilePyramid hasLevelsForImage:fileName]);
+    UIImage *halfImage = [UIImage imageWithContentsOfFile:[TilePyramid pathForImage:fileName atScale:0.5]];
+    XCTAssertEqual(CGImageGetWidth(halfImage.CGImage), (size_t)150);
+}
+
+- (void)testMissingImage
+{
+    NSString *fileName = [directory stringByAppendingPathComponent:@"missing.png"];
+    XCTAssertFalse([TilePyramid buildLevelsForImage:fileName]);
+    XCTAssertFalse([TilePyramid hasLevelsForImage:fileName]);
+    XCTAssertEqualObjects([TilePyramid pathForImage:fileName atScale:0.25], fileName);
+}
+
+- (void)testBuildPerformance
+{
+    //A typical scroll score strip.
+    NSString *fileName = [self writeImageNamed:@"strip.png" size:CGSizeMake(8000, 1400) colour:[UIColor blackColor]];
+    [self measureBlock:^{
+        [[NSFileManager defaultManager] removeItemAtPath:[self->directory stringByAppendingPathComponent:@".pyramid"] error:nil];
+        [[NSFileManager defaultManager] setAttributes:[NSDictionary dictionaryWithObject:[NSDate date] forKey:NSFileModificationDate] ofItemAtPath:fileName error:nil];
+        XCTAssertTrue([TilePyramid buildLevelsForImage:fileName]);
+    }];
+}
+
+#pragma mark - Private methods
+
+- (NSString *)writeImageNamed:(NSString *)name size:(CGSize)size colour:(UIColor *)colour
+{
+    UIGraphicsImageRendererFormat *format = [UIGraphicsImageRendererFormat defaultFormat];
+    format.scale = 1;
+    UIGraphicsImageRenderer *renderer = [[UIGraphicsImageRenderer alloc] initWithSize:size format:format];
+    NSData *data = [renderer PNGDataWithActions:^(UIGraphicsImageRendererContext *context) {
+        [colour setFill];
+        [context fillRect:CGRectMake(0, 0, size.width, size.height)];
+        [[UIColor whiteColor] setFill];
+        [context fillRect:CGRectMake(0, 0, size.width / 3, size.height / 2)];
+    }];
+    NSString *fileName = [directory stringByAppendingPathComponent:name];
+    [data writeToFile:fileName atomically:YES];
+    return fileName;
+}
+
+@end
@@ -0,0 +1,349 @@
+//
+//  TimingWheelTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "TimingWheel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RESOLUTION 0.01
+#define MODEL_EVENTS 2000
+#define BENCHMARK_EVENTS 50000
+
+typedef struct {
+    TimingWheelEntry entry;
+    int identifier;
+    //The model's view of the event, checked against the wheel.
+    uint64_t due;
+    bool scheduled;
+} Event;
+
+typedef struct {
+    TimingWheel *wheel;
+    Event *events;
+    size_t eventCount;
+    int fired[MODEL_EVENTS * 2];
+    uint64_t firedDue[MODEL_EVENTS * 2];
+    size_t firedCount;
+    uint64_t now;
+    bool inOrder;
+    bool notEarly;
+    uint64_t *randomState;
+} FireLog;
+
+static void initEvents(Event *events, size_t count)
+{
+    memset(events, 0, count * sizeof(Event));
+    for (size_t i = 0; i < count; i++) {
+        events[i].identifier = (int)i;
+        events[i].entry.context = &events[i];
+    }
+}
+
+static double timeForTick(uint64_t tick)
+{
+    //The middle of the tick, so that rounding never moves it.
+    return (tick + 0.5) * RESOLUTION;
+}
+
+static void logEvent(TimingWheelEntry *entry, void *userData)
+{
+    FireLog *log = userData;
+    Event *event = entry->context;
+    event->scheduled = false;
+    log->notEarly = log->notEarly && event->due <= log->now;
+    if (log->firedCount > 0 && log->firedDue[log->firedCount - 1] > event->due) {
+        log->inOrder = false;
+    }
+    if (log->firedCount < MODEL_EVENTS * 2) {
+        log->fired[log->firedCount] = event->identifier;
+        log->firedDue[log->firedCount] = event->due;
+        log->firedCount++;
+    }
+}
+
+static void testOrder(void)
+{
+    TimingWheel wheel;
+    TimingWheelInit(&wheel, RESOLUTION, 0);
+    Event events[6];
+    initEvents(events, 6);
+
+    //Spread across every level and the overflow list.
+    uint64_t dues[6] = {5, 3, 70, 5000, 300000, 20000000};
+    for (int i = 0; i < 6; i++) {
+        events[i].due = dues[i];
+        events[i].scheduled = true;
+        TimingWheelSchedule(&wheel, &events[i].entry, timeForTick(dues[i]));
+    }
+    CORE_TEST_ASSERT(wheel.count == 6);
+    CORE_TEST_ASSERT(TimingWheelIsScheduled(&events[0].entry));
+
+    //Cancelling is immediate, and cancelling twice does nothing.
+    TimingWheelCancel(&wheel, &events[2].entry);
+    events[2].scheduled = false;
+    TimingWheelCancel(&wheel, &events[2].entry);
+    CORE_TEST_ASSERT(wheel.count == 5);
+    CORE_TEST_ASSERT(!TimingWheelIsScheduled(&events[2].entry));
+
+    FireLog log = {&wheel, events, 6, {0}, {0}, 0, 0, true, true, NULL};
+    log.now = 4;
+    TimingWheelAdvance(&wheel, timeForTick(4), logEvent, &log);
+    CORE_TEST_ASSERT(log.firedCount == 1 && log.fired[0] == 1);
+
+    log.now = 20000000;
+    TimingWheelAdvance(&wheel, timeForTick(20000000), logEvent, &log);
+    CORE_TEST_ASSERT(log.firedCount == 5);
+    CORE_TEST_ASSERT(log.inOrder && log.notEarly);
+    CORE_TEST_ASSERT(wheel.count == 0);
+    CORE_TEST_ASSERT(TimingWheelCurrentTime(&wheel) >= 20000000 * RESOLUTION);
+}
+
+static void testPastAndRescheduling(void)
+{
+    TimingWheel wheel;
+    TimingWheelInit(&wheel, RESOLUTION, 10);
+    Event events[2];
+    initEvents(events, 2);
+    FireLog log = {&wheel, events, 2, {0}, {0}, 0, 1000, true, true, NULL};
+
+    //Anything in the past goes out on the next advance, even one that doesn't move time on.
+    events[0].due = 0;
+    TimingWheelSchedule(&wheel, &events[0].entry, 1);
+    TimingWheelAdvance(&wheel, 9, logEvent, &log);
+    CORE_TEST_ASSERT(log.firedCount == 1);
+
+    //Scheduling again moves an entry rather than adding it twice.
+    TimingWheelSchedule(&wheel, &events[1].entry, 12);
+    TimingWheelSchedule(&wheel, &events[1].entry, 11);
+    CORE_TEST_ASSERT(wheel.count == 1);
+    events[1].due = 1100;
+    TimingWheelAdvance(&wheel, 11.005, logEvent, &log);
+    CORE_TEST_ASSERT(log.firedCount == 2 && log.fired[1] == 1);
+    CORE_TEST_ASSERT(wheel.count == 0);
+}
+
+static void testSeek(void)
+{
+    TimingWheel wheel;
+    TimingWheelInit(&wheel, RESOLUTION, 100);
+    Event events[3];
+    initEvents(events, 3);
+    FireLog log = {&wheel, events, 3, {0}, {0}, 0, 0, true, true, NULL};
+
+    TimingWheelSchedule(&wheel, &events[0].entry, 101);
+    TimingWheelSchedule(&wheel, &events[1].entry, 150);
+    TimingWheelSchedule(&wheel, &events[2].entry, 1000);
+
+    //Seeking forward past an entry doesn't fire it...
+    TimingWheelSeek(&wheel, 200);
+    CORE_TEST_ASSERT(wheel.count == 3);
+    CORE_TEST_ASSERT(TimingWheelCurrentTime(&wheel) > 199.999 && TimingWheelCurrentTime(&wheel) < 200.001);
+    //...but it goes out on the next advance.
+    log.now = UINT64_MAX;
+    TimingWheelAdvance(&wheel, 200, logEvent, &log);
+    CORE_TEST_ASSERT(log.firedCount == 2);
+    CORE_TEST_ASSERT(wheel.count == 1);
+
+    //Seeking back leaves the later entry waiting for its own time.
+    TimingWheelSeek(&wheel, 0);
+    TimingWheelAdvance(&wheel, 999.5, logEvent, &log);
+    CORE_TEST_ASSERT(log.firedCount == 2);
+    TimingWheelAdvance(&wheel, 1000, logEvent, &log);
+    CORE_TEST_ASSERT(log.firedCount == 3 && log.fired[2] == 2);
+}
+
+static void testIdleAdvance(void)
+{
+    //An empty wheel jumps straight to the new time, however far away it is.
+    TimingWheel wheel;
+    TimingWheelInit(&wheel, RESOLUTION, 0);
+    double start = CoreTestTime();
+    TimingWheelAdvance(&wheel, 1e9, NULL, NULL);
+    CORE_TEST_ASSERT(CoreTestTime() - start < 0.1);
+    CORE_TEST_ASSERT(wheel.nextTick == (uint64_t)(1e9 / RESOLUTION) + 1);
+
+    //So bringing it up to date before scheduling keeps the next advance short.
+    Event event;
+    initEvents(&event, 1);
+    TimingWheelAdvance(&wheel, 2e9, NULL, NULL);
+    TimingWheelSchedule(&wheel, &event.entry, 2e9 + 1);
+    FireLog log = {&wheel, &event, 1, {0}, {0}, 0, UINT64_MAX, true, true, NULL};
+    start = CoreTestTime();
+    TimingWheelAdvance(&wheel, 2e9 + 1, logEvent, &log);
+    CORE_TEST_ASSERT(CoreTestTime() - start < 0.1);
+    CORE_TEST_ASSERT(log.firedCount == 1);
+}
+
+static void clearEvent(TimingWheelEntry *entry, void *userData)
+{
+    ((Event *)entry->context)->scheduled = false;
+}
+
+static void fireAndMeddle(TimingWheelEntry *entry, void *userData)
+{
+    //Callbacks may cancel other entries and occasionally clear the whole wheel.
+    FireLog *log = userData;
+    logEvent(entry, userData);
+    uint32_t choice = CoreTestRandom(log->randomState);
+    if (choice % 10 == 0) {
+        Event *other = &log->events[CoreTestRandom(log->randomState) % log->eventCount];
+        TimingWheelCancel(log->wheel, &other->entry);
+        other->scheduled = false;
+    } else if (choice % 500 == 1) {
+        TimingWheelClear(log->wheel, clearEvent, NULL);
+    }
+}
+
+static void testRandomised(void)
+{
+    //Random operations checked against a simple model of which events should be scheduled.
+    static Event events[MODEL_EVENTS];
+    static FireLog log;
+    uint64_t state = 1;
+    TimingWheel wheel;
+    bool consistent = true;
+
+    for (int round = 0; round < 20; round++) {
+        TimingWheelInit(&wheel, RESOLUTION, (CoreTestRandom(&state) % 100000) * RESOLUTION);
+        initEvents(events, MODEL_EVENTS);
+        memset(&log, 0, sizeof(FireLog));
+        log.wheel = &wheel;
+        log.events = events;
+        log.eventCount = MODEL_EVENTS;
+        log.randomState = &state;
+
+        for (int step = 0; step < 3000; step++) {
+            uint32_t operation = CoreTestRandom(&state) % 100;
+            Event *event = &events[CoreTestRandom(&state) % MODEL_EVENTS];
+            if (operation < 50) {
+                uint64_t due;
+                switch (CoreTestRandom(&state) % 5) {
+                    case 0:
+                        due = wheel.nextTick + CoreTestRandom(&state) % 64;
+                        break;
+                    case 1:
+                        due = wheel.nextTick + CoreTestRandom(&state) % 5000;
+                        break;
+                    case 2:
+                        due = wheel.nextTick + CoreTestRandom(&state) % 300000;
+                        break;
+                    case 3:
+                        due = wheel.nextTick + CoreTestRandom(&state) % 40000000;
+                        break;
+                    default:
+                        due = wheel.nextTick > 100 ? wheel.nextTick - CoreTestRandom(&state) % 100 : 0;
+                        break;
+                }
+                TimingWheelSchedule(&wheel, &event->entry, timeForTick(due));
+                event->due = due;
+                event->scheduled = true;
+            } else if (operation < 60) {
+                TimingWheelCancel(&wheel, &event->entry);
+                event->scheduled = false;
+            } else if (operation < 95) {
+                uint64_t startTick = wheel.nextTick;
+                uint64_t target = startTick + (CoreTestRandom(&state) % 4 == 0 ? CoreTestRandom(&state) % 200000 : CoreTestRandom(&state) % 100);
+                log.now = target;
+                log.firedCount = 0;
+                log.inOrder = true;
+                log.notEarly = true;
+                TimingWheelAdvance(&wheel, timeForTick(target), fireAndMeddle, &log);
+                consistent = consistent && wheel.nextTick == target + 1 && log.notEarly;
+                //Entries that were already overdue go out first in no particular order, and the
+                //rest follow in order of their due tick.
+                for (size_t i = 1; i < log.firedCount; i++) {
+                    if (log.firedDue[i - 1] >= startTick) {
+                        consistent = consistent && log.firedDue[i] >= log.firedDue[i - 1];
+                    }
+                }
+                for (size_t i = 0; i < MODEL_EVENTS; i++) {
+                    consistent = consistent && !(events[i].scheduled && events[i].due <= target);
+                }
+            } else {
+                uint64_t tick;
+                if (CoreTestRandom(&state) % 2 == 0) {
+                    tick = wheel.nextTick + CoreTestRandom(&state) % 100000;
+                } else {
+                    tick = wheel.nextTick > 50000 ? wheel.nextTick - CoreTestRandom(&state) % 50000 : wheel.nextTick;
+                }
+                TimingWheelSeek(&wheel, timeForTick(tick));
+                consistent = consistent && wheel.nextTick == tick;
+            }
+
+            size_t count = 0;
+            for (size_t i = 0; i < MODEL_EVENTS; i++) {
+                count += events[i].scheduled ? 1 : 0;
+                consistent = consistent && TimingWheelIsScheduled(&events[i].entry) == events[i].scheduled;
+            }
+            consistent = consistent && count == wheel.count;
+        }
+        TimingWheelClear(&wheel, clearEvent, NULL);
+        consistent = consistent && wheel.count == 0;
+    }
+    CORE_TEST_ASSERT(consistent);
+}
+
+static void countEvent(TimingWheelEntry *entry, void *userData)
+{
+    (*(size_t *)userData)++;
+}
+
+void TimingWheelTests(void)
+{
+    testOrder();
+    testPastAndRescheduling();
+    testSeek();
+    testIdleAdvance();
+    testRandomised();
+}
+
+void TimingWheelBenchmark(void)
+{
+    //Rodinia style events: 50k of them spread over ten minutes of score time at 10 ms resolution.
+    Event *events = malloc(BENCHMARK_EVENTS * sizeof(Event));
+    initEvents(events, BENCHMARK_EVENTS);
+    double *times = malloc(BENCHMARK_EVENTS * sizeof(double));
+    uint64_t state = 1;
+    for (size_t i = 0; i < BENCHMARK_EVENTS; i++) {
+        times[i] = (CoreTestRandom(&state) % 600000) / 1000.0;
+    }
+
+    TimingWheel wheel;
+    TimingWheelInit(&wheel, RESOLUTION, 0);
+    double start = CoreTestTime();
+    for (size_t i = 0; i < BENCHMARK_EVENTS; i++) {
+        TimingWheelSchedule(&wheel, &events[i].entry, times[i]);
+    }
+    CoreTestReport("TimingWheel insert 50k", (CoreTestTime() - start) * 1e9 / BENCHMARK_EVENTS, "ns/event");
+
+    //Cancel every other event.
+    start = CoreTestTime();
+    for (size_t i = 0; i < BENCHMARK_EVENTS; i += 2) {
+        TimingWheelCancel(&wheel, &events[i].entry);
+    }
+    CoreTestReport("TimingWheel cancel 25k", (CoreTestTime() - start) * 1e9 / (BENCHMARK_EVENTS / 2), "ns/event");
+
+    //Seek to the middle and back again, rearming everything that's left each time.
+    start = CoreTestTime();
+    TimingWheelSeek(&wheel, 300);
+    TimingWheelSeek(&wheel, 0);
+    CoreTestReport("TimingWheel seek with 25k pending", (CoreTestTime() - start) * 1e3 / 2, "ms/seek");
+
+    //Then play through at 60 frames per second.
+    size_t fired = 0;
+    start = CoreTestTime();
+    for (int frame = 0; frame <= 600 * 60; frame++) {
+        TimingWheelAdvance(&wheel, frame / 60.0, countEvent, &fired);
+    }
+    CoreTestReport("TimingWheel advance 10 minutes at 60 fps", (CoreTestTime() - start) * 1e9 / (600 * 60), "ns/frame");
+    CORE_TEST_ASSERT(fired == BENCHMARK_EVENTS / 2);
+
+    free(times);
+    free(events);
+}
@@ -0,0 +1,223 @@
+//
+//  TrigramIndexTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "TrigramIndex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FIELD_LENGTH 64
+
+//Synthetic score entries: a name and a composer, already folded the way ScoreSearchIndex does.
+typedef struct {
+    char fields[2][FIELD_LENGTH];
+} Entry;
+
+static const char *syllables[] = {"ba", "ch", "an", "to", "mi", "ra", "lo", "ve", "ne", "sk", "qu", "or", "el", "is", "ta", "um", " ", "-", "\xC3\xA9"};
+
+static void createField(char *field, int syllableCount, uint64_t *state)
+{
+    field[0] = '\0';
+    for (int i = 0; i < syllableCount; i++) {
+        strcat(field, syllables[CoreTestRandom(state) % (sizeof(syllables) / sizeof(syllables[0]))]);
+    }
+}
+
+static TrigramIndex *createIndex(Entry *entries, size_t count, uint64_t *state)
+{
+    TrigramIndex *index = TrigramIndexCreate(2);
+    for (size_t i = 0; i < count; i++) {
+        createField(entries[i].fields[0], 3 + CoreTestRandom(state) % 8, state);
+        createField(entries[i].fields[1], 3 + CoreTestRandom(state) % 6, state);
+        const char *fields[2] = {entries[i].fields[0], entries[i].fields[1]};
+        size_t lengths[2] = {strlen(fields[0]), strlen(fields[1])};
+        CORE_TEST_ASSERT(TrigramIndexAdd(index, fields, lengths));
+    }
+    return index;
+}
+
+//The linear scan the index replaces.
+static size_t scanEntries(const Entry *entries, size_t count, const char *query, uint32_t *matches)
+{
+    size_t matchCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (strstr(entries[i].fields[0], query) != NULL || strstr(entries[i].fields[1], query) != NULL) {
+            matches[matchCount++] = (uint32_t)i;
+        }
+    }
+    return matchCount;
+}
+
+static void testRanking(void)
+{
+    //Start of a field beats start of a word, which beats anywhere, and earlier fields win ties.
+    TrigramIndex *index = TrigramIndexCreate(2);
+    const char *documents[4][2] = {{"xxbach", "y"}, {"zz", "bach js"}, {"old bach", "q"}, {"bachata", "q"}};
+    for (int i = 0; i < 4; i++) {
+        size_t lengths[2] = {strlen(documents[i][0]), strlen(documents[i][1])};
+        CORE_TEST_ASSERT(TrigramIndexAdd(index, documents[i], lengths));
+    }
+    CORE_TEST_ASSERT(TrigramIndexDocumentCount(index) == 4);
+
+    TrigramSearch search;
+    TrigramSearchInit(&search);
+    CORE_TEST_ASSERT(TrigramSearchRun(&search, index, "bach", 4) == 4);
+    CORE_TEST_ASSERT(search.matches[0].document == 3 && search.matches[1].document == 1);
+    CORE_TEST_ASSERT(search.matches[2].document == 2 && search.matches[3].document == 0);
+
+    //Short queries, which can't use trigrams, rank the same way.
+    CORE_TEST_ASSERT(TrigramSearchRun(&search, index, "b", 1) == 4);
+    CORE_TEST_ASSERT(search.matches[0].document == 3 && search.matches[3].document == 0);
+    CORE_TEST_ASSERT(TrigramSearchRun(&search, index, "js", 2) == 1 && search.matches[0].document == 1);
+
+    CORE_TEST_ASSERT(TrigramSearchRun(&search, index, "", 0) == 4);
+    CORE_TEST_ASSERT(TrigramSearchRun(&search, index, "bachx", 5) == 0);
+    CORE_TEST_ASSERT(TrigramSearchRun(&search, index, "bach", 4) == 4);
+    TrigramSearchRelease(&search);
+
+    //A search notices when the index it last ran against has grown.
+    TrigramSearchInit(&search);
+    CORE_TEST_ASSERT(TrigramSearchRun(&search, index, "bach", 4) == 4);
+    const char *extra[2] = {"bach", ""};
+    size_t extraLengths[2] = {4, 0};
+    TrigramIndexAdd(index, extra, extraLengths);
+    CORE_TEST_ASSERT(TrigramSearchRun(&search, index, "bach", 4) == 5);
+    CORE_TEST_ASSERT(TrigramSearchRun(&search, index, "bacha", 5) == 1);
+    TrigramSearchRelease(&search);
+    TrigramIndexDestroy(index);
+}
+
+static void testAgainstScan(void)
+{
+    //Random queries, typed a character at a time (so the incremental path gets used), checked
+    //against a linear scan. Some have a character changed so that they match nothing.
+    size_t count = 2000;
+    uint64_t state = 7;
+    Entry *entries = malloc(count * sizeof(Entry));
+    TrigramIndex *index = createIndex(entries, count, &state);
+    uint32_t *expected = malloc(count * sizeof(uint32_t));
+    bool *seen = malloc(count * sizeof(bool));
+    TrigramSearch search;
+    TrigramSearchInit(&search);
+
+    bool countsMatch = true, matchesAgree = true, ordered = true;
+    for (int i = 0; i < 500; i++) {
+        const char *field = entries[CoreTestRandom(&state) % count].fields[CoreTestRandom(&state) % 2];
+        size_t fieldLength = strlen(field);
+        size_t start = CoreTestRandom(&state) % fieldLength;
+        size_t length = 1 + CoreTestRandom(&state) % (fieldLength - start > 10 ? 10 : fieldLength - start);
+        char query[FIELD_LENGTH];
+        memcpy(query, field + start, length);
+        if (CoreTestRandom(&state) % 5 == 0) {
+            query[CoreTestRandom(&state) % length] = 'z';
+        }
+
+        for (size_t typed = 1; typed <= length; typed++) {
+            char partial = query[typed];
+            query[typed] = '\0';
+            size_t matchCount = TrigramSearchRun(&search, index, query, typed);
+            size_t expectedCount = scanEntries(entries, count, query, expected);
+            query[typed] = partial;
+            countsMatch = countsMatch && matchCount == expectedCount && search.matchCount == matchCount;
+
+            memset(seen, 0, count * sizeof(bool));
+            for (size_t j = 0; j < search.matchCount; j++) {
+                TrigramMatch *match = &search.matches[j];
+                matchesAgree = matchesAgree && match->document < count && !seen[match->document];
+                seen[match->document] = true;
+                if (j > 0) {
+                    TrigramMatch *previous = &search.matches[j - 1];
+                    ordered = ordered && (previous->rank < match->rank || (previous->rank == match->rank && previous->document < match->document));
+                }
+            }
+            for (size_t j = 0; j < expectedCount; j++) {
+                matchesAgree = matchesAgree && seen[expected[j]];
+            }
+        }
+        if (CoreTestRandom(&state) % 3 == 0) {
+            countsMatch = countsMatch && TrigramSearchRun(&search, index, "", 0) == count;
+        }
+    }
+    CORE_TEST_ASSERT(countsMatch);
+    CORE_TEST_ASSERT(matchesAgree);
+    CORE_TEST_ASSERT(ordered);
+
+    TrigramSearchRelease(&search);
+    TrigramIndexDestroy(index);
+    free(seen);
+    free(expected);
+    free(entries);
+}
+
+void TrigramIndexTests(void)
+{
+    testRanking();
+    testAgainstScan();
+}
+
+void TrigramIndexBenchmark(void)
+{
+    //10,000 synthetic score entries, with queries typed a character at a time as someone would
+    //in the search bar, against the linear scan it replaces.
+    size_t count = 10000;
+    uint64_t state = 7;
+    Entry *entries = malloc(count * sizeof(Entry));
+    double start = CoreTestTime();
+    TrigramIndex *index = createIndex(entries, count, &state);
+    double buildTime = CoreTestTime() - start;
+    uint32_t *expected = malloc(count * sizeof(uint32_t));
+
+    const char *queries[] = {"bachan", "raloveta", "ne-sk"};
+    //Queries of one or two characters can't use the trigrams, so they're timed separately.
+    int runs = 200, keystrokes[2] = {0, 0};
+    double incrementalTime[2] = {0, 0}, coldTime[2] = {0, 0}, scanTime[2] = {0, 0};
+    TrigramSearch search;
+    TrigramSearchInit(&search);
+    bool agrees = true;
+    for (int run = 0; run < runs; run++) {
+        for (int i = 0; i < 3; i++) {
+            size_t length = strlen(queries[i]);
+            for (size_t typed = 1; typed <= length; typed++) {
+                char query[FIELD_LENGTH];
+                memcpy(query, queries[i], typed);
+                query[typed] = '\0';
+                int kind = typed >= 3;
+
+                double time = CoreTestTime();
+                size_t matchCount = TrigramSearchRun(&search, index, query, typed);
+                incrementalTime[kind] += CoreTestTime() - time;
+
+                TrigramSearch cold;
+                TrigramSearchInit(&cold);
+                time = CoreTestTime();
+                TrigramSearchRun(&cold, index, query, typed);
+                coldTime[kind] += CoreTestTime() - time;
+                TrigramSearchRelease(&cold);
+
+                time = CoreTestTime();
+                agrees = agrees && scanEntries(entries, count, query, expected) == matchCount;
+                scanTime[kind] += CoreTestTime() - time;
+                keystrokes[kind]++;
+            }
+            TrigramSearchRun(&search, index, "", 0);
+        }
+    }
+    CORE_TEST_ASSERT(agrees);
+
+    CoreTestReport("TrigramIndex build, 10k entries", buildTime * 1e3, "ms");
+    CoreTestReport("TrigramIndex short query, incremental", incrementalTime[0] / keystrokes[0] * 1e6, "us");
+    CoreTestReport("TrigramIndex short query, linear scan", scanTime[0] / keystrokes[0] * 1e6, "us");
+    CoreTestReport("TrigramIndex 3+ characters, incremental", incrementalTime[1] / keystrokes[1] * 1e6, "us");
+    CoreTestReport("TrigramIndex 3+ characters, fresh search", coldTime[1] / keystrokes[1] * 1e6, "us");
+    CoreTestReport("TrigramIndex 3+ characters, linear scan", scanTime[1] / keystrokes[1] * 1e6, "us");
+
+    TrigramSearchRelease(&search);
+    TrigramIndexDestroy(index);
+    free(expected);
+    free(entries);
+}
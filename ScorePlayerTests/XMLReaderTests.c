@@ -0,0 +1,333 @@
+//
+//  XMLReaderTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "XMLReader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_LENGTH 1024
+
+//Writes out the events of a document in a compact form, so that whole documents can be
+//checked at once: S(name) and E(name) for elements, T[text] for (decoded) text, D for the
+//end of the document and X@position for an error.
+static void traceDocument(const char *document, char *trace)
+{
+    XMLReader reader;
+    XMLReaderInit(&reader, document, strlen(document));
+    XMLText text;
+    XMLTextInit(&text);
+    size_t length = 0;
+    trace[0] = '\0';
+    for (int i = 0; i < 100; i++) {
+        XMLEvent event = XMLReaderNext(&reader);
+        if (event == kXMLStartElement || event == kXMLEndElement) {
+            length += snprintf(trace + length, TRACE_LENGTH - length, "%c(%.*s) ", event == kXMLStartElement ? 'S' : 'E', (int)reader.name.length, reader.name.bytes);
+        } else if (event == kXMLText) {
+            XMLTextReset(&text);
+            XMLTextAppend(&text, &reader);
+            length += snprintf(trace + length, TRACE_LENGTH - length, "T[%.*s] ", (int)text.span.length, text.span.bytes);
+        } else if (event == kXMLEndDocument) {
+            length += snprintf(trace + length, TRACE_LENGTH - length, "D");
+            break;
+        } else {
+            length += snprintf(trace + length, TRACE_LENGTH - length, "X@%zu", reader.errorPosition);
+            break;
+        }
+    }
+    XMLTextRelease(&text);
+}
+
+static bool documentTraces(const char *document, const char *expected)
+{
+    char trace[TRACE_LENGTH];
+    traceDocument(document, trace);
+    if (strcmp(trace, expected) != 0) {
+        fprintf(stderr, "Got: %s\n", trace);
+        return false;
+    }
+    return true;
+}
+
+static void testEvents(void)
+{
+    //The byte order mark, declaration, DOCTYPE (with an internal subset) and comments are all
+    //skipped. Empty tags give a start and an end, attributes are passed over, and CDATA is
+    //kept as is.
+    CORE_TEST_ASSERT(documentTraces("\xEF\xBB\xBF<?xml version=\"1.0\"?>\n<!DOCTYPE opus SYSTEM \"opus.dtd\" [<!ELEMENT a (b)>]>\n<opus><score><name>A &amp; B &#x263A; &#65;&bogus;</name><!-- c --><e/><f a=\"x>y\">z<![CDATA[<raw>&amp;]]></f></score></opus>\n", "S(opus) S(score) S(name) T[A & B \xE2\x98\xBA A&bogus;] E(name) S(e) E(e) S(f) T[z] T[<raw>&amp;] E(f) E(score) E(opus) D"));
+
+    //Attributes are available raw.
+    const char *document = "<score version=\"2\"><name>x</name></score>";
+    XMLReader reader;
+    XMLReaderInit(&reader, document, strlen(document));
+    CORE_TEST_ASSERT(XMLReaderNext(&reader) == kXMLStartElement && reader.depth == 1);
+    CORE_TEST_ASSERT(XMLSpanEquals(reader.attributes, " version=\"2\"") || XMLSpanEquals(reader.attributes, "version=\"2\""));
+    CORE_TEST_ASSERT(XMLReaderNext(&reader) == kXMLStartElement && reader.depth == 2);
+    CORE_TEST_ASSERT(XMLReaderNext(&reader) == kXMLText && !reader.textHasReferences);
+    CORE_TEST_ASSERT(XMLReaderNext(&reader) == kXMLEndElement && XMLSpanEquals(reader.name, "name"));
+
+    //Spans point into the document rather than copies of it.
+    CORE_TEST_ASSERT(reader.name.bytes > document && reader.name.bytes < document + strlen(document));
+    CORE_TEST_ASSERT(XMLReaderNext(&reader) == kXMLEndElement && reader.depth == 0);
+    CORE_TEST_ASSERT(XMLReaderNext(&reader) == kXMLEndDocument);
+    CORE_TEST_ASSERT(XMLReaderNext(&reader) == kXMLEndDocument);
+}
+
+static void testErrors(void)
+{
+    //Mismatched and unclosed tags, more than one root, text outside the root, unterminated
+    //markup and empty documents are all errors, and the error sticks.
+    CORE_TEST_ASSERT(documentTraces("<a><b></a>", "S(a) S(b) X@8"));
+    CORE_TEST_ASSERT(documentTraces("<a></a><b/>", "S(a) E(a) X@8"));
+    CORE_TEST_ASSERT(documentTraces("<a>", "S(a) X@3"));
+    CORE_TEST_ASSERT(documentTraces("text<a/>", "X@0"));
+    CORE_TEST_ASSERT(documentTraces("<a><!-- unterminated", "S(a) X@3"));
+    CORE_TEST_ASSERT(documentTraces("", "X@0"));
+
+    XMLReader reader;
+    XMLReaderInit(&reader, "</a>", 4);
+    CORE_TEST_ASSERT(XMLReaderNext(&reader) == kXMLError);
+    CORE_TEST_ASSERT(XMLReaderNext(&reader) == kXMLError);
+
+    //Nesting deeper than the reader keeps track of is turned away rather than overflowing.
+    char deep[XML_READER_MAX_DEPTH * 3 + 10] = "";
+    for (int i = 0; i <= XML_READER_MAX_DEPTH; i++) {
+        strcat(deep, "<a>");
+    }
+    XMLReaderInit(&reader, deep, strlen(deep));
+    XMLEvent event;
+    int starts = 0;
+    while ((event = XMLReaderNext(&reader)) == kXMLStartElement) {
+        starts++;
+    }
+    CORE_TEST_ASSERT(event == kXMLError && starts == XML_READER_MAX_DEPTH);
+}
+
+static void testText(void)
+{
+    //Text split by comments, references and CDATA is gathered into the buffer.
+    const char *document = "<a>x&amp;y<!--c-->z<![CDATA[w]]></a>";
+    XMLReader reader;
+    XMLReaderInit(&reader, document, strlen(document));
+    XMLText text;
+    XMLTextInit(&text);
+    XMLEvent event;
+    while ((event = XMLReaderNext(&reader)) != kXMLEndDocument && event != kXMLError) {
+        if (event == kXMLText) {
+            CORE_TEST_ASSERT(XMLTextAppend(&text, &reader));
+        }
+    }
+    CORE_TEST_ASSERT(event == kXMLEndDocument);
+    CORE_TEST_ASSERT(text.span.length == 5 && memcmp(text.span.bytes, "x&yzw", 5) == 0);
+
+    //A single plain run stays in the document.
+    XMLTextReset(&text);
+    document = "<a>plain</a>";
+    XMLReaderInit(&reader, document, strlen(document));
+    XMLReaderNext(&reader);
+    XMLReaderNext(&reader);
+    XMLTextAppend(&text, &reader);
+    CORE_TEST_ASSERT(text.span.bytes == document + 3 && text.span.length == 5);
+    XMLTextRelease(&text);
+
+    CORE_TEST_ASSERT(documentTraces("<a>&lt;&gt;&quot;&apos;&#38;&#xe9;</a>", "S(a) T[<>\"'&\xC3\xA9] E(a) D"));
+}
+
+static void testNameTable(void)
+{
+    static const XMLName names[] = {{"x", 1}, {"y", 2}, {"stop", 3}, {"invert", 4}, {"endzone", 5}};
+    XMLNameTable table;
+    CORE_TEST_ASSERT(XMLNameTableInit(&table, names, sizeof(names) / sizeof(names[0])));
+    XMLSpan span = {"stopx", 4};
+    CORE_TEST_ASSERT(XMLNameTableLookup(&table, span) == 3);
+    span.length = 5;
+    CORE_TEST_ASSERT(XMLNameTableLookup(&table, span) == -1);
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        XMLSpan name = {names[i].name, strlen(names[i].name)};
+        CORE_TEST_ASSERT(XMLNameTableLookup(&table, name) == names[i].identifier);
+    }
+
+    //Lots of names that share prefixes all still resolve, up to half the table.
+    static char generated[XML_NAME_TABLE_SLOTS][24];
+    XMLName many[XML_NAME_TABLE_SLOTS];
+    for (int i = 0; i < XML_NAME_TABLE_SLOTS; i++) {
+        snprintf(generated[i], sizeof(generated[i]), "element%d", i);
+        many[i].name = generated[i];
+        many[i].identifier = i;
+    }
+    CORE_TEST_ASSERT(XMLNameTableInit(&table, many, XML_NAME_TABLE_SLOTS / 2));
+    bool found = true;
+    for (int i = 0; i < XML_NAME_TABLE_SLOTS / 2; i++) {
+        XMLSpan name = {generated[i], strlen(generated[i])};
+        found = found && XMLNameTableLookup(&table, name) == i;
+    }
+    CORE_TEST_ASSERT(found);
+    XMLSpan missing = {generated[XML_NAME_TABLE_SLOTS - 1], strlen(generated[XML_NAME_TABLE_SLOTS - 1])};
+    CORE_TEST_ASSERT(XMLNameTableLookup(&table, missing) == -1);
+    CORE_TEST_ASSERT(!XMLNameTableInit(&table, many, XML_NAME_TABLE_SLOTS));
+}
+
+static void testConversions(void)
+{
+    XMLSpan fields[8];
+    XMLSpan list = {" 1.5, 2,3e2,-4abc", 17};
+    CORE_TEST_ASSERT(XMLSpanSplit(list, ',', fields, 8) == 4);
+    CORE_TEST_ASSERT(XMLSpanDoubleValue(fields[0]) == 1.5 && XMLSpanDoubleValue(fields[1]) == 2);
+    CORE_TEST_ASSERT(XMLSpanDoubleValue(fields[2]) == 300 && XMLSpanIntegerValue(fields[3]) == -4);
+    CORE_TEST_ASSERT(XMLSpanSplit(list, ',', fields, 2) == 4);
+    XMLSpan empty = {"", 0};
+    CORE_TEST_ASSERT(XMLSpanSplit(empty, ',', fields, 8) == 0);
+    CORE_TEST_ASSERT(XMLSpanIntegerValue(empty) == 0 && XMLSpanDoubleValue(empty) == 0);
+
+    //Numbers stop at the end of the span, not at the end of the string it's in.
+    XMLSpan truncated = {"12345", 2};
+    CORE_TEST_ASSERT(XMLSpanIntegerValue(truncated) == 12 && XMLSpanDoubleValue(truncated) == 12);
+    XMLSpan word = {"abc", 3};
+    CORE_TEST_ASSERT(XMLSpanIntegerValue(word) == 0);
+
+    XMLSpan value = {" yes", 4};
+    CORE_TEST_ASSERT(XMLSpanBoolValue(value));
+    value = (XMLSpan){"000", 3};
+    CORE_TEST_ASSERT(!XMLSpanBoolValue(value));
+    value = (XMLSpan){"01", 2};
+    CORE_TEST_ASSERT(XMLSpanBoolValue(value));
+    value = (XMLSpan){"no", 2};
+    CORE_TEST_ASSERT(!XMLSpanBoolValue(value));
+
+    value = (XMLSpan){"No", 2};
+    CORE_TEST_ASSERT(XMLSpanEqualsIgnoringCase(value, "no") && !XMLSpanEquals(value, "no"));
+    CORE_TEST_ASSERT(!XMLSpanEquals(value, "Now") && XMLSpanEquals(value, "No"));
+}
+
+void XMLReaderTests(void)
+{
+    testEvents();
+    testErrors();
+    testText();
+    testNameTable();
+    testConversions();
+}
+
+static char *appendFormat(char *buffer, size_t *length, size_t *capacity, const char *format, double value)
+{
+    if (*length + 64 > *capacity) {
+        *capacity *= 2;
+        buffer = realloc(buffer, *capacity);
+    }
+    *length += snprintf(buffer + *length, *capacity - *length, format, value);
+    return buffer;
+}
+
+static char *appendString(char *buffer, size_t *length, size_t *capacity, const char *string)
+{
+    size_t stringLength = strlen(string);
+    while (*length + stringLength + 1 > *capacity) {
+        *capacity *= 2;
+        buffer = realloc(buffer, *capacity);
+    }
+    memcpy(buffer + *length, string, stringLength + 1);
+    *length += stringLength;
+    return buffer;
+}
+
+//Reads a document the way the renderers do: the text of each element is gathered and then
+//split and converted once the element ends.
+static double readDocument(const char *document, size_t length, bool convert, size_t *fieldCount)
+{
+    XMLReader reader;
+    XMLReaderInit(&reader, document, length);
+    XMLText text;
+    XMLTextInit(&text);
+    XMLSpan *fields = malloc(4096 * sizeof(XMLSpan));
+    double sum = 0;
+    XMLEvent event;
+    while ((event = XMLReaderNext(&reader)) != kXMLEndDocument && event != kXMLError) {
+        if (event == kXMLStartElement) {
+            XMLTextReset(&text);
+        } else if (event == kXMLText) {
+            XMLTextAppend(&text, &reader);
+        } else if (convert && text.span.length > 0) {
+            size_t count = XMLSpanSplit(text.span, ',', fields, 4096);
+            for (size_t i = 0; i < count && i < 4096; i++) {
+                sum += XMLSpanDoubleValue(fields[i]);
+            }
+            *fieldCount += count;
+            XMLTextReset(&text);
+        }
+    }
+    CORE_TEST_ASSERT(event == kXMLEndDocument);
+    free(fields);
+    XMLTextRelease(&text);
+    return sum;
+}
+
+void XMLReaderBenchmark(void)
+{
+    //A large paths file for UBahn: 400 paths of 1500 points each.
+    size_t length = 0, capacity = 1 << 20;
+    char *paths = malloc(capacity);
+    paths = appendString(paths, &length, &capacity, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE paths SYSTEM \"paths.dtd\">\n<paths>\n<width>1024</width>\n");
+    uint64_t state = 2;
+    const char *coordinates[] = {"x", "y"};
+    for (int path = 0; path < 400; path++) {
+        paths = appendString(paths, &length, &capacity, "<path>\n");
+        for (int axis = 0; axis < 2; axis++) {
+            paths = appendString(paths, &length, &capacity, "<");
+            paths = appendString(paths, &length, &capacity, coordinates[axis]);
+            paths = appendString(paths, &length, &capacity, ">");
+            for (int i = 0; i < 1500; i++) {
+                paths = appendFormat(paths, &length, &capacity, i == 0 ? "%.2f" : ",%.2f", (CoreTestRandom(&state) % 100000) / 100.0);
+            }
+            paths = appendString(paths, &length, &capacity, "</");
+            paths = appendString(paths, &length, &capacity, coordinates[axis]);
+            paths = appendString(paths, &length, &capacity, ">\n");
+        }
+        paths = appendString(paths, &length, &capacity, "<stop>");
+        for (int i = 0; i < 1500; i++) {
+            paths = appendFormat(paths, &length, &capacity, i == 0 ? "%.0f" : ",%.0f", (double)(CoreTestRandom(&state) % 5) - 1);
+        }
+        paths = appendString(paths, &length, &capacity, "</stop>\n</path>\n");
+    }
+    paths = appendString(paths, &length, &capacity, "<mosaic><startimage>a.png</startimage><endimage>b.png</endimage><finalimage>c.png</finalimage><duration>10</duration></mosaic>\n</paths>\n");
+
+    //And the preferences file of a tiled score.
+    const char *preferences = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE canvas SYSTEM \"canvas.dtd\">\n<canvas>\n<background>score.png</background>\n<tiled>yes</tiled>\n<tilewidth>1024</tilewidth>\n<tileheight>768</tileheight>\n<rows>4</rows>\n<columns>12</columns>\n<colour>255,255,255</colour>\n<layer>\n<name>cursor</name>\n<position>0,0</position>\n<size>20,768</size>\n</layer>\n</canvas>\n";
+
+    int runs = 5;
+    double eventsTime = 1e9, convertTime = 1e9;
+    size_t fieldCount = 0;
+    for (int i = 0; i < runs; i++) {
+        double start = CoreTestTime();
+        readDocument(paths, length, false, &fieldCount);
+        double elapsed = CoreTestTime() - start;
+        eventsTime = elapsed < eventsTime ? elapsed : eventsTime;
+
+        fieldCount = 0;
+        start = CoreTestTime();
+        readDocument(paths, length, true, &fieldCount);
+        elapsed = CoreTestTime() - start;
+        convertTime = elapsed < convertTime ? elapsed : convertTime;
+    }
+    CORE_TEST_ASSERT(fieldCount >= 400 * 3 * 1500);
+
+    int preferenceRuns = 100000;
+    size_t preferencesLength = strlen(preferences);
+    size_t preferenceFields = 0;
+    double start = CoreTestTime();
+    for (int i = 0; i < preferenceRuns; i++) {
+        readDocument(preferences, preferencesLength, true, &preferenceFields);
+    }
+    double preferencesTime = (CoreTestTime() - start) / preferenceRuns;
+
+    CoreTestReport("XMLReader paths file size", length / 1e6, "MB");
+    CoreTestReport("XMLReader paths file, events only", eventsTime * 1e3, "ms");
+    CoreTestReport("XMLReader paths file, with conversion", convertTime * 1e3, "ms");
+    CoreTestReport("XMLReader tiled score preferences", preferencesTime * 1e6, "us");
+    free(paths);
+}
@@ -0,0 +1,223 @@
+//
+//  ZipCompressTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "ZipCompress.h"
+#include "ZipExtract.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define MAXIMUM_WORKERS 4
+#define FILE_COUNT 40
+//Over the size that's compressed to a temporary file rather than into memory.
+#define BIG_FILE_LENGTH (9 * 1024 * 1024)
+
+static char directory[CORE_TEST_PATH_LENGTH];
+
+static void fileName(size_t index, char *name, size_t length)
+{
+    //Every fifth file is a PNG, so that some are stored as they are.
+    snprintf(name, length, "%s%zu.%s", index % 3 == 0 ? "parts/" : (index % 3 == 1 ? "parts/deeper/" : ""), index, index % 5 == 0 ? "png" : "bin");
+}
+
+static void makeSource(const char *source, uint64_t *state)
+{
+    //Random and repetitive files of all sizes (including empty ones and one big enough to go
+    //through a temporary file), and an empty directory.
+    char path[CORE_TEST_PATH_LENGTH], name[64];
+    mkdir(source, 0755);
+    CoreTestPath(source, "parts", path);
+    mkdir(path, 0755);
+    CoreTestPath(source, "parts/deeper", path);
+    mkdir(path, 0755);
+    CoreTestPath(source, "empty", path);
+    mkdir(path, 0755);
+    uint8_t *contents = malloc(BIG_FILE_LENGTH);
+    for (size_t i = 0; i < FILE_COUNT; i++) {
+        size_t length = i == 7 ? BIG_FILE_LENGTH : (i % 8 == 3 ? 0 : CoreTestRandom(state) % 300000);
+        bool random = i % 2 == 0;
+        for (size_t j = 0; j < length; j++) {
+            contents[j] = random || j % 4096 == 0 ? (uint8_t)CoreTestRandom(state) : (uint8_t)("0123456789\n"[j % 11]);
+        }
+        fileName(i, name, sizeof(name));
+        CoreTestPath(source, name, path);
+        CoreTestWriteFile(path, contents, length);
+    }
+    free(contents);
+}
+
+static bool filesMatch(const char *first, const char *second)
+{
+    FILE *a = fopen(first, "rb"), *b = fopen(second, "rb");
+    bool match = a != NULL && b != NULL;
+    uint8_t bufferA[65536], bufferB[65536];
+    while (match) {
+        size_t length = fread(bufferA, 1, sizeof(bufferA), a);
+        match = fread(bufferB, 1, sizeof(bufferB), b) == length && memcmp(bufferA, bufferB, length) == 0;
+        if (length < sizeof(bufferA)) {
+            break;
+        }
+    }
+    if (a != NULL) {
+        fclose(a);
+    }
+    if (b != NULL) {
+        fclose(b);
+    }
+    return match;
+}
+
+static bool exists(const char *directory, const char *name)
+{
+    char path[CORE_TEST_PATH_LENGTH];
+    struct stat status;
+    CoreTestPath(directory, name, path);
+    return lstat(path, &status) == 0;
+}
+
+static void *runCompressionWorker(void *compression)
+{
+    return ZipCompressionRunWorker(compression) ? compression : NULL;
+}
+
+static void *runExtractionWorker(void *extraction)
+{
+    return ZipExtractionRunWorker(extraction) ? extraction : NULL;
+}
+
+static bool compressDirectory(const char *source, const char *archivePath, const ZipCompressionOptions *options, ZipCompressionProgress *progress)
+{
+    ZipCompression *compression = ZipCompressionOpen(source, archivePath, options);
+    if (compression == NULL) {
+        return false;
+    }
+    size_t workerCount = ZipCompressionWorkerCount(compression, MAXIMUM_WORKERS);
+    pthread_t workers[MAXIMUM_WORKERS];
+    for (size_t i = 0; i < workerCount; i++) {
+        pthread_create(&workers[i], NULL, runCompressionWorker, compression);
+    }
+    bool success = true;
+    for (size_t i = 0; i < workerCount; i++) {
+        void *result;
+        pthread_join(workers[i], &result);
+        success = success && result != NULL;
+    }
+    success = ZipCompressionFinish(compression) && success;
+    ZipCompressionGetProgress(compression, progress);
+    ZipCompressionClose(compression);
+    return success;
+}
+
+static bool extractArchive(const char *archivePath, const char *destination, ZipExtractionProgress *progress)
+{
+    ZipExtraction *extraction = ZipExtractionOpen(archivePath, destination);
+    if (extraction == NULL) {
+        return false;
+    }
+    bool success = ZipExtractionPrepare(extraction);
+    size_t workerCount = success ? ZipExtractionWorkerCount(extraction, MAXIMUM_WORKERS) : 0;
+    pthread_t workers[MAXIMUM_WORKERS];
+    for (size_t i = 0; i < workerCount; i++) {
+        pthread_create(&workers[i], NULL, runExtractionWorker, extraction);
+    }
+    for (size_t i = 0; i < workerCount; i++) {
+        void *result;
+        pthread_join(workers[i], &result);
+        success = success && result != NULL;
+    }
+    ZipExtractionGetProgress(extraction, progress);
+    ZipExtractionClose(extraction);
+    return success;
+}
+
+static void testParallelRoundTrip(void)
+{
+    //Four compression workers and four extraction workers, with a memory budget small enough
+    //that the compressors keep having to wait for the archive to catch up.
+    uint64_t state = 20;
+    char source[CORE_TEST_PATH_LENGTH], archivePath[CORE_TEST_PATH_LENGTH], destination[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "source", source);
+    CoreTestPath(directory, "archive.zip", archivePath);
+    CoreTestPath(directory, "extracted", destination);
+    makeSource(source, &state);
+
+    ZipCompressionOptions options;
+    ZipCompressionOptionsInit(&options);
+    options.storeCompressedFiles = true;
+    options.temporaryDirectory = directory;
+    options.memoryBudget = 256 * 1024;
+    ZipCompressionProgress compressionProgress;
+    CORE_TEST_ASSERT(compressDirectory(source, archivePath, &options, &compressionProgress));
+    CORE_TEST_ASSERT(compressionProgress.writtenEntries == compressionProgress.entryCount);
+    CORE_TEST_ASSERT(compressionProgress.compressedBytes == compressionProgress.totalBytes);
+
+    ZipExtractionProgress extractionProgress;
+    CORE_TEST_ASSERT(extractArchive(archivePath, destination, &extractionProgress));
+    CORE_TEST_ASSERT(extractionProgress.fileCount == FILE_COUNT && extractionProgress.extractedFiles == FILE_COUNT);
+    CORE_TEST_ASSERT(extractionProgress.totalBytes == compressionProgress.totalBytes);
+
+    bool identical = true;
+    char name[64], original[CORE_TEST_PATH_LENGTH], extracted[CORE_TEST_PATH_LENGTH];
+    for (size_t i = 0; i < FILE_COUNT; i++) {
+        fileName(i, name, sizeof(name));
+        CoreTestPath(source, name, original);
+        CoreTestPath(destination, name, extracted);
+        identical = identical && filesMatch(original, extracted);
+    }
+    CORE_TEST_ASSERT(identical);
+    CORE_TEST_ASSERT(exists(destination, "empty"));
+}
+
+static void testExcludedNames(void)
+{
+    //Excluded files and directories are left out wherever they are in the tree.
+    char source[CORE_TEST_PATH_LENGTH], archivePath[CORE_TEST_PATH_LENGTH], destination[CORE_TEST_PATH_LENGTH], path[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "excluded", source);
+    CoreTestPath(directory, "excluded.zip", archivePath);
+    CoreTestPath(directory, "excluded-extracted", destination);
+    mkdir(source, 0755);
+    CoreTestPath(source, "cache", path);
+    mkdir(path, 0755);
+    CoreTestPath(source, "parts", path);
+    mkdir(path, 0755);
+    CoreTestPath(source, "score.xml", path);
+    CoreTestWriteFile(path, "<score/>", 8);
+    CoreTestPath(source, ".DS_Store", path);
+    CoreTestWriteFile(path, "junk", 4);
+    CoreTestPath(source, "parts/.DS_Store", path);
+    CoreTestWriteFile(path, "junk", 4);
+    CoreTestPath(source, "parts/part.xml", path);
+    CoreTestWriteFile(path, "<part/>", 7);
+    CoreTestPath(source, "cache/tile", path);
+    CoreTestWriteFile(path, "tile", 4);
+
+    const char *excludedNames[] = {".DS_Store", "cache", NULL};
+    ZipCompressionOptions options;
+    ZipCompressionOptionsInit(&options);
+    options.excludedNames = excludedNames;
+    ZipCompressionProgress compressionProgress;
+    CORE_TEST_ASSERT(compressDirectory(source, archivePath, &options, &compressionProgress));
+    CORE_TEST_ASSERT(compressionProgress.totalBytes == 15);
+
+    ZipExtractionProgress extractionProgress;
+    CORE_TEST_ASSERT(extractArchive(archivePath, destination, &extractionProgress));
+    CORE_TEST_ASSERT(extractionProgress.fileCount == 2);
+    CORE_TEST_ASSERT(exists(destination, "score.xml") && exists(destination, "parts/part.xml"));
+    CORE_TEST_ASSERT(!exists(destination, ".DS_Store") && !exists(destination, "parts/.DS_Store") && !exists(destination, "cache"));
+}
+
+void ZipCompressTests(void)
+{
+    CORE_TEST_ASSERT(CoreTestMakeDirectory("ZipCompressTests", directory));
+    testParallelRoundTrip();
+    testExcludedNames();
+    CoreTestRemoveDirectory(directory);
+}
@@ -0,0 +1,184 @@
+//
+//  ZipExtractTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "ZipExtract.h"
+#include "ZipTestArchive.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define MAXIMUM_WORKERS 4
+
+static char directory[CORE_TEST_PATH_LENGTH];
+
+static void *runWorker(void *extraction)
+{
+    return ZipExtractionRunWorker(extraction) ? extraction : NULL;
+}
+
+static bool extractArchive(const char *archivePath, const char *destination, size_t maximumWorkers)
+{
+    ZipExtraction *extraction = ZipExtractionOpen(archivePath, destination);
+    if (extraction == NULL) {
+        return false;
+    }
+    bool success = ZipExtractionPrepare(extraction);
+    size_t workerCount = success ? ZipExtractionWorkerCount(extraction, maximumWorkers) : 0;
+    pthread_t workers[MAXIMUM_WORKERS];
+    for (size_t i = 0; i < workerCount; i++) {
+        pthread_create(&workers[i], NULL, runWorker, extraction);
+    }
+    for (size_t i = 0; i < workerCount; i++) {
+        void *result;
+        pthread_join(workers[i], &result);
+        success = success && result != NULL;
+    }
+    ZipExtractionClose(extraction);
+    return success;
+}
+
+static bool fileContains(const char *directory, const char *name, const char *contents)
+{
+    char path[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, name, path);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    char buffer[256];
+    size_t length = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+    return length == strlen(contents) && memcmp(buffer, contents, length) == 0;
+}
+
+static bool exists(const char *directory, const char *name)
+{
+    char path[CORE_TEST_PATH_LENGTH];
+    struct stat status;
+    CoreTestPath(directory, name, path);
+    return lstat(path, &status) == 0;
+}
+
+static void testPathTraversal(void)
+{
+    //Every name ends up inside the destination, however many levels it tries to climb.
+    char archivePath[CORE_TEST_PATH_LENGTH], destination[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "traversal.zip", archivePath);
+    CoreTestPath(directory, "traversal", destination);
+    ZipTestArchive archive;
+    ZipTestArchiveInit(&archive);
+    ZipTestArchiveAdd(&archive, "../x", "x", 1, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "/absolute/y", "y", 1, kZipTestDeflated);
+    ZipTestArchiveAdd(&archive, "a/../../../b", "b", 1, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "c\\..\\..\\d", "d", 1, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "./e/./f", "f", 1, kZipTestDeflated);
+    //Nothing is left of these names, so they're skipped.
+    ZipTestArchiveAdd(&archive, "..", "", 0, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "./", "", 0, kZipTestStored);
+    CORE_TEST_ASSERT(ZipTestArchiveWrite(&archive, archivePath));
+    ZipTestArchiveFree(&archive);
+
+    CORE_TEST_ASSERT(extractArchive(archivePath, destination, 1));
+    CORE_TEST_ASSERT(fileContains(destination, "x", "x"));
+    CORE_TEST_ASSERT(fileContains(destination, "absolute/y", "y"));
+    CORE_TEST_ASSERT(fileContains(destination, "b", "b"));
+    CORE_TEST_ASSERT(fileContains(destination, "d", "d"));
+    CORE_TEST_ASSERT(fileContains(destination, "e/f", "f"));
+    CORE_TEST_ASSERT(!exists(directory, "x") && !exists(directory, "b") && !exists(directory, "d"));
+    CORE_TEST_ASSERT(!exists("/", "absolute"));
+}
+
+static void testSymlinks(void)
+{
+    //Links aren't created, so a later entry can't be written through one.
+    char archivePath[CORE_TEST_PATH_LENGTH], destination[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "symlinks.zip", archivePath);
+    CoreTestPath(directory, "symlinks", destination);
+    ZipTestArchive archive;
+    ZipTestArchiveInit(&archive);
+    ZipTestArchiveAdd(&archive, "link", "..", 2, kZipTestSymlink);
+    ZipTestArchiveAdd(&archive, "link/escaped", "escaped", 7, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "absolute", "/tmp", 4, kZipTestSymlink);
+    ZipTestArchiveAdd(&archive, "file", "file", 4, kZipTestDeflated);
+    CORE_TEST_ASSERT(ZipTestArchiveWrite(&archive, archivePath));
+    ZipTestArchiveFree(&archive);
+
+    CORE_TEST_ASSERT(extractArchive(archivePath, destination, 1));
+    char path[CORE_TEST_PATH_LENGTH];
+    struct stat status;
+    CoreTestPath(destination, "link", path);
+    CORE_TEST_ASSERT(lstat(path, &status) == 0 && S_ISDIR(status.st_mode));
+    CORE_TEST_ASSERT(fileContains(destination, "link/escaped", "escaped"));
+    CORE_TEST_ASSERT(!exists(directory, "escaped"));
+    CORE_TEST_ASSERT(!exists(destination, "absolute"));
+    CORE_TEST_ASSERT(fileContains(destination, "file", "file"));
+}
+
+static void testDuplicates(void)
+{
+    //The last entry with a name wins, including names that only match once they're cleaned.
+    char archivePath[CORE_TEST_PATH_LENGTH], destination[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "duplicates.zip", archivePath);
+    CoreTestPath(directory, "duplicates", destination);
+    ZipTestArchive archive;
+    ZipTestArchiveInit(&archive);
+    ZipTestArchiveAdd(&archive, "score.xml", "first version", 13, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "other", "other", 5, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "score.xml", "second", 6, kZipTestDeflated);
+    ZipTestArchiveAdd(&archive, "./parts/../score.xml", "third", 5, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "other", "other again", 11, kZipTestDeflated);
+    CORE_TEST_ASSERT(ZipTestArchiveWrite(&archive, archivePath));
+    ZipTestArchiveFree(&archive);
+
+    ZipExtraction *extraction = ZipExtractionOpen(archivePath, destination);
+    CORE_TEST_ASSERT(extraction != NULL);
+    if (extraction == NULL) {
+        return;
+    }
+    ZipExtractionProgress progress;
+    ZipExtractionGetProgress(extraction, &progress);
+    CORE_TEST_ASSERT(progress.fileCount == 2 && progress.totalBytes == 16);
+    ZipExtractionClose(extraction);
+
+    CORE_TEST_ASSERT(extractArchive(archivePath, destination, MAXIMUM_WORKERS));
+    CORE_TEST_ASSERT(fileContains(destination, "score.xml", "third"));
+    CORE_TEST_ASSERT(fileContains(destination, "other", "other again"));
+}
+
+static void testDamagedEntry(void)
+{
+    //A stored entry whose data no longer matches its CRC fails the extraction.
+    char archivePath[CORE_TEST_PATH_LENGTH], destination[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "damaged.zip", archivePath);
+    CoreTestPath(directory, "damaged", destination);
+    ZipTestArchive archive;
+    ZipTestArchiveInit(&archive);
+    ZipTestArchiveAdd(&archive, "good", "good", 4, kZipTestStored);
+    size_t offset = ZipTestArchiveAdd(&archive, "bad", "bad", 3, kZipTestStored);
+    CORE_TEST_ASSERT(ZipTestArchiveWrite(&archive, archivePath));
+    CORE_TEST_ASSERT(extractArchive(archivePath, destination, 1));
+
+    //The data follows the 30 byte local header and the name.
+    archive.bytes[offset + 30 + 3] ^= 0xff;
+    CORE_TEST_ASSERT(CoreTestWriteFile(archivePath, archive.bytes, archive.length));
+    ZipTestArchiveFree(&archive);
+    CORE_TEST_ASSERT(!extractArchive(archivePath, destination, MAXIMUM_WORKERS));
+}
+
+void ZipExtractTests(void)
+{
+    CORE_TEST_ASSERT(CoreTestMakeDirectory("ZipExtractTests", directory));
+    testPathTraversal();
+    testSymlinks();
+    testDuplicates();
+    testDamagedEntry();
+    CoreTestRemoveDirectory(directory);
+}
@@ -0,0 +1,227 @@
+//
+//  ZipMountTests.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "CoreTest.h"
+#include "ZipMount.h"
+#include "ZipTestArchive.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Several of ZipMount's 64 KiB blocks, and not a whole number of them.
+#define DEFLATED_LENGTH 300001
+#define READER_COUNT 4
+
+static char directory[CORE_TEST_PATH_LENGTH];
+
+typedef struct {
+    ZipMount *mount;
+    const ZipMountEntry *entry;
+    const uint8_t *expected;
+    uint64_t seed;
+    bool success;
+} RangeReader;
+
+static const ZipMountEntry *find(const ZipMount *mount, const char *name)
+{
+    return ZipMountFind(mount, name, strlen(name));
+}
+
+static bool entryContains(ZipMount *mount, const char *name, const char *contents)
+{
+    const ZipMountEntry *entry = find(mount, name);
+    if (entry == NULL || entry->size != strlen(contents)) {
+        return false;
+    }
+    char buffer[256];
+    return ZipMountReadEntry(mount, entry, buffer) && memcmp(buffer, contents, entry->size) == 0;
+}
+
+static void testNames(void)
+{
+    //Names are cleaned up as they are when extracting, so nothing can be found above the root.
+    //Directories and links are left out.
+    char archivePath[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "names.zip", archivePath);
+    ZipTestArchive archive;
+    ZipTestArchiveInit(&archive);
+    ZipTestArchiveAdd(&archive, "../a.txt", "a", 1, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "parts/../../../b.txt", "b", 1, kZipTestDeflated);
+    ZipTestArchiveAdd(&archive, "/parts\\.\\c.txt", "c", 1, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "parts/", "", 0, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "link", "../a.txt", 8, kZipTestSymlink);
+    ZipTestArchiveAdd(&archive, "..", "", 0, kZipTestStored);
+    CORE_TEST_ASSERT(ZipTestArchiveWrite(&archive, archivePath));
+    ZipTestArchiveFree(&archive);
+
+    ZipMount *mount = ZipMountOpen(archivePath);
+    CORE_TEST_ASSERT(mount != NULL);
+    if (mount == NULL) {
+        return;
+    }
+    CORE_TEST_ASSERT(ZipMountEntryCount(mount) == 3);
+    CORE_TEST_ASSERT(entryContains(mount, "a.txt", "a"));
+    CORE_TEST_ASSERT(entryContains(mount, "b.txt", "b"));
+    CORE_TEST_ASSERT(entryContains(mount, "parts/c.txt", "c"));
+    CORE_TEST_ASSERT(find(mount, "../a.txt") == NULL && find(mount, "link") == NULL && find(mount, "parts") == NULL);
+    ZipMountClose(mount);
+}
+
+static void testDuplicates(void)
+{
+    //The last entry with a name wins, and the earlier ones aren't listed.
+    char archivePath[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "duplicates.zip", archivePath);
+    ZipTestArchive archive;
+    ZipTestArchiveInit(&archive);
+    ZipTestArchiveAdd(&archive, "score.xml", "first", 5, kZipTestStored);
+    ZipTestArchiveAdd(&archive, "other", "other", 5, kZipTestDeflated);
+    ZipTestArchiveAdd(&archive, "score.xml", "second", 6, kZipTestDeflated);
+    ZipTestArchiveAdd(&archive, "./score.xml", "third", 5, kZipTestStored);
+    CORE_TEST_ASSERT(ZipTestArchiveWrite(&archive, archivePath));
+    ZipTestArchiveFree(&archive);
+
+    ZipMount *mount = ZipMountOpen(archivePath);
+    CORE_TEST_ASSERT(mount != NULL);
+    if (mount == NULL) {
+        return;
+    }
+    CORE_TEST_ASSERT(ZipMountEntryCount(mount) == 2);
+    CORE_TEST_ASSERT(entryContains(mount, "score.xml", "third"));
+    CORE_TEST_ASSERT(entryContains(mount, "other", "other"));
+    const ZipMountEntry *entry = find(mount, "score.xml");
+    const void *mapped = ZipMountMapEntry(mount, entry);
+    CORE_TEST_ASSERT(mapped != NULL && memcmp(mapped, "third", 5) == 0);
+    ZipMountClose(mount);
+}
+
+static void testDamagedLocalHeaders(void)
+{
+    //The central directory is fine, but the local headers are only looked at when an entry is
+    //read: one has lost its signature, and one claims an extra field running past the end of the
+    //archive.
+    char archivePath[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "damaged.zip", archivePath);
+    ZipTestArchive archive;
+    ZipTestArchiveInit(&archive);
+    ZipTestArchiveAdd(&archive, "good", "good", 4, kZipTestStored);
+    size_t unsignedHeader = ZipTestArchiveAdd(&archive, "unsigned", "unsigned", 8, kZipTestStored);
+    size_t truncated = ZipTestArchiveAdd(&archive, "truncated", "truncated", 9, kZipTestStored);
+    size_t deflated = ZipTestArchiveAdd(&archive, "deflated", "deflated", 8, kZipTestDeflated);
+    CORE_TEST_ASSERT(ZipTestArchiveWrite(&archive, archivePath));
+    archive.bytes[unsignedHeader] = 0;
+    archive.bytes[truncated + 28] = 0xff;
+    archive.bytes[truncated + 29] = 0xff;
+    archive.bytes[deflated + 28] = 0xff;
+    archive.bytes[deflated + 29] = 0xff;
+    CORE_TEST_ASSERT(CoreTestWriteFile(archivePath, archive.bytes, archive.length));
+    ZipTestArchiveFree(&archive);
+
+    ZipMount *mount = ZipMountOpen(archivePath);
+    CORE_TEST_ASSERT(mount != NULL);
+    if (mount == NULL) {
+        return;
+    }
+    CORE_TEST_ASSERT(entryContains(mount, "good", "good"));
+    const char *damaged[] = {"unsigned", "truncated", "deflated"};
+    for (int i = 0; i < 3; i++) {
+        const ZipMountEntry *entry = find(mount, damaged[i]);
+        uint8_t buffer[16];
+        CORE_TEST_ASSERT(entry != NULL);
+        if (entry == NULL) {
+            continue;
+        }
+        CORE_TEST_ASSERT(ZipMountMapEntry(mount, entry) == NULL);
+        CORE_TEST_ASSERT(!ZipMountReadEntry(mount, entry, buffer));
+        CORE_TEST_ASSERT(ZipMountReadRange(mount, entry, 0, buffer, 1) == -1);
+        CORE_TEST_ASSERT(!ZipMountVerifyEntry(mount, entry));
+    }
+    ZipMountClose(mount);
+}
+
+static void *readRanges(void *context)
+{
+    //Random reads of up to a couple of blocks, so most of them cross a block boundary.
+    RangeReader *reader = context;
+    uint8_t *buffer = malloc(150000);
+    reader->success = true;
+    for (int i = 0; i < 200 && reader->success; i++) {
+        uint64_t offset = CoreTestRandom(&reader->seed) % (DEFLATED_LENGTH + 10);
+        size_t length = CoreTestRandom(&reader->seed) % 150000;
+        size_t expected = offset >= DEFLATED_LENGTH ? 0 : (DEFLATED_LENGTH - offset < length ? DEFLATED_LENGTH - (size_t)offset : length);
+        ssize_t read = ZipMountReadRange(reader->mount, reader->entry, offset, buffer, length);
+        reader->success = read == (ssize_t)expected && memcmp(buffer, reader->expected + offset, expected) == 0;
+    }
+    free(buffer);
+    return NULL;
+}
+
+static void testDeflatedRanges(void)
+{
+    //Reads that cross block boundaries, run off the end, go backwards (so the entry has to be
+    //inflated from the start again), and come from several threads at once.
+    uint64_t state = 21;
+    char archivePath[CORE_TEST_PATH_LENGTH];
+    CoreTestPath(directory, "ranges.zip", archivePath);
+    uint8_t *data = malloc(DEFLATED_LENGTH);
+    for (size_t i = 0; i < DEFLATED_LENGTH; i++) {
+        data[i] = i % 7 == 0 ? (uint8_t)CoreTestRandom(&state) : (uint8_t)(i / 1000);
+    }
+    ZipTestArchive archive;
+    ZipTestArchiveInit(&archive);
+    ZipTestArchiveAdd(&archive, "small", "small", 5, kZipTestDeflated);
+    ZipTestArchiveAdd(&archive, "data", data, DEFLATED_LENGTH, kZipTestDeflated);
+    CORE_TEST_ASSERT(ZipTestArchiveWrite(&archive, archivePath));
+    ZipTestArchiveFree(&archive);
+
+    ZipMount *mount = ZipMountOpen(archivePath);
+    CORE_TEST_ASSERT(mount != NULL);
+    if (mount == NULL) {
+        free(data);
+        return;
+    }
+    const ZipMountEntry *entry = find(mount, "data");
+    CORE_TEST_ASSERT(entry != NULL && !entry->stored && entry->size == DEFLATED_LENGTH);
+    CORE_TEST_ASSERT(ZipMountMapEntry(mount, entry) == NULL);
+    CORE_TEST_ASSERT(ZipMountVerifyEntry(mount, entry));
+
+    uint8_t buffer[200000];
+    const uint64_t boundary = 64 * 1024;
+    CORE_TEST_ASSERT(ZipMountReadRange(mount, entry, boundary - 10, buffer, 20) == 20 && memcmp(buffer, data + boundary - 10, 20) == 0);
+    CORE_TEST_ASSERT(ZipMountReadRange(mount, entry, 4 * boundary - 1, buffer, 2) == 2 && memcmp(buffer, data + 4 * boundary - 1, 2) == 0);
+    CORE_TEST_ASSERT(ZipMountReadRange(mount, entry, 100, buffer, 3 * boundary) == 3 * boundary && memcmp(buffer, data + 100, 3 * boundary) == 0);
+    CORE_TEST_ASSERT(ZipMountReadRange(mount, entry, 5, buffer, 10) == 10 && memcmp(buffer, data + 5, 10) == 0);
+    CORE_TEST_ASSERT(ZipMountReadRange(mount, entry, DEFLATED_LENGTH - 50, buffer, 100) == 50 && memcmp(buffer, data + DEFLATED_LENGTH - 50, 50) == 0);
+    CORE_TEST_ASSERT(ZipMountReadRange(mount, entry, DEFLATED_LENGTH, buffer, 100) == 0);
+    //Reading another entry in between uses up a cursor.
+    CORE_TEST_ASSERT(ZipMountReadRange(mount, find(mount, "small"), 1, buffer, 3) == 3 && memcmp(buffer, "mal", 3) == 0);
+    CORE_TEST_ASSERT(ZipMountReadRange(mount, entry, 2 * boundary, buffer, boundary) == boundary && memcmp(buffer, data + 2 * boundary, boundary) == 0);
+
+    RangeReader readers[READER_COUNT];
+    pthread_t threads[READER_COUNT];
+    for (int i = 0; i < READER_COUNT; i++) {
+        readers[i] = (RangeReader){mount, entry, data, 100 + i, false};
+        pthread_create(&threads[i], NULL, readRanges, &readers[i]);
+    }
+    for (int i = 0; i < READER_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+        CORE_TEST_ASSERT(readers[i].success);
+    }
+    ZipMountClose(mount);
+    free(data);
+}
+
+void ZipMountTests(void)
+{
+    CORE_TEST_ASSERT(CoreTestMakeDirectory("ZipMountTests", directory));
+    testNames();
+    testDuplicates();
+    testDamagedLocalHeaders();
+    testDeflatedRanges();
+    CoreTestRemoveDirectory(directory);
+}
@@ -0,0 +1,146 @@
+//
+//  ZipTestArchive.c
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+#include "ZipTestArchive.h"
+#include "CoreTest.h"
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#define UNIX_HOST_SYSTEM 3
+#define UNIX_EXTRA_FIELD 0x000d
+
+static void append(uint8_t **bytes, size_t *length, const void *data, size_t dataLength)
+{
+    *bytes = realloc(*bytes, *length + dataLength);
+    if (dataLength > 0) {
+        memcpy(*bytes + *length, data, dataLength);
+    }
+    *length += dataLength;
+}
+
+static void appendLittleEndian(uint8_t **bytes, size_t *length, uint32_t value, int size)
+{
+    uint8_t field[4];
+    for (int i = 0; i < size; i++) {
+        field[i] = (uint8_t)(value >> (i * 8));
+    }
+    append(bytes, length, field, size);
+}
+
+static uint8_t *deflateData(const void *data, size_t length, size_t *compressedLength)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    uLong bound = deflateBound(&stream, (uLong)length);
+    uint8_t *compressed = malloc(bound);
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = (uInt)length;
+    stream.next_out = compressed;
+    stream.avail_out = (uInt)bound;
+    deflate(&stream, Z_FINISH);
+    *compressedLength = stream.total_out;
+    deflateEnd(&stream);
+    return compressed;
+}
+
+void ZipTestArchiveInit(ZipTestArchive *archive)
+{
+    memset(archive, 0, sizeof(ZipTestArchive));
+}
+
+size_t ZipTestArchiveAdd(ZipTestArchive *archive, const char *name, const void *data, size_t length, ZipTestEntryKind kind)
+{
+    size_t offset = archive->length;
+    uint32_t crc = (uint32_t)crc32(0, data, (uInt)length);
+    size_t compressedLength = length;
+    uint8_t *compressed = NULL;
+    if (kind == kZipTestDeflated) {
+        compressed = deflateData(data, length, &compressedLength);
+    }
+    //A symbolic link keeps its target in the Unix extra field as well as in its data, which is
+    //where minizip looks for it.
+    uint8_t *extra = NULL;
+    size_t extraLength = 0;
+    if (kind == kZipTestSymlink) {
+        appendLittleEndian(&extra, &extraLength, UNIX_EXTRA_FIELD, 2);
+        appendLittleEndian(&extra, &extraLength, (uint32_t)(12 + length), 2);
+        //Access and modification times, then the user and group.
+        appendLittleEndian(&extra, &extraLength, 0, 4);
+        appendLittleEndian(&extra, &extraLength, 0, 4);
+        appendLittleEndian(&extra, &extraLength, 0, 4);
+        append(&extra, &extraLength, data, length);
+    }
+    size_t nameLength = strlen(name);
+    uint16_t method = kind == kZipTestDeflated ? 8 : 0;
+
+    appendLittleEndian(&archive->bytes, &archive->length, 0x04034b50, 4);
+    appendLittleEndian(&archive->bytes, &archive->length, 20, 2);
+    appendLittleEndian(&archive->bytes, &archive->length, 0, 2);
+    appendLittleEndian(&archive->bytes, &archive->length, method, 2);
+    //Midnight, 1 January 2000.
+    appendLittleEndian(&archive->bytes, &archive->length, 0, 2);
+    appendLittleEndian(&archive->bytes, &archive->length, (20 << 9) | (1 << 5) | 1, 2);
+    appendLittleEndian(&archive->bytes, &archive->length, crc, 4);
+    appendLittleEndian(&archive->bytes, &archive->length, (uint32_t)compressedLength, 4);
+    appendLittleEndian(&archive->bytes, &archive->length, (uint32_t)length, 4);
+    appendLittleEndian(&archive->bytes, &archive->length, (uint32_t)nameLength, 2);
+    appendLittleEndian(&archive->bytes, &archive->length, (uint32_t)extraLength, 2);
+    append(&archive->bytes, &archive->length, name, nameLength);
+    append(&archive->bytes, &archive->length, extra, extraLength);
+    append(&archive->bytes, &archive->length, compressed != NULL ? compressed : data, compressedLength);
+
+    uint32_t mode = kind == kZipTestSymlink ? 0120777 : (name[nameLength - 1] == '/' ? 040755 : 0100644);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, 0x02014b50, 4);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, (UNIX_HOST_SYSTEM << 8) | 20, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, 20, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, 0, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, method, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, 0, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, (20 << 9) | (1 << 5) | 1, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, crc, 4);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, (uint32_t)compressedLength, 4);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, (uint32_t)length, 4);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, (uint32_t)nameLength, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, (uint32_t)extraLength, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, 0, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, 0, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, 0, 2);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, mode << 16, 4);
+    appendLittleEndian(&archive->centralDirectory, &archive->centralDirectoryLength, (uint32_t)offset, 4);
+    append(&archive->centralDirectory, &archive->centralDirectoryLength, name, nameLength);
+    append(&archive->centralDirectory, &archive->centralDirectoryLength, extra, extraLength);
+
+    archive->entryCount++;
+    free(compressed);
+    free(extra);
+    return offset;
+}
+
+bool ZipTestArchiveWrite(ZipTestArchive *archive, const char *path)
+{
+    size_t centralDirectoryOffset = archive->length;
+    append(&archive->bytes, &archive->length, archive->centralDirectory, archive->centralDirectoryLength);
+    appendLittleEndian(&archive->bytes, &archive->length, 0x06054b50, 4);
+    appendLittleEndian(&archive->bytes, &archive->length, 0, 2);
+    appendLittleEndian(&archive->bytes, &archive->length, 0, 2);
+    appendLittleEndian(&archive->bytes, &archive->length, archive->entryCount, 2);
+    appendLittleEndian(&archive->bytes, &archive->length, archive->entryCount, 2);
+    appendLittleEndian(&archive->bytes, &archive->length, (uint32_t)archive->centralDirectoryLength, 4);
+    appendLittleEndian(&archive->bytes, &archive->length, (uint32_t)centralDirectoryOffset, 4);
+    appendLittleEndian(&archive->bytes, &archive->length, 0, 2);
+    return CoreTestWriteFile(path, archive->bytes, archive->length);
+}
+
+void ZipTestArchiveFree(ZipTestArchive *archive)
+{
+    free(archive->bytes);
+    free(archive->centralDirectory);
+    memset(archive, 0, sizeof(ZipTestArchive));
+}
@@ -0,0 +1,43 @@
+//
+//  ZipTestArchive.h
+//  ScorePlayerTests
+//
+//  Created by Aaron Wyatt on 18/10/2026.
+//  Copyright (c) 2026 Decibel. All rights reserved.
+//
+
+//Writes small zip archives byte by byte, for the suites that need archives minizip wouldn't make:
+//names that climb out of the destination, the same name twice, symbolic links, and damaged
+//headers. Entries are stored, or deflated with zlib, and written in the order they're added.
+
+#ifndef ZipTestArchive_h
+#define ZipTestArchive_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    kZipTestStored,
+    kZipTestDeflated,
+    //A Unix symbolic link, with the data as its target.
+    kZipTestSymlink
+} ZipTestEntryKind;
+
+typedef struct {
+    uint8_t *bytes;
+    size_t length;
+    uint8_t *centralDirectory;
+    size_t centralDirectoryLength;
+    uint16_t entryCount;
+} ZipTestArchive;
+
+void ZipTestArchiveInit(ZipTestArchive *archive);
+//Returns the offset of the entry's local header, so that a suite can damage it.
+size_t ZipTestArchiveAdd(ZipTestArchive *archive, const char *name, const void *data, size_t length, ZipTestEntryKind kind);
+//Appends the central directory and writes the whole archive out. The archive can't be added to
+//afterwards, but its bytes can still be changed and written again with CoreTestWriteFile.
+bool ZipTestArchiveWrite(ZipTestArchive *archive, const char *path);
+void ZipTestArchiveFree(ZipTestArchive *archive);
+
+#endif /* ZipTestArchive_h */